@@ -8,7 +8,12 @@ namespace blurp
 {
     //Resources forward declarations.
     class Window;
+    class RenderDevice;
     class RenderResourceManager;
+    class ShaderBinaryCache;
+    class ShaderRegistry;
+    class JobSystem;
+    class Profiler;
 
     /*
      * Main entry point into rendering with blurp.
@@ -20,6 +25,7 @@ namespace blurp
         friend class RenderDevice;
     public:
         BlurpEngine();
+        ~BlurpEngine();
 
         /*
          * Initialize this instance of Blurp Engine.
@@ -43,6 +49,29 @@ namespace blurp
          */
         BlurpSettings GetEngineSettings() const;
 
+        /*
+         * Get the cache that compiled shader programs are stored in.
+         * Returns nullptr when BlurpSettings::shaderBinaryCachePath is empty, or when the render device can not load shader binaries.
+         */
+        ShaderBinaryCache* GetShaderBinaryCache() const;
+
+        /*
+         * Get the registry that the shader variants of all render passes are stored in.
+         */
+        std::shared_ptr<ShaderRegistry> GetShaderRegistry() const;
+
+        /*
+         * Get the job system that runs work on multiple threads, for both the engine and the application.
+         * The thread that initialized the engine is its main thread.
+         */
+        JobSystem& GetJobSystem() const;
+
+        /*
+         * Get the profiler that render pipelines record their CPU and GPU markers in when BLURP_PROFILING is defined.
+         * The application can record its own markers in it with BLURP_PROFILE_SCOPE, and has to call Profiler::NextFrame once every frame.
+         */
+        Profiler& GetProfiler() const;
+
     private:
         //The render device containing the rendering context.
         std::shared_ptr<RenderDevice> m_RenderDevice;
@@ -56,5 +85,17 @@ namespace blurp
 
         //The settings the engine was set up with.
         BlurpSettings m_Settings;
+
+        //Compiled shader programs stored on disk. Nullptr when disabled.
+        std::unique_ptr<ShaderBinaryCache> m_ShaderBinaryCache;
+
+        //Compiled shader variants shared by all render passes. Shared with the shader caches, which may outlive the engine.
+        std::shared_ptr<ShaderRegistry> m_ShaderRegistry;
+
+        //Markers of the last frames. Outlives the job system, because jobs record markers in it.
+        std::unique_ptr<Profiler> m_Profiler;
+
+        //Worker threads shared by the engine and the application. Declared last, so that the workers stop before anything else is destroyed.
+        std::unique_ptr<JobSystem> m_JobSystem;
     };
 }
@@ -19,6 +19,17 @@ namespace blurp
          */
         glm::mat4 GetProjectionMatrix() const;
 
+        /*
+         * Get the frustum planes of this camera in world space.
+         */
+        Frustum GetFrustum() const;
+
+        /*
+         * Calculate the view and projection matrices now if they changed. They are otherwise calculated when they are first requested.
+         * After this call the matrices can be read from multiple threads at the same time, until the camera is changed.
+         */
+        void UpdateMatrices() const;
+
         /*
          * Set the projection settings for this camera.
          */
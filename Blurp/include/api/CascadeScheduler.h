@@ -0,0 +1,143 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RenderPass_ShadowMap.h"
+
+namespace blurp
+{
+    /*
+     * Settings that determine how often each cascade of the directional shadow maps is drawn.
+     */
+    struct CascadeSchedulerSettings
+    {
+        CascadeSchedulerSettings()
+        {
+            texelThreshold = 1.f;
+            resolution = 2048;
+        }
+
+        //Cascade N is drawn at least once every intervals[N] frames. 1 means every frame. Cascades without an entry are drawn every frame.
+        //Cascades with the same interval are drawn in different frames where possible.
+        std::vector<std::uint32_t> intervals;
+
+        //A cascade is drawn early when its volume moved more than this many texels since it was last drawn.
+        float texelThreshold;
+
+        //The width and height of the directional shadow maps.
+        std::uint32_t resolution;
+    };
+
+    /*
+     * Counters for the last call to CascadeScheduler::Schedule.
+     */
+    struct CascadeSchedulerStats
+    {
+        CascadeSchedulerStats() : updatedMask(0), skippedMask(0), dueCascades(0), movedCascades(0), totalUpdated(0), totalSkipped(0) {}
+
+        //Bit N is set when cascade N is drawn this frame.
+        std::uint32_t updatedMask;
+
+        //Bit N is set when cascade N keeps its depth from an earlier frame.
+        std::uint32_t skippedMask;
+
+        //The amount of cascades drawn because their interval came around.
+        std::uint32_t dueCascades;
+
+        //The amount of cascades drawn early because their volume moved too far.
+        std::uint32_t movedCascades;
+
+        //The amount of cascades drawn and skipped since the scheduler was created. Not cleared between frames.
+        std::uint64_t totalUpdated;
+        std::uint64_t totalSkipped;
+    };
+
+    /*
+     * CascadeScheduler decides which cascades of the directional shadow maps are drawn each frame.
+     *
+     * Cascades that are not drawn keep the depth and the matrix they were drawn with. These matrices are returned by GetMatrices,
+     * so that the shadow maps are always sampled with the matrix that matches the depth stored in them.
+     * The clip depths that pick a cascade for a fragment always come from the current camera.
+     *
+     * A cascade is drawn when its interval comes around, or when the volume calculated for the current camera is more than
+     * texelThreshold texels away from the volume it was drawn with. Cascades are scheduled for all lights at once,
+     * so that a single cascade mask applies to every light.
+     *
+     * Call Schedule every frame after the lights are added to the shadow pass, and before the clear pass runs.
+     * RenderPass_ShadowMap::UpdateCascadeScheduler does this with the lights of the pass.
+     */
+    class CascadeScheduler
+    {
+    public:
+        CascadeScheduler();
+
+        /*
+         * Change the settings. Every cascade is drawn again on the next call to Schedule.
+         */
+        void SetSettings(const CascadeSchedulerSettings& a_Settings);
+
+        /*
+         * Get the current settings.
+         */
+        const CascadeSchedulerSettings& GetSettings() const;
+
+        /*
+         * Draw every cascade on the next call to Schedule.
+         */
+        void Invalidate();
+
+        /*
+         * Calculate the cascades of the given directional lights for the camera, and decide which cascades are drawn this frame.
+         * a_Lights are the directional lights in the order they were added to the shadow pass.
+         */
+        void Schedule(const Camera& a_Camera, const LightShadowData* a_Lights, std::uint32_t a_Count, const ShadowData& a_ShadowData);
+
+        /*
+         * Get the mask of cascades that are drawn this frame. Bit N is cascade N.
+         */
+        std::uint32_t GetUpdateMask() const;
+
+        /*
+         * Get the view projection matrix of every cascade of every light, stored light after light.
+         * Cascades that are not drawn this frame keep the matrix they were last drawn with.
+         */
+        const std::vector<glm::mat4>& GetMatrices() const;
+
+        /*
+         * Get the camera clip space depth of every cascade of every light for the current camera, stored light after light.
+         */
+        const std::vector<glm::vec4>& GetClipDepths() const;
+
+        /*
+         * Get the regions of the directional shadow map array that have to be cleared this frame.
+         * Offset and size in Z are set for every region, X and Y are copied from a_Template together with the clear value.
+         */
+        void GetClearRegions(const ClearData& a_Template, std::vector<ClearData>& a_Output) const;
+
+        /*
+         * Get the counters for the last call to Schedule.
+         */
+        const CascadeSchedulerStats& GetStats() const;
+
+        /*
+         * Calculate how many texels the corners of the volume of a_New are away from where a_Old puts them, for a shadow map of the given resolution.
+         * Only the directions perpendicular to the light are compared.
+         */
+        static float CalculateTexelShift(const glm::mat4& a_Old, const glm::mat4& a_New, std::uint32_t a_Resolution);
+
+    private:
+        CascadeSchedulerSettings m_Settings;
+        CascadeSchedulerStats m_Stats;
+
+        std::vector<glm::mat4> m_Matrices;
+        std::vector<glm::vec4> m_ClipDepths;
+        std::vector<glm::mat4> m_NewMatrices;       //Matrices for the current camera, reused between frames.
+        std::vector<std::int32_t> m_LightIndices;   //Shadow map index of every light.
+
+        std::uint32_t m_NumCascades;
+        std::uint32_t m_UpdateMask;
+        std::uint64_t m_Frame;
+        bool m_Invalidated;
+    };
+}
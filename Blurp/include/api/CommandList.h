@@ -0,0 +1,202 @@
+#pragma once
+#include <cinttypes>
+#include <functional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Data.h"
+
+namespace blurp
+{
+    class GpuBuffer;
+    class JobSystem;
+    class MaterialBatch;
+    class Mesh;
+    class Shader;
+    class Texture;
+
+    /*
+     * The kinds of commands that can be stored in a CommandList.
+     */
+    enum class CommandType : std::uint8_t
+    {
+        SET_PIPELINE_STATE,     //Object is the PipelineState.
+        BIND_SHADER,            //Object is the Shader.
+        BIND_TEXTURE,           //Object is the Texture. Slot is the texture unit.
+        BIND_STORAGE_BUFFER,    //Object is the GpuBuffer. Slot is the binding, count the size in bytes and value the offset.
+        BIND_MATERIAL_BATCH,    //Object is the MaterialBatch. Slot is the uniform buffer binding of its constant data.
+        BIND_MESH,              //Object is the Mesh.
+        SET_UNIFORM,            //Slot is the location, format the UniformFormat and value the offset of the data in the list.
+        DRAW,                   //Object is the Mesh. Format is the TopologyType and count the amount of instances of the draw.
+
+        NUM_COMMAND_TYPES
+    };
+
+    /*
+     * The types of uniform values that a CommandList can set.
+     */
+    enum class UniformFormat : std::uint8_t
+    {
+        INT,
+        FLOAT,
+        VEC3
+    };
+
+    /*
+     * A single command in a CommandList. What the fields mean depends on the type, see CommandType.
+     */
+    struct Command
+    {
+        CommandType type;
+        std::uint8_t slot;
+        std::uint8_t format;
+        std::uint32_t count;
+        std::uint64_t value;
+        const void* object;
+    };
+
+    /*
+     * Receives the commands of a CommandList when it is replayed. Every graphics API has its own implementation.
+     */
+    class CommandListBackend
+    {
+    public:
+        virtual ~CommandListBackend() = default;
+
+        virtual void SetPipelineState(const PipelineState& a_State) = 0;
+        virtual void BindShader(const Shader& a_Shader) = 0;
+        virtual void BindTexture(std::uint32_t a_Slot, const Texture& a_Texture) = 0;
+        virtual void BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size) = 0;
+
+        /*
+         * Bind the constant data of a_Batch to uniform buffer binding a_Slot. Batches without constant data bind nothing.
+         */
+        virtual void BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch) = 0;
+        virtual void BindMesh(const Mesh& a_Mesh) = 0;
+        virtual void SetUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data) = 0;
+
+        /*
+         * Draw the bound mesh. a_InstanceCount is the amount of instances in the draw data, which is multiplied by the instance count of the mesh.
+         * Points are drawn without indices, everything else is indexed.
+         */
+        virtual void Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount) = 0;
+    };
+
+    /*
+     * A compact list of commands that does not depend on a graphics API.
+     * Commands refer to the objects that are used instead of their API handles, which are looked up when the list is replayed.
+     *
+     * Recording only writes to the list itself, so different lists can be recorded on different threads at the same time.
+     * Replaying has to happen on the thread that owns the graphics API.
+     */
+    class CommandList
+    {
+    public:
+        void SetPipelineState(const PipelineState& a_State);
+        void BindShader(const Shader& a_Shader);
+        void BindTexture(std::uint32_t a_Slot, const Texture& a_Texture);
+        void BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size);
+        void BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch);
+        void BindMesh(const Mesh& a_Mesh);
+        void SetUniform(std::uint32_t a_Location, std::int32_t a_Value);
+        void SetUniform(std::uint32_t a_Location, float a_Value);
+        void SetUniform(std::uint32_t a_Location, const glm::vec3& a_Value);
+        void Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount);
+
+        /*
+         * Send every command to a_Backend in the order that they were recorded.
+         */
+        void Replay(CommandListBackend& a_Backend) const;
+
+        /*
+         * Get all commands in the order they were recorded.
+         */
+        const std::vector<Command>& GetCommands() const;
+
+        /*
+         * Get a hash of every command and the uniform data. Objects are hashed by address, so hashes can only be compared within the same run.
+         */
+        std::uint64_t GetHash() const;
+
+        /*
+         * Remove all commands. Memory is kept for the next recording.
+         */
+        void Clear();
+
+    private:
+        void Add(CommandType a_Type, const void* a_Object, std::uint32_t a_Slot = 0, std::uint32_t a_Count = 0, std::uint64_t a_Value = 0, std::uint8_t a_Format = 0);
+        void AddUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data, std::uint32_t a_Size);
+
+    private:
+        std::vector<Command> m_Commands;
+        std::vector<std::uint8_t> m_Data;
+    };
+
+    /*
+     * A set of command lists that together record a range of items, such as the draws of a render pass.
+     *
+     * The items are split into lists of a fixed amount of items, which are recorded by multiple jobs and replayed in order on one thread.
+     * How the items are split does not depend on the amount of threads, so the same items always give the same lists.
+     * Recorded lists are kept with a key that describes their contents, so they can be replayed again in later frames while the key stays the same.
+     */
+    class CommandListSet
+    {
+    public:
+        /*
+         * Called to record items a_Begin up to a_End into a_List. Can be called on any thread, but never twice for the same list at the same time.
+         */
+        using RecordFunction = std::function<void(CommandList& a_List, std::uint32_t a_Begin, std::uint32_t a_End)>;
+
+        CommandListSet();
+
+        /*
+         * Returns true when the lists were last recorded with a_Key, and can be replayed instead of recording them again.
+         */
+        bool IsRecorded(std::uint64_t a_Key) const;
+
+        /*
+         * Record a_Count items into lists of at most a_ItemsPerList items each, as jobs of a_Jobs on up to a_MaxThreads threads including the calling thread.
+         * Returns when every list is recorded. The lists are then kept with a_Key.
+         */
+        void Record(JobSystem& a_Jobs, std::uint64_t a_Key, std::uint32_t a_Count, std::uint32_t a_ItemsPerList, std::uint32_t a_MaxThreads, const RecordFunction& a_Record);
+
+        /*
+         * Replay every list in order.
+         */
+        void Replay(CommandListBackend& a_Backend) const;
+
+        /*
+         * Forget the key, so that the lists are recorded again the next time.
+         */
+        void Invalidate();
+
+        /*
+         * Get the amount of lists that were recorded, and a list by index.
+         */
+        std::uint32_t GetListCount() const;
+        const CommandList& GetList(std::uint32_t a_Index) const;
+
+        /*
+         * Get the amount of commands in all lists together.
+         */
+        std::uint32_t GetCommandCount() const;
+
+        /*
+         * Get a hash of all lists in order. See CommandList::GetHash.
+         */
+        std::uint64_t GetHash() const;
+
+        /*
+         * Get the amount of times that the lists were recorded, which does not increase when they are reused.
+         */
+        std::uint32_t GetRecordCount() const;
+
+    private:
+        std::vector<CommandList> m_Lists;
+        std::uint32_t m_ListCount;
+        std::uint64_t m_Key;
+        bool m_Recorded;
+        std::uint32_t m_RecordCount;
+    };
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "CommandList.h"
+
+namespace blurp
+{
+    class CommandRecording;
+
+    /*
+     * Replays command lists of the headless GraphicsAPI::NONE backend into a CommandRecording.
+     * Commands are recorded the way the OpenGL backend would send them, without leaving out calls that change nothing.
+     */
+    class CommandListBackend_Null : public CommandListBackend
+    {
+    public:
+        /*
+         * Create a backend that records into a_Recording. The recording has to outlive the backend.
+         */
+        CommandListBackend_Null(CommandRecording& a_Recording) : m_Recording(a_Recording) {}
+
+        void SetPipelineState(const PipelineState& a_State) override;
+        void BindShader(const Shader& a_Shader) override;
+        void BindTexture(std::uint32_t a_Slot, const Texture& a_Texture) override;
+        void BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size) override;
+        void BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch) override;
+        void BindMesh(const Mesh& a_Mesh) override;
+        void SetUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data) override;
+        void Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount) override;
+
+    private:
+        CommandRecording& m_Recording;
+    };
+}
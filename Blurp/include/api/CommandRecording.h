@@ -0,0 +1,118 @@
+#pragma once
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+namespace blurp
+{
+    /*
+     * The kinds of commands that a render pass can record instead of calling a graphics API.
+     */
+    enum class RecordedCommandType : std::uint8_t
+    {
+        BIND_TARGET,            //Object is the render target.
+        ATTACH_DEPTH,           //Object is the texture that depth is written to until the next BIND_TARGET.
+        CLEAR_TARGET,           //Object is the render target. Value is the cleared attachments: 1 = color, 2 = depth, 4 = stencil.
+        CLEAR_TEXTURE,          //Object is the texture. Count is the amount of texels cleared.
+        COPY_TEXTURE,           //Object is the destination texture. Slot is the layer, count the amount of texels copied.
+        SET_VIEWPORT,           //Value is X, Y, width and height as 16 bits each, starting at the highest bits.
+        SET_PIPELINE_STATE,     //Value is the id of the pipeline state.
+        BIND_SHADER,            //Object is the shader.
+        BIND_TEXTURE,           //Object is the texture. Slot is the texture unit.
+        BIND_UNIFORM_BUFFER,    //Object is the buffer. Slot is the binding, count the size in bytes and value the offset.
+        BIND_STORAGE_BUFFER,    //Object is the buffer. Slot is the binding, count the size in bytes and value the offset.
+        BIND_MESH,              //Object is the mesh.
+        SET_UNIFORM,            //Slot is the location. Count is the size in bytes and value a hash of the bytes.
+        UPLOAD,                 //Object is the buffer. Count is the size in bytes and value a hash of the bytes.
+        DRAW,                   //Object is the mesh. Count is the amount of vertices, value the amount of instances.
+        DRAW_INDEXED,           //Object is the mesh. Count is the amount of indices, value the amount of instances.
+
+        NUM_COMMAND_TYPES
+    };
+
+    /*
+     * A single recorded command. What the fields mean depends on the type, see RecordedCommandType.
+     */
+    struct RecordedCommand
+    {
+        RecordedCommandType type;
+        std::uint8_t slot;
+        std::uint32_t object;
+        std::uint32_t count;
+        std::uint64_t value;
+    };
+
+    /*
+     * A stream of commands recorded by render passes, in the order that they would have been sent to a graphics API.
+     *
+     * Objects are stored as small ids that are handed out in the order that the objects are first recorded, instead of their addresses.
+     * Running the same passes over the same data then always gives the same commands, so recordings can be compared and hashed.
+     */
+    class CommandRecording
+    {
+    public:
+        CommandRecording();
+
+        /*
+         * Record a command. a_Object may be nullptr for commands that do not refer to an object.
+         */
+        void Record(RecordedCommandType a_Type, const void* a_Object, std::uint32_t a_Slot = 0, std::uint32_t a_Count = 0, std::uint64_t a_Value = 0);
+
+        /*
+         * Record a_Size bytes being written to a_Buffer. Only the size and a hash of the bytes are stored.
+         */
+        void RecordUpload(const void* a_Buffer, const void* a_Data, std::uint32_t a_Size);
+
+        /*
+         * Record a uniform being set at a_Location. Only the size and a hash of the bytes are stored.
+         */
+        void RecordUniform(std::uint32_t a_Location, const void* a_Data, std::uint32_t a_Size);
+
+        /*
+         * Record the viewport being set. Every value has to fit in 16 bits.
+         */
+        void RecordViewport(std::uint32_t a_X, std::uint32_t a_Y, std::uint32_t a_Width, std::uint32_t a_Height);
+
+        /*
+         * Get the id of an object in this recording. Objects that were not recorded yet get the next id.
+         * Id 0 is nullptr.
+         */
+        std::uint32_t GetObjectId(const void* a_Object);
+
+        /*
+         * Get all commands in the order they were recorded.
+         */
+        const std::vector<RecordedCommand>& GetCommands() const;
+
+        /*
+         * Get the amount of recorded commands of a type.
+         */
+        std::uint32_t GetCount(RecordedCommandType a_Type) const;
+
+        /*
+         * Get the total amount of bytes written by upload commands.
+         */
+        std::uint64_t GetUploadedBytes() const;
+
+        /*
+         * Get a hash of every recorded command. Equal recordings have an equal hash.
+         */
+        std::uint64_t GetHash() const;
+
+        /*
+         * Remove all commands and object ids.
+         */
+        void Clear();
+
+        /*
+         * Calculate the hash that upload and uniform commands store for a_Size bytes at a_Data.
+         */
+        static std::uint64_t HashBytes(const void* a_Data, std::uint32_t a_Size);
+
+    private:
+        std::vector<RecordedCommand> m_Commands;
+        std::unordered_map<const void*, std::uint32_t> m_ObjectIds;
+        std::uint32_t m_Counts[static_cast<int>(RecordedCommandType::NUM_COMMAND_TYPES)];
+        std::uint64_t m_UploadedBytes;
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cinttypes>
+#include <glm/glm.hpp>
+
+#include "Settings.h"
+
+namespace blurp
+{
+    /*
+     * Calculate the bounds of the vertex positions in the given mesh settings.
+     * Only vertices referenced by the index buffer are considered. Without indices, every vertex is used.
+     * Empty bounds are returned when the mesh has no POSITION_3D attribute.
+     */
+    MeshBounds CalculateMeshBounds(const MeshSettings& a_Settings);
+
+    /*
+     * Get bounds that enclose both of the given bounds.
+     */
+    MeshBounds CombineBounds(const MeshBounds& a_First, const MeshBounds& a_Second);
+
+    /*
+     * Get the bounds of a_Bounds after transforming them by a_Transform.
+     * The box is the smallest axis aligned box around the transformed box. The sphere is scaled by the largest axis scale.
+     */
+    MeshBounds TransformBounds(const MeshBounds& a_Bounds, const glm::mat4& a_Transform);
+
+    /*
+     * Extract the frustum planes from a view projection matrix.
+     * The planes are normalized and point inwards.
+     */
+    Frustum ExtractFrustum(const glm::mat4& a_ViewProjection);
+
+    /*
+     * Stretch a frustum infinitely along a_Direction, for example the direction in which a directional light shines.
+     * Planes that the volume moves towards are replaced by planes that contain everything.
+     * Objects outside of the result can not cast a shadow into the original frustum.
+     */
+    Frustum ExtrudeFrustum(const Frustum& a_Frustum, const glm::vec3& a_Direction);
+
+    /*
+     * Test the bounding sphere of a_Bounds, transformed by every matrix in a_Transforms, against a_Frustum.
+     * Transforms of visible instances are written to the front of a_Output in their original order.
+     *
+     * When a_KeepCulled is true, the transforms of culled instances are written to the back of a_Output (last one first),
+     * so that a_Output holds every instance with the visible ones first. a_Output may not overlap a_Transforms in that case.
+     * When a_KeepCulled is false, a_Output may be the same array as a_Transforms.
+     *
+     * a_Output needs to have room for a_Count matrices, and is only written to, so it can point to mapped GPU memory.
+     * Returns the amount of visible instances.
+     */
+    std::uint32_t CullInstances(const Frustum& a_Frustum, const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count, glm::mat4* a_Output, bool a_KeepCulled = false);
+
+    /*
+     * Reference implementation of CullInstances that tests instances one at a time without SIMD.
+     * Produces the same output as CullInstances. Used to validate the SIMD kernel.
+     */
+    std::uint32_t CullInstancesReference(const Frustum& a_Frustum, const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count, glm::mat4* a_Output, bool a_KeepCulled = false);
+}
@@ -3,6 +3,7 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <memory>
 
 #include "GpuBufferView.h"
@@ -236,28 +237,44 @@ namespace blurp
     /*
      * PipelineState describes pipeline state for a draw call.
      * Things like blending and topology are contained within.
+     *
+     * Pipeline states are interned by their contents: every state with the same contents has the same id, and Intern returns one shared object for them.
+     * Ids are ordered by blending, depth testing, depth writing, stencil testing, cull mode and topology, in that order,
+     * so sorting by id places states next to each other that need the least state to change between them.
      */
     struct PipelineState
     {
     public:
         /*
-         * Create an immutable pipeline data object.
+         * Create an immutable pipeline data object. This is a copy of the interned state with the same contents.
          */
         static PipelineState Compile(const BlendData& a_BlendData, const TopologyType& a_Topology, const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData);
 
         /*
-         * Get the default PipelineState object.
+         * Get the interned pipeline state with the given contents. The object is shared by every call with the same contents and lives until the program exits.
          */
-        static PipelineState& GetDefault();
+        static const PipelineState& Intern(const BlendData& a_BlendData, const TopologyType& a_Topology, const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData);
 
+        /*
+         * Get the amount of pipeline states with different contents.
+         */
+        static std::uint32_t GetInternedCount();
 
-        PipelineState() : m_Topology(TopologyType::TRIANGLES), m_CullMode(CullMode::CULL_BACK), m_Front(WindingOrder::COUNTER_CLOCKWISE), m_Id(-1)
+        /*
+         * Get the default PipelineState object.
+         */
+        static const PipelineState& GetDefault();
+
+        /*
+         * Create a copy of the default state.
+         */
+        PipelineState() : PipelineState(GetDefault())
         {
 
         }
 
     private:
-        PipelineState(const BlendData& a_BlendData, const TopologyType& a_Topology, const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData) : m_Blending(a_BlendData), m_Topology(a_Topology), m_CullMode(a_CullMode), m_Front(a_Winding), m_DepthStencilData(a_DepthStencilData), m_Id(m_IdCounter++)
+        PipelineState(const BlendData& a_BlendData, const TopologyType& a_Topology, const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData, int a_Id) : m_Blending(a_BlendData), m_Topology(a_Topology), m_CullMode(a_CullMode), m_Front(a_Winding), m_DepthStencilData(a_DepthStencilData), m_Id(a_Id)
         {
 
         }
@@ -324,11 +341,9 @@ namespace blurp
         DepthStencilData m_DepthStencilData;
 
         /*
-         * The unique ID of this pipeline state. Used to identify state switches.
+         * The ID of the contents of this pipeline state. Used to identify and sort state switches.
          */
         int m_Id;
-
-        static int m_IdCounter;
     };
 
     /*
@@ -385,7 +400,8 @@ namespace blurp
         OPENGL,
         OPENGLES,
         VULKAN,
-        DIRECTX12
+        DIRECTX12,
+        NONE            //Headless. Resources are kept in CPU memory and passes record their commands instead of sending them to a GPU.
     };
 
     enum class TextureType
@@ -844,6 +860,7 @@ namespace blurp
         {
             instanceCount = 1;
             pipelineState = nullptr;
+            sortDepth = 0.f;
         }
 
         /*
@@ -868,7 +885,13 @@ namespace blurp
          * Used to configure culling, blending, topology and depth testing.
          * Will only be applied if not nullptr or different from the last used one.
          */
-        PipelineState* pipelineState;
+        const PipelineState* pipelineState;
+
+        /*
+         * The distance from the camera along the view direction.
+         * Only used when draw sorting is enabled on a render pass. Opaque draws are ordered front-to-back and blended draws back-to-front with this value.
+         */
+        float sortDepth;
 
         //Materials.
         struct
@@ -970,6 +993,36 @@ namespace blurp
         std::shared_ptr<GpuBuffer> dataBuffer;
     };
 
+    /*
+     * Information about the light clusters uploaded by a LightClusterBuilder.
+     * When no dataBuffer is set, every fragment is shaded with every light.
+     */
+    struct LightClusterInfo
+    {
+        LightClusterInfo()
+        {
+            counts = glm::uvec3(0);
+            depthScale = 0.f;
+            depthBias = 0.f;
+        }
+
+        //The amount of clusters along the screen X and Y axis and along the view direction.
+        glm::uvec3 counts;
+
+        //The depth slice of a fragment is floor(log(viewDepth) * depthScale + depthBias).
+        float depthScale;
+        float depthBias;
+
+        //The table with the light index offset and light counts for every cluster.
+        GpuBufferView cells;
+
+        //The list of light indices that the cells point into.
+        GpuBufferView lightIndices;
+
+        //The buffer in which the cells and light indices are stored.
+        std::shared_ptr<GpuBuffer> dataBuffer;
+    };
+
     /*
      * Struct containing information about the lights in a scene.
      * Lights have to be uploaded to the GPU by the user to minimize uploading overhead.
@@ -993,6 +1046,11 @@ namespace blurp
          */
         LightDataInfo directionalLights;
 
+        /*
+         * Point and spot lights per cluster. Optional.
+         */
+        LightClusterInfo clusters;
+
         /*
          * The amount of ambient light in the scene.
          */
@@ -1016,6 +1074,10 @@ namespace blurp
         {
             //Texture containing the shadow maps. Has to be Texture_Cube_Array.
             std::shared_ptr<Texture> shadowMaps;
+
+            //Optional texture with the same settings as shadowMaps. Holds the depth of static casters only.
+            //Used when a PositionalShadowCache with static layers is set on the shadow pass.
+            std::shared_ptr<Texture> staticShadowMaps;
         } positional;
 
         //Shadowmaps for directional lights.
@@ -1216,4 +1278,43 @@ namespace blurp
         std::string locationDefine;
     };
 
+    /*
+     * The bounding volumes of a mesh in object space.
+     * Both an axis aligned bounding box and a bounding sphere are stored.
+     */
+    struct MeshBounds
+    {
+        MeshBounds() : min(0.f), max(0.f), center(0.f), radius(0.f) {}
+
+        //The corners of the axis aligned bounding box.
+        glm::vec3 min;
+        glm::vec3 max;
+
+        //The bounding sphere. The center is the center of the bounding box.
+        glm::vec3 center;
+        float radius;
+    };
+
+    /*
+     * The six planes that enclose the volume visible to a camera.
+     * Each plane is stored as (normal, distance) with the normal pointing inwards and normalized.
+     * A point p is on the inside of a plane when dot(normal, p) + distance >= 0.
+     */
+    struct Frustum
+    {
+        //Plane indices. Prefixed because Windows headers define NEAR and FAR.
+        enum Plane
+        {
+            PLANE_LEFT = 0,
+            PLANE_RIGHT,
+            PLANE_BOTTOM,
+            PLANE_TOP,
+            PLANE_NEAR,
+            PLANE_FAR,
+            NUM_PLANES
+        };
+
+        glm::vec4 planes[NUM_PLANES];
+    };
+
 }
@@ -0,0 +1,145 @@
+#pragma once
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+#include "Data.h"
+
+/*
+ * Bit widths of the fields packed into a draw sort key.
+ * Fields that receive more unique values than fit will saturate, which only affects grouping and not correctness.
+ */
+#define SORT_KEY_PIPELINE_BITS 7
+#define SORT_KEY_SHADER_BITS 10
+#define SORT_KEY_MATERIAL_BITS 12
+#define SORT_KEY_MESH_BITS 12
+#define SORT_KEY_DEPTH_BITS 16
+
+namespace blurp
+{
+    /*
+     * Settings used when building sort keys for a set of DrawData.
+     */
+    struct DrawSortSettings
+    {
+        DrawSortSettings() : nearPlane(0.1f), farPlane(1000.f), sortMaterials(true) {}
+
+        /*
+         * The depth range that DrawData::sortDepth is quantized in.
+         * Depths outside of this range are clamped.
+         */
+        float nearPlane;
+        float farPlane;
+
+        /*
+         * When true, the material or material batch is part of the key and the material bits are included in the shader mask.
+         * Passes that do not bind materials (like shadow mapping) should disable this.
+         */
+        bool sortMaterials;
+    };
+
+    /*
+     * The amount of state changes that occur when drawing a set of DrawData in a certain order.
+     */
+    struct DrawStateChanges
+    {
+        DrawStateChanges() : pipelineStates(0), shaders(0), materials(0), meshes(0) {}
+
+        std::uint32_t pipelineStates;
+        std::uint32_t shaders;
+        std::uint32_t materials;
+        std::uint32_t meshes;
+    };
+
+    /*
+     * DrawSorter builds a 64 bit key for every DrawData in a set, and then radix sorts an array of indices by those keys.
+     * The DrawData itself is never moved.
+     *
+     * Opaque keys are laid out as:    [0][pipeline][shader][material][mesh][depth]
+     * Blended keys are laid out as:   [1][inverted depth][pipeline][shader][material][mesh]
+     *
+     * This groups opaque geometry by state and draws it front-to-back, after which blended geometry is drawn back-to-front.
+     * Pipeline states are assigned dense IDs in the order of their pipeline state IDs, so that similar states end up next to each other.
+     * Shader masks, materials and meshes are assigned dense IDs in the order they are first encountered.
+     */
+    class DrawSorter
+    {
+    public:
+        /*
+         * Build the keys for the given DrawData and sort them.
+         * The resulting draw order can be retrieved with GetOrder().
+         */
+        void Sort(const DrawData* a_DrawData, std::uint32_t a_Count, const DrawSortSettings& a_Settings);
+
+        /*
+         * Get the indices into the last sorted DrawData array in the order they should be drawn.
+         */
+        const std::vector<std::uint32_t>& GetOrder() const;
+
+        /*
+         * Get the keys that were built during the last sort, indexed by DrawData index.
+         */
+        const std::vector<std::uint64_t>& GetKeys() const;
+
+        /*
+         * Pack the given fields into a sort key.
+         * Every field is clamped to the amount of bits available for it.
+         */
+        static std::uint64_t MakeKey(bool a_Blended, std::uint32_t a_PipelineId, std::uint32_t a_ShaderId, std::uint32_t a_MaterialId, std::uint32_t a_MeshId, std::uint32_t a_Depth);
+
+        /*
+         * Quantize a depth value into the bits available for it in the key.
+         * 0 is at the near plane, the maximum value at the far plane.
+         */
+        static std::uint32_t QuantizeDepth(float a_Depth, float a_NearPlane, float a_FarPlane);
+
+        /*
+         * Get the shader mask for the given DrawData.
+         * This is the vertex attribute mask combined with the draw attributes and optionally the material attributes.
+         */
+        static std::uint64_t GetShaderMask(const DrawData& a_DrawData, bool a_IncludeMaterial);
+
+        /*
+         * Sort the given keys from low to high using an LSD radix sort.
+         * a_Indices is reordered together with the keys. Both vectors need to be the same size.
+         */
+        static void RadixSort(std::vector<std::uint64_t>& a_Keys, std::vector<std::uint32_t>& a_Indices);
+
+        /*
+         * Count the state changes that happen when drawing a_DrawData in the order specified by a_Order.
+         * If a_Order is nullptr, the submission order is used.
+         */
+        static DrawStateChanges CountStateChanges(const DrawData* a_DrawData, const std::uint32_t* a_Order, std::uint32_t a_Count, bool a_IncludeMaterial);
+
+    private:
+        //Get or assign a dense ID for a value.
+        template<typename T>
+        static std::uint32_t GetDenseId(std::unordered_map<T, std::uint32_t>& a_Map, const T& a_Value);
+
+    private:
+        std::vector<std::uint64_t> m_Keys;
+        std::vector<std::uint64_t> m_SortedKeys;
+        std::vector<std::uint32_t> m_Order;
+
+        //Dense ID lookups, cleared every sort.
+        std::unordered_map<int, std::uint32_t> m_PipelineIds;
+        std::unordered_map<std::uint64_t, std::uint32_t> m_ShaderIds;
+        std::vector<int> m_SortedPipelineIds;
+        std::unordered_map<const void*, std::uint32_t> m_MaterialIds;
+        std::unordered_map<const void*, std::uint32_t> m_MeshIds;
+    };
+
+    template <typename T>
+    std::uint32_t DrawSorter::GetDenseId(std::unordered_map<T, std::uint32_t>& a_Map, const T& a_Value)
+    {
+        const auto found = a_Map.find(a_Value);
+        if(found != a_Map.end())
+        {
+            return found->second;
+        }
+
+        const auto id = static_cast<std::uint32_t>(a_Map.size());
+        a_Map.emplace(a_Value, id);
+        return id;
+    }
+}
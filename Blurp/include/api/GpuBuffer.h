@@ -1,14 +1,17 @@
 #pragma once
+#include <algorithm>
+
 #include "Lockable.h"
 #include "RenderResource.h"
 #include "GpuBufferView.h"
+#include "GpuBufferWriter.h"
 
 namespace blurp
 {
     class GpuBuffer : public RenderResource, public Lockable
     {
     public:
-        GpuBuffer(const GpuBufferSettings& a_Settings) : m_Settings(a_Settings) {}
+        GpuBuffer(const GpuBufferSettings& a_Settings) : m_Settings(a_Settings), m_Writing(false) {}
 
         /*
          * Write raw data into this GPU buffer.
@@ -24,6 +27,40 @@ namespace blurp
         template<typename T>
         GpuBufferView WriteData(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, const T* a_Data);
 
+        /*
+         * Start writing a_Count elements of type T directly into this GPU buffer.
+         * The arguments are the same as for WriteData, and the data ends up with the same layout.
+         * The returned writer points straight into buffer memory, so no copy is made.
+         *
+         * Only one write can be active at a time. EndWrite() has to be called before the buffer is used or written again.
+         */
+        template<typename T>
+        GpuBufferWriter<T> BeginWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize);
+
+        /*
+         * Start writing per instance data for a_DrawData directly into this GPU buffer.
+         * The enabled draw attributes and instance count of a_DrawData determine the layout, which is the same as WriteData with PerInstanceUploadData.
+         * The GpuBufferView and this buffer are stored in a_DrawData.
+         *
+         * EndWrite() has to be called before the buffer is used or written again.
+         */
+        PerInstanceWriter BeginWrite(std::uintptr_t a_Offset, DrawData& a_DrawData);
+
+        /*
+         * Finish the active write started with BeginWrite.
+         */
+        void EndWrite();
+
+        /*
+         * Get the std430 alignment for an element of which the largest member is a_LargestMemberSize bytes.
+         */
+        static std::uintptr_t GetElementAlignment(std::uint32_t a_LargestMemberSize);
+
+        /*
+         * Get the size of an element including the padding required to keep the next element aligned.
+         */
+        static std::uintptr_t GetPaddedElementSize(std::uint32_t a_ElementSize, std::uintptr_t a_Alignment);
+
         /*
          * Write data to this GpuBuffer.
          * The data will be extracted from the pointers provided in a_UploadData.
@@ -64,6 +101,13 @@ namespace blurp
          */
         virtual bool Resize(std::uint32_t a_Size, bool a_CopyData = true) = 0;
 
+        /*
+         * Start a new frame for a persistent ring buffer.
+         * Data written during the previous frame is protected until the GPU is done with it.
+         * Does nothing for buffers that are not ring buffers.
+         */
+        virtual void BeginFrame() = 0;
+
     protected:
         /*
          * Called when data has to be written to the GPU buffer.
@@ -78,8 +122,27 @@ namespace blurp
          */
         virtual GpuBufferView OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, std::uint32_t a_PerDataSize, const void* a_Data) = 0;
 
+        /*
+         * Called when data is going to be written directly into the buffer.
+         * a_Offset is the requested offset from the start of the buffer.
+         * a_Size is the total size in bytes of the range, including padding.
+         * a_Alignment is the alignment that the start of the range needs.
+         *
+         * The start of the range is stored in a_Start, and a writable pointer to the start of the range is returned.
+         * The buffer should grow the same way it does for OnWrite.
+         */
+        virtual char* OnBeginWrite(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment, std::uintptr_t& a_Start) = 0;
+
+        /*
+         * Called when the range returned by OnBeginWrite has been written.
+         */
+        virtual void OnEndWrite() = 0;
+
     protected:
         GpuBufferSettings m_Settings;
+
+        //True while a writer is active.
+        bool m_Writing;
     };
 
     inline std::uint32_t GpuBuffer::GetSize() const
@@ -87,11 +150,42 @@ namespace blurp
         return m_Settings.size;
     }
 
+    inline std::uintptr_t GpuBuffer::GetElementAlignment(std::uint32_t a_LargestMemberSize)
+    {
+        //Alignment for std430 is equal to the largest member size, up to that of a vec4.
+        return std::min<std::uintptr_t>(16u, a_LargestMemberSize);
+    }
+
+    inline std::uintptr_t GpuBuffer::GetPaddedElementSize(std::uint32_t a_ElementSize, std::uintptr_t a_Alignment)
+    {
+        const std::uintptr_t elementPadding = (a_Alignment - (a_ElementSize & (a_Alignment - 1))) & (a_Alignment - 1);
+        return a_ElementSize + elementPadding;
+    }
+
+    template <typename T>
+    GpuBufferWriter<T> GpuBuffer::BeginWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize)
+    {
+        assert(!IsLocked() && "Cannot write data into a locked GPUBuffer!");
+        assert(m_Settings.access != AccessMode::READ_ONLY && "Attempting to write to a read-only GPU Buffer.");
+        assert(!m_Writing && "Only one GpuBufferWriter can be active at a time!");
+
+        const auto alignment = GetElementAlignment(a_LargestMemberSize);
+        const auto stride = GetPaddedElementSize(static_cast<std::uint32_t>(sizeof(T)), alignment);
+        const auto size = stride * a_Count;
+
+        std::uintptr_t start = 0;
+        char* data = OnBeginWrite(a_Offset, size, alignment, start);
+        m_Writing = true;
+
+        return GpuBufferWriter<T>(data, stride, a_Count, GpuBufferView(start, size, stride));
+    }
+
     template <typename T>
     GpuBufferView GpuBuffer::WriteData(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, const T* a_Data)
     {
         assert(!IsLocked() && "Cannot write data into a locked GPUBuffer!");
         assert(m_Settings.access != AccessMode::READ_ONLY && "Attempting to write to a read-only GPU Buffer.");
+        assert(!m_Writing && "Cannot write data while a GpuBufferWriter is active!");
         return OnWrite(a_Offset, a_Count, a_LargestMemberSize, static_cast<std::uint32_t>(sizeof(T)), static_cast<const void*>(a_Data));
     }
 }
@@ -0,0 +1,95 @@
+#pragma once
+#include <cassert>
+#include <cinttypes>
+#include <glm/glm.hpp>
+#include <memory>
+
+#include "GpuBufferView.h"
+
+namespace blurp
+{
+    /*
+     * GpuBufferWriter gives direct write access to a range of elements inside a GpuBuffer.
+     * Elements are laid out with the stride required by the buffer (std430 padding), so writing through this object places data at its final position.
+     * No intermediate copy is made.
+     *
+     * The writer is only valid between GpuBuffer::BeginWrite and GpuBuffer::EndWrite.
+     */
+    template<typename T>
+    class GpuBufferWriter
+    {
+    public:
+        GpuBufferWriter() : m_Data(nullptr), m_Stride(0), m_Count(0) {}
+
+        GpuBufferWriter(char* a_Data, std::uintptr_t a_Stride, std::uint32_t a_Count, const GpuBufferView& a_View)
+            : m_Data(a_Data), m_Stride(a_Stride), m_Count(a_Count), m_View(a_View)
+        {
+        }
+
+        /*
+         * Access the element at the given index.
+         * The memory may be write-combined, so avoid reading from it.
+         */
+        T& operator[](std::uint32_t a_Index)
+        {
+            assert(a_Index < m_Count && "GpuBufferWriter index out of range!");
+            return *reinterpret_cast<T*>(m_Data + (a_Index * m_Stride));
+        }
+
+        /*
+         * Write a single element at the given index.
+         */
+        void Write(std::uint32_t a_Index, const T& a_Value)
+        {
+            (*this)[a_Index] = a_Value;
+        }
+
+        /*
+         * Get the amount of elements that can be written.
+         */
+        std::uint32_t GetCount() const
+        {
+            return m_Count;
+        }
+
+        /*
+         * Get the distance in bytes between elements.
+         */
+        std::uintptr_t GetStride() const
+        {
+            return m_Stride;
+        }
+
+        /*
+         * Get the view of the buffer range that is being written.
+         */
+        const GpuBufferView& GetView() const
+        {
+            return m_View;
+        }
+
+        /*
+         * Returns true if this writer points to memory.
+         */
+        bool IsValid() const
+        {
+            return m_Data != nullptr;
+        }
+
+    private:
+        char* m_Data;
+        std::uintptr_t m_Stride;
+        std::uint32_t m_Count;
+        GpuBufferView m_View;
+    };
+
+    /*
+     * Writers for per instance data that is interleaved inside a single buffer range.
+     * Writers for attributes that are not enabled are invalid.
+     */
+    struct PerInstanceWriter
+    {
+        GpuBufferWriter<glm::mat4> transforms;
+        GpuBufferWriter<glm::mat4> normalMatrices;
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+
+#include "GpuBuffer.h"
+
+namespace blurp
+{
+    /*
+     * GpuBuffer that stores its contents in CPU memory.
+     * Data is laid out exactly like it is in a GPU buffer, including padding.
+     * This makes it possible to inspect the bytes that would end up on the GPU, for example to check that
+     * data written through a GpuBufferWriter matches data written with WriteData.
+     *
+     * The storage is allocated on construction, so the buffer can be used without a RenderDevice.
+     */
+    class GpuBuffer_CPU : public GpuBuffer
+    {
+    public:
+        GpuBuffer_CPU(const GpuBufferSettings& a_Settings);
+
+        /*
+         * Get the contents of this buffer.
+         * Bytes that have never been written are zero.
+         */
+        const std::vector<char>& GetData() const;
+
+    protected:
+        void OnLock() override;
+        void OnUnlock() override;
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+        GpuBufferView OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, std::uint32_t a_PerDataSize, const void* a_Data) override;
+        char* OnBeginWrite(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment, std::uintptr_t& a_Start) override;
+        void OnEndWrite() override;
+
+    public:
+        bool Resize(std::uint32_t a_Size, bool a_CopyData = true) override;
+        void BeginFrame() override;
+        GpuBufferView WriteData(std::uint32_t a_Offset, const PerInstanceUploadData& a_UploadData) override;
+        GpuBufferView WriteData(std::uint32_t a_Offset, const GlobalUploadData& a_UploadData) override;
+        GpuBufferView WriteData(std::uint32_t a_Offset, const LightUploadData& a_UploadData) override;
+
+    private:
+        /*
+         * Find the aligned start for a_Size bytes of data written at a_Offset, growing the buffer when allowed.
+         */
+        std::uintptr_t Reserve(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment);
+
+    private:
+        std::vector<char> m_Data;
+    };
+}
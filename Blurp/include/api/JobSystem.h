@@ -0,0 +1,221 @@
+#pragma once
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace blurp
+{
+    class JobSystem;
+
+    /*
+     * Counts the jobs that were started with it and have not finished yet.
+     * Wait for a counter with JobSystem::Wait, or pass it as a dependency to start jobs when it reaches zero.
+     *
+     * A counter can be reused when it reached zero. It may only be destroyed when no job uses it anymore, which is the case after JobSystem::Wait returns.
+     */
+    class JobCounter
+    {
+        friend class JobSystem;
+    public:
+        JobCounter();
+
+        //Jobs refer to their counter, so it can not be copied or moved.
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        /*
+         * Returns true when every job that was started with this counter has finished.
+         */
+        bool IsDone() const;
+
+    private:
+        std::atomic<std::uint32_t> m_Count;
+
+        //Guards the continuations and the exception. Also held while the count reaches zero, see JobSystem::Wait.
+        std::mutex m_Mutex;
+
+        //Called when the count reaches zero. Used to start the jobs that depend on this counter.
+        std::vector<std::function<void()>> m_Continuations;
+
+        //The first exception thrown by a job of this counter. Thrown again by JobSystem::Wait.
+        std::exception_ptr m_Exception;
+    };
+
+    /*
+     * Counters of a JobSystem. These are not cleared.
+     */
+    struct JobSystemStats
+    {
+        JobSystemStats() : jobs(0), stolen(0), mainThreadJobs(0) {}
+
+        //The amount of jobs that were run.
+        std::uint64_t jobs;
+
+        //The amount of jobs that were run by another thread than the one that queued them.
+        std::uint64_t stolen;
+
+        //The amount of jobs that were run on the main thread because they were started with RunOnMainThread.
+        std::uint64_t mainThreadJobs;
+    };
+
+    /*
+     * JobSystem runs jobs on a fixed amount of worker threads together with the main thread, which is the thread that created it.
+     *
+     * Every thread has its own queue. A thread runs the jobs that it queued itself newest first, and when it has none left it steals the oldest jobs of other threads.
+     * Threads that wait for a counter run jobs in the meantime, so jobs can start other jobs and wait for them without blocking a worker.
+     * Jobs started with RunOnMainThread are only run by the main thread, for work that has to happen on the thread that owns the graphics API.
+     *
+     * Jobs may run on any thread and at the same time as each other, so they may only change data that no other running job reads or changes.
+     */
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        /*
+         * Called with the range of items a_Begin up to a_End to process. See ParallelFor.
+         */
+        using RangeJob = std::function<void(std::uint32_t a_Begin, std::uint32_t a_End)>;
+
+        /*
+         * Create a job system with a_WorkerCount threads besides the calling thread, which becomes the main thread.
+         * With 0 workers every job runs on the main thread while it waits.
+         */
+        explicit JobSystem(std::uint32_t a_WorkerCount);
+
+        /*
+         * Stops the workers after they finish their current job. Jobs that did not start yet are not run.
+         */
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        /*
+         * Start a_Job. When a_Counter is not nullptr it counts the job until it finished.
+         * The job is queued once every counter in a_Dependencies is done, which can be right away.
+         */
+        void Run(const Job& a_Job, JobCounter* a_Counter = nullptr, const std::vector<JobCounter*>& a_Dependencies = {});
+
+        /*
+         * Start a_Job like Run, but only ever run it on the main thread.
+         * The main thread runs these jobs in Wait and RunMainThreadJobs.
+         */
+        void RunOnMainThread(const Job& a_Job, JobCounter* a_Counter = nullptr, const std::vector<JobCounter*>& a_Dependencies = {});
+
+        /*
+         * Run jobs on the calling thread until every job of a_Counter finished.
+         * Throws the first exception that a job of a_Counter threw, which clears it from the counter.
+         */
+        void Wait(JobCounter& a_Counter);
+
+        /*
+         * Call a_Job for the items 0 up to a_Count, split into ranges of a_Grain items. Returns when every range is done.
+         * The ranges only depend on a_Count and a_Grain, so every item ends up in the same range no matter how many threads there are.
+         */
+        void ParallelFor(std::uint32_t a_Count, std::uint32_t a_Grain, const RangeJob& a_Job);
+
+        /*
+         * Run every job that was started with RunOnMainThread and can run now. Has to be called on the main thread.
+         */
+        void RunMainThreadJobs();
+
+        /*
+         * Get the amount of worker threads, and the amount of threads that run jobs including the main thread.
+         */
+        std::uint32_t GetWorkerCount() const;
+        std::uint32_t GetThreadCount() const;
+
+        /*
+         * Returns true when called on the thread that created this job system.
+         */
+        bool IsMainThread() const;
+
+        /*
+         * Get the counters of this job system.
+         */
+        JobSystemStats GetStats() const;
+
+    private:
+        struct QueuedJob
+        {
+            Job job;
+            JobCounter* counter;
+            std::uint32_t queue;    //The queue that the job was added to.
+        };
+
+        //A queue of jobs owned by one thread, which other threads steal from.
+        struct JobQueue
+        {
+            std::mutex mutex;
+            std::deque<QueuedJob> jobs;
+        };
+
+        /*
+         * Queue a job once its dependencies are done, starting at dependency a_First.
+         */
+        void Schedule(QueuedJob&& a_Job, bool a_MainThread, std::shared_ptr<std::vector<JobCounter*>> a_Dependencies, std::size_t a_First);
+
+        /*
+         * Add a job to the queue of the calling thread, or to the main thread queue.
+         */
+        void Enqueue(QueuedJob&& a_Job, bool a_MainThread);
+
+        /*
+         * Take a job from the queue of a_Thread, or steal one from another thread. Returns false when there are no jobs.
+         */
+        bool TakeJob(std::uint32_t a_Thread, QueuedJob& a_Job);
+
+        /*
+         * Take the oldest job that can only run on the main thread. Returns false when there are none.
+         */
+        bool TakeMainThreadJob(QueuedJob& a_Job);
+
+        /*
+         * Mark a job of a_Counter as finished, and start the jobs that depend on it when it was the last.
+         */
+        void Finish(JobCounter& a_Counter);
+
+        /*
+         * Run a job and mark it as finished in its counter.
+         */
+        void Execute(QueuedJob& a_Job, std::uint32_t a_Thread);
+
+        /*
+         * The loop of every worker thread.
+         */
+        void WorkerLoop(std::uint32_t a_Thread);
+
+        /*
+         * Get the index of the calling thread in this job system. Threads that are not part of it use the queue of the main thread.
+         */
+        std::uint32_t GetThreadIndex() const;
+
+    private:
+        std::thread::id m_MainThread;
+        std::vector<std::thread> m_Workers;
+
+        //One queue per thread. Queue 0 belongs to the main thread.
+        std::vector<std::unique_ptr<JobQueue>> m_Queues;
+
+        //Jobs that can only run on the main thread.
+        JobQueue m_MainThreadJobs;
+
+        //The amount of jobs in all queues except the main thread jobs. Workers sleep while it is zero.
+        std::atomic<std::int32_t> m_QueuedJobs;
+        std::mutex m_SleepMutex;
+        std::condition_variable m_WakeUp;
+        std::atomic<bool> m_Stop;
+
+        std::atomic<std::uint64_t> m_JobCount;
+        std::atomic<std::uint64_t> m_StolenCount;
+        std::atomic<std::uint64_t> m_MainThreadJobCount;
+    };
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Data.h"
+
+namespace blurp
+{
+    class Camera;
+
+    /*
+     * Settings that determine how the view frustum is divided into clusters.
+     */
+    struct LightClusterSettings
+    {
+        LightClusterSettings()
+        {
+            tilesX = 16;
+            tilesY = 9;
+            depthSlices = 24;
+            nearDepth = 1.f;
+            lightCutoff = 0.01f;
+        }
+
+        //The amount of clusters along the X and Y axis of the screen.
+        std::uint32_t tilesX;
+        std::uint32_t tilesY;
+
+        //The amount of clusters along the view direction. Has to be at least 2.
+        std::uint32_t depthSlices;
+
+        //The first slice reaches from the camera near plane up to this depth.
+        //The other slices divide the rest of the view up to the far plane exponentially, so that clusters keep roughly the same shape.
+        float nearDepth;
+
+        //The radiance below which a light no longer affects a surface.
+        //Point and spot lights have no range of their own, so their range is the distance where their light falls below this value.
+        float lightCutoff;
+    };
+
+    /*
+     * The lights of a single cluster, laid out the same way the forward shader reads them.
+     * offset is the index of the first light in the light index list. Point lights come first, followed by spot lights.
+     */
+    struct LightClusterCell
+    {
+        std::uint32_t offset;
+        std::uint32_t pointCount;
+        std::uint32_t spotCount;
+        std::uint32_t padding;
+    };
+
+    /*
+     * Counters for the last build.
+     */
+    struct LightClusterStats
+    {
+        LightClusterStats() : lights(0), clusterTests(0), lightIndices(0), maxLightsPerCluster(0) {}
+
+        //The amount of point and spot lights assigned to the clusters.
+        std::uint32_t lights;
+
+        //The amount of light versus cluster tests done.
+        std::uint64_t clusterTests;
+
+        //The length of the light index list.
+        std::uint32_t lightIndices;
+
+        //The most lights that affect a single cluster.
+        std::uint32_t maxLightsPerCluster;
+    };
+
+    /*
+     * LightClusterBuilder divides the view frustum of a camera into clusters, and finds the point and spot lights that affect each cluster.
+     * The result is a light index list, and a table with the offset into that list and the light counts for every cluster.
+     * After uploading, the forward pass only shades each fragment with the lights of its cluster instead of every light in the scene.
+     *
+     * Directional lights affect everything, so they are not assigned to clusters.
+     * Light indices refer to the light arrays that GpuBuffer::WriteData uploads, where lights without shadows are placed before lights with shadows.
+     * The assignment only depends on the camera and the lights, so the output is the same every time for the same input.
+     */
+    class LightClusterBuilder
+    {
+    public:
+        LightClusterBuilder();
+
+        /*
+         * Change how the view frustum is divided. The clusters are rebuilt on the next build.
+         */
+        void SetSettings(const LightClusterSettings& a_Settings);
+
+        /*
+         * Get the current settings.
+         */
+        const LightClusterSettings& GetSettings() const;
+
+        /*
+         * Assign the lights in a_Lights to the clusters of the camera.
+         * a_Lights has to contain the same lights as the upload that the forward pass uses.
+         * Only perspective cameras are supported.
+         */
+        void Build(const Camera& a_Camera, const LightUploadData& a_Lights);
+
+        /*
+         * Reference implementation of Build that tests every light against every cluster.
+         * Produces the same output as Build. Used to validate it.
+         */
+        void BuildReference(const Camera& a_Camera, const LightUploadData& a_Lights);
+
+        /*
+         * Upload the cluster table and light index list into a_Buffer, starting at a_Offset.
+         * The references to the uploaded data are stored in a_LightData, which can then be passed to the forward pass.
+         * Returns the view of the light index list, which is written last, so that more data can be appended behind it.
+         */
+        GpuBufferView Upload(const std::shared_ptr<GpuBuffer>& a_Buffer, std::uintptr_t a_Offset, LightData& a_LightData) const;
+
+        /*
+         * Get the index of the cluster that contains a position in view space.
+         * This uses the same calculation as the forward shader. Positions outside of the view are clamped to the closest cluster.
+         */
+        std::uint32_t GetClusterIndex(const glm::vec3& a_ViewPosition) const;
+
+        /*
+         * Get the table with one cell per cluster. Clusters are stored row by row, and slice after slice.
+         */
+        const std::vector<LightClusterCell>& GetCells() const;
+
+        /*
+         * Get the light index list that the cells point into.
+         */
+        const std::vector<std::uint32_t>& GetLightIndices() const;
+
+        /*
+         * Get the counters for the last build.
+         */
+        const LightClusterStats& GetStats() const;
+
+        /*
+         * Get the distance at which the light of a point or spot light falls below a_Cutoff.
+         */
+        static float GetLightRange(const glm::vec4& a_ColorIntensity, float a_Cutoff);
+
+    private:
+        //A point or spot light in view space.
+        struct ClusterLight
+        {
+            glm::vec3 position;
+            float range;
+            glm::vec3 direction;
+            float cosAngle;
+            float sinAngle;
+            bool spot;
+
+            //Spot lights wider than half a sphere are only tested by their range.
+            bool cone;
+
+            //Index into the uploaded light array of this type.
+            std::uint32_t index;
+        };
+
+        //Rebuild the cluster bounds when the projection or settings changed.
+        void UpdateClusters(const Camera& a_Camera);
+
+        //Transform the lights to view space and give them their index in the uploaded arrays.
+        void GatherLights(const Camera& a_Camera, const LightUploadData& a_Lights);
+
+        //Get the depth slice that contains a view depth.
+        std::uint32_t GetSlice(float a_Depth) const;
+
+        //Test a light against the bounds of a cluster.
+        bool Intersects(const ClusterLight& a_Light, std::uint32_t a_Cluster) const;
+
+        //Turn the list of light and cluster pairs into the cell table and light index list.
+        void Compact();
+
+    private:
+        LightClusterSettings m_Settings;
+
+        //The projection the clusters were built for.
+        glm::mat4 m_Projection;
+        bool m_Dirty;
+
+        //Depth slices map from view depth with floor(log(depth) * scale + bias).
+        float m_DepthScale;
+        float m_DepthBias;
+
+        //Start and end depth of every slice.
+        std::vector<float> m_SliceDepths;
+
+        //View space bounds of every cluster.
+        std::vector<glm::vec3> m_ClusterMin;
+        std::vector<glm::vec3> m_ClusterMax;
+
+        //Lights of the current build. Point lights come before spot lights.
+        std::vector<ClusterLight> m_Lights;
+
+        //Every cluster that a light affects, stored as (cluster, index into m_Lights).
+        std::vector<glm::uvec2> m_Pairs;
+
+        std::vector<LightClusterCell> m_Cells;
+        std::vector<std::uint32_t> m_LightIndices;
+
+        LightClusterStats m_Stats;
+    };
+}
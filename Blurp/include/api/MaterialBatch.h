@@ -1,4 +1,7 @@
 #pragma once
+#include <memory>
+#include <vector>
+
 #include "RenderResource.h"
 
 namespace blurp
@@ -6,7 +9,7 @@ namespace blurp
     class MaterialBatch : public RenderResource
     {
     public:
-        MaterialBatch(const MaterialBatchSettings& a_Settings) : m_Settings(a_Settings) {}
+        MaterialBatch(const MaterialBatchSettings& a_Settings) : m_Settings(a_Settings), m_HasTexture(false) {}
 
         /*
          * Return the 16bit bitmask.
@@ -16,7 +19,40 @@ namespace blurp
             return m_Settings.GetMask();
         }
 
+        /*
+         * Returns true if the materials in this batch use textures, which are then stored in a single array texture.
+         */
+        bool HasTexture() const
+        {
+            return m_HasTexture;
+        }
+
+        /*
+         * Get the array texture containing the textures of every material.
+         */
+        std::shared_ptr<Texture> GetTexture() const
+        {
+            return m_ArrayTexture;
+        }
+
+        /*
+         * Get the amount of textures per material in the array texture.
+         */
+        int GetActiveTextureCount() const
+        {
+            return m_Settings.textureCount;
+        }
+
+    protected:
+        /*
+         * Pack the constant data of every material into one array of floats, padded following the std140 layout rules.
+         * The array is empty when no constant material attributes are enabled.
+         */
+        std::vector<float> PackConstantData() const;
+
     protected:
         MaterialBatchSettings m_Settings;
+        bool m_HasTexture;
+        std::shared_ptr<Texture> m_ArrayTexture;
     };
 }
\ No newline at end of file
@@ -1,12 +1,13 @@
 #pragma once
 #include "RenderResource.h"
+#include "Culling.h"
 
 namespace blurp
 {
     class Mesh : public RenderResource
     {
     public:
-        Mesh(const MeshSettings& a_Settings) : m_Settings(a_Settings), m_Mask(a_Settings.vertexSettings.GetMask()){}
+        Mesh(const MeshSettings& a_Settings) : m_Settings(a_Settings), m_Mask(a_Settings.vertexSettings.GetMask()), m_Bounds(CalculateMeshBounds(a_Settings)){}
 
         /*
          * Get the vertex attribute mask for this mesh.
@@ -34,8 +35,18 @@ namespace blurp
             return m_Settings;
         }
 
+        /*
+         * Get the bounds of this mesh in object space.
+         * These are calculated from the vertex positions when the mesh is created.
+         */
+        const MeshBounds& GetBounds() const
+        {
+            return m_Bounds;
+        }
+
     protected:
         MeshSettings m_Settings;
         VertexAttribute m_Mask;
+        MeshBounds m_Bounds;
     };
 }
@@ -0,0 +1,197 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RenderPass_ShadowMap.h"
+
+namespace blurp
+{
+    /*
+     * What happens to a single cube face of a positional shadow map this frame.
+     */
+    enum class ShadowFaceUpdate
+    {
+        //Nothing changed. The face is not cleared and nothing is drawn into it.
+        CACHED,
+
+        //The face is cleared and every caster is drawn into it. Used when there are no static layers.
+        REDRAW,
+
+        //The static layer is cleared and the static casters are drawn into it. It is then copied into the shadow map and the dynamic casters are drawn on top.
+        REDRAW_STATIC,
+
+        //The static layer is still valid. It is copied into the shadow map and the dynamic casters are drawn on top.
+        RESTORE
+    };
+
+    /*
+     * Settings for a PositionalShadowCache.
+     */
+    struct PositionalShadowCacheSettings
+    {
+        PositionalShadowCacheSettings()
+        {
+            slots = 1;
+            moveThreshold = 0.001f;
+            staticLayers = false;
+        }
+
+        //The amount of shadow maps in the positional shadow map array. Light indices go from 0 up to slots - 1.
+        std::uint32_t slots;
+
+        //A light has to move further than this distance before its shadow map is drawn again.
+        float moveThreshold;
+
+        //Keep the depth of static casters in ShadowData::positional::staticShadowMaps.
+        //When enabled, dynamic casters no longer cause the static casters to be drawn again.
+        bool staticLayers;
+    };
+
+    /*
+     * Counters for the last call to PositionalShadowCache::Update. The totals are not cleared between frames.
+     */
+    struct PositionalShadowCacheStats
+    {
+        PositionalShadowCacheStats() : faces(0), cached(0), redrawn(0), staticRedrawn(0), restored(0), movedLights(0), newLights(0), staticInvalidated(0), dynamicLights(0), clearedLayers(0), totalCached(0), totalDrawn(0) {}
+
+        //The amount of faces of all lights passed in. Six per light.
+        std::uint32_t faces;
+
+        //The amount of faces per ShadowFaceUpdate.
+        std::uint32_t cached;
+        std::uint32_t redrawn;
+        std::uint32_t staticRedrawn;
+        std::uint32_t restored;
+
+        //The amount of lights that moved since the last frame.
+        std::uint32_t movedLights;
+
+        //The amount of lights that were not in their slot in the last frame.
+        std::uint32_t newLights;
+
+        //The amount of faces that were invalidated because static casters changed.
+        std::uint32_t staticInvalidated;
+
+        //The amount of lights with dynamic casters in any face in this or the last frame.
+        std::uint32_t dynamicLights;
+
+        //The amount of layers that have to be cleared, in both the shadow map and the static layers.
+        std::uint32_t clearedLayers;
+
+        //The amount of faces that were skipped and drawn since the cache was created.
+        std::uint64_t totalCached;
+        std::uint64_t totalDrawn;
+    };
+
+    /*
+     * PositionalShadowCache decides which cube faces of the positional shadow maps have to be drawn again each frame.
+     *
+     * A face keeps its content from the last frame when its light did not move, no static caster that it can see changed, and no dynamic caster
+     * is drawn into the face in this or the last frame. Those faces are neither cleared nor drawn.
+     *
+     * Geometry is static when LightIndexData::staticCaster is set. The static casters of every face are compared to the last frame by their mesh and
+     * instance count. Static casters that move without changing their count have to be reported with Invalidate.
+     * Geometry only counts for the faces in its LightIndexData::faceMask, so a dynamic caster behind a light leaves the faces in front of it cached.
+     *
+     * With static layers enabled, static caster depth is kept in a second cube map array. Dynamic casters then only need the static depth to be copied
+     * back before they are drawn, instead of drawing every static caster again.
+     *
+     * Call Update every frame after the lights and geometry are added to the shadow pass, and before the clear pass runs.
+     * RenderPass_ShadowMap::UpdateShadowCache does this with the lights and geometry of the pass.
+     */
+    class PositionalShadowCache
+    {
+    public:
+        PositionalShadowCache();
+
+        /*
+         * Change the settings. Every face is drawn again on the next update.
+         */
+        void SetSettings(const PositionalShadowCacheSettings& a_Settings);
+
+        /*
+         * Get the current settings.
+         */
+        const PositionalShadowCacheSettings& GetSettings() const;
+
+        /*
+         * Static casters changed inside the given sphere. Every face that can see the sphere is drawn again on the next update.
+         */
+        void Invalidate(const glm::vec3& a_Center, float a_Radius);
+
+        /*
+         * Draw every face again on the next update.
+         */
+        void InvalidateAll();
+
+        /*
+         * Decide what happens to every face of the given lights this frame.
+         * a_Lights are the positional lights in the order they were added to the shadow pass. Their index is the slot in the shadow map array.
+         * a_DrawData and a_LightIndices are the geometry passed to RenderPass_ShadowMap::SetGeometry. a_LightIndices can be nullptr, which makes all geometry dynamic.
+         * a_NearPlane and a_FarPlane are the planes used by the shadow pass.
+         */
+        void Update(const LightShadowData* a_Lights, std::uint32_t a_LightCount, const DrawData* a_DrawData, const LightIndexData* a_LightIndices, std::uint32_t a_DrawCount, float a_NearPlane, float a_FarPlane);
+
+        /*
+         * Get what happens to a face of the shadow map in a slot. Slots without a light this frame are CACHED.
+         */
+        ShadowFaceUpdate GetFaceUpdate(std::uint32_t a_Slot, std::uint32_t a_Face) const;
+
+        /*
+         * Get a mask with bit N set when face N of the shadow map in a slot has the given update.
+         */
+        std::uint32_t GetFaceMask(std::uint32_t a_Slot, ShadowFaceUpdate a_Update) const;
+
+        /*
+         * Get the regions of the shadow map array that have to be cleared this frame.
+         * Pass true for a_Static to get the regions of the static layers instead.
+         * Offset and size in Z are set for every region, X and Y are copied from a_Template together with the clear value.
+         * Consecutive layers are merged into a single region.
+         */
+        void GetClearRegions(bool a_Static, const ClearData& a_Template, std::vector<ClearData>& a_Output) const;
+
+        /*
+         * Get the counters for the last call to Update.
+         */
+        const PositionalShadowCacheStats& GetStats() const;
+
+    private:
+        //What is known about the shadow map in a single slot.
+        struct SlotState
+        {
+            SlotState() : used(false), validMask(0), position(0.f), staticSignatures{}, dynamicMask(0) {}
+
+            //A light was in this slot in the last frame.
+            bool used;
+
+            //Bit N is set when face N contains the shadow of the light at position.
+            std::uint32_t validMask;
+            glm::vec3 position;
+
+            //Combination of the meshes and instance counts of the static casters of every face.
+            std::uint64_t staticSignatures[6];
+
+            //Bit N is set when dynamic casters were drawn into face N in the last frame.
+            std::uint32_t dynamicMask;
+        };
+
+    private:
+        PositionalShadowCacheSettings m_Settings;
+        PositionalShadowCacheStats m_Stats;
+
+        std::vector<SlotState> m_Slots;
+        std::vector<ShadowFaceUpdate> m_Updates;    //Six per slot.
+
+        //Static caster signature of every face, and the mask of faces with dynamic casters of every light passed to Update.
+        std::vector<std::uint64_t> m_LightSignatures;   //Six per light.
+        std::vector<std::uint8_t> m_LightDynamic;
+
+        //Spheres passed to Invalidate since the last update. Radius in W.
+        std::vector<glm::vec4> m_Invalidated;
+        bool m_InvalidateAll;
+
+        float m_NearPlane;
+        float m_FarPlane;
+    };
+}
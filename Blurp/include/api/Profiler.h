@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Profiling markers are only compiled in when BLURP_PROFILING is defined, which the debug configurations do.
+ * Without it the macros expand to nothing and their arguments are never evaluated, so markers cost nothing in release builds.
+ */
+#ifdef BLURP_PROFILING
+#define BLURP_PROFILE_CONCAT_INNER(a_A, a_B) a_A##a_B
+#define BLURP_PROFILE_CONCAT(a_A, a_B) BLURP_PROFILE_CONCAT_INNER(a_A, a_B)
+
+//Record the time until the end of the enclosing scope as a CPU marker of a_Profiler.
+#define BLURP_PROFILE_SCOPE(a_Profiler, a_Name) ::blurp::ProfileScope BLURP_PROFILE_CONCAT(profileScope, __LINE__)((a_Profiler), (a_Name))
+
+//Measure the GPU work submitted until the end of the enclosing scope with a_Timer, which may be nullptr.
+#define BLURP_PROFILE_GPU_SCOPE(a_Timer, a_Name) ::blurp::ProfileGpuScope BLURP_PROFILE_CONCAT(profileGpuScope, __LINE__)((a_Timer), (a_Name))
+#else
+#define BLURP_PROFILE_SCOPE(a_Profiler, a_Name)
+#define BLURP_PROFILE_GPU_SCOPE(a_Timer, a_Name)
+#endif
+
+namespace blurp
+{
+    class Profiler;
+
+    enum class ProfileEventType : std::uint8_t
+    {
+        CPU,
+        GPU
+    };
+
+    /*
+     * A single marker recorded by the Profiler. Times are in microseconds since the profiler was created.
+     */
+    struct ProfileEvent
+    {
+        const char* name;
+        ProfileEventType type;
+        std::uint32_t thread;   //The index of the thread that recorded a CPU marker. Always 0 for GPU markers.
+        double start;           //GPU markers are converted to the CPU clock, so both can be compared.
+        double duration;
+    };
+
+    /*
+     * The markers of one frame of the Profiler.
+     */
+    struct ProfileFrame
+    {
+        ProfileFrame() : index(0), start(0.0), duration(0.0) {}
+
+        std::uint64_t index;
+        double start;
+        double duration;        //0 while the frame is still being recorded.
+
+        //CPU markers in the order that they ended, followed by GPU markers once they are resolved.
+        std::vector<ProfileEvent> events;
+    };
+
+    /*
+     * Measures how long ranges of GPU work take with timestamp queries. Every graphics API that supports them has its own implementation.
+     * Results are only known a few frames after the work was submitted, so they are given to the profiler once they are available instead of right away.
+     * Only the thread that owns the graphics API can use a GpuTimer.
+     */
+    class GpuTimer
+    {
+    public:
+        virtual ~GpuTimer() = default;
+
+        /*
+         * Give every result that is available to a_Profiler, and start measuring ranges for the current frame of a_Profiler.
+         */
+        virtual void BeginFrame(Profiler& a_Profiler) = 0;
+
+        /*
+         * Begin and end a range of GPU work called a_Name. Ranges can not overlap, and are ignored before the first BeginFrame.
+         */
+        virtual void Begin(const char* a_Name) = 0;
+        virtual void End() = 0;
+    };
+
+    /*
+     * Profiler keeps the CPU and GPU markers of the last frames in a ring buffer, which can be exported in the Chrome trace event format.
+     * Open the exported file in chrome://tracing or Perfetto to see when every marker ran on which thread.
+     *
+     * Markers can be recorded on any thread. Marker names are stored as pointers, so they have to stay valid as long as the profiler, such as string literals.
+     * Call NextFrame once every frame, otherwise every marker ends up in the same frame.
+     */
+    class Profiler
+    {
+    public:
+        /*
+         * Create a profiler that keeps the markers of the last a_FrameCount frames.
+         * The calling thread is recorded as the main thread.
+         */
+        explicit Profiler(std::uint32_t a_FrameCount);
+
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        /*
+         * Finish the current frame and start the next one, which replaces the oldest frame in the buffer.
+         */
+        void NextFrame();
+
+        /*
+         * Get the index of the frame that is currently being recorded.
+         */
+        std::uint64_t GetFrameIndex() const;
+
+        /*
+         * Get the time in microseconds since the profiler was created.
+         */
+        double Now() const;
+
+        /*
+         * Turn recording on or off. Markers that are recorded while the profiler is disabled are dropped.
+         */
+        void SetEnabled(bool a_Enabled);
+        bool IsEnabled() const;
+
+        /*
+         * Add a CPU marker of the calling thread to the current frame.
+         */
+        void AddCpuEvent(const char* a_Name, double a_Start, double a_Duration);
+
+        /*
+         * Add a GPU marker to frame a_Frame. The marker is dropped when that frame is no longer in the buffer.
+         */
+        void AddGpuEvent(std::uint64_t a_Frame, const char* a_Name, double a_Start, double a_Duration);
+
+        /*
+         * Get a copy of every frame in the buffer, oldest first. The last frame is the one that is still being recorded.
+         */
+        std::vector<ProfileFrame> GetFrames() const;
+
+        /*
+         * Get the amount of frames that the buffer keeps.
+         */
+        std::uint32_t GetFrameCount() const;
+
+        /*
+         * Write every frame in the buffer as Chrome trace event JSON.
+         */
+        void WriteChromeTrace(std::ostream& a_Stream) const;
+
+        /*
+         * Write every frame in the buffer as Chrome trace event JSON to the file at a_Path. Returns false when the file could not be written.
+         */
+        bool ExportChromeTrace(const std::string& a_Path) const;
+
+    private:
+        /*
+         * Get the index of the calling thread, which is added when it did not record a marker before. Called with the mutex locked.
+         */
+        std::uint32_t GetThreadIndex();
+
+    private:
+        const std::chrono::steady_clock::time_point m_Start;
+        std::atomic<bool> m_Enabled;
+
+        //Guards everything below.
+        mutable std::mutex m_Mutex;
+
+        //Ring buffer of frames. Frame n is stored at n modulo the size.
+        std::vector<ProfileFrame> m_Frames;
+        std::uint64_t m_FrameIndex;
+
+        //Every thread that recorded a marker. The index in this vector is the thread index of its markers.
+        std::vector<std::thread::id> m_Threads;
+    };
+
+    /*
+     * Records a CPU marker from construction until destruction. See BLURP_PROFILE_SCOPE.
+     */
+    class ProfileScope
+    {
+    public:
+        ProfileScope(Profiler& a_Profiler, const char* a_Name);
+        ~ProfileScope();
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        Profiler& m_Profiler;
+        const char* m_Name;
+        double m_Start;
+    };
+
+    /*
+     * Measures the GPU work submitted from construction until destruction. Does nothing when the timer is nullptr. See BLURP_PROFILE_GPU_SCOPE.
+     */
+    class ProfileGpuScope
+    {
+    public:
+        ProfileGpuScope(GpuTimer* a_Timer, const char* a_Name);
+        ~ProfileGpuScope();
+
+        ProfileGpuScope(const ProfileGpuScope&) = delete;
+        ProfileGpuScope& operator=(const ProfileGpuScope&) = delete;
+
+    private:
+        GpuTimer* m_Timer;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <string>
 
 
 #include "RenderResource.h"
@@ -118,6 +119,12 @@ namespace blurp
          */
         virtual std::shared_ptr<GpuBuffer> CreateGpuBuffer(const GpuBufferSettings& a_Settings) = 0;
 
+        /*
+         * Get a string that identifies the driver, used to make sure that stored shader binaries are only loaded by the driver that made them.
+         * Returns an empty string when the device can not load shader binaries.
+         */
+        virtual std::string GetDriverId() const;
+
     protected:
         /*
          * Bind a Window and SwapChain together.
@@ -1,4 +1,8 @@
 #pragma once
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
 #include "LockType.h"
 #include "RenderResource.h"
 
@@ -13,7 +17,7 @@ namespace blurp
     public:
         virtual ~RenderPass() = default;
 
-        RenderPass(RenderPipeline& a_Pipeline) : m_Pipeline(a_Pipeline), m_Enabled(true) {}
+        RenderPass(RenderPipeline& a_Pipeline) : m_Pipeline(a_Pipeline), m_Enabled(true), m_PrepareIndex(0) {}
 
         //Don't allow copy.
         RenderPass(RenderPass&) = delete;
@@ -29,6 +33,17 @@ namespace blurp
          */
         bool IsEnabled() const;
 
+        /*
+         * Make the preparation of this pass wait until a_Pass is prepared, for passes that read data which a_Pass prepares.
+         * a_Pass has to be part of the same pipeline and appended before this pass. Passes without dependencies are prepared at the same time.
+         */
+        void AddDependency(const std::shared_ptr<RenderPass>& a_Pass);
+
+        /*
+         * Get the passes that have to be prepared before this pass.
+         */
+        const std::vector<RenderPass*>& GetDependencies() const;
+
         /*
          * Get the type of this render pass.
          */
@@ -49,13 +64,31 @@ namespace blurp
         virtual bool IsStateValid() = 0;
 
         /*
-         * Execute this RenderPass with the currently bound settings.
+         * Called for every enabled pass on the thread that executes the pipeline, before any pass is prepared.
+         * Update lazily calculated data that other passes read as well here, such as the matrices of a camera, so that preparing only reads it.
          */
-        virtual void Execute() = 0;
+        virtual void PrePrepare() {}
 
-    private:
-        
+        /*
+         * Do the CPU work of this pass that does not use the graphics API, such as sorting and calculating matrices.
+         * This runs on a worker thread at the same time as the preparation of other passes, so it may only write to this pass.
+         */
+        virtual void Prepare() {}
+
+        /*
+         * Send the work prepared for this pass to the graphics API. Passes are submitted one after another in the order of the pipeline.
+         */
+        virtual void Submit() = 0;
+
+    protected:
+        //The pipeline that this pass is part of.
         RenderPipeline& m_Pipeline;
+
+    private:
         bool m_Enabled;
+
+        //Passes that are prepared before this pass, and the index of this pass in the pipeline.
+        std::vector<RenderPass*> m_Dependencies;
+        std::uint32_t m_PrepareIndex;
     };
 }
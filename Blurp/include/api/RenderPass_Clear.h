@@ -25,6 +25,11 @@ namespace blurp
          */
         void AddTexture(const std::shared_ptr<Texture>& a_Texture, const ClearData& a_ClearData);
 
+        /*
+         * Stop clearing a texture. Every region that was added for it is removed.
+         */
+        void RemoveTexture(const std::shared_ptr<Texture>& a_Texture);
+
         RenderPassType GetType() override;
         void Reset() override;
 
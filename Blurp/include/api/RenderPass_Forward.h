@@ -1,18 +1,43 @@
 #pragma once
 #include "RenderTarget.h"
 #include "Camera.h"
+#include "CommandList.h"
 #include "Light.h"
 #include "RenderPass.h"
+#include "DrawSorter.h"
+#include "ShaderCompileQueue.h"
+#include "ShaderMaskTable.h"
 
+#include <algorithm>
+#include <limits>
 #include <unordered_set>
 
 namespace blurp
 {
+    class Mesh;
+    class Shader;
+    class ShaderManifest;
+
+    /*
+     * Data that is the same for every draw in a forward pass, laid out like the uniform block that the forward shaders read from.
+     */
+    struct StaticData
+    {
+        glm::mat4 pv;                            //Projection * View matrix for the camera.
+        glm::vec4 camPosFarPlane;               //XYZ = camera position. W = far plane distance.
+        glm::vec4 numLightsNumCascades;        //X = numPointLight. Y = numSpotLights. Z = numDirectionalLights.    W = number of dir shadow cascades.
+        glm::vec4 numShadows;                 //X = numPointShadows. Y = numSpotShadows. Z = numDirectionalShadows.
+        glm::vec4 ambientLight;              //The ambient light RGB.
+        glm::vec4 clusterCounts;            //Number of light clusters. X = screen X. Y = screen Y. Z = depth slices.
+        glm::vec4 clusterDepth;            //X = depth slice scale. Y = depth slice bias.
+    };
+
     class RenderPass_Forward : public RenderPass
     {
     public:
         RenderPass_Forward(RenderPipeline& a_Pipeline)
-            : RenderPass(a_Pipeline)
+            : RenderPass(a_Pipeline), m_SortDrawData(false), m_WarmUpBudget(0.f), m_ShaderManifestChanged(false), m_ShaderFallbackPolicy(ShaderFallbackPolicy::BLOCK), m_CompileBudget(0.f), m_StaticData(),
+            m_DrawKey(0), m_RecordThreads(std::numeric_limits<std::uint32_t>::max()), m_DrawsPerList(1024)
         {
         }
 
@@ -36,6 +61,14 @@ namespace blurp
          */
         void SetDrawData(const DrawDataSet& a_DrawDataSet);
 
+        /*
+         * Enable or disable sorting of the draw data before drawing.
+         * When enabled, opaque draws are grouped by pipeline state, shader, material and mesh and drawn front-to-back.
+         * Blended draws are drawn back-to-front after all opaque draws. DrawData::sortDepth is used as depth.
+         * When disabled, the submission order is kept. This setting persists between frames.
+         */
+        void SetDrawSorting(bool a_Enabled);
+
         /*
          * Set the light to be used for this scene.
          */
@@ -46,6 +79,42 @@ namespace blurp
          */
         void SetShadowData(const ShadowData& a_ShadowData);
 
+        /*
+         * Set the manifest that the shader variants compiled by this pass are recorded in. Set to nullptr to stop recording.
+         * The variants of this pass that are already in the manifest are compiled before drawing, spending at most a_WarmUpBudget milliseconds each frame.
+         * With a budget of 0 or less they are all compiled in the next frame.
+         */
+        void SetShaderManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, float a_WarmUpBudget = 0.f);
+
+        /*
+         * Set what happens when a shader variant that this pass needs is not compiled yet. See ShaderFallbackPolicy.
+         * With any policy other than BLOCK, missing variants are compiled in the background, spending at most a_CompileBudget milliseconds each frame on starting them.
+         */
+        void SetShaderFallbackPolicy(ShaderFallbackPolicy a_Policy, float a_CompileBudget = 2.f);
+
+        /*
+         * Get what happens when a shader variant that this pass needs is not compiled yet.
+         */
+        ShaderFallbackPolicy GetShaderFallbackPolicy() const;
+
+        /*
+         * Set how draws are recorded into command lists. Every list holds at most a_DrawsPerList draws, and the lists are recorded on up to a_MaxThreads threads.
+         * The recorded commands only depend on a_DrawsPerList, never on the amount of threads. By default every thread of the JobSystem is used, with 1024 draws per list.
+         */
+        void SetCommandRecording(std::uint32_t a_MaxThreads, std::uint32_t a_DrawsPerList);
+
+        /*
+         * Get the command lists that the draws of the last execution were replayed from.
+         * The lists are only recorded again when the draws, their materials or their shaders change.
+         */
+        const CommandListSet& GetDrawLists() const;
+
+        /*
+         * Create the table of the shader mask bits of this pass: the vertex attributes, the draw attributes, the material attributes,
+         * and the bits for positional shadows, directional shadows and light clusters. Bone attributes are not used by the forward shaders.
+         */
+        static ShaderMaskTable CreateShaderMaskTable();
+
         /*
          * Reset for the next frame.
          */
@@ -53,19 +122,82 @@ namespace blurp
 
     protected:
         bool IsStateValid() override;
+        void PrePrepare() override;
+
+        /*
+         * Calculate the static data, sort the draw data if enabled, and find the pipeline state and shader mask of every draw.
+         */
+        void Prepare() override;
+
+        /*
+         * Calculate the data that every draw of this frame reads, from the camera, lights and shadows that are set.
+         */
+        StaticData CalculateStaticData() const;
+
+        /*
+         * Get the shader to draw a_Mesh with for a_Mask. Returns nullptr when there is no shader to use yet, in which case the draw is skipped.
+         * This is only called from the thread that executes the pass.
+         */
+        virtual std::shared_ptr<Shader> GetShader(std::uint64_t a_Mask, const Mesh& a_Mesh) = 0;
+
+        /*
+         * Find the shader of every prepared draw, and record the draws into m_DrawLists. Nothing is recorded when the lists already contain the same draws.
+         */
+        void RecordDraws();
+
+    private:
+        /*
+         * Record draws a_Begin up to a_End of m_PreparedDraws into a_List. Called from multiple threads at once for different ranges.
+         */
+        void RecordDrawRange(CommandList& a_List, std::uint32_t a_Begin, std::uint32_t a_End) const;
 
     protected:
 
         std::shared_ptr<Camera> m_Camera;
         std::shared_ptr<RenderTarget> m_Output;
 
-        //Draw queue containing all drawable data. Order is kept while drawing.
+        //Draw queue containing all drawable data. Order is kept while drawing unless sorting is enabled.
         DrawDataSet m_DrawDataSet;
 
+        //Sorts the draw queue by state and depth when enabled.
+        bool m_SortDrawData;
+        DrawSorter m_DrawSorter;
+
         //Shadow information for all lights.
         ShadowData m_ShadowData;
 
         //The light data object containing all information about the lights in the scene.
         LightData m_LightData;
+
+        //Manifest of the shader variants used by this pass. Changed is set until the shader cache picks up a new manifest.
+        std::shared_ptr<ShaderManifest> m_ShaderManifest;
+        float m_WarmUpBudget;
+        bool m_ShaderManifestChanged;
+
+        //What is drawn while shader variants compile, and how long is spent on starting them each frame.
+        ShaderFallbackPolicy m_ShaderFallbackPolicy;
+        float m_CompileBudget;
+
+        //The data that every draw reads, calculated when the pass is prepared.
+        StaticData m_StaticData;
+
+        //Command lists that the draws are recorded into, which are kept between frames.
+        CommandListSet m_DrawLists;
+
+    private:
+        //A draw in submission order, with the pipeline state and shader that it uses. The shader keeps the recorded lists valid.
+        struct PreparedDraw
+        {
+            const DrawData* drawData;
+            const PipelineState* pipelineState;
+            std::uint64_t shaderMask;
+            std::shared_ptr<Shader> shader;
+        };
+
+        //The prepared draws, and the key of their commands without the shaders.
+        std::vector<PreparedDraw> m_PreparedDraws;
+        std::uint64_t m_DrawKey;
+        std::uint32_t m_RecordThreads;
+        std::uint32_t m_DrawsPerList;
     };
 }
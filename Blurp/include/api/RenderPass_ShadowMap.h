@@ -1,10 +1,21 @@
 #pragma once
+#include <bitset>
+
 #include "Camera.h"
 #include "Light.h"
 #include "RenderPass.h"
+#include "DrawSorter.h"
+#include "ShaderCompileQueue.h"
+#include "ShaderMaskTable.h"
 
 namespace blurp
 {
+    class PositionalShadowCache;
+    class CascadeScheduler;
+    class ShaderManifest;
+    class GpuBuffer;
+    class Shader;
+
     /*
      * Struct containing the data required to render a shadow map for a positional light.
      */
@@ -22,20 +33,66 @@ namespace blurp
         glm::vec3 data;
     };
 
+    //The maximum amount of lights of each type that can generate a shadow map in a single pass.
+    constexpr std::uint32_t MAX_SHADOW_LIGHTS = 64;
+
+    /*
+     * The data of a positional light that casts a shadow, laid out like the uniform block that the shadow shaders read from.
+     */
+    struct PosLightData
+    {
+        glm::vec4 lightPosition;
+        glm::mat4 matrices[6];
+        glm::vec<4, std::int32_t> shadowMapIndex;   //X is the shadow map index, Y the mask of faces to draw. 2 * 4 Bytes padding.
+    };
+
+    /*
+     * The directional lights that cast a shadow, laid out like the uniform block that the shadow shaders read from.
+     */
+    struct DirLightData
+    {
+        glm::ivec4 numCascades;                         //The amount of cascades stored in X.
+        glm::ivec4 shadowIndices[MAX_SHADOW_LIGHTS];    //Only X is used.
+    };
+
+    /*
+     * The camera clip depth and light view projection matrix of a single cascade, as stored in the directional shadow GpuBuffer.
+     */
+    struct DirCascade
+    {
+        glm::vec4 clipDepth;
+        glm::mat4 transform;
+    };
+
+    /*
+     * Specifies which lights a piece of geometry casts a shadow for.
+     * Bit i refers to the i-th light of that type that was added to the shadow pass with AddLight.
+     */
     struct LightIndexData
     {
-        //Indices of all directional lights that this geometry affects.
-        std::vector<std::int32_t> dirIndices;
+        LightIndexData() : cascadeMask(~0u), faceMask(0x3Fu), staticCaster(false) {}
+
+        //Directional lights that this geometry affects.
+        std::bitset<MAX_SHADOW_LIGHTS> dirLights;
+
+        //Positional lights that this geometry affects.
+        std::bitset<MAX_SHADOW_LIGHTS> posLights;
+
+        //The cascades of the directional lights that this geometry is drawn into. Bit i is cascade i. All cascades by default.
+        std::uint32_t cascadeMask;
 
-        //Indices of all positional lights that this geometry affects.
-        std::vector<std::int32_t> posIndices;
+        //The cube faces of the positional lights that this geometry is drawn into. Bit i is face i, in the order of CalculateCubeFaces. All faces by default.
+        std::uint32_t faceMask;
+
+        //The geometry does not move. Used by a PositionalShadowCache to keep the shadows of positional lights between frames.
+        bool staticCaster;
     };
 
     class RenderPass_ShadowMap : public RenderPass
     {
     public:
         RenderPass_ShadowMap(RenderPipeline& a_Pipeline)
-            : RenderPass(a_Pipeline), m_DrawDataPtr(nullptr), m_LightIndices(nullptr), m_DrawDataCount(0)
+            : RenderPass(a_Pipeline), m_DrawDataPtr(nullptr), m_LightIndices(nullptr), m_DrawDataCount(0), m_SortDrawData(false), m_SkippedCascades(0), m_DrawOrder(nullptr), m_DirLightData(), m_CascadeUpdateMask(0), m_WarmUpBudget(0.f), m_ShaderManifestChanged(false), m_ShaderFallbackPolicy(ShaderFallbackPolicy::BLOCK), m_CompileBudget(0.f), m_MaxPosLightsPerCall(0), m_MaxComponents(0), m_MaxTriangles(0), m_PrevShaderMask(0), m_CurrentShader(nullptr), m_PrevMesh(nullptr)
         {
         }
 
@@ -59,15 +116,104 @@ namespace blurp
          * a_Count is the total amount of elements in both arrays. They have to be equal size.
          *
          * If a_LightIndexData is nullptr, all lights will affect all geometry.
+         * Geometry is only drawn into the cascades enabled in its cascade mask, and skipped when no light or cascade remains.
          */
         void SetGeometry(const DrawData* a_DrawData, const LightIndexData* a_LightIndexData, const std::uint32_t a_Count);
 
+        /*
+         * Enable or disable sorting of the geometry before drawing.
+         * When enabled, geometry is grouped by shader and mesh, and drawn front-to-back using DrawData::sortDepth.
+         * When disabled, the submission order is kept. This setting persists between frames.
+         */
+        void SetDrawSorting(bool a_Enabled);
+
         /*
          * Set the struct containing output information for this shadow generation pass.
          * No shadowmaps will be generated if the provided textures for the shadow type are nullptr.
          */
         void SetOutput(const ShadowData& a_Data);
 
+        /*
+         * Set the cache that decides which faces of the positional shadow maps are drawn again. Set to nullptr to draw every face every frame.
+         * The clear pass should then only clear the regions returned by PositionalShadowCache::GetClearRegions.
+         */
+        void SetShadowCache(const std::shared_ptr<PositionalShadowCache>& a_Cache);
+
+        /*
+         * Update the shadow cache with the positional lights and geometry of this frame.
+         * Call this after adding the lights and setting the geometry, and before the pipeline is executed.
+         */
+        void UpdateShadowCache();
+
+        /*
+         * Set the scheduler that decides which cascades of the directional shadow maps are drawn. Set to nullptr to draw every cascade every frame.
+         * The clear pass should then only clear the regions returned by CascadeScheduler::GetClearRegions.
+         */
+        void SetCascadeScheduler(const std::shared_ptr<CascadeScheduler>& a_Scheduler);
+
+        /*
+         * Schedule the cascades of the directional lights of this frame.
+         * Call this after adding the lights, and before the pipeline is executed.
+         */
+        void UpdateCascadeScheduler();
+
+        /*
+         * Get the cascades that were not drawn in the last execution, because they kept their depth from an earlier frame. Bit N is cascade N.
+         */
+        std::uint32_t GetSkippedCascades() const;
+
+        /*
+         * Set the manifest that the shader variants compiled by this pass are recorded in. Set to nullptr to stop recording.
+         * The variants of this pass that are already in the manifest are compiled before drawing, spending at most a_WarmUpBudget milliseconds each frame.
+         * With a budget of 0 or less they are all compiled in the next frame.
+         */
+        void SetShaderManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, float a_WarmUpBudget = 0.f);
+
+        /*
+         * Set what happens when a shader variant that this pass needs is not compiled yet. See ShaderFallbackPolicy.
+         * Every bit of a shadow variant changes its inputs, so other variants are never used in place of a missing one. Geometry is skipped until its variant is ready.
+         * With any policy other than BLOCK, missing variants are compiled in the background, spending at most a_CompileBudget milliseconds each frame on starting them.
+         */
+        void SetShaderFallbackPolicy(ShaderFallbackPolicy a_Policy, float a_CompileBudget = 2.f);
+
+        /*
+         * Get what happens when a shader variant that this pass needs is not compiled yet.
+         */
+        ShaderFallbackPolicy GetShaderFallbackPolicy() const;
+
+        /*
+         * Calculate the view projection matrix and the camera clip space depth for every cascade of a directional light.
+         * The matrices cover the part of the camera frustum belonging to each cascade, stretched towards the light so that casters outside of the view are included.
+         * a_Matrices and a_ClipDepths need room for a_ShadowData.directional.numCascades elements.
+         * This is what the pass uses to render the cascades, so culling against these volumes matches what ends up in the shadow map.
+         * When a_ShadowData contains the directional shadow maps, the volumes are snapped to their texels so that shadows do not shimmer when the camera moves.
+         */
+        static void CalculateCascades(const Camera& a_Camera, const glm::vec3& a_Direction, const ShadowData& a_ShadowData, glm::mat4* a_Matrices, glm::vec4* a_ClipDepths);
+
+        /*
+         * Calculate the view projection matrix of every cube map face for a positional light at a_Position.
+         * a_Matrices needs room for 6 elements, in the order +X, -X, +Y, -Y, +Z, -Z.
+         */
+        static void CalculateCubeFaces(const glm::vec3& a_Position, float a_NearPlane, float a_FarPlane, glm::mat4* a_Matrices);
+
+        /*
+         * Find the cube faces of a positional light at a_Position that a sphere is visible in. Bit i is set for face i, in the order of CalculateCubeFaces.
+         * This gives the same result as testing the sphere against the planes of the face matrices.
+         */
+        static std::uint32_t CalculateCubeFaceMask(const glm::vec3& a_Position, float a_NearPlane, float a_FarPlane, const glm::vec3& a_Center, float a_Radius);
+
+        /*
+         * Move an orthographic light view projection matrix by less than half a texel, so that the world origin falls on a texel corner.
+         * A volume that only moves then always moves by whole texels.
+         */
+        static void SnapToTexels(glm::mat4& a_Matrix, std::uint32_t a_Resolution);
+
+        /*
+         * Create the table of the shader mask bits of this pass. Every vertex attribute and draw attribute has a bit, followed by POSITIONAL and DIRECTIONAL.
+         * Only the position, the matrices and the light type change the shadow shaders, so every other bit is folded out.
+         */
+        static ShaderMaskTable CreateShaderMaskTable();
+
         RenderPassType GetType() override;
 
         void Reset() override;
@@ -75,8 +221,86 @@ namespace blurp
     protected:
 
         bool IsStateValid() override;
+        void PrePrepare() override;
+
+        /*
+         * Sort the geometry if enabled, and calculate the matrices of the positional lights and the cascades of the directional lights.
+         */
+        void Prepare() override;
+
+        /*
+         * Store the indices of the directional or positional lights that the draw data at a_DrawIndex casts a shadow for.
+         */
+        void CollectLights(std::uint32_t a_DrawIndex, bool a_Directional, std::vector<std::int32_t>& a_Output) const;
+
+        /*
+         * Draw the shadow maps of all lights. Called by the backends from Submit, after they set the render state.
+         * Decides which faces and cascades are drawn, skips geometry that casts no shadow into them, and splits the lights of every draw into batches that fit the geometry shader.
+         * Commands are sent through the command list backend of the pipeline and the hooks below.
+         */
+        void DrawShadows();
+
+        /*
+         * Size the light batches by the amount of vertices and components that the geometry shader can output. Called by the backends when they are loaded.
+         */
+        void SetGeometryShaderLimits(int a_MaxVertices, int a_MaxComponents);
+
+        /*
+         * Get the shader variant to draw a_Mesh with for a_Mask. Returns nullptr when it is not ready yet, in which case the geometry is skipped.
+         */
+        virtual std::shared_ptr<Shader> GetShader(std::uint32_t a_Mask, const Mesh& a_Mesh) = 0;
+
+        /*
+         * Draw into the layers of the depth texture a_Texture, with a viewport that covers a whole layer.
+         */
+        virtual void BindDepthTarget(const Texture& a_Texture) = 0;
+
+        /*
+         * Upload a_Size bytes of PosLightData or DirLightData to the light uniform buffer at binding 1.
+         */
+        virtual void UploadLightData(const void* a_Data, std::uint32_t a_Size) = 0;
+
+        /*
+         * Upload a batch of light indices to the uniform buffer at binding 2. a_Count is the amount of integers, which is a multiple of 4.
+         */
+        virtual void UploadLightIndices(const std::int32_t* a_Data, std::uint32_t a_Count) = 0;
+
+        /*
+         * Copy the depth of layer a_Layer of a_Source into the same layer of a_Destination.
+         */
+        virtual void CopyDepthLayer(const Texture& a_Source, const Texture& a_Destination, std::uint32_t a_Layer) = 0;
+
+        /*
+         * Called after a_Size bytes of a_Data were written into a_Buffer, before the written range is bound.
+         */
+        virtual void OnBufferWritten(const GpuBuffer& a_Buffer, const void* a_Data, std::uint32_t a_Size) = 0;
+
+    private:
+        /*
+         * Draw the static and/or dynamic positional casters into a_Texture, in the faces enabled in the face mask of each light.
+         */
+        void DrawPositional(const Texture& a_Texture, bool a_DrawStatic, bool a_DrawDynamic);
+
+        /*
+         * Draw the directional casters into the cascades that are updated this frame.
+         */
+        void DrawDirectional();
+
+        /*
+         * Bind the shader for a_ShaderMask if it changed. Returns false when the geometry has to be skipped because the shader is not ready.
+         */
+        bool BindShader(std::uint32_t a_ShaderMask, const Mesh& a_Mesh);
+
+        /*
+         * Draw a_DrawData once for every batch of at most a_LightsPerCall lights in m_LightList.
+         */
+        void DrawLightBatches(const DrawData& a_DrawData, TopologyType a_Topology, int a_LightsPerCall);
 
     protected:
+        //Bits of the shader mask that select the positional and directional variants. They follow the vertex and draw attributes.
+        static constexpr std::uint32_t POSITIONAL_BIT = 1u << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
+        static constexpr std::uint32_t DIRECTIONAL_BIT = 1u << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS + 1);
+
 
         //Collection of lights with a position.
         std::vector<LightShadowData> m_PositionalLights;
@@ -89,11 +313,54 @@ namespace blurp
         const LightIndexData* m_LightIndices;
         std::uint32_t m_DrawDataCount;
 
+        //Sorts the geometry by state and depth when enabled.
+        bool m_SortDrawData;
+        DrawSorter m_DrawSorter;
+
         //The camera used to determine directional light positions.
         std::shared_ptr<Camera> m_Camera;
 
         //Object containing information about shadow generation.
         ShadowData m_ShadowData;
 
+        //Decides which faces of the positional shadow maps are drawn. Every face is drawn when nullptr.
+        std::shared_ptr<PositionalShadowCache> m_ShadowCache;
+
+        //Decides which cascades are drawn. Every cascade is drawn when nullptr.
+        std::shared_ptr<CascadeScheduler> m_CascadeScheduler;
+        std::uint32_t m_SkippedCascades;
+
+        //Calculated when the pass is prepared. The order to draw the geometry in, or nullptr to keep the submitted order.
+        const std::uint32_t* m_DrawOrder;
+
+        //Calculated when the pass is prepared. The data of every positional light, without the faces to draw.
+        std::vector<PosLightData> m_PosLightData;
+
+        //Calculated when the pass is prepared. The directional lights, the matrices of every cascade, and the cascades that are drawn.
+        DirLightData m_DirLightData;
+        std::vector<DirCascade> m_DirCascades;
+        std::uint32_t m_CascadeUpdateMask;
+
+        //Manifest of the shader variants used by this pass. Changed is set until the shader cache picks up a new manifest.
+        std::shared_ptr<ShaderManifest> m_ShaderManifest;
+        float m_WarmUpBudget;
+        bool m_ShaderManifestChanged;
+
+        //What is drawn while shader variants compile, and how long is spent on starting them each frame.
+        ShaderFallbackPolicy m_ShaderFallbackPolicy;
+        float m_CompileBudget;
+
+    private:
+        //Geometry shader limits that the light batches are sized by.
+        int m_MaxPosLightsPerCall;
+        int m_MaxComponents;
+        int m_MaxTriangles;
+
+        //Used while drawing. The lights of the current geometry, the packed indices of a batch, and the last bound shader and mesh.
+        std::vector<std::int32_t> m_LightList;
+        std::vector<std::int32_t> m_LightIndexBatch;
+        std::uint32_t m_PrevShaderMask;
+        const Shader* m_CurrentShader;
+        const Mesh* m_PrevMesh;
     };
 }
@@ -13,7 +13,7 @@ namespace blurp
     {
     public:
         explicit RenderPass_Skybox(RenderPipeline& a_Pipeline)
-            : RenderPass(a_Pipeline), m_Opacity(1.f), m_MixColor(0.f), m_ColorMultiplier(1.f)
+            : RenderPass(a_Pipeline), m_Opacity(1.f), m_MixColor(0.f), m_ColorMultiplier(1.f), m_ViewProjection(1.f)
         {
         }
 
@@ -57,6 +57,12 @@ namespace blurp
 
     protected:
         bool IsStateValid() override;
+        void PrePrepare() override;
+
+        /*
+         * Calculate the projection-view matrix without the camera translation.
+         */
+        void Prepare() override;
 
     protected:
         std::shared_ptr<Texture> m_Texture;
@@ -69,6 +75,9 @@ namespace blurp
         glm::vec3 m_MixColor;
         glm::vec3 m_ColorMultiplier;
 
+        //Calculated when the pass is prepared.
+        glm::mat4 m_ViewProjection;
+
         //Static cube mesh data that is used to draw the skybox.
         inline  const static std::float_t CUBE_DATA[]
         {
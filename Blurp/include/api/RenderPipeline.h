@@ -7,9 +7,41 @@
 
 namespace blurp
 {
+    class CommandListBackend;
+    class GpuTimer;
+    class JobSystem;
     class RenderPass;
     class ResourceLock;
 
+    /*
+     * How long a render pass took in the last execution of its pipeline. Times are in microseconds.
+     */
+    struct PassTimings
+    {
+        RenderPassType type;
+        bool enabled;
+        double prepareStart;    //When preparing started, relative to the start of the prepare phase.
+        double prepare;         //Time spent in Prepare, on whichever thread it ran.
+        double submit;          //Time spent in Submit.
+    };
+
+    /*
+     * How long each phase of the last execution of a pipeline took. Times are in microseconds.
+     */
+    struct PipelineTimings
+    {
+        PipelineTimings() : prepare(0.0), prepareWork(0.0), criticalPath(0.0), submit(0.0), gpuWait(0.0) {}
+
+        double prepare;         //Time from the start of the prepare phase until every pass was prepared.
+        double prepareWork;     //Time spent in Prepare by all passes together. This is what preparing takes on a single thread.
+        double criticalPath;    //The longest chain of passes that depend on each other. Preparing can never take less than this.
+        double submit;          //Time spent submitting the passes, including PreExecute and PostExecute.
+        double gpuWait;         //Time spent waiting for the GPU when PipelineSettings::waitForGpu is set.
+
+        //The timings of every pass, in the order of the pipeline.
+        std::vector<PassTimings> passes;
+    };
+
     class RenderPipeline : public RenderResource
     {
     public:
@@ -32,9 +64,13 @@ namespace blurp
 
         /*
          * Execute this RenderPipeline.
-         * This consecutively executes each of the render passes.
+         * Jobs that were started with JobSystem::RunOnMainThread are run first when this is called on the main thread.
+         * Every enabled pass is then prepared. Passes are prepared at the same time as jobs of the JobSystem when PipelineSettings::parallelPrepare is set,
+         * except for passes that depend on each other. When every pass is prepared, they are submitted one after another on this thread.
          * If settings.waitForGpu is true, this stalls the GPU until drawing is completed.
          * In that scenario this will automatically release all resource locks upon completion.
+         *
+         * When BLURP_PROFILING is defined, every phase and pass is recorded in the Profiler of the engine, on the GPU as well when the backend supports it.
          */
         void Execute();
 
@@ -52,24 +88,53 @@ namespace blurp
          */
         virtual bool HasFinishedExecuting() = 0;
 
+        /*
+         * Get the backend that the passes in this pipeline replay their command lists with.
+         * Command lists can be recorded on any thread, but may only be replayed while this pipeline executes.
+         */
+        virtual CommandListBackend& GetCommandListBackend() = 0;
+
+        /*
+         * Get how long each phase and pass took in the last execution.
+         */
+        const PipelineTimings& GetTimings() const;
+
+        /*
+         * Get the job system of the engine that this pipeline belongs to. Passes use it to spread their work over multiple threads.
+         */
+        JobSystem& GetJobSystem() const;
+
     protected:
         /*
-         * This is called before Execute is called on the render passes in this pipeline.
+         * This is called before the render passes in this pipeline are prepared and submitted.
          */
         virtual void PreExecute() = 0;
 
         /*
-         * This is called after Execute is called on the render passes in this pipeline.
+         * This is called after the render passes in this pipeline are submitted.
          */
         virtual void PostExecute() = 0;
 
+        /*
+         * Get the timer that measures how long every pass takes on the GPU when profiling is compiled in.
+         * Returns nullptr when the backend can not measure GPU time, in which case only CPU markers are recorded.
+         */
+        virtual GpuTimer* GetGpuTimer();
+
     protected:
         PipelineSettings m_Settings;
         RenderDevice& m_RenderDevice;
         BlurpEngine& m_Engine;
 
+    private:
+        /*
+         * Prepare every enabled pass, on multiple threads when enabled. Returns when every pass is prepared.
+         */
+        void PreparePasses();
+
     private:
         std::vector<std::shared_ptr<RenderPass>> m_RenderPasses;
+        PipelineTimings m_Timings;
     };
 
     template <typename T>
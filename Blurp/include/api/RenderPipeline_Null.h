@@ -0,0 +1,39 @@
+#pragma once
+#include "RenderPipeline.h"
+#include "CommandListBackend_Null.h"
+#include "CommandRecording.h"
+
+namespace blurp
+{
+    /*
+     * RenderPipeline of the headless GraphicsAPI::NONE backend.
+     * The passes in this pipeline do all of their CPU work, but record the commands they would send to a graphics API instead of sending them.
+     * The recording is cleared when the pipeline starts executing, so after Execute it contains the commands of that execution.
+     */
+    class RenderPipeline_Null : public RenderPipeline
+    {
+    public:
+        RenderPipeline_Null(const PipelineSettings& a_Settings, BlurpEngine& a_Engine, RenderDevice& a_Device) : RenderPipeline(a_Settings, a_Engine, a_Device), m_CommandListBackend(m_Recording) {}
+
+        /*
+         * Get the commands recorded by the passes in this pipeline during the last execution.
+         */
+        CommandRecording& GetRecording();
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    public:
+        bool HasFinishedExecuting() override;
+        CommandListBackend& GetCommandListBackend() override;
+
+    protected:
+        void PreExecute() override;
+        void PostExecute() override;
+
+    private:
+        CommandRecording m_Recording;
+        CommandListBackend_Null m_CommandListBackend;
+    };
+}
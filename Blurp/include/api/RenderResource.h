@@ -1,6 +1,8 @@
 #pragma once
 #include "Settings.h"
 
+#include <stdexcept>
+
 namespace blurp
 {
     class RenderDevice;
@@ -32,7 +34,7 @@ namespace blurp
         {
             if(m_Loaded)
             {
-                throw std::exception("Trying to load resource that was already loaded!");
+                throw std::runtime_error("Trying to load resource that was already loaded!");
                 return false;
             }
             m_Loaded = true;
@@ -46,7 +48,7 @@ namespace blurp
         {
             if (!m_Loaded)
             {
-                throw std::exception("Trying to destroy resource that was never loaded!");
+                throw std::runtime_error("Trying to destroy resource that was never loaded!");
                 return false;
             }
             m_Loaded = false;
@@ -0,0 +1,148 @@
+#pragma once
+#include <cinttypes>
+#include <deque>
+
+namespace blurp
+{
+    /*
+     * Interface used by RingBufferAllocator to synchronize with the GPU.
+     * Every graphics backend implements this with its own fence objects.
+     */
+    class RingBufferFence
+    {
+    public:
+        virtual ~RingBufferFence() = default;
+
+        /*
+         * Place a fence after all GPU work that has been submitted so far.
+         * a_FrameId identifies the frame whose memory region is protected by the fence.
+         */
+        virtual void Insert(std::uint64_t a_FrameId) = 0;
+
+        /*
+         * Returns true if the GPU has passed the fence for the given frame.
+         * The fence is released when this returns true.
+         */
+        virtual bool IsComplete(std::uint64_t a_FrameId) = 0;
+
+        /*
+         * Block until the GPU has passed the fence for the given frame, then release the fence.
+         */
+        virtual void Wait(std::uint64_t a_FrameId) = 0;
+    };
+
+    /*
+     * Counters kept by a RingBufferAllocator.
+     */
+    struct RingBufferStats
+    {
+        RingBufferStats() : allocations(0), wraps(0), stalls(0), framesRetired(0) {}
+
+        //The amount of successful allocations.
+        std::uint64_t allocations;
+
+        //The amount of times an allocation had to wrap around to the start of the buffer.
+        std::uint64_t wraps;
+
+        //The amount of times the CPU had to wait for the GPU to finish with a region of memory.
+        std::uint64_t stalls;
+
+        //The amount of frames whose memory was released for reuse.
+        std::uint64_t framesRetired;
+    };
+
+    /*
+     * RingBufferAllocator hands out aligned regions of a buffer of fixed capacity.
+     * Allocations are grouped per frame. When a new frame begins, the region used by the previous frame is fenced.
+     * Memory is only reused after the fence for the frame that used it has been passed.
+     *
+     * The allocator only deals with offsets, so it does not depend on a graphics API.
+     */
+    class RingBufferAllocator
+    {
+    public:
+        /*
+         * Create an allocator for a buffer of a_Capacity bytes.
+         * a_NumFrames is the amount of frames that can use the buffer at the same time, including the frame being written.
+         * The fence object has to stay alive for as long as the allocator does.
+         */
+        RingBufferAllocator(std::uint64_t a_Capacity, std::uint32_t a_NumFrames, RingBufferFence& a_Fence);
+
+        /*
+         * Start a new frame.
+         * The allocations of the previous frame are fenced, and the CPU waits when too many frames are in flight.
+         */
+        void BeginFrame();
+
+        /*
+         * Allocate a_Size bytes with the start aligned to a_Alignment. a_Alignment has to be a power of two.
+         * The offset of the allocation is stored in a_Offset.
+         * Waits for older frames if their memory is required.
+         *
+         * Returns false if the allocation does not fit next to the data of the current frame.
+         */
+        bool Allocate(std::uint64_t a_Size, std::uint64_t a_Alignment, std::uint64_t& a_Offset);
+
+        /*
+         * Wait until the GPU is done with all frames that are in flight.
+         */
+        void WaitIdle();
+
+        /*
+         * Change the capacity of the buffer. No frames can be in flight when this is called.
+         * Allocations made in the current frame keep their offsets, so the data has to be copied over by the caller.
+         */
+        void Resize(std::uint64_t a_Capacity);
+
+        /*
+         * Get the capacity in bytes.
+         */
+        std::uint64_t GetCapacity() const;
+
+        /*
+         * Get the amount of frames that have been fenced but not yet released.
+         */
+        std::uint32_t GetFramesInFlight() const;
+
+        /*
+         * Get the ID of the current frame.
+         */
+        std::uint64_t GetFrameId() const;
+
+        /*
+         * Get the counters for this allocator.
+         */
+        const RingBufferStats& GetStats() const;
+
+    private:
+        //Release frames that the GPU has finished with.
+        void RetireCompleted();
+
+        //Wait for the oldest frame in flight and release its memory.
+        void RetireOldest();
+
+    private:
+        //Memory region used by a frame that is still in use by the GPU.
+        struct FrameRegion
+        {
+            std::uint64_t frameId;
+            std::uint64_t start;
+            std::uint64_t end;
+        };
+
+        RingBufferFence& m_Fence;
+        std::uint64_t m_Capacity;
+        std::uint32_t m_NumFrames;
+
+        //Position where the next allocation is placed, and where the current frame started.
+        std::uint64_t m_Head;
+        std::uint64_t m_FrameStart;
+        std::uint64_t m_FrameId;
+        std::uint32_t m_FrameAllocations;
+
+        //Oldest frame at the front.
+        std::deque<FrameRegion> m_InFlight;
+
+        RingBufferStats m_Stats;
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include "Data.h"
 
+#include <stdexcept>
+
 /*
  * This file contains all structs used to describe a resource before creation.
  * These settings objects are passed to the render device to create the appropriate resources.
@@ -260,6 +262,9 @@ namespace blurp
             //Default settings.
             graphicsAPI = GraphicsAPI::OPENGL;
             shadersPath = "/shaders/";
+            maxShaderPrograms = 0;
+            jobWorkers = -1;
+            profilerFrames = 120;
         }
 
         //Settings for the window. To not create a window, set type to NONE.
@@ -270,6 +275,21 @@ namespace blurp
 
         //Path to the shaders directory.
         std::string shadersPath;
+
+        //Directory in which compiled shader programs are stored, so that they do not have to be compiled again in the next run.
+        //Leave empty to always compile shaders from source.
+        std::string shaderBinaryCachePath;
+
+        //The maximum amount of shader programs that are kept loaded for all render passes together. Programs that were used the longest ago are removed first.
+        //0 means there is no limit.
+        std::uint32_t maxShaderPrograms;
+
+        //The amount of worker threads of the JobSystem, besides the thread that initializes the engine.
+        //Negative uses one worker for every hardware thread except the calling thread.
+        std::int32_t jobWorkers;
+
+        //The amount of frames that the Profiler keeps markers for. Only used when BLURP_PROFILING is defined.
+        std::uint32_t profilerFrames;
     };
 
     struct VertexSettings
@@ -343,7 +363,7 @@ namespace blurp
             {
                 return found->second;
             }
-            throw std::exception("Fatal error: This should never happen. Were more vertex attributes added but not to VERTEX_ATTRIBUTE_INFO?");
+            throw std::runtime_error("Fatal error: This should never happen. Were more vertex attributes added but not to VERTEX_ATTRIBUTE_INFO?");
         }
 
     private:
@@ -838,6 +858,7 @@ namespace blurp
             computeShaderSource = nullptr;
 
             type = ShaderType::GRAPHICS;
+            compileAsynchronously = false;
         }
 
         //Raw pointers to each shader stage. Nullptr if not used.
@@ -855,6 +876,10 @@ namespace blurp
 
         //The type of shader
         ShaderType type;
+
+        //Let the driver compile the shader in the background when it can. Shader::IsReady returns false until it is done.
+        //Without driver support the shader is compiled right away.
+        bool compileAsynchronously;
     };
 
     /*
@@ -865,6 +890,7 @@ namespace blurp
         PipelineSettings()
         {
             waitForGpu = true;
+            parallelPrepare = true;
         }
 
         /*
@@ -872,6 +898,12 @@ namespace blurp
          * Once execution has finished, all locked resources are automatically freed.
          */
         bool waitForGpu;
+
+        /*
+         * When true, the passes of a pipeline are prepared on multiple threads at the same time, except for passes that depend on each other.
+         * When false, every pass is prepared on the thread that executes the pipeline.
+         */
+        bool parallelPrepare;
     };
 
     /*
@@ -885,6 +917,8 @@ namespace blurp
             resizeWhenFull = false;
             memoryUsage = MemoryUsage::CPU_W;
             access = AccessMode::READ_WRITE;
+            persistentRingBuffer = false;
+            ringBufferFrames = 3;
         }
 
         /*
@@ -911,5 +945,19 @@ namespace blurp
          * Otherwise choose READ_WRITE.
          */
         AccessMode access;
+
+        /*
+         * If true, the buffer is persistently mapped and used as a ring buffer shared by multiple frames.
+         * Writes ignore the offset passed to them and are sub-allocated from the ring instead.
+         * GpuBuffer::BeginFrame() has to be called once at the start of every frame so that old regions can be reused.
+         * Size is the capacity of the entire ring, so it has to fit ringBufferFrames frames worth of data.
+         */
+        bool persistentRingBuffer;
+
+        /*
+         * The amount of frames that can use a persistent ring buffer at the same time, including the frame being written.
+         * The CPU waits for the GPU when more frames than this are in flight.
+         */
+        std::uint32_t ringBufferFrames;
     };
 }
\ No newline at end of file
@@ -16,6 +16,40 @@ namespace blurp
             return m_Settings.type;
         }
 
+        /*
+         * Returns true when the shader can be used.
+         * Shaders created with ShaderSettings::compileAsynchronously may still be compiling when they are created.
+         */
+        virtual bool IsReady()
+        {
+            return true;
+        }
+
+        /*
+         * Returns true while the settings still point to the source of a shader stage.
+         * Every stage is handed to the graphics API while the shader is loaded, after which the source pointers are released.
+         * The memory of the source can be reused as soon as this returns false, even when the shader is still compiling in the background.
+         */
+        bool HasSources() const
+        {
+            return m_Settings.vertexShaderSource != nullptr || m_Settings.tessellationHullShaderSource != nullptr || m_Settings.tessellationDomainShaderSource != nullptr
+                || m_Settings.geometryShaderSource != nullptr || m_Settings.fragmentShaderSource != nullptr || m_Settings.computeShaderSource != nullptr;
+        }
+
+    protected:
+        /*
+         * Forget the source of every stage. Called by the backends at the end of OnLoad, because the pointers are only valid while the shader is created.
+         */
+        void ReleaseSources()
+        {
+            m_Settings.vertexShaderSource = nullptr;
+            m_Settings.tessellationHullShaderSource = nullptr;
+            m_Settings.tessellationDomainShaderSource = nullptr;
+            m_Settings.geometryShaderSource = nullptr;
+            m_Settings.fragmentShaderSource = nullptr;
+            m_Settings.computeShaderSource = nullptr;
+        }
+
     protected:
         ShaderSettings m_Settings;
     };
@@ -0,0 +1,156 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Settings.h"
+
+namespace blurp
+{
+    /*
+     * Interface between a ShaderBinaryCache and the graphics API that creates the program.
+     * Implemented by the shader of each graphics API, or by a fake backend to test the cache without a GPU.
+     */
+    class ShaderBinaryBackend
+    {
+    public:
+        virtual ~ShaderBinaryBackend() = default;
+
+        /*
+         * Create the program from a binary that was returned by Compile in an earlier run.
+         * Returns false when the driver does not accept the binary. The backend has to be ready for a call to Compile afterwards.
+         */
+        virtual bool LoadBinary(std::uint32_t a_Format, const std::vector<char>& a_Data) = 0;
+
+        /*
+         * Create the program from source. The binary of the program is written to a_Format and a_Data.
+         * Returns false when compiling failed. a_Data is left empty when the driver can not provide a binary.
+         */
+        virtual bool Compile(std::uint32_t& a_Format, std::vector<char>& a_Data) = 0;
+    };
+
+    /*
+     * Counters of a ShaderBinaryCache. These are not cleared.
+     */
+    struct ShaderBinaryCacheStats
+    {
+        ShaderBinaryCacheStats() : loaded(0), hits(0), misses(0), rejected(0), stored(0), writeFailures(0) {}
+
+        //The amount of entries found when the cache was opened.
+        std::uint32_t loaded;
+
+        //The amount of programs created from a binary, and the amount that had no binary and were compiled.
+        std::uint32_t hits;
+        std::uint32_t misses;
+
+        //The amount of binaries that were dropped because the file was damaged or the driver did not accept them. These were compiled instead.
+        std::uint32_t rejected;
+
+        //The amount of binaries written to disk, and the amount that could not be written.
+        std::uint32_t stored;
+        std::uint32_t writeFailures;
+    };
+
+    /*
+     * ShaderBinaryCache keeps the binaries of linked shader programs on disk, so that they do not have to be compiled again in the next run.
+     *
+     * Every binary is stored in its own file in the cache directory, named after its key.
+     * The key is a hash of the shader stages without comments and whitespace, the preprocessor definitions (which hold the mask of a ShaderCache),
+     * the shader type and the driver. Changing a shader or updating the driver gives new keys, so old binaries are never used for the wrong program.
+     *
+     * Open reads the header of every file to build the index. Files that are damaged or belong to another driver are deleted.
+     * Files are written to a temporary file first and then renamed, so that a crash can never leave a half written binary behind.
+     *
+     * The cache only stores bytes. Creating programs is done by a ShaderBinaryBackend, see LoadOrCompile.
+     */
+    class ShaderBinaryCache
+    {
+    public:
+        ShaderBinaryCache();
+
+        /*
+         * Open the cache in a directory, which is created if it does not exist.
+         * a_DriverId identifies the driver that the binaries are made by. Binaries of other drivers are deleted.
+         * Returns false if the directory could not be created.
+         */
+        bool Open(const std::string& a_Directory, const std::string& a_DriverId);
+
+        /*
+         * Returns true when Open succeeded.
+         */
+        bool IsOpen() const;
+
+        /*
+         * Create the program for a_Settings with a_Backend.
+         * The stored binary is tried first. When there is none, or the backend does not accept it, the program is compiled and its binary is stored.
+         * Returns false if the program could not be compiled.
+         */
+        bool LoadOrCompile(const ShaderSettings& a_Settings, ShaderBinaryBackend& a_Backend);
+
+        /*
+         * Get the key of the program for a_Settings when made by the driver this cache was opened with.
+         */
+        std::uint64_t GetKey(const ShaderSettings& a_Settings) const;
+
+        /*
+         * Returns true if a binary is stored for the key.
+         */
+        bool Contains(std::uint64_t a_Key) const;
+
+        /*
+         * Read the binary for a key. Returns false if there is none, or if the file is damaged. Damaged files are removed.
+         */
+        bool Find(std::uint64_t a_Key, std::uint32_t& a_Format, std::vector<char>& a_Data);
+
+        /*
+         * Write the binary for a key, replacing the one that is stored. Returns false if the file could not be written.
+         */
+        bool Store(std::uint64_t a_Key, std::uint32_t a_Format, const std::vector<char>& a_Data);
+
+        /*
+         * Remove the binary for a key.
+         */
+        void Remove(std::uint64_t a_Key);
+
+        /*
+         * Get the amount of binaries stored.
+         */
+        std::size_t GetEntryCount() const;
+
+        /*
+         * Get the counters of this cache.
+         */
+        const ShaderBinaryCacheStats& GetStats() const;
+
+        /*
+         * Calculate the key of the program for a_Settings when made by the driver with the given id.
+         */
+        static std::uint64_t CalculateKey(const ShaderSettings& a_Settings, const std::string& a_DriverId);
+
+        /*
+         * Remove comments, empty lines and repeated whitespace from shader source.
+         * Lines are kept so that preprocessor directives stay intact.
+         */
+        static std::string StripSource(const char* a_Source);
+
+    private:
+        //What is known about a file without reading its binary.
+        struct Entry
+        {
+            std::uint32_t format;
+            std::uint64_t size;
+            std::uint64_t checksum;
+        };
+
+        std::string GetPath(std::uint64_t a_Key) const;
+
+    private:
+        std::string m_Directory;
+        std::string m_DriverId;
+        std::uint64_t m_DriverHash;
+        std::unordered_map<std::uint64_t, Entry> m_Index;
+        ShaderBinaryCacheStats m_Stats;
+        bool m_Open;
+    };
+}
@@ -3,6 +3,13 @@
 #include "Shader.h"
 #include "FileReader.h"
 #include "RenderResourceManager.h"
+#include "ShaderCompileQueue.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderManifest.h"
+#include "ShaderMaskTable.h"
+#include "ShaderPreprocessor.h"
+#include "ShaderRegistry.h"
+#include <chrono>
 #include <iostream>
 
 namespace blurp
@@ -14,6 +21,10 @@ namespace blurp
      *
      * T is the mask type. This has to be an integer or enumeration type.
      * INTERNAL_FORMAT is what the mask will be stored as. This 
+     *
+     * Compiled shaders are stored in the ShaderRegistry of the engine, so caches for the same shader in different passes share them.
+     * When preprocessing is enabled, the definitions are resolved on the CPU before compiling. Variants that end up with the same source use the same program.
+     * When a ShaderMaskTable is set, bits that the shader does not use are removed from every mask before it is looked up, see SetMaskTable.
      */
     template<typename T, typename INTERNAL_FORMAT>
     class ShaderCache
@@ -22,20 +33,31 @@ namespace blurp
         //TODO use conditional to only enable underlying type when is_enum is true. Disabled for now because dark magic is at hand with these templates.
         ///* && std::is_convertible_v<std::underlying_type_t<T>, INTERNAL_FORMAT>) */
         static_assert((std::is_same_v<T, INTERNAL_FORMAT> || std::is_convertible_v<T, INTERNAL_FORMAT> || std::is_enum_v<T>) && std::is_integral_v<INTERNAL_FORMAT>, "T has to be convertible to the internal format provided which has to be interpretable as an integer.");
+        static_assert(sizeof(INTERNAL_FORMAT) <= sizeof(std::uint64_t), "The shader registry stores masks of at most 64 bits.");
 
     public:
         ShaderCache();
+        ~ShaderCache();
+
+        //The cache holds a reference in the registry, so it can not be copied.
+        ShaderCache(const ShaderCache&) = delete;
+        ShaderCache& operator=(const ShaderCache&) = delete;
 
         /*
-         * Initialize this shader registry.
-         * This stores a reference to the resource manager that will be used to construct the shaders.
+         * Initialize this shader cache.
+         * This stores a reference to the resource manager of the engine that will be used to construct the shaders, and to the shader registry they are stored in.
          * The ShaderSettings object contains all settings that the shaders loaded in this cache will adhere to.
          * Definitions is an array of strings that correspond to preprocessor definitions in the shader.
          * The slot in which each string is stored corresponds to the bit in the bitmask that will enable that definition.
          *
          * Note: The shader settings object provided should contain the raw source of the shader.
          */
-        void Init(RenderResourceManager& a_ResourceManager,const ShaderSettings& a_Settings, const std::vector<std::string>& a_Definitions);
+        void Init(BlurpEngine& a_BlurpEngine, const ShaderSettings& a_Settings, const std::vector<std::string>& a_Definitions);
+
+        /*
+         * Initialize this shader cache with the definitions of a_Table, and fold the bits that a_Table does not use out of every mask.
+         */
+        void Init(BlurpEngine& a_BlurpEngine, const ShaderSettings& a_Settings, const ShaderMaskTable& a_Table);
 
         /* 
          * Get the shader with the given bit mask.
@@ -44,10 +66,20 @@ namespace blurp
         std::shared_ptr<Shader> GetOrLoad(T a_Mask);
 
         /*
-         * Get the shader with the given mask.
+         * Get the shader with the given mask and additional defines.
          * If no shader could be found, returns an empty shared pointer.
          */
-        std::shared_ptr<Shader> GetOrNull(T a_Mask) const;
+        std::shared_ptr<Shader> GetOrNull(T a_Mask, const std::vector<std::string>& a_AdditionalDefines = std::vector<std::string>());
+
+        /*
+         * Returns true if the shader with the given mask and additional defines is loaded. This does not count as a use in the registry.
+         */
+        bool Contains(T a_Mask, const std::vector<std::string>& a_AdditionalDefines = std::vector<std::string>());
+
+        /*
+         * Get the mask that is used to store the shader for a_Mask. This is a_Mask without the bits that the mask table does not use.
+         */
+        INTERNAL_FORMAT Canonicalize(T a_Mask) const;
 
         /*
          * Load the shader for each mask in the provided array.
@@ -61,15 +93,95 @@ namespace blurp
          */
         std::shared_ptr<Shader> LoadShader(T a_Mask, const std::vector<std::string>& a_AdditionalDefines = std::vector<std::string>());
 
+        /*
+         * Set what GetOrRequest does when a shader is not loaded yet. Bits set in a_ExactBits can not differ between the requested shader and the one used in its place.
+         * With BLOCK, which is the default, shaders are loaded right away. Otherwise they are compiled by UpdateCompiles.
+         */
+        void SetFallbackPolicy(ShaderFallbackPolicy a_Policy, INTERNAL_FORMAT a_ExactBits);
+
+        /*
+         * Get the shader with the given mask.
+         * If it is not loaded, it is loaded right away or queued to be compiled in the background, depending on the fallback policy.
+         * While it is compiling another shader may be returned in its place, or nullptr when the draw should be skipped.
+         */
+        std::shared_ptr<Shader> GetOrRequest(T a_Mask, const std::vector<std::string>& a_AdditionalDefines = std::vector<std::string>());
+
+        /*
+         * Start compiling queued shaders until a_BudgetMilliseconds have passed, and add the shaders that finished to the registry.
+         * Call once per frame. Returns the amount of shaders that are queued or compiling.
+         */
+        std::size_t UpdateCompiles(float a_BudgetMilliseconds);
+
+        /*
+         * Get the queue of shaders that are compiled in the background.
+         */
+        const ShaderCompileQueue& GetCompileQueue() const;
+
+        /*
+         * Resolve the preprocessor definitions of every shader loaded from now on with a ShaderPreprocessor, which removes the code they disable.
+         * a_IncludeDirectory is where #include looks for files. Shaders that can not be processed are compiled as they are.
+         * This is disabled by default.
+         */
+        void SetPreprocessing(bool a_Enabled, const std::string& a_IncludeDirectory = std::string());
+
+        /*
+         * Get the counters of the preprocessor.
+         */
+        const ShaderPreprocessorStats& GetPreprocessorStats() const;
+
+        /*
+         * Record every shader loaded from now on in a_Manifest under the name a_Pass, together with its compile time.
+         * The variants that a_Manifest already holds for a_Pass are queued to be loaded by WarmUp.
+         * Pass nullptr to stop recording and clear the queue.
+         */
+        void SetManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, const std::string& a_Pass);
+
+        /*
+         * Load queued variants from the manifest until a_BudgetMilliseconds have passed. Everything is loaded when the budget is 0 or less.
+         * The shader that passes the budget is always finished. Variants that were loaded in another way are skipped.
+         * Returns the amount of variants that are still queued.
+         */
+        std::size_t WarmUp(float a_BudgetMilliseconds);
+
+    private:
+        /*
+         * Fold the unused bits out of a_Mask, and return a_AdditionalDefines without the locations of unused attributes.
+         * The returned definitions stay valid until the next call.
+         */
+        const std::vector<std::string>& CanonicalizeVariant(INTERNAL_FORMAT& a_Mask, const std::vector<std::string>& a_AdditionalDefines);
+
+        /*
+         * Load and store the shader for a canonical mask and its additional defines.
+         */
+        std::shared_ptr<Shader> LoadVariant(INTERNAL_FORMAT a_Mask, const std::vector<std::string>& a_AdditionalDefines);
+
+        /*
+         * Create the shader for a mask with the additional defines.
+         */
+        std::shared_ptr<Shader> CreateVariant(INTERNAL_FORMAT a_Mask, const std::vector<std::string>& a_AdditionalDefines, bool a_Asynchronous);
+
+        /*
+         * Add a loaded shader to the registry and record it in the manifest.
+         */
+        void StoreVariant(INTERNAL_FORMAT a_Mask, const std::vector<std::string>& a_AdditionalDefines, const std::shared_ptr<Shader>& a_Shader, float a_CompileMilliseconds);
+
     private:
         RenderResourceManager* m_ResourceManager;
         ShaderSettings m_Settings;
-        std::unordered_map<INTERNAL_FORMAT, std::shared_ptr<Shader>> m_ShaderRegistry;
+
+        //Registry shared by all caches of the engine, and the id of the source of this cache in it.
+        std::shared_ptr<ShaderRegistry> m_Registry;
+        std::uint64_t m_SourceId;
 
         //Preprocessor definition matching with each bit at the same index.
         std::vector<std::string> m_PreProcessorDefinitions;
         std::uint32_t m_BasePreprocessorCount;
 
+        //The bits that the shader uses, and the additional defines that are left for the current variant.
+        bool m_HasMaskTable;
+        ShaderMaskTable m_MaskTable;
+        std::vector<std::string> m_FilteredDefinitions;
+
         //Raw shader source before compilation.
         std::string m_VertexSource;
         std::string m_FragmentSource;
@@ -77,16 +189,43 @@ namespace blurp
         std::string m_TessellationControlSource;
         std::string m_TessellationEvaluationSource;
 
+        //Manifest that loaded shaders are recorded in, and the variants from it that still have to be loaded.
+        std::shared_ptr<ShaderManifest> m_Manifest;
+        std::string m_ManifestPass;
+        std::vector<ShaderManifestEntry> m_WarmUpQueue;
+        std::size_t m_WarmUpNext;
+
+        //Shaders compiled in the background, and what is used while they compile.
+        ShaderCompileQueue m_CompileQueue;
+        ShaderFallbackPolicy m_FallbackPolicy;
+        INTERNAL_FORMAT m_ExactBits;
+        std::vector<std::uint64_t> m_AvailableMasks;
+
+        //Resolves definitions before compiling, and the processed source of each stage.
+        //The processed source is reused by the next variant, which is safe because shaders release their source before CreateShader returns.
+        bool m_Preprocess;
+        ShaderPreprocessor m_Preprocessor;
+        std::string m_ProcessedSources[5];
+
         bool m_Init;
     };
 
     template <typename T, typename INTERNAL_FORMAT>
-    ShaderCache<T, INTERNAL_FORMAT>::ShaderCache() : m_ResourceManager(nullptr), m_BasePreprocessorCount(0), m_Init(false)
+    ShaderCache<T, INTERNAL_FORMAT>::ShaderCache() : m_ResourceManager(nullptr), m_SourceId(0), m_BasePreprocessorCount(0), m_HasMaskTable(false), m_WarmUpNext(0), m_FallbackPolicy(ShaderFallbackPolicy::BLOCK), m_ExactBits(0), m_Preprocess(false), m_Init(false)
     { 
     }
 
     template <typename T, typename INTERNAL_FORMAT>
-    void ShaderCache<T, INTERNAL_FORMAT>::Init(RenderResourceManager& a_ResourceManager,
+    ShaderCache<T, INTERNAL_FORMAT>::~ShaderCache()
+    {
+        if (m_Registry != nullptr)
+        {
+            m_Registry->RemoveReference(m_SourceId);
+        }
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::Init(BlurpEngine& a_BlurpEngine,
         const ShaderSettings& a_Settings, const std::vector<std::string>& a_Definitions)
     {
         //Ensure that the amount of definitions can fit in the specified bit mask size.
@@ -94,7 +233,7 @@ namespace blurp
         assert(a_Definitions.size() <= (sizeof(INTERNAL_FORMAT) * 8) && "Bitmask data type does not have enough bits to hold the specified amount of preprocessor definitions!");
 
         //Store the resource manager instance.
-        m_ResourceManager = &a_ResourceManager;
+        m_ResourceManager = &a_BlurpEngine.GetResourceManager();
 
         //Store the shader settings in the local settings object.
         m_Settings = a_Settings;
@@ -137,34 +276,85 @@ namespace blurp
         //How many preprocessor definitions are present by default.
         m_BasePreprocessorCount = static_cast<std::uint32_t>(a_Settings.preprocessorDefinitions.size());
 
+        //Reference the source in the registry. Initializing again moves the reference to the new source.
+        if (m_Registry != nullptr)
+        {
+            m_Registry->RemoveReference(m_SourceId);
+        }
+        m_Registry = a_BlurpEngine.GetShaderRegistry();
+        m_SourceId = ShaderRegistry::CalculateSourceId(m_Settings, m_PreProcessorDefinitions);
+        m_Registry->AddReference(m_SourceId);
+
+        //Masks are used as they are until a mask table is set.
+        m_HasMaskTable = false;
+
         //Set the class to initialized.
         m_Init = true;
     }
 
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::Init(BlurpEngine& a_BlurpEngine,
+        const ShaderSettings& a_Settings, const ShaderMaskTable& a_Table)
+    {
+        Init(a_BlurpEngine, a_Settings, a_Table.GetDefinitions());
+        m_MaskTable = a_Table;
+        m_HasMaskTable = true;
+    }
+
     template <typename T, typename INTERNAL_FORMAT>
     std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::GetOrLoad(T a_Mask)
     {
         assert(m_Init);
-        INTERNAL_FORMAT asInternalFormat = static_cast<INTERNAL_FORMAT>(a_Mask);
-        const auto found = m_ShaderRegistry.find(asInternalFormat);
-        if (found == m_ShaderRegistry.end())
+        auto shader = GetOrNull(a_Mask);
+        if (shader == nullptr)
         {
             return LoadShader(a_Mask);
         }
-        return found->second;
+        return shader;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::GetOrNull(T a_Mask, const std::vector<std::string>& a_AdditionalDefines)
+    {
+        assert(m_Init);
+        INTERNAL_FORMAT asInternalFormat = static_cast<INTERNAL_FORMAT>(a_Mask);
+        const auto& defines = CanonicalizeVariant(asInternalFormat, a_AdditionalDefines);
+        return m_Registry->Find(m_SourceId, static_cast<std::uint64_t>(asInternalFormat), ShaderRegistry::CalculateDefinitionsId(defines));
     }
 
     template <typename T, typename INTERNAL_FORMAT>
-    std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::GetOrNull(T a_Mask) const
+    bool ShaderCache<T, INTERNAL_FORMAT>::Contains(T a_Mask, const std::vector<std::string>& a_AdditionalDefines)
     {
         assert(m_Init);
         INTERNAL_FORMAT asInternalFormat = static_cast<INTERNAL_FORMAT>(a_Mask);
-        const auto found = m_ShaderRegistry.find(asInternalFormat);
-        if (found == m_ShaderRegistry.end())
+        const auto& defines = CanonicalizeVariant(asInternalFormat, a_AdditionalDefines);
+        return m_Registry->Contains(m_SourceId, static_cast<std::uint64_t>(asInternalFormat), ShaderRegistry::CalculateDefinitionsId(defines));
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    INTERNAL_FORMAT ShaderCache<T, INTERNAL_FORMAT>::Canonicalize(T a_Mask) const
+    {
+        INTERNAL_FORMAT asInternalFormat = static_cast<INTERNAL_FORMAT>(a_Mask);
+        return m_HasMaskTable ? static_cast<INTERNAL_FORMAT>(m_MaskTable.Canonicalize(static_cast<std::uint64_t>(asInternalFormat))) : asInternalFormat;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    const std::vector<std::string>& ShaderCache<T, INTERNAL_FORMAT>::CanonicalizeVariant(INTERNAL_FORMAT& a_Mask,
+        const std::vector<std::string>& a_AdditionalDefines)
+    {
+        if (!m_HasMaskTable)
         {
-            return nullptr;
+            return a_AdditionalDefines;
         }
-        return found->second;
+
+        a_Mask = static_cast<INTERNAL_FORMAT>(m_MaskTable.Canonicalize(static_cast<std::uint64_t>(a_Mask)));
+
+        //Filtering the definitions that were returned by the last call would read and write the same vector.
+        if (&a_AdditionalDefines != &m_FilteredDefinitions)
+        {
+            m_MaskTable.FilterDefinitions(a_AdditionalDefines, m_FilteredDefinitions);
+        }
+        return m_FilteredDefinitions;
     }
 
     template <typename T, typename INTERNAL_FORMAT>
@@ -173,9 +363,7 @@ namespace blurp
         assert(m_Init);
         for (auto& mask : a_Masks)
         {
-            INTERNAL_FORMAT asInternalFormat = static_cast<INTERNAL_FORMAT>(mask);
-            const auto found = m_ShaderRegistry.find(asInternalFormat);
-            if (found == m_ShaderRegistry.end())
+            if (!Contains(mask))
             {
                 LoadShader(mask);
             }
@@ -188,7 +376,106 @@ namespace blurp
     {
         assert(m_Init);
         auto internalFormatMask = static_cast<INTERNAL_FORMAT>(a_Mask);
+        const auto& defines = CanonicalizeVariant(internalFormatMask, a_AdditionalDefines);
+        return LoadVariant(internalFormatMask, defines);
+    }
 
+    template <typename T, typename INTERNAL_FORMAT>
+    std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::LoadVariant(INTERNAL_FORMAT a_Mask,
+        const std::vector<std::string>& a_AdditionalDefines)
+    {
+        //Load the shader and add to the registry.
+        const auto start = std::chrono::high_resolution_clock::now();
+        auto shader = CreateVariant(a_Mask, a_AdditionalDefines, false);
+        const std::chrono::duration<float, std::milli> compileTime = std::chrono::high_resolution_clock::now() - start;
+        StoreVariant(a_Mask, a_AdditionalDefines, shader, compileTime.count());
+
+        return shader;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::SetFallbackPolicy(ShaderFallbackPolicy a_Policy, INTERNAL_FORMAT a_ExactBits)
+    {
+        m_FallbackPolicy = a_Policy;
+        m_ExactBits = a_ExactBits;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::GetOrRequest(T a_Mask,
+        const std::vector<std::string>& a_AdditionalDefines)
+    {
+        assert(m_Init);
+        INTERNAL_FORMAT internalFormatMask = static_cast<INTERNAL_FORMAT>(a_Mask);
+        const auto& defines = CanonicalizeVariant(internalFormatMask, a_AdditionalDefines);
+        const std::uint64_t mask = static_cast<std::uint64_t>(internalFormatMask);
+        const std::uint64_t definitionsId = ShaderRegistry::CalculateDefinitionsId(defines);
+
+        auto shader = m_Registry->Find(m_SourceId, mask, definitionsId);
+        if (shader != nullptr)
+        {
+            return shader;
+        }
+
+        if (m_FallbackPolicy == ShaderFallbackPolicy::BLOCK)
+        {
+            return LoadVariant(internalFormatMask, defines);
+        }
+
+        m_CompileQueue.Request(mask, defines, definitionsId);
+
+        //Use the closest shader that is loaded until the requested one is done. It has to have the same attribute locations.
+        m_AvailableMasks.clear();
+        m_Registry->GetMasks(m_SourceId, m_AvailableMasks, definitionsId);
+
+        std::uint64_t fallback = 0;
+        const bool found = ShaderCompileQueue::SelectFallback(mask, m_AvailableMasks, static_cast<std::uint64_t>(m_ExactBits), m_FallbackPolicy, fallback);
+        m_CompileQueue.CountFallback(found);
+
+        return found ? m_Registry->Find(m_SourceId, fallback, definitionsId) : nullptr;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    std::size_t ShaderCache<T, INTERNAL_FORMAT>::UpdateCompiles(float a_BudgetMilliseconds)
+    {
+        assert(m_Init);
+        return m_CompileQueue.Update(a_BudgetMilliseconds,
+            [this](const ShaderCompileJob& a_Job)
+            {
+                return CreateVariant(static_cast<INTERNAL_FORMAT>(a_Job.mask), a_Job.definitions, true);
+            },
+            [](Shader& a_Shader)
+            {
+                return a_Shader.IsReady();
+            },
+            [this](const ShaderCompileJob& a_Job, float a_CompileMilliseconds)
+            {
+                StoreVariant(static_cast<INTERNAL_FORMAT>(a_Job.mask), a_Job.definitions, a_Job.shader, a_CompileMilliseconds);
+            });
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    const ShaderCompileQueue& ShaderCache<T, INTERNAL_FORMAT>::GetCompileQueue() const
+    {
+        return m_CompileQueue;
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::SetPreprocessing(bool a_Enabled, const std::string& a_IncludeDirectory)
+    {
+        m_Preprocess = a_Enabled;
+        m_Preprocessor.SetIncludeDirectory(a_IncludeDirectory);
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    const ShaderPreprocessorStats& ShaderCache<T, INTERNAL_FORMAT>::GetPreprocessorStats() const
+    {
+        return m_Preprocessor.GetStats();
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    std::shared_ptr<Shader> ShaderCache<T, INTERNAL_FORMAT>::CreateVariant(INTERNAL_FORMAT a_Mask,
+        const std::vector<std::string>& a_AdditionalDefines, bool a_Asynchronous)
+    {
         //Only keep the basic preprocessor definitions that are always present.
         if (m_Settings.preprocessorDefinitions.size() != m_BasePreprocessorCount)
         {
@@ -198,7 +485,7 @@ namespace blurp
         for (int i = 0; i < static_cast<int>(m_PreProcessorDefinitions.size()); ++i)
         {
             //If the mask has the bit at index i set, enable that preprocessor definition in the shader.
-            if (internalFormatMask & (static_cast<INTERNAL_FORMAT>(1) << i))
+            if (a_Mask & (static_cast<INTERNAL_FORMAT>(1) << i))
             {
                 m_Settings.preprocessorDefinitions.emplace_back(m_PreProcessorDefinitions[i]);
             }
@@ -210,10 +497,95 @@ namespace blurp
             m_Settings.preprocessorDefinitions.insert(m_Settings.preprocessorDefinitions.end(), a_AdditionalDefines.begin(), a_AdditionalDefines.end());
         }
 
-        //Load the shader and add to the registry.
-        auto shader = m_ResourceManager->CreateShader(m_Settings);
-        m_ShaderRegistry.insert({ a_Mask, shader });
+        m_Settings.compileAsynchronously = a_Asynchronous;
 
-        return shader;
+        //Resolve the definitions on the CPU. Variants that end up with the same source share one program.
+        if (m_Preprocess)
+        {
+            ShaderSettings processed = m_Settings;
+            processed.preprocessorDefinitions.clear();
+
+            const char** sources[] = { &processed.vertexShaderSource, &processed.fragmentShaderSource, &processed.geometryShaderSource,
+                &processed.tessellationHullShaderSource, &processed.tessellationDomainShaderSource };
+
+            bool success = true;
+            for (int i = 0; success && i < 5; ++i)
+            {
+                if (*sources[i] != nullptr)
+                {
+                    success = m_Preprocessor.Process(*sources[i], m_Settings.preprocessorDefinitions, m_ProcessedSources[i]);
+                    *sources[i] = m_ProcessedSources[i].c_str();
+                }
+            }
+
+            if (success)
+            {
+                const std::uint64_t hash = ShaderBinaryCache::CalculateKey(processed, std::string());
+                auto shader = m_Registry->FindShared(hash);
+                if (shader == nullptr)
+                {
+                    shader = m_ResourceManager->CreateShader(processed);
+                    assert(!shader->HasSources() && "Shaders have to be done with their source when they are created, because the processed source is overwritten by the next variant!");
+                    m_Registry->Share(hash, shader);
+                }
+                return shader;
+            }
+
+            std::cout << "Could not preprocess shader, compiling it as it is: " << m_Preprocessor.GetError() << std::endl;
+        }
+
+        return m_ResourceManager->CreateShader(m_Settings);
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::StoreVariant(INTERNAL_FORMAT a_Mask,
+        const std::vector<std::string>& a_AdditionalDefines, const std::shared_ptr<Shader>& a_Shader, float a_CompileMilliseconds)
+    {
+        m_Registry->Insert(m_SourceId, static_cast<std::uint64_t>(a_Mask), a_Shader, ShaderRegistry::CalculateDefinitionsId(a_AdditionalDefines));
+
+        if (m_Manifest != nullptr)
+        {
+            m_Manifest->Record(m_ManifestPass, static_cast<std::uint64_t>(a_Mask), a_AdditionalDefines, a_CompileMilliseconds);
+        }
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    void ShaderCache<T, INTERNAL_FORMAT>::SetManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, const std::string& a_Pass)
+    {
+        m_Manifest = a_Manifest;
+        m_ManifestPass = a_Pass;
+        m_WarmUpQueue.clear();
+        m_WarmUpNext = 0;
+
+        if (m_Manifest != nullptr)
+        {
+            m_WarmUpQueue = m_Manifest->GetEntries(a_Pass);
+        }
+    }
+
+    template <typename T, typename INTERNAL_FORMAT>
+    std::size_t ShaderCache<T, INTERNAL_FORMAT>::WarmUp(float a_BudgetMilliseconds)
+    {
+        assert(m_Init);
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        while (m_WarmUpNext < m_WarmUpQueue.size())
+        {
+            if (a_BudgetMilliseconds > 0.f && std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= a_BudgetMilliseconds)
+            {
+                break;
+            }
+
+            const auto& entry = m_WarmUpQueue[m_WarmUpNext];
+            ++m_WarmUpNext;
+
+            const auto mask = static_cast<T>(entry.mask);
+            if (!Contains(mask, entry.definitions))
+            {
+                LoadShader(mask, entry.definitions);
+            }
+        }
+
+        return m_WarmUpQueue.size() - m_WarmUpNext;
     }
 }
@@ -0,0 +1,170 @@
+#pragma once
+#include <chrono>
+#include <cinttypes>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blurp
+{
+    class Shader;
+
+    /*
+     * What a ShaderCache does when a pass needs a variant that is not compiled yet.
+     */
+    enum class ShaderFallbackPolicy
+    {
+        //Compile the variant right away. This stalls the frame, but every draw uses the right shader.
+        BLOCK,
+
+        //Compile the variant in the background and skip draws that need it until it is ready.
+        SKIP,
+
+        //Compile the variant in the background. Until then draw with the compiled variant that has the most of the requested features and no others.
+        //Draws are skipped when there is no such variant.
+        SUBSET,
+
+        //Compile the variant in the background. Until then draw with the compiled variant that differs in the fewest features, preferring fewer features over more.
+        //Draws are skipped when there is no compiled variant.
+        NEAREST
+    };
+
+    /*
+     * Counters of a ShaderCompileQueue. These are not cleared.
+     */
+    struct ShaderCompileQueueStats
+    {
+        ShaderCompileQueueStats() : requests(0), started(0), finished(0), failed(0), fallbacks(0), skips(0) {}
+
+        //The amount of variants that were queued.
+        std::uint32_t requests;
+
+        //The amount of variants that started compiling, the amount that were ready to use and the amount that could not be created.
+        std::uint32_t started;
+        std::uint32_t finished;
+        std::uint32_t failed;
+
+        //The amount of times another variant was used while the requested one was compiling, and the amount of times nothing could be used.
+        std::uint32_t fallbacks;
+        std::uint32_t skips;
+    };
+
+    /*
+     * A variant that is waiting to be compiled, or is being compiled.
+     */
+    struct ShaderCompileJob
+    {
+        ShaderCompileJob() : mask(0), definitionsId(0) {}
+
+        std::uint64_t mask;
+
+        //Preprocessor definitions to add on top of the ones enabled by the mask, and their id in the ShaderRegistry.
+        std::vector<std::string> definitions;
+        std::uint64_t definitionsId;
+
+        //The shader being compiled, and when compiling started. Set once the job started.
+        std::shared_ptr<Shader> shader;
+        std::chrono::high_resolution_clock::time_point start;
+    };
+
+    /*
+     * ShaderCompileQueue schedules the compilation of shader variants over several frames.
+     *
+     * Requested variants wait in order of request. Every Update first collects the variants that finished compiling,
+     * and then starts new ones until the time budget is spent or the maximum amount of variants is compiling.
+     * How a variant is created and when it is ready is up to the caller, so that the queue works the same for every graphics API:
+     * drivers that compile in parallel return right away and are ready a few frames later, others compile while starting and are ready immediately.
+     *
+     * SelectFallback picks the variant that is used in place of one that is still compiling.
+     */
+    class ShaderCompileQueue
+    {
+    public:
+        /*
+         * Create the shader for a job. Returns nullptr if it could not be created.
+         */
+        using StartFunction = std::function<std::shared_ptr<Shader>(const ShaderCompileJob&)>;
+
+        /*
+         * Returns true when the shader of a job can be used.
+         */
+        using ReadyFunction = std::function<bool(Shader&)>;
+
+        /*
+         * Called with every job that is ready, and the time in milliseconds since it was started.
+         */
+        using FinishFunction = std::function<void(const ShaderCompileJob&, float)>;
+
+        ShaderCompileQueue(std::uint32_t a_MaxInFlight = 8);
+
+        /*
+         * Set the maximum amount of variants that are compiling at the same time.
+         */
+        void SetMaxInFlight(std::uint32_t a_MaxInFlight);
+
+        /*
+         * Queue a variant to be compiled. Variants that are already queued or compiling are ignored.
+         * Variants are told apart by their mask and a_DefinitionsId, see ShaderRegistry::CalculateDefinitionsId.
+         * Returns true if the variant was added.
+         */
+        bool Request(std::uint64_t a_Mask, const std::vector<std::string>& a_Definitions, std::uint64_t a_DefinitionsId = 0);
+
+        /*
+         * Returns true if a variant is waiting or compiling.
+         */
+        bool IsQueued(std::uint64_t a_Mask, std::uint64_t a_DefinitionsId = 0) const;
+
+        /*
+         * Finish the jobs that are ready, and start new jobs until a_BudgetMilliseconds have passed.
+         * At least one job is started when there is room for it. There is no time limit when the budget is 0 or less.
+         * Returns the amount of jobs that are waiting or compiling.
+         */
+        std::size_t Update(float a_BudgetMilliseconds, const StartFunction& a_Start, const ReadyFunction& a_IsReady, const FinishFunction& a_Finish);
+
+        /*
+         * Count a draw that used another variant when a_Found is true, or that was skipped.
+         */
+        void CountFallback(bool a_Found);
+
+        /*
+         * Remove every job. Shaders that are compiling are dropped.
+         */
+        void Clear();
+
+        /*
+         * Get the amount of jobs that did not start yet.
+         */
+        std::size_t GetWaitingCount() const;
+
+        /*
+         * Get the amount of jobs that are compiling.
+         */
+        std::size_t GetInFlightCount() const;
+
+        /*
+         * Get the counters of this queue.
+         */
+        const ShaderCompileQueueStats& GetStats() const;
+
+        /*
+         * Select the variant from a_Available to use in place of a_Requested, following a_Policy.
+         * Bits in a_ExactBits have to be the same in both masks, for example the bits for vertex attributes which change the input layout.
+         * Returns false when no variant can be used, which is always the case for BLOCK and SKIP.
+         */
+        static bool SelectFallback(std::uint64_t a_Requested, const std::vector<std::uint64_t>& a_Available, std::uint64_t a_ExactBits, ShaderFallbackPolicy a_Policy, std::uint64_t& a_Fallback);
+
+    private:
+        std::deque<ShaderCompileJob> m_Waiting;
+        std::vector<ShaderCompileJob> m_InFlight;
+
+        //Masks and definition ids of all waiting and compiling jobs.
+        std::set<std::pair<std::uint64_t, std::uint64_t>> m_Queued;
+
+        std::uint32_t m_MaxInFlight;
+        ShaderCompileQueueStats m_Stats;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cinttypes>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace blurp
+{
+    /*
+     * A single shader variant that was used by a render pass.
+     */
+    struct ShaderManifestEntry
+    {
+        ShaderManifestEntry() : mask(0), frame(0), compileMilliseconds(0.f) {}
+
+        //The mask that the pass requested from its ShaderCache.
+        std::uint64_t mask;
+
+        //Preprocessor definitions that were passed to ShaderCache::LoadShader on top of the mask.
+        std::vector<std::string> definitions;
+
+        //The frame in which the variant was first used, and how long compiling it took.
+        std::uint64_t frame;
+        float compileMilliseconds;
+    };
+
+    /*
+     * ShaderManifest is a list of the shader variants that render passes used, so that they can be compiled at startup in a later run.
+     *
+     * Give a manifest to the passes with SetShaderManifest. Every variant that a pass compiles while drawing is added to it,
+     * and every variant that is in the manifest is compiled before it is needed. Call NextFrame once per frame to keep track of when variants were first used.
+     *
+     * Save writes a text file with one variant per line, sorted by pass and mask, so that the file only changes where the variants do.
+     * Lines are tab separated: pass name, mask in hexadecimal, first use frame, compile time in milliseconds and the extra definitions separated by ';'.
+     * Lines starting with '#' are comments.
+     */
+    class ShaderManifest
+    {
+    public:
+        ShaderManifest();
+
+        /*
+         * Add a variant for a pass. Variants that are already known keep their first use frame and compile time.
+         * The current frame is used as first use frame.
+         * Returns true if the variant was added.
+         */
+        bool Record(const std::string& a_Pass, std::uint64_t a_Mask, const std::vector<std::string>& a_Definitions, float a_CompileMilliseconds);
+
+        /*
+         * Returns true if the pass used the variant with the given mask.
+         */
+        bool Contains(const std::string& a_Pass, std::uint64_t a_Mask) const;
+
+        /*
+         * Get every variant of a pass, sorted by their first use frame so that the ones needed first are compiled first.
+         */
+        std::vector<ShaderManifestEntry> GetEntries(const std::string& a_Pass) const;
+
+        /*
+         * Get the amount of variants of all passes.
+         */
+        std::size_t GetEntryCount() const;
+
+        /*
+         * Move on to the next frame.
+         */
+        void NextFrame();
+
+        /*
+         * Get the current frame.
+         */
+        std::uint64_t GetFrame() const;
+
+        /*
+         * Remove every variant and reset the frame to 0.
+         */
+        void Clear();
+
+        /*
+         * Write the manifest to a file. Returns false if the file could not be written.
+         */
+        bool Save(const std::string& a_Path) const;
+
+        /*
+         * Add the variants in a file to this manifest. Lines that can not be read are skipped.
+         * Returns false if the file could not be opened.
+         */
+        bool Load(const std::string& a_Path);
+
+        /*
+         * Get the amount of lines that were skipped by the last call to Load.
+         */
+        std::uint32_t GetSkippedLines() const;
+
+    private:
+        //Sorted by pass and then by mask, which is the order in which they are saved.
+        std::map<std::pair<std::string, std::uint64_t>, ShaderManifestEntry> m_Entries;
+        std::uint64_t m_Frame;
+        std::uint32_t m_SkippedLines;
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blurp
+{
+    /*
+     * ShaderMaskTable describes the bits of a shader mask for a pass: the preprocessor definition of every bit, and whether the shaders of the pass use it.
+     *
+     * Passes build their masks from everything a draw has, such as every vertex attribute of the mesh. Bits that the shaders do not use are folded out
+     * by Canonicalize, so draws that only differ in those bits use the same variant.
+     * Vertex attribute locations are passed to the shaders as additional definitions, see Mesh_GL::GetAttribLocations.
+     * FilterDefinitions drops the locations of attributes that are not used, so that they do not tell variants apart either.
+     */
+    class ShaderMaskTable
+    {
+    public:
+        ShaderMaskTable();
+
+        /*
+         * Add the definition for the next bit of the mask. a_Used is false when the shaders do not change with this definition.
+         * a_LocationDefinition is the name of the definition that holds the attribute location for this bit, or empty when the bit is not a vertex attribute.
+         */
+        void Add(const std::string& a_Definition, bool a_Used, const std::string& a_LocationDefinition = std::string());
+
+        /*
+         * Get the definition of every bit, at the index of the bit.
+         */
+        const std::vector<std::string>& GetDefinitions() const;
+
+        /*
+         * Get the mask with a bit for every definition that is used.
+         */
+        std::uint64_t GetUsedBits() const;
+
+        /*
+         * Returns true if the bit at a_Index is used.
+         */
+        bool IsUsed(std::uint32_t a_Index) const;
+
+        /*
+         * Remove the bits that are not used from a mask.
+         */
+        std::uint64_t Canonicalize(std::uint64_t a_Mask) const;
+
+        /*
+         * Copy a_Definitions to a_Output, leaving out the attribute locations of bits that are not used. Definitions that are not a location are kept.
+         * Definitions are "NAME" or "NAME VALUE". a_Output is cleared first and may not be a_Definitions.
+         */
+        void FilterDefinitions(const std::vector<std::string>& a_Definitions, std::vector<std::string>& a_Output) const;
+
+    private:
+        std::vector<std::string> m_Definitions;
+
+        //Every location definition, and whether its bit is used.
+        std::unordered_map<std::string, bool> m_Locations;
+
+        std::uint64_t m_UsedBits;
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace blurp
+{
+    /*
+     * Counters of a ShaderPreprocessor. These are not cleared.
+     */
+    struct ShaderPreprocessorStats
+    {
+        ShaderPreprocessorStats() : processed(0), failed(0), inputBytes(0), outputBytes(0) {}
+
+        //The amount of sources that were processed, and the amount that could not be processed.
+        std::uint32_t processed;
+        std::uint32_t failed;
+
+        //The size of the sources with their definitions before processing, and the size of the output.
+        std::uint64_t inputBytes;
+        std::uint64_t outputBytes;
+    };
+
+    /*
+     * ShaderPreprocessor resolves the conditional parts of GLSL source for a set of definitions on the CPU, so that the driver only gets the code that is used.
+     *
+     * #ifdef, #ifndef, #if, #elif, #else and #endif are resolved. #if supports defined(), integer literals, macros with integer values,
+     * and the operators ! && || == != < > <= >= + - * / % and parentheses. Names that are not defined count as 0, like in C.
+     * #include "file" inserts a file from the include directory. Every file is included at most once per source.
+     * Comments, empty lines and repeated whitespace are removed. #version is moved to the top, followed by the definitions that are still used.
+     * Other directives such as #define in the source are kept in place.
+     *
+     * Variants that only differ in definitions that do not change the output give the same source, so they can share one program.
+     */
+    class ShaderPreprocessor
+    {
+    public:
+        ShaderPreprocessor();
+
+        /*
+         * Set the directory that #include looks in.
+         */
+        void SetIncludeDirectory(const std::string& a_Directory);
+
+        /*
+         * Resolve a_Source for a_Definitions and write the result to a_Output. Definitions are "NAME" or "NAME VALUE", like ShaderSettings::preprocessorDefinitions.
+         * Returns false when the source can not be processed, for example when a conditional is not closed or an include is missing. See GetError.
+         */
+        bool Process(const char* a_Source, const std::vector<std::string>& a_Definitions, std::string& a_Output);
+
+        /*
+         * Get the reason why the last call to Process failed.
+         */
+        const std::string& GetError() const;
+
+        /*
+         * Get the counters of this preprocessor.
+         */
+        const ShaderPreprocessorStats& GetStats() const;
+
+    private:
+        //State of an #if block.
+        struct Conditional
+        {
+            //The block containing this one is active, this branch is active, and an earlier branch was taken.
+            bool parentActive;
+            bool active;
+            bool taken;
+            bool seenElse;
+        };
+
+        bool ProcessText(const std::string& a_Text, std::uint32_t a_Depth);
+        bool IsActive() const;
+        bool Define(const std::string& a_Definition);
+
+        /*
+         * Evaluate the expression of an #if or #elif.
+         */
+        bool Evaluate(const std::string& a_Expression, bool& a_Result);
+
+    private:
+        std::string m_IncludeDirectory;
+        std::string m_Error;
+        ShaderPreprocessorStats m_Stats;
+
+        //State while processing a source.
+        std::unordered_map<std::string, std::string> m_Macros;
+        std::unordered_set<std::string> m_Included;
+        std::vector<Conditional> m_Conditionals;
+        std::string m_Version;
+        std::string m_Body;
+    };
+}
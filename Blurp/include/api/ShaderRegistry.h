@@ -0,0 +1,203 @@
+#pragma once
+#include <cinttypes>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace blurp
+{
+    class Shader;
+    struct ShaderSettings;
+
+    /*
+     * Counters of a ShaderRegistry. These are not cleared.
+     */
+    struct ShaderRegistryStats
+    {
+        ShaderRegistryStats() : hits(0), misses(0), evictions(0), released(0), overBudget(0), shared(0) {}
+
+        //The amount of lookups that found a program, and the amount that did not.
+        std::uint32_t hits;
+        std::uint32_t misses;
+
+        //The amount of programs removed because the budget was exceeded.
+        std::uint32_t evictions;
+
+        //The amount of programs removed because no ShaderCache used their source anymore.
+        std::uint32_t released;
+
+        //The amount of times the budget could not be met because every program was used in the current frame.
+        std::uint32_t overBudget;
+
+        //The amount of variants that reused the program of another variant with the same preprocessed source.
+        std::uint32_t shared;
+    };
+
+    /*
+     * ShaderRegistry holds the compiled variants of every ShaderCache in a BlurpEngine, so that passes that use the same shader share their programs.
+     *
+     * Variants are stored by the id of their source, their mask and the id of their additional definitions such as attribute locations.
+     * The source id is calculated from the shader stages and all preprocessor definitions, so caches only share programs when they would compile exactly the same thing.
+     * Every ShaderCache references its source. When the last reference is removed, the variants of that source are removed as well.
+     *
+     * When a budget is set, the variants that were used the longest ago are removed whenever the budget is exceeded.
+     * Variants used in the current frame are never removed, see NextFrame. Removed programs are destroyed by RenderResourceManager::CleanUpUnused.
+     */
+    class ShaderRegistry
+    {
+    public:
+        /*
+         * Create a registry that holds at most a_MaxPrograms programs. 0 means there is no limit.
+         */
+        ShaderRegistry(std::uint32_t a_MaxPrograms = 0);
+
+        /*
+         * Set the maximum amount of programs. 0 means there is no limit.
+         * Idle programs are removed right away when there are too many.
+         */
+        void SetBudget(std::uint32_t a_MaxPrograms);
+
+        /*
+         * Get the maximum amount of programs. 0 means there is no limit.
+         */
+        std::uint32_t GetBudget() const;
+
+        /*
+         * Add a reference to a source. Called by every ShaderCache that uses the source.
+         */
+        void AddReference(std::uint64_t a_SourceId);
+
+        /*
+         * Remove a reference to a source. The variants of the source are removed when no references are left.
+         */
+        void RemoveReference(std::uint64_t a_SourceId);
+
+        /*
+         * Get the amount of references to a source.
+         */
+        std::uint32_t GetReferences(std::uint64_t a_SourceId) const;
+
+        /*
+         * Get the program for a variant, and mark it as used in the current frame.
+         * Returns nullptr if the variant is not stored.
+         */
+        std::shared_ptr<Shader> Find(std::uint64_t a_SourceId, std::uint64_t a_Mask, std::uint64_t a_DefinitionsId = 0);
+
+        /*
+         * Returns true if a variant is stored. This does not count as a use.
+         */
+        bool Contains(std::uint64_t a_SourceId, std::uint64_t a_Mask, std::uint64_t a_DefinitionsId = 0) const;
+
+        /*
+         * Add the masks of every variant of a source with the given additional definitions to a_Masks. This does not count as a use.
+         */
+        void GetMasks(std::uint64_t a_SourceId, std::vector<std::uint64_t>& a_Masks, std::uint64_t a_DefinitionsId = 0) const;
+
+        /*
+         * Store the program for a variant, replacing the one that is stored. The variant is marked as used in the current frame.
+         * Idle programs are removed when the budget is exceeded.
+         */
+        void Insert(std::uint64_t a_SourceId, std::uint64_t a_Mask, const std::shared_ptr<Shader>& a_Shader, std::uint64_t a_DefinitionsId = 0);
+
+        /*
+         * Get the program that was made from preprocessed source with the hash a_SourceHash, as long as any variant still uses it.
+         * Returns nullptr if there is no such program.
+         */
+        std::shared_ptr<Shader> FindShared(std::uint64_t a_SourceHash);
+
+        /*
+         * Remember that a_Shader was made from preprocessed source with the hash a_SourceHash, so that variants that preprocess to the same source can use it.
+         * The registry does not keep the program alive for this.
+         */
+        void Share(std::uint64_t a_SourceHash, const std::shared_ptr<Shader>& a_Shader);
+
+        /*
+         * Remove the programs that were used the longest ago until the budget is met. Programs used in the current frame are kept.
+         * Returns the amount of programs removed.
+         */
+        std::uint32_t Evict();
+
+        /*
+         * Move on to the next frame. Called by every RenderPipeline before it executes.
+         */
+        void NextFrame();
+
+        /*
+         * Get the current frame.
+         */
+        std::uint64_t GetFrame() const;
+
+        /*
+         * Get the amount of programs stored.
+         */
+        std::size_t GetProgramCount() const;
+
+        /*
+         * Get the counters of this registry.
+         */
+        const ShaderRegistryStats& GetStats() const;
+
+        /*
+         * Remove every program. References are kept.
+         */
+        void Clear();
+
+        /*
+         * Calculate the id of a source from the settings that are used for every variant and the definitions that are enabled by the bits of the mask.
+         */
+        static std::uint64_t CalculateSourceId(const ShaderSettings& a_Settings, const std::vector<std::string>& a_Definitions);
+
+        /*
+         * Calculate the id of the additional definitions of a variant. This is 0 when there are none.
+         */
+        static std::uint64_t CalculateDefinitionsId(const std::vector<std::string>& a_Definitions);
+
+    private:
+        struct Key
+        {
+            std::uint64_t source;
+            std::uint64_t mask;
+            std::uint64_t definitions;
+
+            bool operator==(const Key& a_Other) const
+            {
+                return source == a_Other.source && mask == a_Other.mask && definitions == a_Other.definitions;
+            }
+        };
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Key& a_Key) const
+            {
+                return static_cast<std::size_t>(a_Key.source ^ (a_Key.mask * 0x9e3779b97f4a7c15ull) ^ (a_Key.definitions * 0xc2b2ae3d27d4eb4full));
+            }
+        };
+
+        struct Entry
+        {
+            std::shared_ptr<Shader> shader;
+            std::uint64_t lastFrame;
+
+            //Position in m_UseOrder.
+            std::list<Key>::iterator use;
+        };
+
+        void Touch(Entry& a_Entry);
+
+    private:
+        std::unordered_map<Key, Entry, KeyHash> m_Entries;
+
+        //Most recently used at the front.
+        std::list<Key> m_UseOrder;
+
+        std::unordered_map<std::uint64_t, std::uint32_t> m_References;
+
+        //Programs by the hash of their preprocessed source.
+        std::unordered_map<std::uint64_t, std::weak_ptr<Shader>> m_Shared;
+        std::uint32_t m_MaxPrograms;
+        std::uint64_t m_Frame;
+        ShaderRegistryStats m_Stats;
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "RenderPass_ShadowMap.h"
+
+namespace blurp
+{
+    /*
+     * Counters kept by a ShadowCasterCuller. They are cleared by ShadowCasterCuller::Reset().
+     */
+    struct ShadowCullingStats
+    {
+        ShadowCullingStats() : instancesTested(0), faceInstances(0), skippedFaceInstances(0) {}
+
+        //The amount of instances passed to Cull().
+        std::uint64_t instancesTested;
+
+        //The amount of instances that cast a shadow into each cascade. The index is (directional light index * cascade count) + cascade.
+        std::vector<std::uint64_t> cascadeCasters;
+
+        //The amount of instances that cast a shadow into at least one cascade of each directional light. Each of them is in a single list.
+        std::vector<std::uint64_t> directionalCasters;
+
+        //The amount of instances that cast a shadow for each positional light.
+        std::vector<std::uint64_t> positionalCasters;
+
+        //The amount of instances that cast a shadow into each cube face. The index is (positional light index * 6) + face.
+        //Faces with a count of 0 are not drawn into at all.
+        std::vector<std::uint64_t> faceCasters;
+
+        //The amount of cube faces that positional casters are drawn into, and the amount that they are not drawn into out of the six of their light.
+        std::uint64_t faceInstances;
+        std::uint64_t skippedFaceInstances;
+    };
+
+    /*
+     * Transforms of the instances that cast a shadow into the same cascades or cube faces of a single light.
+     * lights contains the bits for that light and those cascades or faces, ready to be passed to RenderPass_ShadowMap::SetGeometry.
+     */
+    struct ShadowCasterList
+    {
+        LightIndexData lights;
+        std::vector<glm::mat4> transforms;
+    };
+
+    /*
+     * ShadowCasterCuller tests shadow casting instances against the volume of every shadow map that they could be drawn into.
+     * Every cascade of a directional light uses its light space orthographic volume, calculated the same way RenderPass_ShadowMap does.
+     * Instances that are in the same cascades are put in the same list, with LightIndexData::cascadeMask set to those cascades.
+     * Positional lights use a sphere with the range of the light as radius. This is the distance where their light falls below the light cutoff,
+     * but never more than the camera far plane, which is the range of their shadow maps. Instances further away can not shadow anything that the light reaches.
+     * The instances of a positional light are also tested against each of its cube faces. Instances that are visible in the same faces
+     * are put in the same list, with LightIndexData::faceMask set to those faces. The other faces never see these instances.
+     *
+     * The instances that survive are copied into a compact list, once for every light that they cast a shadow for.
+     * Drawing each list with its LightIndexData means every instance is only drawn into the shadow maps it can affect.
+     */
+    class ShadowCasterCuller
+    {
+    public:
+        ShadowCasterCuller();
+
+        /*
+         * Set the camera used by the shadow pass.
+         */
+        void SetCamera(const std::shared_ptr<Camera>& a_Camera);
+
+        /*
+         * Set the shadow settings used by the shadow pass. Only the cascade settings are used.
+         */
+        void SetShadowData(const ShadowData& a_Data);
+
+        /*
+         * Set the radiance below which a light no longer affects a surface. Used to find the range of positional lights.
+         * This should be the same value that the light clusters and shadow scheduler use. 0.01 by default.
+         */
+        void SetLightCutoff(float a_Cutoff);
+
+        /*
+         * Get the range used for the positional light at the given index, in the order the lights were added.
+         */
+        float GetLightRange(std::uint32_t a_Light) const;
+
+        /*
+         * Remove all lights and clear the counters. Call this at the start of every frame.
+         */
+        void Reset();
+
+        /*
+         * Add a shadow casting light. The volumes are calculated from the current camera state.
+         * Lights have to be added in the same order as they are added to the shadow pass, so that the light indices match.
+         */
+        void AddLight(const std::shared_ptr<Light>& a_Light);
+
+        /*
+         * Cull instances of a mesh with the given local bounds against every light volume.
+         * Returns the lists that at least one instance was put in, for every light.
+         * The returned lists are overwritten by the next call.
+         */
+        const std::vector<const ShadowCasterList*>& Cull(const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count);
+
+        /*
+         * Get the orthographic volume of a cascade of a directional light.
+         */
+        const Frustum& GetCascadeVolume(std::uint32_t a_Light, std::uint32_t a_Cascade) const;
+
+        /*
+         * Get the counters for the current frame.
+         */
+        const ShadowCullingStats& GetStats() const;
+
+    private:
+        std::shared_ptr<Camera> m_Camera;
+        ShadowData m_ShadowData;
+
+        //One volume per cascade for every directional light, stored light after light.
+        std::vector<Frustum> m_CascadeVolumes;
+
+        //Position and range of every positional light.
+        std::vector<glm::vec3> m_LightPositions;
+        std::vector<float> m_LightRanges;
+        float m_LightCutoff;
+
+        //One list per face mask for every positional light.
+        //The list at (positional light index * 64) + mask holds the instances that are visible in exactly the faces in mask. Mask 0 is never used.
+        std::vector<ShadowCasterList> m_Lists;
+
+        //One list per combination of cascades that instances were found in, for every directional light.
+        //Only the first m_UsedCascadeLists are filled by the last call to Cull(). The others are kept to reuse their memory.
+        std::vector<ShadowCasterList> m_CascadeLists;
+        std::size_t m_UsedCascadeLists;
+        std::vector<const ShadowCasterList*> m_Results;
+
+        ShadowCullingStats m_Stats;
+    };
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Data.h"
+
+namespace blurp
+{
+    class Camera;
+    class Light;
+
+    /*
+     * Settings that determine how shadow map slots are handed out to positional lights.
+     */
+    struct ShadowSchedulerSettings
+    {
+        ShadowSchedulerSettings()
+        {
+            slots = 1;
+            hysteresis = 0.25f;
+            distanceWeight = 0.01f;
+            lightCutoff = 0.01f;
+        }
+
+        //The amount of positional shadow maps available. Shadow map indices go from 0 up to slots - 1.
+        std::uint32_t slots;
+
+        //Lights that had a slot in the previous frame have their score increased by this fraction.
+        //This stops lights with a similar score from taking each others slot every frame.
+        float hysteresis;
+
+        //How quickly the score drops with the distance to the camera. The score is divided by (1 + distance * distanceWeight).
+        float distanceWeight;
+
+        //The radiance below which a light no longer affects a surface. Used to find the range of a light.
+        float lightCutoff;
+    };
+
+    /*
+     * Counters for the last call to ShadowLightScheduler::Schedule.
+     */
+    struct ShadowSchedulerStats
+    {
+        ShadowSchedulerStats() : lights(0), visible(0), assigned(0), slotChanges(0), evicted(0), totalSlotChanges(0) {}
+
+        //The amount of point and spot lights passed to the scheduler.
+        std::uint32_t lights;
+
+        //The amount of lights that affect the view.
+        std::uint32_t visible;
+
+        //The amount of slots that hold a light.
+        std::uint32_t assigned;
+
+        //The amount of slots that now hold a different light (or none) than in the previous frame.
+        std::uint32_t slotChanges;
+
+        //The amount of lights that lost their slot.
+        std::uint32_t evicted;
+
+        //The amount of slot changes since the scheduler was created. Not cleared between frames.
+        std::uint64_t totalSlotChanges;
+    };
+
+    /*
+     * ShadowLightScheduler decides which point and spot lights get one of a limited amount of shadow maps.
+     *
+     * Every light is scored each frame by how much of the screen it can affect, how bright it is and how far it is from the camera.
+     * Lights whose range does not reach the view frustum are not considered.
+     * The highest scoring lights receive a shadow map slot through Light::SetShadowMapIndex, all other lights are set to -1 and are drawn without shadows.
+     *
+     * A light that keeps its slot always keeps the same index, so that its shadow map does not move around in the array.
+     * Lights that held a slot in the previous frame get a bonus to their score, so that slots are not traded back and forth every frame.
+     * Ties are broken by the order in which lights are passed in, which makes the result the same every time for the same input.
+     */
+    class ShadowLightScheduler
+    {
+    public:
+        ShadowLightScheduler();
+
+        /*
+         * Change the settings. Lights that hold a slot that no longer exists lose it on the next call to Schedule.
+         */
+        void SetSettings(const ShadowSchedulerSettings& a_Settings);
+
+        /*
+         * Get the current settings.
+         */
+        const ShadowSchedulerSettings& GetSettings() const;
+
+        /*
+         * Score the point and spot lights in a_Lights and assign the shadow map slots for this frame.
+         * Only a_Lights.point and a_Lights.spot are used. Pass the same upload data to GpuBuffer::WriteData afterwards,
+         * so that the lights with a slot are uploaded as shadow casting lights.
+         */
+        void Schedule(const Camera& a_Camera, const LightUploadData& a_Lights);
+
+        /*
+         * Get the light in every slot. The index in this vector is the shadow map index of the light. Empty slots are nullptr.
+         * Add these lights to RenderPass_ShadowMap with their slot as index.
+         */
+        const std::vector<std::shared_ptr<Light>>& GetSlots() const;
+
+        /*
+         * Remove every light from its slot and set its shadow map index to -1.
+         */
+        void Clear();
+
+        /*
+         * Get the counters for the last call to Schedule.
+         */
+        const ShadowSchedulerStats& GetStats() const;
+
+        /*
+         * Calculate the score of a light at a_Position with the given color and intensity.
+         * a_Spread is between 0 and 1, and is the part of the surrounding area the light shines on. 1 for point lights.
+         * Returns 0 when the light does not reach the view.
+         */
+        static float CalculateScore(const Camera& a_Camera, const Frustum& a_Frustum, const glm::vec3& a_Position, const glm::vec4& a_ColorIntensity, float a_Spread, const ShadowSchedulerSettings& a_Settings);
+
+    private:
+        //A light that was passed to Schedule, with its score for this frame.
+        //order is the index into the point lights, followed by the spot lights.
+        struct Candidate
+        {
+            Light* light;
+            float score;
+            std::uint32_t order;
+            std::int32_t previousSlot;
+        };
+
+        //Find the slot that a light had in the previous frame, or -1.
+        std::int32_t FindSlot(const Light* a_Light) const;
+
+    private:
+        ShadowSchedulerSettings m_Settings;
+        std::vector<std::shared_ptr<Light>> m_Slots;
+        std::vector<Candidate> m_Candidates;
+        ShadowSchedulerStats m_Stats;
+    };
+}
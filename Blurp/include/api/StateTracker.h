@@ -0,0 +1,218 @@
+#pragma once
+#include <cinttypes>
+#include <unordered_map>
+
+namespace blurp
+{
+    /*
+     * The faces that stencil state can be set for.
+     */
+    enum class StateFace
+    {
+        FRONT,
+        BACK
+    };
+
+    /*
+     * Receives the state changes that StateTracker decided to send. Every function maps to exactly one graphics API call.
+     * Values such as capabilities, targets and functions are passed on unchanged, so they are in the format of the API.
+     */
+    class StateTrackerBackend
+    {
+    public:
+        virtual ~StateTrackerBackend() = default;
+
+        virtual void UseProgram(std::uint32_t a_Program) = 0;
+        virtual void BindVertexArray(std::uint32_t a_VertexArray) = 0;
+        virtual void ActiveTexture(std::uint32_t a_Unit) = 0;
+        virtual void BindTexture(std::uint32_t a_Target, std::uint32_t a_Texture) = 0;
+        virtual void BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler) = 0;
+        virtual void BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer) = 0;
+        virtual void BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer) = 0;
+        virtual void BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size) = 0;
+        virtual void BindFramebuffer(std::uint32_t a_Framebuffer) = 0;
+        virtual void SetEnabled(std::uint32_t a_Capability, bool a_Enabled) = 0;
+        virtual void DepthFunc(std::uint32_t a_Function) = 0;
+        virtual void DepthMask(bool a_Write) = 0;
+        virtual void CullFace(std::uint32_t a_Face) = 0;
+        virtual void FrontFace(std::uint32_t a_WindingOrder) = 0;
+        virtual void BlendFuncSeparate(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha) = 0;
+        virtual void BlendEquationSeparate(std::uint32_t a_Rgb, std::uint32_t a_Alpha) = 0;
+        virtual void StencilFuncSeparate(StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask) = 0;
+        virtual void StencilOpSeparate(StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass) = 0;
+        virtual void StencilMask(std::uint32_t a_Mask) = 0;
+        virtual void Viewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) = 0;
+        virtual void Scissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) = 0;
+        virtual void ClearColor(float a_R, float a_G, float a_B, float a_A) = 0;
+    };
+
+    /*
+     * Counters of a StateTracker for a single frame.
+     */
+    struct StateTrackerStats
+    {
+        StateTrackerStats() : issued(0), filtered(0) {}
+
+        //The amount of calls sent to the backend, and the amount that were left out because they would not change anything.
+        std::uint32_t issued;
+        std::uint32_t filtered;
+    };
+
+    /*
+     * StateTracker mirrors the state that render passes set, and only sends the calls that change it to a StateTrackerBackend.
+     *
+     * The bound program, vertex array, framebuffer, textures and samplers per unit, generic and indexed buffer bindings,
+     * enabled capabilities and the depth, stencil, cull, blend, viewport, scissor and clear color state are tracked.
+     * State starts out unknown, so the first call for every value is always sent. Binding an indexed buffer also changes the generic binding of its target.
+     *
+     * Anything that changes state without going through the tracker has to be followed by Invalidate, or InvalidateBuffers when only buffer bindings changed.
+     * Objects that are deleted and recreated can get the id of the old object, so deleting bound objects also requires invalidating.
+     */
+    class StateTracker
+    {
+    public:
+        /*
+         * Create a tracker that sends its calls to a_Backend. The backend has to outlive the tracker.
+         */
+        StateTracker(StateTrackerBackend& a_Backend);
+
+        void UseProgram(std::uint32_t a_Program);
+        void BindVertexArray(std::uint32_t a_VertexArray);
+        void BindFramebuffer(std::uint32_t a_Framebuffer);
+
+        /*
+         * Bind a texture to a_Target of texture unit a_Unit. The active unit is only changed when the binding changes.
+         */
+        void BindTexture(std::uint32_t a_Unit, std::uint32_t a_Target, std::uint32_t a_Texture);
+        void BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler);
+
+        void BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer);
+        void BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer);
+        void BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size);
+
+        void SetEnabled(std::uint32_t a_Capability, bool a_Enabled);
+        void SetDepthFunc(std::uint32_t a_Function);
+        void SetDepthMask(bool a_Write);
+        void SetCullFace(std::uint32_t a_Face);
+        void SetFrontFace(std::uint32_t a_WindingOrder);
+        void SetBlendFunc(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha);
+        void SetBlendEquation(std::uint32_t a_Rgb, std::uint32_t a_Alpha);
+        void SetStencilFunc(StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask);
+        void SetStencilOp(StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass);
+
+        /*
+         * Set the stencil write mask for both faces.
+         */
+        void SetStencilMask(std::uint32_t a_Mask);
+        void SetViewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height);
+        void SetScissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height);
+        void SetClearColor(float a_R, float a_G, float a_B, float a_A);
+
+        /*
+         * Forget all state, so that every next call is sent.
+         */
+        void Invalidate();
+
+        /*
+         * Forget the generic and indexed buffer bindings.
+         */
+        void InvalidateBuffers();
+
+        /*
+         * Start counting for a new frame. The counters of the current frame become the counters of the last frame.
+         */
+        void NextFrame();
+
+        /*
+         * Get the counters of the current frame.
+         */
+        const StateTrackerStats& GetStats() const;
+
+        /*
+         * Get the counters of the frame before NextFrame was last called.
+         */
+        const StateTrackerStats& GetLastFrameStats() const;
+
+    private:
+        //A tracked value, which is unknown until it is first set.
+        template<typename T>
+        struct Cached
+        {
+            Cached() : value(), known(false) {}
+
+            //Store a_Value and return true if it differs from what was stored.
+            bool Set(const T& a_Value)
+            {
+                if(known && value == a_Value)
+                {
+                    return false;
+                }
+                value = a_Value;
+                known = true;
+                return true;
+            }
+
+            T value;
+            bool known;
+        };
+
+        struct Values4
+        {
+            std::int64_t values[4];
+
+            bool operator==(const Values4& a_Other) const
+            {
+                return values[0] == a_Other.values[0] && values[1] == a_Other.values[1] && values[2] == a_Other.values[2] && values[3] == a_Other.values[3];
+            }
+        };
+
+        struct ClearValue
+        {
+            float values[4];
+
+            bool operator==(const ClearValue& a_Other) const
+            {
+                return values[0] == a_Other.values[0] && values[1] == a_Other.values[1] && values[2] == a_Other.values[2] && values[3] == a_Other.values[3];
+            }
+        };
+
+        //Count a call that was sent, or a_Calls calls that were left out.
+        void Issue(std::uint32_t a_Calls = 1);
+        void Filter(std::uint32_t a_Calls = 1);
+
+        //Returns true if the indexed binding a_Key and the generic binding of a_Target are both set to a_Binding.
+        bool IsBound(std::uint32_t a_Target, std::uint64_t a_Key, const Values4& a_Binding) const;
+
+        static std::uint64_t PairKey(std::uint32_t a_First, std::uint32_t a_Second);
+
+    private:
+        StateTrackerBackend& m_Backend;
+        StateTrackerStats m_Stats;
+        StateTrackerStats m_LastFrameStats;
+
+        Cached<std::uint32_t> m_Program;
+        Cached<std::uint32_t> m_VertexArray;
+        Cached<std::uint32_t> m_Framebuffer;
+        Cached<std::uint32_t> m_ActiveUnit;
+
+        //Textures by unit and target, samplers by unit, generic buffers by target and indexed buffers by target and index.
+        std::unordered_map<std::uint64_t, std::uint32_t> m_Textures;
+        std::unordered_map<std::uint32_t, std::uint32_t> m_Samplers;
+        std::unordered_map<std::uint32_t, std::uint32_t> m_Buffers;
+        std::unordered_map<std::uint64_t, Values4> m_IndexedBuffers;
+        std::unordered_map<std::uint32_t, bool> m_Capabilities;
+
+        Cached<std::uint32_t> m_DepthFunc;
+        Cached<bool> m_DepthMask;
+        Cached<std::uint32_t> m_CullFace;
+        Cached<std::uint32_t> m_FrontFace;
+        Cached<Values4> m_BlendFunc;
+        Cached<Values4> m_BlendEquation;
+        Cached<Values4> m_StencilFunc[2];
+        Cached<Values4> m_StencilOp[2];
+        Cached<std::uint32_t> m_StencilMask;
+        Cached<Values4> m_Viewport;
+        Cached<Values4> m_Scissor;
+        Cached<ClearValue> m_ClearColor;
+    };
+}
@@ -99,6 +99,17 @@ namespace blurp
          */
         glm::vec3 GetScale() const;
 
+        /**
+         * Returns true if this transform changed since the last call to ClearChanged().
+         * A new transform counts as changed.
+         */
+        bool HasChanged() const;
+
+        /**
+         * Clear the changed flag, after the owner has processed the current transformation.
+         */
+        void ClearChanged();
+
         /**
          * Get the forward direction of this matrix.
          */
@@ -170,5 +181,8 @@ namespace blurp
 
         mutable glm::mat4 m_Transformation;
         mutable bool m_Flag;
+
+        //Set by every change, and only cleared by ClearChanged(). Unlike m_Flag, rebuilding the matrix does not reset it.
+        bool m_Changed;
     };
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace blurp
+{
+    /*
+     * The instruction sets that TransformStore can compose matrices with.
+     */
+    enum class TransformKernel
+    {
+        SCALAR,
+        SSE,
+        AVX
+    };
+
+    /*
+     * TransformStore keeps the translation, rotation and scale of many transforms in separate contiguous arrays (structure of arrays).
+     * Every component (x, y, z, w) is stored in its own array, so that a SIMD register can hold the same component for multiple transforms.
+     *
+     * Changing a transform marks it dirty. Compose() then builds the matrices for all dirty transforms in one batch,
+     * writing them straight into an array provided by the caller. Transforms that did not change are skipped.
+     *
+     * Transforms are identified by an index that stays the same until the transform is removed. Removed indices are reused.
+     */
+    class TransformStore
+    {
+    public:
+        TransformStore();
+
+        /*
+         * Add a transform and return its index.
+         * The transform starts out dirty.
+         */
+        std::uint32_t Add(const glm::vec3& a_Translation = glm::vec3(0.f), const glm::quat& a_Rotation = glm::quat(1.f, 0.f, 0.f, 0.f), const glm::vec3& a_Scale = glm::vec3(1.f));
+
+        /*
+         * Remove the transform at the given index. The index may be returned by a later call to Add().
+         */
+        void Remove(std::uint32_t a_Index);
+
+        /*
+         * Allocate memory for the given amount of transforms.
+         */
+        void Reserve(std::uint32_t a_Capacity);
+
+        /*
+         * Remove all transforms.
+         */
+        void Clear();
+
+        /*
+         * Set the translation, rotation or scale of a transform.
+         */
+        void SetTranslation(std::uint32_t a_Index, const glm::vec3& a_Translation);
+        void SetRotation(std::uint32_t a_Index, const glm::quat& a_Rotation);
+        void SetScale(std::uint32_t a_Index, const glm::vec3& a_Scale);
+
+        /*
+         * Translate, rotate or scale a transform relative to its current state.
+         * These behave the same as the functions with the same name in Transform.
+         */
+        void Translate(std::uint32_t a_Index, const glm::vec3& a_Translation);
+        void Rotate(std::uint32_t a_Index, const glm::quat& a_Rotation);
+        void Scale(std::uint32_t a_Index, const glm::vec3& a_Scale);
+
+        /*
+         * Get the translation, rotation or scale of a transform.
+         */
+        glm::vec3 GetTranslation(std::uint32_t a_Index) const;
+        glm::quat GetRotation(std::uint32_t a_Index) const;
+        glm::vec3 GetScale(std::uint32_t a_Index) const;
+
+        /*
+         * Returns true if the transform at the given index changed since the last call to Compose().
+         */
+        bool IsDirty(std::uint32_t a_Index) const;
+
+        /*
+         * Mark every transform as dirty, for example when the output array was reallocated.
+         */
+        void MarkAllDirty();
+
+        /*
+         * Get the amount of indices in use, including removed ones that have not been reused yet.
+         * Arrays passed to Compose() need to be at least this large.
+         */
+        std::uint32_t GetSize() const;
+
+        /*
+         * Get the amount of transforms in this store.
+         */
+        std::uint32_t GetCount() const;
+
+        /*
+         * Build the matrices for all dirty transforms and clear their dirty flag.
+         * a_Transforms[i] receives translation * rotation * scale for the transform at index i.
+         * If a_NormalMatrices is not nullptr, a_NormalMatrices[i] receives the inverse transpose of the upper 3x3 matrix.
+         * Entries of transforms that are not dirty are not touched.
+         *
+         * If the requested kernel is not available, the best available kernel is used instead.
+         * Returns the amount of matrices that were built.
+         */
+        std::uint32_t Compose(glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices = nullptr, TransformKernel a_Kernel = GetBestKernel());
+
+        /*
+         * Returns true if the given kernel was compiled in.
+         */
+        static bool IsKernelSupported(TransformKernel a_Kernel);
+
+        /*
+         * Get the fastest kernel that was compiled in.
+         */
+        static TransformKernel GetBestKernel();
+
+    private:
+        //Compose the transforms in [a_Start, a_End) with each kernel.
+        std::uint32_t ComposeScalar(std::uint32_t a_Start, std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices);
+        std::uint32_t ComposeSSE(std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices);
+        std::uint32_t ComposeAVX(std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices);
+
+        //Grow the arrays so that a_Size transforms fit, keeping the size a multiple of the widest SIMD register.
+        void Resize(std::uint32_t a_Size);
+
+    private:
+        //Translation, rotation and scale, one array per component.
+        std::vector<float> m_TranslationX, m_TranslationY, m_TranslationZ;
+        std::vector<float> m_RotationX, m_RotationY, m_RotationZ, m_RotationW;
+        std::vector<float> m_ScaleX, m_ScaleY, m_ScaleZ;
+
+        //1 for transforms that need to be composed, 0 otherwise. Removed and padding entries are never dirty.
+        std::vector<std::uint8_t> m_Dirty;
+
+        //Indices of removed transforms that can be reused.
+        std::vector<std::uint32_t> m_FreeIndices;
+
+        //Amount of indices in use.
+        std::uint32_t m_Size;
+    };
+}
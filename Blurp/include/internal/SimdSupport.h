@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+ * Instruction sets that SIMD code paths can use.
+ * These are selected at compile time, based on the instruction sets the compiler is allowed to use.
+ *
+ * BLURP_SIMD_SSE is defined when SSE2 is available (always on x64).
+ * BLURP_SIMD_AVX is defined when AVX is available (/arch:AVX or -mavx).
+ */
+#if defined(__AVX__)
+#define BLURP_SIMD_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLURP_SIMD_SSE
+#endif
+
+#if defined(BLURP_SIMD_SSE) || defined(BLURP_SIMD_AVX)
+#include <immintrin.h>
+#endif
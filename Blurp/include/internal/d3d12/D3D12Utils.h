@@ -150,6 +150,6 @@ inline DXGI_FORMAT ToD3D12(blurp::PixelFormat a_Format, blurp::DataType a_Type)
     break;
     }
 
-    throw std::exception("Error: Could not convert pixel format and data type to sized OpenGL type.");
+    throw std::runtime_error("Error: Could not convert pixel format and data type to sized OpenGL type.");
     //return 0;
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+#include "MaterialBatch.h"
+
+namespace blurp
+{
+    /*
+     * MaterialBatch that keeps the packed constant data of its materials in CPU memory.
+     * Textures are stored in an array texture created through the resource manager, like in the OpenGL implementation.
+     */
+    class MaterialBatch_Null : public MaterialBatch
+    {
+    public:
+        explicit MaterialBatch_Null(const MaterialBatchSettings& a_Settings) : MaterialBatch(a_Settings) {}
+
+        bool HasConstantData() const
+        {
+            return !m_ConstantData.empty();
+        }
+
+        /*
+         * Get the constant data of every material, padded following the std140 layout rules.
+         */
+        const std::vector<float>& GetConstantData() const
+        {
+            return m_ConstantData;
+        }
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    private:
+        std::vector<float> m_ConstantData;
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+
+#include "Mesh.h"
+
+namespace blurp
+{
+    /*
+     * Mesh that keeps copies of its vertex and index data in CPU memory.
+     * Attribute locations are assigned the same way as in the OpenGL implementation, so shaders get the same definitions.
+     */
+    class Mesh_Null : public Mesh
+    {
+    public:
+        Mesh_Null(const MeshSettings& a_Settings) : Mesh(a_Settings), m_NumIndices(0) {}
+
+        /*
+         * Get the number of indices for this mesh.
+         */
+        std::uint32_t GetNumIndices() const;
+
+        /*
+         * Get the copied vertex data.
+         */
+        const std::vector<std::uint8_t>& GetVertexData() const;
+
+        /*
+         * Get the copied index data.
+         */
+        const std::vector<std::uint8_t>& GetIndexData() const;
+
+        /*
+         * Get the attribute location defines for the current mask.
+         */
+        const std::vector<std::string>& GetAttribLocations() const;
+
+        /*
+         * Get a reference to the vector containing instance divisors used by this mesh.
+         * The pairs in the vector are laid out by <index, divisor>.
+         */
+        const std::vector<std::pair<std::uint32_t, std::uint32_t>>& GetInstanceDivisors() const;
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    private:
+        std::uint32_t m_NumIndices;
+        std::vector<std::uint8_t> m_VertexData;
+        std::vector<std::uint8_t> m_IndexData;
+
+        //Shader compiling flags to set the right layout index per attribute.
+        std::vector<std::string> m_VertexPosDefines;
+
+        //Pairs of <index, divisor> for instancing.
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> m_InstancedVertexAttributes;
+    };
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "RenderPass_Clear.h"
+
+namespace blurp
+{
+    class RenderPass_Clear_Null : public RenderPass_Clear
+    {
+    public:
+        explicit RenderPass_Clear_Null(RenderPipeline& a_Pipeline)
+            : RenderPass_Clear(a_Pipeline)
+        {
+        }
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+        void Submit() override;
+    };
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "RenderPass_Forward.h"
+#include "ShaderCache.h"
+
+namespace blurp
+{
+    class RenderPass_Forward_Null : public RenderPass_Forward
+    {
+    public:
+        RenderPass_Forward_Null(RenderPipeline& a_Pipeline)
+            : RenderPass_Forward(a_Pipeline)
+        {
+        }
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+        void Submit() override;
+        std::shared_ptr<Shader> GetShader(std::uint64_t a_Mask, const Mesh& a_Mesh) override;
+
+    private:
+        //Shader cache that creates shaders dynamically based on required attributes.
+        ShaderCache<std::uint64_t, std::uint64_t> m_ShaderCache;
+    };
+}
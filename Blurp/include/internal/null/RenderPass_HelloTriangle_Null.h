@@ -0,0 +1,20 @@
+#pragma once
+#include "RenderPass_HelloTriangle.h"
+#include "Shader.h"
+
+namespace blurp
+{
+    class RenderPass_HelloTriangle_Null : public RenderPass_HelloTriangle
+    {
+    public:
+        RenderPass_HelloTriangle_Null(RenderPipeline& a_Pipeline) : RenderPass_HelloTriangle(a_Pipeline) {}
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+        void Submit() override;
+
+    private:
+        std::shared_ptr<Shader> m_Shader;
+    };
+}
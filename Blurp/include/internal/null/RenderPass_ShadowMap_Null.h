@@ -0,0 +1,32 @@
+#pragma once
+#include "RenderPass_ShadowMap.h"
+#include "ShaderCache.h"
+
+namespace blurp
+{
+    class RenderPass_ShadowMap_Null : public RenderPass_ShadowMap
+    {
+    public:
+        explicit RenderPass_ShadowMap_Null(RenderPipeline& a_Pipeline) : RenderPass_ShadowMap(a_Pipeline)
+        {
+        }
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+        void Submit() override;
+
+        std::shared_ptr<Shader> GetShader(std::uint32_t a_Mask, const Mesh& a_Mesh) override;
+        void BindDepthTarget(const Texture& a_Texture) override;
+        void UploadLightData(const void* a_Data, std::uint32_t a_Size) override;
+        void UploadLightIndices(const std::int32_t* a_Data, std::uint32_t a_Count) override;
+        void CopyDepthLayer(const Texture& a_Source, const Texture& a_Destination, std::uint32_t a_Layer) override;
+        void OnBufferWritten(const GpuBuffer& a_Buffer, const void* a_Data, std::uint32_t a_Size) override;
+
+    private:
+        //Stand in for the UBOs of the OpenGL pass. The light data is used for both pos and dir lights.
+        std::vector<char> m_LightUbo;
+        std::vector<std::int32_t> m_LightIndicesUbo;
+        ShaderCache<std::uint32_t, std::uint32_t> m_ShaderCache;
+    };
+}
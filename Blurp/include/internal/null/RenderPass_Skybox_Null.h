@@ -0,0 +1,23 @@
+#pragma once
+#include "RenderPass_Skybox.h"
+#include "Shader.h"
+
+namespace blurp
+{
+    class RenderPass_Skybox_Null : public RenderPass_Skybox
+    {
+    public:
+        explicit RenderPass_Skybox_Null(RenderPipeline& a_Pipeline)
+            : RenderPass_Skybox(a_Pipeline)
+        {
+        }
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+        void Submit() override;
+
+    private:
+        std::shared_ptr<Shader> m_Shader;
+    };
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include "RenderTarget.h"
+
+namespace blurp
+{
+    class CommandRecording;
+
+    class RenderTarget_Null : public RenderTarget
+    {
+        friend class SwapChain_Null;
+    public:
+        /*
+         * Create a render target that stands in for the buffers of a swap chain.
+         * Attachments can not be set, so whether it has color, depth and stencil is passed instead.
+         */
+        RenderTarget_Null(const RenderTargetSettings& a_Settings, bool a_HasDepth, bool a_HasStencil, bool a_HasColor) : RenderTarget(a_Settings),
+            m_IsSwapChainTarget(true), m_HasDefaultColor(a_HasColor), m_HasDefaultDepth(a_HasDepth), m_HasDefaultStencil(a_HasStencil)
+        {
+            m_NumColorAttachments = 0;
+        }
+
+        RenderTarget_Null(const RenderTargetSettings& a_Settings) : RenderTarget(a_Settings), m_IsSwapChainTarget(false), m_HasDefaultColor(false), m_HasDefaultDepth(false), m_HasDefaultStencil(false)
+        {
+            m_NumColorAttachments = 0;
+        }
+
+        /*
+         * Record binding this render target and setting its viewport.
+         */
+        void Bind(CommandRecording& a_Recording);
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    public:
+        glm::vec4 GetClearColor() override;
+        void SetClearColor(const glm::vec4& a_ClearColor) override;
+        glm::vec4 GetViewPort() override;
+        void SetViewPort(const glm::vec<4, std::uint32_t>& a_ViewPort) override;
+        glm::vec4 GetScissorRect() override;
+        void SetScissorRect(const glm::vec<4, std::uint32_t>& a_ScissorRect) override;
+        void OnColorAttachmentBound(std::uint16_t a_Slot, const std::shared_ptr<Texture>& a_Added) override;
+        void OnDepthStencilAttachmentBound(const std::shared_ptr<Texture>& a_Added) override;
+
+        //Overridden because swap chain targets have their attachments built in.
+        bool HasColorAttachment() const override;
+        bool HasDepthAttachment() const override;
+        bool HasStencilAttachment() const override;
+
+    private:
+        //The following only applies to swap chain targets.
+        bool m_IsSwapChainTarget;
+        bool m_HasDefaultColor;
+        bool m_HasDefaultDepth;
+        bool m_HasDefaultStencil;
+
+        glm::vec4 m_ClearColor;
+        glm::vec4 m_ViewPort;
+        glm::vec4 m_ScissorRect;
+    };
+}
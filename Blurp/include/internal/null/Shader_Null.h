@@ -0,0 +1,26 @@
+#pragma once
+#include "Shader.h"
+
+namespace blurp
+{
+    /*
+     * Shader that is never compiled. The size of its source is kept, so that it is visible which shaders would have been compiled.
+     */
+    class Shader_Null : public Shader
+    {
+    public:
+        Shader_Null(const ShaderSettings& a_Settings) : Shader(a_Settings), m_SourceSize(0) {}
+
+        /*
+         * Get the total amount of characters in the source of every stage of this shader.
+         */
+        std::size_t GetSourceSize() const;
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    private:
+        std::size_t m_SourceSize;
+    };
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "SwapChain.h"
+
+#include "RenderTarget_Null.h"
+
+namespace blurp
+{
+    /*
+     * Swap chain without a window surface. Presenting only counts the frames.
+     */
+    class SwapChain_Null : public SwapChain
+    {
+    public:
+        SwapChain_Null(const SwapChainSettings& a_Settings) : SwapChain(a_Settings), m_PresentCount(0)
+        {
+        }
+
+        void Resize(const glm::vec2& a_Dimensions, bool a_FullScreen) override;
+
+        std::uint16_t GetNumBuffers() override;
+
+        std::shared_ptr<RenderTarget> GetRenderTarget() override;
+
+        void Present() override;
+
+        /*
+         * Get the amount of times Present was called.
+         */
+        std::uint64_t GetPresentCount() const;
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    private:
+        std::shared_ptr<RenderTarget_Null> m_RenderTarget;
+        std::uint64_t m_PresentCount;
+    };
+}
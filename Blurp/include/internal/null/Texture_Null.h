@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+
+#include "Texture.h"
+
+namespace blurp
+{
+    /*
+     * Texture that keeps its pixels in CPU memory.
+     * Storage is only allocated when data is provided on creation, so that large render textures such as shadow maps cost no memory.
+     * Pixels of textures without storage read as zero.
+     */
+    class Texture_Null : public Texture
+    {
+    public:
+        Texture_Null(const TextureSettings& a_Settings) : Texture(a_Settings), m_TexelSize(0) {}
+
+        /*
+         * Get the amount of texels in the base level of this texture. Every layer and cube face is counted.
+         */
+        std::uint64_t GetTexelCount() const;
+
+        /*
+         * Set every texel in the region to a_Value, which points to a single texel in the format of this texture.
+         * Nothing is stored for textures without storage.
+         */
+        void Clear(const glm::vec<3, std::uint32_t>& a_Offset, const glm::vec<3, std::uint32_t>& a_Size, const void* a_Value);
+
+        std::unique_ptr<std::uint8_t[]> GetPixels(const glm::vec3& a_Start, const glm::vec3& a_Size, int a_Channels) override;
+
+    protected:
+        bool OnLoad(BlurpEngine& a_BlurpEngine) override;
+        bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
+
+    private:
+        //Get the amount of layers of the base level, with six layers per cube map.
+        std::uint32_t GetLayerCount() const;
+
+        //Get the amount of channels of the pixel format.
+        std::uint32_t GetChannelCount() const;
+
+    private:
+        std::uint32_t m_TexelSize;
+        std::vector<std::uint8_t> m_Data;
+    };
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "CommandList.h"
+
+namespace blurp
+{
+    class StateTracker;
+
+    /*
+     * Replays command lists with OpenGL. Bindings and pipeline state go through a StateTracker, so calls that change nothing are left out.
+     */
+    class CommandListBackend_GL : public CommandListBackend
+    {
+    public:
+        /*
+         * Create a backend that sets state through a_StateTracker. The tracker has to outlive the backend.
+         */
+        CommandListBackend_GL(StateTracker& a_StateTracker) : m_StateTracker(a_StateTracker) {}
+
+        void SetPipelineState(const PipelineState& a_State) override;
+        void BindShader(const Shader& a_Shader) override;
+        void BindTexture(std::uint32_t a_Slot, const Texture& a_Texture) override;
+        void BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size) override;
+        void BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch) override;
+        void BindMesh(const Mesh& a_Mesh) override;
+        void SetUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data) override;
+        void Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount) override;
+
+    private:
+        StateTracker& m_StateTracker;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "Settings.h"
 #include <GL/glew.h>
+#include <stdexcept>
 
 namespace blurp
 {
@@ -263,7 +264,7 @@ namespace blurp
             break;
         }
 
-        throw std::exception("Error: Could not convert pixel format and data type to sized OpenGL type.");
+        throw std::runtime_error("Error: Could not convert pixel format and data type to sized OpenGL type.");
         return 0;
     }
 }
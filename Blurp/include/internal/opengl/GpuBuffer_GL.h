@@ -1,10 +1,30 @@
 #pragma once
 #include <GL/glew.h>
 
+#include <deque>
+
 #include "GpuBuffer.h"
+#include "RingBufferAllocator.h"
 
 namespace blurp
 {
+    /*
+     * Ring buffer fences implemented with OpenGL sync objects.
+     */
+    class RingBufferFence_GL : public RingBufferFence
+    {
+    public:
+        ~RingBufferFence_GL() override;
+
+        void Insert(std::uint64_t a_FrameId) override;
+        bool IsComplete(std::uint64_t a_FrameId) override;
+        void Wait(std::uint64_t a_FrameId) override;
+
+    private:
+        //Sync objects ordered from oldest to newest.
+        std::deque<std::pair<std::uint64_t, GLsync>> m_Fences;
+    };
+
     class GpuBuffer_GL : public GpuBuffer
     {
     public:
@@ -19,14 +39,47 @@ namespace blurp
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
 
         GpuBufferView OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, std::uint32_t a_PerDataSize, const void* a_Data) override;
+        char* OnBeginWrite(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment, std::uintptr_t& a_Start) override;
+        void OnEndWrite() override;
 
     public:
 
         bool Resize(std::uint32_t a_Size, bool a_CopyData = true) override;
+        void BeginFrame() override;
         GpuBufferView WriteData(std::uint32_t a_Offset, const PerInstanceUploadData& a_UploadData) override;
         GpuBufferView WriteData(std::uint32_t a_Offset, const GlobalUploadData& a_UploadData) override;
         GpuBufferView WriteData(std::uint32_t a_Offset, const LightUploadData& a_UploadData) override;
+
+    private:
+        /*
+         * Create a buffer object of the given size.
+         * Ring buffers get immutable storage which is persistently mapped into m_MappedData.
+         */
+        GLuint CreateStorage(std::uint32_t a_Size);
+
+        /*
+         * Find the aligned start for a_Size bytes of data written at a_Offset.
+         * Regular buffers grow when full if enabled. Ring buffers ignore a_Offset and sub-allocate instead.
+         */
+        std::uintptr_t Reserve(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment);
+
+        /*
+         * Copy data into the buffer at the given position.
+         */
+        void Upload(std::uintptr_t a_Start, std::uintptr_t a_Size, const void* a_Data);
+
     private:
         GLuint m_Ssbo;
+
+        //Offsets used to bind ranges of this buffer have to be a multiple of this.
+        GLint m_BindAlignment;
+
+        //Persistent ring buffer state. The mapped pointer is only valid for ring buffers.
+        char* m_MappedData;
+        RingBufferFence_GL m_RingFence;
+
+        //True while a range of a regular buffer is mapped for a GpuBufferWriter.
+        bool m_RangeMapped;
+        std::unique_ptr<RingBufferAllocator> m_RingAllocator;
     };
 }
\ No newline at end of file
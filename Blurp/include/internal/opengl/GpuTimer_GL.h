@@ -0,0 +1,77 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+
+#include "Profiler.h"
+
+namespace blurp
+{
+    /*
+     * Measures GPU ranges with OpenGL timestamp queries.
+     *
+     * The queries of a frame are kept until their results are available, which is usually a frame or two later.
+     * Queries are reused once they are resolved. Only when the GPU is more than FRAME_LATENCY frames behind does BeginFrame wait for the oldest results.
+     */
+    class GpuTimer_GL : public GpuTimer
+    {
+    public:
+        GpuTimer_GL();
+
+        void BeginFrame(Profiler& a_Profiler) override;
+        void Begin(const char* a_Name) override;
+        void End() override;
+
+        /*
+         * Delete every query. Has to be called while the OpenGL context still exists.
+         */
+        void Destroy();
+
+    private:
+        //The amount of frames that queries are kept for before waiting on their results.
+        static constexpr std::uint32_t FRAME_LATENCY = 4;
+
+        struct Range
+        {
+            const char* name;
+            std::uint32_t begin;
+            std::uint32_t end;
+        };
+
+        //The queries of a single frame.
+        struct FrameQueries
+        {
+            FrameQueries() : frame(0), gpuReference(0), cpuReference(0.0), usedQueries(0) {}
+
+            std::uint64_t frame;
+
+            //The GPU and profiler time at the start of the frame, used to convert timestamps to the profiler clock.
+            std::int64_t gpuReference;
+            double cpuReference;
+
+            std::vector<Range> ranges;
+
+            //Queries owned by this frame. The first usedQueries of them are in use.
+            std::vector<std::uint32_t> queries;
+            std::uint32_t usedQueries;
+        };
+
+        /*
+         * Give the results of a_Frame to the profiler, and free its queries.
+         * When a_Wait is false nothing happens unless every result is available. Returns true when the frame has no more pending queries.
+         */
+        bool Resolve(FrameQueries& a_Frame, bool a_Wait);
+
+        /*
+         * Get an unused query of the current frame, which is created when the frame has none left.
+         */
+        std::uint32_t NextQuery();
+
+    private:
+        FrameQueries m_Frames[FRAME_LATENCY];
+        std::uint32_t m_Current;
+
+        //The profiler that results are given to. Nullptr before the first frame.
+        Profiler* m_Profiler;
+        bool m_InRange;
+    };
+}
@@ -14,7 +14,7 @@ namespace blurp
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
-        void Execute() override;
+        void Submit() override;
 
     };
 }
\ No newline at end of file
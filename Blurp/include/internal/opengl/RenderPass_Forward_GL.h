@@ -6,45 +6,21 @@
 #include "ShaderCache.h"
 #include <stdint.h>
 
-//Maximum amount of lights that will fit in the GPU buffer. 65KB for UBO, which will fit about 580 tightly packed structs of LightDataPacked.
-#define MAX_LIGHTS 580
-
 namespace blurp
 {
-    struct StaticData
-    {
-        glm::mat4 pv;                            //Projection * View matrix for the camera.
-        glm::vec4 camPosFarPlane;               //XYZ = camera position. W = far plane distance.
-        glm::vec4 numLightsNumCascades;        //X = numPointLight. Y = numSpotLights. Z = numDirectionalLights.    W = number of dir shadow cascades.
-        glm::vec4 numShadows;                 //X = numPointShadows. Y = numSpotShadows. Z = numDirectionalShadows.
-        glm::vec4 ambientLight;              //The ambient light RGB.
-    };
-
-    /*
-     * Struct that is laid out to comply with UBO rules with correct padding and alignment.
-     * Enough data is present to contain any light type.
-     *
-     * Depending on the light type, the GPU will interpret these values differently.
-     */
-    struct LightDataPacked
-    {
-        glm::vec4 vec1;
-        glm::vec4 vec2;
-        glm::vec4 vec3;
-    };
-
     class RenderPass_Forward_GL : public RenderPass_Forward
     {
     public:
         RenderPass_Forward_GL(RenderPipeline& a_Pipeline)
-            : RenderPass_Forward(a_Pipeline), m_StaticDataUbo(0), m_LightUbo(0), m_ShadowSampler(0)
+            : RenderPass_Forward(a_Pipeline), m_StaticDataUbo(0), m_ShadowSampler(0)
         {
         }
 
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
-        void Execute() override;
+        void Submit() override;
+        std::shared_ptr<Shader> GetShader(std::uint64_t a_Mask, const Mesh& a_Mesh) override;
 
     private:
         //Shader cache that compiles shaders dynamically based on required attributes.
@@ -53,9 +29,6 @@ namespace blurp
         //UBO used to upload data that is persistent for the entire frame. For example: camera matrices and light amount.
         GLuint m_StaticDataUbo;
 
-        //UBOs used for light uploading and light transforming.
-        GLuint m_LightUbo;
-
         //Shadow sampler objects with texture comparisons enabled.
         GLuint m_ShadowSampler;
     };
@@ -59,7 +59,7 @@ namespace blurp
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
-        void Execute() override;
+        void Submit() override;
 
     private:
         GLuint m_Vbo, m_Vao, m_ColorUniformId;
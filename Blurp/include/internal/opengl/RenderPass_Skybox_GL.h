@@ -15,7 +15,7 @@ namespace blurp
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
-        void Execute() override;
+        void Submit() override;
 
     private:
         std::shared_ptr<Shader_GL> m_Shader;
@@ -1,13 +1,23 @@
 #pragma once
 #include "RenderPipeline.h"
+#include "opengl/CommandListBackend_GL.h"
+#include "opengl/GpuTimer_GL.h"
 #include "ResourceLock.h"
+#include "StateTracker.h"
+#include "opengl/StateTrackerBackend_GL.h"
 
 namespace blurp
 {
 	class RenderPipeline_GL : public RenderPipeline
 	{
 	public:
-        RenderPipeline_GL(const PipelineSettings& a_Settings, BlurpEngine& a_Engine, RenderDevice& a_Device) : RenderPipeline(a_Settings, a_Engine, a_Device) {}
+        RenderPipeline_GL(const PipelineSettings& a_Settings, BlurpEngine& a_Engine, RenderDevice& a_Device) : RenderPipeline(a_Settings, a_Engine, a_Device), m_StateTracker(m_StateBackend), m_CommandListBackend(m_StateTracker) {}
+
+        /*
+         * Get the tracker that the passes in this pipeline set OpenGL state through.
+         * It is invalidated before every execution, because anything outside of the pipeline may have changed the state.
+         */
+        StateTracker& GetStateTracker();
 
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
@@ -15,9 +25,17 @@ namespace blurp
 
     public:
         bool HasFinishedExecuting() override;
+        CommandListBackend& GetCommandListBackend() override;
 
     protected:
         void PreExecute() override;
         void PostExecute() override;
+        GpuTimer* GetGpuTimer() override;
+
+    private:
+        StateTrackerBackend_GL m_StateBackend;
+        StateTracker m_StateTracker;
+        CommandListBackend_GL m_CommandListBackend;
+        GpuTimer_GL m_GpuTimer;
 	};
 }
\ No newline at end of file
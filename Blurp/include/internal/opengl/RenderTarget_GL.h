@@ -6,6 +6,8 @@
 
 namespace blurp
 {
+    class StateTracker;
+
     class RenderTarget_GL : public RenderTarget
     {
         friend class SwapChain_GL_Win32;
@@ -38,9 +40,9 @@ namespace blurp
         bool IsDefaultGlTarget() const;
 
         /*
-         * Bind the framebuffer as render target to the OpenGL state.
+         * Bind the framebuffer as render target through a_State, and set its viewport, scissor rect and clear color.
          */
-        void Bind();
+        void Bind(StateTracker& a_State);
 
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
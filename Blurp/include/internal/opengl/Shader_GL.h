@@ -2,28 +2,57 @@
 #include <GL/glew.h>
 
 #include "Shader.h"
+#include "ShaderBinaryCache.h"
 
 namespace blurp
 {
-    class Shader_GL : public Shader
+    class Shader_GL : public Shader, private ShaderBinaryBackend
     {
     public:
-        Shader_GL(const ShaderSettings& a_Settings) : Shader(a_Settings), m_Program(0) {}
+        Shader_GL(const ShaderSettings& a_Settings) : Shader(a_Settings), m_Program(0), m_Deferred(false), m_BinaryCache(nullptr), m_BinaryKey(0) {}
 
         /*
          * Get the shader program ID for this shader.
          */
         GLuint GetProgramId() const;
 
+        /*
+         * Returns true when the driver finished compiling and linking the program.
+         * The compile and link results of programs compiled in the background are checked here.
+         */
+        bool IsReady() override;
+
     protected:
         bool OnLoad(BlurpEngine& a_BlurpEngine) override;
         bool OnDestroy(BlurpEngine& a_BlurpEngine) override;
 
     private:
+        bool LoadBinary(std::uint32_t a_Format, const std::vector<char>& a_Data) override;
+        bool Compile(std::uint32_t& a_Format, std::vector<char>& a_Data) override;
+
+        /*
+         * Compile and link the program from the source in the settings.
+         * When compiling in the background, this returns before the driver is done and the results are checked by FinishProgram.
+         */
+        bool CompileProgram();
+
+        /*
+         * Check the results of a program compiled in the background, and store its binary in the binary cache.
+         */
+        void FinishProgram();
+
         bool CompileShader(GLuint a_ShaderId, const char** a_Src, std::size_t a_Size);
         void FindVersionIndices(const char* a_Src, bool& a_HasVersion, const char*& a_SrcStart, const char*& a_VersionStart, std::uint16_t& a_VersionSize) const;
 
     private:
         GLuint m_Program;
+
+        //Set while the driver is compiling the program in the background. The stages are kept to check their results afterwards.
+        bool m_Deferred;
+        std::vector<GLuint> m_DeferredStages;
+
+        //Where the binary of a program compiled in the background is stored once it is done.
+        ShaderBinaryCache* m_BinaryCache;
+        std::uint64_t m_BinaryKey;
     };
 }
\ No newline at end of file
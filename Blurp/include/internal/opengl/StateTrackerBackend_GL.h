@@ -0,0 +1,35 @@
+#pragma once
+#include "StateTracker.h"
+
+namespace blurp
+{
+    /*
+     * Sends the calls of a StateTracker to OpenGL.
+     */
+    class StateTrackerBackend_GL : public StateTrackerBackend
+    {
+    public:
+        void UseProgram(std::uint32_t a_Program) override;
+        void BindVertexArray(std::uint32_t a_VertexArray) override;
+        void ActiveTexture(std::uint32_t a_Unit) override;
+        void BindTexture(std::uint32_t a_Target, std::uint32_t a_Texture) override;
+        void BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler) override;
+        void BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer) override;
+        void BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer) override;
+        void BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size) override;
+        void BindFramebuffer(std::uint32_t a_Framebuffer) override;
+        void SetEnabled(std::uint32_t a_Capability, bool a_Enabled) override;
+        void DepthFunc(std::uint32_t a_Function) override;
+        void DepthMask(bool a_Write) override;
+        void CullFace(std::uint32_t a_Face) override;
+        void FrontFace(std::uint32_t a_WindingOrder) override;
+        void BlendFuncSeparate(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha) override;
+        void BlendEquationSeparate(std::uint32_t a_Rgb, std::uint32_t a_Alpha) override;
+        void StencilFuncSeparate(StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask) override;
+        void StencilOpSeparate(StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass) override;
+        void StencilMask(std::uint32_t a_Mask) override;
+        void Viewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) override;
+        void Scissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) override;
+        void ClearColor(float a_R, float a_G, float a_B, float a_A) override;
+    };
+}
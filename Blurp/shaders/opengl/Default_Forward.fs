@@ -1,7 +1,6 @@
 #version 460 core
 
 #define MAX_MATERIAL_BATCH_SIZE 512
-#define MAX_LIGHTS 580
 
 //Functions for PBR shading.
 vec3 LightReflected(vec3 toLightDir, vec3 toCameraDir, vec3 surfaceNormal, vec3 f0, vec3 lightColor, float lightDistance, float metallic, float roughness, vec3 diffuse);
@@ -10,6 +9,11 @@ float GeometrySchlickGGX(float sNormalToCamDot, float roughness);
 float GeometrySmith(vec3 surfaceNormal, vec3 toCameraDir, vec3 toLightDir, float roughness);
 vec3 FresnelSchlick(float cosTheta, vec3 f0);
 
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+//Find the light cluster that contains the current fragment.
+uint FindCluster();
+#endif
+
 in VERTEX_OUT
 {
     //Vertex position in world space without the projection applied.
@@ -33,6 +37,13 @@ in VERTEX_OUT
 	float fragDepth;
 #endif
 
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+    //Clip space position used to find the light cluster.
+    vec4 clipPosition;
+    flat vec3 clusterCounts;
+    flat vec2 clusterDepth;
+#endif
+
     //Material ID in the material batch.
 	#ifdef VA_MATERIALID_DEF
 	flat int materialID;
@@ -174,6 +185,20 @@ layout(location = 5) uniform float alphaConstant;
     {
         DirectionalLightData dirLightData[];
     };
+
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+	//One cell per cluster. X = offset into the light indices. Y = point light count. Z = spot light count.
+	layout(std430, binding = 8) buffer LightClusterCells
+    {
+        uvec4 clusterCells[];
+    };
+
+	//Indices into the point and spot light arrays. The point lights of a cluster come before its spot lights.
+	layout(std430, binding = 9) buffer LightClusterIndices
+    {
+        uint clusterLightIndices[];
+    };
+#endif
 //END LIGHT DATA
 
 
@@ -442,6 +467,90 @@ void main()
     vec3 ambientColor = inData.ambientLight * diffuseVec3;
 
 #if defined(VA_NORMAL_DEF)
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+	//Only the point and spot lights that reach the cluster of this fragment are used.
+	uvec4 cluster = clusterCells[FindCluster()];
+
+	//Point lights. Lights with shadows are stored after the ones without.
+	for(uint c = 0; c < cluster.y; ++c)
+	{
+		int i = int(clusterLightIndices[cluster.x + c]);
+		PointLightData data = pointLightData[i];
+
+		//PBR shading
+		vec3 lightColor = data.colorIntensity.xyz * data.colorIntensity.w;
+		vec3 toLightDir = data.positionShadowMapIndex.xyz - inData.fragPos.xyz;
+        float lightDistance = length(toLightDir);
+        toLightDir /= lightDistance;
+
+		float visibility = 1.0;
+
+	#ifdef USE_POS_SHADOWS_DEFINE
+		//Index into shadow map and check for shadow.
+		if(i >= int(inData.numLights.x))
+		{
+			vec4 shadowCoord = vec4(-toLightDir, data.positionShadowMapIndex.w);
+			visibility = texture(shadowSamplerCube, shadowCoord, lightDistance / inData.farPlane);
+		}
+	#else
+		//Lights with shadows are skipped when no shadow maps are bound.
+		if(i >= int(inData.numLights.x))
+		{
+			continue;
+		}
+	#endif
+
+		if(visibility > 0.0)
+		{
+			reflectedLight += LightReflected(toLightDir, toCameraDir, surfaceNormal, f0, lightColor, lightDistance, metallic, roughness, diffuseVec3);
+		}
+	}
+
+	//Spot lights.
+	for(uint c = 0; c < cluster.z; ++c)
+	{
+		int i = int(clusterLightIndices[cluster.x + cluster.y + c]);
+		SpotLightData data = spotLightData[i];
+
+		//PBR shading
+		vec3 spotLightDirection = data.directionAngle.xyz;
+		vec3 lightColor = data.colorIntensity.xyz * data.colorIntensity.w;
+		vec3 toLightDir = data.positionShadowMapIndex.xyz - inData.fragPos.xyz;
+		vec3 lightDir = -toLightDir;
+        float lightDistance = length(toLightDir);
+        toLightDir /= lightDistance;
+
+		//Ensure that the position is within the angle.
+		float angle = acos(dot(-toLightDir, spotLightDirection));
+		if (angle > data.directionAngle.w)
+		{
+			continue;
+		}
+
+		float visibility = 1.0;
+
+	#ifdef USE_POS_SHADOWS_DEFINE
+		//Index into shadow map and check for shadow.
+		if(i >= int(inData.numLights.y))
+		{
+			vec4 shadowCoord = vec4(lightDir, data.positionShadowMapIndex.w);
+			visibility = texture(shadowSamplerCube, shadowCoord, lightDistance / inData.farPlane);
+		}
+	#else
+		//Lights with shadows are skipped when no shadow maps are bound.
+		if(i >= int(inData.numLights.y))
+		{
+			continue;
+		}
+	#endif
+
+		if(visibility > 0.0)
+		{
+			reflectedLight += LightReflected(toLightDir, toCameraDir, surfaceNormal, f0, lightColor, lightDistance, metallic, roughness, diffuseVec3);
+		}
+	}
+
+#else
     //Point lights.
     for(int i = 0; i < inData.numLights.x; ++i)
     {		
@@ -539,6 +648,9 @@ void main()
 	//ENDIF SHADOWS
 #endif
 
+	//ENDIF LIGHT CLUSTERS
+#endif
+
     //Directional lights.
     for(int i = 0; i < inData.numLights.z; ++i)
     {
@@ -704,4 +816,21 @@ float GeometrySmith(vec3 surfaceNormal, vec3 toCameraDir, vec3 toLightDir, float
 vec3 FresnelSchlick(float cosTheta, vec3 f0)
 {
     return f0 + (1.0 - f0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
-}
\ No newline at end of file
+}
+
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+//Find the light cluster of the fragment from its clip space position. Matches LightClusterBuilder::GetClusterIndex.
+uint FindCluster()
+{
+	vec3 counts = inData.clusterCounts;
+
+	//The clip space W of a perspective projection is the view depth.
+	float depth = max(inData.clipPosition.w, 1.175494e-38);
+	vec2 ndc = inData.clipPosition.xy / depth;
+
+	vec2 tile = clamp(floor((ndc * 0.5 + 0.5) * counts.xy), vec2(0.0), counts.xy - 1.0);
+	float slice = clamp(floor(log(depth) * inData.clusterDepth.x + inData.clusterDepth.y), 0.0, counts.z - 1.0);
+
+	return uint(tile.x) + uint(counts.x) * (uint(tile.y) + uint(counts.y) * uint(slice));
+}
+#endif
@@ -1,7 +1,5 @@
 #version 460 core
 
-#define MAX_LIGHTS 580
-
 #ifdef VA_POS3D_DEF
 layout(location = VA_POS3D_LOCATION_DEF) in vec3 aPos;
 #endif
@@ -86,6 +84,8 @@ layout(std140, binding = 1) uniform StaticData
     vec4 numLightsNumCascades;      //Number of lights. X = point, Y = spot, Z = directional.   W = number of directional shadow cascades.
     vec4 numShadows;                //Number of shadow lights. X = point, Y = spot, Z = directional.
     vec4 ambientLight;              //Total ambient light count.
+    vec4 clusterCounts;             //Number of light clusters. X = screen X, Y = screen Y, Z = depth slices.
+    vec4 clusterDepth;              //X = depth slice scale. Y = depth slice bias.
 };
 
 //Uv modifiers
@@ -126,6 +126,13 @@ out VERTEX_OUT
     float fragDepth;
 #endif
 
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+    //Clip space position used to find the light cluster.
+    vec4 clipPosition;
+    flat vec3 clusterCounts;
+    flat vec2 clusterDepth;
+#endif
+
     //Material ID in the material batch.
 	#ifdef VA_MATERIALID_DEF
 	flat int materialID;
@@ -259,4 +266,11 @@ void main()
     outData.numShadowCascades = numLightsNumCascades.w;
     outData.fragDepth = gl_Position.z;
 #endif
+
+#ifdef USE_LIGHT_CLUSTERS_DEFINE
+    //The fragment shader uses the clip space position to find its light cluster.
+    outData.clipPosition = gl_Position;
+    outData.clusterCounts = clusterCounts.xyz;
+    outData.clusterDepth = clusterDepth.xy;
+#endif
 }
\ No newline at end of file
@@ -27,13 +27,16 @@ struct PosLightData
 {
     vec4 lightPosition;
     mat4 transforms[6];
-    int shadowMapId;
+    ivec4 shadowMapData;    //X is the shadow map index. Bit N of Y is set when face N has to be drawn.
 };
 
 layout(std140, binding = 1) uniform PosLights
 {
     PosLightData posLightData[MAX_LIGHTS];
 };
+
+//Bit N is set when the geometry can be seen by face N of the lights.
+layout(location = 3) uniform int faceMask;
 #endif
 
 //DIR LIGHTS
@@ -57,6 +60,9 @@ layout(std430, binding = 3) buffer DirCascades
     DirCascade cascades[];
 } dirCascades;
 
+//Bit N is set when the geometry has to be drawn into cascade N.
+layout(location = 2) uniform int cascadeMask;
+
 #endif
 
 void main()
@@ -75,8 +81,14 @@ void main()
             //Get the transform for every cubemap face and transform all three vertices. Then set the layer accordingly.
             for(int faceIndex = 0; faceIndex < 6; ++faceIndex)
             {   
+                //Skip faces that keep their shadow from an earlier frame, and faces that can not see the geometry.
+                if((posLightData[lightIndex].shadowMapData.y & faceMask & (1 << faceIndex)) == 0)
+                {
+                    continue;
+                }
+
                 //Then calculate the layer index for the current light.
-                gl_Layer = (6 * int(posLightData[lightIndex].shadowMapId)) + faceIndex;
+                gl_Layer = (6 * posLightData[lightIndex].shadowMapData.x) + faceIndex;
                 for(int i = 0; i < gl_in.length(); ++i)
                 {
                     outData.fragmentPosition = gl_in[i].gl_Position;
@@ -106,6 +118,12 @@ void main()
             //Loop over every cascade because some triangles are in multiple cascades. 
             for(int cascadeIndex = 0; cascadeIndex < dirLights.numCascades; ++cascadeIndex)
             {
+                //Skip cascades that the geometry was culled from.
+                if((cascadeMask & (1 << cascadeIndex)) == 0)
+                {
+                    continue;
+                }
+
                 int cascade = cascadeBase + cascadeIndex;
 
                 //Loop over every vertex and output it to this cascade.
@@ -1,11 +1,24 @@
 #include "BlurpEngine.h"
 
 
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <thread>
 #include <RenderDevice.h>
+#include "null/RenderDevice_Null.h"
+#include "RenderResourceManager.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderRegistry.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Window.h"
+
+//The window and the OpenGL device are only built on Windows. Elsewhere only GraphicsAPI::NONE without a window can be used.
+#ifdef _WIN32
 #include "opengl/RenderDevice_GL.h"
 #include "Window_Win32.h"
-#include "RenderResourceManager.h"
+#endif
 
 
 namespace blurp
@@ -13,6 +26,10 @@ namespace blurp
 	BlurpEngine::BlurpEngine()
     {
 
+    }
+
+	BlurpEngine::~BlurpEngine()
+    {
     }
 
     bool BlurpEngine::Init(const BlurpSettings& a_Settings)
@@ -20,16 +37,26 @@ namespace blurp
 		//Store the settings for later use.
 		m_Settings = a_Settings;
 
+		//Created first, so that everything below can record markers.
+		m_Profiler = std::make_unique<Profiler>(a_Settings.profilerFrames);
+
+		//Start the worker threads. The calling thread becomes the main thread, which owns the graphics API.
+		const std::uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+		const std::uint32_t workers = a_Settings.jobWorkers < 0 ? hardwareThreads - 1 : static_cast<std::uint32_t>(a_Settings.jobWorkers);
+		m_JobSystem = std::make_unique<JobSystem>(workers);
+
 		//Create the window if specified.
 		if(a_Settings.windowSettings.type != WindowType::NONE)
 		{
             switch (a_Settings.windowSettings.type)
             {
+#ifdef _WIN32
 			case WindowType::WINDOW_WIN32:
 				m_Window = std::make_shared<Window_Win32>(a_Settings.windowSettings);
 				break;
+#endif
 			default:
-				throw std::exception("Window type selected not implemented!");
+				throw std::runtime_error("Window type selected not implemented!");
 				return false;
             }
 
@@ -40,11 +67,16 @@ namespace blurp
 		//Create the right render device instance.
         switch (a_Settings.graphicsAPI)
         {
+#ifdef _WIN32
 		case GraphicsAPI::OPENGL:
 			m_RenderDevice = std::make_shared<RenderDevice_GL>(*this);
 			break;
+#endif
+		case GraphicsAPI::NONE:
+			m_RenderDevice = std::make_shared<RenderDevice_Null>(*this);
+			break;
 		default:
-			throw std::exception("Graphics API selected not implemented!");
+			throw std::runtime_error("Graphics API selected not implemented!");
 			return false;
         }
 
@@ -53,10 +85,24 @@ namespace blurp
 
 		if(!rDeviceInitialized)
 		{
-			throw std::exception("Could not initialize render device.");
+			throw std::runtime_error("Could not initialize render device.");
 			return false;
 		}
 
+		//Open the shader binary cache if the device can load binaries. Shaders are compiled from source when it can not be opened.
+		const std::string driverId = m_RenderDevice->GetDriverId();
+		if(!a_Settings.shaderBinaryCachePath.empty() && !driverId.empty())
+		{
+			m_ShaderBinaryCache = std::make_unique<ShaderBinaryCache>();
+			if(!m_ShaderBinaryCache->Open(a_Settings.shaderBinaryCachePath, driverId))
+			{
+				std::cout << "Could not open shader binary cache at " << a_Settings.shaderBinaryCachePath << "." << std::endl;
+				m_ShaderBinaryCache.reset();
+			}
+		}
+
+		m_ShaderRegistry = std::make_shared<ShaderRegistry>(a_Settings.maxShaderPrograms);
+
 		m_ResourceManager = std::make_unique<RenderResourceManager>(*this, *m_RenderDevice);
 
 		return true;
@@ -77,5 +123,27 @@ namespace blurp
     {
 		return m_Settings;
     }
-}
 
+    ShaderBinaryCache* BlurpEngine::GetShaderBinaryCache() const
+    {
+		return m_ShaderBinaryCache.get();
+    }
+
+    std::shared_ptr<ShaderRegistry> BlurpEngine::GetShaderRegistry() const
+    {
+		assert(m_ShaderRegistry && "BlurpEngine was not yet initialized!");
+		return m_ShaderRegistry;
+    }
+
+    JobSystem& BlurpEngine::GetJobSystem() const
+    {
+		assert(m_JobSystem && "BlurpEngine was not yet initialized!");
+		return *m_JobSystem;
+    }
+
+    Profiler& BlurpEngine::GetProfiler() const
+    {
+		assert(m_Profiler && "BlurpEngine was not yet initialized!");
+		return *m_Profiler;
+    }
+}
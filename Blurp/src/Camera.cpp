@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "Culling.h"
 
 namespace blurp
 {
@@ -33,6 +34,18 @@ namespace blurp
         return m_Projection;
     }
 
+    Frustum Camera::GetFrustum() const
+    {
+        return ExtractFrustum(GetProjectionMatrix() * GetViewMatrix());
+    }
+
+    void Camera::UpdateMatrices() const
+    {
+        m_Transform.GetTransformation();
+        GetViewMatrix();
+        GetProjectionMatrix();
+    }
+
     void Camera::UpdateSettings(const CameraSettings& a_Settings)
     {
         m_Settings = a_Settings;
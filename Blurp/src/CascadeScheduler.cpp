@@ -0,0 +1,211 @@
+#include "CascadeScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace blurp
+{
+    CascadeScheduler::CascadeScheduler() : m_NumCascades(0), m_UpdateMask(0), m_Frame(0), m_Invalidated(true)
+    {
+    }
+
+    void CascadeScheduler::SetSettings(const CascadeSchedulerSettings& a_Settings)
+    {
+        assert(a_Settings.texelThreshold >= 0.f && "Texel threshold can not be negative!");
+        assert(a_Settings.resolution > 0 && "Shadow map resolution has to be larger than 0!");
+        m_Settings = a_Settings;
+        m_Invalidated = true;
+    }
+
+    const CascadeSchedulerSettings& CascadeScheduler::GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    void CascadeScheduler::Invalidate()
+    {
+        m_Invalidated = true;
+    }
+
+    void CascadeScheduler::Schedule(const Camera& a_Camera, const LightShadowData* a_Lights, std::uint32_t a_Count, const ShadowData& a_ShadowData)
+    {
+        const std::uint32_t numCascades = a_ShadowData.directional.numCascades;
+        assert(numCascades <= 32 && "Cascade masks only fit 32 cascades!");
+
+        const std::uint64_t totalUpdated = m_Stats.totalUpdated;
+        const std::uint64_t totalSkipped = m_Stats.totalSkipped;
+        m_Stats = CascadeSchedulerStats();
+        m_Stats.totalUpdated = totalUpdated;
+        m_Stats.totalSkipped = totalSkipped;
+
+        //Calculate the cascades for the current camera.
+        m_NewMatrices.resize(static_cast<std::size_t>(a_Count) * numCascades);
+        m_ClipDepths.resize(static_cast<std::size_t>(a_Count) * numCascades);
+        for(std::uint32_t light = 0; light < a_Count; ++light)
+        {
+            RenderPass_ShadowMap::CalculateCascades(a_Camera, a_Lights[light].data, a_ShadowData, &m_NewMatrices[light * numCascades], &m_ClipDepths[light * numCascades]);
+        }
+
+        //Nothing that was drawn can be kept when the lights or the cascades changed.
+        bool redrawAll = m_Invalidated || numCascades != m_NumCascades || a_Count != m_LightIndices.size();
+        for(std::uint32_t light = 0; light < a_Count && !redrawAll; ++light)
+        {
+            redrawAll = a_Lights[light].index != m_LightIndices[light];
+        }
+
+        m_UpdateMask = 0;
+        for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+        {
+            if(redrawAll)
+            {
+                m_UpdateMask |= 1u << cascade;
+                continue;
+            }
+
+            //Cascades with the same interval are offset by their index, so that they are not all drawn in the same frame.
+            const std::uint32_t interval = cascade < m_Settings.intervals.size() ? std::max(m_Settings.intervals[cascade], 1u) : 1u;
+            if(m_Frame % interval == cascade % interval)
+            {
+                m_UpdateMask |= 1u << cascade;
+                ++m_Stats.dueCascades;
+                continue;
+            }
+
+            float shift = 0.f;
+            for(std::uint32_t light = 0; light < a_Count; ++light)
+            {
+                const std::size_t index = static_cast<std::size_t>(light) * numCascades + cascade;
+                shift = std::max(shift, CalculateTexelShift(m_Matrices[index], m_NewMatrices[index], m_Settings.resolution));
+            }
+
+            if(shift > m_Settings.texelThreshold)
+            {
+                m_UpdateMask |= 1u << cascade;
+                ++m_Stats.movedCascades;
+            }
+        }
+
+        //Only the cascades that are drawn take the matrices of the current camera.
+        if(redrawAll)
+        {
+            m_Matrices = m_NewMatrices;
+        }
+        else
+        {
+            for(std::uint32_t light = 0; light < a_Count; ++light)
+            {
+                for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+                {
+                    if((m_UpdateMask & (1u << cascade)) != 0)
+                    {
+                        const std::size_t index = static_cast<std::size_t>(light) * numCascades + cascade;
+                        m_Matrices[index] = m_NewMatrices[index];
+                    }
+                }
+            }
+        }
+
+        m_LightIndices.resize(a_Count);
+        for(std::uint32_t light = 0; light < a_Count; ++light)
+        {
+            m_LightIndices[light] = a_Lights[light].index;
+        }
+
+        const std::uint32_t allCascades = numCascades >= 32 ? ~0u : (1u << numCascades) - 1u;
+        m_Stats.updatedMask = m_UpdateMask;
+        m_Stats.skippedMask = allCascades & ~m_UpdateMask;
+
+        for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+        {
+            if((m_UpdateMask & (1u << cascade)) != 0)
+            {
+                ++m_Stats.totalUpdated;
+            }
+            else
+            {
+                ++m_Stats.totalSkipped;
+            }
+        }
+
+        m_NumCascades = numCascades;
+        m_Invalidated = false;
+        ++m_Frame;
+    }
+
+    std::uint32_t CascadeScheduler::GetUpdateMask() const
+    {
+        return m_UpdateMask;
+    }
+
+    const std::vector<glm::mat4>& CascadeScheduler::GetMatrices() const
+    {
+        return m_Matrices;
+    }
+
+    const std::vector<glm::vec4>& CascadeScheduler::GetClipDepths() const
+    {
+        return m_ClipDepths;
+    }
+
+    void CascadeScheduler::GetClearRegions(const ClearData& a_Template, std::vector<ClearData>& a_Output) const
+    {
+        //Find every layer that is drawn, in order.
+        std::vector<std::uint32_t> layers;
+        for(auto index : m_LightIndices)
+        {
+            for(std::uint32_t cascade = 0; cascade < m_NumCascades; ++cascade)
+            {
+                if((m_UpdateMask & (1u << cascade)) != 0)
+                {
+                    layers.push_back(static_cast<std::uint32_t>(index) * m_NumCascades + cascade);
+                }
+            }
+        }
+        std::sort(layers.begin(), layers.end());
+
+        //Merge consecutive layers into a single region.
+        std::size_t layer = 0;
+        while(layer < layers.size())
+        {
+            const std::uint32_t start = layers[layer];
+            std::uint32_t end = start + 1;
+            ++layer;
+            while(layer < layers.size() && layers[layer] <= end)
+            {
+                end = std::max(end, layers[layer] + 1);
+                ++layer;
+            }
+
+            ClearData region = a_Template;
+            region.offset.z = static_cast<float>(start);
+            region.size.z = static_cast<float>(end - start);
+            a_Output.push_back(region);
+        }
+    }
+
+    const CascadeSchedulerStats& CascadeScheduler::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    float CascadeScheduler::CalculateTexelShift(const glm::mat4& a_Old, const glm::mat4& a_New, std::uint32_t a_Resolution)
+    {
+        //Move the corners of the new volume back to world space, and then into the old volume.
+        const glm::mat4 newToOld = a_Old * glm::inverse(a_New);
+
+        float shift = 0.f;
+        for(float x = -1.f; x <= 1.f; x += 2.f)
+        {
+            for(float y = -1.f; y <= 1.f; y += 2.f)
+            {
+                glm::vec4 corner = newToOld * glm::vec4(x, y, 0.f, 1.f);
+                corner /= corner.w;
+                shift = std::max(shift, std::max(std::fabs(corner.x - x), std::fabs(corner.y - y)));
+            }
+        }
+
+        //Clip space is 2 units wide.
+        return shift * static_cast<float>(a_Resolution) * 0.5f;
+    }
+}
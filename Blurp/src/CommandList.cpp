@@ -0,0 +1,263 @@
+#include "CommandList.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "JobSystem.h"
+
+namespace blurp
+{
+    namespace
+    {
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        //FNV-1a over the bytes of a value.
+        template<typename T>
+        void HashValue(std::uint64_t& a_Hash, const T& a_Value)
+        {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&a_Value);
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                a_Hash = (a_Hash ^ bytes[i]) * FNV_PRIME;
+            }
+        }
+
+        std::uint32_t GetUniformSize(UniformFormat a_Format)
+        {
+            switch (a_Format)
+            {
+            case UniformFormat::INT:
+                return sizeof(std::int32_t);
+            case UniformFormat::FLOAT:
+                return sizeof(float);
+            case UniformFormat::VEC3:
+                return sizeof(glm::vec3);
+            }
+            return 0;
+        }
+    }
+
+    void CommandList::SetPipelineState(const PipelineState& a_State)
+    {
+        Add(CommandType::SET_PIPELINE_STATE, &a_State);
+    }
+
+    void CommandList::BindShader(const Shader& a_Shader)
+    {
+        Add(CommandType::BIND_SHADER, &a_Shader);
+    }
+
+    void CommandList::BindTexture(std::uint32_t a_Slot, const Texture& a_Texture)
+    {
+        Add(CommandType::BIND_TEXTURE, &a_Texture, a_Slot);
+    }
+
+    void CommandList::BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size)
+    {
+        Add(CommandType::BIND_STORAGE_BUFFER, &a_Buffer, a_Slot, a_Size, a_Offset);
+    }
+
+    void CommandList::BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch)
+    {
+        Add(CommandType::BIND_MATERIAL_BATCH, &a_Batch, a_Slot);
+    }
+
+    void CommandList::BindMesh(const Mesh& a_Mesh)
+    {
+        Add(CommandType::BIND_MESH, &a_Mesh);
+    }
+
+    void CommandList::SetUniform(std::uint32_t a_Location, std::int32_t a_Value)
+    {
+        AddUniform(a_Location, UniformFormat::INT, &a_Value, sizeof(a_Value));
+    }
+
+    void CommandList::SetUniform(std::uint32_t a_Location, float a_Value)
+    {
+        AddUniform(a_Location, UniformFormat::FLOAT, &a_Value, sizeof(a_Value));
+    }
+
+    void CommandList::SetUniform(std::uint32_t a_Location, const glm::vec3& a_Value)
+    {
+        AddUniform(a_Location, UniformFormat::VEC3, &a_Value, sizeof(a_Value));
+    }
+
+    void CommandList::Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount)
+    {
+        Add(CommandType::DRAW, &a_Mesh, 0, a_InstanceCount, 0, static_cast<std::uint8_t>(a_Topology));
+    }
+
+    void CommandList::Replay(CommandListBackend& a_Backend) const
+    {
+        for (const auto& command : m_Commands)
+        {
+            switch (command.type)
+            {
+            case CommandType::SET_PIPELINE_STATE:
+                a_Backend.SetPipelineState(*static_cast<const PipelineState*>(command.object));
+                break;
+            case CommandType::BIND_SHADER:
+                a_Backend.BindShader(*static_cast<const Shader*>(command.object));
+                break;
+            case CommandType::BIND_TEXTURE:
+                a_Backend.BindTexture(command.slot, *static_cast<const Texture*>(command.object));
+                break;
+            case CommandType::BIND_STORAGE_BUFFER:
+                a_Backend.BindStorageBuffer(command.slot, *static_cast<const GpuBuffer*>(command.object), command.value, command.count);
+                break;
+            case CommandType::BIND_MATERIAL_BATCH:
+                a_Backend.BindMaterialBatch(command.slot, *static_cast<const MaterialBatch*>(command.object));
+                break;
+            case CommandType::BIND_MESH:
+                a_Backend.BindMesh(*static_cast<const Mesh*>(command.object));
+                break;
+            case CommandType::SET_UNIFORM:
+                a_Backend.SetUniform(command.slot, static_cast<UniformFormat>(command.format), &m_Data[static_cast<std::size_t>(command.value)]);
+                break;
+            case CommandType::DRAW:
+                a_Backend.Draw(*static_cast<const Mesh*>(command.object), static_cast<TopologyType>(command.format), command.count);
+                break;
+            default:
+                assert(false && "Invalid command type in command list!");
+                break;
+            }
+        }
+    }
+
+    const std::vector<Command>& CommandList::GetCommands() const
+    {
+        return m_Commands;
+    }
+
+    std::uint64_t CommandList::GetHash() const
+    {
+        //Every field is hashed on its own, so that padding never ends up in the hash.
+        std::uint64_t hash = FNV_OFFSET;
+        for (const auto& command : m_Commands)
+        {
+            HashValue(hash, command.type);
+            HashValue(hash, command.slot);
+            HashValue(hash, command.format);
+            HashValue(hash, command.count);
+            HashValue(hash, command.value);
+            HashValue(hash, command.object);
+        }
+        for (const auto byte : m_Data)
+        {
+            HashValue(hash, byte);
+        }
+        return hash;
+    }
+
+    void CommandList::Clear()
+    {
+        m_Commands.clear();
+        m_Data.clear();
+    }
+
+    void CommandList::Add(CommandType a_Type, const void* a_Object, std::uint32_t a_Slot, std::uint32_t a_Count, std::uint64_t a_Value, std::uint8_t a_Format)
+    {
+        assert(a_Slot <= 0xFFu && "Command slots have to fit in 8 bits!");
+        m_Commands.push_back(Command{ a_Type, static_cast<std::uint8_t>(a_Slot), a_Format, a_Count, a_Value, a_Object });
+    }
+
+    void CommandList::AddUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data, std::uint32_t a_Size)
+    {
+        assert(a_Size == GetUniformSize(a_Format) && "Uniform size does not match its format!");
+
+        const std::size_t offset = m_Data.size();
+        m_Data.resize(offset + a_Size);
+        std::memcpy(&m_Data[offset], a_Data, a_Size);
+        Add(CommandType::SET_UNIFORM, nullptr, a_Location, a_Size, offset, static_cast<std::uint8_t>(a_Format));
+    }
+
+    CommandListSet::CommandListSet() : m_ListCount(0), m_Key(0), m_Recorded(false), m_RecordCount(0)
+    {
+    }
+
+    bool CommandListSet::IsRecorded(std::uint64_t a_Key) const
+    {
+        return m_Recorded && m_Key == a_Key;
+    }
+
+    void CommandListSet::Record(JobSystem& a_Jobs, std::uint64_t a_Key, std::uint32_t a_Count, std::uint32_t a_ItemsPerList, std::uint32_t a_MaxThreads, const RecordFunction& a_Record)
+    {
+        //Lists are cleared instead of removed, so that their memory is reused.
+        const std::uint32_t itemsPerList = std::max(a_ItemsPerList, 1u);
+        m_ListCount = (a_Count + itemsPerList - 1) / itemsPerList;
+        if (m_Lists.size() < m_ListCount)
+        {
+            m_Lists.resize(m_ListCount);
+        }
+
+        //Every job records a fixed selection of lists. Which thread records a list does not change its contents.
+        const std::uint32_t jobCount = std::max(1u, std::min({ a_MaxThreads, m_ListCount, a_Jobs.GetThreadCount() }));
+        a_Jobs.ParallelFor(jobCount, 1, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+        {
+            for (std::uint32_t job = a_Begin; job < a_End; ++job)
+            {
+                for (std::uint32_t list = job; list < m_ListCount; list += jobCount)
+                {
+                    const std::uint32_t begin = list * itemsPerList;
+                    m_Lists[list].Clear();
+                    a_Record(m_Lists[list], begin, std::min(begin + itemsPerList, a_Count));
+                }
+            }
+        });
+
+        m_Key = a_Key;
+        m_Recorded = true;
+        ++m_RecordCount;
+    }
+
+    void CommandListSet::Replay(CommandListBackend& a_Backend) const
+    {
+        for (std::uint32_t list = 0; list < m_ListCount; ++list)
+        {
+            m_Lists[list].Replay(a_Backend);
+        }
+    }
+
+    void CommandListSet::Invalidate()
+    {
+        m_Recorded = false;
+    }
+
+    std::uint32_t CommandListSet::GetListCount() const
+    {
+        return m_ListCount;
+    }
+
+    const CommandList& CommandListSet::GetList(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_ListCount && "Command list index out of range!");
+        return m_Lists[a_Index];
+    }
+
+    std::uint32_t CommandListSet::GetCommandCount() const
+    {
+        std::uint32_t count = 0;
+        for (std::uint32_t list = 0; list < m_ListCount; ++list)
+        {
+            count += static_cast<std::uint32_t>(m_Lists[list].GetCommands().size());
+        }
+        return count;
+    }
+
+    std::uint64_t CommandListSet::GetHash() const
+    {
+        std::uint64_t hash = FNV_OFFSET;
+        for (std::uint32_t list = 0; list < m_ListCount; ++list)
+        {
+            HashValue(hash, m_Lists[list].GetHash());
+        }
+        return hash;
+    }
+
+    std::uint32_t CommandListSet::GetRecordCount() const
+    {
+        return m_RecordCount;
+    }
+}
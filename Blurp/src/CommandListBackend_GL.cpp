@@ -0,0 +1,181 @@
+#include "opengl/CommandListBackend_GL.h"
+
+#include <GL/glew.h>
+
+#include "StateTracker.h"
+#include "opengl/GLUtils.h"
+#include "opengl/GpuBuffer_GL.h"
+#include "opengl/MaterialBatch_GL.h"
+#include "opengl/Mesh_GL.h"
+#include "opengl/Shader_GL.h"
+#include "opengl/Texture_GL.h"
+
+namespace blurp
+{
+    void CommandListBackend_GL::SetPipelineState(const PipelineState& a_State)
+    {
+        auto& state = m_StateTracker;
+
+        //Set depth
+        auto depthStencilData = a_State.GetDepthStencilData();
+        if (depthStencilData.enableDepth)
+        {
+            state.SetEnabled(GL_DEPTH_TEST, true);    //Depth testing enabled.
+            state.SetDepthFunc(ToGL(depthStencilData.depthFunction)); //The depth function
+            state.SetDepthMask(depthStencilData.depthWrite);    //Enable or disable depth writing.
+        }
+        else
+        {
+            state.SetEnabled(GL_DEPTH_TEST, false);   //No depth used at all.
+        }
+
+        //Set stencil
+        if (depthStencilData.enableStencil)
+        {
+            /*
+             * Note:
+             * OpenGL and D3D12 have different stencil masking parameters in different places.
+             * It's a bit vague so idk if this is 100% correct, but I believe it is.
+             * If it doesn't seem to be working as intended then this is why.
+             */
+
+            state.SetEnabled(GL_STENCIL_TEST, true);
+
+            //Front faces
+            state.SetStencilFunc(StateFace::FRONT,
+                ToGL(depthStencilData.stencilFrontFace.stencilFunc),
+                depthStencilData.stencilRef,
+                depthStencilData.stencilReadMask);
+
+            state.SetStencilOp(StateFace::FRONT,
+                ToGL(depthStencilData.stencilFrontFace.stencilFailOp),
+                ToGL(depthStencilData.stencilFrontFace.stencilDepthFailOp),
+                ToGL(depthStencilData.stencilFrontFace.stencilPassOp));
+
+            //Back faces
+            state.SetStencilFunc(StateFace::BACK,
+                ToGL(depthStencilData.stencilBackFace.stencilFunc),
+                depthStencilData.stencilRef,
+                depthStencilData.stencilReadMask);
+
+            state.SetStencilOp(StateFace::BACK,
+                ToGL(depthStencilData.stencilBackFace.stencilFailOp),
+                ToGL(depthStencilData.stencilBackFace.stencilDepthFailOp),
+                ToGL(depthStencilData.stencilBackFace.stencilPassOp));
+
+            //Write mask cannot be separate for different faces in D3D12, so I'm not supporting it in OpenGL either.
+            state.SetStencilMask(depthStencilData.stencilWriteMask);
+        }
+        else
+        {
+            state.SetEnabled(GL_STENCIL_TEST, false);
+        }
+
+        //Set culling
+        if (a_State.GetCullMode() != CullMode::CULL_NONE)
+        {
+            state.SetEnabled(GL_CULL_FACE, true);
+            state.SetCullFace(ToGL(a_State.GetCullMode()));
+            state.SetFrontFace(ToGL(a_State.GetFrontWindingOrder()));
+        }
+        else
+        {
+            state.SetEnabled(GL_CULL_FACE, false);
+        }
+
+        //Set blending
+        auto blending = a_State.GetBlendData();
+        if (blending.blend)
+        {
+            state.SetEnabled(GL_BLEND, true);
+
+            state.SetBlendFunc(
+                ToGL(blending.srcBlend),
+                ToGL(blending.dstBlend),
+                ToGL(blending.srcBlendAlpha),
+                ToGL(blending.dstBlendAlpha)
+            );
+
+            state.SetBlendEquation(
+                ToGL(blending.blendOperation),
+                ToGL(blending.blendOperationAlpha)
+            );
+        }
+        else
+        {
+            state.SetEnabled(GL_BLEND, false);
+        }
+    }
+
+    void CommandListBackend_GL::BindShader(const Shader& a_Shader)
+    {
+        m_StateTracker.UseProgram(static_cast<const Shader_GL&>(a_Shader).GetProgramId());
+    }
+
+    void CommandListBackend_GL::BindTexture(std::uint32_t a_Slot, const Texture& a_Texture)
+    {
+        m_StateTracker.BindTexture(a_Slot, ToGL(a_Texture.GetTextureType()), static_cast<const Texture_GL&>(a_Texture).GetTextureId());
+    }
+
+    void CommandListBackend_GL::BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size)
+    {
+        //The buffer id is looked up now, because resizing a buffer replaces it.
+        m_StateTracker.BindBufferRange(GL_SHADER_STORAGE_BUFFER, a_Slot, static_cast<const GpuBuffer_GL&>(a_Buffer).GetBufferId(), static_cast<std::int64_t>(a_Offset), a_Size);
+    }
+
+    void CommandListBackend_GL::BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch)
+    {
+        const auto& batchGl = static_cast<const MaterialBatch_GL&>(a_Batch);
+        if (batchGl.HasUbo())
+        {
+            m_StateTracker.BindBufferBase(GL_UNIFORM_BUFFER, a_Slot, batchGl.GetUboID());
+        }
+    }
+
+    void CommandListBackend_GL::BindMesh(const Mesh& a_Mesh)
+    {
+        m_StateTracker.BindVertexArray(static_cast<const Mesh_GL&>(a_Mesh).GetVaoId());
+    }
+
+    void CommandListBackend_GL::SetUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data)
+    {
+        switch (a_Format)
+        {
+        case UniformFormat::INT:
+            glUniform1iv(a_Location, 1, static_cast<const GLint*>(a_Data));
+            break;
+        case UniformFormat::FLOAT:
+            glUniform1fv(a_Location, 1, static_cast<const GLfloat*>(a_Data));
+            break;
+        case UniformFormat::VEC3:
+            glUniform3fv(a_Location, 1, static_cast<const GLfloat*>(a_Data));
+            break;
+        }
+    }
+
+    void CommandListBackend_GL::Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount)
+    {
+        const auto& mesh = static_cast<const Mesh_GL&>(a_Mesh);
+        const auto glTopology = ToGL(a_Topology);
+
+        //Set up the right instance divisor based on the number of instances.
+        for (auto& pair : mesh.GetInstanceDivisors())
+        {
+            //Divisor is the increment rate of the attribute in literal instances. It's not based on other divisors!
+            glVertexAttribDivisor(pair.first, pair.second * a_InstanceCount);
+        }
+
+        if (a_Topology == TopologyType::POINTS)
+        {
+            m_StateTracker.SetEnabled(GL_PROGRAM_POINT_SIZE, true);
+            glPointSize(5.f);
+
+            glDrawArraysInstanced(glTopology, 0, mesh.GetNumIndices(), a_InstanceCount * mesh.GetInstanceCount());
+        }
+        //Indexed drawing.
+        else
+        {
+            glDrawElementsInstanced(glTopology, mesh.GetNumIndices(), mesh.GetIndexDataType(), nullptr, a_InstanceCount * mesh.GetInstanceCount());
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include "CommandListBackend_Null.h"
+
+#include "CommandRecording.h"
+#include "null/MaterialBatch_Null.h"
+#include "null/Mesh_Null.h"
+
+namespace blurp
+{
+    void CommandListBackend_Null::SetPipelineState(const PipelineState& a_State)
+    {
+        m_Recording.Record(RecordedCommandType::SET_PIPELINE_STATE, nullptr, 0, 0, static_cast<std::uint64_t>(a_State.GetId()));
+    }
+
+    void CommandListBackend_Null::BindShader(const Shader& a_Shader)
+    {
+        m_Recording.Record(RecordedCommandType::BIND_SHADER, &a_Shader);
+    }
+
+    void CommandListBackend_Null::BindTexture(std::uint32_t a_Slot, const Texture& a_Texture)
+    {
+        m_Recording.Record(RecordedCommandType::BIND_TEXTURE, &a_Texture, a_Slot);
+    }
+
+    void CommandListBackend_Null::BindStorageBuffer(std::uint32_t a_Slot, const GpuBuffer& a_Buffer, std::uint64_t a_Offset, std::uint32_t a_Size)
+    {
+        m_Recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, &a_Buffer, a_Slot, a_Size, a_Offset);
+    }
+
+    void CommandListBackend_Null::BindMaterialBatch(std::uint32_t a_Slot, const MaterialBatch& a_Batch)
+    {
+        const auto& batch = static_cast<const MaterialBatch_Null&>(a_Batch);
+        if (batch.HasConstantData())
+        {
+            m_Recording.Record(RecordedCommandType::BIND_UNIFORM_BUFFER, &a_Batch, a_Slot, static_cast<std::uint32_t>(batch.GetConstantData().size() * sizeof(float)));
+        }
+    }
+
+    void CommandListBackend_Null::BindMesh(const Mesh& a_Mesh)
+    {
+        m_Recording.Record(RecordedCommandType::BIND_MESH, &a_Mesh);
+    }
+
+    void CommandListBackend_Null::SetUniform(std::uint32_t a_Location, UniformFormat a_Format, const void* a_Data)
+    {
+        std::uint32_t size = 0;
+        switch (a_Format)
+        {
+        case UniformFormat::INT:
+            size = sizeof(std::int32_t);
+            break;
+        case UniformFormat::FLOAT:
+            size = sizeof(float);
+            break;
+        case UniformFormat::VEC3:
+            size = sizeof(glm::vec3);
+            break;
+        }
+        m_Recording.RecordUniform(a_Location, a_Data, size);
+    }
+
+    void CommandListBackend_Null::Draw(const Mesh& a_Mesh, TopologyType a_Topology, std::uint32_t a_InstanceCount)
+    {
+        const auto& mesh = static_cast<const Mesh_Null&>(a_Mesh);
+        const std::uint64_t numInstances = static_cast<std::uint64_t>(a_InstanceCount) * mesh.GetInstanceCount();
+
+        //Points are drawn without indices, everything else is indexed.
+        if (a_Topology == TopologyType::POINTS)
+        {
+            m_Recording.Record(RecordedCommandType::DRAW, &a_Mesh, 0, mesh.GetNumIndices(), numInstances);
+        }
+        else
+        {
+            m_Recording.Record(RecordedCommandType::DRAW_INDEXED, &a_Mesh, 0, mesh.GetNumIndices(), numInstances);
+        }
+    }
+}
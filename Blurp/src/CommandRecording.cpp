@@ -0,0 +1,125 @@
+#include "CommandRecording.h"
+
+#include <cassert>
+
+namespace blurp
+{
+    namespace
+    {
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        //FNV-1a over the bytes of a value.
+        template<typename T>
+        void HashValue(std::uint64_t& a_Hash, const T& a_Value)
+        {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&a_Value);
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                a_Hash = (a_Hash ^ bytes[i]) * FNV_PRIME;
+            }
+        }
+    }
+
+    CommandRecording::CommandRecording() : m_Counts{}, m_UploadedBytes(0)
+    {
+    }
+
+    void CommandRecording::Record(RecordedCommandType a_Type, const void* a_Object, std::uint32_t a_Slot, std::uint32_t a_Count, std::uint64_t a_Value)
+    {
+        assert(a_Type < RecordedCommandType::NUM_COMMAND_TYPES && "Invalid recorded command type!");
+        assert(a_Slot <= 0xFFu && "Recorded slots have to fit in 8 bits!");
+
+        m_Commands.push_back(RecordedCommand{ a_Type, static_cast<std::uint8_t>(a_Slot), GetObjectId(a_Object), a_Count, a_Value });
+        ++m_Counts[static_cast<int>(a_Type)];
+
+        if (a_Type == RecordedCommandType::UPLOAD)
+        {
+            m_UploadedBytes += a_Count;
+        }
+    }
+
+    void CommandRecording::RecordUpload(const void* a_Buffer, const void* a_Data, std::uint32_t a_Size)
+    {
+        Record(RecordedCommandType::UPLOAD, a_Buffer, 0, a_Size, HashBytes(a_Data, a_Size));
+    }
+
+    void CommandRecording::RecordUniform(std::uint32_t a_Location, const void* a_Data, std::uint32_t a_Size)
+    {
+        Record(RecordedCommandType::SET_UNIFORM, nullptr, a_Location, a_Size, HashBytes(a_Data, a_Size));
+    }
+
+    void CommandRecording::RecordViewport(std::uint32_t a_X, std::uint32_t a_Y, std::uint32_t a_Width, std::uint32_t a_Height)
+    {
+        assert(a_X <= 0xFFFFu && a_Y <= 0xFFFFu && a_Width <= 0xFFFFu && a_Height <= 0xFFFFu && "Recorded viewports have to fit in 16 bits per value!");
+
+        const std::uint64_t value = (static_cast<std::uint64_t>(a_X) << 48) | (static_cast<std::uint64_t>(a_Y) << 32) | (static_cast<std::uint64_t>(a_Width) << 16) | a_Height;
+        Record(RecordedCommandType::SET_VIEWPORT, nullptr, 0, 0, value);
+    }
+
+    std::uint32_t CommandRecording::GetObjectId(const void* a_Object)
+    {
+        if (a_Object == nullptr)
+        {
+            return 0;
+        }
+
+        const auto id = static_cast<std::uint32_t>(m_ObjectIds.size() + 1);
+        return m_ObjectIds.emplace(a_Object, id).first->second;
+    }
+
+    const std::vector<RecordedCommand>& CommandRecording::GetCommands() const
+    {
+        return m_Commands;
+    }
+
+    std::uint32_t CommandRecording::GetCount(RecordedCommandType a_Type) const
+    {
+        assert(a_Type < RecordedCommandType::NUM_COMMAND_TYPES && "Invalid recorded command type!");
+        return m_Counts[static_cast<int>(a_Type)];
+    }
+
+    std::uint64_t CommandRecording::GetUploadedBytes() const
+    {
+        return m_UploadedBytes;
+    }
+
+    std::uint64_t CommandRecording::GetHash() const
+    {
+        //Every field is hashed on its own, so that padding never ends up in the hash.
+        std::uint64_t hash = FNV_OFFSET;
+        for (const auto& command : m_Commands)
+        {
+            HashValue(hash, command.type);
+            HashValue(hash, command.slot);
+            HashValue(hash, command.object);
+            HashValue(hash, command.count);
+            HashValue(hash, command.value);
+        }
+        return hash;
+    }
+
+    void CommandRecording::Clear()
+    {
+        m_Commands.clear();
+        m_ObjectIds.clear();
+        for (auto& count : m_Counts)
+        {
+            count = 0;
+        }
+        m_UploadedBytes = 0;
+    }
+
+    std::uint64_t CommandRecording::HashBytes(const void* a_Data, std::uint32_t a_Size)
+    {
+        assert((a_Data != nullptr || a_Size == 0) && "Cannot hash nullptr!");
+
+        std::uint64_t hash = FNV_OFFSET;
+        const auto* bytes = static_cast<const unsigned char*>(a_Data);
+        for (std::uint32_t i = 0; i < a_Size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+}
@@ -0,0 +1,303 @@
+#include "Culling.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <glm/gtc/matrix_access.hpp>
+
+#include "SimdSupport.h"
+
+namespace blurp
+{
+    namespace
+    {
+        //Read a vec3 of floats from unaligned memory.
+        glm::vec3 ReadPosition(const char* a_Data)
+        {
+            glm::vec3 position;
+            memcpy(&position, a_Data, sizeof(glm::vec3));
+            return position;
+        }
+
+        //Test a single instance. Operations happen in the same order as in the SIMD kernel, so that the results are identical.
+        bool IsVisible(const Frustum& a_Frustum, const MeshBounds& a_Bounds, const glm::mat4& a_Transform)
+        {
+            const glm::vec4 center = a_Transform[0] * a_Bounds.center.x + a_Transform[1] * a_Bounds.center.y + a_Transform[2] * a_Bounds.center.z + a_Transform[3];
+
+            //Scale the radius by the largest axis scale.
+            const auto lengthSquared = [](const glm::vec4& a_Column) { return a_Column.x * a_Column.x + a_Column.y * a_Column.y + a_Column.z * a_Column.z; };
+            const float scaleSquared = std::max(std::max(lengthSquared(a_Transform[0]), lengthSquared(a_Transform[1])), lengthSquared(a_Transform[2]));
+            const float radius = std::sqrt(scaleSquared) * a_Bounds.radius;
+
+            for(const auto& plane : a_Frustum.planes)
+            {
+                const float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+                if(distance < -radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    MeshBounds CalculateMeshBounds(const MeshSettings& a_Settings)
+    {
+        MeshBounds bounds;
+
+        VertexSettings vertexSettings = a_Settings.vertexSettings;
+        if(!vertexSettings.IsEnabled(VertexAttribute::POSITION_3D) || a_Settings.vertexData == nullptr)
+        {
+            return bounds;
+        }
+
+        const auto attribute = vertexSettings.GetAttributeData(VertexAttribute::POSITION_3D);
+        const std::uint32_t stride = attribute.byteStride != 0 ? attribute.byteStride : static_cast<std::uint32_t>(sizeof(glm::vec3));
+        const char* positions = static_cast<const char*>(a_Settings.vertexData) + attribute.byteOffset;
+
+        //Without indices, every complete vertex in the buffer is used.
+        std::uint32_t numVertices = 0;
+        if(a_Settings.vertexDataSizeBytes >= attribute.byteOffset + sizeof(glm::vec3))
+        {
+            numVertices = ((a_Settings.vertexDataSizeBytes - attribute.byteOffset - static_cast<std::uint32_t>(sizeof(glm::vec3))) / stride) + 1;
+        }
+
+        const bool indexed = a_Settings.indexData != nullptr && a_Settings.numIndices > 0;
+        const std::uint32_t count = indexed ? a_Settings.numIndices : numVertices;
+        if(count == 0)
+        {
+            return bounds;
+        }
+
+        //Find the vertex index for the i-th vertex that is drawn.
+        const auto getVertex = [&](std::uint32_t a_Index) -> std::uint32_t
+        {
+            if(!indexed)
+            {
+                return a_Index;
+            }
+            if(a_Settings.indexDataType == DataType::USHORT)
+            {
+                return static_cast<const std::uint16_t*>(a_Settings.indexData)[a_Index];
+            }
+            assert(a_Settings.indexDataType == DataType::UINT && "Index buffer data type has to be either UINT or USHORT.");
+            return static_cast<const std::uint32_t*>(a_Settings.indexData)[a_Index];
+        };
+
+        glm::vec3 min(std::numeric_limits<float>::max());
+        glm::vec3 max(std::numeric_limits<float>::lowest());
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            const auto vertex = getVertex(i);
+            assert(vertex < numVertices && "Index out of range of the vertex data!");
+            const auto position = ReadPosition(positions + static_cast<std::size_t>(vertex) * stride);
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+
+        bounds.min = min;
+        bounds.max = max;
+        bounds.center = (min + max) * 0.5f;
+
+        //The sphere is centered on the box, but only needs to enclose the vertices.
+        float radiusSquared = 0.f;
+        for(std::uint32_t i = 0; i < count; ++i)
+        {
+            const auto offset = ReadPosition(positions + static_cast<std::size_t>(getVertex(i)) * stride) - bounds.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+        }
+        bounds.radius = std::sqrt(radiusSquared);
+
+        return bounds;
+    }
+
+    MeshBounds CombineBounds(const MeshBounds& a_First, const MeshBounds& a_Second)
+    {
+        MeshBounds bounds;
+        bounds.min = glm::min(a_First.min, a_Second.min);
+        bounds.max = glm::max(a_First.max, a_Second.max);
+        bounds.center = (bounds.min + bounds.max) * 0.5f;
+
+        //Enclose both spheres around the new center.
+        bounds.radius = std::max(glm::length(a_First.center - bounds.center) + a_First.radius, glm::length(a_Second.center - bounds.center) + a_Second.radius);
+        return bounds;
+    }
+
+    MeshBounds TransformBounds(const MeshBounds& a_Bounds, const glm::mat4& a_Transform)
+    {
+        //Arvo: every axis of the new box is the translation plus the smallest and largest contribution of each matrix column.
+        MeshBounds bounds;
+        bounds.min = glm::vec3(a_Transform[3]);
+        bounds.max = bounds.min;
+
+        for(int column = 0; column < 3; ++column)
+        {
+            const glm::vec3 axis(a_Transform[column]);
+            const glm::vec3 first = axis * a_Bounds.min[column];
+            const glm::vec3 second = axis * a_Bounds.max[column];
+            bounds.min += glm::min(first, second);
+            bounds.max += glm::max(first, second);
+        }
+
+        const float scale = std::max(std::max(glm::length(glm::vec3(a_Transform[0])), glm::length(glm::vec3(a_Transform[1]))), glm::length(glm::vec3(a_Transform[2])));
+        bounds.center = glm::vec3(a_Transform * glm::vec4(a_Bounds.center, 1.f));
+        bounds.radius = a_Bounds.radius * scale;
+        return bounds;
+    }
+
+    Frustum ExtractFrustum(const glm::mat4& a_ViewProjection)
+    {
+        //Gribb-Hartmann: every plane is a combination of the fourth row with one of the other rows.
+        const glm::vec4 rowX = glm::row(a_ViewProjection, 0);
+        const glm::vec4 rowY = glm::row(a_ViewProjection, 1);
+        const glm::vec4 rowZ = glm::row(a_ViewProjection, 2);
+        const glm::vec4 rowW = glm::row(a_ViewProjection, 3);
+
+        Frustum frustum;
+        frustum.planes[Frustum::PLANE_LEFT] = rowW + rowX;
+        frustum.planes[Frustum::PLANE_RIGHT] = rowW - rowX;
+        frustum.planes[Frustum::PLANE_BOTTOM] = rowW + rowY;
+        frustum.planes[Frustum::PLANE_TOP] = rowW - rowY;
+        frustum.planes[Frustum::PLANE_NEAR] = rowW + rowZ;
+        frustum.planes[Frustum::PLANE_FAR] = rowW - rowZ;
+
+        for(auto& plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+
+        return frustum;
+    }
+
+    Frustum ExtrudeFrustum(const Frustum& a_Frustum, const glm::vec3& a_Direction)
+    {
+        //Moving along the direction brings a point further inside planes whose normal points the same way, so those planes can never reject a shadow caster.
+        Frustum frustum = a_Frustum;
+        for(auto& plane : frustum.planes)
+        {
+            if(glm::dot(glm::vec3(plane), a_Direction) > 0.f)
+            {
+                plane = glm::vec4(0.f, 0.f, 0.f, std::numeric_limits<float>::max());
+            }
+        }
+        return frustum;
+    }
+
+    std::uint32_t CullInstancesReference(const Frustum& a_Frustum, const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count, glm::mat4* a_Output, bool a_KeepCulled)
+    {
+        assert((!a_KeepCulled || a_Count == 0 || a_Output != a_Transforms) && "Output cannot be the input when keeping culled instances!");
+
+        std::uint32_t visible = 0;
+        std::uint32_t culled = 0;
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            if(IsVisible(a_Frustum, a_Bounds, a_Transforms[i]))
+            {
+                a_Output[visible++] = a_Transforms[i];
+            }
+            else if(a_KeepCulled)
+            {
+                a_Output[a_Count - ++culled] = a_Transforms[i];
+            }
+        }
+        return visible;
+    }
+
+    std::uint32_t CullInstances(const Frustum& a_Frustum, const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count, glm::mat4* a_Output, bool a_KeepCulled)
+    {
+#if defined(BLURP_SIMD_SSE)
+        assert((!a_KeepCulled || a_Count == 0 || a_Output != a_Transforms) && "Output cannot be the input when keeping culled instances!");
+
+        const __m128 centerX = _mm_set1_ps(a_Bounds.center.x);
+        const __m128 centerY = _mm_set1_ps(a_Bounds.center.y);
+        const __m128 centerZ = _mm_set1_ps(a_Bounds.center.z);
+        const __m128 radius = _mm_set1_ps(a_Bounds.radius);
+        const __m128 signBit = _mm_set1_ps(-0.f);
+
+        std::uint32_t visible = 0;
+        std::uint32_t culled = 0;
+        const std::uint32_t groupEnd = a_Count & ~3u;
+
+        //Four instances at a time.
+        for(std::uint32_t i = 0; i < groupEnd; i += 4)
+        {
+            __m128 columns[4][4];
+            __m128 center[4];
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                const float* matrix = &a_Transforms[i + lane][0][0];
+                for(int column = 0; column < 4; ++column)
+                {
+                    columns[column][lane] = _mm_loadu_ps(matrix + column * 4);
+                }
+
+                center[lane] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[0][lane], centerX), _mm_mul_ps(columns[1][lane], centerY)), _mm_mul_ps(columns[2][lane], centerZ)), columns[3][lane]);
+            }
+
+            //Switch to one register per component, holding that component for all four instances.
+            _MM_TRANSPOSE4_PS(center[0], center[1], center[2], center[3]);
+
+            __m128 scaleSquared = _mm_setzero_ps();
+            for(int column = 0; column < 3; ++column)
+            {
+                _MM_TRANSPOSE4_PS(columns[column][0], columns[column][1], columns[column][2], columns[column][3]);
+                const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(columns[column][0], columns[column][0]), _mm_mul_ps(columns[column][1], columns[column][1])), _mm_mul_ps(columns[column][2], columns[column][2]));
+                scaleSquared = _mm_max_ps(scaleSquared, lengthSquared);
+            }
+
+            const __m128 negativeRadius = _mm_xor_ps(_mm_mul_ps(_mm_sqrt_ps(scaleSquared), radius), signBit);
+
+            //An instance is culled when it is fully behind any of the planes.
+            __m128 outside = _mm_setzero_ps();
+            for(const auto& plane : a_Frustum.planes)
+            {
+                const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), center[0]), _mm_mul_ps(_mm_set1_ps(plane.y), center[1])), _mm_mul_ps(_mm_set1_ps(plane.z), center[2])), _mm_set1_ps(plane.w));
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negativeRadius));
+            }
+
+            const int outsideMask = _mm_movemask_ps(outside);
+
+            //Everything visible is the common case, so copy the group at once. Safe in place because the group has been read already.
+            if(outsideMask == 0)
+            {
+                if(a_Output + visible != a_Transforms + i)
+                {
+                    memmove(a_Output + visible, a_Transforms + i, sizeof(glm::mat4) * 4);
+                }
+                visible += 4;
+                continue;
+            }
+
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if((outsideMask & (1 << lane)) == 0)
+                {
+                    a_Output[visible++] = a_Transforms[i + lane];
+                }
+                else if(a_KeepCulled)
+                {
+                    a_Output[a_Count - ++culled] = a_Transforms[i + lane];
+                }
+            }
+        }
+
+        //The remaining instances one by one.
+        for(std::uint32_t i = groupEnd; i < a_Count; ++i)
+        {
+            if(IsVisible(a_Frustum, a_Bounds, a_Transforms[i]))
+            {
+                a_Output[visible++] = a_Transforms[i];
+            }
+            else if(a_KeepCulled)
+            {
+                a_Output[a_Count - ++culled] = a_Transforms[i];
+            }
+        }
+
+        return visible;
+#else
+        return CullInstancesReference(a_Frustum, a_Bounds, a_Transforms, a_Count, a_Output, a_KeepCulled);
+#endif
+    }
+}
@@ -1,19 +1,116 @@
 #include <Data.h>
 
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
 namespace blurp
 {
-    //Initialize global ID counter.
-    int PipelineState::m_IdCounter = 0;
+    namespace
+    {
+        //Bits of a pipeline state id that number the states within a group of states that share the sorted fields.
+        constexpr int PIPELINE_INDEX_BITS = 22;
+
+        //The interned pipeline states. Stored in a deque so that their addresses never change.
+        struct PipelineStateRegistry
+        {
+            std::mutex mutex;
+            std::unordered_map<std::string, const PipelineState*> states;
+            std::deque<PipelineState> storage;
+        };
+
+        PipelineStateRegistry& GetPipelineStateRegistry()
+        {
+            static PipelineStateRegistry registry;
+            return registry;
+        }
+
+        //Append the bytes of a value to a key.
+        template<typename T>
+        void AppendKey(std::string& a_Key, const T& a_Value)
+        {
+            a_Key.append(reinterpret_cast<const char*>(&a_Value), sizeof(T));
+        }
+
+        void AppendKey(std::string& a_Key, const StencilOperationData& a_Data)
+        {
+            AppendKey(a_Key, a_Data.stencilFailOp);
+            AppendKey(a_Key, a_Data.stencilDepthFailOp);
+            AppendKey(a_Key, a_Data.stencilPassOp);
+            AppendKey(a_Key, a_Data.stencilFunc);
+        }
+    }
 
     PipelineState PipelineState::Compile(const BlendData& a_BlendData, const TopologyType& a_Topology,
         const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData)
     {
-        return PipelineState(a_BlendData, a_Topology, a_CullMode, a_Winding, a_DepthStencilData);
+        return Intern(a_BlendData, a_Topology, a_CullMode, a_Winding, a_DepthStencilData);
+    }
+
+    const PipelineState& PipelineState::Intern(const BlendData& a_BlendData, const TopologyType& a_Topology,
+        const CullMode& a_CullMode, const WindingOrder& a_Winding, const DepthStencilData& a_DepthStencilData)
+    {
+        //Every field is added on its own, so that padding never ends up in the key.
+        std::string key;
+        AppendKey(key, a_BlendData.blend);
+        AppendKey(key, a_BlendData.srcBlend);
+        AppendKey(key, a_BlendData.dstBlend);
+        AppendKey(key, a_BlendData.srcBlendAlpha);
+        AppendKey(key, a_BlendData.dstBlendAlpha);
+        AppendKey(key, a_BlendData.blendOperation);
+        AppendKey(key, a_BlendData.blendOperationAlpha);
+        AppendKey(key, a_Topology);
+        AppendKey(key, a_CullMode);
+        AppendKey(key, a_Winding);
+        AppendKey(key, a_DepthStencilData.enableDepth);
+        AppendKey(key, a_DepthStencilData.depthWrite);
+        AppendKey(key, a_DepthStencilData.depthFunction);
+        AppendKey(key, a_DepthStencilData.enableStencil);
+        AppendKey(key, a_DepthStencilData.stencilWriteMask);
+        AppendKey(key, a_DepthStencilData.stencilReadMask);
+        AppendKey(key, a_DepthStencilData.stencilRef);
+        AppendKey(key, a_DepthStencilData.stencilFrontFace);
+        AppendKey(key, a_DepthStencilData.stencilBackFace);
+
+        auto& registry = GetPipelineStateRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        const auto found = registry.states.find(key);
+        if(found != registry.states.end())
+        {
+            return *found->second;
+        }
+
+        const int index = static_cast<int>(registry.storage.size());
+        if(index >= (1 << PIPELINE_INDEX_BITS))
+        {
+            throw std::runtime_error("Too many pipeline states with different contents!");
+        }
+
+        //The fields that are most expensive to change go in the highest bits.
+        int group = a_BlendData.blend ? 1 : 0;
+        group = (group << 1) | (a_DepthStencilData.enableDepth ? 1 : 0);
+        group = (group << 1) | (a_DepthStencilData.depthWrite ? 1 : 0);
+        group = (group << 1) | (a_DepthStencilData.enableStencil ? 1 : 0);
+        group = (group << 2) | static_cast<int>(a_CullMode);
+        group = (group << 3) | static_cast<int>(a_Topology);
+
+        registry.storage.push_back(PipelineState(a_BlendData, a_Topology, a_CullMode, a_Winding, a_DepthStencilData, (group << PIPELINE_INDEX_BITS) | index));
+        const PipelineState& state = registry.storage.back();
+        registry.states.emplace(std::move(key), &state);
+        return state;
+    }
+
+    std::uint32_t PipelineState::GetInternedCount()
+    {
+        auto& registry = GetPipelineStateRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        return static_cast<std::uint32_t>(registry.storage.size());
     }
 
-    PipelineState& PipelineState::GetDefault()
+    const PipelineState& PipelineState::GetDefault()
     {
-        static PipelineState defaultState;
+        static const PipelineState& defaultState = Intern(BlendData(), TopologyType::TRIANGLES, CullMode::CULL_BACK, WindingOrder::COUNTER_CLOCKWISE, DepthStencilData());
         return defaultState;
     }
 }
@@ -0,0 +1,280 @@
+#include "DrawSorter.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "Material.h"
+#include "MaterialBatch.h"
+#include "Mesh.h"
+
+namespace blurp
+{
+    void DrawSorter::Sort(const DrawData* a_DrawData, std::uint32_t a_Count, const DrawSortSettings& a_Settings)
+    {
+        m_Keys.resize(a_Count);
+        m_Order.resize(a_Count);
+
+        m_PipelineIds.clear();
+        m_ShaderIds.clear();
+        m_MaterialIds.clear();
+        m_MeshIds.clear();
+        m_SortedPipelineIds.clear();
+
+        //Pipeline state ids are ordered so that similar states are next to each other. Rank them so that the dense ids keep that order.
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            const PipelineState* pipelineState = a_DrawData[i].pipelineState != nullptr ? a_DrawData[i].pipelineState : &PipelineState::GetDefault();
+            if(m_PipelineIds.emplace(pipelineState->GetId(), 0).second)
+            {
+                m_SortedPipelineIds.push_back(pipelineState->GetId());
+            }
+        }
+        std::sort(m_SortedPipelineIds.begin(), m_SortedPipelineIds.end());
+        for(std::uint32_t rank = 0; rank < static_cast<std::uint32_t>(m_SortedPipelineIds.size()); ++rank)
+        {
+            m_PipelineIds[m_SortedPipelineIds[rank]] = rank;
+        }
+
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            const auto& drawData = a_DrawData[i];
+            assert(drawData.mesh != nullptr && "Mesh cannot be nullptr!");
+
+            //No pipeline state is treated as the default state.
+            const PipelineState* pipelineState = drawData.pipelineState != nullptr ? drawData.pipelineState : &PipelineState::GetDefault();
+            const bool blended = pipelineState->GetBlendData().blend;
+
+            //Materials and batches share the same field. Only one of them can be enabled at a time.
+            const void* material = nullptr;
+            if(a_Settings.sortMaterials)
+            {
+                if(drawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE))
+                {
+                    material = drawData.materialData.material.get();
+                }
+                else if(drawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH))
+                {
+                    material = drawData.materialData.materialBatch.get();
+                }
+            }
+
+            const auto pipelineId = m_PipelineIds[pipelineState->GetId()];
+            const auto shaderId = GetDenseId(m_ShaderIds, GetShaderMask(drawData, a_Settings.sortMaterials));
+            const auto materialId = GetDenseId(m_MaterialIds, material);
+            const auto meshId = GetDenseId(m_MeshIds, static_cast<const void*>(drawData.mesh.get()));
+            const auto depth = QuantizeDepth(drawData.sortDepth, a_Settings.nearPlane, a_Settings.farPlane);
+
+            m_Keys[i] = MakeKey(blended, pipelineId, shaderId, materialId, meshId, depth);
+            m_Order[i] = i;
+        }
+
+        //Sort a copy so that the keys can still be looked up by DrawData index.
+        m_SortedKeys = m_Keys;
+        RadixSort(m_SortedKeys, m_Order);
+    }
+
+    const std::vector<std::uint32_t>& DrawSorter::GetOrder() const
+    {
+        return m_Order;
+    }
+
+    const std::vector<std::uint64_t>& DrawSorter::GetKeys() const
+    {
+        return m_Keys;
+    }
+
+    std::uint64_t DrawSorter::MakeKey(bool a_Blended, std::uint32_t a_PipelineId, std::uint32_t a_ShaderId, std::uint32_t a_MaterialId, std::uint32_t a_MeshId, std::uint32_t a_Depth)
+    {
+        constexpr std::uint64_t pipelineMax = (1ull << SORT_KEY_PIPELINE_BITS) - 1;
+        constexpr std::uint64_t shaderMax = (1ull << SORT_KEY_SHADER_BITS) - 1;
+        constexpr std::uint64_t materialMax = (1ull << SORT_KEY_MATERIAL_BITS) - 1;
+        constexpr std::uint64_t meshMax = (1ull << SORT_KEY_MESH_BITS) - 1;
+        constexpr std::uint64_t depthMax = (1ull << SORT_KEY_DEPTH_BITS) - 1;
+
+        //Saturate every field so that overflowing values can never bleed into the next field.
+        const std::uint64_t pipeline = std::min<std::uint64_t>(a_PipelineId, pipelineMax);
+        const std::uint64_t shader = std::min<std::uint64_t>(a_ShaderId, shaderMax);
+        const std::uint64_t material = std::min<std::uint64_t>(a_MaterialId, materialMax);
+        const std::uint64_t mesh = std::min<std::uint64_t>(a_MeshId, meshMax);
+        const std::uint64_t depth = std::min<std::uint64_t>(a_Depth, depthMax);
+
+        //State fields, highest priority first.
+        std::uint64_t state = pipeline;
+        state = (state << SORT_KEY_SHADER_BITS) | shader;
+        state = (state << SORT_KEY_MATERIAL_BITS) | material;
+        state = (state << SORT_KEY_MESH_BITS) | mesh;
+
+        constexpr std::uint32_t stateBits = SORT_KEY_PIPELINE_BITS + SORT_KEY_SHADER_BITS + SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS;
+        static_assert(1 + stateBits + SORT_KEY_DEPTH_BITS <= 64, "Sort key fields do not fit in 64 bits.");
+
+        //Everything is aligned against the top bit so that the unused bits end up at the bottom.
+        constexpr std::uint32_t unusedBits = 64 - (1 + stateBits + SORT_KEY_DEPTH_BITS);
+
+        std::uint64_t key;
+        if(!a_Blended)
+        {
+            //Opaque: state first to minimize state changes, then front-to-back.
+            key = (state << SORT_KEY_DEPTH_BITS) | depth;
+        }
+        else
+        {
+            //Blended: back-to-front is required for correct results, so depth comes first (inverted).
+            key = ((depthMax - depth) << stateBits) | state;
+            key |= 1ull << (stateBits + SORT_KEY_DEPTH_BITS);
+        }
+
+        return key << unusedBits;
+    }
+
+    std::uint32_t DrawSorter::QuantizeDepth(float a_Depth, float a_NearPlane, float a_FarPlane)
+    {
+        constexpr float depthMax = static_cast<float>((1u << SORT_KEY_DEPTH_BITS) - 1);
+
+        const float range = a_FarPlane - a_NearPlane;
+        if(range <= 0.f)
+        {
+            return 0;
+        }
+
+        const float normalized = std::clamp((a_Depth - a_NearPlane) / range, 0.f, 1.f);
+        return static_cast<std::uint32_t>(normalized * depthMax);
+    }
+
+    std::uint64_t DrawSorter::GetShaderMask(const DrawData& a_DrawData, bool a_IncludeMaterial)
+    {
+        std::uint64_t mask = static_cast<std::uint64_t>(a_DrawData.mesh->GetVertexAttributeMask()) | (static_cast<std::uint64_t>(a_DrawData.attributes.GetMask()) << NUM_VERTEX_ATRRIBS);
+
+        if(a_IncludeMaterial)
+        {
+            if (a_DrawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE) && a_DrawData.materialData.material != nullptr)
+            {
+                mask |= static_cast<std::uint64_t>(a_DrawData.materialData.material->GetSettings().GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
+            }
+            else if (a_DrawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH) && a_DrawData.materialData.materialBatch != nullptr)
+            {
+                mask |= static_cast<std::uint64_t>(a_DrawData.materialData.materialBatch->GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
+            }
+        }
+
+        return mask;
+    }
+
+    void DrawSorter::RadixSort(std::vector<std::uint64_t>& a_Keys, std::vector<std::uint32_t>& a_Indices)
+    {
+        assert(a_Keys.size() == a_Indices.size() && "Keys and indices need to be the same size!");
+
+        const std::size_t count = a_Keys.size();
+        if(count < 2)
+        {
+            return;
+        }
+
+        std::vector<std::uint64_t> tempKeys(count);
+        std::vector<std::uint32_t> tempIndices(count);
+
+        std::uint64_t* srcKeys = a_Keys.data();
+        std::uint64_t* dstKeys = tempKeys.data();
+        std::uint32_t* srcIndices = a_Indices.data();
+        std::uint32_t* dstIndices = tempIndices.data();
+
+        //8 passes of 8 bits each. Stable, so every pass keeps the order of the previous one.
+        for(std::uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            std::size_t histogram[256] = {};
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                ++histogram[(srcKeys[i] >> shift) & 0xFF];
+            }
+
+            //When every key has the same byte, this pass would not change anything.
+            if(histogram[(srcKeys[0] >> shift) & 0xFF] == count)
+            {
+                continue;
+            }
+
+            //Turn the counts into start offsets.
+            std::size_t offset = 0;
+            for(auto& bucket : histogram)
+            {
+                const auto bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+
+            for(std::size_t i = 0; i < count; ++i)
+            {
+                const auto destination = histogram[(srcKeys[i] >> shift) & 0xFF]++;
+                dstKeys[destination] = srcKeys[i];
+                dstIndices[destination] = srcIndices[i];
+            }
+
+            std::swap(srcKeys, dstKeys);
+            std::swap(srcIndices, dstIndices);
+        }
+
+        //If the result ended up in the temporary buffers, copy it back.
+        if(srcKeys != a_Keys.data())
+        {
+            std::copy(srcKeys, srcKeys + count, a_Keys.data());
+            std::copy(srcIndices, srcIndices + count, a_Indices.data());
+        }
+    }
+
+    DrawStateChanges DrawSorter::CountStateChanges(const DrawData* a_DrawData, const std::uint32_t* a_Order, std::uint32_t a_Count, bool a_IncludeMaterial)
+    {
+        DrawStateChanges changes;
+
+        //Values that can never occur, so that the first draw always counts as a change.
+        int prevPipeline = std::numeric_limits<int>::min();
+        std::uint64_t prevMask = std::numeric_limits<std::uint64_t>::max();
+        const void* prevMaterial = &changes;
+        const void* prevMesh = &changes;
+
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            const auto& drawData = a_DrawData[a_Order != nullptr ? a_Order[i] : i];
+
+            const PipelineState* pipelineState = drawData.pipelineState != nullptr ? drawData.pipelineState : &PipelineState::GetDefault();
+            if(pipelineState->GetId() != prevPipeline)
+            {
+                prevPipeline = pipelineState->GetId();
+                ++changes.pipelineStates;
+            }
+
+            const auto mask = GetShaderMask(drawData, a_IncludeMaterial);
+            if(mask != prevMask)
+            {
+                prevMask = mask;
+                ++changes.shaders;
+            }
+
+            if(a_IncludeMaterial)
+            {
+                const void* material = nullptr;
+                if (drawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE))
+                {
+                    material = drawData.materialData.material.get();
+                }
+                else if (drawData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH))
+                {
+                    material = drawData.materialData.materialBatch.get();
+                }
+
+                if(material != prevMaterial)
+                {
+                    prevMaterial = material;
+                    ++changes.materials;
+                }
+            }
+
+            if(drawData.mesh.get() != prevMesh)
+            {
+                prevMesh = drawData.mesh.get();
+                ++changes.meshes;
+            }
+        }
+
+        return changes;
+    }
+}
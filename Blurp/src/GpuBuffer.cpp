@@ -0,0 +1,53 @@
+#include "GpuBuffer.h"
+
+namespace blurp
+{
+    PerInstanceWriter GpuBuffer::BeginWrite(std::uintptr_t a_Offset, DrawData& a_DrawData)
+    {
+        assert(!IsLocked() && "Cannot write data into a locked GPUBuffer!");
+        assert(m_Settings.access != AccessMode::READ_ONLY && "Attempting to write to a read-only GPU Buffer.");
+        assert(!m_Writing && "Only one GpuBufferWriter can be active at a time!");
+
+        const bool transformEnabled = a_DrawData.attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX);
+        const bool normalMatrixEnabled = a_DrawData.attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX);
+
+        //Same layout as WriteData with PerInstanceUploadData: the enabled matrices interleaved per instance.
+        constexpr auto mat4Size = static_cast<std::uintptr_t>(sizeof(glm::mat4));
+        const std::uintptr_t elementSize = (transformEnabled ? mat4Size : 0) + (normalMatrixEnabled ? mat4Size : 0);
+        assert(elementSize != 0 && "Trying to write DrawAttribute per instance data while no attributes are enabled!");
+
+        const std::uintptr_t alignment = 16u;   //Matrices are always aligned as vec4.
+        const std::uintptr_t totalSize = elementSize * a_DrawData.instanceCount;
+
+        std::uintptr_t start = 0;
+        char* data = OnBeginWrite(a_Offset, totalSize, alignment, start);
+        m_Writing = true;
+
+        const auto view = GpuBufferView(start, totalSize, elementSize);
+
+        PerInstanceWriter writer;
+        if(transformEnabled)
+        {
+            writer.transforms = GpuBufferWriter<glm::mat4>(data, elementSize, a_DrawData.instanceCount, view);
+        }
+        if(normalMatrixEnabled)
+        {
+            //Normal matrices come after the transform when both are enabled.
+            const std::uintptr_t offset = transformEnabled ? mat4Size : 0;
+            writer.normalMatrices = GpuBufferWriter<glm::mat4>(data + offset, elementSize, a_DrawData.instanceCount, view);
+        }
+
+        //Fill in the data in the DrawData provided.
+        a_DrawData.transformData.dataRange = view;
+        a_DrawData.transformData.dataBuffer = std::static_pointer_cast<GpuBuffer>(shared_from_this());
+
+        return writer;
+    }
+
+    void GpuBuffer::EndWrite()
+    {
+        assert(m_Writing && "EndWrite called without an active GpuBufferWriter!");
+        OnEndWrite();
+        m_Writing = false;
+    }
+}
@@ -0,0 +1,243 @@
+#include "GpuBuffer_CPU.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "Light.h"
+
+namespace blurp
+{
+    GpuBuffer_CPU::GpuBuffer_CPU(const GpuBufferSettings& a_Settings) : GpuBuffer(a_Settings), m_Data(a_Settings.size, 0)
+    {
+
+    }
+
+    const std::vector<char>& GpuBuffer_CPU::GetData() const
+    {
+        return m_Data;
+    }
+
+    void GpuBuffer_CPU::OnLock()
+    {
+
+    }
+
+    void GpuBuffer_CPU::OnUnlock()
+    {
+
+    }
+
+    bool GpuBuffer_CPU::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    bool GpuBuffer_CPU::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    std::uintptr_t GpuBuffer_CPU::Reserve(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment)
+    {
+        const std::uintptr_t startPadding = (a_Alignment - (a_Offset & (a_Alignment - 1))) & (a_Alignment - 1);
+        const std::uintptr_t start = a_Offset + startPadding;
+        const auto totalSize = start + a_Size;
+
+        if(totalSize > m_Settings.size)
+        {
+            if(!m_Settings.resizeWhenFull)
+            {
+                throw std::runtime_error("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
+            }
+
+            //Keep doubling till it fits.
+            std::uint32_t newSize = std::max(m_Settings.size, 1u);
+            while(newSize < totalSize)
+            {
+                newSize *= 2;
+            }
+
+            Resize(newSize, true);
+        }
+
+        return start;
+    }
+
+    GpuBufferView GpuBuffer_CPU::OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize, std::uint32_t a_PerDataSize, const void* a_Data)
+    {
+        const std::uintptr_t alignment = GetElementAlignment(a_LargestMemberSize);
+        const std::uintptr_t elementPaddedSize = GetPaddedElementSize(a_PerDataSize, alignment);
+        const std::uintptr_t totalSize = elementPaddedSize * a_Count;
+
+        const std::uintptr_t start = Reserve(a_Offset, totalSize, alignment);
+
+        //Copy every element to its padded position.
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            memcpy(&m_Data[start + (i * elementPaddedSize)], static_cast<const char*>(a_Data) + (i * static_cast<std::uintptr_t>(a_PerDataSize)), a_PerDataSize);
+        }
+
+        return GpuBufferView(start, totalSize, elementPaddedSize);
+    }
+
+    char* GpuBuffer_CPU::OnBeginWrite(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment, std::uintptr_t& a_Start)
+    {
+        a_Start = Reserve(a_Offset, a_Size, a_Alignment);
+        return m_Data.data() + a_Start;
+    }
+
+    void GpuBuffer_CPU::OnEndWrite()
+    {
+
+    }
+
+    bool GpuBuffer_CPU::Resize(std::uint32_t a_Size, bool a_CopyData)
+    {
+        assert(!IsLocked() && "Cannot resize a Gpu Buffer that is currently locked!");
+        assert(!m_Writing && "Cannot resize a Gpu Buffer while a GpuBufferWriter is active!");
+
+        m_Settings.size = a_Size;
+
+        if(!a_CopyData)
+        {
+            m_Data.clear();
+        }
+
+        m_Data.resize(a_Size, 0);
+        return true;
+    }
+
+    void GpuBuffer_CPU::BeginFrame()
+    {
+
+    }
+
+    GpuBufferView GpuBuffer_CPU::WriteData(std::uint32_t a_Offset, const PerInstanceUploadData& a_UploadData)
+    {
+        assert(a_UploadData.drawData != nullptr && "DrawData cannot be nullptr.");
+
+        const bool transformEnabled = a_UploadData.drawData->attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX);
+        const bool normalMatrixEnabled = a_UploadData.drawData->attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX);
+        assert((!transformEnabled || a_UploadData.transforms != nullptr) && "DrawAttribute enabled, but corresponding data is not provided!");
+        assert((!normalMatrixEnabled || a_UploadData.normalMatrices != nullptr) && "DrawAttribute enabled, but corresponding data is not provided!");
+
+        constexpr auto mat4Size = static_cast<std::uintptr_t>(sizeof(glm::mat4));
+        const std::uintptr_t elementSize = (transformEnabled ? mat4Size : 0) + (normalMatrixEnabled ? mat4Size : 0);
+        assert(elementSize != 0 && "Trying to upload DrawAttribute per isntance data while no attributes are enabled!");
+
+        const std::uintptr_t totalSize = elementSize * a_UploadData.drawData->instanceCount;
+        const std::uintptr_t start = Reserve(a_Offset, totalSize, 16u);
+
+        //Interleave the enabled matrices per instance.
+        for(std::uint32_t i = 0; i < a_UploadData.drawData->instanceCount; ++i)
+        {
+            std::uintptr_t pos = start + (i * elementSize);
+            if(transformEnabled)
+            {
+                memcpy(&m_Data[pos], &a_UploadData.transforms[i], mat4Size);
+                pos += mat4Size;
+            }
+            if(normalMatrixEnabled)
+            {
+                memcpy(&m_Data[pos], &a_UploadData.normalMatrices[i], mat4Size);
+            }
+        }
+
+        const auto view = GpuBufferView(start, totalSize, elementSize);
+        a_UploadData.drawData->transformData.dataRange = view;
+        a_UploadData.drawData->transformData.dataBuffer = std::static_pointer_cast<GpuBuffer>(shared_from_this());
+        return view;
+    }
+
+    GpuBufferView GpuBuffer_CPU::WriteData(std::uint32_t a_Offset, const GlobalUploadData& a_UploadData)
+    {
+        assert(a_UploadData.drawData != nullptr && "DrawData cannot be nullptr.");
+        assert(a_UploadData.drawData->attributes.IsAttributeEnabled(DrawAttribute::UV_MODIFIER) && "Trying to upload DrawAttribute per isntance data while no attributes are enabled!");
+
+        const std::uintptr_t elementSize = DRAW_ATTRIBUTE_INFO.find(DrawAttribute::UV_MODIFIER)->second.size;
+        const std::uintptr_t totalSize = elementSize * a_UploadData.drawData->instanceCount;
+        const std::uintptr_t start = Reserve(a_Offset, totalSize, 16u);
+
+        if(totalSize > 0)
+        {
+            memcpy(&m_Data[start], &a_UploadData.uvModifiers[0], totalSize);
+        }
+
+        const auto view = GpuBufferView(start, totalSize, elementSize);
+        a_UploadData.drawData->transformData.dataRange = view;
+        a_UploadData.drawData->transformData.dataBuffer = std::static_pointer_cast<GpuBuffer>(shared_from_this());
+        return view;
+    }
+
+    GpuBufferView GpuBuffer_CPU::WriteData(std::uint32_t a_Offset, const LightUploadData& a_UploadData)
+    {
+        assert(a_UploadData.lightData != nullptr && "Cannot upload light data with nullptr LightData object!");
+
+        //Same layout as the GPU: lights without shadows first, then lights with shadows, for point, spot and directional lights in that order.
+        std::vector<PointLightData> pointData;
+        std::vector<SpotLightData> spotData;
+        std::vector<DirectionalLightData> dirData;
+        std::uint32_t pointCount = 0, spotCount = 0, dirCount = 0;
+
+        for(int shadow = 0; shadow < 2; ++shadow)
+        {
+            for(std::uint32_t i = 0u; a_UploadData.point.lights != nullptr && i < a_UploadData.point.count; ++i)
+            {
+                const auto data = a_UploadData.point.lights[i]->GetData();
+                if((data.positionShadowMapIndex.w >= 0) == (shadow == 1))
+                {
+                    pointData.push_back(data);
+                    pointCount += 1 - shadow;
+                }
+            }
+            for(std::uint32_t i = 0u; a_UploadData.spot.lights != nullptr && i < a_UploadData.spot.count; ++i)
+            {
+                const auto data = a_UploadData.spot.lights[i]->GetData();
+                if((data.positionShadowMapIndex.w >= 0) == (shadow == 1))
+                {
+                    spotData.push_back(data);
+                    spotCount += 1 - shadow;
+                }
+            }
+            for(std::uint32_t i = 0u; a_UploadData.directional.lights != nullptr && i < a_UploadData.directional.count; ++i)
+            {
+                const auto data = a_UploadData.directional.lights[i]->GetData();
+                if((data.directionShadowMapIndex.w >= 0) == (shadow == 1))
+                {
+                    dirData.push_back(data);
+                    dirCount += 1 - shadow;
+                }
+            }
+        }
+
+        const std::uintptr_t pointSize = sizeof(PointLightData) * pointData.size();
+        const std::uintptr_t spotSize = sizeof(SpotLightData) * spotData.size();
+        const std::uintptr_t dirSize = sizeof(DirectionalLightData) * dirData.size();
+        const std::uintptr_t bufferSize = pointSize + spotSize + dirSize;
+
+        const std::uintptr_t offset = Reserve(a_Offset, bufferSize, 16u);
+        if(pointSize > 0) memcpy(&m_Data[offset], pointData.data(), pointSize);
+        if(spotSize > 0) memcpy(&m_Data[offset + pointSize], spotData.data(), spotSize);
+        if(dirSize > 0) memcpy(&m_Data[offset + pointSize + spotSize], dirData.data(), dirSize);
+
+        const auto selfPtr = std::static_pointer_cast<GpuBuffer>(shared_from_this());
+        auto& lightData = *a_UploadData.lightData;
+
+        lightData.pointLights.dataBuffer = selfPtr;
+        lightData.pointLights.dataRange = GpuBufferView(offset, pointSize, sizeof(PointLightData));
+        lightData.pointLights.count = pointCount;
+        lightData.pointLights.shadowCount = static_cast<std::uint32_t>(pointData.size()) - pointCount;
+
+        lightData.spotLights.dataBuffer = selfPtr;
+        lightData.spotLights.dataRange = GpuBufferView(offset + pointSize, spotSize, sizeof(SpotLightData));
+        lightData.spotLights.count = spotCount;
+        lightData.spotLights.shadowCount = static_cast<std::uint32_t>(spotData.size()) - spotCount;
+
+        lightData.directionalLights.dataBuffer = selfPtr;
+        lightData.directionalLights.dataRange = GpuBufferView(offset + pointSize + spotSize, dirSize, sizeof(DirectionalLightData));
+        lightData.directionalLights.count = dirCount;
+        lightData.directionalLights.shadowCount = static_cast<std::uint32_t>(dirData.size()) - dirCount;
+
+        return GpuBufferView(offset, bufferSize, 1);
+    }
+}
@@ -1,6 +1,7 @@
 #include "opengl/GpuBuffer_GL.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 
 #include "opengl/GLUtils.h"
@@ -8,7 +9,63 @@
 
 namespace blurp
 {
-    GpuBuffer_GL::GpuBuffer_GL(const GpuBufferSettings& a_Settings): GpuBuffer(a_Settings), m_Ssbo(0)
+    RingBufferFence_GL::~RingBufferFence_GL()
+    {
+        for(auto& fence : m_Fences)
+        {
+            glDeleteSync(fence.second);
+        }
+    }
+
+    void RingBufferFence_GL::Insert(std::uint64_t a_FrameId)
+    {
+        m_Fences.emplace_back(a_FrameId, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+
+    bool RingBufferFence_GL::IsComplete(std::uint64_t a_FrameId)
+    {
+        assert(!m_Fences.empty() && m_Fences.front().first == a_FrameId && "Ring buffer fences have to be retired in order!");
+
+        //Poll without waiting.
+        const GLenum result = glClientWaitSync(m_Fences.front().second, 0, 0);
+        if(result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            glDeleteSync(m_Fences.front().second);
+            m_Fences.pop_front();
+            return true;
+        }
+
+        return false;
+    }
+
+    void RingBufferFence_GL::Wait(std::uint64_t a_FrameId)
+    {
+        assert(!m_Fences.empty() && m_Fences.front().first == a_FrameId && "Ring buffer fences have to be retired in order!");
+
+        //Flush so that the fence is guaranteed to be submitted, then wait in steps of 1ms.
+        constexpr GLuint64 timeout = 1000000;
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while(true)
+        {
+            const GLenum result = glClientWaitSync(m_Fences.front().second, flags, timeout);
+            if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+
+            if(result == GL_WAIT_FAILED)
+            {
+                throw std::runtime_error("Waiting for ring buffer fence failed!");
+            }
+
+            flags = 0;
+        }
+
+        glDeleteSync(m_Fences.front().second);
+        m_Fences.pop_front();
+    }
+
+    GpuBuffer_GL::GpuBuffer_GL(const GpuBufferSettings& a_Settings): GpuBuffer(a_Settings), m_Ssbo(0), m_BindAlignment(1), m_MappedData(nullptr), m_RangeMapped(false)
     {
 
     }
@@ -30,36 +87,84 @@ namespace blurp
 
     bool GpuBuffer_GL::OnLoad(BlurpEngine& a_BlurpEngine)
     {
-        glGenBuffers(1, &m_Ssbo);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Ssbo);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, m_Settings.size, nullptr, ToGL(m_Settings.memoryUsage));
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_BindAlignment);
+
+        m_Ssbo = CreateStorage(m_Settings.size);
+
+        if(m_Settings.persistentRingBuffer)
+        {
+            m_RingAllocator = std::make_unique<RingBufferAllocator>(m_Settings.size, m_Settings.ringBufferFrames, m_RingFence);
+        }
 
         return true;
     }
 
     bool GpuBuffer_GL::OnDestroy(BlurpEngine& a_BlurpEngine)
     {
+        if(m_MappedData != nullptr)
+        {
+            glUnmapNamedBuffer(m_Ssbo);
+            m_MappedData = nullptr;
+        }
+
         glDeleteBuffers(1, &m_Ssbo);
         return true;
     }
 
-    GpuBufferView GpuBuffer_GL::OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize,
-        std::uint32_t a_PerDataSize, const void* a_Data)
+    GLuint GpuBuffer_GL::CreateStorage(std::uint32_t a_Size)
     {
-        //Alignment for std430 is equal to the largest member size.
-        const std::uintptr_t alignment = std::min(16u, a_LargestMemberSize);
-        const std::uintptr_t startPadding = (alignment - (a_Offset & (alignment - 1))) & (alignment - 1);
-        const std::uintptr_t elementPadding = (alignment - (a_PerDataSize & (alignment - 1))) & (alignment - 1);
-        const std::uintptr_t elementPaddedSize = elementPadding +  a_PerDataSize;
-        const std::uintptr_t sizeFromAlignedStart = elementPaddedSize * a_Count;
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+        if(m_Settings.persistentRingBuffer)
+        {
+            //Immutable storage that stays mapped. Coherent so that no explicit flushing is needed.
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_SHADER_STORAGE_BUFFER, a_Size, nullptr, flags);
+            m_MappedData = static_cast<char*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, a_Size, flags));
 
+            if(m_MappedData == nullptr)
+            {
+                throw std::runtime_error("Could not persistently map ring buffer!");
+            }
+        }
+        else
+        {
+            glBufferData(GL_SHADER_STORAGE_BUFFER, a_Size, nullptr, ToGL(m_Settings.memoryUsage));
+        }
 
-        //The size of the newly added data when padded.
-        const std::uintptr_t paddedSize = startPadding + (a_Count * elementPaddedSize);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return buffer;
+    }
+
+    std::uintptr_t GpuBuffer_GL::Reserve(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment)
+    {
+        //Ring buffers decide the offset themselves. Bound ranges have to respect the binding alignment as well.
+        if(m_RingAllocator != nullptr)
+        {
+            const std::uint64_t alignment = std::max(static_cast<std::uint64_t>(a_Alignment), static_cast<std::uint64_t>(m_BindAlignment));
+            std::uint64_t start = 0;
+
+            while(!m_RingAllocator->Allocate(a_Size, alignment, start))
+            {
+                //A single frame does not fit in the ring.
+                if(!m_Settings.resizeWhenFull)
+                {
+                    throw std::runtime_error("Ring buffer size limit reached. A single frame does not fit. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
+                }
+
+                Resize(m_Settings.size * 2, true);
+            }
+
+            return static_cast<std::uintptr_t>(start);
+        }
+
+        const std::uintptr_t startPadding = (a_Alignment - (a_Offset & (a_Alignment - 1))) & (a_Alignment - 1);
+        const std::uintptr_t start = a_Offset + startPadding;
 
         //The total size required with the new data.
-        const auto totalSize = a_Offset + paddedSize;
+        const auto totalSize = start + a_Size;
 
         //Overwriting buffer limits.
         if (totalSize > m_Settings.size)
@@ -80,31 +185,105 @@ namespace blurp
             //No auto resizing allowed so crash the program.
             else
             {
-                throw std::exception("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
+                throw std::runtime_error("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
             }
         }
 
-        //Bind the buffer and write to it.
+        return start;
+    }
+
+    void GpuBuffer_GL::Upload(std::uintptr_t a_Start, std::uintptr_t a_Size, const void* a_Data)
+    {
+        if(a_Size == 0)
+        {
+            return;
+        }
+
+        //Mapped memory can be written directly.
+        if(m_MappedData != nullptr)
+        {
+            memcpy(m_MappedData + a_Start, a_Data, a_Size);
+            return;
+        }
+
         glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Ssbo);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, a_Start, a_Size, a_Data);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+
+    GpuBufferView GpuBuffer_GL::OnWrite(std::uintptr_t a_Offset, std::uint32_t a_Count, std::uint32_t a_LargestMemberSize,
+        std::uint32_t a_PerDataSize, const void* a_Data)
+    {
+        const std::uintptr_t alignment = GetElementAlignment(a_LargestMemberSize);
+        const std::uintptr_t elementPaddedSize = GetPaddedElementSize(a_PerDataSize, alignment);
+        const std::uintptr_t sizeFromAlignedStart = elementPaddedSize * a_Count;
+
+        //Find where the data goes, resizing or waiting for the GPU when needed.
+        const std::uintptr_t start = Reserve(a_Offset, sizeFromAlignedStart, alignment);
 
-        //Reserve enough memory to temporarily store the data and add padding.
+        //Ring buffers are written in place. Other buffers use a temporary buffer to add the padding.
         std::vector<char> paddedData;
-        paddedData.resize(paddedSize);
+        char* destination = m_MappedData;
+        if(destination != nullptr)
+        {
+            destination += start;
+        }
+        else
+        {
+            paddedData.resize(sizeFromAlignedStart);
+            destination = paddedData.data();
+        }
 
-        //Add the data, skipping the start alignment padding.
+        //Add the data with padding after each element.
         for(std::uint32_t i = 0; i < a_Count; ++i)
         {
-            const auto index = startPadding + (i * elementPaddedSize);
-            memcpy(static_cast<void*>(&paddedData[index]), reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(a_Data) + (i * static_cast<std::uintptr_t>(a_PerDataSize))), a_PerDataSize);
+            const auto index = i * elementPaddedSize;
+            memcpy(static_cast<void*>(destination + index), reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(a_Data) + (i * static_cast<std::uintptr_t>(a_PerDataSize))), a_PerDataSize);
         }
 
         //Upload the padded data to the GPU.
-        glBufferSubData(GL_SHADER_STORAGE_BUFFER, a_Offset, paddedSize, &paddedData[0]);
+        if(!paddedData.empty())
+        {
+            Upload(start, sizeFromAlignedStart, paddedData.data());
+        }
 
-        //Unbind the buffer.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return GpuBufferView(start, sizeFromAlignedStart, elementPaddedSize);
+    }
+
+    char* GpuBuffer_GL::OnBeginWrite(std::uintptr_t a_Offset, std::uintptr_t a_Size, std::uintptr_t a_Alignment, std::uintptr_t& a_Start)
+    {
+        //Find where the data goes, resizing or waiting for the GPU when needed.
+        a_Start = Reserve(a_Offset, a_Size, a_Alignment);
+
+        //Ring buffers are always mapped.
+        if(m_MappedData != nullptr)
+        {
+            return m_MappedData + a_Start;
+        }
+
+        if(a_Size == 0)
+        {
+            return nullptr;
+        }
+
+        //Map only the range that is written. The old contents of the range are discarded so that the driver does not need to sync.
+        void* data = glMapNamedBufferRange(m_Ssbo, a_Start, a_Size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if(data == nullptr)
+        {
+            throw std::runtime_error("Could not map GPU buffer range for writing!");
+        }
+
+        m_RangeMapped = true;
+        return static_cast<char*>(data);
+    }
 
-        return GpuBufferView(a_Offset + startPadding, sizeFromAlignedStart, elementPaddedSize);
+    void GpuBuffer_GL::OnEndWrite()
+    {
+        if(m_RangeMapped)
+        {
+            glUnmapNamedBuffer(m_Ssbo);
+            m_RangeMapped = false;
+        }
     }
 
     bool GpuBuffer_GL::Resize(std::uint32_t a_Size, bool a_CopyData)
@@ -115,8 +294,25 @@ namespace blurp
         const auto oldSize = m_Settings.size;
         m_Settings.size = a_Size;
 
+        //Ring buffers have immutable storage, so they always need a new buffer. Offsets handed out this frame stay valid, so the data is always copied.
+        if(m_RingAllocator != nullptr)
+        {
+            //The old buffer may still be read by the GPU.
+            m_RingAllocator->WaitIdle();
+
+            //Mapped memory is write only, so copy on the GPU. Wait for the copy so that new writes can not be overwritten by it.
+            const GLuint oldBuffer = m_Ssbo;
+            m_Ssbo = CreateStorage(m_Settings.size);
+            glCopyNamedBufferSubData(oldBuffer, m_Ssbo, 0, 0, std::min(oldSize, m_Settings.size));
+            glFinish();
+
+            glUnmapNamedBuffer(oldBuffer);
+            glDeleteBuffers(1, &oldBuffer);
+
+            m_RingAllocator->Resize(m_Settings.size);
+        }
         //Copy old data to the new buffer if specified.
-        if(a_CopyData)
+        else if(a_CopyData)
         {
             //Create a new bigger buffer.
             GLuint tempBuffer;
@@ -144,6 +340,14 @@ namespace blurp
         return true;
     }
 
+    void GpuBuffer_GL::BeginFrame()
+    {
+        if(m_RingAllocator != nullptr)
+        {
+            m_RingAllocator->BeginFrame();
+        }
+    }
+
     GpuBufferView GpuBuffer_GL::WriteData(std::uint32_t a_Offset, const PerInstanceUploadData& a_UploadData)
     {
         assert(a_UploadData.drawData != nullptr && "DrawData cannot be nullptr.");
@@ -177,41 +381,10 @@ namespace blurp
         assert(elementSize != 0 && "Trying to upload DrawAttribute per isntance data while no attributes are enabled!");
 
         const std::uintptr_t alignment = 16u;   //Upload data exists out of mat4 and vec3s. This means that alignment is always that of vec4. Padding only happens for vec3.
-        const std::uintptr_t startPadding = (alignment - (a_Offset & (alignment - 1))) & (alignment - 1);
         const std::uintptr_t totalElementSize = elementSize * a_UploadData.drawData->instanceCount;
 
-
-        //The size of the newly added data when padded.
-        const std::uintptr_t totalSizeWithOffset = startPadding + (a_UploadData.drawData->instanceCount * elementSize);
-
-        //The total size required with the new data.
-        const auto endOffset = a_Offset + totalSizeWithOffset;
-
-        //Resize buffer if needed and enabled.
-        if (endOffset > m_Settings.size)
-        {
-            //Resize to double the size. Create a new buffer and move data into it.
-            if (m_Settings.resizeWhenFull)
-            {
-                //Keep doubling till it fits.
-                std::uint32_t newSize = m_Settings.size;
-                while (newSize < endOffset)
-                {
-                    newSize *= 2;
-                }
-
-                //Resize and copy the data.
-                Resize(newSize, true);
-            }
-            //No auto resizing allowed so crash the program.
-            else
-            {
-                throw std::exception("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
-            }
-        }
-
-        //Bind the buffer and write to it.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Ssbo);
+        //Find where the data goes, resizing or waiting for the GPU when needed.
+        const std::uintptr_t start = Reserve(a_Offset, totalElementSize, alignment);
 
         constexpr auto mat4Size = static_cast<std::uintptr_t>(sizeof(glm::mat4));
 
@@ -221,45 +394,53 @@ namespace blurp
         {
             glm::mat4* ptr = normalMatrixEnabled ? a_UploadData.normalMatrices : a_UploadData.transforms;
 
-            //Upload the padded data to the GPU, directly from the passed pointer since there is no interleaving.
-            glBufferSubData(GL_SHADER_STORAGE_BUFFER, a_Offset + startPadding, totalSizeWithOffset, &ptr[0]);
-            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            //Upload the data to the GPU, directly from the passed pointer since there is no interleaving.
+            Upload(start, totalElementSize, &ptr[0]);
         }
         else
         {
-            //Reserve enough memory to temporarily store the data and add padding.
+            //Ring buffers are interleaved in place. Other buffers use a temporary buffer.
             std::vector<char> paddedData;
-            paddedData.resize(totalSizeWithOffset);
+            char* destination = m_MappedData;
+            if (destination != nullptr)
+            {
+                destination += start;
+            }
+            else
+            {
+                paddedData.resize(totalElementSize);
+                destination = paddedData.data();
+            }
 
             //Add each element to the buffer with the required offset and position/padding.
             for (std::uint32_t i = 0; i < a_UploadData.drawData->instanceCount; ++i)
             {
-                const auto start = startPadding + (i * elementSize);
+                const auto elementStart = i * elementSize;
                 std::uint32_t offset = 0;   //Offset from start where to place elements.
 
                 if (transformEnabled)
                 {
-                    const auto pos = start + offset;
-                    memcpy(static_cast<void*>(&paddedData[pos]), static_cast<void*>(&a_UploadData.transforms[i]), mat4Size);
+                    const auto pos = elementStart + offset;
+                    memcpy(static_cast<void*>(destination + pos), static_cast<void*>(&a_UploadData.transforms[i]), mat4Size);
                     offset += mat4Size;
                 }
                 if (normalMatrixEnabled)
                 {
-                    const auto pos = start + offset;
-                    memcpy(static_cast<void*>(&paddedData[pos]), static_cast<void*>(&a_UploadData.normalMatrices[i]), mat4Size);
+                    const auto pos = elementStart + offset;
+                    memcpy(static_cast<void*>(destination + pos), static_cast<void*>(&a_UploadData.normalMatrices[i]), mat4Size);
                     offset += mat4Size;
                 }
             }
 
             //Upload the padded data to the GPU.
-            glBufferSubData(GL_SHADER_STORAGE_BUFFER, a_Offset, totalSizeWithOffset, &paddedData[0]);
-
-            //Unbind the buffer.
-            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            if (!paddedData.empty())
+            {
+                Upload(start, totalElementSize, paddedData.data());
+            }
         }
 
         //Create a view containing the buffer offsets.
-        const auto view = GpuBufferView(a_Offset + startPadding, totalElementSize, elementSize);
+        const auto view = GpuBufferView(start, totalElementSize, elementSize);
         const auto selfPtr = std::static_pointer_cast<GpuBuffer>(shared_from_this());
 
         //Fill in the data in the DrawData provided.
@@ -291,55 +472,18 @@ namespace blurp
         assert(elementSize != 0 && "Trying to upload DrawAttribute per isntance data while no attributes are enabled!");
 
         const std::uintptr_t alignment = 16u;   //Upload data exists out of mat4 and vec3s. This means that alignment is always that of vec4. Padding only happens for vec3.
-        const std::uintptr_t startPadding = (alignment - (a_Offset & (alignment - 1))) & (alignment - 1);
         const std::uintptr_t totalElementSize = elementSize * a_UploadData.drawData->instanceCount;
 
-
-        //The size of the newly added data when padded.
-        const std::uintptr_t totalSizeWithOffset = startPadding + (a_UploadData.drawData->instanceCount * elementSize);
-
-        //The total size required with the new data.
-        const auto endOffset = a_Offset + totalSizeWithOffset;
-
-        //Resize buffer if needed and enabled.
-        if (endOffset > m_Settings.size)
-        {
-            //Resize to double the size. Create a new buffer and move data into it.
-            if (m_Settings.resizeWhenFull)
-            {
-                //Keep doubling till it fits.
-                std::uint32_t newSize = m_Settings.size;
-                while (newSize < endOffset)
-                {
-                    newSize *= 2;
-                }
-
-                //Resize and copy the data.
-                Resize(newSize, true);
-            }
-            //No auto resizing allowed so crash the program.
-            else
-            {
-                throw std::exception("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
-            }
-        }
+        //Find where the data goes, resizing or waiting for the GPU when needed.
+        const std::uintptr_t start = Reserve(a_Offset, totalElementSize, alignment);
 
         /*
          * This is a single vec4 aligned buffer so no padding needed. Can just upload straight from the passed pointer.
-         * I only have to add the startPadding to the offset where it is uploaded to the buffer manually.
          */
-
-        //Bind the buffer and write to it.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Ssbo);
-
-        //Upload the padded data to the GPU.
-        glBufferSubData(GL_SHADER_STORAGE_BUFFER, a_Offset + startPadding, totalElementSize, &a_UploadData.uvModifiers[0]);
-
-        //Unbind the buffer.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        Upload(start, totalElementSize, &a_UploadData.uvModifiers[0]);
 
         //Create a view containing the buffer offsets.
-        auto view = GpuBufferView(a_Offset + startPadding, totalElementSize, elementSize);
+        auto view = GpuBufferView(start, totalElementSize, elementSize);
         auto selfPtr = std::static_pointer_cast<GpuBuffer>(shared_from_this());
 
         //Fill in the data in the DrawData provided.
@@ -475,44 +619,16 @@ namespace blurp
 
         //Alignment for std430 is equal to the largest member size.
         const std::uintptr_t alignment = 16u;
-        const std::uintptr_t startPadding = (alignment - (a_Offset & (alignment - 1))) & (alignment - 1);
 
-        //The total size required with the new data.
-        const auto totalSize = a_Offset + startPadding + bufferSize;
-        auto offset = a_Offset + startPadding;
+        //Find where the data goes, resizing or waiting for the GPU when needed.
+        const auto offset = Reserve(a_Offset, bufferSize, alignment);
 
-        //Overwriting buffer limits.
-        if (totalSize > m_Settings.size)
+        //Upload the data to the GPU.
+        if(bufferSize > 0)
         {
-            //Resize to double the size. Create a new buffer and move data into it.
-            if (m_Settings.resizeWhenFull)
-            {
-                //Keep doubling till it fits.
-                std::uint32_t newSize = m_Settings.size;
-                while (newSize < totalSize)
-                {
-                    newSize *= 2;
-                }
-
-                //Resize and copy the data.
-                Resize(newSize, true);
-            }
-            //No auto resizing allowed so crash the program.
-            else
-            {
-                throw std::exception("Gpu Buffer size limit reached. Assign more space to the buffer by increasing setting.size or enable auto resizing.");
-            }
+            Upload(offset, bufferSize, &buffer[0]);
         }
 
-        //Bind the buffer and write to it.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_Ssbo);
-
-        //Upload the padded data to the GPU.
-        glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bufferSize, &buffer[0]);
-
-        //Unbind the buffer.
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-
 
         /*
          * Finally fill in the LightData object.
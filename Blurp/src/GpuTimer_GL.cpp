@@ -0,0 +1,134 @@
+#include "opengl/GpuTimer_GL.h"
+
+#include <cassert>
+
+#include <GL/glew.h>
+
+namespace blurp
+{
+    GpuTimer_GL::GpuTimer_GL() : m_Current(0), m_Profiler(nullptr), m_InRange(false)
+    {
+    }
+
+    void GpuTimer_GL::BeginFrame(Profiler& a_Profiler)
+    {
+        assert(!m_InRange && "GPU timer range was not ended before the next frame!");
+        m_Profiler = &a_Profiler;
+
+        //Oldest frame first, so that markers are added in order. Queries finish in the order they were submitted, so the first frame that is not done ends the search.
+        for (std::uint32_t offset = 1; offset <= FRAME_LATENCY; ++offset)
+        {
+            if (!Resolve(m_Frames[(m_Current + offset) % FRAME_LATENCY], false))
+            {
+                break;
+            }
+        }
+
+        //The oldest frame is reused. Its results are only still pending when the GPU is far behind, in which case this waits for them.
+        m_Current = (m_Current + 1) % FRAME_LATENCY;
+        auto& frame = m_Frames[m_Current];
+        Resolve(frame, true);
+
+        //The GPU clock is sampled together with the profiler clock, so that timestamps can be converted to profiler time.
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        frame.frame = a_Profiler.GetFrameIndex();
+        frame.gpuReference = gpuNow;
+        frame.cpuReference = a_Profiler.Now();
+    }
+
+    void GpuTimer_GL::Begin(const char* a_Name)
+    {
+        if (m_Profiler == nullptr)
+        {
+            return;
+        }
+
+        assert(!m_InRange && "GPU timer ranges can not overlap!");
+        m_InRange = true;
+
+        auto& frame = m_Frames[m_Current];
+        frame.ranges.push_back(Range{ a_Name, NextQuery(), 0 });
+        glQueryCounter(frame.ranges.back().begin, GL_TIMESTAMP);
+    }
+
+    void GpuTimer_GL::End()
+    {
+        if (!m_InRange)
+        {
+            return;
+        }
+
+        m_InRange = false;
+
+        auto& range = m_Frames[m_Current].ranges.back();
+        range.end = NextQuery();
+        glQueryCounter(range.end, GL_TIMESTAMP);
+    }
+
+    void GpuTimer_GL::Destroy()
+    {
+        for (auto& frame : m_Frames)
+        {
+            if (!frame.queries.empty())
+            {
+                glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            }
+            frame.queries.clear();
+            frame.ranges.clear();
+            frame.usedQueries = 0;
+        }
+
+        m_Profiler = nullptr;
+        m_InRange = false;
+    }
+
+    bool GpuTimer_GL::Resolve(FrameQueries& a_Frame, bool a_Wait)
+    {
+        if (a_Frame.ranges.empty())
+        {
+            a_Frame.usedQueries = 0;
+            return true;
+        }
+
+        //The last query of a frame finishes last, so every result is available when it is.
+        if (!a_Wait)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(a_Frame.ranges.back().end, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE)
+            {
+                return false;
+            }
+        }
+
+        for (const auto& range : a_Frame.ranges)
+        {
+            GLuint64 begin = 0;
+            GLuint64 end = 0;
+            glGetQueryObjectui64v(range.begin, GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(range.end, GL_QUERY_RESULT, &end);
+
+            //Timestamps are in nanoseconds, the profiler uses microseconds.
+            const double start = a_Frame.cpuReference + static_cast<double>(static_cast<std::int64_t>(begin) - a_Frame.gpuReference) / 1000.0;
+            m_Profiler->AddGpuEvent(a_Frame.frame, range.name, start, static_cast<double>(end - begin) / 1000.0);
+        }
+
+        a_Frame.ranges.clear();
+        a_Frame.usedQueries = 0;
+        return true;
+    }
+
+    std::uint32_t GpuTimer_GL::NextQuery()
+    {
+        auto& frame = m_Frames[m_Current];
+        if (frame.usedQueries == frame.queries.size())
+        {
+            GLuint query = 0;
+            glGenQueries(1, &query);
+            frame.queries.push_back(query);
+        }
+
+        return frame.queries[frame.usedQueries++];
+    }
+}
@@ -0,0 +1,337 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace blurp
+{
+    namespace
+    {
+        //The job system that the calling thread is a worker of, and its index in it.
+        thread_local const JobSystem* t_JobSystem = nullptr;
+        thread_local std::uint32_t t_ThreadIndex = 0;
+    }
+
+    JobCounter::JobCounter() : m_Count(0)
+    {
+    }
+
+    bool JobCounter::IsDone() const
+    {
+        return m_Count.load() == 0;
+    }
+
+    JobSystem::JobSystem(std::uint32_t a_WorkerCount) : m_MainThread(std::this_thread::get_id()), m_QueuedJobs(0), m_Stop(false), m_JobCount(0), m_StolenCount(0), m_MainThreadJobCount(0)
+    {
+        //Queues are created before any worker starts, because workers steal from all of them.
+        for (std::uint32_t thread = 0; thread <= a_WorkerCount; ++thread)
+        {
+            m_Queues.push_back(std::make_unique<JobQueue>());
+        }
+
+        m_Workers.reserve(a_WorkerCount);
+        for (std::uint32_t worker = 0; worker < a_WorkerCount; ++worker)
+        {
+            m_Workers.emplace_back(&JobSystem::WorkerLoop, this, worker + 1);
+        }
+    }
+
+    JobSystem::~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stop = true;
+        }
+        m_WakeUp.notify_all();
+
+        for (auto& worker : m_Workers)
+        {
+            worker.join();
+        }
+    }
+
+    void JobSystem::Run(const Job& a_Job, JobCounter* a_Counter, const std::vector<JobCounter*>& a_Dependencies)
+    {
+        //Counted right away, so that waiting for the counter includes jobs that still wait for their dependencies.
+        if (a_Counter != nullptr)
+        {
+            ++a_Counter->m_Count;
+        }
+        Schedule(QueuedJob{ a_Job, a_Counter, 0 }, false, std::make_shared<std::vector<JobCounter*>>(a_Dependencies), 0);
+    }
+
+    void JobSystem::RunOnMainThread(const Job& a_Job, JobCounter* a_Counter, const std::vector<JobCounter*>& a_Dependencies)
+    {
+        if (a_Counter != nullptr)
+        {
+            ++a_Counter->m_Count;
+        }
+        Schedule(QueuedJob{ a_Job, a_Counter, 0 }, true, std::make_shared<std::vector<JobCounter*>>(a_Dependencies), 0);
+    }
+
+    void JobSystem::Wait(JobCounter& a_Counter)
+    {
+        const std::uint32_t thread = GetThreadIndex();
+        const bool mainThread = IsMainThread();
+
+        while (!a_Counter.IsDone())
+        {
+            QueuedJob job;
+            if ((mainThread && TakeMainThreadJob(job)) || TakeJob(thread, job))
+            {
+                Execute(job, thread);
+            }
+            else
+            {
+                //The remaining jobs are running on other threads, or wait for jobs that are.
+                std::this_thread::yield();
+            }
+        }
+
+        //The thread that finished the last job holds the mutex until it no longer uses the counter, so the counter can be destroyed after this.
+        std::exception_ptr exception;
+        {
+            std::lock_guard<std::mutex> lock(a_Counter.m_Mutex);
+            std::swap(exception, a_Counter.m_Exception);
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void JobSystem::ParallelFor(std::uint32_t a_Count, std::uint32_t a_Grain, const RangeJob& a_Job)
+    {
+        const std::uint32_t grain = std::max(a_Grain, 1u);
+        const std::uint32_t numRanges = (a_Count + grain - 1) / grain;
+
+        //Without other threads to help, the ranges are called right away in order.
+        if (numRanges <= 1 || m_Workers.empty())
+        {
+            for (std::uint32_t begin = 0; begin < a_Count; begin += grain)
+            {
+                a_Job(begin, std::min(begin + grain, a_Count));
+            }
+            return;
+        }
+
+        //The ranges are queued last to first, so that this thread starts with the first range while other threads steal from the end.
+        JobCounter counter;
+        for (std::uint32_t range = numRanges; range > 0; --range)
+        {
+            const std::uint32_t begin = (range - 1) * grain;
+            const std::uint32_t end = std::min(begin + grain, a_Count);
+            Run([&a_Job, begin, end]() { a_Job(begin, end); }, &counter);
+        }
+        Wait(counter);
+    }
+
+    void JobSystem::RunMainThreadJobs()
+    {
+        assert(IsMainThread() && "Main thread jobs can only be run on the main thread!");
+
+        QueuedJob job;
+        while (TakeMainThreadJob(job))
+        {
+            Execute(job, 0);
+        }
+    }
+
+    std::uint32_t JobSystem::GetWorkerCount() const
+    {
+        return static_cast<std::uint32_t>(m_Workers.size());
+    }
+
+    std::uint32_t JobSystem::GetThreadCount() const
+    {
+        return static_cast<std::uint32_t>(m_Workers.size()) + 1;
+    }
+
+    bool JobSystem::IsMainThread() const
+    {
+        return std::this_thread::get_id() == m_MainThread;
+    }
+
+    JobSystemStats JobSystem::GetStats() const
+    {
+        JobSystemStats stats;
+        stats.jobs = m_JobCount.load();
+        stats.stolen = m_StolenCount.load();
+        stats.mainThreadJobs = m_MainThreadJobCount.load();
+        return stats;
+    }
+
+    void JobSystem::Schedule(QueuedJob&& a_Job, bool a_MainThread, std::shared_ptr<std::vector<JobCounter*>> a_Dependencies, std::size_t a_First)
+    {
+        //Wait for the first dependency that is not done. When it is done, the remaining ones are checked again.
+        for (std::size_t i = a_First; i < a_Dependencies->size(); ++i)
+        {
+            JobCounter* dependency = (*a_Dependencies)[i];
+            if (dependency == nullptr)
+            {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(dependency->m_Mutex);
+            if (!dependency->IsDone())
+            {
+                auto job = std::make_shared<QueuedJob>(std::move(a_Job));
+                dependency->m_Continuations.push_back([this, job, a_MainThread, a_Dependencies, i]()
+                {
+                    Schedule(std::move(*job), a_MainThread, a_Dependencies, i + 1);
+                });
+                return;
+            }
+        }
+
+        Enqueue(std::move(a_Job), a_MainThread);
+    }
+
+    void JobSystem::Enqueue(QueuedJob&& a_Job, bool a_MainThread)
+    {
+        if (a_MainThread)
+        {
+            std::lock_guard<std::mutex> lock(m_MainThreadJobs.mutex);
+            a_Job.queue = 0;
+            m_MainThreadJobs.jobs.push_back(std::move(a_Job));
+            return;
+        }
+
+        const std::uint32_t thread = GetThreadIndex();
+        a_Job.queue = thread;
+        {
+            std::lock_guard<std::mutex> lock(m_Queues[thread]->mutex);
+            m_Queues[thread]->jobs.push_back(std::move(a_Job));
+        }
+
+        //Counted after the job is queued, so a worker that wakes up always finds it.
+        ++m_QueuedJobs;
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+        }
+        m_WakeUp.notify_one();
+    }
+
+    bool JobSystem::TakeJob(std::uint32_t a_Thread, QueuedJob& a_Job)
+    {
+        //The newest job of this thread first, because its data is most likely still in the cache.
+        {
+            auto& queue = *m_Queues[a_Thread];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                a_Job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                --m_QueuedJobs;
+                return true;
+            }
+        }
+
+        //Steal the oldest job of another thread, which is usually the largest piece of work that is left.
+        const std::uint32_t numQueues = static_cast<std::uint32_t>(m_Queues.size());
+        for (std::uint32_t offset = 1; offset < numQueues; ++offset)
+        {
+            auto& queue = *m_Queues[(a_Thread + offset) % numQueues];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                a_Job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                --m_QueuedJobs;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool JobSystem::TakeMainThreadJob(QueuedJob& a_Job)
+    {
+        std::lock_guard<std::mutex> lock(m_MainThreadJobs.mutex);
+        if (m_MainThreadJobs.jobs.empty())
+        {
+            return false;
+        }
+
+        a_Job = std::move(m_MainThreadJobs.jobs.front());
+        m_MainThreadJobs.jobs.pop_front();
+        ++m_MainThreadJobCount;
+        return true;
+    }
+
+    void JobSystem::Finish(JobCounter& a_Counter)
+    {
+        //The continuations are called after the mutex is released, because the counter may be destroyed as soon as it is.
+        std::vector<std::function<void()>> continuations;
+        {
+            std::lock_guard<std::mutex> lock(a_Counter.m_Mutex);
+            if (--a_Counter.m_Count == 0)
+            {
+                continuations.swap(a_Counter.m_Continuations);
+            }
+        }
+
+        for (auto& continuation : continuations)
+        {
+            continuation();
+        }
+    }
+
+    void JobSystem::Execute(QueuedJob& a_Job, std::uint32_t a_Thread)
+    {
+        ++m_JobCount;
+        if (a_Job.queue != a_Thread)
+        {
+            ++m_StolenCount;
+        }
+
+        //Jobs without a counter have nobody to pass their exception on to.
+        if (a_Job.counter == nullptr)
+        {
+            a_Job.job();
+            return;
+        }
+
+        try
+        {
+            a_Job.job();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(a_Job.counter->m_Mutex);
+            if (!a_Job.counter->m_Exception)
+            {
+                a_Job.counter->m_Exception = std::current_exception();
+            }
+        }
+
+        //Release the captures of the job before it counts as finished, they may refer to data that is destroyed after waiting.
+        a_Job.job = nullptr;
+        Finish(*a_Job.counter);
+    }
+
+    void JobSystem::WorkerLoop(std::uint32_t a_Thread)
+    {
+        t_JobSystem = this;
+        t_ThreadIndex = a_Thread;
+
+        while (!m_Stop)
+        {
+            QueuedJob job;
+            if (TakeJob(a_Thread, job))
+            {
+                Execute(job, a_Thread);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_WakeUp.wait(lock, [this]() { return m_Stop || m_QueuedJobs > 0; });
+        }
+    }
+
+    std::uint32_t JobSystem::GetThreadIndex() const
+    {
+        return t_JobSystem == this ? t_ThreadIndex : 0;
+    }
+}
@@ -0,0 +1,413 @@
+#include "LightClusterBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "Camera.h"
+#include "GpuBuffer.h"
+#include "Light.h"
+
+namespace blurp
+{
+    namespace
+    {
+        //Get the tile that contains a coordinate in normalized device coordinates.
+        std::uint32_t ToTile(float a_Ndc, std::uint32_t a_Tiles)
+        {
+            const float tile = std::floor((a_Ndc * 0.5f + 0.5f) * static_cast<float>(a_Tiles));
+            return static_cast<std::uint32_t>(std::clamp(tile, 0.f, static_cast<float>(a_Tiles - 1)));
+        }
+    }
+
+    LightClusterBuilder::LightClusterBuilder() : m_Projection(1.f), m_Dirty(true), m_DepthScale(0.f), m_DepthBias(0.f)
+    {
+    }
+
+    void LightClusterBuilder::SetSettings(const LightClusterSettings& a_Settings)
+    {
+        assert(a_Settings.tilesX > 0 && a_Settings.tilesY > 0 && a_Settings.depthSlices >= 2 && "Light clusters need at least one tile and two depth slices!");
+        assert(a_Settings.lightCutoff > 0.f && "Light cutoff has to be larger than 0!");
+        m_Settings = a_Settings;
+        m_Dirty = true;
+    }
+
+    const LightClusterSettings& LightClusterBuilder::GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    void LightClusterBuilder::Build(const Camera& a_Camera, const LightUploadData& a_Lights)
+    {
+        UpdateClusters(a_Camera);
+        GatherLights(a_Camera, a_Lights);
+
+        m_Pairs.clear();
+        m_Stats = LightClusterStats();
+        m_Stats.lights = static_cast<std::uint32_t>(m_Lights.size());
+
+        const float scaleX = m_Projection[0][0];
+        const float scaleY = m_Projection[1][1];
+        const float nearPlane = m_SliceDepths.front();
+        const float farPlane = m_SliceDepths.back();
+
+        for(std::uint32_t lightIndex = 0; lightIndex < static_cast<std::uint32_t>(m_Lights.size()); ++lightIndex)
+        {
+            const auto& light = m_Lights[lightIndex];
+
+            //The camera looks down negative Z, so the view depth is -Z.
+            const float depth = -light.position.z;
+            if(depth + light.range < nearPlane || depth - light.range > farPlane)
+            {
+                continue;
+            }
+
+            //Slices are found with a logarithm, so one extra slice is tested on both sides in case of rounding.
+            const std::uint32_t firstSlice = std::max(GetSlice(depth - light.range), 1u) - 1;
+            const std::uint32_t lastSlice = std::min(GetSlice(depth + light.range) + 1, m_Settings.depthSlices - 1);
+
+            for(std::uint32_t slice = firstSlice; slice <= lastSlice; ++slice)
+            {
+                const float sliceNear = m_SliceDepths[slice];
+                const float sliceFar = m_SliceDepths[slice + 1];
+
+                //Range of tiles covered by the box around the light within this slice. Position / depth is largest at one of the corners.
+                const auto tileRange = [&](float a_Min, float a_Max, float a_Scale, std::uint32_t a_Tiles, std::uint32_t& a_First, std::uint32_t& a_Last)
+                {
+                    a_First = ToTile(std::min(a_Min / sliceNear, a_Min / sliceFar) * a_Scale, a_Tiles);
+                    a_Last = ToTile(std::max(a_Max / sliceNear, a_Max / sliceFar) * a_Scale, a_Tiles);
+                };
+
+                std::uint32_t firstX, lastX, firstY, lastY;
+                tileRange(light.position.x - light.range, light.position.x + light.range, scaleX, m_Settings.tilesX, firstX, lastX);
+                tileRange(light.position.y - light.range, light.position.y + light.range, scaleY, m_Settings.tilesY, firstY, lastY);
+
+                for(std::uint32_t y = firstY; y <= lastY; ++y)
+                {
+                    for(std::uint32_t x = firstX; x <= lastX; ++x)
+                    {
+                        const std::uint32_t cluster = x + m_Settings.tilesX * (y + m_Settings.tilesY * slice);
+                        ++m_Stats.clusterTests;
+
+                        if(Intersects(light, cluster))
+                        {
+                            m_Pairs.emplace_back(cluster, lightIndex);
+                        }
+                    }
+                }
+            }
+        }
+
+        //Pairs are added light after light with the clusters in increasing order, the same as the reference. Compact keeps that order.
+        Compact();
+    }
+
+    void LightClusterBuilder::BuildReference(const Camera& a_Camera, const LightUploadData& a_Lights)
+    {
+        UpdateClusters(a_Camera);
+        GatherLights(a_Camera, a_Lights);
+
+        m_Pairs.clear();
+        m_Stats = LightClusterStats();
+        m_Stats.lights = static_cast<std::uint32_t>(m_Lights.size());
+
+        const std::uint32_t numClusters = static_cast<std::uint32_t>(m_ClusterMin.size());
+        for(std::uint32_t lightIndex = 0; lightIndex < static_cast<std::uint32_t>(m_Lights.size()); ++lightIndex)
+        {
+            for(std::uint32_t cluster = 0; cluster < numClusters; ++cluster)
+            {
+                ++m_Stats.clusterTests;
+                if(Intersects(m_Lights[lightIndex], cluster))
+                {
+                    m_Pairs.emplace_back(cluster, lightIndex);
+                }
+            }
+        }
+
+        Compact();
+    }
+
+    GpuBufferView LightClusterBuilder::Upload(const std::shared_ptr<GpuBuffer>& a_Buffer, std::uintptr_t a_Offset, LightData& a_LightData) const
+    {
+        assert(a_Buffer != nullptr && "Cannot upload light clusters into nullptr buffer!");
+        assert(!m_Cells.empty() && "Light clusters have to be built before they are uploaded!");
+
+        const auto cells = a_Buffer->WriteData<LightClusterCell>(a_Offset, static_cast<std::uint32_t>(m_Cells.size()), 16, m_Cells.data());
+
+        //Indices are uploaded four at a time so that the list keeps the same alignment as all other data. The shader reads them as a flat array.
+        //The list is never empty, because an empty range can not be bound.
+        std::vector<glm::uvec4> packed(std::max<std::size_t>((m_LightIndices.size() + 3) / 4, 1), glm::uvec4(0));
+        if(!m_LightIndices.empty())
+        {
+            memcpy(packed.data(), m_LightIndices.data(), m_LightIndices.size() * sizeof(std::uint32_t));
+        }
+
+        const auto indices = a_Buffer->WriteData<glm::uvec4>(cells.end, static_cast<std::uint32_t>(packed.size()), 16, packed.data());
+
+        auto& clusters = a_LightData.clusters;
+        clusters.counts = glm::uvec3(m_Settings.tilesX, m_Settings.tilesY, m_Settings.depthSlices);
+        clusters.depthScale = m_DepthScale;
+        clusters.depthBias = m_DepthBias;
+        clusters.cells = cells;
+        clusters.lightIndices = indices;
+        clusters.dataBuffer = a_Buffer;
+
+        return indices;
+    }
+
+    std::uint32_t LightClusterBuilder::GetClusterIndex(const glm::vec3& a_ViewPosition) const
+    {
+        //Same as the forward shader: the clip space W of a perspective projection is the view depth.
+        const glm::vec4 clip = m_Projection * glm::vec4(a_ViewPosition, 1.f);
+        const float depth = std::max(clip.w, std::numeric_limits<float>::min());
+
+        const std::uint32_t x = ToTile(clip.x / depth, m_Settings.tilesX);
+        const std::uint32_t y = ToTile(clip.y / depth, m_Settings.tilesY);
+        const std::uint32_t z = GetSlice(depth);
+
+        return x + m_Settings.tilesX * (y + m_Settings.tilesY * z);
+    }
+
+    const std::vector<LightClusterCell>& LightClusterBuilder::GetCells() const
+    {
+        return m_Cells;
+    }
+
+    const std::vector<std::uint32_t>& LightClusterBuilder::GetLightIndices() const
+    {
+        return m_LightIndices;
+    }
+
+    const LightClusterStats& LightClusterBuilder::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    float LightClusterBuilder::GetLightRange(const glm::vec4& a_ColorIntensity, float a_Cutoff)
+    {
+        //Light falls off with the squared distance.
+        const float brightest = std::max(std::max(a_ColorIntensity.x, a_ColorIntensity.y), a_ColorIntensity.z) * a_ColorIntensity.w;
+        return std::sqrt(std::max(brightest, 0.f) / a_Cutoff);
+    }
+
+    void LightClusterBuilder::UpdateClusters(const Camera& a_Camera)
+    {
+        assert(a_Camera.GetSettings().projectionMode == ProjectionMode::PERSPECTIVE && "Light clusters require a perspective camera!");
+
+        const glm::mat4 projection = a_Camera.GetProjectionMatrix();
+        if(!m_Dirty && projection == m_Projection)
+        {
+            return;
+        }
+
+        m_Projection = projection;
+        m_Dirty = false;
+
+        const auto& settings = a_Camera.GetSettings();
+        const float nearPlane = settings.nearPlane;
+        const float farPlane = settings.farPlane;
+        const float nearDepth = std::clamp(m_Settings.nearDepth, nearPlane, farPlane);
+        const std::uint32_t slices = m_Settings.depthSlices;
+
+        //The first slice covers everything up to nearDepth. The others split the remaining depth exponentially.
+        m_DepthScale = static_cast<float>(slices - 1) / std::log(farPlane / nearDepth);
+        m_DepthBias = 1.f - std::log(nearDepth) * m_DepthScale;
+
+        m_SliceDepths.resize(slices + 1);
+        m_SliceDepths[0] = nearPlane;
+        for(std::uint32_t slice = 1; slice < slices; ++slice)
+        {
+            m_SliceDepths[slice] = nearDepth * std::pow(farPlane / nearDepth, static_cast<float>(slice - 1) / static_cast<float>(slices - 1));
+        }
+        m_SliceDepths[slices] = farPlane;
+
+        //Bounds of every cluster in view space. A point in NDC at a given depth is at ndc * depth / scale in view space.
+        const std::uint32_t numClusters = m_Settings.tilesX * m_Settings.tilesY * slices;
+        m_ClusterMin.resize(numClusters);
+        m_ClusterMax.resize(numClusters);
+
+        const float scaleX = m_Projection[0][0];
+        const float scaleY = m_Projection[1][1];
+
+        for(std::uint32_t slice = 0; slice < slices; ++slice)
+        {
+            const float sliceNear = m_SliceDepths[slice];
+            const float sliceFar = m_SliceDepths[slice + 1];
+
+            for(std::uint32_t y = 0; y < m_Settings.tilesY; ++y)
+            {
+                const float ndcY0 = (static_cast<float>(y) / static_cast<float>(m_Settings.tilesY)) * 2.f - 1.f;
+                const float ndcY1 = (static_cast<float>(y + 1) / static_cast<float>(m_Settings.tilesY)) * 2.f - 1.f;
+
+                for(std::uint32_t x = 0; x < m_Settings.tilesX; ++x)
+                {
+                    const float ndcX0 = (static_cast<float>(x) / static_cast<float>(m_Settings.tilesX)) * 2.f - 1.f;
+                    const float ndcX1 = (static_cast<float>(x + 1) / static_cast<float>(m_Settings.tilesX)) * 2.f - 1.f;
+
+                    const std::uint32_t cluster = x + m_Settings.tilesX * (y + m_Settings.tilesY * slice);
+
+                    m_ClusterMin[cluster] = glm::vec3(
+                        std::min(ndcX0 * sliceNear, ndcX0 * sliceFar) / scaleX,
+                        std::min(ndcY0 * sliceNear, ndcY0 * sliceFar) / scaleY,
+                        -sliceFar);
+
+                    m_ClusterMax[cluster] = glm::vec3(
+                        std::max(ndcX1 * sliceNear, ndcX1 * sliceFar) / scaleX,
+                        std::max(ndcY1 * sliceNear, ndcY1 * sliceFar) / scaleY,
+                        -sliceNear);
+                }
+            }
+        }
+    }
+
+    void LightClusterBuilder::GatherLights(const Camera& a_Camera, const LightUploadData& a_Lights)
+    {
+        const glm::mat4 view = a_Camera.GetViewMatrix();
+        const glm::mat3 rotation = glm::mat3(view);
+        const float cutoff = m_Settings.lightCutoff;
+
+        m_Lights.clear();
+
+        //Lights without shadows are uploaded before lights with shadows.
+        const auto countUnshadowed = [](const auto* a_Lights, std::uint32_t a_Count)
+        {
+            std::uint32_t count = 0;
+            for(std::uint32_t i = 0; a_Lights != nullptr && i < a_Count; ++i)
+            {
+                count += a_Lights[i]->GetData().positionShadowMapIndex.w < 0 ? 1 : 0;
+            }
+            return count;
+        };
+
+        if(a_Lights.point.lights != nullptr)
+        {
+            std::uint32_t unshadowed = 0;
+            std::uint32_t shadowed = countUnshadowed(a_Lights.point.lights, a_Lights.point.count);
+
+            for(std::uint32_t i = 0; i < a_Lights.point.count; ++i)
+            {
+                assert(a_Lights.point.lights[i] != nullptr && "Light can't be nullptr.");
+                const auto data = a_Lights.point.lights[i]->GetData();
+
+                ClusterLight light;
+                light.position = glm::vec3(view * glm::vec4(glm::vec3(data.positionShadowMapIndex), 1.f));
+                light.range = GetLightRange(data.colorIntensity, cutoff);
+                light.direction = glm::vec3(0.f);
+                light.cosAngle = 0.f;
+                light.sinAngle = 0.f;
+                light.spot = false;
+                light.cone = false;
+                light.index = data.positionShadowMapIndex.w < 0 ? unshadowed++ : shadowed++;
+                m_Lights.push_back(light);
+            }
+        }
+
+        if(a_Lights.spot.lights != nullptr)
+        {
+            std::uint32_t unshadowed = 0;
+            std::uint32_t shadowed = countUnshadowed(a_Lights.spot.lights, a_Lights.spot.count);
+
+            for(std::uint32_t i = 0; i < a_Lights.spot.count; ++i)
+            {
+                assert(a_Lights.spot.lights[i] != nullptr && "Light can't be nullptr.");
+                const auto data = a_Lights.spot.lights[i]->GetData();
+
+                //The angle is measured from the direction to the edge of the cone.
+                const float angle = data.directionAngle.w;
+
+                ClusterLight light;
+                light.position = glm::vec3(view * glm::vec4(glm::vec3(data.positionShadowMapIndex), 1.f));
+                light.range = GetLightRange(data.colorIntensity, cutoff);
+                light.direction = rotation * glm::vec3(data.directionAngle);
+                light.cosAngle = std::cos(angle);
+                light.sinAngle = std::sin(angle);
+                light.spot = true;
+                light.cone = angle < 1.5707963f;
+                light.index = data.positionShadowMapIndex.w < 0 ? unshadowed++ : shadowed++;
+                m_Lights.push_back(light);
+            }
+        }
+    }
+
+    std::uint32_t LightClusterBuilder::GetSlice(float a_Depth) const
+    {
+        if(a_Depth <= 0.f)
+        {
+            return 0;
+        }
+
+        const float slice = std::floor(std::log(a_Depth) * m_DepthScale + m_DepthBias);
+        return static_cast<std::uint32_t>(std::clamp(slice, 0.f, static_cast<float>(m_Settings.depthSlices - 1)));
+    }
+
+    bool LightClusterBuilder::Intersects(const ClusterLight& a_Light, std::uint32_t a_Cluster) const
+    {
+        const glm::vec3& min = m_ClusterMin[a_Cluster];
+        const glm::vec3& max = m_ClusterMax[a_Cluster];
+
+        //Sphere against box: the closest point in the box has to be within range.
+        const glm::vec3 offset = glm::clamp(a_Light.position, min, max) - a_Light.position;
+        if(glm::dot(offset, offset) > a_Light.range * a_Light.range)
+        {
+            return false;
+        }
+
+        if(!a_Light.cone)
+        {
+            return true;
+        }
+
+        //Cone against the sphere around the box. The sphere is outside when it is further than its radius from the cone edge, or behind the light.
+        const glm::vec3 center = (min + max) * 0.5f;
+        const float radius = glm::length(max - center);
+
+        const glm::vec3 toCenter = center - a_Light.position;
+        const float lengthSquared = glm::dot(toCenter, toCenter);
+        const float alongAxis = glm::dot(toCenter, a_Light.direction);
+        const float distanceToEdge = a_Light.cosAngle * std::sqrt(std::max(lengthSquared - alongAxis * alongAxis, 0.f)) - alongAxis * a_Light.sinAngle;
+
+        return distanceToEdge <= radius && alongAxis >= -radius;
+    }
+
+    void LightClusterBuilder::Compact()
+    {
+        const std::size_t numClusters = m_ClusterMin.size();
+
+        //Count the lights per cluster.
+        m_Cells.assign(numClusters, LightClusterCell{ 0, 0, 0, 0 });
+        for(const auto& pair : m_Pairs)
+        {
+            auto& cell = m_Cells[pair.x];
+            if(m_Lights[pair.y].spot)
+            {
+                ++cell.spotCount;
+            }
+            else
+            {
+                ++cell.pointCount;
+            }
+        }
+
+        //Offsets into the list follow from the counts.
+        std::uint32_t offset = 0;
+        for(auto& cell : m_Cells)
+        {
+            const std::uint32_t count = cell.pointCount + cell.spotCount;
+            cell.offset = offset;
+            offset += count;
+            m_Stats.maxLightsPerCluster = std::max(m_Stats.maxLightsPerCluster, count);
+        }
+
+        //Point lights come before spot lights in m_Lights, so they also come first in every cluster.
+        std::vector<std::uint32_t> written(numClusters, 0);
+        m_LightIndices.resize(m_Pairs.size());
+        for(const auto& pair : m_Pairs)
+        {
+            m_LightIndices[m_Cells[pair.x].offset + written[pair.x]++] = m_Lights[pair.y].index;
+        }
+
+        m_Stats.lightIndices = static_cast<std::uint32_t>(m_LightIndices.size());
+    }
+}
@@ -1,6 +1,7 @@
 #include "Lockable.h"
 #include <cassert>
 #include <iostream>
+#include <stdexcept>
 
 namespace blurp
 {
@@ -31,7 +32,7 @@ namespace blurp
         {
             if (IsLocked())
             {
-                throw std::exception("Lockable already locked! Unlock before trying to write lock.");
+                throw std::runtime_error("Lockable already locked! Unlock before trying to write lock.");
             }
 
             //Set the lock and this is always the first time locking so call OnLock.
@@ -42,7 +43,7 @@ namespace blurp
         {
             if(m_WriteLock)
             {
-                throw std::exception("Trying to lock a resource for reading when it was already write locked!");
+                throw std::runtime_error("Trying to lock a resource for reading when it was already write locked!");
             }
 
             //Increment lock count and call OnLock if this is the first lock.
@@ -0,0 +1,115 @@
+#include "MaterialBatch.h"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace blurp
+{
+    std::vector<float> MaterialBatch::PackConstantData() const
+    {
+        //Padding and stride is calculated to follow the std140 layout rules. 4 byte alignment is required for structs.
+
+        //Calculate the size of the constant data buffer.
+        std::uint32_t stride = 0;
+        constexpr std::uint32_t numAttribs = sizeof(CONSTANT_MATERIAL_ATTRIBUTES) / sizeof(CONSTANT_MATERIAL_ATTRIBUTES[0]);
+
+        //Array to store the padding for each element in.
+        std::uint32_t paddedSize[numAttribs];
+        std::uint32_t numElements[numAttribs];
+        const float* attribData[numAttribs];
+
+        //NOTE: This only works if all vec3/vec4s are first, followed by all loose floats.
+        int i = 0;
+        for(auto& attrib : CONSTANT_MATERIAL_ATTRIBUTES)
+        {
+            if (m_Settings.IsAttributeEnabled(attrib))
+            {
+                auto found = MATERIAL_ATTRIBUTE_INFO.find(attrib);
+                assert(found != MATERIAL_ATTRIBUTE_INFO.end());
+
+                const auto elementCount = found->second.numElements;
+                auto attribStride = 0u;
+
+                attribStride += elementCount;
+
+                //If numElements > 1, add a stride to align to 4.
+                //This works because float and vec2 don't need padding. Vec3 does need padding.
+                if(elementCount > 2)
+                {
+                    attribStride += (4 - elementCount);
+                }
+
+                //Add onto the total stride.
+                stride += attribStride;
+
+                //Add the total padded size of this attribute for later use.
+                paddedSize[i] = attribStride;
+                numElements[i] = elementCount;
+
+                switch (attrib)
+                {
+                case MaterialAttribute::DIFFUSE_CONSTANT_VALUE:
+                    attribData[i] = m_Settings.constantData.diffuseConstantData;
+                    break;
+                case MaterialAttribute::EMISSIVE_CONSTANT_VALUE:
+                    attribData[i] = m_Settings.constantData.emissiveConstantData;
+                    break;
+                case MaterialAttribute::METALLIC_CONSTANT_VALUE:
+                    attribData[i] = m_Settings.constantData.metallicConstantData;
+                    break;
+                case MaterialAttribute::ROUGHNESS_CONSTANT_VALUE:
+                    attribData[i] = m_Settings.constantData.roughnessConstantData;
+                    break;
+                case MaterialAttribute::ALPHA_CONSTANT_VALUE:
+                    attribData[i] = m_Settings.constantData.alphaConstantData;
+                    break;
+                default:
+                    throw std::runtime_error("Oops I forgot to add a new material attribute constant data to MaterialBatch.");
+                    break;
+                }
+            }
+            ++i;
+        }
+
+        //If the current stride is not a multiple of 4, then make it so.
+        const auto leftOver = stride % 4u;
+        if(leftOver != 0)
+        {
+            stride += (4u - leftOver);
+        }
+
+        //Create the contiguous array of floats.
+        std::vector<float> constantData;
+        constantData.resize(static_cast<std::size_t>(stride) * m_Settings.materialCount);
+
+        //Loop over each attribute, and then put the data in the right spot for each including padding.
+        auto accumulatedStride = 0u;
+        i = 0;
+        for (auto& attrib : CONSTANT_MATERIAL_ATTRIBUTES)
+        {
+            if (m_Settings.IsAttributeEnabled(attrib))
+            {
+                auto attribStride = paddedSize[i];
+                auto elementCount = numElements[i];
+
+                //Add each materials data in the right index.
+                for (auto matIndex = 0u; matIndex < m_Settings.materialCount; ++matIndex)
+                {
+                    auto startIndex = (matIndex * stride) + accumulatedStride;
+                    for(unsigned int elementIndex = 0; elementIndex < elementCount; ++elementIndex)
+                    {
+                        auto dataPtr = attribData[i];
+                        assert(dataPtr != nullptr && "MaterialBatch that has constant data enabled had nullptr provided for that data!");
+                        constantData[static_cast<std::size_t>(startIndex) + elementIndex] = dataPtr[(matIndex * elementCount) + elementIndex];
+                    }
+                }
+
+                //Append the current stride for the next element to use.
+                accumulatedStride += attribStride;
+            }
+            ++i;
+        }
+
+        return constantData;
+    }
+}
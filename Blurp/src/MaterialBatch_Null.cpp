@@ -0,0 +1,59 @@
+#include "null/MaterialBatch_Null.h"
+
+#include <cassert>
+
+#include "BlurpEngine.h"
+#include "RenderResourceManager.h"
+
+namespace blurp
+{
+    bool MaterialBatch_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //Ensure that the settings are valid.
+        assert(m_Settings.GetMask() != 0 && "MaterialBatch needs at least one attribute enabled!");
+        assert(m_Settings.materialCount > 0 && m_Settings.textureSettings.dimensions.x > 0 && m_Settings.textureSettings.dimensions.y > 0 && "Material count, width and height in a batch need to be at least 1.");
+
+        for(auto& attrib : TEXTURE_MATERIAL_ATTRIBUTES)
+        {
+            if (m_Settings.IsAttributeEnabled(attrib))
+            {
+                m_HasTexture = true;
+                break;
+            }
+        }
+
+        assert(m_HasTexture == (m_Settings.textureData != nullptr) && "Material batch that has texture enabled requires textureData to be provided!");
+
+        //Store the texture data in an array texture, with a layer per texture of every material.
+        if(m_HasTexture)
+        {
+            assert(m_Settings.textureCount != 0 && "Please provide how many textures are in the texture array per material!");
+
+            TextureSettings tSettings;
+            tSettings.textureType = TextureType::TEXTURE_2D_ARRAY;
+            tSettings.pixelFormat = PixelFormat::RGB;
+            tSettings.dataType = m_Settings.textureSettings.dataType;
+            tSettings.wrapMode = m_Settings.textureSettings.wrapMode;
+            tSettings.dimensions = { m_Settings.textureSettings.dimensions.x, m_Settings.textureSettings.dimensions.y, m_Settings.materialCount * m_Settings.textureCount };
+            tSettings.generateMipMaps = m_Settings.textureSettings.generateMipMaps;
+            tSettings.numMipMaps = m_Settings.textureSettings.numMipMaps;
+            tSettings.magFilter = m_Settings.textureSettings.magFilter;
+            tSettings.minFilter = m_Settings.textureSettings.minFilter;
+            tSettings.memoryAccess = AccessMode::READ_ONLY;
+            tSettings.memoryUsage = MemoryUsage::GPU;
+            tSettings.texture2DArray.data = m_Settings.textureData;
+
+            m_ArrayTexture = a_BlurpEngine.GetResourceManager().CreateTexture(tSettings);
+        }
+
+        m_ConstantData = PackConstantData();
+        return true;
+    }
+
+    bool MaterialBatch_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        m_ArrayTexture = nullptr;
+        m_ConstantData.clear();
+        return true;
+    }
+}
@@ -1,6 +1,7 @@
 #include "MaterialFile.h"
 
 #include <filesystem>
+#include <stdexcept>
 
 #include "Material.h"
 #include "stb_image.h"
@@ -617,7 +618,7 @@ std::shared_ptr<blurp::Material> blurp::LoadMaterial(blurp::RenderResourceManage
 	char* const regen_buffer = static_cast<char*>(malloc(header.originalSize));
 	if (regen_buffer == NULL)
 	{
-		throw std::exception("Failed to allocate memory for *regen_buffer.");
+		throw std::runtime_error("Failed to allocate memory for *regen_buffer.");
 	}
 
 	char* originStart = reinterpret_cast<char*>(&data[0]) + sizeof(CompressionHeader);
@@ -626,12 +627,12 @@ std::shared_ptr<blurp::Material> blurp::LoadMaterial(blurp::RenderResourceManage
 
 	if (decompressed_size < 0)
 	{
-		throw std::exception("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
+		throw std::runtime_error("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
 	}
 
 	if (decompressed_size != header.originalSize)
 	{
-		throw std::exception("Decompressed data is different from original!");
+		throw std::runtime_error("Decompressed data is different from original!");
 	}
 
 
@@ -1234,12 +1235,12 @@ bool blurp::CreateMaterialBatchFile(const MaterialBatchInfo& a_MaterialInfo, con
 	char* compressed_data = static_cast<char*>(malloc(static_cast<size_t>(max_dst_size)));
 	if (compressed_data == NULL)
 	{
-		throw std::exception("Could not allocate compression memory!");
+		throw std::runtime_error("Could not allocate compression memory!");
 	}
 	const int compressed_data_size = LZ4_compress_HC(&data[0], compressed_data, src_size, max_dst_size, LZ4HC_CLEVEL_MAX);
 	if (compressed_data_size <= 0)
 	{
-		throw std::exception("A 0 or negative result from LZ4_compress_default() indicates a failure trying to compress the data. ");
+		throw std::runtime_error("A 0 or negative result from LZ4_compress_default() indicates a failure trying to compress the data. ");
 	}
 
 	//Create the path if not exist.
@@ -1286,7 +1287,7 @@ std::shared_ptr<blurp::MaterialBatch> blurp::LoadMaterialBatch(blurp::RenderReso
 	}
 	else
 	{
-		throw std::exception("Could not load material file!");
+		throw std::runtime_error("Could not load material file!");
 	}
 
 	header = *reinterpret_cast<CompressionHeader*>(&data[0]);
@@ -1294,7 +1295,7 @@ std::shared_ptr<blurp::MaterialBatch> blurp::LoadMaterialBatch(blurp::RenderReso
 	char* const regen_buffer = static_cast<char*>(malloc(header.originalSize));
 	if (regen_buffer == NULL)
 	{
-		throw std::exception("Failed to allocate memory for *regen_buffer.");
+		throw std::runtime_error("Failed to allocate memory for *regen_buffer.");
 	}
 
 	char* originStart = reinterpret_cast<char*>(&data[0]) + sizeof(CompressionHeader);
@@ -1303,12 +1304,12 @@ std::shared_ptr<blurp::MaterialBatch> blurp::LoadMaterialBatch(blurp::RenderReso
 
 	if (decompressed_size < 0)
 	{
-		throw std::exception("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
+		throw std::runtime_error("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
 	}
 
 	if (decompressed_size != header.originalSize)
 	{
-		throw std::exception("Decompressed data is different from original!");
+		throw std::runtime_error("Decompressed data is different from original!");
 	}
 
 
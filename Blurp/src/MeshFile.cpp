@@ -7,6 +7,7 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <stdexcept>
 
 namespace blurp
 {
@@ -43,12 +44,12 @@ namespace blurp
         char* compressed_data = static_cast<char*>(malloc(static_cast<size_t>(max_dst_size)));
         if (compressed_data == NULL)
         {
-            throw std::exception("Could not allocate compression memory!");
+            throw std::runtime_error("Could not allocate compression memory!");
         }
         const int compressed_data_size = LZ4_compress_HC(&uncompressed[0], compressed_data, src_size, max_dst_size, LZ4HC_CLEVEL_MAX);
         if (compressed_data_size <= 0)
         {
-            throw std::exception("A 0 or negative result from LZ4_compress_default() indicates a failure trying to compress the data. ");
+            throw std::runtime_error("A 0 or negative result from LZ4_compress_default() indicates a failure trying to compress the data. ");
         }
 
         header.uncompressedSize = src_size;
@@ -95,7 +96,7 @@ namespace blurp
         }
         else
         {
-            throw std::exception("Could not load material file!");
+            throw std::runtime_error("Could not load material file!");
         }
 
         MeshFileHeader* header = reinterpret_cast<MeshFileHeader*>(&data[0]);
@@ -103,7 +104,7 @@ namespace blurp
         char* const regen_buffer = static_cast<char*>(malloc(header->uncompressedSize));
         if (regen_buffer == NULL)
         {
-            throw std::exception("Failed to allocate memory for *regen_buffer.");
+            throw std::runtime_error("Failed to allocate memory for *regen_buffer.");
         }
 
         char* originStart = reinterpret_cast<char*>(&data[0]) + sizeof(MeshFileHeader);
@@ -112,12 +113,12 @@ namespace blurp
 
         if (decompressed_size < 0)
         {
-            throw std::exception("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
+            throw std::runtime_error("A negative result from LZ4_decompress_safe indicates a failure trying to decompress the data.  See exit code (echo $?) for value returned.");
         }
 
         if (decompressed_size != header->uncompressedSize)
         {
-            throw std::exception("Decompressed data is different from original!");
+            throw std::runtime_error("Decompressed data is different from original!");
         }
 
         MeshSettings settings = header->settings;
@@ -0,0 +1,85 @@
+#include "null/Mesh_Null.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace blurp
+{
+    std::uint32_t Mesh_Null::GetNumIndices() const
+    {
+        return m_NumIndices;
+    }
+
+    const std::vector<std::uint8_t>& Mesh_Null::GetVertexData() const
+    {
+        return m_VertexData;
+    }
+
+    const std::vector<std::uint8_t>& Mesh_Null::GetIndexData() const
+    {
+        return m_IndexData;
+    }
+
+    const std::vector<std::string>& Mesh_Null::GetAttribLocations() const
+    {
+        return m_VertexPosDefines;
+    }
+
+    const std::vector<std::pair<std::uint32_t, std::uint32_t>>& Mesh_Null::GetInstanceDivisors() const
+    {
+        return m_InstancedVertexAttributes;
+    }
+
+    bool Mesh_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        assert((m_Settings.indexDataType == DataType::USHORT || m_Settings.indexDataType == DataType::UINT) && "Index buffer data type has to be either UINT or USHORT.");
+
+        //Copy the data, which the caller does not have to keep around after creating the mesh.
+        m_NumIndices = m_Settings.numIndices;
+        const auto indexDataSize = static_cast<std::size_t>(m_Settings.numIndices) * SizeOf(m_Settings.indexDataType);
+        if (m_Settings.indexData != nullptr && indexDataSize != 0)
+        {
+            m_IndexData.resize(indexDataSize);
+            std::memcpy(&m_IndexData[0], m_Settings.indexData, indexDataSize);
+        }
+
+        if (m_Settings.vertexData != nullptr && m_Settings.vertexDataSizeBytes != 0)
+        {
+            m_VertexData.resize(m_Settings.vertexDataSizeBytes);
+            std::memcpy(&m_VertexData[0], m_Settings.vertexData, m_Settings.vertexDataSizeBytes);
+        }
+
+        //Every enabled attribute takes one location per 4 elements, in the order of VERTEX_ATTRIBUTES.
+        std::uint32_t index = 0;
+        for (const auto attrib : VERTEX_ATTRIBUTES)
+        {
+            const auto info = VertexSettings::GetVertexAttributeInfo(attrib);
+            const std::uint32_t numIndicesRequired = ((info.numElements - 1) / 4) + 1;
+
+            if (m_Settings.vertexSettings.IsEnabled(attrib))
+            {
+                const auto data = m_Settings.vertexSettings.GetAttributeData(attrib);
+                m_VertexPosDefines.emplace_back(info.locationDefine + " " + std::to_string(index));
+
+                if (data.instanceDivisor != 0)
+                {
+                    for (std::uint32_t i = 0; i < numIndicesRequired; ++i)
+                    {
+                        m_InstancedVertexAttributes.emplace_back(std::make_pair(index + i, data.instanceDivisor));
+                    }
+                }
+
+                index += numIndicesRequired;
+            }
+        }
+
+        return true;
+    }
+
+    bool Mesh_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        m_VertexData.clear();
+        m_IndexData.clear();
+        return true;
+    }
+}
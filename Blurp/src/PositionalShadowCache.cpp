@@ -0,0 +1,331 @@
+#include "PositionalShadowCache.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+
+#include "Culling.h"
+
+namespace blurp
+{
+    //Bit for every face of a cube map.
+    constexpr std::uint32_t ALL_FACES = (1u << 6) - 1u;
+
+    PositionalShadowCache::PositionalShadowCache() : m_InvalidateAll(false), m_NearPlane(0.f), m_FarPlane(0.f)
+    {
+        m_Slots.resize(m_Settings.slots);
+        m_Updates.resize(m_Settings.slots * 6, ShadowFaceUpdate::CACHED);
+    }
+
+    void PositionalShadowCache::SetSettings(const PositionalShadowCacheSettings& a_Settings)
+    {
+        assert(a_Settings.slots <= MAX_SHADOW_LIGHTS && "Shadow pass can not render that many positional lights!");
+        assert(a_Settings.moveThreshold >= 0.f && "Move threshold can not be negative!");
+        m_Settings = a_Settings;
+
+        //Nothing that was drawn before can be trusted with different settings.
+        m_Slots.clear();
+        m_Slots.resize(m_Settings.slots);
+        m_Updates.clear();
+        m_Updates.resize(m_Settings.slots * 6, ShadowFaceUpdate::CACHED);
+        m_Invalidated.clear();
+        m_InvalidateAll = false;
+    }
+
+    const PositionalShadowCacheSettings& PositionalShadowCache::GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    void PositionalShadowCache::Invalidate(const glm::vec3& a_Center, float a_Radius)
+    {
+        assert(a_Radius >= 0.f && "Radius can not be negative!");
+        m_Invalidated.emplace_back(a_Center, a_Radius);
+    }
+
+    void PositionalShadowCache::InvalidateAll()
+    {
+        m_InvalidateAll = true;
+    }
+
+    void PositionalShadowCache::Update(const LightShadowData* a_Lights, std::uint32_t a_LightCount, const DrawData* a_DrawData, const LightIndexData* a_LightIndices, std::uint32_t a_DrawCount, float a_NearPlane, float a_FarPlane)
+    {
+        assert(a_LightCount <= MAX_SHADOW_LIGHTS && "Max positional light count for shadow mapping exceeded!");
+
+        const std::uint64_t totalCached = m_Stats.totalCached;
+        const std::uint64_t totalDrawn = m_Stats.totalDrawn;
+        m_Stats = PositionalShadowCacheStats();
+        m_Stats.totalCached = totalCached;
+        m_Stats.totalDrawn = totalDrawn;
+        m_Stats.faces = a_LightCount * 6;
+
+        //The depth stored in every face depends on the planes.
+        if(a_NearPlane != m_NearPlane || a_FarPlane != m_FarPlane)
+        {
+            m_InvalidateAll = true;
+            m_NearPlane = a_NearPlane;
+            m_FarPlane = a_FarPlane;
+        }
+
+        /*
+         * Drop the faces that can see a static caster that changed.
+         * The faces were drawn from the position stored in the slot, so that is what is tested against.
+         */
+        for(auto& slot : m_Slots)
+        {
+            if(slot.validMask == 0)
+            {
+                continue;
+            }
+
+            std::uint32_t invalidMask = m_InvalidateAll ? ALL_FACES : 0u;
+            if(invalidMask == 0 && !m_Invalidated.empty())
+            {
+                glm::mat4 faces[6];
+                RenderPass_ShadowMap::CalculateCubeFaces(slot.position, m_NearPlane, m_FarPlane, faces);
+
+                for(std::uint32_t face = 0; face < 6; ++face)
+                {
+                    if((slot.validMask & (1u << face)) == 0)
+                    {
+                        continue;
+                    }
+
+                    const Frustum frustum = ExtractFrustum(faces[face]);
+                    for(const auto& sphere : m_Invalidated)
+                    {
+                        bool inside = true;
+                        for(const auto& plane : frustum.planes)
+                        {
+                            if(glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w)
+                            {
+                                inside = false;
+                                break;
+                            }
+                        }
+
+                        if(inside)
+                        {
+                            invalidMask |= 1u << face;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            m_Stats.staticInvalidated += static_cast<std::uint32_t>(std::bitset<6>(slot.validMask & invalidMask).count());
+            slot.validMask &= ~invalidMask;
+        }
+
+        m_Invalidated.clear();
+        m_InvalidateAll = false;
+
+        /*
+         * Combine the static casters of every face into a signature, and find the faces with dynamic casters.
+         * The signature is a sum so that the order of the geometry does not matter.
+         * Casters only count for the faces in their LightIndexData::faceMask.
+         */
+        m_LightSignatures.assign(static_cast<std::size_t>(a_LightCount) * 6, 0);
+        m_LightDynamic.assign(a_LightCount, 0);
+
+        for(std::uint32_t draw = 0; draw < a_DrawCount; ++draw)
+        {
+            if(a_DrawData[draw].instanceCount == 0)
+            {
+                continue;
+            }
+
+            //Without light index data, everything is dynamic and affects every light.
+            if(a_LightIndices == nullptr)
+            {
+                m_LightDynamic.assign(a_LightCount, static_cast<std::uint8_t>(ALL_FACES));
+                break;
+            }
+
+            const auto& indices = a_LightIndices[draw];
+            const std::uint32_t faceMask = indices.faceMask & ALL_FACES;
+            std::uint64_t hash = 0;
+            if(indices.staticCaster)
+            {
+                //Mix the mesh and the instance count. Constants from SplitMix64.
+                hash = reinterpret_cast<std::uintptr_t>(a_DrawData[draw].mesh.get()) ^ (static_cast<std::uint64_t>(a_DrawData[draw].instanceCount) << 48);
+                hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ull;
+                hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebull;
+                hash ^= hash >> 31;
+            }
+
+            for(std::uint32_t light = 0; light < a_LightCount; ++light)
+            {
+                if(!indices.posLights.test(light))
+                {
+                    continue;
+                }
+
+                if(indices.staticCaster)
+                {
+                    for(std::uint32_t face = 0; face < 6; ++face)
+                    {
+                        if((faceMask & (1u << face)) != 0)
+                        {
+                            m_LightSignatures[light * 6 + face] += hash;
+                        }
+                    }
+                }
+                else
+                {
+                    m_LightDynamic[light] |= static_cast<std::uint8_t>(faceMask);
+                }
+            }
+        }
+
+        /*
+         * Decide what happens to every face of every slot.
+         */
+        std::fill(m_Updates.begin(), m_Updates.end(), ShadowFaceUpdate::CACHED);
+        std::vector<bool> present(m_Slots.size(), false);
+
+        for(std::uint32_t light = 0; light < a_LightCount; ++light)
+        {
+            const auto& lightData = a_Lights[light];
+            assert(lightData.index >= 0 && static_cast<std::uint32_t>(lightData.index) < m_Slots.size() && "Light index is outside of the cached slots!");
+            assert(!present[lightData.index] && "Two lights use the same shadow map!");
+            present[lightData.index] = true;
+
+            auto& slot = m_Slots[lightData.index];
+
+            if(!slot.used)
+            {
+                ++m_Stats.newLights;
+                slot.validMask = 0;
+            }
+            else if(glm::distance(slot.position, lightData.data) > m_Settings.moveThreshold)
+            {
+                ++m_Stats.movedLights;
+                slot.validMask = 0;
+            }
+            else
+            {
+                for(std::uint32_t face = 0; face < 6; ++face)
+                {
+                    if((slot.validMask & (1u << face)) != 0 && slot.staticSignatures[face] != m_LightSignatures[light * 6 + face])
+                    {
+                        ++m_Stats.staticInvalidated;
+                        slot.validMask &= ~(1u << face);
+                    }
+                }
+            }
+
+            //Dynamic casters from the last frame have to be removed as well.
+            const std::uint32_t dynamicMask = m_LightDynamic[light] | (slot.used ? slot.dynamicMask : 0u);
+            if(dynamicMask != 0)
+            {
+                ++m_Stats.dynamicLights;
+            }
+
+            for(std::uint32_t face = 0; face < 6; ++face)
+            {
+                const bool valid = (slot.validMask & (1u << face)) != 0;
+                const bool dynamic = (dynamicMask & (1u << face)) != 0;
+                ShadowFaceUpdate update = ShadowFaceUpdate::CACHED;
+
+                if(m_Settings.staticLayers)
+                {
+                    if(!valid)
+                    {
+                        update = ShadowFaceUpdate::REDRAW_STATIC;
+                        ++m_Stats.staticRedrawn;
+                        ++m_Stats.clearedLayers;
+                    }
+                    else if(dynamic)
+                    {
+                        update = ShadowFaceUpdate::RESTORE;
+                        ++m_Stats.restored;
+                    }
+                }
+                else if(!valid || dynamic)
+                {
+                    update = ShadowFaceUpdate::REDRAW;
+                    ++m_Stats.redrawn;
+                    ++m_Stats.clearedLayers;
+                }
+
+                if(update == ShadowFaceUpdate::CACHED)
+                {
+                    ++m_Stats.cached;
+                }
+
+                m_Updates[lightData.index * 6 + face] = update;
+            }
+
+            slot.used = true;
+            slot.validMask = ALL_FACES;
+            slot.position = lightData.data;
+            std::copy_n(&m_LightSignatures[light * 6], 6, slot.staticSignatures);
+            slot.dynamicMask = m_LightDynamic[light];
+        }
+
+        //Other lights may draw into the shadow maps of slots that are empty this frame, so their content is lost.
+        for(std::size_t slot = 0; slot < m_Slots.size(); ++slot)
+        {
+            if(!present[slot])
+            {
+                m_Slots[slot] = SlotState();
+            }
+        }
+
+        m_Stats.totalCached += m_Stats.cached;
+        m_Stats.totalDrawn += m_Stats.faces - m_Stats.cached;
+    }
+
+    ShadowFaceUpdate PositionalShadowCache::GetFaceUpdate(std::uint32_t a_Slot, std::uint32_t a_Face) const
+    {
+        assert(a_Slot < m_Slots.size() && a_Face < 6 && "Face is out of bounds!");
+        return m_Updates[a_Slot * 6 + a_Face];
+    }
+
+    std::uint32_t PositionalShadowCache::GetFaceMask(std::uint32_t a_Slot, ShadowFaceUpdate a_Update) const
+    {
+        std::uint32_t mask = 0;
+        for(std::uint32_t face = 0; face < 6; ++face)
+        {
+            if(GetFaceUpdate(a_Slot, face) == a_Update)
+            {
+                mask |= 1u << face;
+            }
+        }
+        return mask;
+    }
+
+    void PositionalShadowCache::GetClearRegions(bool a_Static, const ClearData& a_Template, std::vector<ClearData>& a_Output) const
+    {
+        const ShadowFaceUpdate cleared = a_Static ? ShadowFaceUpdate::REDRAW_STATIC : ShadowFaceUpdate::REDRAW;
+        const std::uint32_t numLayers = static_cast<std::uint32_t>(m_Updates.size());
+
+        std::uint32_t layer = 0;
+        while(layer < numLayers)
+        {
+            if(m_Updates[layer] != cleared)
+            {
+                ++layer;
+                continue;
+            }
+
+            //Extend the region over every following layer that is cleared as well.
+            const std::uint32_t start = layer;
+            while(layer < numLayers && m_Updates[layer] == cleared)
+            {
+                ++layer;
+            }
+
+            ClearData region = a_Template;
+            region.offset.z = static_cast<float>(start);
+            region.size.z = static_cast<float>(layer - start);
+            a_Output.push_back(region);
+        }
+    }
+
+    const PositionalShadowCacheStats& PositionalShadowCache::GetStats() const
+    {
+        return m_Stats;
+    }
+}
@@ -0,0 +1,240 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace blurp
+{
+    namespace
+    {
+        //The trace event process ids that the markers are grouped in.
+        constexpr std::uint32_t TRACE_PID_CPU = 0;
+        constexpr std::uint32_t TRACE_PID_GPU = 1;
+        constexpr std::uint32_t TRACE_PID_FRAMES = 2;
+
+        //Write a_String as a JSON string.
+        void WriteJsonString(std::ostream& a_Stream, const char* a_String)
+        {
+            a_Stream << '"';
+            for (const char* c = a_String; *c != '\0'; ++c)
+            {
+                switch (*c)
+                {
+                case '"':
+                    a_Stream << "\\\"";
+                    break;
+                case '\\':
+                    a_Stream << "\\\\";
+                    break;
+                default:
+                    //Control characters are not allowed in JSON strings, and never useful in a marker name.
+                    if (static_cast<unsigned char>(*c) >= 0x20)
+                    {
+                        a_Stream << *c;
+                    }
+                    break;
+                }
+            }
+            a_Stream << '"';
+        }
+
+        //Write the metadata event that gives a process or thread its name.
+        void WriteNameEvent(std::ostream& a_Stream, const char* a_Type, std::uint32_t a_Pid, std::uint32_t a_Tid, const std::string& a_Name)
+        {
+            a_Stream << ",\n{\"name\":\"" << a_Type << "\",\"ph\":\"M\",\"pid\":" << a_Pid << ",\"tid\":" << a_Tid << ",\"args\":{\"name\":";
+            WriteJsonString(a_Stream, a_Name.c_str());
+            a_Stream << "}}";
+        }
+    }
+
+    Profiler::Profiler(std::uint32_t a_FrameCount) : m_Start(std::chrono::steady_clock::now()), m_Enabled(true), m_Frames(std::max(a_FrameCount, 1u)), m_FrameIndex(0)
+    {
+        m_Threads.push_back(std::this_thread::get_id());
+    }
+
+    void Profiler::NextFrame()
+    {
+        const double now = Now();
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto& current = m_Frames[m_FrameIndex % m_Frames.size()];
+        current.duration = now - current.start;
+
+        //The events are cleared instead of replaced, so that their memory is reused.
+        ++m_FrameIndex;
+        auto& next = m_Frames[m_FrameIndex % m_Frames.size()];
+        next.index = m_FrameIndex;
+        next.start = now;
+        next.duration = 0.0;
+        next.events.clear();
+    }
+
+    std::uint64_t Profiler::GetFrameIndex() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_FrameIndex;
+    }
+
+    double Profiler::Now() const
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_Start).count();
+    }
+
+    void Profiler::SetEnabled(bool a_Enabled)
+    {
+        m_Enabled = a_Enabled;
+    }
+
+    bool Profiler::IsEnabled() const
+    {
+        return m_Enabled;
+    }
+
+    void Profiler::AddCpuEvent(const char* a_Name, double a_Start, double a_Duration)
+    {
+        if (!m_Enabled)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const std::uint32_t thread = GetThreadIndex();
+        m_Frames[m_FrameIndex % m_Frames.size()].events.push_back(ProfileEvent{ a_Name, ProfileEventType::CPU, thread, a_Start, a_Duration });
+    }
+
+    void Profiler::AddGpuEvent(std::uint64_t a_Frame, const char* a_Name, double a_Start, double a_Duration)
+    {
+        if (!m_Enabled)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto& frame = m_Frames[a_Frame % m_Frames.size()];
+        if (a_Frame <= m_FrameIndex && frame.index == a_Frame)
+        {
+            frame.events.push_back(ProfileEvent{ a_Name, ProfileEventType::GPU, 0, a_Start, a_Duration });
+        }
+    }
+
+    std::vector<ProfileFrame> Profiler::GetFrames() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        const std::uint64_t size = m_Frames.size();
+        const std::uint64_t first = m_FrameIndex + 1 >= size ? m_FrameIndex + 1 - size : 0;
+
+        std::vector<ProfileFrame> frames;
+        frames.reserve(static_cast<std::size_t>(m_FrameIndex + 1 - first));
+        for (std::uint64_t index = first; index <= m_FrameIndex; ++index)
+        {
+            frames.push_back(m_Frames[index % size]);
+        }
+        return frames;
+    }
+
+    std::uint32_t Profiler::GetFrameCount() const
+    {
+        return static_cast<std::uint32_t>(m_Frames.size());
+    }
+
+    void Profiler::WriteChromeTrace(std::ostream& a_Stream) const
+    {
+        const auto frames = GetFrames();
+        std::size_t threadCount;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            threadCount = m_Threads.size();
+        }
+
+        //Times are written in microseconds with nanosecond precision, which is what the trace event format expects.
+        const auto flags = a_Stream.flags();
+        const auto precision = a_Stream.precision();
+        a_Stream << std::fixed << std::setprecision(3);
+
+        a_Stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        a_Stream << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << TRACE_PID_CPU << ",\"tid\":0,\"args\":{\"name\":\"CPU\"}}";
+        WriteNameEvent(a_Stream, "process_name", TRACE_PID_GPU, 0, "GPU");
+        WriteNameEvent(a_Stream, "process_name", TRACE_PID_FRAMES, 0, "Frames");
+        for (std::uint32_t thread = 0; thread < threadCount; ++thread)
+        {
+            WriteNameEvent(a_Stream, "thread_name", TRACE_PID_CPU, thread, thread == 0 ? std::string("Main thread") : "Thread " + std::to_string(thread));
+        }
+        WriteNameEvent(a_Stream, "thread_name", TRACE_PID_GPU, 0, "GPU");
+
+        for (const auto& frame : frames)
+        {
+            //The last frame is still being recorded and has no duration yet, so only its markers are written.
+            if (&frame != &frames.back())
+            {
+                a_Stream << ",\n{\"name\":\"Frame " << frame.index << "\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":" << frame.start << ",\"dur\":" << frame.duration
+                    << ",\"pid\":" << TRACE_PID_FRAMES << ",\"tid\":0}";
+            }
+
+            for (const auto& event : frame.events)
+            {
+                const bool gpu = event.type == ProfileEventType::GPU;
+                a_Stream << ",\n{\"name\":";
+                WriteJsonString(a_Stream, event.name);
+                a_Stream << ",\"cat\":\"" << (gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\",\"ts\":" << event.start << ",\"dur\":" << event.duration
+                    << ",\"pid\":" << (gpu ? TRACE_PID_GPU : TRACE_PID_CPU) << ",\"tid\":" << event.thread << ",\"args\":{\"frame\":" << frame.index << "}}";
+            }
+        }
+
+        a_Stream << "\n]}\n";
+
+        a_Stream.flags(flags);
+        a_Stream.precision(precision);
+    }
+
+    bool Profiler::ExportChromeTrace(const std::string& a_Path) const
+    {
+        std::ofstream file(a_Path, std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        WriteChromeTrace(file);
+        return static_cast<bool>(file);
+    }
+
+    std::uint32_t Profiler::GetThreadIndex()
+    {
+        const auto id = std::this_thread::get_id();
+        const auto found = std::find(m_Threads.begin(), m_Threads.end(), id);
+        if (found != m_Threads.end())
+        {
+            return static_cast<std::uint32_t>(found - m_Threads.begin());
+        }
+
+        m_Threads.push_back(id);
+        return static_cast<std::uint32_t>(m_Threads.size() - 1);
+    }
+
+    ProfileScope::ProfileScope(Profiler& a_Profiler, const char* a_Name) : m_Profiler(a_Profiler), m_Name(a_Name), m_Start(a_Profiler.Now())
+    {
+    }
+
+    ProfileScope::~ProfileScope()
+    {
+        m_Profiler.AddCpuEvent(m_Name, m_Start, m_Profiler.Now() - m_Start);
+    }
+
+    ProfileGpuScope::ProfileGpuScope(GpuTimer* a_Timer, const char* a_Name) : m_Timer(a_Timer)
+    {
+        if (m_Timer != nullptr)
+        {
+            m_Timer->Begin(a_Name);
+        }
+    }
+
+    ProfileGpuScope::~ProfileGpuScope()
+    {
+        if (m_Timer != nullptr)
+        {
+            m_Timer->End();
+        }
+    }
+}
@@ -15,4 +15,9 @@ namespace blurp
             a_Window->BindSwapChain(std::move(a_SwapChain));
         }
     }
+
+    std::string RenderDevice::GetDriverId() const
+    {
+        return std::string();
+    }
 }
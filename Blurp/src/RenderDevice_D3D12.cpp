@@ -7,6 +7,8 @@
 #include "Light.h"
 #include "Material.h"
 
+#include <stdexcept>
+
 namespace blurp
 {
     Microsoft::WRL::ComPtr<ID3D12Device>& RenderDevice_D3D12::GetDevice()
@@ -61,7 +63,7 @@ namespace blurp
         const auto window = a_BlurpEngine.GetWindow();
         if (window == nullptr)
         {
-            throw std::exception("For D3D12 contexts, a window is required! Technically it's not but I didn't implement it that way.");
+            throw std::runtime_error("For D3D12 contexts, a window is required! Technically it's not but I didn't implement it that way.");
             return false;
         }
 
@@ -130,7 +132,7 @@ namespace blurp
             return std::make_shared<SwapChain_D3D12_Win32>(a_Settings.swapChainSettings, *this);
         default:
         {
-            throw std::exception("Swap chain for given window not implemented for OpenGL!");
+            throw std::runtime_error("Swap chain for given window not implemented for OpenGL!");
             return nullptr;
         }
         }
@@ -18,6 +18,8 @@
 #include "opengl/RenderPass_ShadowMap_GL.h"
 #include "opengl/RenderPass_Skybox_GL.h"
 
+#include <stdexcept>
+
 
 namespace blurp
 {
@@ -26,7 +28,7 @@ namespace blurp
         const auto window = a_BlurpEngine.GetWindow();
         if(window == nullptr)
         {
-            throw std::exception("For OpenGL contexts, a window is required!");
+            throw std::runtime_error("For OpenGL contexts, a window is required!");
             return false;
         }
 
@@ -40,10 +42,20 @@ namespace blurp
         //Now init glew and make sure it works correctly.
         if(glewInit() != GLEW_OK)
         {
-            throw std::exception("Glew could not be initialized! How horrible!");
+            throw std::runtime_error("Glew could not be initialized! How horrible!");
             return false;
         }
 
+        //Let the driver decide how many threads compile shaders in the background.
+        if(GLEW_KHR_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        }
+        else if(GLEW_ARB_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        }
+
         //Enable debugging
 #ifdef _DEBUG
         glEnable(GL_DEBUG_OUTPUT);
@@ -67,7 +79,7 @@ namespace blurp
             return std::make_shared<SpotLight>(a_Settings);
         };
 
-        throw std::exception("Unsupported light type!");
+        throw std::runtime_error("Unsupported light type!");
     }
 
     std::shared_ptr<Camera> RenderDevice_GL::CreateCamera(const CameraSettings& a_Settings)
@@ -99,7 +111,7 @@ namespace blurp
                 return std::make_shared<SwapChain_GL_Win32>(a_Settings.swapChainSettings);
             default:
             {
-                throw std::exception("Swap chain for given window not implemented for OpenGL!");
+                throw std::runtime_error("Swap chain for given window not implemented for OpenGL!");
                 return nullptr;
             }
         }
@@ -125,7 +137,7 @@ namespace blurp
             case RenderPassType::RP_SHADOWMAP:
                 return std::make_shared<RenderPass_ShadowMap_GL>(a_Pipeline);
         default:
-            throw std::exception("RenderPassType not implemented for OpenGL!");
+            throw std::runtime_error("RenderPassType not implemented for OpenGL!");
             break;
         }
     }
@@ -150,6 +162,25 @@ namespace blurp
         return std::make_shared<MaterialBatch_GL>(a_Settings);
     }
 
+    std::string RenderDevice_GL::GetDriverId() const
+    {
+        //Program binaries can not be loaded without at least one binary format.
+        GLint numFormats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+        if(numFormats <= 0)
+        {
+            return std::string();
+        }
+
+        const auto toString = [](GLenum a_Name)
+        {
+            const GLubyte* value = glGetString(a_Name);
+            return value != nullptr ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+        };
+
+        return toString(GL_VENDOR) + "|" + toString(GL_RENDERER) + "|" + toString(GL_VERSION);
+    }
+
     void GLAPIENTRY MessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
     {
         fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
@@ -0,0 +1,126 @@
+#include "null/RenderDevice_Null.h"
+
+#include "BlurpEngine.h"
+#include "Camera.h"
+#include "GpuBuffer_CPU.h"
+#include "Light.h"
+#include "Material.h"
+#include "RenderPipeline_Null.h"
+
+#include "null/MaterialBatch_Null.h"
+#include "null/Mesh_Null.h"
+#include "null/RenderPass_Clear_Null.h"
+#include "null/RenderPass_Forward_Null.h"
+#include "null/RenderPass_HelloTriangle_Null.h"
+#include "null/RenderPass_ShadowMap_Null.h"
+#include "null/RenderPass_Skybox_Null.h"
+#include "null/RenderTarget_Null.h"
+#include "null/Shader_Null.h"
+#include "null/SwapChain_Null.h"
+#include "null/Texture_Null.h"
+
+#include <stdexcept>
+
+namespace blurp
+{
+    bool RenderDevice_Null::Init(BlurpEngine& a_BlurpEngine, const WindowSettings& a_WindowSettings)
+    {
+        //A window is optional. When there is one, it gets a swap chain that only counts presented frames.
+        const auto window = a_BlurpEngine.GetWindow();
+        if(window != nullptr)
+        {
+            BindWindowAndSwapChain(a_BlurpEngine, window.get(), CreateSwapChain(a_WindowSettings));
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<Light> RenderDevice_Null::CreateLight(const LightSettings& a_Settings)
+    {
+        switch (a_Settings.type)
+        {
+        case LightType::LIGHT_AMBIENT:
+            return std::make_shared<AmbientLight>(a_Settings);
+        case LightType::LIGHT_DIRECTIONAL:
+            return std::make_shared<DirectionalLight>(a_Settings);
+        case LightType::LIGHT_POINT:
+            return std::make_shared<PointLight>(a_Settings);
+        case LightType::LIGHT_SPOT:
+            return std::make_shared<SpotLight>(a_Settings);
+        };
+
+        throw std::runtime_error("Unsupported light type!");
+    }
+
+    std::shared_ptr<Camera> RenderDevice_Null::CreateCamera(const CameraSettings& a_Settings)
+    {
+        return std::make_shared<Camera>(a_Settings);
+    }
+
+    std::shared_ptr<Mesh> RenderDevice_Null::CreateMesh(const MeshSettings& a_Settings)
+    {
+        return std::make_shared<Mesh_Null>(a_Settings);
+    }
+
+    std::shared_ptr<Texture> RenderDevice_Null::CreateTexture(const TextureSettings& a_Settings)
+    {
+        return std::make_shared<Texture_Null>(a_Settings);
+    }
+
+    std::shared_ptr<RenderTarget> RenderDevice_Null::CreateRenderTarget(const RenderTargetSettings& a_Settings)
+    {
+        return std::make_shared<RenderTarget_Null>(a_Settings);
+    }
+
+    std::shared_ptr<SwapChain> RenderDevice_Null::CreateSwapChain(const WindowSettings& a_Settings)
+    {
+        //Nothing is presented to the window, so every window type works.
+        return std::make_shared<SwapChain_Null>(a_Settings.swapChainSettings);
+    }
+
+    std::shared_ptr<Material> RenderDevice_Null::CreateMaterial(const MaterialSettings& a_Settings)
+    {
+        return std::make_shared<Material>(a_Settings);
+    }
+
+    std::shared_ptr<RenderPass> RenderDevice_Null::CreateRenderPass(RenderPassType& a_Type, RenderPipeline& a_Pipeline)
+    {
+        switch(a_Type)
+        {
+            case RenderPassType::RP_HELLOTRIANGLE:
+                return std::make_shared<RenderPass_HelloTriangle_Null>(a_Pipeline);
+            case RenderPassType::RP_FORWARD:
+                return std::make_shared<RenderPass_Forward_Null>(a_Pipeline);
+            case RenderPassType::RP_SKYBOX:
+                return std::make_shared<RenderPass_Skybox_Null>(a_Pipeline);
+            case RenderPassType::RP_CLEAR:
+                return std::make_shared<RenderPass_Clear_Null>(a_Pipeline);
+            case RenderPassType::RP_SHADOWMAP:
+                return std::make_shared<RenderPass_ShadowMap_Null>(a_Pipeline);
+        default:
+            throw std::runtime_error("RenderPassType not implemented for the null backend!");
+            break;
+        }
+    }
+
+    std::shared_ptr<RenderPipeline> RenderDevice_Null::CreatePipeline(const PipelineSettings& a_Settings)
+    {
+        return std::make_shared<RenderPipeline_Null>(a_Settings, m_Engine, *this);
+    }
+
+    std::shared_ptr<Shader> RenderDevice_Null::CreateShader(const ShaderSettings& a_Settings)
+    {
+        return std::make_shared<Shader_Null>(a_Settings);
+    }
+
+    std::shared_ptr<GpuBuffer> RenderDevice_Null::CreateGpuBuffer(const GpuBufferSettings& a_Settings)
+    {
+        //The CPU buffer lays out data exactly like a GPU buffer, so views into it are the same as on a GPU.
+        return std::make_shared<GpuBuffer_CPU>(a_Settings);
+    }
+
+    std::shared_ptr<MaterialBatch> RenderDevice_Null::CreateMaterialBatch(const MaterialBatchSettings& a_Settings)
+    {
+        return std::make_shared<MaterialBatch_Null>(a_Settings);
+    }
+}
@@ -1,5 +1,8 @@
 #include "RenderPass.h"
 
+#include <algorithm>
+#include <cassert>
+
 namespace blurp
 {
     void RenderPass::SetEnabled(bool a_Enabled)
@@ -11,4 +14,21 @@ namespace blurp
     {
         return m_Enabled;
     }
+
+    void RenderPass::AddDependency(const std::shared_ptr<RenderPass>& a_Pass)
+    {
+        assert(a_Pass != nullptr && a_Pass.get() != this && "A render pass cannot depend on itself or nullptr!");
+        assert(&a_Pass->m_Pipeline == &m_Pipeline && "Render passes can only depend on passes in the same pipeline!");
+        assert(a_Pass->m_PrepareIndex < m_PrepareIndex && "Render passes can only depend on passes that were appended before them!");
+
+        if (std::find(m_Dependencies.begin(), m_Dependencies.end(), a_Pass.get()) == m_Dependencies.end())
+        {
+            m_Dependencies.push_back(a_Pass.get());
+        }
+    }
+
+    const std::vector<RenderPass*>& RenderPass::GetDependencies() const
+    {
+        return m_Dependencies;
+    }
 }
@@ -1,6 +1,8 @@
 #include "RenderPass_Clear.h"
 #include "Texture.h"
 
+#include <algorithm>
+
 namespace blurp
 {
     void RenderPass_Clear::AddRenderTarget(const std::shared_ptr<RenderTarget>& a_Target)
@@ -14,6 +16,14 @@ namespace blurp
         m_Textures.emplace_back(std::make_pair(a_Texture, a_ClearData));
     }
 
+    void RenderPass_Clear::RemoveTexture(const std::shared_ptr<Texture>& a_Texture)
+    {
+        m_Textures.erase(std::remove_if(m_Textures.begin(), m_Textures.end(), [&](const std::pair<std::shared_ptr<Texture>, ClearData>& a_Entry)
+        {
+            return a_Entry.first == a_Texture;
+        }), m_Textures.end());
+    }
+
     RenderPassType RenderPass_Clear::GetType()
     {
         return RenderPassType::RP_CLEAR;
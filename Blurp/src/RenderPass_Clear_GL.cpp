@@ -5,6 +5,7 @@
 #include <iostream>
 
 #include "opengl/GLUtils.h"
+#include "opengl/RenderPipeline_GL.h"
 #include "opengl/RenderTarget_GL.h"
 #include "opengl/Texture_GL.h"
 
@@ -22,7 +23,7 @@ namespace blurp
         return true;
     }
 
-    void RenderPass_Clear_GL::Execute()
+    void RenderPass_Clear_GL::Submit()
     {
         for(auto& tex : m_Textures)
         {
@@ -36,23 +37,28 @@ namespace blurp
             glClearTexSubImage(glTex->GetTextureId(), 0, static_cast<GLsizei>(clearData.offset.x), static_cast<GLsizei>(clearData.offset.y), static_cast<GLsizei>(clearData.offset.z), static_cast<GLsizei>(clearData.size.x), static_cast<GLsizei>(clearData.size.y), static_cast<GLsizei>(clearData.size.z), format, dataType, &clearData.clearValue);
         }
 
+        auto& state = static_cast<RenderPipeline_GL&>(m_Pipeline).GetStateTracker();
+
         for(auto& rt : m_RenderTargets)
         {
             auto glTarget = static_cast<RenderTarget_GL*>(rt.get());
-            glTarget->Bind();
+            glTarget->Bind(state);
 
             GLenum clearBit = 0;
             if(glTarget->HasColorAttachment() != 0)
             {
                 clearBit = GL_COLOR_BUFFER_BIT;
             }
+            //Clearing respects the write masks, so make sure they allow everything.
             if(glTarget->HasStencilAttachment())
             {
                 clearBit |= GL_STENCIL_BUFFER_BIT;
+                state.SetStencilMask(0xFFFFFFFF);
             }
             if (glTarget->HasDepthAttachment())
             {
                 clearBit |= GL_DEPTH_BUFFER_BIT;
+                state.SetDepthMask(true);
             }
 
             //Only clear if there is attachments.
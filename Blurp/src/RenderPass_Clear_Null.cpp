@@ -0,0 +1,63 @@
+#include "null/RenderPass_Clear_Null.h"
+
+#include "CommandRecording.h"
+#include "RenderPipeline_Null.h"
+#include "null/RenderTarget_Null.h"
+#include "null/Texture_Null.h"
+
+namespace blurp
+{
+    bool RenderPass_Clear_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    bool RenderPass_Clear_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    void RenderPass_Clear_Null::Submit()
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+
+        for(auto& tex : m_Textures)
+        {
+            auto nullTex = static_cast<Texture_Null*>(tex.first.get());
+            auto& clearData = tex.second;
+
+            //Clear the region on the CPU, so that reading the pixels back gives the same result as on a GPU.
+            const glm::vec<3, std::uint32_t> offset = clearData.offset;
+            const glm::vec<3, std::uint32_t> size = clearData.size;
+
+            nullTex->Clear(offset, size, &clearData.clearValue);
+            recording.Record(RecordedCommandType::CLEAR_TEXTURE, nullTex, 0, size.x * size.y * size.z);
+        }
+
+        for(auto& rt : m_RenderTargets)
+        {
+            auto nullTarget = static_cast<RenderTarget_Null*>(rt.get());
+            nullTarget->Bind(recording);
+
+            std::uint64_t clearBits = 0;
+            if(nullTarget->HasColorAttachment())
+            {
+                clearBits |= 1;
+            }
+            if(nullTarget->HasDepthAttachment())
+            {
+                clearBits |= 2;
+            }
+            if(nullTarget->HasStencilAttachment())
+            {
+                clearBits |= 4;
+            }
+
+            //Only clear if there is attachments.
+            if(clearBits != 0)
+            {
+                recording.Record(RecordedCommandType::CLEAR_TARGET, nullTarget, 0, 0, clearBits);
+            }
+        }
+    }
+}
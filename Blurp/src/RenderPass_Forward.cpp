@@ -1,8 +1,73 @@
 #include "RenderPass_Forward.h"
+#include "Data.h"
+#include "GpuBuffer.h"
+#include "JobSystem.h"
+#include "Material.h"
+#include "MaterialBatch.h"
+#include "Mesh.h"
+#include "RenderPipeline.h"
+#include "Settings.h"
+#include "Shader.h"
 #include "Texture.h"
 
+#include <cassert>
+
 namespace blurp
 {
+    namespace
+    {
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+        //FNV-1a over the bytes of a value.
+        template<typename T>
+        void HashValue(std::uint64_t& a_Hash, const T& a_Value)
+        {
+            const auto* bytes = reinterpret_cast<const unsigned char*>(&a_Value);
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                a_Hash = (a_Hash ^ bytes[i]) * FNV_PRIME;
+            }
+        }
+    }
+
+    ShaderMaskTable RenderPass_Forward::CreateShaderMaskTable()
+    {
+        ShaderMaskTable table;
+
+        //Add every mesh bitmask to it as the first set of bits. Bones are declared by the shaders but never read.
+        for (auto& attrib : VERTEX_ATTRIBUTES)
+        {
+            const auto info = VertexSettings::GetVertexAttributeInfo(attrib);
+            const bool used = attrib != VertexAttribute::BONE_INDEX && attrib != VertexAttribute::BONE_WEIGHT;
+            table.Add(info.defineName, used, info.locationDefine);
+        }
+
+        //Add all the draw attribute defines to the shader cache.
+        for (auto& attrib : DRAW_ATTRIBUTES)
+        {
+            auto found = DRAW_ATTRIBUTE_INFO.find(attrib);
+            assert(found != DRAW_ATTRIBUTE_INFO.end());
+            table.Add(found->second.defineName, true);
+        }
+
+        //Add all the bitmask defines for the material settings.
+        for (auto& attrib : MATERIAL_ATTRIBUTES)
+        {
+            auto found = MATERIAL_ATTRIBUTE_INFO.find(attrib);
+            assert(found != MATERIAL_ATTRIBUTE_INFO.end());
+            table.Add(found->second.defineName, true);
+        }
+
+        //Add a define for shadows enabled or not.
+        table.Add("USE_POS_SHADOWS_DEFINE", true);
+        table.Add("USE_DIR_SHADOWS_DEFINE", true);
+
+        //Add a define for light clusters.
+        table.Add("USE_LIGHT_CLUSTERS_DEFINE", true);
+        return table;
+    }
+
     RenderPassType RenderPass_Forward::GetType()
     {
         return RenderPassType::RP_FORWARD;
@@ -23,6 +88,11 @@ namespace blurp
         m_DrawDataSet = a_DrawDataSet;
     }
 
+    void RenderPass_Forward::SetDrawSorting(bool a_Enabled)
+    {
+        m_SortDrawData = a_Enabled;
+    }
+
     void RenderPass_Forward::SetLights(const LightData& a_LightData)
     {
         m_LightData = a_LightData;
@@ -37,6 +107,36 @@ namespace blurp
         m_ShadowData = a_ShadowData;
     }
 
+    void RenderPass_Forward::SetShaderManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, float a_WarmUpBudget)
+    {
+        m_ShaderManifest = a_Manifest;
+        m_WarmUpBudget = a_WarmUpBudget;
+        m_ShaderManifestChanged = true;
+    }
+
+    void RenderPass_Forward::SetShaderFallbackPolicy(ShaderFallbackPolicy a_Policy, float a_CompileBudget)
+    {
+        m_ShaderFallbackPolicy = a_Policy;
+        m_CompileBudget = a_CompileBudget;
+    }
+
+    ShaderFallbackPolicy RenderPass_Forward::GetShaderFallbackPolicy() const
+    {
+        return m_ShaderFallbackPolicy;
+    }
+
+    void RenderPass_Forward::SetCommandRecording(std::uint32_t a_MaxThreads, std::uint32_t a_DrawsPerList)
+    {
+        assert(a_DrawsPerList > 0 && "Command lists need to hold at least one draw!");
+        m_RecordThreads = std::max(a_MaxThreads, 1u);
+        m_DrawsPerList = std::max(a_DrawsPerList, 1u);
+    }
+
+    const CommandListSet& RenderPass_Forward::GetDrawLists() const
+    {
+        return m_DrawLists;
+    }
+
     void RenderPass_Forward::Reset()
     {
         m_DrawDataSet = DrawDataSet();
@@ -47,4 +147,340 @@ namespace blurp
     {
         return m_Output != nullptr && m_Camera != nullptr;
     }
+
+    StaticData RenderPass_Forward::CalculateStaticData() const
+    {
+        const auto& clusters = m_LightData.clusters;
+
+        //Only read the camera, because it can be shared with other passes that are prepared at the same time.
+        const Camera& camera = *m_Camera;
+
+        StaticData staticData;
+        staticData.pv = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+        staticData.camPosFarPlane = glm::vec4(camera.GetTransform().GetTranslation(), camera.GetSettings().farPlane);
+        staticData.numLightsNumCascades = glm::vec4(m_LightData.pointLights.count, m_LightData.spotLights.count, m_LightData.directionalLights.count, m_ShadowData.directional.numCascades);
+        staticData.numShadows = glm::vec4(m_LightData.pointLights.shadowCount, m_LightData.spotLights.shadowCount, m_LightData.directionalLights.shadowCount, 0.f);
+        staticData.ambientLight = glm::vec4(m_LightData.ambient, 0.f);
+        staticData.clusterCounts = glm::vec4(clusters.counts, 0.f);
+        staticData.clusterDepth = glm::vec4(clusters.depthScale, clusters.depthBias, 0.f, 0.f);
+        return staticData;
+    }
+
+    void RenderPass_Forward::PrePrepare()
+    {
+        //The camera can be shared with other passes that are prepared at the same time.
+        m_Camera->UpdateMatrices();
+    }
+
+    void RenderPass_Forward::Prepare()
+    {
+        m_StaticData = CalculateStaticData();
+
+        //Bits used for shadows and light clusters, which are the same for every draw.
+        constexpr std::uint64_t usePosShadowsBit = static_cast<std::uint64_t>(1) << (NUM_MATERIAL_ATRRIBS + NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
+        constexpr std::uint64_t useDirShadowsBit = usePosShadowsBit << 1;
+        constexpr std::uint64_t useLightClustersBit = useDirShadowsBit << 1;
+
+        const auto& clusters = m_LightData.clusters;
+        std::uint64_t sharedBits = 0;
+        if (m_LightData.pointLights.shadowCount + m_LightData.spotLights.shadowCount != 0)
+        {
+            sharedBits |= usePosShadowsBit;
+        }
+        if (m_LightData.directionalLights.shadowCount != 0)
+        {
+            sharedBits |= useDirShadowsBit;
+        }
+        if (clusters.dataBuffer != nullptr && clusters.counts.x > 0 && clusters.counts.y > 0 && clusters.counts.z > 0)
+        {
+            sharedBits |= useLightClustersBit;
+        }
+
+        m_PreparedDraws.resize(m_DrawDataSet.drawDataCount);
+        if (m_DrawDataSet.drawDataCount == 0)
+        {
+            return;
+        }
+
+        //Sort the draw data if enabled. Only the indices are reordered, the draw data itself stays in place.
+        const std::uint32_t* drawOrder = nullptr;
+        if (m_SortDrawData)
+        {
+            DrawSortSettings sortSettings;
+            sortSettings.nearPlane = m_Camera->GetSettings().nearPlane;
+            sortSettings.farPlane = m_Camera->GetSettings().farPlane;
+            sortSettings.sortMaterials = true;
+
+            m_DrawSorter.Sort(m_DrawDataSet.drawDataPtr, m_DrawDataSet.drawDataCount, sortSettings);
+            drawOrder = m_DrawSorter.GetOrder().data();
+        }
+
+        //Retrieve the default pipeline state if none is specified for the first element.
+        const PipelineState* pipelineState = m_DrawDataSet.drawDataPtr[drawOrder != nullptr ? drawOrder[0] : 0].pipelineState;
+        if (pipelineState == nullptr)
+        {
+            pipelineState = &PipelineState::GetDefault();
+        }
+
+        /*
+         * Find the pipeline state and shader mask of every draw.
+         * Everything except the shaders that changes the recorded commands goes into the key, so the lists of the last recording can be reused when it matches.
+         */
+        std::uint64_t key = FNV_OFFSET;
+        HashValue(key, m_DrawsPerList);
+
+        const Material* prevMaterial = nullptr;
+
+        for (auto i = 0u; i < m_DrawDataSet.drawDataCount; ++i)
+        {
+            const auto& instanceData = m_DrawDataSet.drawDataPtr[drawOrder != nullptr ? drawOrder[i] : i];
+
+            assert(instanceData.mesh != nullptr && "Mesh cannot be nullptr!");
+            assert(instanceData.instanceCount > 0 && "Cannot draw 0 instances of mesh!");
+
+            //When sorted, the previous draw is no longer the submitted one. No pipeline state then means the default state.
+            const PipelineState* drawPipelineState = instanceData.pipelineState;
+            if (drawOrder != nullptr && drawPipelineState == nullptr)
+            {
+                drawPipelineState = &PipelineState::GetDefault();
+            }
+            if (drawPipelineState != nullptr)
+            {
+                pipelineState = drawPipelineState;
+            }
+
+            const bool material = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE);
+            const bool materialBatch = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH);
+
+            //Ensure that either only one is enabled, or both are disabled. Never both enabled.
+            assert((material != materialBatch) || (!material && !materialBatch));
+
+            //Shader mask matching the vertex layout.
+            std::uint64_t shaderMask = static_cast<std::uint64_t>(instanceData.mesh->GetVertexAttributeMask()) | (instanceData.attributes.GetMask() << NUM_VERTEX_ATRRIBS) | sharedBits;
+
+            if (material && instanceData.materialData.material != nullptr)
+            {
+                shaderMask = shaderMask | (static_cast<std::uint64_t>(instanceData.materialData.material->GetSettings().GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS));
+            }
+            else if (materialBatch && instanceData.materialData.materialBatch != nullptr)
+            {
+                shaderMask = shaderMask | (static_cast<std::uint64_t>(instanceData.materialData.materialBatch->GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS));
+            }
+
+            m_PreparedDraws[i] = PreparedDraw{ &instanceData, pipelineState, shaderMask, nullptr };
+
+            HashValue(key, instanceData.mesh.get());
+            HashValue(key, instanceData.instanceCount);
+            HashValue(key, instanceData.attributes.GetMask());
+            HashValue(key, instanceData.materialData.materialBatch.get());
+            HashValue(key, instanceData.transformData.dataBuffer.get());
+            HashValue(key, instanceData.transformData.dataRange.start);
+            HashValue(key, instanceData.transformData.dataRange.totalSize);
+            HashValue(key, instanceData.uvModifierData.dataBuffer.get());
+            HashValue(key, instanceData.uvModifierData.dataRange.start);
+            HashValue(key, instanceData.uvModifierData.dataRange.totalSize);
+            HashValue(key, pipelineState);
+            HashValue(key, pipelineState->GetId());
+
+            //Materials can be changed after they are created, so their contents are part of the key.
+            const Material* drawMaterial = instanceData.materialData.material.get();
+            HashValue(key, drawMaterial);
+            if (drawMaterial != prevMaterial && drawMaterial != nullptr)
+            {
+                auto& matSettings = instanceData.materialData.material->GetSettings();
+                HashValue(key, matSettings.GetMask());
+                HashValue(key, matSettings.GetDiffuseTexture().get());
+                HashValue(key, matSettings.GetNormalTexture().get());
+                HashValue(key, matSettings.GetEmissiveTexture().get());
+                HashValue(key, matSettings.GetMRATexture().get());
+                HashValue(key, matSettings.GetOHTexture().get());
+                HashValue(key, matSettings.GetDiffuseValue());
+                HashValue(key, matSettings.GetEmissiveValue());
+                HashValue(key, matSettings.GetAlphaValue());
+            }
+            prevMaterial = drawMaterial;
+        }
+
+        m_DrawKey = key;
+    }
+
+    void RenderPass_Forward::RecordDraws()
+    {
+        //Look up the shaders on this thread, because they may have to be compiled. The shaders complete the key of the prepared draws.
+        std::uint64_t key = m_DrawKey;
+        std::uint64_t prevMask = 0;
+        std::shared_ptr<Shader> shader;
+
+        for (auto& prepared : m_PreparedDraws)
+        {
+            //Get the new shader when the mask changes. If not present, load a new one or use another one while it compiles.
+            if (prepared.shaderMask != prevMask)
+            {
+                prevMask = prepared.shaderMask;
+                shader = GetShader(prepared.shaderMask, *prepared.drawData->mesh);
+            }
+
+            prepared.shader = shader;
+            HashValue(key, shader.get());
+        }
+
+        if (m_DrawLists.IsRecorded(key))
+        {
+            return;
+        }
+
+        m_DrawLists.Record(m_Pipeline.GetJobSystem(), key, m_DrawDataSet.drawDataCount, m_DrawsPerList, m_RecordThreads, [this](CommandList& a_List, std::uint32_t a_Begin, std::uint32_t a_End)
+        {
+            RecordDrawRange(a_List, a_Begin, a_End);
+        });
+    }
+
+    void RenderPass_Forward::RecordDrawRange(CommandList& a_List, std::uint32_t a_Begin, std::uint32_t a_End) const
+    {
+        //Every list starts without any state, so that lists can be replayed after each other in any state.
+        const PipelineState* pipelineState = nullptr;
+        const Shader* currentShader = nullptr;
+        const Material* prevMaterial = nullptr;
+        const MaterialBatch* prevMaterialBatch = nullptr;
+        const Mesh* prevMesh = nullptr;
+
+        for (auto i = a_Begin; i < a_End; ++i)
+        {
+            const auto& prepared = m_PreparedDraws[i];
+            const auto& instanceData = *prepared.drawData;
+
+            //Apply the pipeline state when it changes.
+            if (pipelineState == nullptr || prepared.pipelineState->GetId() != pipelineState->GetId())
+            {
+                pipelineState = prepared.pipelineState;
+                a_List.SetPipelineState(*pipelineState);
+            }
+
+            //Has the material and materialbatch changed?
+            const bool changedMaterial = prevMaterial != instanceData.materialData.material.get();
+            const bool changedBatch = prevMaterialBatch != instanceData.materialData.materialBatch.get();
+            prevMaterial = instanceData.materialData.material.get();
+            prevMaterialBatch = instanceData.materialData.materialBatch.get();
+
+            const bool material = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE);
+            const bool materialBatch = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH);
+
+            //Masks that only differ in bits the shaders do not use give the same shader, which is kept bound.
+            const bool changedShader = prepared.shader.get() != currentShader;
+            currentShader = prepared.shader.get();
+
+            //Skip the draw while its shader compiles and there is nothing to use in its place.
+            if (currentShader == nullptr)
+            {
+                continue;
+            }
+
+            if (changedShader)
+            {
+                a_List.BindShader(*currentShader);
+            }
+
+            //If the current material is new or the shader changed, bind the material data again.
+            if (material && (changedMaterial || changedShader))
+            {
+                auto& matSettings = instanceData.materialData.material->GetSettings();
+
+                //DIFFUSE
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::DIFFUSE_TEXTURE) && matSettings.GetDiffuseTexture() != nullptr)
+                {
+                    a_List.BindTexture(0, *matSettings.GetDiffuseTexture());
+                }
+                else if (matSettings.IsAttributeEnabled(MaterialAttribute::DIFFUSE_CONSTANT_VALUE))
+                {
+                    a_List.SetUniform(1, matSettings.GetDiffuseValue());
+                }
+
+                //NORMAL
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::NORMAL_TEXTURE) && matSettings.GetNormalTexture() != nullptr)
+                {
+                    a_List.BindTexture(1, *matSettings.GetNormalTexture());
+                }
+
+                //EMISSIVE
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::EMISSIVE_TEXTURE) && matSettings.GetEmissiveTexture() != nullptr)
+                {
+                    a_List.BindTexture(2, *matSettings.GetEmissiveTexture());
+                }
+                else if (matSettings.IsAttributeEnabled(MaterialAttribute::EMISSIVE_CONSTANT_VALUE))
+                {
+                    a_List.SetUniform(2, matSettings.GetEmissiveValue());
+                }
+
+                //METAL/ROUGHNESS/ALPHA
+                if ((matSettings.IsAttributeEnabled(MaterialAttribute::METALLIC_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::ROUGHNESS_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::ALPHA_TEXTURE)) && matSettings.GetMRATexture() != nullptr)
+                {
+                    a_List.BindTexture(3, *matSettings.GetMRATexture());
+                }
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::METALLIC_CONSTANT_VALUE))
+                {
+                    a_List.SetUniform(3, matSettings.GetAlphaValue());
+                }
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::ROUGHNESS_CONSTANT_VALUE))
+                {
+                    a_List.SetUniform(4, matSettings.GetAlphaValue());
+                }
+                if (matSettings.IsAttributeEnabled(MaterialAttribute::ALPHA_CONSTANT_VALUE))
+                {
+                    a_List.SetUniform(5, matSettings.GetAlphaValue());
+                }
+
+                //OCCLUSION/HEIGHT
+                if ((matSettings.IsAttributeEnabled(MaterialAttribute::OCCLUSION_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::HEIGHT_TEXTURE)) && matSettings.GetOHTexture() != nullptr)
+                {
+                    a_List.BindTexture(4, *matSettings.GetOHTexture());
+                }
+            }
+
+            //If the material batch data needs to be bound, bind it.
+            if (materialBatch && (changedBatch || changedShader))
+            {
+                const auto& batch = *instanceData.materialData.materialBatch;
+                if (batch.HasTexture())
+                {
+                    a_List.BindTexture(5, *batch.GetTexture());
+
+                    //Set the stride uniform
+                    a_List.SetUniform(6, static_cast<std::int32_t>(batch.GetActiveTextureCount()));
+                }
+                a_List.BindMaterialBatch(2, batch);
+            }
+
+            //Which DrawData is active?
+            const bool matrixEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX);
+            const bool normalMatrixEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX);
+            const bool uvModEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::UV_MODIFIER);
+
+            //If transforms are uploaded, bind the transform buffer. The shader is hard coded to use slot 0 for the buffer.
+            if (matrixEnabled || normalMatrixEnabled)
+            {
+                assert(instanceData.transformData.dataBuffer != nullptr);
+                a_List.BindStorageBuffer(0, *instanceData.transformData.dataBuffer, instanceData.transformData.dataRange.start, static_cast<std::uint32_t>(instanceData.transformData.dataRange.totalSize));
+            }
+
+            //Check if Uv modifiers are enabled. Bind to slot 3 if used.
+            const auto* mesh = instanceData.mesh.get();
+            const bool hasUvModifiers = (uvModEnabled && (mesh->GetVertexAttributeMask() & VertexAttribute::UV_MODIFIER_ID) == VertexAttribute::UV_MODIFIER_ID) && instanceData.uvModifierData.dataBuffer != nullptr;
+            if (hasUvModifiers)
+            {
+                a_List.BindStorageBuffer(3, *instanceData.uvModifierData.dataBuffer, instanceData.uvModifierData.dataRange.start, static_cast<std::uint32_t>(instanceData.uvModifierData.dataRange.totalSize));
+            }
+
+            //Upload how many instances are dynamic. The shader invocation instance is then divided by this to get the right ID into the dynamic array.
+            a_List.SetUniform(0, static_cast<std::int32_t>(instanceData.instanceCount));
+
+            //If the geometry changed, bind the new geometry.
+            if (prevMesh != mesh)
+            {
+                a_List.BindMesh(*mesh);
+                prevMesh = mesh;
+            }
+
+            a_List.Draw(*mesh, pipelineState->GetTopology(), instanceData.instanceCount);
+        }
+    }
 }
@@ -1,5 +1,6 @@
 #include "opengl/RenderPass_Forward_GL.h"
 
+#include <stdexcept>
 #include <glm/gtc/type_ptr.hpp>
 
 #include "BlurpEngine.h"
@@ -7,6 +8,7 @@
 #include "opengl/GpuBuffer_GL.h"
 #include "opengl/MaterialBatch_GL.h"
 #include "opengl/Mesh_GL.h"
+#include "opengl/RenderPipeline_GL.h"
 #include "opengl/RenderTarget_GL.h"
 #include "opengl/Shader_GL.h"
 #include "opengl/Texture_GL.h"
@@ -29,7 +31,7 @@ namespace blurp
 
         if(!vertexReader.Open() || !fragmentReader.Open())
         {
-            throw std::exception("Could not find forward shaders at path specified.");
+            throw std::runtime_error("Could not find forward shaders at path specified.");
         }
 
         auto vertexSrc = vertexReader.ToArray();
@@ -40,36 +42,11 @@ namespace blurp
         sSettings.fragmentShaderSource = fragmentSrc.get();
         sSettings.type = ShaderType::GRAPHICS;
 
-        //Preprocessor definitions at their respective bit indices.
-        std::vector<std::string> definitions;
+        //Preprocessor definitions at their respective bit indices. Bits the shaders do not use are folded out of every mask.
+        m_ShaderCache.Init(a_BlurpEngine, sSettings, CreateShaderMaskTable());
 
-        //Add every mesh bitmask to it as the first set of bits.
-        for(auto& attrib : VERTEX_ATTRIBUTES)
-        {
-            definitions.emplace_back(VertexSettings::GetVertexAttributeInfo(attrib).defineName);
-        }
-
-        //Add all the draw attribute defines  to the shader cache.
-        for (auto& attrib : DRAW_ATTRIBUTES)
-        {
-            auto found = DRAW_ATTRIBUTE_INFO.find(attrib);
-            assert(found != DRAW_ATTRIBUTE_INFO.end());
-            definitions.emplace_back(found->second.defineName);
-        }
-
-        //Add all the bitmask defines for the material settings.
-        for (auto& attrib : MATERIAL_ATTRIBUTES)
-        {
-            auto found = MATERIAL_ATTRIBUTE_INFO.find(attrib);
-            assert(found != MATERIAL_ATTRIBUTE_INFO.end());
-            definitions.emplace_back(found->second.defineName);
-        }
-
-        //Add a define for shadows enabled or not.
-        definitions.emplace_back("USE_POS_SHADOWS_DEFINE");
-        definitions.emplace_back("USE_DIR_SHADOWS_DEFINE");
-
-        m_ShaderCache.Init(a_BlurpEngine.GetResourceManager(), sSettings, definitions);
+        //Strip the code that each variant disables before compiling, so variants that only differ in unused definitions share a program.
+        m_ShaderCache.SetPreprocessing(true, shaderPath);
 
         //Create the static data buffer. Also bind the buffer to slot 1. The shader is hard coded to read camera data from slot 1.
         glGenBuffers(1, &m_StaticDataUbo);
@@ -78,13 +55,6 @@ namespace blurp
         glBindBufferBase(GL_UNIFORM_BUFFER, 1, m_StaticDataUbo);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-        //Create the UBO used to upload light data to the GPU. Hard coded to slot 4.
-        glGenBuffers(1, &m_LightUbo);
-        glBindBuffer(GL_UNIFORM_BUFFER, m_LightUbo);
-        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightDataPacked) * MAX_LIGHTS, nullptr, GL_DYNAMIC_DRAW);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 4, m_LightUbo);
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-
         //Create samplers to sample shadows maps.
         glGenSamplers(1, &m_ShadowSampler);
         glSamplerParameteri(m_ShadowSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
@@ -108,8 +78,21 @@ namespace blurp
         return true;
     }
 
-    void RenderPass_Forward_GL::Execute()
+    void RenderPass_Forward_GL::Submit()
     {
+        //Compile the variants from the manifest before they are needed.
+        if (m_ShaderManifestChanged)
+        {
+            m_ShaderCache.SetManifest(m_ShaderManifest, "Forward");
+            m_ShaderManifestChanged = false;
+        }
+        m_ShaderCache.WarmUp(m_WarmUpBudget);
+
+        //Compile the variants that were missing in earlier frames. Vertex and draw attributes change the inputs of the shader, so they have to match when another variant is used.
+        constexpr std::uint64_t exactBits = (static_cast<std::uint64_t>(1) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS)) - 1;
+        m_ShaderCache.SetFallbackPolicy(m_ShaderFallbackPolicy, exactBits);
+        m_ShaderCache.UpdateCompiles(m_CompileBudget);
+
         //Don't run if no data is present.
         if (m_DrawDataSet.drawDataCount == 0) return;
 
@@ -120,26 +103,16 @@ namespace blurp
         //Clear the target buffer.
         const auto rtGL = reinterpret_cast<RenderTarget_GL*>(m_Output.get());
 
+        //All state is set through the tracker of the pipeline, which leaves out what earlier draws and passes already set.
+        auto& state = static_cast<RenderPipeline_GL&>(m_Pipeline).GetStateTracker();
+
         //Bind the render target.
-        rtGL->Bind();
+        rtGL->Bind(state);
 
         /*
          * Global data setup that is used for all draw calls.
          */
 
-        //Cache last used bound data to prevent binding it again unless it changes.
-        std::uint64_t prevMask = 0;
-        std::shared_ptr<Material> prevMaterial;
-        std::shared_ptr<MaterialBatch> prevMaterialBatch;
-        std::shared_ptr<Mesh> prevMesh;
-
-        //To set uniforms.
-        GLuint currentProgramId = 0;
-
-        //Bits used for materials and uploaded data.
-        constexpr std::uint64_t usePosShadowsBit = static_cast<std::uint64_t>(1) << (NUM_MATERIAL_ATRRIBS + NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
-        constexpr std::uint64_t useDirShadowsBit = usePosShadowsBit << 1;
-
         //Bind lights
 
         if(m_LightData.pointLights.count > 0 || m_LightData.pointLights.shadowCount > 0)
@@ -148,7 +121,7 @@ namespace blurp
             auto bufferId = static_cast<GpuBuffer_GL*>(m_LightData.pointLights.dataBuffer.get())->GetBufferId();
             auto start = m_LightData.pointLights.dataRange.start;
             auto size = m_LightData.pointLights.dataRange.totalSize;
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<GLintptr>(start), size);
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<std::int64_t>(start), size);
         }
 
         if (m_LightData.spotLights.count > 0 || m_LightData.spotLights.shadowCount > 0)
@@ -157,7 +130,7 @@ namespace blurp
             auto bufferId = static_cast<GpuBuffer_GL*>(m_LightData.spotLights.dataBuffer.get())->GetBufferId();
             auto start = m_LightData.spotLights.dataRange.start;
             auto size = m_LightData.spotLights.dataRange.totalSize;
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<GLintptr>(start), size);
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<std::int64_t>(start), size);
         }
 
         if (m_LightData.directionalLights.count > 0 || m_LightData.directionalLights.shadowCount > 0)
@@ -166,7 +139,17 @@ namespace blurp
             auto bufferId = static_cast<GpuBuffer_GL*>(m_LightData.directionalLights.dataBuffer.get())->GetBufferId();
             auto start = m_LightData.directionalLights.dataRange.start;
             auto size = m_LightData.directionalLights.dataRange.totalSize;
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<GLintptr>(start), size);
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, slot, bufferId, static_cast<std::int64_t>(start), size);
+        }
+
+        //Bind the light clusters. When present, point and spot lights are only read through the clusters.
+        const auto& clusters = m_LightData.clusters;
+        const bool useLightClusters = clusters.dataBuffer != nullptr && clusters.counts.x > 0 && clusters.counts.y > 0 && clusters.counts.z > 0;
+        if (useLightClusters)
+        {
+            auto bufferId = static_cast<GpuBuffer_GL*>(clusters.dataBuffer.get())->GetBufferId();
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, 8, bufferId, static_cast<std::int64_t>(clusters.cells.start), clusters.cells.totalSize);
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, 9, bufferId, static_cast<std::int64_t>(clusters.lightIndices.start), clusters.lightIndices.totalSize);
         }
 
         auto numPosShadows = m_LightData.pointLights.shadowCount + m_LightData.spotLights.shadowCount;
@@ -176,386 +159,35 @@ namespace blurp
         if (m_ShadowData.directional.shadowMaps != nullptr && numDirShadows > 0 && m_ShadowData.directional.dataBuffer != nullptr)
         {
             //Sampler and shadowmaps
-            glActiveTexture(GL_TEXTURE0 + 6);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, reinterpret_cast<Texture_GL*>(m_ShadowData.directional.shadowMaps.get())->GetTextureId());
-            glBindSampler(6, m_ShadowSampler);
+            state.BindTexture(6, GL_TEXTURE_2D_ARRAY, reinterpret_cast<Texture_GL*>(m_ShadowData.directional.shadowMaps.get())->GetTextureId());
+            state.BindSampler(6, m_ShadowSampler);
 
             //Bind the buffer containing light space transformations.
             auto glBuffer = static_cast<GpuBuffer_GL*>(m_ShadowData.directional.dataBuffer.get());
-            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 4, glBuffer->GetBufferId(), static_cast<GLintptr>(m_ShadowData.directional.dataRange->start), m_ShadowData.directional.dataRange->totalSize);
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, 4, glBuffer->GetBufferId(), static_cast<std::int64_t>(m_ShadowData.directional.dataRange->start), m_ShadowData.directional.dataRange->totalSize);
         }
 
         if (m_ShadowData.positional.shadowMaps != nullptr && (numPosShadows > 0))
         {
-            glActiveTexture(GL_TEXTURE0 + 7);
-            glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, reinterpret_cast<Texture_GL*>(m_ShadowData.positional.shadowMaps.get())->GetTextureId());
-            glBindSampler(7, m_ShadowSampler);
+            state.BindTexture(7, GL_TEXTURE_CUBE_MAP_ARRAY, reinterpret_cast<Texture_GL*>(m_ShadowData.positional.shadowMaps.get())->GetTextureId());
+            state.BindSampler(7, m_ShadowSampler);
         }
         
 
-        //Upload the static data to the GPU such as the camera and light counts.
-        StaticData staticData;
-        staticData.pv = m_Camera->GetProjectionMatrix() * m_Camera->GetViewMatrix();
-        staticData.camPosFarPlane = glm::vec4(m_Camera->GetTransform().GetTranslation(), m_Camera->GetSettings().farPlane);
-        staticData.numLightsNumCascades = glm::vec4(m_LightData.pointLights.count, m_LightData.spotLights.count, m_LightData.directionalLights.count, m_ShadowData.directional.numCascades);
-        staticData.numShadows = glm::vec4(m_LightData.pointLights.shadowCount, m_LightData.spotLights.shadowCount, m_LightData.directionalLights.shadowCount, 0.f);
-        staticData.ambientLight = glm::vec4(m_LightData.ambient, 0.f);
-
-        glBindBuffer(GL_UNIFORM_BUFFER, m_StaticDataUbo);
-        glBindBufferBase(GL_UNIFORM_BUFFER, 1, m_StaticDataUbo);
-        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(staticData), static_cast<void*>(&staticData));
+        //Upload the static data to the GPU such as the camera and light counts. It was calculated when the pass was prepared.
+        state.BindBufferBase(GL_UNIFORM_BUFFER, 1, m_StaticDataUbo);
+        glNamedBufferSubData(m_StaticDataUbo, 0, sizeof(m_StaticData), static_cast<void*>(&m_StaticData));
 
         /*
-         * Retrieve the default pipeline state if none is specified for the first element.
+         * Record the draws into command lists on multiple threads, or reuse the lists of the last frame when nothing changed.
+         * The lists are then replayed here, because only this thread can make OpenGL calls.
          */
-        PipelineState* pipelineState = m_DrawDataSet.drawDataPtr[0].pipelineState;
-        if(pipelineState == nullptr)
-        {
-            pipelineState = &PipelineState::GetDefault();
-        }
-
-        //Keeps track wheter or not the pipeline state has to be updated.
-        bool setPipelineState = true;
-
-        /*
-         * Actual drawing.
-         */
-
-
-        for(auto i = 0u; i < m_DrawDataSet.drawDataCount; ++i)
-        {
-            auto& instanceData = m_DrawDataSet.drawDataPtr[i];
-
-            //If a pipeline state object is specified and not the same as the current state, then reapply the pipeline state.
-            if(instanceData.pipelineState != nullptr && instanceData.pipelineState->GetId() != pipelineState->GetId())
-            {
-                pipelineState = instanceData.pipelineState;
-                setPipelineState = true;
-            }
-
-            //Apply the pipeline state.
-            if (setPipelineState)
-            {
-                //Set depth
-                auto depthStencilData = pipelineState->GetDepthStencilData();
-                if (depthStencilData.enableDepth)
-                {
-                    glEnable(GL_DEPTH_TEST);    //Depth testing enabled.
-                    glDepthFunc(ToGL(depthStencilData.depthFunction)); //The depth function
-                    glDepthMask(depthStencilData.depthWrite);    //Enable or disable depth writing.
-                }
-                else
-                {
-                    glDisable(GL_DEPTH_TEST);   //No depth used at all.
-                }
-
-                //Set stencil
-                if (depthStencilData.enableStencil)
-                {
-                    /*
-                     * Note:
-                     * OpenGL and D3D12 have different stencil masking parameters in different places.
-                     * It's a bit vague so idk if this is 100% correct, but I believe it is.
-                     * If it doesn't seem to be working as intended then this is why.
-                     */
-
-                    glEnable(GL_STENCIL_TEST);
-
-                    //Front faces
-                    glStencilFuncSeparate(GL_FRONT,
-                        ToGL(depthStencilData.stencilFrontFace.stencilFunc),
-                        depthStencilData.stencilRef,
-                        depthStencilData.stencilReadMask);
-
-                    glStencilOpSeparate(GL_FRONT,
-                        ToGL(depthStencilData.stencilFrontFace.stencilFailOp),
-                        ToGL(depthStencilData.stencilFrontFace.stencilDepthFailOp),
-                        ToGL(depthStencilData.stencilFrontFace.stencilPassOp));
-
-                    //Back faces
-                    glStencilFuncSeparate(GL_BACK,
-                        ToGL(depthStencilData.stencilBackFace.stencilFunc),
-                        depthStencilData.stencilRef,
-                        depthStencilData.stencilReadMask);
-
-                    glStencilOpSeparate(GL_BACK,
-                        ToGL(depthStencilData.stencilBackFace.stencilFailOp),
-                        ToGL(depthStencilData.stencilBackFace.stencilDepthFailOp),
-                        ToGL(depthStencilData.stencilBackFace.stencilPassOp));
-
-                    //Write mask cannot be separate for different faces in D3D12, so I'm not supporting it in OpenGL either.
-                    glStencilMask(depthStencilData.stencilWriteMask);
-                }
-                else
-                {
-                    glDisable(GL_STENCIL_TEST);
-                }
-
-                //Set culling
-                if (pipelineState->GetCullMode() != CullMode::CULL_NONE)
-                {
-                    glEnable(GL_CULL_FACE);
-                    glCullFace(ToGL(pipelineState->GetCullMode()));
-                    glFrontFace(ToGL(pipelineState->GetFrontWindingOrder()));
-                }
-                else
-                {
-                    glDisable(GL_CULL_FACE);
-                }
-
-                //Set blending
-                auto blending = pipelineState->GetBlendData();
-                if (blending.blend)
-                {
-                    glEnable(GL_BLEND);
-
-                    glBlendFuncSeparate(
-                        ToGL(blending.srcBlend),
-                        ToGL(blending.dstBlend),
-                        ToGL(blending.srcBlendAlpha),
-                        ToGL(blending.dstBlendAlpha)
-                    );
-
-                    glBlendEquationSeparate(
-                        ToGL(blending.blendOperation),
-                        ToGL(blending.blendOperationAlpha)
-                    );
-                }
-                else
-                {
-                    glDisable(GL_BLEND);
-                }
-
-
-
-                //Mark state as current.
-                setPipelineState = false;
-            }
-
-
-            assert(instanceData.mesh != nullptr && "Mesh cannot be nullptr!");
-            assert(instanceData.instanceCount > 0 && "Cannot draw 0 instances of mesh!");
-
-            //TODO lock using ResourceLock for all currently used resources.
-
-            Mesh_GL* mesh = static_cast<Mesh_GL*>(instanceData.mesh.get());
-
-            //Shadows active?
-            const bool usePosShadows = numPosShadows != 0;
-            const bool useDirShadows = numDirShadows != 0;
-
-            //Has the material and materialbatch changed?
-            const bool changedMaterial = prevMaterial != instanceData.materialData.material;
-            const bool changedBatch = prevMaterialBatch != instanceData.materialData.materialBatch;
-
-            //Cache last used batch/material
-            prevMaterial = instanceData.materialData.material;
-            prevMaterialBatch = instanceData.materialData.materialBatch;
-
-            //See if materials or batches are enabled.
-            const bool material = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_SINGLE);
-            const bool materialBatch = instanceData.attributes.IsAttributeEnabled(DrawAttribute::MATERIAL_BATCH);
-
-            //Ensure that either only one is enabled, or both are disabled. Never both enabled.
-            assert((material != materialBatch) || (!material && !materialBatch));
-
-            //Shader mask matching the vertex layout.
-            std::uint64_t shaderMask = static_cast<std::uint64_t>(mesh->GetVertexAttributeMask()) | (instanceData.attributes.GetMask() << NUM_VERTEX_ATRRIBS);
-
-            if(material && instanceData.materialData.material != nullptr)
-            {
-                shaderMask = shaderMask | (static_cast<std::uint64_t>(instanceData.materialData.material->GetSettings().GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS));
-            }
-            else if(materialBatch && instanceData.materialData.materialBatch != nullptr)
-            {
-                shaderMask = shaderMask | (static_cast<std::uint64_t>(instanceData.materialData.materialBatch->GetMask()) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS));
-            }
-
-            //Mask for shadow usage.
-            if(usePosShadows)
-            {
-                shaderMask |= usePosShadowsBit;
-            }
-            if(useDirShadows)
-            {
-                shaderMask |= useDirShadowsBit;
-            }
-
-            //Has the shader changed?
-            const bool changedShader = shaderMask != prevMask;
-
-            //If the current mask is not the same as the one needed, switch shader.
-            if(changedShader)
-            {
-                //Bind the new shader.
-                prevMask = shaderMask;
-
-                //Get the new shader. If not present, load a new one.
-                auto newShader = m_ShaderCache.GetOrNull(shaderMask);
-                if(newShader == nullptr)
-                {
-                    newShader = m_ShaderCache.LoadShader(shaderMask, mesh->GetAttribLocations());
-                }
-                const std::shared_ptr<Shader_GL> currentShader = std::reinterpret_pointer_cast<Shader_GL>(newShader);
-                currentProgramId = currentShader->GetProgramId();
-                glUseProgram(currentProgramId);
-            }
-
-            //If the current material is new or the shader changed, re-upload the material data.
-            if (material && (changedMaterial || changedShader))
-            {
-                auto& matSettings = instanceData.materialData.material->GetSettings();
-
-                //DIFFUSE
-                if(matSettings.IsAttributeEnabled(MaterialAttribute::DIFFUSE_TEXTURE) && matSettings.GetDiffuseTexture() != nullptr)
-                {
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, std::static_pointer_cast<Texture_GL>(matSettings.GetDiffuseTexture())->GetTextureId());
-                }
-                else if(matSettings.IsAttributeEnabled(MaterialAttribute::DIFFUSE_CONSTANT_VALUE))
-                {
-                    const auto diffuse = matSettings.GetDiffuseValue();
-                    glUniform3f(1, diffuse.x, diffuse.y, diffuse.z);
-                }
-
-                //NORMAL
-                if (matSettings.IsAttributeEnabled(MaterialAttribute::NORMAL_TEXTURE) && matSettings.GetNormalTexture() != nullptr)
-                {
-                    glActiveTexture(GL_TEXTURE1);
-                    glBindTexture(GL_TEXTURE_2D, std::static_pointer_cast<Texture_GL>(matSettings.GetNormalTexture())->GetTextureId());
-                }
-
-                //EMISSIVE
-                if (matSettings.IsAttributeEnabled(MaterialAttribute::EMISSIVE_TEXTURE) && matSettings.GetEmissiveTexture() != nullptr)
-                {
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, std::static_pointer_cast<Texture_GL>(matSettings.GetEmissiveTexture())->GetTextureId());
-                }
-                else if (matSettings.IsAttributeEnabled(MaterialAttribute::EMISSIVE_CONSTANT_VALUE))
-                {
-                    const auto diffuse = matSettings.GetEmissiveValue();
-                    glUniform3f(2, diffuse.x, diffuse.y, diffuse.z);
-                }
-
-                //METAL/ROUGHNESS/ALPHA
-                if ((matSettings.IsAttributeEnabled(MaterialAttribute::METALLIC_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::ROUGHNESS_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::ALPHA_TEXTURE)) && matSettings.GetMRATexture() != nullptr)
-                {
-                    glActiveTexture(GL_TEXTURE3);
-                    glBindTexture(GL_TEXTURE_2D, std::static_pointer_cast<Texture_GL>(matSettings.GetMRATexture())->GetTextureId());
-                }
-                if (matSettings.IsAttributeEnabled(MaterialAttribute::METALLIC_CONSTANT_VALUE))
-                {
-                    glUniform1f(3, matSettings.GetAlphaValue());
-                }
-                if (matSettings.IsAttributeEnabled(MaterialAttribute::ROUGHNESS_CONSTANT_VALUE))
-                {
-                    glUniform1f(4, matSettings.GetAlphaValue());
-                }
-                if (matSettings.IsAttributeEnabled(MaterialAttribute::ALPHA_CONSTANT_VALUE))
-                {
-                    glUniform1f(5, matSettings.GetAlphaValue());
-                }
-
-                //OCCLUSION/HEIGHT
-                if ((matSettings.IsAttributeEnabled(MaterialAttribute::OCCLUSION_TEXTURE) || matSettings.IsAttributeEnabled(MaterialAttribute::HEIGHT_TEXTURE)) && matSettings.GetOHTexture() != nullptr)
-                {
-                    glActiveTexture(GL_TEXTURE4);
-                    glBindTexture(GL_TEXTURE_2D, std::static_pointer_cast<Texture_GL>(matSettings.GetOHTexture())->GetTextureId());
-                }
-            }
-
-            //If the material batch data needs to be bound, bind it.
-            if (materialBatch && (changedBatch || changedShader))
-            {
-                auto batchGl = static_cast<MaterialBatch_GL*>(instanceData.materialData.materialBatch.get());
-
-                //Bind the texture
-                if(batchGl->HasTexture())
-                {
-                    auto texture = std::static_pointer_cast<Texture_GL>(batchGl->GetTexture());
-                    glActiveTexture(GL_TEXTURE5);
-                    glBindTexture(GL_TEXTURE_2D_ARRAY, texture->GetTextureId());
-
-                    //Set the stride uniform
-                    glUniform1i(6, batchGl->GetActiveTextureCount());
-                }
-                if(batchGl->HasUbo())
-                {
-                    auto uboId = batchGl->GetUboID();
-                    glBindBuffer(GL_UNIFORM_BUFFER, uboId);
-                    glBindBufferBase(GL_UNIFORM_BUFFER, 2, uboId);
-                }
-            }
-
-            //Which DrawData is active?
-            const bool matrixEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX);
-            const bool normalMatrixEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX);
-            const bool uvModEnabled = instanceData.attributes.IsAttributeEnabled(DrawAttribute::UV_MODIFIER);
-
-            //If transforms are uploaded, bind the transform buffer.
-            if(matrixEnabled || normalMatrixEnabled)
-            {
-                //Make sure the buffer and view are valid.
-                assert(instanceData.transformData.dataBuffer != nullptr);
-
-                //Bind the SSBO to the instance data slot (0).
-                const auto glTransformGpuBuffer = std::reinterpret_pointer_cast<GpuBuffer_GL>(instanceData.transformData.dataBuffer);
-
-                //Set the binding point that the shader interface block reads from to contain a specific range from the GPU buffer.
-                //Shader is hard coded to use slot 0 for the buffer.
-                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, glTransformGpuBuffer->GetBufferId(), static_cast<GLintptr>(instanceData.transformData.dataRange.start), instanceData.transformData.dataRange.totalSize);
-            }
-
-
-            //Check if Uv modifiers are enabled. Bind to slot 3 if used.
-            const bool hasUvModifiers = (uvModEnabled && (mesh->GetVertexAttributeMask() & VertexAttribute::UV_MODIFIER_ID) == VertexAttribute::UV_MODIFIER_ID) && instanceData.uvModifierData.dataBuffer != nullptr;
-            if(hasUvModifiers)
-            {
-                assert(instanceData.uvModifierData.dataBuffer != nullptr);
-
-                auto glUvModifierBuffer = static_cast<GpuBuffer_GL*>(instanceData.uvModifierData.dataBuffer.get());
-                glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, glUvModifierBuffer->GetBufferId(), static_cast<GLintptr>(instanceData.uvModifierData.dataRange.start), instanceData.uvModifierData.dataRange.totalSize);
-            }
-
-            //Upload how many instances are dynamic. The shader invocation instance is then divided by this to get the right ID into the dynamic array.
-            glUniform1i(0, instanceData.instanceCount);
-
-            //If the geometry changed, bind the new geometry.
-            if(prevMesh != instanceData.mesh)
-            {
-                //Bind the VAO of the mesh.
-                glBindVertexArray(mesh->GetVaoId());
-                prevMesh = instanceData.mesh;
-            }
-
-            //Finally draw instanced.
-            auto blurpTopology = pipelineState->GetTopology();
-            auto glTopology = ToGL(blurpTopology);
-
-            //Set up the right instance divisor based on the number of instances.
-            for(auto& pair : mesh->GetInstanceDivisors())
-            {
-                //Divisor is the increment rate of the attribute in literal instances. It's not based on other divisors!
-                glVertexAttribDivisor(pair.first, pair.second * instanceData.instanceCount);
-            }
-
-            if(blurpTopology == TopologyType::POINTS)
-            {
-                glEnable(GL_PROGRAM_POINT_SIZE);
-                glPointSize(5.f);
-
-                glDrawArraysInstanced(glTopology, 0, mesh->GetNumIndices(), instanceData.instanceCount * mesh->GetInstanceCount());
-            }
-            //Indexed drawing.
-            else
-            {
-                glDrawElementsInstanced(glTopology, mesh->GetNumIndices(), mesh->GetIndexDataType(), nullptr, instanceData.instanceCount * mesh->GetInstanceCount());
-            }
-        }
+        RecordDraws();
+        m_DrawLists.Replay(m_Pipeline.GetCommandListBackend());
+    }
 
-        //Unbind state that may affect other rendering.
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-        glBindVertexArray(0);
+    std::shared_ptr<Shader> RenderPass_Forward_GL::GetShader(std::uint64_t a_Mask, const Mesh& a_Mesh)
+    {
+        return m_ShaderCache.GetOrRequest(a_Mask, static_cast<const Mesh_GL&>(a_Mesh).GetAttribLocations());
     }
 }
@@ -0,0 +1,126 @@
+#include "null/RenderPass_Forward_Null.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "BlurpEngine.h"
+#include "CommandRecording.h"
+#include "FileReader.h"
+#include "GpuBuffer.h"
+#include "Material.h"
+#include "MaterialBatch.h"
+#include "RenderPipeline_Null.h"
+#include "null/MaterialBatch_Null.h"
+#include "null/Mesh_Null.h"
+#include "null/RenderTarget_Null.h"
+
+namespace blurp
+{
+    bool RenderPass_Forward_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //The OpenGL shaders are used, so that variants are preprocessed and shared exactly like with a graphics API.
+        auto shaderPath = a_BlurpEngine.GetEngineSettings().shadersPath + "opengl/";
+        auto vertex = "Default_Forward.vs";
+        auto fragment = "Default_Forward.fs";
+
+        FileReader vertexReader(shaderPath + vertex);
+        FileReader fragmentReader(shaderPath + fragment);
+
+        if(!vertexReader.Open() || !fragmentReader.Open())
+        {
+            throw std::runtime_error("Could not find forward shaders at path specified.");
+        }
+
+        auto vertexSrc = vertexReader.ToArray();
+        auto fragmentSrc = fragmentReader.ToArray();
+
+        ShaderSettings sSettings;
+        sSettings.vertexShaderSource = vertexSrc.get();
+        sSettings.fragmentShaderSource = fragmentSrc.get();
+        sSettings.type = ShaderType::GRAPHICS;
+
+        m_ShaderCache.Init(a_BlurpEngine, sSettings, CreateShaderMaskTable());
+        m_ShaderCache.SetPreprocessing(true, shaderPath);
+
+        return true;
+    }
+
+    bool RenderPass_Forward_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    void RenderPass_Forward_Null::Submit()
+    {
+        //Compile the variants from the manifest before they are needed.
+        if (m_ShaderManifestChanged)
+        {
+            m_ShaderCache.SetManifest(m_ShaderManifest, "Forward");
+            m_ShaderManifestChanged = false;
+        }
+        m_ShaderCache.WarmUp(m_WarmUpBudget);
+
+        constexpr std::uint64_t exactBits = (static_cast<std::uint64_t>(1) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS)) - 1;
+        m_ShaderCache.SetFallbackPolicy(m_ShaderFallbackPolicy, exactBits);
+        m_ShaderCache.UpdateCompiles(m_CompileBudget);
+
+        //Don't run if no data is present.
+        if (m_DrawDataSet.drawDataCount == 0) return;
+
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+        static_cast<RenderTarget_Null*>(m_Output.get())->Bind(recording);
+
+        //Bind lights.
+        if(m_LightData.pointLights.count > 0 || m_LightData.pointLights.shadowCount > 0)
+        {
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, m_LightData.pointLights.dataBuffer.get(), 5, static_cast<std::uint32_t>(m_LightData.pointLights.dataRange.totalSize), m_LightData.pointLights.dataRange.start);
+        }
+
+        if (m_LightData.spotLights.count > 0 || m_LightData.spotLights.shadowCount > 0)
+        {
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, m_LightData.spotLights.dataBuffer.get(), 6, static_cast<std::uint32_t>(m_LightData.spotLights.dataRange.totalSize), m_LightData.spotLights.dataRange.start);
+        }
+
+        if (m_LightData.directionalLights.count > 0 || m_LightData.directionalLights.shadowCount > 0)
+        {
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, m_LightData.directionalLights.dataBuffer.get(), 7, static_cast<std::uint32_t>(m_LightData.directionalLights.dataRange.totalSize), m_LightData.directionalLights.dataRange.start);
+        }
+
+        //Bind the light clusters. When present, point and spot lights are only read through the clusters.
+        const auto& clusters = m_LightData.clusters;
+        const bool useLightClusters = clusters.dataBuffer != nullptr && clusters.counts.x > 0 && clusters.counts.y > 0 && clusters.counts.z > 0;
+        if (useLightClusters)
+        {
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, clusters.dataBuffer.get(), 8, static_cast<std::uint32_t>(clusters.cells.totalSize), clusters.cells.start);
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, clusters.dataBuffer.get(), 9, static_cast<std::uint32_t>(clusters.lightIndices.totalSize), clusters.lightIndices.start);
+        }
+
+        auto numPosShadows = m_LightData.pointLights.shadowCount + m_LightData.spotLights.shadowCount;
+        auto numDirShadows = m_LightData.directionalLights.shadowCount;
+
+        //Bind the shadow maps if they are specified and there is lights that use shadows.
+        if (m_ShadowData.directional.shadowMaps != nullptr && numDirShadows > 0 && m_ShadowData.directional.dataBuffer != nullptr)
+        {
+            recording.Record(RecordedCommandType::BIND_TEXTURE, m_ShadowData.directional.shadowMaps.get(), 6);
+            recording.Record(RecordedCommandType::BIND_STORAGE_BUFFER, m_ShadowData.directional.dataBuffer.get(), 4, static_cast<std::uint32_t>(m_ShadowData.directional.dataRange->totalSize), m_ShadowData.directional.dataRange->start);
+        }
+
+        if (m_ShadowData.positional.shadowMaps != nullptr && (numPosShadows > 0))
+        {
+            recording.Record(RecordedCommandType::BIND_TEXTURE, m_ShadowData.positional.shadowMaps.get(), 7);
+        }
+
+        //Upload the static data such as the camera and light counts, which was calculated when the pass was prepared.
+        recording.Record(RecordedCommandType::BIND_UNIFORM_BUFFER, &m_StaticData, 1, sizeof(m_StaticData));
+        recording.RecordUpload(&m_StaticData, &m_StaticData, sizeof(m_StaticData));
+
+        //Record the draws like the OpenGL pass does, and replay them into the recording.
+        RecordDraws();
+        m_DrawLists.Replay(m_Pipeline.GetCommandListBackend());
+    }
+
+    std::shared_ptr<Shader> RenderPass_Forward_Null::GetShader(std::uint64_t a_Mask, const Mesh& a_Mesh)
+    {
+        return m_ShaderCache.GetOrRequest(a_Mask, static_cast<const Mesh_Null&>(a_Mesh).GetAttribLocations());
+    }
+}
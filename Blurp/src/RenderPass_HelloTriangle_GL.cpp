@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "opengl/RenderTarget_GL.h"
+#include "opengl/RenderPipeline_GL.h"
 
 #include "BlurpEngine.h"
 #include "RenderResourceManager.h"
@@ -71,20 +72,22 @@ namespace blurp
         return true;
     }
 
-    void RenderPass_HelloTriangle_GL::Execute()
+    void RenderPass_HelloTriangle_GL::Submit()
     {
         //Clear the target buffer.
         const auto fboId = reinterpret_cast<RenderTarget_GL*>(m_Target.get())->GetFrameBufferId();
 
-        glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+        auto& state = static_cast<RenderPipeline_GL&>(m_Pipeline).GetStateTracker();
+
+        state.BindFramebuffer(fboId);
         const auto viewPort = m_Target->GetViewPort();
-        glViewport(static_cast<int>(viewPort.r), static_cast<int>(viewPort.g), static_cast<int>(viewPort.b), static_cast<int>(viewPort.a));
+        state.SetViewport(static_cast<int>(viewPort.r), static_cast<int>(viewPort.g), static_cast<int>(viewPort.b), static_cast<int>(viewPort.a));
 
         const auto scissorRect = m_Target->GetScissorRect();
-        glScissor(static_cast<int>(scissorRect.r), static_cast<int>(scissorRect.g), static_cast<int>(scissorRect.b), static_cast<int>(scissorRect.a));
+        state.SetScissor(static_cast<int>(scissorRect.r), static_cast<int>(scissorRect.g), static_cast<int>(scissorRect.b), static_cast<int>(scissorRect.a));
 
-        glUseProgram(std::reinterpret_pointer_cast<Shader_GL>(m_Shader)->GetProgramId());
-        glBindVertexArray(m_Vao);
+        state.UseProgram(std::reinterpret_pointer_cast<Shader_GL>(m_Shader)->GetProgramId());
+        state.BindVertexArray(m_Vao);
 
         glUniform4f(m_ColorUniformId, m_Color.r, m_Color.g, m_Color.b, m_Color.a);
 
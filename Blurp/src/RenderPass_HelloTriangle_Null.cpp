@@ -0,0 +1,34 @@
+#include "null/RenderPass_HelloTriangle_Null.h"
+
+#include "BlurpEngine.h"
+#include "CommandRecording.h"
+#include "RenderPipeline_Null.h"
+#include "RenderResourceManager.h"
+#include "null/RenderTarget_Null.h"
+
+namespace blurp
+{
+    bool RenderPass_HelloTriangle_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //The shader is never compiled, so it needs no source.
+        ShaderSettings shaderSettings;
+        shaderSettings.type = ShaderType::GRAPHICS;
+        m_Shader = a_BlurpEngine.GetResourceManager().CreateShader(shaderSettings);
+        return true;
+    }
+
+    bool RenderPass_HelloTriangle_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    void RenderPass_HelloTriangle_Null::Submit()
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+
+        static_cast<RenderTarget_Null*>(m_Target.get())->Bind(recording);
+        recording.Record(RecordedCommandType::BIND_SHADER, m_Shader.get());
+        recording.RecordUniform(0, &m_Color, sizeof(m_Color));
+        recording.Record(RecordedCommandType::DRAW, nullptr, 0, 3, 1);
+    }
+}
@@ -1,6 +1,22 @@
 #include "RenderPass_ShadowMap.h"
+#include "PositionalShadowCache.h"
+#include "CascadeScheduler.h"
+#include "CommandList.h"
+#include "Data.h"
+#include "GpuBuffer.h"
+#include "Mesh.h"
+#include "RenderPipeline.h"
+#include "Settings.h"
+#include "Shader.h"
 #include "Texture.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+
 namespace blurp
 {
     void RenderPass_ShadowMap::SetCamera(const std::shared_ptr<Camera>& a_Camera)
@@ -25,7 +41,7 @@ namespace blurp
             m_DirectionalLights.emplace_back(LightShadowData(a_Index, std::static_pointer_cast<DirectionalLight>(a_Light)->GetDirection()));
             break;
         default:
-            throw std::exception("Light type cannot generate a shadow!");
+            throw std::runtime_error("Light type cannot generate a shadow!");
             break;
         }
     }
@@ -37,6 +53,11 @@ namespace blurp
         m_LightIndices = a_LightIndexData;
     }
 
+    void RenderPass_ShadowMap::SetDrawSorting(bool a_Enabled)
+    {
+        m_SortDrawData = a_Enabled;
+    }
+
     void RenderPass_ShadowMap::SetOutput(const ShadowData& a_Data)
     {
         //Ensure positional shadows are correctly set up. No shadow maps are generated if the textures provided are null.
@@ -59,10 +80,258 @@ namespace blurp
         }
 #endif
 
+        //Static layers have to match the shadow maps, because faces are copied between them.
+        assert((a_Data.positional.staticShadowMaps == nullptr || a_Data.positional.shadowMaps != nullptr) && "Static shadow layers require positional shadow maps.");
+        assert((a_Data.positional.staticShadowMaps == nullptr || a_Data.positional.staticShadowMaps->GetDimensions() == a_Data.positional.shadowMaps->GetDimensions()) && "Static shadow layers need the same dimensions as the shadow maps.");
+        assert((a_Data.positional.staticShadowMaps == nullptr || a_Data.positional.staticShadowMaps->GetTextureType() == TextureType::TEXTURE_CUBEMAP_ARRAY) && "Static shadow layers require a Cubemap Texture Array.");
+        assert((a_Data.positional.staticShadowMaps == nullptr || a_Data.positional.staticShadowMaps->GetPixelFormat() == PixelFormat::DEPTH) && "Shadowmaps only need a depth channel.");
+
         //Finally store the data struct if everything is in order.
         m_ShadowData = a_Data;
     }
 
+    void RenderPass_ShadowMap::SetShadowCache(const std::shared_ptr<PositionalShadowCache>& a_Cache)
+    {
+        m_ShadowCache = a_Cache;
+    }
+
+    void RenderPass_ShadowMap::UpdateShadowCache()
+    {
+        assert(m_ShadowCache != nullptr && "No shadow cache was set!");
+        assert(m_Camera != nullptr && "Shadow cache requires the camera to be set.");
+
+        const auto& camSettings = m_Camera->GetSettings();
+        m_ShadowCache->Update(m_PositionalLights.data(), static_cast<std::uint32_t>(m_PositionalLights.size()), m_DrawDataPtr, m_LightIndices, m_DrawDataCount, camSettings.nearPlane, camSettings.farPlane);
+    }
+
+    void RenderPass_ShadowMap::SetShaderManifest(const std::shared_ptr<ShaderManifest>& a_Manifest, float a_WarmUpBudget)
+    {
+        m_ShaderManifest = a_Manifest;
+        m_WarmUpBudget = a_WarmUpBudget;
+        m_ShaderManifestChanged = true;
+    }
+
+    void RenderPass_ShadowMap::SetShaderFallbackPolicy(ShaderFallbackPolicy a_Policy, float a_CompileBudget)
+    {
+        m_ShaderFallbackPolicy = a_Policy;
+        m_CompileBudget = a_CompileBudget;
+    }
+
+    ShaderFallbackPolicy RenderPass_ShadowMap::GetShaderFallbackPolicy() const
+    {
+        return m_ShaderFallbackPolicy;
+    }
+
+    void RenderPass_ShadowMap::SetCascadeScheduler(const std::shared_ptr<CascadeScheduler>& a_Scheduler)
+    {
+        m_CascadeScheduler = a_Scheduler;
+    }
+
+    void RenderPass_ShadowMap::UpdateCascadeScheduler()
+    {
+        assert(m_CascadeScheduler != nullptr && "No cascade scheduler was set!");
+        assert(m_Camera != nullptr && "Cascade scheduler requires the camera to be set.");
+
+        m_CascadeScheduler->Schedule(*m_Camera, m_DirectionalLights.data(), static_cast<std::uint32_t>(m_DirectionalLights.size()), m_ShadowData);
+    }
+
+    std::uint32_t RenderPass_ShadowMap::GetSkippedCascades() const
+    {
+        return m_SkippedCascades;
+    }
+
+    void RenderPass_ShadowMap::CalculateCascades(const Camera& a_Camera, const glm::vec3& a_Direction, const ShadowData& a_ShadowData, glm::mat4* a_Matrices, glm::vec4* a_ClipDepths)
+    {
+        //Matrix used to convert a point from camera space to world space.
+        const glm::mat4 camToWorld = a_Camera.GetTransform().GetTransformation();
+
+        //Horizontal and vertical FOV.
+        auto& camSettings = a_Camera.GetSettings();
+        const float verticalFovTanHalved = tanf(glm::radians(camSettings.fov / 2.0f));
+        const float aspectRatio = camSettings.width / camSettings.height;
+        const float horizontalFovTanHalved = verticalFovTanHalved * aspectRatio;
+
+        //Find an up vector.
+        glm::vec3 up = Transform::GetWorldUp();
+        if (fabsf(glm::dot(up, a_Direction)) <= 0.f + std::numeric_limits<float>::epsilon())
+        {
+            up = Transform::GetWorldRight();
+        }
+
+        //Matrices transforming Z to light direction, and camera to light space.
+        const glm::mat4 lightMatrix = glm::lookAt(glm::vec3(0.f, 0.f, 0.f), a_Direction, up);
+        const glm::mat4 camToLight = lightMatrix * camToWorld;
+
+        float lastFar = 0.f;
+
+        for (std::uint32_t cascade = 0; cascade < a_ShadowData.directional.numCascades; ++cascade)
+        {
+            glm::vec4 cameraFrustumCorners[8];      //The 8 corners of the frustum.
+
+            //Calculate the far and near Z positions of this cascade. The last cascade is goes all the way to the far plane.
+            float nearZ = lastFar;
+            float farZ = nearZ + a_ShadowData.directional.cascadeDistances[cascade];
+            lastFar = farZ;
+
+            //Calculate near and far X using some trigonometry.
+            const float nearX = nearZ * horizontalFovTanHalved;
+            const float farX = farZ * horizontalFovTanHalved;
+
+            //Calculate Y using the vertical FOV.
+            const float nearY = nearZ * verticalFovTanHalved;
+            const float farY = farZ * verticalFovTanHalved;
+
+            //Because the camera frustum points in negative Z direction, invert the Z coordinates.
+            farZ *= -1.f;
+            nearZ *= -1.f;
+
+            //All 8 corners.
+            cameraFrustumCorners[0] = { -nearX, -nearY, nearZ, 1.f };
+            cameraFrustumCorners[1] = { +nearX, -nearY, nearZ, 1.f };
+            cameraFrustumCorners[2] = { -nearX, +nearY, nearZ, 1.f };
+            cameraFrustumCorners[3] = { +nearX, +nearY, nearZ, 1.f };
+            cameraFrustumCorners[4] = { -farX, -farY, farZ, 1.f };
+            cameraFrustumCorners[5] = { +farX, -farY, farZ, 1.f };
+            cameraFrustumCorners[6] = { -farX, +farY, farZ, 1.f };
+            cameraFrustumCorners[7] = { +farX, +farY, farZ, 1.f };
+
+            //Min and max coordinates on each axis.
+            glm::vec3 min(std::numeric_limits<float>::max());
+            glm::vec3 max(-std::numeric_limits<float>::max());
+
+            //Transform to world space and then to light space. All corners are now aligned with the light (Z = light dir).
+            //Then compare the coordinates to find the min and max of each axis.
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                cameraFrustumCorners[corner] = camToLight * cameraFrustumCorners[corner];
+
+                min.x = std::fmin(min.x, cameraFrustumCorners[corner].x);
+                min.y = std::fmin(min.y, cameraFrustumCorners[corner].y);
+                min.z = std::fmin(min.z, cameraFrustumCorners[corner].z);
+
+                max.x = std::fmax(max.x, cameraFrustumCorners[corner].x);
+                max.y = std::fmax(max.y, cameraFrustumCorners[corner].y);
+                max.z = std::fmax(max.z, cameraFrustumCorners[corner].z);
+            }
+
+            //Simpler way in world space without light translation. 
+            const float depth = max.z - min.z;
+            const float depthH = depth / 2.f;
+            const float scaleFactor = glm::dot(a_Direction, a_Camera.GetTransform().GetBack());
+            const float cascadeDepthH = fabsf((farZ - nearZ) / 2.f);
+            const float frustumCenterDistance = -nearZ + cascadeDepthH;
+            const float lightDistance = camSettings.farPlane + depthH + (frustumCenterDistance * scaleFactor);
+
+            /*
+             * Z is always along the -z axis. THis means that the max Z value is closer to 0 than min.z.
+             * In light space, the light always points down -z axis. This means that near plane is always max.z.
+             * FarPlane is min.z because it's further away from the Z origin.
+             *
+             * Finally add lightDistance onto the nearplane. This moves it into the positive Z direction, which means objects in the lights frustum are captured.
+             */
+            const float nearPlane = max.z + lightDistance;
+            const float farPlane = min.z;
+
+            /*
+             * Construct the projection matrix from identity (1 in constructor makes it identity).
+             */
+            glm::mat<4, 4, float, glm::defaultp> proj(1);
+            proj[0][0] = static_cast<float>(2) / (max.x - min.x);
+            proj[1][1] = static_cast<float>(2) / (max.y - min.y);
+            proj[2][2] = static_cast<float>(2) / (farPlane - nearPlane);    //Z is already negative so no need to flip.
+            proj[3][0] = -(max.x + min.x) / (max.x - min.x);
+            proj[3][1] = -(max.y + min.y) / (max.y - min.y);
+            proj[3][2] = -(farPlane + nearPlane) / (farPlane - nearPlane);
+
+            //Combine PV matrices.
+            a_Matrices[cascade] = proj * lightMatrix;
+            if (a_ShadowData.directional.shadowMaps != nullptr)
+            {
+                SnapToTexels(a_Matrices[cascade], a_ShadowData.directional.shadowMaps->GetDimensions().x);
+            }
+            a_ClipDepths[cascade] = a_Camera.GetProjectionMatrix() * glm::vec4(0.f, 0.f, farZ, 1.f);
+        }
+    }
+
+    void RenderPass_ShadowMap::CalculateCubeFaces(const glm::vec3& a_Position, float a_NearPlane, float a_FarPlane, glm::mat4* a_Matrices)
+    {
+        //Aspect is 1 because cubemaps have equal width and height.
+        const glm::mat4 projection = glm::perspective(glm::radians(90.f), 1.f, a_NearPlane, a_FarPlane);
+
+        a_Matrices[0] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0));
+        a_Matrices[1] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(-1.0, 0.0, 0.0), glm::vec3(0.0, -1.0, 0.0));
+        a_Matrices[2] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.0, 1.0));
+        a_Matrices[3] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(0.0, -1.0, 0.0), glm::vec3(0.0, 0.0, -1.0));
+        a_Matrices[4] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(0.0, 0.0, 1.0), glm::vec3(0.0, -1.0, 0.0));
+        a_Matrices[5] = projection * glm::lookAt(a_Position, a_Position + glm::vec3(0.0, 0.0, -1.0), glm::vec3(0.0, -1.0, 0.0));
+    }
+
+    ShaderMaskTable RenderPass_ShadowMap::CreateShaderMaskTable()
+    {
+        ShaderMaskTable table;
+
+        //The shadow shaders only read the position and the matrix of each vertex.
+        for (auto& attrib : VERTEX_ATTRIBUTES)
+        {
+            const auto info = VertexSettings::GetVertexAttributeInfo(attrib);
+            const bool used = attrib == VertexAttribute::POSITION_3D || attrib == VertexAttribute::MATRIX;
+            table.Add(info.defineName, used, info.locationDefine);
+        }
+
+        //The normal matrix is not used, but it changes the layout of the instance data.
+        for (auto& attrib : DRAW_ATTRIBUTES)
+        {
+            auto found = DRAW_ATTRIBUTE_INFO.find(attrib);
+            assert(found != DRAW_ATTRIBUTE_INFO.end());
+            table.Add(found->second.defineName, attrib == DrawAttribute::TRANSFORMATION_MATRIX || attrib == DrawAttribute::NORMAL_MATRIX);
+        }
+
+        table.Add("POSITIONAL", true);
+        table.Add("DIRECTIONAL", true);
+        return table;
+    }
+
+    std::uint32_t RenderPass_ShadowMap::CalculateCubeFaceMask(const glm::vec3& a_Position, float a_NearPlane, float a_FarPlane, const glm::vec3& a_Center, float a_Radius)
+    {
+        //Every face is a 90 degree pyramid around an axis. Its side planes go through the light at 45 degrees, so their normals are (axis +- other axis) / sqrt(2).
+        const glm::vec3 offset = a_Center - a_Position;
+        const float sideReach = a_Radius * 1.41421356f;
+
+        std::uint32_t mask = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float u = offset[(axis + 1) % 3];
+            const float v = offset[(axis + 2) % 3];
+
+            //Positive face first, then negative.
+            for (int side = 0; side < 2; ++side)
+            {
+                const float depth = side == 0 ? offset[axis] : -offset[axis];
+                const bool inside = depth >= a_NearPlane - a_Radius && depth <= a_FarPlane + a_Radius
+                    && depth - u >= -sideReach && depth + u >= -sideReach
+                    && depth - v >= -sideReach && depth + v >= -sideReach;
+
+                if (inside)
+                {
+                    mask |= 1u << (axis * 2 + side);
+                }
+            }
+        }
+        return mask;
+    }
+
+    void RenderPass_ShadowMap::SnapToTexels(glm::mat4& a_Matrix, std::uint32_t a_Resolution)
+    {
+        //Position of the world origin in texels. Clip space is 2 units wide.
+        const float texelsPerUnit = static_cast<float>(a_Resolution) * 0.5f;
+        const glm::vec2 origin = glm::vec2(a_Matrix[3]) * texelsPerUnit;
+        const glm::vec2 offset = (glm::round(origin) - origin) / texelsPerUnit;
+
+        //The matrix is orthographic, so the translation moves everything by the same amount.
+        a_Matrix[3][0] += offset.x;
+        a_Matrix[3][1] += offset.y;
+    }
+
     RenderPassType RenderPass_ShadowMap::GetType()
     {
         return RenderPassType::RP_SHADOWMAP;
@@ -90,6 +359,12 @@ namespace blurp
             return false;
         }
 
+        //The shadow cache keeps static casters in layers that do not exist.
+        if (m_ShadowCache != nullptr && m_ShadowCache->GetSettings().staticLayers && !m_ShadowData.positional.staticShadowMaps)
+        {
+            return false;
+        }
+
         //There is no camera specified for the scene.
         if(m_Camera == nullptr)
         {
@@ -98,4 +373,400 @@ namespace blurp
 
         return true;
     }
+
+    void RenderPass_ShadowMap::PrePrepare()
+    {
+        //The camera can be shared with other passes that are prepared at the same time.
+        m_Camera->UpdateMatrices();
+    }
+
+    void RenderPass_ShadowMap::Prepare()
+    {
+        assert(m_PositionalLights.size() <= MAX_SHADOW_LIGHTS && "Max positional light count for shadow mapping exceeded!");
+        assert(m_DirectionalLights.size() <= MAX_SHADOW_LIGHTS && "Max number of directional lights exceeded!");
+
+        //Only read the camera, because it can be shared with other passes that are prepared at the same time.
+        const Camera& camera = *m_Camera;
+        const auto nearPlane = camera.GetSettings().nearPlane;
+        const auto farPlane = camera.GetSettings().farPlane;
+
+        /*
+         * Sort the geometry if enabled. Only the indices are reordered, the draw data and light indices stay in place.
+         * Materials are not bound for shadows, so they are left out of the sort key.
+         */
+        m_DrawOrder = nullptr;
+        if (m_SortDrawData && m_DrawDataCount > 0)
+        {
+            DrawSortSettings sortSettings;
+            sortSettings.nearPlane = nearPlane;
+            sortSettings.farPlane = farPlane;
+            sortSettings.sortMaterials = false;
+
+            m_DrawSorter.Sort(m_DrawDataPtr, m_DrawDataCount, sortSettings);
+            m_DrawOrder = m_DrawSorter.GetOrder().data();
+        }
+
+        //Positional lights use the camera near and far plane for their projection. Light depth is stored within the near-far range.
+        m_PosLightData.clear();
+        if (!m_PositionalLights.empty() && m_ShadowData.positional.shadowMaps != nullptr)
+        {
+            m_PosLightData.resize(m_PositionalLights.size());
+            for (std::size_t i = 0; i < m_PositionalLights.size(); ++i)
+            {
+                auto& data = m_PositionalLights[i];
+
+                //Shadow map index.
+                m_PosLightData[i].shadowMapIndex.x = data.index;
+
+                //Store the light position as well to calculate the light distance from the fragment for depth storing.
+                m_PosLightData[i].lightPosition = glm::vec4(data.data, 1.0);
+
+                //PV matrices for each face.
+                CalculateCubeFaces(data.data, nearPlane, farPlane, m_PosLightData[i].matrices);
+            }
+        }
+
+        //Set again when directional shadows are drawn.
+        m_SkippedCascades = 0;
+        m_CascadeUpdateMask = 0;
+        m_DirCascades.clear();
+        if (!m_DirectionalLights.empty() && m_ShadowData.directional.shadowMaps != nullptr)
+        {
+            //Format: NumCascades(vec4), shadow map index of every light(vec4).
+            m_DirLightData.numCascades.x = m_ShadowData.directional.numCascades;
+            int lIndex = 0;
+            for (auto& dirLight : m_DirectionalLights)
+            {
+                m_DirLightData.shadowIndices[lIndex].x = dirLight.index;
+                ++lIndex;
+            }
+
+            //Iterate over all directional lights and set up their matrices.
+            const std::uint32_t numCascades = m_ShadowData.directional.numCascades;
+            std::vector<glm::mat4> matrices(numCascades);
+            std::vector<glm::vec4> clipDepths(numCascades);
+            m_DirCascades.reserve(numCascades * m_DirectionalLights.size());
+
+            //Mask with a bit for every cascade that exists.
+            const std::uint32_t allCascades = numCascades >= 32 ? ~0u : (1u << numCascades) - 1u;
+
+            //Cascades that are not scheduled keep the matrix that their depth was drawn with.
+            m_CascadeUpdateMask = allCascades;
+            if (m_CascadeScheduler != nullptr)
+            {
+                assert(m_CascadeScheduler->GetMatrices().size() == numCascades * m_DirectionalLights.size() && "Cascade scheduler was not updated with the lights of this frame!");
+                m_CascadeUpdateMask &= m_CascadeScheduler->GetUpdateMask();
+
+                for (std::size_t cascade = 0; cascade < m_CascadeScheduler->GetMatrices().size(); ++cascade)
+                {
+                    m_DirCascades.push_back(DirCascade{ m_CascadeScheduler->GetClipDepths()[cascade], m_CascadeScheduler->GetMatrices()[cascade] });
+                }
+            }
+            else
+            {
+                for (auto& lightData : m_DirectionalLights)
+                {
+                    CalculateCascades(camera, lightData.data, m_ShadowData, &matrices[0], &clipDepths[0]);
+
+                    for (std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+                    {
+                        m_DirCascades.push_back(DirCascade{ clipDepths[cascade], matrices[cascade] });
+                    }
+                }
+            }
+
+            m_SkippedCascades = allCascades & ~m_CascadeUpdateMask;
+        }
+    }
+
+    void RenderPass_ShadowMap::CollectLights(std::uint32_t a_DrawIndex, bool a_Directional, std::vector<std::int32_t>& a_Output) const
+    {
+        a_Output.clear();
+        const auto numLights = static_cast<std::int32_t>(a_Directional ? m_DirectionalLights.size() : m_PositionalLights.size());
+
+        //Without light index data, every light affects all geometry.
+        if (m_LightIndices == nullptr)
+        {
+            for (std::int32_t light = 0; light < numLights; ++light)
+            {
+                a_Output.push_back(light);
+            }
+            return;
+        }
+
+        const auto& lights = a_Directional ? m_LightIndices[a_DrawIndex].dirLights : m_LightIndices[a_DrawIndex].posLights;
+        for (std::int32_t light = 0; light < numLights; ++light)
+        {
+            if (lights.test(static_cast<std::size_t>(light)))
+            {
+                a_Output.push_back(light);
+            }
+        }
+    }
+
+    void RenderPass_ShadowMap::SetGeometryShaderLimits(int a_MaxVertices, int a_MaxComponents)
+    {
+        //3 vertices per triangle.
+        m_MaxComponents = a_MaxComponents;
+        m_MaxTriangles = a_MaxVertices / 3;
+
+        //These are static counts determined by how the shader works. This has to be updated if the shader changes.
+        constexpr int posComponentsPerLight = 6 * 3 * (4 + 4 + 1); //6 faces * 3 vertices * (fragPos + lPos + layer).
+        m_MaxPosLightsPerCall = std::max(std::min(m_MaxComponents / posComponentsPerLight, m_MaxTriangles), 1);
+    }
+
+    void RenderPass_ShadowMap::DrawShadows()
+    {
+        assert(m_MaxPosLightsPerCall > 0 && "The geometry shader limits have to be set before drawing!");
+
+        /*
+         * PointLights.
+         */
+
+        if (!m_PositionalLights.empty() && m_ShadowData.positional.shadowMaps != nullptr)
+        {
+            //Ensure enough space.
+            assert(m_ShadowData.positional.shadowMaps->GetDimensions().z >= m_PositionalLights.size() * 6 && "Shadow map array has not enough layers for this many lights!");
+
+            //Static casters are kept in separate layers when the cache asks for it.
+            const bool staticLayers = m_ShadowCache != nullptr && m_ShadowCache->GetSettings().staticLayers;
+            assert((!staticLayers || m_ShadowData.positional.staticShadowMaps != nullptr) && "Shadow cache uses static layers, but no static shadow maps were provided.");
+
+            /*
+             * Faces with outdated static layers get the static casters drawn into them first.
+             * Then every face that has dynamic casters drawn on top gets the static depth copied into the shadow map.
+             */
+            if (staticLayers)
+            {
+                bool drawStatic = false;
+                for (auto& light : m_PosLightData)
+                {
+                    light.shadowMapIndex.y = static_cast<std::int32_t>(m_ShadowCache->GetFaceMask(light.shadowMapIndex.x, ShadowFaceUpdate::REDRAW_STATIC));
+                    drawStatic = drawStatic || light.shadowMapIndex.y != 0;
+                }
+
+                if (drawStatic)
+                {
+                    DrawPositional(*m_ShadowData.positional.staticShadowMaps, true, false);
+                }
+
+                for (auto& light : m_PosLightData)
+                {
+                    const std::uint32_t copyMask = m_ShadowCache->GetFaceMask(light.shadowMapIndex.x, ShadowFaceUpdate::REDRAW_STATIC) | m_ShadowCache->GetFaceMask(light.shadowMapIndex.x, ShadowFaceUpdate::RESTORE);
+                    for (int face = 0; face < 6; ++face)
+                    {
+                        if ((copyMask & (1u << face)) != 0)
+                        {
+                            CopyDepthLayer(*m_ShadowData.positional.staticShadowMaps, *m_ShadowData.positional.shadowMaps, 6 * light.shadowMapIndex.x + face);
+                        }
+                    }
+                }
+            }
+
+            //Draw into every face that is not cached. Static casters are already in place when static layers are used.
+            bool drawLive = false;
+            for (auto& light : m_PosLightData)
+            {
+                light.shadowMapIndex.y = static_cast<std::int32_t>(m_ShadowCache != nullptr ? ~m_ShadowCache->GetFaceMask(light.shadowMapIndex.x, ShadowFaceUpdate::CACHED) & 0x3Fu : 0x3Fu);
+                drawLive = drawLive || light.shadowMapIndex.y != 0;
+            }
+
+            if (drawLive)
+            {
+                DrawPositional(*m_ShadowData.positional.shadowMaps, !staticLayers, true);
+            }
+        }
+
+        /*
+         * Directional lights.
+         */
+
+        if (!m_DirectionalLights.empty() && m_ShadowData.directional.shadowMaps != nullptr)
+        {
+            DrawDirectional();
+        }
+    }
+
+    void RenderPass_ShadowMap::DrawPositional(const Texture& a_Texture, bool a_DrawStatic, bool a_DrawDynamic)
+    {
+        auto& commands = m_Pipeline.GetCommandListBackend();
+
+        BindDepthTarget(a_Texture);
+        UploadLightData(&m_PosLightData[0], static_cast<std::uint32_t>(sizeof(PosLightData) * m_PosLightData.size()));
+
+        const float farPlane = m_Camera->GetSettings().farPlane;
+        m_PrevShaderMask = 0;
+        m_CurrentShader = nullptr;
+        m_PrevMesh = nullptr;
+
+        //Loop over geometry and draw.
+        for (std::uint32_t drawIndex = 0; drawIndex < m_DrawDataCount; ++drawIndex)
+        {
+            const std::uint32_t i = m_DrawOrder != nullptr ? m_DrawOrder[drawIndex] : drawIndex;
+
+            //Only draw the kind of casters asked for. Geometry without light index data is dynamic.
+            const bool isStatic = m_LightIndices != nullptr && m_LightIndices[i].staticCaster;
+            if ((isStatic && !a_DrawStatic) || (!isStatic && !a_DrawDynamic))
+            {
+                continue;
+            }
+
+            //Skip geometry that does not cast a shadow for any of the lights. Lights without any face to draw that can see the geometry are left out.
+            const std::uint32_t faceMask = (m_LightIndices != nullptr ? m_LightIndices[i].faceMask : ~0u) & 0x3Fu;
+            CollectLights(i, false, m_LightList);
+            m_LightList.erase(std::remove_if(m_LightList.begin(), m_LightList.end(), [&](std::int32_t a_Light) { return (static_cast<std::uint32_t>(m_PosLightData[a_Light].shadowMapIndex.y) & faceMask) == 0; }), m_LightList.end());
+            if (m_LightList.empty())
+            {
+                continue;
+            }
+
+            const DrawData& drawData = m_DrawDataPtr[i];
+            const Mesh& mesh = *drawData.mesh;
+
+            //The shader cache folds the bits that the shadow shaders do not use out of the mask.
+            const std::uint32_t shaderMask = static_cast<std::uint32_t>(mesh.GetVertexAttributeMask()) | (drawData.attributes.GetMask() << NUM_VERTEX_ATRRIBS) | POSITIONAL_BIT;
+            if (!BindShader(shaderMask, mesh))
+            {
+                continue;
+            }
+
+            //Bind the transforms to the instance data slot (0) when they are uploaded.
+            if (drawData.transformData.dataBuffer != nullptr && (drawData.attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX) || drawData.attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX)))
+            {
+                commands.BindStorageBuffer(0, *drawData.transformData.dataBuffer, drawData.transformData.dataRange.start, static_cast<std::uint32_t>(drawData.transformData.dataRange.totalSize));
+            }
+
+            //The instance count of the mesh itself, the far plane and the faces that the geometry is drawn into.
+            const std::int32_t instanceCount = static_cast<std::int32_t>(mesh.GetInstanceCount());
+            const std::int32_t faceUniform = static_cast<std::int32_t>(faceMask);
+            commands.SetUniform(0, UniformFormat::INT, &instanceCount);
+            commands.SetUniform(1, UniformFormat::FLOAT, &farPlane);
+            commands.SetUniform(3, UniformFormat::INT, &faceUniform);
+
+            DrawLightBatches(drawData, TopologyType::TRIANGLES, m_MaxPosLightsPerCall);
+        }
+    }
+
+    void RenderPass_ShadowMap::DrawDirectional()
+    {
+        auto& commands = m_Pipeline.GetCommandListBackend();
+
+        //Ensure there's enough space in the texture.
+        assert(m_ShadowData.directional.shadowMaps->GetDimensions().z >= m_DirectionalLights.size() * m_ShadowData.directional.numCascades && "Shadow map array has not enough layers for this many lights!");
+
+        //Max dir lights is determined by the cascades, which is a runtime value.
+        const int dirComponentsPerLight = 3 * static_cast<int>(m_ShadowData.directional.numCascades) * (4 + 1); //3 vertices * cascades * (pos + layer)
+        const int maxDirLightsPerCall = std::max(std::min(m_MaxComponents / dirComponentsPerLight, m_MaxTriangles), 1);
+
+        BindDepthTarget(*m_ShadowData.directional.shadowMaps);
+
+        //Upload the light data, which was calculated when the pass was prepared.
+        UploadLightData(&m_DirLightData, sizeof(DirLightData));
+
+        //Upload the matrices for each light and cascade. Store the result in the view that was provided, and bind it to the right shader slot and range.
+        const auto numCascades = static_cast<std::uint32_t>(m_DirCascades.size());
+        (*m_ShadowData.directional.dataRange) = m_ShadowData.directional.dataBuffer->WriteData<DirCascade>(m_ShadowData.directional.startOffset->end, numCascades, 16, &m_DirCascades[0]);
+        OnBufferWritten(*m_ShadowData.directional.dataBuffer, &m_DirCascades[0], static_cast<std::uint32_t>(numCascades * sizeof(DirCascade)));
+        commands.BindStorageBuffer(3, *m_ShadowData.directional.dataBuffer, m_ShadowData.directional.dataRange->start, static_cast<std::uint32_t>(m_ShadowData.directional.dataRange->totalSize));
+
+        m_PrevShaderMask = 0;
+        m_CurrentShader = nullptr;
+        m_PrevMesh = nullptr;
+
+        //Loop over geometry and draw. Nothing is drawn when every cascade is skipped.
+        for (std::uint32_t drawIndex = 0; drawIndex < m_DrawDataCount && m_CascadeUpdateMask != 0; ++drawIndex)
+        {
+            const std::uint32_t i = m_DrawOrder != nullptr ? m_DrawOrder[drawIndex] : drawIndex;
+
+            //Skip geometry that is not inside any cascade of any light that is drawn this frame.
+            const std::uint32_t cascadeMask = (m_LightIndices != nullptr ? m_LightIndices[i].cascadeMask : ~0u) & m_CascadeUpdateMask;
+            CollectLights(i, true, m_LightList);
+            if (m_LightList.empty() || cascadeMask == 0)
+            {
+                continue;
+            }
+
+            const DrawData& drawData = m_DrawDataPtr[i];
+            const Mesh& mesh = *drawData.mesh;
+
+            //The shader cache folds the bits that the shadow shaders do not use out of the mask.
+            const std::uint32_t shaderMask = static_cast<std::uint32_t>(mesh.GetVertexAttributeMask()) | (drawData.attributes.GetMask() << NUM_VERTEX_ATRRIBS) | DIRECTIONAL_BIT;
+            if (!BindShader(shaderMask, mesh))
+            {
+                continue;
+            }
+
+            //Bind the transforms to the instance data slot (0) when they are uploaded.
+            if (drawData.attributes.IsAttributeEnabled(DrawAttribute::TRANSFORMATION_MATRIX) || drawData.attributes.IsAttributeEnabled(DrawAttribute::NORMAL_MATRIX))
+            {
+                assert(drawData.transformData.dataBuffer != nullptr);
+                commands.BindStorageBuffer(0, *drawData.transformData.dataBuffer, drawData.transformData.dataRange.start, static_cast<std::uint32_t>(drawData.transformData.dataRange.totalSize));
+            }
+
+            //The amount of instances and the cascades that the geometry shader outputs to.
+            const std::int32_t instanceCount = static_cast<std::int32_t>(drawData.instanceCount);
+            const std::int32_t cascadeUniform = static_cast<std::int32_t>(cascadeMask);
+            commands.SetUniform(0, UniformFormat::INT, &instanceCount);
+            commands.SetUniform(2, UniformFormat::INT, &cascadeUniform);
+
+            //Only triangles can cast a shadow because they have a volume.
+            const auto topology = drawData.pipelineState->GetTopology();
+            assert((topology == TopologyType::TRIANGLES || topology == TopologyType::TRIANGLE_STRIP) && "Cannot draw shadows for non-triangle topology");
+            if (topology == TopologyType::TRIANGLES || topology == TopologyType::TRIANGLE_STRIP)
+            {
+                DrawLightBatches(drawData, topology, maxDirLightsPerCall);
+            }
+        }
+    }
+
+    bool RenderPass_ShadowMap::BindShader(std::uint32_t a_ShaderMask, const Mesh& a_Mesh)
+    {
+        if (a_ShaderMask != m_PrevShaderMask)
+        {
+            m_PrevShaderMask = a_ShaderMask;
+
+            //Get the new shader. If not present, load a new one or skip the geometry while it compiles.
+            //Masks that only differ in folded bits give the shader that is already bound.
+            auto shader = GetShader(a_ShaderMask, a_Mesh);
+            if (shader != nullptr && shader.get() != m_CurrentShader)
+            {
+                m_Pipeline.GetCommandListBackend().BindShader(*shader);
+            }
+            m_CurrentShader = shader.get();
+        }
+
+        return m_CurrentShader != nullptr;
+    }
+
+    void RenderPass_ShadowMap::DrawLightBatches(const DrawData& a_DrawData, TopologyType a_Topology, int a_LightsPerCall)
+    {
+        auto& commands = m_Pipeline.GetCommandListBackend();
+
+        const int numLights = static_cast<int>(m_LightList.size());
+        for (int start = 0; start < numLights; start += a_LightsPerCall)
+        {
+            //The amount of lights in this batch padded to a vec4, followed by the indices padded to a multiple of 4. This matches the std140 block in the shader.
+            const int count = std::min(numLights - start, a_LightsPerCall);
+            m_LightIndexBatch.clear();
+            m_LightIndexBatch.push_back(count);
+            m_LightIndexBatch.push_back(0);
+            m_LightIndexBatch.push_back(0);
+            m_LightIndexBatch.push_back(0);
+            m_LightIndexBatch.insert(m_LightIndexBatch.end(), m_LightList.begin() + start, m_LightList.begin() + start + count);
+            while ((m_LightIndexBatch.size() & 3) != 0)
+            {
+                m_LightIndexBatch.push_back(0);
+            }
+            UploadLightIndices(&m_LightIndexBatch[0], static_cast<std::uint32_t>(m_LightIndexBatch.size()));
+
+            //If the geometry changed, bind the new geometry.
+            if (m_PrevMesh != a_DrawData.mesh.get())
+            {
+                commands.BindMesh(*a_DrawData.mesh);
+                m_PrevMesh = a_DrawData.mesh.get();
+            }
+
+            commands.Draw(*a_DrawData.mesh, a_Topology, a_DrawData.instanceCount);
+        }
+    }
 }
@@ -0,0 +1,118 @@
+#include "null/RenderPass_ShadowMap_Null.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "BlurpEngine.h"
+#include "CommandRecording.h"
+#include "FileReader.h"
+#include "GpuBuffer.h"
+#include "RenderPipeline_Null.h"
+#include "Texture.h"
+#include "null/Mesh_Null.h"
+
+namespace blurp
+{
+    bool RenderPass_ShadowMap_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //The OpenGL shaders are used, so that variants are preprocessed and shared exactly like with a graphics API.
+        auto shaderPath = a_BlurpEngine.GetEngineSettings().shadersPath + "opengl/";
+        auto vertex = "Default_ShadowMap.vs";
+        auto geometry = "Default_ShadowMap.gs";
+        auto fragment = "Default_ShadowMap.fs";
+
+        FileReader vertexReader(shaderPath + vertex);
+        FileReader geometryReader(shaderPath + geometry);
+        FileReader fragmentReader(shaderPath + fragment);
+
+        if (!vertexReader.Open() || !fragmentReader.Open() || !geometryReader.Open())
+        {
+            throw std::runtime_error("Could not find shadow map shaders at path specified.");
+        }
+
+        auto vertexSrc = vertexReader.ToArray();
+        auto geometrySrc = geometryReader.ToArray();
+        auto fragmentSrc = fragmentReader.ToArray();
+
+        ShaderSettings sSettings;
+        sSettings.vertexShaderSource = vertexSrc.get();
+        sSettings.geometryShaderSource = geometrySrc.get();
+        sSettings.fragmentShaderSource = fragmentSrc.get();
+        sSettings.type = ShaderType::GRAPHICS;
+
+        m_ShaderCache.Init(a_BlurpEngine, sSettings, CreateShaderMaskTable());
+        m_ShaderCache.SetPreprocessing(true, shaderPath);
+
+        //Sized like the UBOs of the OpenGL pass. PosLightData is used because it is far bigger than dir light data.
+        m_LightUbo.resize(MAX_SHADOW_LIGHTS * sizeof(PosLightData));
+        m_LightIndicesUbo.reserve((MAX_SHADOW_LIGHTS + 1) * 4);
+
+        //The minimum values of GL_MAX_GEOMETRY_OUTPUT_VERTICES and GL_MAX_GEOMETRY_TOTAL_OUTPUT_COMPONENTS.
+        SetGeometryShaderLimits(256, 1024);
+
+        return true;
+    }
+
+    bool RenderPass_ShadowMap_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    void RenderPass_ShadowMap_Null::Submit()
+    {
+        //Compile the variants from the manifest before they are needed.
+        if (m_ShaderManifestChanged)
+        {
+            m_ShaderCache.SetManifest(m_ShaderManifest, "ShadowMap");
+            m_ShaderManifestChanged = false;
+        }
+        m_ShaderCache.WarmUp(m_WarmUpBudget);
+        m_ShaderCache.SetFallbackPolicy(m_ShaderFallbackPolicy, ~0u);
+        m_ShaderCache.UpdateCompiles(m_CompileBudget);
+
+        DrawShadows();
+    }
+
+    std::shared_ptr<Shader> RenderPass_ShadowMap_Null::GetShader(std::uint32_t a_Mask, const Mesh& a_Mesh)
+    {
+        return m_ShaderCache.GetOrRequest(a_Mask, static_cast<const Mesh_Null&>(a_Mesh).GetAttribLocations());
+    }
+
+    void RenderPass_ShadowMap_Null::BindDepthTarget(const Texture& a_Texture)
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+        recording.Record(RecordedCommandType::ATTACH_DEPTH, &a_Texture);
+
+        const auto dimensions = a_Texture.GetDimensions();
+        recording.RecordViewport(0, 0, dimensions.x, dimensions.y);
+    }
+
+    void RenderPass_ShadowMap_Null::UploadLightData(const void* a_Data, std::uint32_t a_Size)
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+        std::memcpy(&m_LightUbo[0], a_Data, a_Size);
+        recording.Record(RecordedCommandType::BIND_UNIFORM_BUFFER, &m_LightUbo, 1, a_Size);
+        recording.RecordUpload(&m_LightUbo, a_Data, a_Size);
+    }
+
+    void RenderPass_ShadowMap_Null::UploadLightIndices(const std::int32_t* a_Data, std::uint32_t a_Count)
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+        m_LightIndicesUbo.assign(a_Data, a_Data + a_Count);
+
+        const auto size = static_cast<std::uint32_t>(sizeof(std::int32_t) * a_Count);
+        recording.Record(RecordedCommandType::BIND_UNIFORM_BUFFER, &m_LightIndicesUbo, 2, size);
+        recording.RecordUpload(&m_LightIndicesUbo, &m_LightIndicesUbo[0], size);
+    }
+
+    void RenderPass_ShadowMap_Null::CopyDepthLayer(const Texture& a_Source, const Texture& a_Destination, std::uint32_t a_Layer)
+    {
+        const auto dimensions = a_Destination.GetDimensions();
+        static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording().Record(RecordedCommandType::COPY_TEXTURE, &a_Destination, a_Layer, dimensions.x * dimensions.y);
+    }
+
+    void RenderPass_ShadowMap_Null::OnBufferWritten(const GpuBuffer& a_Buffer, const void* a_Data, std::uint32_t a_Size)
+    {
+        static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording().RecordUpload(&a_Buffer, a_Data, a_Size);
+    }
+}
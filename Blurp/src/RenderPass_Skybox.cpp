@@ -50,4 +50,16 @@ namespace blurp
     {
         return m_Camera != nullptr && m_Target != nullptr && m_Texture != nullptr && m_Texture->GetTextureType() == TextureType::TEXTURE_CUBEMAP;
     }
+
+    void RenderPass_Skybox::PrePrepare()
+    {
+        //The camera can be shared with other passes that are prepared at the same time.
+        m_Camera->UpdateMatrices();
+    }
+
+    void RenderPass_Skybox::Prepare()
+    {
+        const Camera& camera = *m_Camera;
+        m_ViewProjection = camera.GetProjectionMatrix() * glm::mat4(glm::mat3(camera.GetViewMatrix()));
+    }
 }
@@ -1,5 +1,6 @@
 #include "opengl/RenderPass_Skybox_GL.h"
 
+#include <stdexcept>
 #include <glm/gtc/type_ptr.hpp>
 
 
@@ -7,6 +8,7 @@
 #include "BlurpEngine.h"
 #include "opengl/Mesh_GL.h"
 #include "opengl/RenderTarget_GL.h"
+#include "opengl/RenderPipeline_GL.h"
 #include "RenderResourceManager.h"
 #include "opengl/Texture_GL.h"
 
@@ -23,7 +25,7 @@ namespace blurp
 
         if (!vertexReader.Open() || !fragmentReader.Open())
         {
-            throw std::exception("Could not find forward shaders at path specified.");
+            throw std::runtime_error("Could not find forward shaders at path specified.");
         }
 
         auto vertexSrc = vertexReader.ToArray();
@@ -57,26 +59,25 @@ namespace blurp
         return true;
     }
 
-    void RenderPass_Skybox_GL::Execute()
+    void RenderPass_Skybox_GL::Submit()
     {
         //Clear the target buffer.
         const auto fbGl = reinterpret_cast<RenderTarget_GL*>(m_Target.get());
 
+        auto& state = static_cast<RenderPipeline_GL&>(m_Pipeline).GetStateTracker();
+
         //Bind the FBO and set the viewport / scissorrect.
-        fbGl->Bind();
+        fbGl->Bind(state);
 
         //Don't do depth writing.
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        glDepthMask(GL_FALSE);
-        glDisable(GL_CULL_FACE);
-
-        //Calculate the pv matrix.
-        auto pv = m_Camera->GetProjectionMatrix() * glm::mat4(glm::mat3(m_Camera->GetViewMatrix()));
+        state.SetEnabled(GL_DEPTH_TEST, true);
+        state.SetDepthFunc(GL_LEQUAL);
+        state.SetDepthMask(false);
+        state.SetEnabled(GL_CULL_FACE, false);
 
         //Bind the shader and upload the pv matrix.
-        glUseProgram(m_Shader->GetProgramId());
-        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(pv));
+        state.UseProgram(m_Shader->GetProgramId());
+        glUniformMatrix4fv(0, 1, GL_FALSE, glm::value_ptr(m_ViewProjection));
 
         glUniform3f(1, m_MixColor.x, m_MixColor.y, m_MixColor.z);
         glUniform3f(2, m_ColorMultiplier.x, m_ColorMultiplier.y, m_ColorMultiplier.z);
@@ -84,19 +85,13 @@ namespace blurp
 
         //Bind the texture
         auto texture = static_cast<Texture_GL*>(m_Texture.get());
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, texture->GetTextureId());
+        state.BindTexture(0, GL_TEXTURE_CUBE_MAP, texture->GetTextureId());
 
         //Bind the cube mesh.
         Mesh_GL* mesh = static_cast<Mesh_GL*>(m_CubeMesh.get());
-        glBindVertexArray(mesh->GetVaoId());
+        state.BindVertexArray(mesh->GetVaoId());
 
         //Draw
         glDrawElements(GL_TRIANGLES, mesh->GetNumIndices(), mesh->GetIndexDataType(), nullptr);
-
-        //Reset state.
-        glDepthMask(true);
-        glBindVertexArray(0);
-
     }
 }
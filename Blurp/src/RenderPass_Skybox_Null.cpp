@@ -0,0 +1,79 @@
+#include "null/RenderPass_Skybox_Null.h"
+
+#include "BlurpEngine.h"
+#include "CommandRecording.h"
+#include "FileReader.h"
+#include "RenderPipeline_Null.h"
+#include "RenderResourceManager.h"
+#include "null/Mesh_Null.h"
+#include "null/RenderTarget_Null.h"
+
+#include <stdexcept>
+
+namespace blurp
+{
+    bool RenderPass_Skybox_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //The OpenGL shaders are read, so that loading costs the same as with a graphics API.
+        auto shaderPath = a_BlurpEngine.GetEngineSettings().shadersPath + "opengl/";
+        auto vertex = "Default_Skybox.vs";
+        auto fragment = "Default_Skybox.fs";
+
+        FileReader vertexReader(shaderPath + vertex);
+        FileReader fragmentReader(shaderPath + fragment);
+
+        if (!vertexReader.Open() || !fragmentReader.Open())
+        {
+            throw std::runtime_error("Could not find skybox shaders at path specified.");
+        }
+
+        auto vertexSrc = vertexReader.ToArray();
+        auto fragmentSrc = fragmentReader.ToArray();
+
+        ShaderSettings sSettings;
+        sSettings.vertexShaderSource = vertexSrc.get();
+        sSettings.fragmentShaderSource = fragmentSrc.get();
+        sSettings.type = ShaderType::GRAPHICS;
+
+        m_Shader = a_BlurpEngine.GetResourceManager().CreateShader(sSettings);
+
+        //Load the cube mesh.
+        MeshSettings meshSettings;
+        meshSettings.indexDataType = DataType::USHORT;
+        meshSettings.indexData = CUBE_INDICES;
+        meshSettings.numIndices = sizeof(CUBE_INDICES) / sizeof(CUBE_INDICES[0]);
+        meshSettings.vertexData = CUBE_DATA;
+        meshSettings.access = AccessMode::READ_ONLY;
+        meshSettings.usage = MemoryUsage::GPU;
+        meshSettings.vertexDataSizeBytes = sizeof(CUBE_DATA);
+        meshSettings.vertexSettings.EnableAttribute(VertexAttribute::POSITION_3D, 0, 0, 0);
+
+        m_CubeMesh = a_BlurpEngine.GetResourceManager().CreateMesh(meshSettings);
+
+        return true;
+    }
+
+    bool RenderPass_Skybox_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    void RenderPass_Skybox_Null::Submit()
+    {
+        auto& recording = static_cast<RenderPipeline_Null&>(m_Pipeline).GetRecording();
+
+        static_cast<RenderTarget_Null*>(m_Target.get())->Bind(recording);
+
+        recording.Record(RecordedCommandType::BIND_SHADER, m_Shader.get());
+        recording.RecordUniform(0, &m_ViewProjection, sizeof(m_ViewProjection));
+        recording.RecordUniform(1, &m_MixColor, sizeof(m_MixColor));
+        recording.RecordUniform(2, &m_ColorMultiplier, sizeof(m_ColorMultiplier));
+        recording.RecordUniform(3, &m_Opacity, sizeof(m_Opacity));
+
+        recording.Record(RecordedCommandType::BIND_TEXTURE, m_Texture.get(), 0);
+
+        auto mesh = static_cast<Mesh_Null*>(m_CubeMesh.get());
+        recording.Record(RecordedCommandType::BIND_MESH, mesh);
+        recording.Record(RecordedCommandType::DRAW_INDEXED, mesh, 0, mesh->GetNumIndices(), 1);
+    }
+}
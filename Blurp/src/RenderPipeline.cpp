@@ -2,7 +2,8 @@
 
 #include "RenderPipeline.h"
 
-#include <iostream>
+#include <algorithm>
+#include <chrono>
 
 #include "RenderPass.h"
 #include "BlurpEngine.h"
@@ -10,76 +11,264 @@
 #include <unordered_set>
 #include "Settings.h"
 #include "Lockable.h"
+#include "ShaderRegistry.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 
 namespace blurp
 {
+#ifdef BLURP_PROFILING
+    namespace
+    {
+        //The profiler marker names of a pass type.
+        struct PassMarkers
+        {
+            const char* gpu;
+            const char* prepare;
+            const char* submit;
+        };
+
+        PassMarkers GetPassMarkers(RenderPassType a_Type)
+        {
+            switch(a_Type)
+            {
+            case RenderPassType::RP_HELLOTRIANGLE:
+                return { "HelloTriangle", "Prepare HelloTriangle", "Submit HelloTriangle" };
+            case RenderPassType::RP_CLEAR:
+                return { "Clear", "Prepare Clear", "Submit Clear" };
+            case RenderPassType::RP_FORWARD:
+                return { "Forward", "Prepare Forward", "Submit Forward" };
+            case RenderPassType::RP_DEFERRED:
+                return { "Deferred", "Prepare Deferred", "Submit Deferred" };
+            case RenderPassType::RP_SHADOWMAP:
+                return { "ShadowMap", "Prepare ShadowMap", "Submit ShadowMap" };
+            case RenderPassType::RP_CUBEMAP:
+                return { "CubeMap", "Prepare CubeMap", "Submit CubeMap" };
+            case RenderPassType::RP_SKYBOX:
+                return { "Skybox", "Prepare Skybox", "Submit Skybox" };
+            case RenderPassType::RP_DOF:
+                return { "DOF", "Prepare DOF", "Submit DOF" };
+            case RenderPassType::RP_2D:
+                return { "2D", "Prepare 2D", "Submit 2D" };
+            case RenderPassType::RP_BLOOM:
+                return { "Bloom", "Prepare Bloom", "Submit Bloom" };
+            case RenderPassType::RP_BLUR:
+                return { "Blur", "Prepare Blur", "Submit Blur" };
+            case RenderPassType::RP_ANIMATION:
+                return { "Animation", "Prepare Animation", "Submit Animation" };
+            }
+            return { "Pass", "Prepare Pass", "Submit Pass" };
+        }
+    }
+#endif
+
     std::shared_ptr<RenderPass> RenderPipeline::AppendRenderPass(RenderPassType a_Type)
     {
         //Create and emplace in the vector.
         std::shared_ptr<RenderPass> ptr = m_Engine.GetResourceManager().CreateRenderPass(a_Type, *this);
+        ptr->m_PrepareIndex = static_cast<std::uint32_t>(m_RenderPasses.size());
         m_RenderPasses.emplace_back(ptr);
         return ptr;
     }
 
     void RenderPipeline::Execute()
     {
-#ifndef NDEBUG
-        auto pipelineStart = std::chrono::high_resolution_clock::now();
+#ifdef BLURP_PROFILING
+        //GPU ranges are only measured while the profiler records, because their queries are not free.
+        auto& profiler = m_Engine.GetProfiler();
+        GpuTimer* gpuTimer = profiler.IsEnabled() ? GetGpuTimer() : nullptr;
 #endif
+        BLURP_PROFILE_SCOPE(profiler, "RenderPipeline::Execute");
+
+        //Work that needs the graphics API is done before anything is submitted.
+        auto& jobs = m_Engine.GetJobSystem();
+        if(jobs.IsMainThread())
+        {
+            jobs.RunMainThreadJobs();
+        }
+
+        //Shaders used by this pipeline are kept loaded until it has finished.
+        m_Engine.GetShaderRegistry()->NextFrame();
 
         //Before executing, let the child class set up some stuff.
         PreExecute();
 
-#ifndef NDEBUG
-        int passCounter = 0;
+#ifdef BLURP_PROFILING
+        //Results of earlier executions that the GPU finished are added to the frames they belong to.
+        if(gpuTimer != nullptr)
+        {
+            gpuTimer->BeginFrame(profiler);
+        }
 #endif
 
-        //Tell each pass to execute.
-        for(auto& pass : m_RenderPasses)
+        //Prepare every pass, possibly on multiple threads.
+        PreparePasses();
+
+        //Submit each pass in order.
+        const auto submitStart = std::chrono::high_resolution_clock::now();
+        for(std::size_t i = 0; i < m_RenderPasses.size(); ++i)
         {
+            auto& pass = m_RenderPasses[i];
             if(pass->IsEnabled())
             {
-                assert(pass->IsStateValid() && "Cannot execute render pass with invalid state!");
-
-                //Time tracking.
-#ifndef NDEBUG
-                /*auto start = std::chrono::high_resolution_clock::now();*/
-#endif
-
-                pass->Execute();
-
-#ifndef NDEBUG
-                //auto end = std::chrono::high_resolution_clock::now();
-                //auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-                //std::cout << "Render pass #" << passCounter << " execution time: " << duration.count() <<  " microseconds." << std::endl;
-                //++passCounter;
-#endif
+                BLURP_PROFILE_SCOPE(profiler, GetPassMarkers(pass->GetType()).submit);
+                BLURP_PROFILE_GPU_SCOPE(gpuTimer, GetPassMarkers(pass->GetType()).gpu);
+                const auto start = std::chrono::high_resolution_clock::now();
+                pass->Submit();
+                m_Timings.passes[i].submit = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count();
             }
         }
 
         //Before finishing, let the child class clean up and possibly send GPU work.
         PostExecute();
 
-#ifndef NDEBUG
-        auto halfway = std::chrono::high_resolution_clock::now();
-#endif
+        const auto halfway = std::chrono::high_resolution_clock::now();
+        m_Timings.submit = std::chrono::duration<double, std::micro>(halfway - submitStart).count();
 
         //Finally, if configured stall the CPU and then free resources once the GPU is done.
         if(m_Settings.waitForGpu)
         {
+            BLURP_PROFILE_SCOPE(profiler, "Wait for GPU");
             while(!HasFinishedExecuting())
             {
                 //Nothing here just wait.   
             }
         }
 
-#ifndef NDEBUG
-        auto pipelineEnd = std::chrono::high_resolution_clock::now();
-        auto half = std::chrono::duration_cast<std::chrono::microseconds>(halfway - pipelineStart);
-        auto wait = std::chrono::duration_cast<std::chrono::microseconds>(pipelineEnd - halfway);
-        auto full = half.count() + wait.count();
-        std::cout << "Finished executing pipeline.\n Total time to execute all passes: " << half.count() << " micros.\nGPU wait time: " << wait.count() << " micros.\nTotal time: " << full << " micros." << std::endl;;;
-#endif
+        const auto end = std::chrono::high_resolution_clock::now();
+        m_Timings.gpuWait = std::chrono::duration<double, std::micro>(end - halfway).count();
+    }
+
+    const PipelineTimings& RenderPipeline::GetTimings() const
+    {
+        return m_Timings;
+    }
+
+    JobSystem& RenderPipeline::GetJobSystem() const
+    {
+        return m_Engine.GetJobSystem();
+    }
+
+    GpuTimer* RenderPipeline::GetGpuTimer()
+    {
+        return nullptr;
+    }
+
+    void RenderPipeline::PreparePasses()
+    {
+        BLURP_PROFILE_SCOPE(m_Engine.GetProfiler(), "Prepare passes");
+        const auto prepareStart = std::chrono::high_resolution_clock::now();
+
+        m_Timings.passes.resize(m_RenderPasses.size());
+        std::uint32_t enabledCount = 0;
+        for(std::size_t i = 0; i < m_RenderPasses.size(); ++i)
+        {
+            auto& pass = m_RenderPasses[i];
+            m_Timings.passes[i] = PassTimings{ pass->GetType(), pass->IsEnabled(), 0.0, 0.0, 0.0 };
+
+            if(pass->IsEnabled())
+            {
+                assert(pass->IsStateValid() && "Cannot execute render pass with invalid state!");
+
+                //Shared data is updated before any pass reads it on another thread.
+                pass->PrePrepare();
+                ++enabledCount;
+            }
+        }
+
+        //Every pass writes only its own timings, so no synchronization is needed for them.
+        const auto preparePass = [this, prepareStart](std::size_t a_Index)
+        {
+            BLURP_PROFILE_SCOPE(m_Engine.GetProfiler(), GetPassMarkers(m_RenderPasses[a_Index]->GetType()).prepare);
+            const auto start = std::chrono::high_resolution_clock::now();
+            m_RenderPasses[a_Index]->Prepare();
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            m_Timings.passes[a_Index].prepareStart = std::chrono::duration<double, std::micro>(start - prepareStart).count();
+            m_Timings.passes[a_Index].prepare = std::chrono::duration<double, std::micro>(end - start).count();
+        };
+
+        if(!m_Settings.parallelPrepare || enabledCount <= 1)
+        {
+            for(std::size_t i = 0; i < m_RenderPasses.size(); ++i)
+            {
+                if(m_RenderPasses[i]->IsEnabled())
+                {
+                    preparePass(i);
+                }
+            }
+        }
+        else
+        {
+            /*
+             * Every pass is prepared in its own job, which starts when the jobs of the passes it depends on are done.
+             * This thread runs jobs as well while it waits for them.
+             */
+            auto& jobs = m_Engine.GetJobSystem();
+            std::vector<JobCounter> counters(m_RenderPasses.size());
+            for(std::size_t i = 0; i < m_RenderPasses.size(); ++i)
+            {
+                if(!m_RenderPasses[i]->IsEnabled())
+                {
+                    continue;
+                }
+
+                std::vector<JobCounter*> dependencies;
+                for(auto* dependency : m_RenderPasses[i]->GetDependencies())
+                {
+                    if(dependency->IsEnabled())
+                    {
+                        dependencies.push_back(&counters[dependency->m_PrepareIndex]);
+                    }
+                }
+
+                jobs.Run([&preparePass, i]() { preparePass(i); }, &counters[i], dependencies);
+            }
+
+            //Wait for every job before passing on the first exception, because the jobs refer to the counters.
+            std::exception_ptr exception;
+            for(auto& counter : counters)
+            {
+                try
+                {
+                    jobs.Wait(counter);
+                }
+                catch(...)
+                {
+                    if(!exception)
+                    {
+                        exception = std::current_exception();
+                    }
+                }
+            }
+            if(exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+
+        m_Timings.prepare = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - prepareStart).count();
+
+        //The critical path ends at the pass that finishes last when every pass starts as soon as its dependencies are done.
+        std::vector<double> finish(m_RenderPasses.size(), 0.0);
+        m_Timings.prepareWork = 0.0;
+        m_Timings.criticalPath = 0.0;
+        for(std::size_t i = 0; i < m_RenderPasses.size(); ++i)
+        {
+            if(!m_RenderPasses[i]->IsEnabled())
+            {
+                continue;
+            }
+
+            double start = 0.0;
+            for(auto* dependency : m_RenderPasses[i]->GetDependencies())
+            {
+                start = std::max(start, finish[dependency->m_PrepareIndex]);
+            }
+            finish[i] = start + m_Timings.passes[i].prepare;
+            m_Timings.prepareWork += m_Timings.passes[i].prepare;
+            m_Timings.criticalPath = std::max(m_Timings.criticalPath, finish[i]);
+        }
     }
 
     void RenderPipeline::Reset()
@@ -9,6 +9,7 @@ namespace blurp
 
     bool RenderPipeline_GL::OnDestroy(BlurpEngine& a_BlurpEngine)
     {
+        m_GpuTimer.Destroy();
         return true;
     }
 
@@ -17,11 +18,30 @@ namespace blurp
         return true;
     }
 
+    StateTracker& RenderPipeline_GL::GetStateTracker()
+    {
+        return m_StateTracker;
+    }
+
+    CommandListBackend& RenderPipeline_GL::GetCommandListBackend()
+    {
+        return m_CommandListBackend;
+    }
+
     void RenderPipeline_GL::PreExecute()
     {
+        m_StateTracker.NextFrame();
+        m_StateTracker.Invalidate();
     }
 
     void RenderPipeline_GL::PostExecute()
     {
+        //Resources bind their own vertex array when they are created, but nothing outside of the pipeline should modify the last one used.
+        m_StateTracker.BindVertexArray(0);
+    }
+
+    GpuTimer* RenderPipeline_GL::GetGpuTimer()
+    {
+        return &m_GpuTimer;
     }
 }
@@ -0,0 +1,39 @@
+#include "RenderPipeline_Null.h"
+
+namespace blurp
+{
+    CommandRecording& RenderPipeline_Null::GetRecording()
+    {
+        return m_Recording;
+    }
+
+    bool RenderPipeline_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    bool RenderPipeline_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    bool RenderPipeline_Null::HasFinishedExecuting()
+    {
+        //Nothing is sent to a GPU, so everything is done when the passes return.
+        return true;
+    }
+
+    CommandListBackend& RenderPipeline_Null::GetCommandListBackend()
+    {
+        return m_CommandListBackend;
+    }
+
+    void RenderPipeline_Null::PreExecute()
+    {
+        m_Recording.Clear();
+    }
+
+    void RenderPipeline_Null::PostExecute()
+    {
+    }
+}
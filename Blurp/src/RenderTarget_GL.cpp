@@ -7,6 +7,7 @@
 #include "BlurpEngine.h"
 #include "opengl/Texture_GL.h"
 #include "opengl/GLUtils.h"
+#include "StateTracker.h"
 
 
 namespace blurp
@@ -21,13 +22,13 @@ namespace blurp
         return m_IsDefault;
     }
 
-    void RenderTarget_GL::Bind()
+    void RenderTarget_GL::Bind(StateTracker& a_State)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, m_Fbo);
+        a_State.BindFramebuffer(m_Fbo);
 
-        glClearColor(m_ClearColor.r, m_ClearColor.g, m_ClearColor.b, m_ClearColor.a);
-        glViewport(static_cast<int>(m_ViewPort.x), static_cast<int>(m_ViewPort.y), static_cast<int>(m_ViewPort.z), static_cast<int>(m_ViewPort.w));
-        glScissor(static_cast<int>(m_ScissorRect.x), static_cast<int>(m_ScissorRect.y), static_cast<int>(m_ScissorRect.z), static_cast<int>(m_ScissorRect.w));
+        a_State.SetClearColor(m_ClearColor.r, m_ClearColor.g, m_ClearColor.b, m_ClearColor.a);
+        a_State.SetViewport(static_cast<int>(m_ViewPort.x), static_cast<int>(m_ViewPort.y), static_cast<int>(m_ViewPort.z), static_cast<int>(m_ViewPort.w));
+        a_State.SetScissor(static_cast<int>(m_ScissorRect.x), static_cast<int>(m_ScissorRect.y), static_cast<int>(m_ScissorRect.z), static_cast<int>(m_ScissorRect.w));
     }
 
     bool RenderTarget_GL::OnLoad(BlurpEngine& a_BlurpEngine)
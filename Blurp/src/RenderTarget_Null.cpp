@@ -0,0 +1,103 @@
+#include "null/RenderTarget_Null.h"
+
+#include <cassert>
+
+#include "CommandRecording.h"
+#include "Texture.h"
+
+namespace blurp
+{
+    void RenderTarget_Null::Bind(CommandRecording& a_Recording)
+    {
+        a_Recording.Record(RecordedCommandType::BIND_TARGET, this);
+        a_Recording.RecordViewport(static_cast<std::uint32_t>(m_ViewPort.x), static_cast<std::uint32_t>(m_ViewPort.y), static_cast<std::uint32_t>(m_ViewPort.z), static_cast<std::uint32_t>(m_ViewPort.w));
+    }
+
+    bool RenderTarget_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        assert(m_Settings.scissorRect.z > 0 && m_Settings.scissorRect.w > 0 && "Scissorrect needs positive dimensions!");
+        assert(m_Settings.viewPort.z > 0 && m_Settings.viewPort.w > 0 && "Viewport needs positive dimensions!");
+
+        m_ClearColor = m_Settings.clearColor;
+        m_ScissorRect = m_Settings.scissorRect;
+        m_ViewPort = m_Settings.viewPort;
+
+        if (!m_IsSwapChainTarget)
+        {
+            //Attach defaults.
+            if (m_Settings.defaultColorAttachment != nullptr)
+            {
+                SetColorAttachment(0, m_Settings.defaultColorAttachment);
+            }
+
+            if (m_Settings.defaultDepthStencilAttachment != nullptr)
+            {
+                SetDepthStencilAttachment(m_Settings.defaultDepthStencilAttachment);
+            }
+        }
+
+        //Only set after adding the defaults, because read only targets still need them.
+        m_AllowAttachments = m_Settings.allowAttachments;
+        return true;
+    }
+
+    bool RenderTarget_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+
+    glm::vec4 RenderTarget_Null::GetClearColor()
+    {
+        return m_ClearColor;
+    }
+
+    void RenderTarget_Null::SetClearColor(const glm::vec4& a_ClearColor)
+    {
+        m_ClearColor = a_ClearColor;
+    }
+
+    glm::vec4 RenderTarget_Null::GetViewPort()
+    {
+        return m_ViewPort;
+    }
+
+    void RenderTarget_Null::SetViewPort(const glm::vec<4, std::uint32_t>& a_ViewPort)
+    {
+        m_ViewPort = a_ViewPort;
+    }
+
+    glm::vec4 RenderTarget_Null::GetScissorRect()
+    {
+        return m_ScissorRect;
+    }
+
+    void RenderTarget_Null::SetScissorRect(const glm::vec<4, std::uint32_t>& a_ScissorRect)
+    {
+        m_ScissorRect = a_ScissorRect;
+    }
+
+    void RenderTarget_Null::OnColorAttachmentBound(std::uint16_t a_Slot, const std::shared_ptr<Texture>& a_Added)
+    {
+        //Attachments are only stored in the base class.
+    }
+
+    void RenderTarget_Null::OnDepthStencilAttachmentBound(const std::shared_ptr<Texture>& a_Added)
+    {
+        //Attachments are only stored in the base class.
+    }
+
+    bool RenderTarget_Null::HasColorAttachment() const
+    {
+        return m_HasDefaultColor || m_NumColorAttachments != 0;
+    }
+
+    bool RenderTarget_Null::HasDepthAttachment() const
+    {
+        return m_HasDefaultDepth || m_DepthStencilAttachment != nullptr;
+    }
+
+    bool RenderTarget_Null::HasStencilAttachment() const
+    {
+        return m_HasDefaultStencil || (m_DepthStencilAttachment != nullptr && m_DepthStencilAttachment->GetPixelFormat() == PixelFormat::DEPTH_STENCIL);
+    }
+}
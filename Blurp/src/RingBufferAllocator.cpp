@@ -0,0 +1,182 @@
+#include "RingBufferAllocator.h"
+
+#include <cassert>
+
+namespace blurp
+{
+    RingBufferAllocator::RingBufferAllocator(std::uint64_t a_Capacity, std::uint32_t a_NumFrames, RingBufferFence& a_Fence)
+        : m_Fence(a_Fence), m_Capacity(a_Capacity), m_NumFrames(a_NumFrames), m_Head(0), m_FrameStart(0), m_FrameId(0), m_FrameAllocations(0)
+    {
+        assert(a_NumFrames > 0 && "A ring buffer needs at least one frame!");
+    }
+
+    void RingBufferAllocator::BeginFrame()
+    {
+        //Fence the memory used by the frame that just ended. Frames without allocations do not need protection.
+        if(m_FrameAllocations > 0)
+        {
+            m_Fence.Insert(m_FrameId);
+            m_InFlight.push_back(FrameRegion{ m_FrameId, m_FrameStart, m_Head });
+        }
+
+        ++m_FrameId;
+        m_FrameStart = m_Head;
+        m_FrameAllocations = 0;
+
+        //Release whatever the GPU is already done with, then make sure that the frame limit is respected.
+        RetireCompleted();
+        while(m_InFlight.size() >= m_NumFrames)
+        {
+            RetireOldest();
+        }
+    }
+
+    bool RingBufferAllocator::Allocate(std::uint64_t a_Size, std::uint64_t a_Alignment, std::uint64_t& a_Offset)
+    {
+        assert(a_Alignment > 0 && (a_Alignment & (a_Alignment - 1)) == 0 && "Alignment has to be a power of two!");
+
+        if(a_Size > m_Capacity)
+        {
+            return false;
+        }
+
+        while(true)
+        {
+            //When nothing is in use, start at the beginning to have the most contiguous space.
+            const bool empty = m_InFlight.empty() && m_FrameAllocations == 0;
+            if(empty)
+            {
+                m_Head = 0;
+                m_FrameStart = 0;
+            }
+
+            //The oldest byte still in use. Everything from here up to the head is off limits.
+            const std::uint64_t tail = m_InFlight.empty() ? m_FrameStart : m_InFlight.front().start;
+
+            std::uint64_t start = (m_Head + (a_Alignment - 1)) & ~(a_Alignment - 1);
+            bool fits = false;
+            bool wrapped = false;
+
+            if(empty)
+            {
+                fits = start + a_Size <= m_Capacity;
+            }
+            //Used memory is contiguous. Try the space behind the head first, then the space before the tail.
+            //The head may never reach the tail when wrapping, otherwise a full buffer would look empty.
+            else if(m_Head >= tail)
+            {
+                if(start + a_Size <= m_Capacity)
+                {
+                    fits = true;
+                }
+                else
+                {
+                    start = 0;
+                    wrapped = true;
+                    fits = a_Size < tail;
+                }
+            }
+            //Used memory wraps around. Only the space between the head and tail is free.
+            else
+            {
+                fits = start + a_Size < tail;
+            }
+
+            if(fits)
+            {
+                m_Head = start + a_Size;
+                a_Offset = start;
+                ++m_FrameAllocations;
+                ++m_Stats.allocations;
+                if(wrapped)
+                {
+                    ++m_Stats.wraps;
+                }
+                return true;
+            }
+
+            //The current frame is in the way, which means the buffer is too small for a single frame.
+            if(m_InFlight.empty())
+            {
+                return false;
+            }
+
+            //Free up the memory of the oldest frame and try again.
+            RetireOldest();
+        }
+    }
+
+    void RingBufferAllocator::WaitIdle()
+    {
+        while(!m_InFlight.empty())
+        {
+            RetireOldest();
+        }
+    }
+
+    void RingBufferAllocator::Resize(std::uint64_t a_Capacity)
+    {
+        assert(m_InFlight.empty() && "Cannot resize a ring buffer while frames are in flight!");
+
+        //Data from the current frame wraps around. Claim everything up to the old capacity so that the allocations stay protected.
+        if(m_FrameAllocations > 0 && m_Head < m_FrameStart)
+        {
+            m_FrameStart = 0;
+            m_Head = m_Capacity;
+        }
+
+        m_Capacity = a_Capacity;
+
+        //When shrinking, the current data can no longer be kept.
+        if(m_Head > m_Capacity)
+        {
+            m_Head = 0;
+            m_FrameStart = 0;
+            m_FrameAllocations = 0;
+        }
+    }
+
+    std::uint64_t RingBufferAllocator::GetCapacity() const
+    {
+        return m_Capacity;
+    }
+
+    std::uint32_t RingBufferAllocator::GetFramesInFlight() const
+    {
+        return static_cast<std::uint32_t>(m_InFlight.size());
+    }
+
+    std::uint64_t RingBufferAllocator::GetFrameId() const
+    {
+        return m_FrameId;
+    }
+
+    const RingBufferStats& RingBufferAllocator::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    void RingBufferAllocator::RetireCompleted()
+    {
+        //Fences are passed in order, so stop at the first one that is not done yet.
+        while(!m_InFlight.empty() && m_Fence.IsComplete(m_InFlight.front().frameId))
+        {
+            m_InFlight.pop_front();
+            ++m_Stats.framesRetired;
+        }
+    }
+
+    void RingBufferAllocator::RetireOldest()
+    {
+        assert(!m_InFlight.empty());
+
+        if(!m_Fence.IsComplete(m_InFlight.front().frameId))
+        {
+            m_Fence.Wait(m_InFlight.front().frameId);
+            ++m_Stats.stalls;
+        }
+
+        m_InFlight.pop_front();
+        ++m_Stats.framesRetired;
+    }
+}
@@ -0,0 +1,383 @@
+#include "ShaderBinaryCache.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace blurp
+{
+    namespace
+    {
+        //Written at the start of every file. Files with a different magic number or version are deleted.
+        constexpr std::uint32_t BINARY_MAGIC = 0x43425342;  //"BSBC"
+        constexpr std::uint32_t BINARY_VERSION = 1;
+        constexpr const char* BINARY_EXTENSION = ".bin";
+        constexpr const char* TEMPORARY_EXTENSION = ".tmp";
+
+        struct ShaderBinaryHeader
+        {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint64_t key;
+            std::uint64_t driverHash;
+            std::uint64_t size;
+            std::uint64_t checksum;
+            std::uint32_t format;
+            std::uint32_t padding;
+        };
+
+        //64 bit FNV-1a.
+        constexpr std::uint64_t HASH_SEED = 0xcbf29ce484222325ull;
+
+        std::uint64_t Hash(std::uint64_t a_Hash, const void* a_Data, std::size_t a_Size)
+        {
+            const auto* bytes = static_cast<const unsigned char*>(a_Data);
+            for(std::size_t i = 0; i < a_Size; ++i)
+            {
+                a_Hash = (a_Hash ^ bytes[i]) * 0x100000001b3ull;
+            }
+            return a_Hash;
+        }
+
+        //Hash the size first, so that the end of one string can not be mistaken for the start of the next.
+        std::uint64_t Hash(std::uint64_t a_Hash, const std::string& a_String)
+        {
+            const std::uint64_t size = a_String.size();
+            a_Hash = Hash(a_Hash, &size, sizeof(size));
+            return Hash(a_Hash, a_String.data(), a_String.size());
+        }
+    }
+
+    ShaderBinaryCache::ShaderBinaryCache() : m_DriverHash(0), m_Open(false)
+    {
+    }
+
+    bool ShaderBinaryCache::Open(const std::string& a_Directory, const std::string& a_DriverId)
+    {
+        m_Directory = a_Directory;
+        m_DriverId = a_DriverId;
+        m_DriverHash = Hash(HASH_SEED, a_DriverId);
+        m_Index.clear();
+        m_Open = false;
+
+        std::error_code error;
+        std::filesystem::create_directories(m_Directory, error);
+        if(error)
+        {
+            return false;
+        }
+
+        std::vector<std::filesystem::path> invalid;
+        for(const auto& file : std::filesystem::directory_iterator(m_Directory, error))
+        {
+            const auto& path = file.path();
+
+            //Temporary files are left behind when writing was interrupted.
+            if(path.extension() == TEMPORARY_EXTENSION)
+            {
+                invalid.push_back(path);
+                continue;
+            }
+
+            if(path.extension() != BINARY_EXTENSION)
+            {
+                continue;
+            }
+
+            ShaderBinaryHeader header;
+            std::ifstream stream(path, std::ios::in | std::ios::binary);
+            const bool read = static_cast<bool>(stream.read(reinterpret_cast<char*>(&header), sizeof(header)));
+            const std::uint64_t fileSize = file.file_size(error);
+            stream.close();
+
+            //The file has to be complete, made by the current driver and named after its key.
+            if(!read || error || header.magic != BINARY_MAGIC || header.version != BINARY_VERSION || header.driverHash != m_DriverHash
+                || fileSize != sizeof(header) + header.size || path.filename() != std::filesystem::path(GetPath(header.key)).filename())
+            {
+                invalid.push_back(path);
+                continue;
+            }
+
+            m_Index[header.key] = { header.format, header.size, header.checksum };
+        }
+
+        for(const auto& path : invalid)
+        {
+            std::filesystem::remove(path, error);
+        }
+
+        m_Stats.loaded = static_cast<std::uint32_t>(m_Index.size());
+        m_Open = true;
+        return true;
+    }
+
+    bool ShaderBinaryCache::IsOpen() const
+    {
+        return m_Open;
+    }
+
+    bool ShaderBinaryCache::LoadOrCompile(const ShaderSettings& a_Settings, ShaderBinaryBackend& a_Backend)
+    {
+        std::uint32_t format = 0;
+        std::vector<char> data;
+
+        //Without a directory there is nothing to load or store.
+        if(!m_Open)
+        {
+            return a_Backend.Compile(format, data);
+        }
+
+        const std::uint64_t key = GetKey(a_Settings);
+        const bool stored = Contains(key);
+        if(stored && Find(key, format, data) && a_Backend.LoadBinary(format, data))
+        {
+            ++m_Stats.hits;
+            return true;
+        }
+
+        //The binary is damaged or no longer accepted by the driver, so it is replaced.
+        if(stored)
+        {
+            ++m_Stats.rejected;
+            Remove(key);
+        }
+        else
+        {
+            ++m_Stats.misses;
+        }
+
+        data.clear();
+        if(!a_Backend.Compile(format, data))
+        {
+            return false;
+        }
+
+        if(!data.empty())
+        {
+            Store(key, format, data);
+        }
+        return true;
+    }
+
+    std::uint64_t ShaderBinaryCache::GetKey(const ShaderSettings& a_Settings) const
+    {
+        return CalculateKey(a_Settings, m_DriverId);
+    }
+
+    bool ShaderBinaryCache::Contains(std::uint64_t a_Key) const
+    {
+        return m_Index.find(a_Key) != m_Index.end();
+    }
+
+    bool ShaderBinaryCache::Find(std::uint64_t a_Key, std::uint32_t& a_Format, std::vector<char>& a_Data)
+    {
+        const auto found = m_Index.find(a_Key);
+        if(found == m_Index.end())
+        {
+            return false;
+        }
+
+        const Entry entry = found->second;
+        ShaderBinaryHeader header;
+        std::ifstream stream(GetPath(a_Key), std::ios::in | std::ios::binary);
+        bool valid = static_cast<bool>(stream.read(reinterpret_cast<char*>(&header), sizeof(header)));
+        valid = valid && header.key == a_Key && header.size == entry.size && header.format == entry.format && header.checksum == entry.checksum;
+
+        if(valid)
+        {
+            a_Data.resize(static_cast<std::size_t>(entry.size));
+            valid = entry.size == 0 || static_cast<bool>(stream.read(a_Data.data(), static_cast<std::streamsize>(entry.size)));
+            valid = valid && Hash(HASH_SEED, a_Data.data(), a_Data.size()) == entry.checksum;
+        }
+        stream.close();
+
+        if(!valid)
+        {
+            a_Data.clear();
+            Remove(a_Key);
+            return false;
+        }
+
+        a_Format = entry.format;
+        return true;
+    }
+
+    bool ShaderBinaryCache::Store(std::uint64_t a_Key, std::uint32_t a_Format, const std::vector<char>& a_Data)
+    {
+        assert(m_Open && "Shader binary cache has to be opened before storing binaries!");
+
+        ShaderBinaryHeader header;
+        header.magic = BINARY_MAGIC;
+        header.version = BINARY_VERSION;
+        header.key = a_Key;
+        header.driverHash = m_DriverHash;
+        header.size = a_Data.size();
+        header.checksum = Hash(HASH_SEED, a_Data.data(), a_Data.size());
+        header.format = a_Format;
+        header.padding = 0;
+
+        //Write everything to a temporary file first, and then move it in place.
+        const std::string path = GetPath(a_Key);
+        const std::string temporaryPath = path + TEMPORARY_EXTENSION;
+        std::ofstream stream(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if(!a_Data.empty())
+        {
+            stream.write(a_Data.data(), static_cast<std::streamsize>(a_Data.size()));
+        }
+        stream.close();
+
+        std::error_code error;
+        if(stream.fail())
+        {
+            std::filesystem::remove(temporaryPath, error);
+            ++m_Stats.writeFailures;
+            return false;
+        }
+
+        std::filesystem::rename(temporaryPath, path, error);
+        if(error)
+        {
+            //Some file systems do not replace existing files when renaming.
+            error.clear();
+            std::filesystem::remove(path, error);
+            std::filesystem::rename(temporaryPath, path, error);
+        }
+
+        if(error)
+        {
+            std::filesystem::remove(temporaryPath, error);
+            m_Index.erase(a_Key);
+            ++m_Stats.writeFailures;
+            return false;
+        }
+
+        m_Index[a_Key] = { header.format, header.size, header.checksum };
+        ++m_Stats.stored;
+        return true;
+    }
+
+    void ShaderBinaryCache::Remove(std::uint64_t a_Key)
+    {
+        m_Index.erase(a_Key);
+        std::error_code error;
+        std::filesystem::remove(GetPath(a_Key), error);
+    }
+
+    std::size_t ShaderBinaryCache::GetEntryCount() const
+    {
+        return m_Index.size();
+    }
+
+    const ShaderBinaryCacheStats& ShaderBinaryCache::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    std::uint64_t ShaderBinaryCache::CalculateKey(const ShaderSettings& a_Settings, const std::string& a_DriverId)
+    {
+        std::uint64_t hash = Hash(HASH_SEED, &BINARY_VERSION, sizeof(BINARY_VERSION));
+        hash = Hash(hash, a_DriverId);
+        hash = Hash(hash, &a_Settings.type, sizeof(a_Settings.type));
+
+        //Missing stages are hashed as empty strings, so every stage stays in its own place.
+        for(const char* source : { a_Settings.vertexShaderSource, a_Settings.tessellationHullShaderSource, a_Settings.tessellationDomainShaderSource,
+            a_Settings.geometryShaderSource, a_Settings.fragmentShaderSource, a_Settings.computeShaderSource })
+        {
+            hash = Hash(hash, source != nullptr ? StripSource(source) : std::string());
+        }
+
+        const std::uint64_t numDefinitions = a_Settings.preprocessorDefinitions.size();
+        hash = Hash(hash, &numDefinitions, sizeof(numDefinitions));
+        for(const auto& definition : a_Settings.preprocessorDefinitions)
+        {
+            hash = Hash(hash, definition);
+        }
+
+        return hash;
+    }
+
+    std::string ShaderBinaryCache::StripSource(const char* a_Source)
+    {
+        std::string result;
+        if(a_Source == nullptr)
+        {
+            return result;
+        }
+
+        const std::size_t length = strlen(a_Source);
+        result.reserve(length);
+
+        bool lineHasContent = false;
+        bool pendingSpace = false;
+
+        std::size_t i = 0;
+        while(i < length)
+        {
+            const char c = a_Source[i];
+            const char next = i + 1 < length ? a_Source[i + 1] : '\0';
+
+            //Line comments run up to the end of the line, which is handled as usual.
+            if(c == '/' && next == '/')
+            {
+                while(i < length && a_Source[i] != '\n')
+                {
+                    ++i;
+                }
+                continue;
+            }
+
+            //Block comments are replaced by a single space, like the preprocessor does.
+            if(c == '/' && next == '*')
+            {
+                const char* end = strstr(a_Source + i + 2, "*/");
+                i = end != nullptr ? static_cast<std::size_t>(end - a_Source) + 2 : length;
+                pendingSpace = lineHasContent;
+                continue;
+            }
+
+            if(c == '\n' || c == '\r')
+            {
+                if(lineHasContent)
+                {
+                    result += '\n';
+                }
+                lineHasContent = false;
+                pendingSpace = false;
+            }
+            else if(c == ' ' || c == '\t')
+            {
+                pendingSpace = lineHasContent;
+            }
+            else
+            {
+                if(pendingSpace)
+                {
+                    result += ' ';
+                    pendingSpace = false;
+                }
+                result += c;
+                lineHasContent = true;
+            }
+
+            ++i;
+        }
+
+        //End the last line the same way whether the source ends with a new line or not.
+        if(lineHasContent)
+        {
+            result += '\n';
+        }
+
+        return result;
+    }
+
+    std::string ShaderBinaryCache::GetPath(std::uint64_t a_Key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(a_Key));
+        return (std::filesystem::path(m_Directory) / (std::string(name) + BINARY_EXTENSION)).string();
+    }
+}
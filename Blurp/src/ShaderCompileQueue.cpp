@@ -0,0 +1,189 @@
+#include "ShaderCompileQueue.h"
+
+#include <bitset>
+#include <cassert>
+
+#include "Shader.h"
+
+namespace blurp
+{
+    namespace
+    {
+        std::uint32_t CountBits(std::uint64_t a_Mask)
+        {
+            return static_cast<std::uint32_t>(std::bitset<64>(a_Mask).count());
+        }
+    }
+
+    ShaderCompileQueue::ShaderCompileQueue(std::uint32_t a_MaxInFlight) : m_MaxInFlight(a_MaxInFlight)
+    {
+        assert(a_MaxInFlight > 0 && "At least one shader has to be able to compile at a time!");
+    }
+
+    void ShaderCompileQueue::SetMaxInFlight(std::uint32_t a_MaxInFlight)
+    {
+        assert(a_MaxInFlight > 0 && "At least one shader has to be able to compile at a time!");
+        m_MaxInFlight = a_MaxInFlight;
+    }
+
+    bool ShaderCompileQueue::Request(std::uint64_t a_Mask, const std::vector<std::string>& a_Definitions, std::uint64_t a_DefinitionsId)
+    {
+        if (!m_Queued.emplace(a_Mask, a_DefinitionsId).second)
+        {
+            return false;
+        }
+
+        ShaderCompileJob job;
+        job.mask = a_Mask;
+        job.definitions = a_Definitions;
+        job.definitionsId = a_DefinitionsId;
+        m_Waiting.push_back(std::move(job));
+        ++m_Stats.requests;
+        return true;
+    }
+
+    bool ShaderCompileQueue::IsQueued(std::uint64_t a_Mask, std::uint64_t a_DefinitionsId) const
+    {
+        return m_Queued.find(std::make_pair(a_Mask, a_DefinitionsId)) != m_Queued.end();
+    }
+
+    std::size_t ShaderCompileQueue::Update(float a_BudgetMilliseconds, const StartFunction& a_Start, const ReadyFunction& a_IsReady, const FinishFunction& a_Finish)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        const auto finish = [&](const ShaderCompileJob& a_Job)
+        {
+            const std::chrono::duration<float, std::milli> compileTime = std::chrono::high_resolution_clock::now() - a_Job.start;
+            m_Queued.erase(std::make_pair(a_Job.mask, a_Job.definitionsId));
+            ++m_Stats.finished;
+            a_Finish(a_Job, compileTime.count());
+        };
+
+        //Collect the jobs that are done. The order of the others does not matter.
+        for (std::size_t i = 0; i < m_InFlight.size();)
+        {
+            if (a_IsReady(*m_InFlight[i].shader))
+            {
+                const ShaderCompileJob job = std::move(m_InFlight[i]);
+                m_InFlight[i] = std::move(m_InFlight.back());
+                m_InFlight.pop_back();
+                finish(job);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        bool started = false;
+        while (!m_Waiting.empty() && m_InFlight.size() < m_MaxInFlight)
+        {
+            if (started && a_BudgetMilliseconds > 0.f && std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count() >= a_BudgetMilliseconds)
+            {
+                break;
+            }
+
+            ShaderCompileJob job = std::move(m_Waiting.front());
+            m_Waiting.pop_front();
+            started = true;
+
+            job.start = std::chrono::high_resolution_clock::now();
+            job.shader = a_Start(job);
+            if (job.shader == nullptr)
+            {
+                m_Queued.erase(std::make_pair(job.mask, job.definitionsId));
+                ++m_Stats.failed;
+                continue;
+            }
+            ++m_Stats.started;
+
+            //Drivers that can not compile in parallel are done right away.
+            if (a_IsReady(*job.shader))
+            {
+                finish(job);
+            }
+            else
+            {
+                m_InFlight.push_back(std::move(job));
+            }
+        }
+
+        return m_Waiting.size() + m_InFlight.size();
+    }
+
+    void ShaderCompileQueue::CountFallback(bool a_Found)
+    {
+        if (a_Found)
+        {
+            ++m_Stats.fallbacks;
+        }
+        else
+        {
+            ++m_Stats.skips;
+        }
+    }
+
+    void ShaderCompileQueue::Clear()
+    {
+        m_Waiting.clear();
+        m_InFlight.clear();
+        m_Queued.clear();
+    }
+
+    std::size_t ShaderCompileQueue::GetWaitingCount() const
+    {
+        return m_Waiting.size();
+    }
+
+    std::size_t ShaderCompileQueue::GetInFlightCount() const
+    {
+        return m_InFlight.size();
+    }
+
+    const ShaderCompileQueueStats& ShaderCompileQueue::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    bool ShaderCompileQueue::SelectFallback(std::uint64_t a_Requested, const std::vector<std::uint64_t>& a_Available, std::uint64_t a_ExactBits,
+        ShaderFallbackPolicy a_Policy, std::uint64_t& a_Fallback)
+    {
+        if (a_Policy == ShaderFallbackPolicy::BLOCK || a_Policy == ShaderFallbackPolicy::SKIP)
+        {
+            return false;
+        }
+
+        bool found = false;
+        std::uint32_t bestMissing = 0;
+        std::uint32_t bestExtra = 0;
+
+        for (const auto mask : a_Available)
+        {
+            if ((mask & a_ExactBits) != (a_Requested & a_ExactBits))
+            {
+                continue;
+            }
+
+            //Features the variant lacks, and features it has that were not requested.
+            const std::uint32_t missing = CountBits(a_Requested & ~mask);
+            const std::uint32_t extra = CountBits(mask & ~a_Requested);
+            if (a_Policy == ShaderFallbackPolicy::SUBSET && extra != 0)
+            {
+                continue;
+            }
+
+            //Fewest differences first, then fewest extra features, then the lowest mask so the choice does not depend on the order.
+            const std::uint32_t difference = missing + extra;
+            const std::uint32_t bestDifference = bestMissing + bestExtra;
+            if (!found || difference < bestDifference || (difference == bestDifference && (extra < bestExtra || (extra == bestExtra && mask < a_Fallback))))
+            {
+                found = true;
+                bestMissing = missing;
+                bestExtra = extra;
+                a_Fallback = mask;
+            }
+        }
+
+        return found;
+    }
+}
@@ -0,0 +1,205 @@
+#include "ShaderManifest.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace blurp
+{
+    namespace
+    {
+        constexpr const char* MANIFEST_HEADER = "#Blurp shader manifest. Pass\tmask\tfirst use frame\tcompile milliseconds\tdefinitions separated by ';'";
+
+        //Split a line on a separator. Empty parts are kept.
+        std::vector<std::string> Split(const std::string& a_Line, char a_Separator)
+        {
+            std::vector<std::string> parts;
+            std::size_t start = 0;
+            while(true)
+            {
+                const std::size_t end = a_Line.find(a_Separator, start);
+                parts.push_back(a_Line.substr(start, end == std::string::npos ? std::string::npos : end - start));
+                if(end == std::string::npos)
+                {
+                    return parts;
+                }
+                start = end + 1;
+            }
+        }
+    }
+
+    ShaderManifest::ShaderManifest() : m_Frame(0), m_SkippedLines(0)
+    {
+    }
+
+    bool ShaderManifest::Record(const std::string& a_Pass, std::uint64_t a_Mask, const std::vector<std::string>& a_Definitions, float a_CompileMilliseconds)
+    {
+        assert(!a_Pass.empty() && a_Pass.find_first_of("\t\n#") == std::string::npos && "Pass names can not be empty or contain tabs, new lines or '#'!");
+        assert(std::none_of(a_Definitions.begin(), a_Definitions.end(), [](const std::string& a_Definition) { return a_Definition.find_first_of("\t\n;") != std::string::npos; })
+            && "Definitions in a shader manifest can not contain tabs, new lines or ';'!");
+
+        const auto key = std::make_pair(a_Pass, a_Mask);
+        if(m_Entries.find(key) != m_Entries.end())
+        {
+            return false;
+        }
+
+        ShaderManifestEntry entry;
+        entry.mask = a_Mask;
+        entry.definitions = a_Definitions;
+        entry.frame = m_Frame;
+        entry.compileMilliseconds = a_CompileMilliseconds;
+        m_Entries.emplace(key, entry);
+        return true;
+    }
+
+    bool ShaderManifest::Contains(const std::string& a_Pass, std::uint64_t a_Mask) const
+    {
+        return m_Entries.find(std::make_pair(a_Pass, a_Mask)) != m_Entries.end();
+    }
+
+    std::vector<ShaderManifestEntry> ShaderManifest::GetEntries(const std::string& a_Pass) const
+    {
+        std::vector<ShaderManifestEntry> entries;
+        for(auto itr = m_Entries.lower_bound(std::make_pair(a_Pass, std::uint64_t(0))); itr != m_Entries.end() && itr->first.first == a_Pass; ++itr)
+        {
+            entries.push_back(itr->second);
+        }
+
+        //Stable so that variants from the same frame stay sorted by mask.
+        std::stable_sort(entries.begin(), entries.end(), [](const ShaderManifestEntry& a_Left, const ShaderManifestEntry& a_Right) { return a_Left.frame < a_Right.frame; });
+        return entries;
+    }
+
+    std::size_t ShaderManifest::GetEntryCount() const
+    {
+        return m_Entries.size();
+    }
+
+    void ShaderManifest::NextFrame()
+    {
+        ++m_Frame;
+    }
+
+    std::uint64_t ShaderManifest::GetFrame() const
+    {
+        return m_Frame;
+    }
+
+    void ShaderManifest::Clear()
+    {
+        m_Entries.clear();
+        m_Frame = 0;
+    }
+
+    bool ShaderManifest::Save(const std::string& a_Path) const
+    {
+        std::ostringstream text;
+        text << MANIFEST_HEADER << '\n';
+
+        for(const auto& pair : m_Entries)
+        {
+            const auto& entry = pair.second;
+            char numbers[96];
+            snprintf(numbers, sizeof(numbers), "0x%016llx\t%llu\t%.3f", static_cast<unsigned long long>(entry.mask), static_cast<unsigned long long>(entry.frame), entry.compileMilliseconds);
+            text << pair.first.first << '\t' << numbers << '\t';
+
+            for(std::size_t i = 0; i < entry.definitions.size(); ++i)
+            {
+                text << (i == 0 ? "" : ";") << entry.definitions[i];
+            }
+            text << '\n';
+        }
+
+        //Write to a temporary file first so that an interrupted save keeps the old manifest.
+        const std::string temporaryPath = a_Path + ".tmp";
+        std::ofstream file(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        const std::string data = text.str();
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+
+        std::error_code error;
+        if(file.fail())
+        {
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+
+        std::filesystem::rename(temporaryPath, a_Path, error);
+        if(error)
+        {
+            error.clear();
+            std::filesystem::remove(a_Path, error);
+            std::filesystem::rename(temporaryPath, a_Path, error);
+        }
+        return !error;
+    }
+
+    bool ShaderManifest::Load(const std::string& a_Path)
+    {
+        m_SkippedLines = 0;
+
+        std::ifstream file(a_Path, std::ios::in);
+        if(!file.good())
+        {
+            return false;
+        }
+
+        std::string line;
+        while(std::getline(file, line))
+        {
+            //Files edited on Windows may end lines with \r\n.
+            if(!line.empty() && line.back() == '\r')
+            {
+                line.pop_back();
+            }
+
+            if(line.empty() || line[0] == '#')
+            {
+                continue;
+            }
+
+            const auto fields = Split(line, '\t');
+            if(fields.size() < 4 || fields.size() > 5 || fields[0].empty())
+            {
+                ++m_SkippedLines;
+                continue;
+            }
+
+            char* maskEnd = nullptr;
+            char* frameEnd = nullptr;
+            char* timeEnd = nullptr;
+            const std::uint64_t mask = strtoull(fields[1].c_str(), &maskEnd, 16);
+            const std::uint64_t frame = strtoull(fields[2].c_str(), &frameEnd, 10);
+            const float time = strtof(fields[3].c_str(), &timeEnd);
+            if(fields[1].empty() || *maskEnd != '\0' || fields[2].empty() || *frameEnd != '\0' || fields[3].empty() || *timeEnd != '\0')
+            {
+                ++m_SkippedLines;
+                continue;
+            }
+
+            ShaderManifestEntry entry;
+            entry.mask = mask;
+            entry.frame = frame;
+            entry.compileMilliseconds = time;
+            if(fields.size() == 5 && !fields[4].empty())
+            {
+                entry.definitions = Split(fields[4], ';');
+            }
+
+            //Variants that are already known are kept as they are.
+            m_Entries.emplace(std::make_pair(fields[0], mask), entry);
+        }
+
+        return true;
+    }
+
+    std::uint32_t ShaderManifest::GetSkippedLines() const
+    {
+        return m_SkippedLines;
+    }
+}
@@ -0,0 +1,63 @@
+#include "ShaderMaskTable.h"
+
+#include <cassert>
+
+namespace blurp
+{
+    ShaderMaskTable::ShaderMaskTable() : m_UsedBits(0)
+    {
+    }
+
+    void ShaderMaskTable::Add(const std::string& a_Definition, bool a_Used, const std::string& a_LocationDefinition)
+    {
+        assert(m_Definitions.size() < 64 && "A shader mask can not have more than 64 bits!");
+
+        if (a_Used)
+        {
+            m_UsedBits |= static_cast<std::uint64_t>(1) << m_Definitions.size();
+        }
+
+        if (!a_LocationDefinition.empty())
+        {
+            m_Locations[a_LocationDefinition] = a_Used;
+        }
+
+        m_Definitions.push_back(a_Definition);
+    }
+
+    const std::vector<std::string>& ShaderMaskTable::GetDefinitions() const
+    {
+        return m_Definitions;
+    }
+
+    std::uint64_t ShaderMaskTable::GetUsedBits() const
+    {
+        return m_UsedBits;
+    }
+
+    bool ShaderMaskTable::IsUsed(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_Definitions.size() && "Bit index out of bounds!");
+        return (m_UsedBits & (static_cast<std::uint64_t>(1) << a_Index)) != 0;
+    }
+
+    std::uint64_t ShaderMaskTable::Canonicalize(std::uint64_t a_Mask) const
+    {
+        return a_Mask & m_UsedBits;
+    }
+
+    void ShaderMaskTable::FilterDefinitions(const std::vector<std::string>& a_Definitions, std::vector<std::string>& a_Output) const
+    {
+        assert(&a_Definitions != &a_Output && "Definitions can not be filtered in place!");
+
+        a_Output.clear();
+        for (const auto& definition : a_Definitions)
+        {
+            const auto found = m_Locations.find(definition.substr(0, definition.find(' ')));
+            if (found == m_Locations.end() || found->second)
+            {
+                a_Output.push_back(definition);
+            }
+        }
+    }
+}
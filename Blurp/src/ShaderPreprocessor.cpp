@@ -0,0 +1,568 @@
+#include "ShaderPreprocessor.h"
+
+#include <cctype>
+#include <cstring>
+
+#include "FileReader.h"
+#include "ShaderBinaryCache.h"
+
+namespace blurp
+{
+    namespace
+    {
+        //Includes and macros that refer to other macros can not nest deeper than this.
+        constexpr std::uint32_t MAX_DEPTH = 32;
+
+        bool IsIdentifierStart(char a_Char)
+        {
+            return std::isalpha(static_cast<unsigned char>(a_Char)) || a_Char == '_';
+        }
+
+        bool IsIdentifierChar(char a_Char)
+        {
+            return std::isalnum(static_cast<unsigned char>(a_Char)) || a_Char == '_';
+        }
+
+        std::string Trim(const std::string& a_String)
+        {
+            const auto start = a_String.find_first_not_of(" \t");
+            if (start == std::string::npos)
+            {
+                return std::string();
+            }
+            const auto end = a_String.find_last_not_of(" \t");
+            return a_String.substr(start, end - start + 1);
+        }
+
+        //Read the identifier at the start of a string.
+        std::string ReadIdentifier(const std::string& a_String)
+        {
+            std::size_t end = 0;
+            while (end < a_String.size() && IsIdentifierChar(a_String[end]))
+            {
+                ++end;
+            }
+            return a_String.substr(0, end);
+        }
+
+        //Split an expression into identifiers, numbers and operators. Returns false on characters that can not be part of an expression.
+        bool Tokenize(const std::string& a_Expression, std::vector<std::string>& a_Tokens)
+        {
+            std::size_t i = 0;
+            while (i < a_Expression.size())
+            {
+                const char c = a_Expression[i];
+                if (c == ' ' || c == '\t')
+                {
+                    ++i;
+                }
+                else if (IsIdentifierChar(c))
+                {
+                    std::size_t end = i;
+                    while (end < a_Expression.size() && IsIdentifierChar(a_Expression[end]))
+                    {
+                        ++end;
+                    }
+                    a_Tokens.push_back(a_Expression.substr(i, end - i));
+                    i = end;
+                }
+                else
+                {
+                    const std::string pair = a_Expression.substr(i, 2);
+                    if (pair == "&&" || pair == "||" || pair == "==" || pair == "!=" || pair == "<=" || pair == ">=")
+                    {
+                        a_Tokens.push_back(pair);
+                        i += 2;
+                    }
+                    else if (strchr("!()<>+-*/%", c) != nullptr)
+                    {
+                        a_Tokens.push_back(std::string(1, c));
+                        ++i;
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /*
+         * Recursive descent parser for #if expressions, from the lowest to the highest precedence.
+         */
+        class ExpressionParser
+        {
+        public:
+            ExpressionParser(const std::vector<std::string>& a_Tokens, const std::unordered_map<std::string, std::string>& a_Macros, std::uint32_t a_Depth)
+                : m_Tokens(a_Tokens), m_Macros(a_Macros), m_Position(0), m_Depth(a_Depth), m_Error(false)
+            {
+            }
+
+            //Parse the whole expression. Returns false on errors or when tokens are left over.
+            bool Parse(long long& a_Result)
+            {
+                a_Result = ParseOr();
+                return !m_Error && m_Position == m_Tokens.size();
+            }
+
+        private:
+            bool Accept(const char* a_Token)
+            {
+                if (m_Position < m_Tokens.size() && m_Tokens[m_Position] == a_Token)
+                {
+                    ++m_Position;
+                    return true;
+                }
+                return false;
+            }
+
+            long long ParseOr()
+            {
+                long long left = ParseAnd();
+                while (Accept("||"))
+                {
+                    const long long right = ParseAnd();
+                    left = left != 0 || right != 0;
+                }
+                return left;
+            }
+
+            long long ParseAnd()
+            {
+                long long left = ParseEquality();
+                while (Accept("&&"))
+                {
+                    const long long right = ParseEquality();
+                    left = left != 0 && right != 0;
+                }
+                return left;
+            }
+
+            long long ParseEquality()
+            {
+                long long left = ParseRelational();
+                while (true)
+                {
+                    if (Accept("==")) { left = left == ParseRelational(); }
+                    else if (Accept("!=")) { left = left != ParseRelational(); }
+                    else { return left; }
+                }
+            }
+
+            long long ParseRelational()
+            {
+                long long left = ParseAdditive();
+                while (true)
+                {
+                    if (Accept("<=")) { left = left <= ParseAdditive(); }
+                    else if (Accept(">=")) { left = left >= ParseAdditive(); }
+                    else if (Accept("<")) { left = left < ParseAdditive(); }
+                    else if (Accept(">")) { left = left > ParseAdditive(); }
+                    else { return left; }
+                }
+            }
+
+            long long ParseAdditive()
+            {
+                long long left = ParseMultiplicative();
+                while (true)
+                {
+                    if (Accept("+")) { left += ParseMultiplicative(); }
+                    else if (Accept("-")) { left -= ParseMultiplicative(); }
+                    else { return left; }
+                }
+            }
+
+            long long ParseMultiplicative()
+            {
+                long long left = ParseUnary();
+                while (true)
+                {
+                    const bool divide = Accept("/");
+                    const bool modulo = !divide && Accept("%");
+                    if (!divide && !modulo && !Accept("*"))
+                    {
+                        return left;
+                    }
+
+                    const long long right = ParseUnary();
+                    if (!divide && !modulo)
+                    {
+                        left *= right;
+                    }
+                    else if (right == 0)
+                    {
+                        m_Error = true;
+                        return 0;
+                    }
+                    else
+                    {
+                        left = divide ? left / right : left % right;
+                    }
+                }
+            }
+
+            long long ParseUnary()
+            {
+                if (Accept("!")) { return ParseUnary() == 0; }
+                if (Accept("-")) { return -ParseUnary(); }
+                if (Accept("+")) { return ParseUnary(); }
+                return ParsePrimary();
+            }
+
+            long long ParsePrimary()
+            {
+                if (m_Position >= m_Tokens.size())
+                {
+                    m_Error = true;
+                    return 0;
+                }
+
+                if (Accept("("))
+                {
+                    const long long value = ParseOr();
+                    m_Error = m_Error || !Accept(")");
+                    return value;
+                }
+
+                const std::string token = m_Tokens[m_Position++];
+                if (token == "defined")
+                {
+                    const bool parentheses = Accept("(");
+                    if (m_Position >= m_Tokens.size() || !IsIdentifierStart(m_Tokens[m_Position][0]))
+                    {
+                        m_Error = true;
+                        return 0;
+                    }
+                    const bool defined = m_Macros.find(m_Tokens[m_Position++]) != m_Macros.end();
+                    m_Error = m_Error || (parentheses && !Accept(")"));
+                    return defined;
+                }
+
+                if (std::isdigit(static_cast<unsigned char>(token[0])))
+                {
+                    char* end = nullptr;
+                    const long long value = strtoll(token.c_str(), &end, 0);
+
+                    //Allow unsigned suffixes.
+                    m_Error = m_Error || !(*end == '\0' || ((*end == 'u' || *end == 'U') && end[1] == '\0'));
+                    return value;
+                }
+
+                if (!IsIdentifierStart(token[0]))
+                {
+                    m_Error = true;
+                    return 0;
+                }
+
+                //Names that are not defined are 0. Defined names are replaced by their value.
+                const auto macro = m_Macros.find(token);
+                if (macro == m_Macros.end())
+                {
+                    return 0;
+                }
+
+                std::vector<std::string> tokens;
+                long long value = 0;
+                if (macro->second.empty() || m_Depth >= MAX_DEPTH || !Tokenize(macro->second, tokens) || !ExpressionParser(tokens, m_Macros, m_Depth + 1).Parse(value))
+                {
+                    m_Error = true;
+                    return 0;
+                }
+                return value;
+            }
+
+        private:
+            const std::vector<std::string>& m_Tokens;
+            const std::unordered_map<std::string, std::string>& m_Macros;
+            std::size_t m_Position;
+            std::uint32_t m_Depth;
+            bool m_Error;
+        };
+    }
+
+    ShaderPreprocessor::ShaderPreprocessor()
+    {
+    }
+
+    void ShaderPreprocessor::SetIncludeDirectory(const std::string& a_Directory)
+    {
+        m_IncludeDirectory = a_Directory;
+    }
+
+    bool ShaderPreprocessor::Process(const char* a_Source, const std::vector<std::string>& a_Definitions, std::string& a_Output)
+    {
+        m_Error.clear();
+        m_Macros.clear();
+        m_Included.clear();
+        m_Conditionals.clear();
+        m_Version.clear();
+        m_Body.clear();
+        a_Output.clear();
+
+        //What the driver would get without processing: the source with a #define line for every definition.
+        std::uint64_t inputBytes = a_Source != nullptr ? strlen(a_Source) : 0;
+        for (const auto& definition : a_Definitions)
+        {
+            inputBytes += definition.size() + 9;
+        }
+
+        bool success = a_Source != nullptr;
+        for (std::size_t i = 0; success && i < a_Definitions.size(); ++i)
+        {
+            success = Define(a_Definitions[i]);
+        }
+
+        success = success && ProcessText(ShaderBinaryCache::StripSource(a_Source), 0);
+        if (success && !m_Conditionals.empty())
+        {
+            m_Error = "Missing #endif.";
+            success = false;
+        }
+
+        if (!success)
+        {
+            ++m_Stats.failed;
+            return false;
+        }
+
+        //Only the definitions that are still used are passed on.
+        std::unordered_set<std::string> identifiers;
+        for (std::size_t i = 0; i < m_Body.size();)
+        {
+            if (!IsIdentifierChar(m_Body[i]))
+            {
+                ++i;
+                continue;
+            }
+
+            //Numbers are skipped the same way, but are never definitions.
+            std::size_t end = i;
+            while (end < m_Body.size() && IsIdentifierChar(m_Body[end]))
+            {
+                ++end;
+            }
+            if (IsIdentifierStart(m_Body[i]))
+            {
+                identifiers.insert(m_Body.substr(i, end - i));
+            }
+            i = end;
+        }
+
+        if (!m_Version.empty())
+        {
+            a_Output += m_Version;
+            a_Output += '\n';
+        }
+
+        std::unordered_set<std::string> emitted;
+        for (const auto& definition : a_Definitions)
+        {
+            const std::string trimmed = Trim(definition);
+            if (identifiers.find(ReadIdentifier(trimmed)) != identifiers.end() && emitted.insert(trimmed).second)
+            {
+                a_Output += "#define " + trimmed + "\n";
+            }
+        }
+        a_Output += m_Body;
+
+        ++m_Stats.processed;
+        m_Stats.inputBytes += inputBytes;
+        m_Stats.outputBytes += a_Output.size();
+        return true;
+    }
+
+    const std::string& ShaderPreprocessor::GetError() const
+    {
+        return m_Error;
+    }
+
+    const ShaderPreprocessorStats& ShaderPreprocessor::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    bool ShaderPreprocessor::ProcessText(const std::string& a_Text, std::uint32_t a_Depth)
+    {
+        std::size_t start = 0;
+        while (start < a_Text.size())
+        {
+            const std::size_t end = a_Text.find('\n', start);
+            const std::string line = a_Text.substr(start, end == std::string::npos ? std::string::npos : end - start);
+            start = end == std::string::npos ? a_Text.size() : end + 1;
+
+            if (line.empty())
+            {
+                continue;
+            }
+
+            if (line[0] != '#')
+            {
+                if (IsActive())
+                {
+                    m_Body += line;
+                    m_Body += '\n';
+                }
+                continue;
+            }
+
+            const std::string directive = Trim(line.substr(1));
+            const std::string name = ReadIdentifier(directive);
+            const std::string rest = Trim(directive.substr(name.size()));
+
+            //Conditionals are followed even in inactive blocks, so that their #endif is matched.
+            if (name == "ifdef" || name == "ifndef")
+            {
+                const bool parentActive = IsActive();
+                const bool defined = m_Macros.find(ReadIdentifier(rest)) != m_Macros.end();
+                const bool active = parentActive && (defined != (name == "ifndef"));
+                m_Conditionals.push_back({ parentActive, active, active, false });
+                continue;
+            }
+
+            if (name == "if")
+            {
+                const bool parentActive = IsActive();
+                bool result = false;
+                if (parentActive && !Evaluate(rest, result))
+                {
+                    return false;
+                }
+                m_Conditionals.push_back({ parentActive, result, result, false });
+                continue;
+            }
+
+            if (name == "elif" || name == "else" || name == "endif")
+            {
+                if (m_Conditionals.empty() || (name != "endif" && m_Conditionals.back().seenElse))
+                {
+                    m_Error = "#" + name + " without matching #if.";
+                    return false;
+                }
+
+                auto& conditional = m_Conditionals.back();
+                if (name == "endif")
+                {
+                    m_Conditionals.pop_back();
+                }
+                else if (name == "else")
+                {
+                    conditional.active = conditional.parentActive && !conditional.taken;
+                    conditional.taken = true;
+                    conditional.seenElse = true;
+                }
+                else
+                {
+                    bool result = false;
+                    if (conditional.parentActive && !conditional.taken && !Evaluate(rest, result))
+                    {
+                        return false;
+                    }
+                    conditional.active = result;
+                    conditional.taken = conditional.taken || result;
+                }
+                continue;
+            }
+
+            if (!IsActive())
+            {
+                continue;
+            }
+
+            if (name == "version")
+            {
+                //Only the first one counts, the driver would refuse a second one anyway.
+                if (m_Version.empty())
+                {
+                    m_Version = line;
+                }
+            }
+            else if (name == "include")
+            {
+                if (rest.size() < 2 || !((rest.front() == '"' && rest.back() == '"') || (rest.front() == '<' && rest.back() == '>')))
+                {
+                    m_Error = "Invalid #include: " + rest;
+                    return false;
+                }
+
+                const std::string file = rest.substr(1, rest.size() - 2);
+                if (!m_Included.insert(file).second)
+                {
+                    continue;
+                }
+
+                FileReader reader(m_IncludeDirectory + file);
+                if (a_Depth >= MAX_DEPTH || !reader.Open())
+                {
+                    m_Error = "Could not include " + file + ".";
+                    return false;
+                }
+
+                const auto source = reader.ToArray();
+                const std::size_t conditionals = m_Conditionals.size();
+                if (!ProcessText(ShaderBinaryCache::StripSource(source.get()), a_Depth + 1))
+                {
+                    return false;
+                }
+
+                if (m_Conditionals.size() != conditionals)
+                {
+                    m_Error = "Conditionals in " + file + " are not closed.";
+                    return false;
+                }
+            }
+            else
+            {
+                //Keep the macros up to date for the conditionals that follow. The line itself is still needed by the driver.
+                if (name == "define" && !Define(rest))
+                {
+                    return false;
+                }
+                if (name == "undef")
+                {
+                    m_Macros.erase(ReadIdentifier(rest));
+                }
+
+                m_Body += line;
+                m_Body += '\n';
+            }
+        }
+
+        return true;
+    }
+
+    bool ShaderPreprocessor::IsActive() const
+    {
+        return m_Conditionals.empty() || m_Conditionals.back().active;
+    }
+
+    bool ShaderPreprocessor::Define(const std::string& a_Definition)
+    {
+        const std::string trimmed = Trim(a_Definition);
+        const std::string name = ReadIdentifier(trimmed);
+        if (name.empty() || !IsIdentifierStart(name[0]))
+        {
+            m_Error = "Invalid definition: " + a_Definition;
+            return false;
+        }
+
+        //Function-like macros can not be used in conditionals, so only their name is kept.
+        m_Macros[name] = trimmed.size() > name.size() && trimmed[name.size()] == '(' ? std::string() : Trim(trimmed.substr(name.size()));
+        return true;
+    }
+
+    bool ShaderPreprocessor::Evaluate(const std::string& a_Expression, bool& a_Result)
+    {
+        std::vector<std::string> tokens;
+        long long value = 0;
+        if (!Tokenize(a_Expression, tokens) || !ExpressionParser(tokens, m_Macros, 0).Parse(value))
+        {
+            m_Error = "Could not evaluate #if " + a_Expression;
+            return false;
+        }
+
+        a_Result = value != 0;
+        return true;
+    }
+}
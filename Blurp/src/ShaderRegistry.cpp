@@ -0,0 +1,224 @@
+#include "ShaderRegistry.h"
+
+#include <cassert>
+
+#include "Settings.h"
+#include "ShaderBinaryCache.h"
+
+namespace blurp
+{
+    ShaderRegistry::ShaderRegistry(std::uint32_t a_MaxPrograms) : m_MaxPrograms(a_MaxPrograms), m_Frame(0)
+    {
+    }
+
+    void ShaderRegistry::SetBudget(std::uint32_t a_MaxPrograms)
+    {
+        m_MaxPrograms = a_MaxPrograms;
+        Evict();
+    }
+
+    std::uint32_t ShaderRegistry::GetBudget() const
+    {
+        return m_MaxPrograms;
+    }
+
+    void ShaderRegistry::AddReference(std::uint64_t a_SourceId)
+    {
+        ++m_References[a_SourceId];
+    }
+
+    void ShaderRegistry::RemoveReference(std::uint64_t a_SourceId)
+    {
+        const auto found = m_References.find(a_SourceId);
+        assert(found != m_References.end() && found->second > 0 && "Removing a reference to a shader source that was never referenced!");
+
+        if (--found->second > 0)
+        {
+            return;
+        }
+        m_References.erase(found);
+
+        //Nothing can request these variants anymore.
+        for (auto itr = m_Entries.begin(); itr != m_Entries.end();)
+        {
+            if (itr->first.source == a_SourceId)
+            {
+                m_UseOrder.erase(itr->second.use);
+                itr = m_Entries.erase(itr);
+                ++m_Stats.released;
+            }
+            else
+            {
+                ++itr;
+            }
+        }
+    }
+
+    std::uint32_t ShaderRegistry::GetReferences(std::uint64_t a_SourceId) const
+    {
+        const auto found = m_References.find(a_SourceId);
+        return found != m_References.end() ? found->second : 0;
+    }
+
+    std::shared_ptr<Shader> ShaderRegistry::Find(std::uint64_t a_SourceId, std::uint64_t a_Mask, std::uint64_t a_DefinitionsId)
+    {
+        const auto found = m_Entries.find(Key{ a_SourceId, a_Mask, a_DefinitionsId });
+        if (found == m_Entries.end())
+        {
+            ++m_Stats.misses;
+            return nullptr;
+        }
+
+        ++m_Stats.hits;
+        Touch(found->second);
+        return found->second.shader;
+    }
+
+    bool ShaderRegistry::Contains(std::uint64_t a_SourceId, std::uint64_t a_Mask, std::uint64_t a_DefinitionsId) const
+    {
+        return m_Entries.find(Key{ a_SourceId, a_Mask, a_DefinitionsId }) != m_Entries.end();
+    }
+
+    void ShaderRegistry::GetMasks(std::uint64_t a_SourceId, std::vector<std::uint64_t>& a_Masks, std::uint64_t a_DefinitionsId) const
+    {
+        for (const auto& entry : m_Entries)
+        {
+            if (entry.first.source == a_SourceId && entry.first.definitions == a_DefinitionsId)
+            {
+                a_Masks.push_back(entry.first.mask);
+            }
+        }
+    }
+
+    void ShaderRegistry::Insert(std::uint64_t a_SourceId, std::uint64_t a_Mask, const std::shared_ptr<Shader>& a_Shader, std::uint64_t a_DefinitionsId)
+    {
+        assert(a_Shader != nullptr && "Shader cannot be nullptr!");
+
+        const Key key{ a_SourceId, a_Mask, a_DefinitionsId };
+        auto found = m_Entries.find(key);
+        if (found == m_Entries.end())
+        {
+            m_UseOrder.push_front(key);
+            found = m_Entries.emplace(key, Entry{ nullptr, m_Frame, m_UseOrder.begin() }).first;
+        }
+
+        found->second.shader = a_Shader;
+        Touch(found->second);
+        Evict();
+    }
+
+    std::shared_ptr<Shader> ShaderRegistry::FindShared(std::uint64_t a_SourceHash)
+    {
+        const auto found = m_Shared.find(a_SourceHash);
+        if (found == m_Shared.end())
+        {
+            return nullptr;
+        }
+
+        auto shader = found->second.lock();
+        if (shader == nullptr)
+        {
+            m_Shared.erase(found);
+            return nullptr;
+        }
+
+        ++m_Stats.shared;
+        return shader;
+    }
+
+    void ShaderRegistry::Share(std::uint64_t a_SourceHash, const std::shared_ptr<Shader>& a_Shader)
+    {
+        assert(a_Shader != nullptr && "Shader cannot be nullptr!");
+        m_Shared[a_SourceHash] = a_Shader;
+    }
+
+    std::uint32_t ShaderRegistry::Evict()
+    {
+        if (m_MaxPrograms == 0)
+        {
+            return 0;
+        }
+
+        std::uint32_t evicted = 0;
+        while (m_Entries.size() > m_MaxPrograms)
+        {
+            //The list is sorted by use, so when the oldest entry was used this frame all of them were.
+            const auto found = m_Entries.find(m_UseOrder.back());
+            assert(found != m_Entries.end() && "Shader registry use order is out of sync!");
+            if (found->second.lastFrame == m_Frame)
+            {
+                ++m_Stats.overBudget;
+                break;
+            }
+
+            m_UseOrder.pop_back();
+            m_Entries.erase(found);
+            ++m_Stats.evictions;
+            ++evicted;
+        }
+
+        return evicted;
+    }
+
+    void ShaderRegistry::NextFrame()
+    {
+        ++m_Frame;
+    }
+
+    std::uint64_t ShaderRegistry::GetFrame() const
+    {
+        return m_Frame;
+    }
+
+    std::size_t ShaderRegistry::GetProgramCount() const
+    {
+        return m_Entries.size();
+    }
+
+    const ShaderRegistryStats& ShaderRegistry::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    void ShaderRegistry::Clear()
+    {
+        m_Entries.clear();
+        m_UseOrder.clear();
+        m_Shared.clear();
+    }
+
+    std::uint64_t ShaderRegistry::CalculateSourceId(const ShaderSettings& a_Settings, const std::vector<std::string>& a_Definitions)
+    {
+        //The mask definitions are hashed after the ones that every variant uses, so moving a definition between the two gives a new id.
+        ShaderSettings settings = a_Settings;
+        settings.preprocessorDefinitions.push_back("#MASK");
+        settings.preprocessorDefinitions.insert(settings.preprocessorDefinitions.end(), a_Definitions.begin(), a_Definitions.end());
+        return ShaderBinaryCache::CalculateKey(settings, std::string());
+    }
+
+    std::uint64_t ShaderRegistry::CalculateDefinitionsId(const std::vector<std::string>& a_Definitions)
+    {
+        if (a_Definitions.empty())
+        {
+            return 0;
+        }
+
+        //FNV-1a. Every definition ends with a separator so that moving characters between definitions gives a new id.
+        std::uint64_t hash = 14695981039346656037ull;
+        for (const auto& definition : a_Definitions)
+        {
+            for (const char c : definition)
+            {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+            }
+            hash = (hash ^ 0xFFu) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void ShaderRegistry::Touch(Entry& a_Entry)
+    {
+        a_Entry.lastFrame = m_Frame;
+        m_UseOrder.splice(m_UseOrder.begin(), m_UseOrder, a_Entry.use);
+    }
+}
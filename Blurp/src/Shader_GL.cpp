@@ -2,6 +2,9 @@
 
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
+
+#include "BlurpEngine.h"
 
 namespace blurp
 {
@@ -10,7 +13,101 @@ namespace blurp
         return m_Program;
     }
 
+    bool Shader_GL::IsReady()
+    {
+        if(!m_Deferred)
+        {
+            return true;
+        }
+
+        //Asking for the link status would wait for the driver, so only the completion status is checked.
+        GLint completed = GL_FALSE;
+        glGetProgramiv(m_Program, GL_COMPLETION_STATUS_KHR, &completed);
+        if(completed == GL_FALSE)
+        {
+            return false;
+        }
+
+        FinishProgram();
+        return true;
+    }
+
     bool Shader_GL::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //Compile in the background when asked to and when the driver can.
+        m_Deferred = m_Settings.compileAsynchronously && (GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile);
+
+        //Load a stored program binary when there is one, and store the binary when the program is compiled.
+        bool success;
+        ShaderBinaryCache* binaryCache = a_BlurpEngine.GetShaderBinaryCache();
+        if(binaryCache != nullptr)
+        {
+            m_BinaryCache = binaryCache;
+            m_BinaryKey = binaryCache->GetKey(m_Settings);
+            success = binaryCache->LoadOrCompile(m_Settings, *this);
+        }
+        else
+        {
+            success = CompileProgram();
+        }
+
+        //The driver copied the source of every stage, also when it compiles them in the background.
+        ReleaseSources();
+        return success;
+    }
+
+    bool Shader_GL::LoadBinary(std::uint32_t a_Format, const std::vector<char>& a_Data)
+    {
+        m_Program = glCreateProgram();
+        glProgramBinary(m_Program, static_cast<GLenum>(a_Format), a_Data.data(), static_cast<GLsizei>(a_Data.size()));
+
+        //Drivers refuse binaries by failing the link status.
+        GLint success = 0;
+        glGetProgramiv(m_Program, GL_LINK_STATUS, &success);
+        if(!success)
+        {
+            glDeleteProgram(m_Program);
+            m_Program = 0;
+            return false;
+        }
+
+        //Binaries are loaded right away, so there is nothing left to do in the background.
+        m_Deferred = false;
+        return true;
+    }
+
+    bool Shader_GL::Compile(std::uint32_t& a_Format, std::vector<char>& a_Data)
+    {
+        if(!CompileProgram())
+        {
+            return false;
+        }
+
+        //The binary of a program compiled in the background is stored by FinishProgram.
+        if(m_Deferred)
+        {
+            return true;
+        }
+
+        //Programs that did not link have no binary worth keeping.
+        GLint linked = 0;
+        GLint length = 0;
+        glGetProgramiv(m_Program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(m_Program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(linked && length > 0)
+        {
+            GLenum format = 0;
+            GLsizei written = 0;
+            a_Data.resize(static_cast<std::size_t>(length));
+            glGetProgramBinary(m_Program, length, &written, &format, a_Data.data());
+            a_Data.resize(static_cast<std::size_t>(written));
+            a_Format = static_cast<std::uint32_t>(format);
+        }
+
+        return true;
+    }
+
+    bool Shader_GL::CompileProgram()
     {
         //Append the #define tag to each preprocessor definition.
         std::vector<std::string> defines;
@@ -70,7 +167,7 @@ namespace blurp
             }
             else
             {
-                throw std::exception("Vertex shader is always required!");
+                throw std::runtime_error("Vertex shader is always required!");
             }
 
             //Fragment shader
@@ -187,8 +284,22 @@ namespace blurp
             if (hasTessDomain) glAttachShader(m_Program, tess_domain);
             if (hasGeometry) glAttachShader(m_Program, geometry);
 
+            glProgramParameteri(m_Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
             glLinkProgram(m_Program);
 
+            //Results are checked once the driver is done.
+            if(m_Deferred)
+            {
+                for(const GLuint stage : { vertex, fragment, tess_hull, tess_domain, geometry })
+                {
+                    if(stage != 0)
+                    {
+                        m_DeferredStages.push_back(stage);
+                    }
+                }
+                return true;
+            }
+
             // check for linking errors
             int success;
             char infoLog[512];
@@ -211,7 +322,7 @@ namespace blurp
         {
             if(m_Settings.computeShaderSource == nullptr)
             {
-                throw std::exception("Error: trying to make compute shader with null source.");
+                throw std::runtime_error("Error: trying to make compute shader with null source.");
                 return false;
             }
 
@@ -239,8 +350,16 @@ namespace blurp
 
             m_Program = glCreateProgram();
             glAttachShader(m_Program, compute);
+            glProgramParameteri(m_Program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
             glLinkProgram(m_Program);
 
+            //Results are checked once the driver is done.
+            if(m_Deferred)
+            {
+                m_DeferredStages.push_back(compute);
+                return true;
+            }
+
             // check for linking errors
             int success;
             char infoLog[512];
@@ -258,8 +377,55 @@ namespace blurp
         return true;
     }
 
+    void Shader_GL::FinishProgram()
+    {
+        m_Deferred = false;
+
+        char infoLog[512];
+        for(const GLuint stage : m_DeferredStages)
+        {
+            GLint compiled = 0;
+            glGetShaderiv(stage, GL_COMPILE_STATUS, &compiled);
+            if(!compiled)
+            {
+                glGetShaderInfoLog(stage, 512, NULL, infoLog);
+                std::cout << "Error Could not compile shader: \n" << infoLog << std::endl;
+            }
+            glDeleteShader(stage);
+        }
+        m_DeferredStages.clear();
+
+        GLint linked = 0;
+        glGetProgramiv(m_Program, GL_LINK_STATUS, &linked);
+        if(!linked)
+        {
+            glGetProgramInfoLog(m_Program, 512, NULL, infoLog);
+            std::cout << "Error could not link shaders.\n" << infoLog << std::endl;
+            return;
+        }
+
+        //Store the binary now that it exists.
+        GLint length = 0;
+        glGetProgramiv(m_Program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(m_BinaryCache != nullptr && length > 0)
+        {
+            GLenum format = 0;
+            GLsizei written = 0;
+            std::vector<char> data(static_cast<std::size_t>(length));
+            glGetProgramBinary(m_Program, length, &written, &format, data.data());
+            data.resize(static_cast<std::size_t>(written));
+            m_BinaryCache->Store(m_BinaryKey, static_cast<std::uint32_t>(format), data);
+        }
+    }
+
     bool Shader_GL::OnDestroy(BlurpEngine& a_BlurpEngine)
     {
+        for(const GLuint stage : m_DeferredStages)
+        {
+            glDeleteShader(stage);
+        }
+        m_DeferredStages.clear();
+
         glDeleteProgram(m_Program);
         return true;
     }
@@ -267,6 +433,12 @@ namespace blurp
     bool Shader_GL::CompileShader(GLuint a_ShaderId, const char** a_Src, std::size_t a_Size)
     {
         glCompileShader(a_ShaderId);
+
+        //The result is checked by FinishProgram, as asking for it here would wait for the driver.
+        if(m_Deferred)
+        {
+            return true;
+        }
         int success;
         char infoLog[512];
         glGetShaderiv(a_ShaderId, GL_COMPILE_STATUS, &success);
@@ -0,0 +1,32 @@
+#include "null/Shader_Null.h"
+
+#include <cstring>
+
+namespace blurp
+{
+    std::size_t Shader_Null::GetSourceSize() const
+    {
+        return m_SourceSize;
+    }
+
+    bool Shader_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //The source pointers are only valid while the shader is created.
+        const char* sources[] = { m_Settings.vertexShaderSource, m_Settings.tessellationHullShaderSource, m_Settings.tessellationDomainShaderSource, m_Settings.geometryShaderSource, m_Settings.fragmentShaderSource, m_Settings.computeShaderSource };
+        for (const char* source : sources)
+        {
+            if (source != nullptr)
+            {
+                m_SourceSize += std::strlen(source);
+            }
+        }
+
+        ReleaseSources();
+        return true;
+    }
+
+    bool Shader_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        return true;
+    }
+}
@@ -0,0 +1,281 @@
+#include "ShadowCasterCuller.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+#include "Culling.h"
+#include "Light.h"
+#include "LightClusterBuilder.h"
+
+namespace blurp
+{
+    //Every combination of the six cube faces gets its own list.
+    constexpr std::size_t FACE_LISTS = 64;
+
+    namespace
+    {
+        //Test a bounding sphere against the planes of a cascade volume, the same way CullInstances does.
+        bool IsInVolume(const Frustum& a_Volume, const glm::vec4& a_Center, float a_Radius)
+        {
+            for (const auto& plane : a_Volume.planes)
+            {
+                if (plane.x * a_Center.x + plane.y * a_Center.y + plane.z * a_Center.z + plane.w < -a_Radius)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    ShadowCasterCuller::ShadowCasterCuller() : m_LightCutoff(0.01f), m_UsedCascadeLists(0)
+    {
+    }
+
+    void ShadowCasterCuller::SetCamera(const std::shared_ptr<Camera>& a_Camera)
+    {
+        m_Camera = a_Camera;
+    }
+
+    void ShadowCasterCuller::SetShadowData(const ShadowData& a_Data)
+    {
+        assert(a_Data.directional.cascadeDistances.size() >= a_Data.directional.numCascades && "The amount of shadow cascade distances has to be equal to the amount of cascades!");
+        assert(a_Data.directional.numCascades <= 32 && "Cascade masks can not hold more than 32 cascades!");
+        m_ShadowData = a_Data;
+    }
+
+    void ShadowCasterCuller::SetLightCutoff(float a_Cutoff)
+    {
+        assert(a_Cutoff > 0.f && "Light cutoff has to be larger than 0!");
+        m_LightCutoff = a_Cutoff;
+    }
+
+    float ShadowCasterCuller::GetLightRange(std::uint32_t a_Light) const
+    {
+        assert(a_Light < m_LightRanges.size() && "Positional light index out of range!");
+        return m_LightRanges[a_Light];
+    }
+
+    void ShadowCasterCuller::Reset()
+    {
+        m_CascadeVolumes.clear();
+        m_LightPositions.clear();
+        m_LightRanges.clear();
+        m_Lists.clear();
+        m_UsedCascadeLists = 0;
+        m_Results.clear();
+        m_Stats = ShadowCullingStats();
+    }
+
+    void ShadowCasterCuller::AddLight(const std::shared_ptr<Light>& a_Light)
+    {
+        assert(a_Light && "Light cannot be nullptr!");
+        assert(m_Camera && "A camera is required to calculate the light volumes!");
+
+        const auto numCascades = m_ShadowData.directional.numCascades;
+
+        //Positional shadow maps reach up to the camera far plane, so lights that reach further are cut off there.
+        const float farPlane = m_Camera->GetSettings().farPlane;
+        const float range = std::min(LightClusterBuilder::GetLightRange(glm::vec4(a_Light->GetColor(), a_Light->GetIntensity()), m_LightCutoff), farPlane);
+
+        switch (a_Light->GetType())
+        {
+        case LightType::LIGHT_POINT:
+            m_LightPositions.push_back(std::static_pointer_cast<PointLight>(a_Light)->GetPosition());
+            m_LightRanges.push_back(range);
+            break;
+        case LightType::LIGHT_SPOT:
+            m_LightPositions.push_back(std::static_pointer_cast<SpotLight>(a_Light)->GetPosition());
+            m_LightRanges.push_back(range);
+            break;
+        case LightType::LIGHT_DIRECTIONAL:
+        {
+            assert(m_CascadeVolumes.size() / numCascades < MAX_SHADOW_LIGHTS && "Max number of directional lights exceeded!");
+
+            std::vector<glm::mat4> matrices(numCascades);
+            std::vector<glm::vec4> clipDepths(numCascades);
+            RenderPass_ShadowMap::CalculateCascades(*m_Camera, std::static_pointer_cast<DirectionalLight>(a_Light)->GetDirection(), m_ShadowData, matrices.data(), clipDepths.data());
+
+            for (const auto& matrix : matrices)
+            {
+                m_CascadeVolumes.push_back(ExtractFrustum(matrix));
+            }
+        }
+            break;
+        default:
+            throw std::runtime_error("Light type cannot generate a shadow!");
+            break;
+        }
+
+        assert(m_LightPositions.size() <= MAX_SHADOW_LIGHTS && "Max positional light count for shadow mapping exceeded!");
+
+        //Every positional light gets one list per face mask. Lists for the cascades are made while culling, one for every combination of cascades.
+        const std::size_t numLists = m_LightPositions.size() * FACE_LISTS;
+        for (std::size_t list = m_Lists.size(); list < numLists; ++list)
+        {
+            m_Lists.emplace_back();
+            LightIndexData& lights = m_Lists.back().lights;
+            lights.posLights.set(list / FACE_LISTS);
+            lights.faceMask = static_cast<std::uint32_t>(list % FACE_LISTS);
+            lights.cascadeMask = 0;
+        }
+
+        m_Stats.cascadeCasters.resize(m_CascadeVolumes.size(), 0);
+        m_Stats.directionalCasters.resize(numCascades == 0 ? 0 : m_CascadeVolumes.size() / numCascades, 0);
+        m_Stats.positionalCasters.resize(m_LightPositions.size(), 0);
+        m_Stats.faceCasters.resize(m_LightPositions.size() * 6, 0);
+    }
+
+    const std::vector<const ShadowCasterList*>& ShadowCasterCuller::Cull(const MeshBounds& a_Bounds, const glm::mat4* a_Transforms, std::uint32_t a_Count)
+    {
+        m_Results.clear();
+        m_Stats.instancesTested += a_Count;
+
+        //Every instance is tested against all cascades of a directional light, and goes into the list for the combination of cascades it is in.
+        //This way an instance is uploaded and drawn once per directional light, and the shadow pass draws it into each of those cascades.
+        const std::uint32_t numCascades = m_ShadowData.directional.numCascades;
+        const std::size_t numDirLights = m_Stats.directionalCasters.size();
+        m_UsedCascadeLists = 0;
+        for (std::size_t light = 0; light < numDirLights; ++light)
+        {
+            const Frustum* volumes = &m_CascadeVolumes[light * numCascades];
+            const std::size_t firstList = m_UsedCascadeLists;
+            ShadowCasterList* list = nullptr;
+
+            const auto lengthSquared = [](const glm::vec4& a_Column) { return a_Column.x * a_Column.x + a_Column.y * a_Column.y + a_Column.z * a_Column.z; };
+            for (std::uint32_t i = 0; i < a_Count; ++i)
+            {
+                const glm::mat4& transform = a_Transforms[i];
+                const glm::vec4 center = transform[0] * a_Bounds.center.x + transform[1] * a_Bounds.center.y + transform[2] * a_Bounds.center.z + transform[3];
+                const float radius = std::sqrt(std::max(std::max(lengthSquared(transform[0]), lengthSquared(transform[1])), lengthSquared(transform[2]))) * a_Bounds.radius;
+
+                std::uint32_t cascadeMask = 0;
+                for (std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+                {
+                    if (IsInVolume(volumes[cascade], center, radius))
+                    {
+                        cascadeMask |= 1u << cascade;
+                        ++m_Stats.cascadeCasters[light * numCascades + cascade];
+                    }
+                }
+
+                if (cascadeMask == 0)
+                {
+                    continue;
+                }
+
+                //Neighbouring instances are often in the same cascades, so the previous list is tried first.
+                if (list == nullptr || list->lights.cascadeMask != cascadeMask)
+                {
+                    list = nullptr;
+                    for (std::size_t used = firstList; used < m_UsedCascadeLists && list == nullptr; ++used)
+                    {
+                        list = m_CascadeLists[used].lights.cascadeMask == cascadeMask ? &m_CascadeLists[used] : nullptr;
+                    }
+
+                    //Lists are kept between calls so that their memory is reused.
+                    if (list == nullptr)
+                    {
+                        if (m_UsedCascadeLists == m_CascadeLists.size())
+                        {
+                            m_CascadeLists.emplace_back();
+                        }
+                        list = &m_CascadeLists[m_UsedCascadeLists++];
+                        list->lights = LightIndexData();
+                        list->lights.dirLights.set(light);
+                        list->lights.cascadeMask = cascadeMask;
+                        list->transforms.clear();
+                    }
+                }
+
+                list->transforms.push_back(transform);
+                ++m_Stats.directionalCasters[light];
+            }
+        }
+
+        for (std::size_t list = 0; list < m_UsedCascadeLists; ++list)
+        {
+            m_Results.push_back(&m_CascadeLists[list]);
+        }
+
+        const float nearPlane = m_Camera != nullptr ? m_Camera->GetSettings().nearPlane : 0.f;
+
+        for (std::size_t light = 0; light < m_LightPositions.size(); ++light)
+        {
+            const std::size_t firstList = light * FACE_LISTS;
+
+            //Bit N is set when the list for face mask N has instances.
+            std::uint64_t usedMasks = 0;
+
+            //Instances further away than the light reaches can not shadow anything it lights.
+            const glm::vec3& position = m_LightPositions[light];
+            const float range = m_LightRanges[light];
+            for (std::uint32_t i = 0; i < a_Count; ++i)
+            {
+                const glm::mat4& transform = a_Transforms[i];
+                const glm::vec3 center = glm::vec3(transform * glm::vec4(a_Bounds.center, 1.f));
+                const float scale = std::max(std::max(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1]))), glm::length(glm::vec3(transform[2])));
+                const float radius = a_Bounds.radius * scale;
+                const float reach = range + radius;
+
+                const glm::vec3 offset = center - position;
+                if (glm::dot(offset, offset) > reach * reach)
+                {
+                    continue;
+                }
+
+                const std::uint32_t faceMask = RenderPass_ShadowMap::CalculateCubeFaceMask(position, nearPlane, range, center, radius);
+                if (faceMask == 0)
+                {
+                    continue;
+                }
+
+                //Start the list over the first time it is used in this call.
+                auto& list = m_Lists[firstList + faceMask];
+                if ((usedMasks & (1ull << faceMask)) == 0)
+                {
+                    list.transforms.clear();
+                    usedMasks |= 1ull << faceMask;
+                }
+                list.transforms.push_back(transform);
+
+                ++m_Stats.positionalCasters[light];
+                for (std::uint32_t face = 0; face < 6; ++face)
+                {
+                    if ((faceMask & (1u << face)) != 0)
+                    {
+                        ++m_Stats.faceCasters[light * 6 + face];
+                        ++m_Stats.faceInstances;
+                    }
+                    else
+                    {
+                        ++m_Stats.skippedFaceInstances;
+                    }
+                }
+            }
+
+            for (std::uint32_t faceMask = 1; faceMask < FACE_LISTS; ++faceMask)
+            {
+                if ((usedMasks & (1ull << faceMask)) != 0)
+                {
+                    m_Results.push_back(&m_Lists[firstList + faceMask]);
+                }
+            }
+        }
+
+        return m_Results;
+    }
+
+    const Frustum& ShadowCasterCuller::GetCascadeVolume(std::uint32_t a_Light, std::uint32_t a_Cascade) const
+    {
+        assert(a_Cascade < m_ShadowData.directional.numCascades && (a_Light * m_ShadowData.directional.numCascades) + a_Cascade < m_CascadeVolumes.size() && "Cascade volume out of range!");
+        return m_CascadeVolumes[(a_Light * m_ShadowData.directional.numCascades) + a_Cascade];
+    }
+
+    const ShadowCullingStats& ShadowCasterCuller::GetStats() const
+    {
+        return m_Stats;
+    }
+}
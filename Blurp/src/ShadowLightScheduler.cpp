@@ -0,0 +1,220 @@
+#include "ShadowLightScheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "Camera.h"
+#include "Light.h"
+#include "LightClusterBuilder.h"
+#include "RenderPass_ShadowMap.h"
+
+namespace blurp
+{
+    ShadowLightScheduler::ShadowLightScheduler()
+    {
+        m_Slots.resize(m_Settings.slots);
+    }
+
+    void ShadowLightScheduler::SetSettings(const ShadowSchedulerSettings& a_Settings)
+    {
+        assert(a_Settings.slots <= MAX_SHADOW_LIGHTS && "Shadow pass can not render that many positional lights!");
+        assert(a_Settings.hysteresis >= 0.f && "Hysteresis can not be negative!");
+        assert(a_Settings.lightCutoff > 0.f && "Light cutoff has to be larger than 0!");
+        m_Settings = a_Settings;
+    }
+
+    const ShadowSchedulerSettings& ShadowLightScheduler::GetSettings() const
+    {
+        return m_Settings;
+    }
+
+    void ShadowLightScheduler::Schedule(const Camera& a_Camera, const LightUploadData& a_Lights)
+    {
+        const Frustum frustum = a_Camera.GetFrustum();
+        const std::uint32_t pointCount = a_Lights.point.lights != nullptr ? a_Lights.point.count : 0;
+        const std::uint32_t spotCount = a_Lights.spot.lights != nullptr ? a_Lights.spot.count : 0;
+
+        const std::uint64_t totalSlotChanges = m_Stats.totalSlotChanges;
+        m_Stats = ShadowSchedulerStats();
+        m_Stats.totalSlotChanges = totalSlotChanges;
+        m_Stats.lights = pointCount + spotCount;
+
+        //Score every light. Lights that do not reach the view are left out.
+        m_Candidates.clear();
+        const auto addCandidate = [&](Light* a_Light, std::uint32_t a_Order, const glm::vec3& a_Position, const glm::vec4& a_ColorIntensity, float a_Spread)
+        {
+            assert(a_Light != nullptr && "Light can't be nullptr.");
+            a_Light->SetShadowMapIndex(-1);
+
+            float score = CalculateScore(a_Camera, frustum, a_Position, a_ColorIntensity, a_Spread, m_Settings);
+            if(score <= 0.f)
+            {
+                return;
+            }
+
+            const std::int32_t previousSlot = FindSlot(a_Light);
+            if(previousSlot >= 0)
+            {
+                score *= 1.f + m_Settings.hysteresis;
+            }
+
+            m_Candidates.push_back(Candidate{ a_Light, score, a_Order, previousSlot });
+        };
+
+        for(std::uint32_t i = 0; i < pointCount; ++i)
+        {
+            const auto data = a_Lights.point.lights[i]->GetData();
+            addCandidate(a_Lights.point.lights[i].get(), i, data.positionShadowMapIndex, data.colorIntensity, 1.f);
+        }
+
+        for(std::uint32_t i = 0; i < spotCount; ++i)
+        {
+            //Wide spot lights shine on as much as a point light. Narrow ones affect less of the screen.
+            const auto data = a_Lights.spot.lights[i]->GetData();
+            const float spread = std::sin(std::clamp(data.directionAngle.w, 0.f, 1.5707963f));
+            addCandidate(a_Lights.spot.lights[i].get(), pointCount + i, data.positionShadowMapIndex, data.colorIntensity, spread);
+        }
+
+        m_Stats.visible = static_cast<std::uint32_t>(m_Candidates.size());
+
+        //The highest scores win. Equal scores are ordered by the order the lights were passed in.
+        const std::size_t numSelected = std::min<std::size_t>(m_Settings.slots, m_Candidates.size());
+        std::partial_sort(m_Candidates.begin(), m_Candidates.begin() + numSelected, m_Candidates.end(), [](const Candidate& a_Left, const Candidate& a_Right)
+        {
+            return a_Left.score > a_Right.score || (a_Left.score == a_Right.score && a_Left.order < a_Right.order);
+        });
+
+        //Selected lights keep the slot they already had. The others fill the free slots from the front.
+        std::vector<std::shared_ptr<Light>> slots(m_Settings.slots);
+        const auto getShared = [&](std::uint32_t a_Order) -> std::shared_ptr<Light>
+        {
+            if(a_Order < pointCount)
+            {
+                return a_Lights.point.lights[a_Order];
+            }
+            return a_Lights.spot.lights[a_Order - pointCount];
+        };
+
+        for(std::size_t i = 0; i < numSelected; ++i)
+        {
+            const auto& candidate = m_Candidates[i];
+            if(candidate.previousSlot >= 0 && candidate.previousSlot < static_cast<std::int32_t>(slots.size()))
+            {
+                slots[candidate.previousSlot] = getShared(candidate.order);
+            }
+        }
+
+        std::size_t freeSlot = 0;
+        for(std::size_t i = 0; i < numSelected; ++i)
+        {
+            const auto& candidate = m_Candidates[i];
+            if(candidate.previousSlot >= 0 && candidate.previousSlot < static_cast<std::int32_t>(slots.size()))
+            {
+                continue;
+            }
+
+            while(slots[freeSlot] != nullptr)
+            {
+                ++freeSlot;
+            }
+            slots[freeSlot] = getShared(candidate.order);
+        }
+
+        //Count the slots that changed owner, and the lights that lost their slot.
+        const std::size_t numCompared = std::max(slots.size(), m_Slots.size());
+        for(std::size_t slot = 0; slot < numCompared; ++slot)
+        {
+            const Light* previous = slot < m_Slots.size() ? m_Slots[slot].get() : nullptr;
+            const Light* current = slot < slots.size() ? slots[slot].get() : nullptr;
+            if(previous != current)
+            {
+                ++m_Stats.slotChanges;
+            }
+
+            if(previous != nullptr && std::none_of(slots.begin(), slots.end(), [&](const std::shared_ptr<Light>& a_Light) { return a_Light.get() == previous; }))
+            {
+                ++m_Stats.evicted;
+
+                //Lights that were removed from the scene are not in the input, so they are reset here.
+                m_Slots[slot]->SetShadowMapIndex(-1);
+            }
+        }
+
+        for(std::size_t slot = 0; slot < slots.size(); ++slot)
+        {
+            if(slots[slot] != nullptr)
+            {
+                slots[slot]->SetShadowMapIndex(static_cast<std::int32_t>(slot));
+                ++m_Stats.assigned;
+            }
+        }
+
+        m_Stats.totalSlotChanges += m_Stats.slotChanges;
+        m_Slots = std::move(slots);
+    }
+
+    const std::vector<std::shared_ptr<Light>>& ShadowLightScheduler::GetSlots() const
+    {
+        return m_Slots;
+    }
+
+    void ShadowLightScheduler::Clear()
+    {
+        for(auto& light : m_Slots)
+        {
+            if(light != nullptr)
+            {
+                light->SetShadowMapIndex(-1);
+                light = nullptr;
+            }
+        }
+    }
+
+    const ShadowSchedulerStats& ShadowLightScheduler::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    float ShadowLightScheduler::CalculateScore(const Camera& a_Camera, const Frustum& a_Frustum, const glm::vec3& a_Position, const glm::vec4& a_ColorIntensity, float a_Spread, const ShadowSchedulerSettings& a_Settings)
+    {
+        const float range = LightClusterBuilder::GetLightRange(a_ColorIntensity, a_Settings.lightCutoff);
+        if(range <= 0.f)
+        {
+            return 0.f;
+        }
+
+        //The sphere the light reaches has to touch the view.
+        for(const auto& plane : a_Frustum.planes)
+        {
+            if(glm::dot(glm::vec3(plane), a_Position) + plane.w < -range)
+            {
+                return 0.f;
+            }
+        }
+
+        //Part of the screen height covered by the sphere. The whole screen when the camera is inside of it.
+        const float distance = glm::distance(a_Camera.GetTransform().GetTranslation(), a_Position);
+        float coverage = 1.f;
+        if(distance > range)
+        {
+            const float tangent = range / std::sqrt(distance * distance - range * range);
+            coverage = std::min(tangent * a_Camera.GetProjectionMatrix()[1][1], 1.f);
+        }
+
+        const float brightness = std::max(std::max(a_ColorIntensity.x, a_ColorIntensity.y), a_ColorIntensity.z) * a_ColorIntensity.w;
+        return coverage * a_Spread * brightness / (1.f + distance * a_Settings.distanceWeight);
+    }
+
+    std::int32_t ShadowLightScheduler::FindSlot(const Light* a_Light) const
+    {
+        for(std::size_t slot = 0; slot < m_Slots.size(); ++slot)
+        {
+            if(m_Slots[slot].get() == a_Light)
+            {
+                return static_cast<std::int32_t>(slot);
+            }
+        }
+        return -1;
+    }
+}
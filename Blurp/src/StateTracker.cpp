@@ -0,0 +1,347 @@
+#include "StateTracker.h"
+
+namespace blurp
+{
+    StateTracker::StateTracker(StateTrackerBackend& a_Backend) : m_Backend(a_Backend)
+    {
+    }
+
+    void StateTracker::UseProgram(std::uint32_t a_Program)
+    {
+        if(!m_Program.Set(a_Program))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.UseProgram(a_Program);
+        Issue();
+    }
+
+    void StateTracker::BindVertexArray(std::uint32_t a_VertexArray)
+    {
+        if(!m_VertexArray.Set(a_VertexArray))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.BindVertexArray(a_VertexArray);
+        Issue();
+    }
+
+    void StateTracker::BindFramebuffer(std::uint32_t a_Framebuffer)
+    {
+        if(!m_Framebuffer.Set(a_Framebuffer))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.BindFramebuffer(a_Framebuffer);
+        Issue();
+    }
+
+    void StateTracker::BindTexture(std::uint32_t a_Unit, std::uint32_t a_Target, std::uint32_t a_Texture)
+    {
+        //Without tracking the caller would switch the active unit and then bind, so both count.
+        const std::uint64_t key = PairKey(a_Unit, a_Target);
+        const auto found = m_Textures.find(key);
+        if(found != m_Textures.end() && found->second == a_Texture)
+        {
+            Filter(2);
+            return;
+        }
+
+        if(m_ActiveUnit.Set(a_Unit))
+        {
+            m_Backend.ActiveTexture(a_Unit);
+            Issue();
+        }
+        else
+        {
+            Filter();
+        }
+
+        m_Backend.BindTexture(a_Target, a_Texture);
+        m_Textures[key] = a_Texture;
+        Issue();
+    }
+
+    void StateTracker::BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler)
+    {
+        const auto found = m_Samplers.find(a_Unit);
+        if(found != m_Samplers.end() && found->second == a_Sampler)
+        {
+            Filter();
+            return;
+        }
+
+        m_Backend.BindSampler(a_Unit, a_Sampler);
+        m_Samplers[a_Unit] = a_Sampler;
+        Issue();
+    }
+
+    void StateTracker::BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer)
+    {
+        const auto found = m_Buffers.find(a_Target);
+        if(found != m_Buffers.end() && found->second == a_Buffer)
+        {
+            Filter();
+            return;
+        }
+
+        m_Backend.BindBuffer(a_Target, a_Buffer);
+        m_Buffers[a_Target] = a_Buffer;
+        Issue();
+    }
+
+    void StateTracker::BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer)
+    {
+        //A size of -1 marks a binding of the whole buffer, which is not the same as any range.
+        const Values4 binding{ { a_Buffer, 0, -1, 0 } };
+        const std::uint64_t key = PairKey(a_Target, a_Index);
+        if(IsBound(a_Target, key, binding))
+        {
+            Filter();
+            return;
+        }
+
+        m_Backend.BindBufferBase(a_Target, a_Index, a_Buffer);
+        m_IndexedBuffers[key] = binding;
+        m_Buffers[a_Target] = a_Buffer;
+        Issue();
+    }
+
+    void StateTracker::BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size)
+    {
+        const Values4 binding{ { a_Buffer, a_Offset, a_Size, 0 } };
+        const std::uint64_t key = PairKey(a_Target, a_Index);
+        if(IsBound(a_Target, key, binding))
+        {
+            Filter();
+            return;
+        }
+
+        m_Backend.BindBufferRange(a_Target, a_Index, a_Buffer, a_Offset, a_Size);
+        m_IndexedBuffers[key] = binding;
+        m_Buffers[a_Target] = a_Buffer;
+        Issue();
+    }
+
+    void StateTracker::SetEnabled(std::uint32_t a_Capability, bool a_Enabled)
+    {
+        const auto found = m_Capabilities.find(a_Capability);
+        if(found != m_Capabilities.end() && found->second == a_Enabled)
+        {
+            Filter();
+            return;
+        }
+
+        m_Backend.SetEnabled(a_Capability, a_Enabled);
+        m_Capabilities[a_Capability] = a_Enabled;
+        Issue();
+    }
+
+    void StateTracker::SetDepthFunc(std::uint32_t a_Function)
+    {
+        if(!m_DepthFunc.Set(a_Function))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.DepthFunc(a_Function);
+        Issue();
+    }
+
+    void StateTracker::SetDepthMask(bool a_Write)
+    {
+        if(!m_DepthMask.Set(a_Write))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.DepthMask(a_Write);
+        Issue();
+    }
+
+    void StateTracker::SetCullFace(std::uint32_t a_Face)
+    {
+        if(!m_CullFace.Set(a_Face))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.CullFace(a_Face);
+        Issue();
+    }
+
+    void StateTracker::SetFrontFace(std::uint32_t a_WindingOrder)
+    {
+        if(!m_FrontFace.Set(a_WindingOrder))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.FrontFace(a_WindingOrder);
+        Issue();
+    }
+
+    void StateTracker::SetBlendFunc(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha)
+    {
+        if(!m_BlendFunc.Set(Values4{ { a_SrcRgb, a_DstRgb, a_SrcAlpha, a_DstAlpha } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.BlendFuncSeparate(a_SrcRgb, a_DstRgb, a_SrcAlpha, a_DstAlpha);
+        Issue();
+    }
+
+    void StateTracker::SetBlendEquation(std::uint32_t a_Rgb, std::uint32_t a_Alpha)
+    {
+        if(!m_BlendEquation.Set(Values4{ { a_Rgb, a_Alpha, 0, 0 } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.BlendEquationSeparate(a_Rgb, a_Alpha);
+        Issue();
+    }
+
+    void StateTracker::SetStencilFunc(StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask)
+    {
+        if(!m_StencilFunc[static_cast<int>(a_Face)].Set(Values4{ { a_Function, a_Reference, a_Mask, 0 } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.StencilFuncSeparate(a_Face, a_Function, a_Reference, a_Mask);
+        Issue();
+    }
+
+    void StateTracker::SetStencilOp(StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass)
+    {
+        if(!m_StencilOp[static_cast<int>(a_Face)].Set(Values4{ { a_StencilFail, a_DepthFail, a_Pass, 0 } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.StencilOpSeparate(a_Face, a_StencilFail, a_DepthFail, a_Pass);
+        Issue();
+    }
+
+    void StateTracker::SetStencilMask(std::uint32_t a_Mask)
+    {
+        if(!m_StencilMask.Set(a_Mask))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.StencilMask(a_Mask);
+        Issue();
+    }
+
+    void StateTracker::SetViewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height)
+    {
+        if(!m_Viewport.Set(Values4{ { a_X, a_Y, a_Width, a_Height } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.Viewport(a_X, a_Y, a_Width, a_Height);
+        Issue();
+    }
+
+    void StateTracker::SetScissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height)
+    {
+        if(!m_Scissor.Set(Values4{ { a_X, a_Y, a_Width, a_Height } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.Scissor(a_X, a_Y, a_Width, a_Height);
+        Issue();
+    }
+
+    void StateTracker::SetClearColor(float a_R, float a_G, float a_B, float a_A)
+    {
+        if(!m_ClearColor.Set(ClearValue{ { a_R, a_G, a_B, a_A } }))
+        {
+            Filter();
+            return;
+        }
+        m_Backend.ClearColor(a_R, a_G, a_B, a_A);
+        Issue();
+    }
+
+    void StateTracker::Invalidate()
+    {
+        m_Program = Cached<std::uint32_t>();
+        m_VertexArray = Cached<std::uint32_t>();
+        m_Framebuffer = Cached<std::uint32_t>();
+        m_ActiveUnit = Cached<std::uint32_t>();
+        m_Textures.clear();
+        m_Samplers.clear();
+        m_Capabilities.clear();
+        InvalidateBuffers();
+
+        m_DepthFunc = Cached<std::uint32_t>();
+        m_DepthMask = Cached<bool>();
+        m_CullFace = Cached<std::uint32_t>();
+        m_FrontFace = Cached<std::uint32_t>();
+        m_BlendFunc = Cached<Values4>();
+        m_BlendEquation = Cached<Values4>();
+        for(int face = 0; face < 2; ++face)
+        {
+            m_StencilFunc[face] = Cached<Values4>();
+            m_StencilOp[face] = Cached<Values4>();
+        }
+        m_StencilMask = Cached<std::uint32_t>();
+        m_Viewport = Cached<Values4>();
+        m_Scissor = Cached<Values4>();
+        m_ClearColor = Cached<ClearValue>();
+    }
+
+    void StateTracker::InvalidateBuffers()
+    {
+        m_Buffers.clear();
+        m_IndexedBuffers.clear();
+    }
+
+    void StateTracker::NextFrame()
+    {
+        m_LastFrameStats = m_Stats;
+        m_Stats = StateTrackerStats();
+    }
+
+    const StateTrackerStats& StateTracker::GetStats() const
+    {
+        return m_Stats;
+    }
+
+    const StateTrackerStats& StateTracker::GetLastFrameStats() const
+    {
+        return m_LastFrameStats;
+    }
+
+    bool StateTracker::IsBound(std::uint32_t a_Target, std::uint64_t a_Key, const Values4& a_Binding) const
+    {
+        //Indexed binds also set the generic binding, so the call is only redundant when both are already set.
+        const auto indexed = m_IndexedBuffers.find(a_Key);
+        const auto generic = m_Buffers.find(a_Target);
+        return indexed != m_IndexedBuffers.end() && indexed->second == a_Binding && generic != m_Buffers.end() && generic->second == a_Binding.values[0];
+    }
+
+    void StateTracker::Issue(std::uint32_t a_Calls)
+    {
+        m_Stats.issued += a_Calls;
+    }
+
+    void StateTracker::Filter(std::uint32_t a_Calls)
+    {
+        m_Stats.filtered += a_Calls;
+    }
+
+    std::uint64_t StateTracker::PairKey(std::uint32_t a_First, std::uint32_t a_Second)
+    {
+        return (static_cast<std::uint64_t>(a_First) << 32) | a_Second;
+    }
+}
@@ -0,0 +1,123 @@
+#include "opengl/StateTrackerBackend_GL.h"
+
+#include <GL/glew.h>
+
+namespace blurp
+{
+    void StateTrackerBackend_GL::UseProgram(std::uint32_t a_Program)
+    {
+        glUseProgram(a_Program);
+    }
+
+    void StateTrackerBackend_GL::BindVertexArray(std::uint32_t a_VertexArray)
+    {
+        glBindVertexArray(a_VertexArray);
+    }
+
+    void StateTrackerBackend_GL::ActiveTexture(std::uint32_t a_Unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + a_Unit);
+    }
+
+    void StateTrackerBackend_GL::BindTexture(std::uint32_t a_Target, std::uint32_t a_Texture)
+    {
+        glBindTexture(a_Target, a_Texture);
+    }
+
+    void StateTrackerBackend_GL::BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler)
+    {
+        glBindSampler(a_Unit, a_Sampler);
+    }
+
+    void StateTrackerBackend_GL::BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer)
+    {
+        glBindBuffer(a_Target, a_Buffer);
+    }
+
+    void StateTrackerBackend_GL::BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer)
+    {
+        glBindBufferBase(a_Target, a_Index, a_Buffer);
+    }
+
+    void StateTrackerBackend_GL::BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size)
+    {
+        glBindBufferRange(a_Target, a_Index, a_Buffer, static_cast<GLintptr>(a_Offset), static_cast<GLsizeiptr>(a_Size));
+    }
+
+    void StateTrackerBackend_GL::BindFramebuffer(std::uint32_t a_Framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, a_Framebuffer);
+    }
+
+    void StateTrackerBackend_GL::SetEnabled(std::uint32_t a_Capability, bool a_Enabled)
+    {
+        if(a_Enabled)
+        {
+            glEnable(a_Capability);
+        }
+        else
+        {
+            glDisable(a_Capability);
+        }
+    }
+
+    void StateTrackerBackend_GL::DepthFunc(std::uint32_t a_Function)
+    {
+        glDepthFunc(a_Function);
+    }
+
+    void StateTrackerBackend_GL::DepthMask(bool a_Write)
+    {
+        glDepthMask(a_Write ? GL_TRUE : GL_FALSE);
+    }
+
+    void StateTrackerBackend_GL::CullFace(std::uint32_t a_Face)
+    {
+        glCullFace(a_Face);
+    }
+
+    void StateTrackerBackend_GL::FrontFace(std::uint32_t a_WindingOrder)
+    {
+        glFrontFace(a_WindingOrder);
+    }
+
+    void StateTrackerBackend_GL::BlendFuncSeparate(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha)
+    {
+        glBlendFuncSeparate(a_SrcRgb, a_DstRgb, a_SrcAlpha, a_DstAlpha);
+    }
+
+    void StateTrackerBackend_GL::BlendEquationSeparate(std::uint32_t a_Rgb, std::uint32_t a_Alpha)
+    {
+        glBlendEquationSeparate(a_Rgb, a_Alpha);
+    }
+
+    void StateTrackerBackend_GL::StencilFuncSeparate(StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask)
+    {
+        glStencilFuncSeparate(a_Face == StateFace::FRONT ? GL_FRONT : GL_BACK, a_Function, a_Reference, a_Mask);
+    }
+
+    void StateTrackerBackend_GL::StencilOpSeparate(StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass)
+    {
+        glStencilOpSeparate(a_Face == StateFace::FRONT ? GL_FRONT : GL_BACK, a_StencilFail, a_DepthFail, a_Pass);
+    }
+
+    void StateTrackerBackend_GL::StencilMask(std::uint32_t a_Mask)
+    {
+        glStencilMask(a_Mask);
+    }
+
+    void StateTrackerBackend_GL::Viewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height)
+    {
+        glViewport(a_X, a_Y, a_Width, a_Height);
+    }
+
+    void StateTrackerBackend_GL::Scissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height)
+    {
+        glScissor(a_X, a_Y, a_Width, a_Height);
+    }
+
+    void StateTrackerBackend_GL::ClearColor(float a_R, float a_G, float a_B, float a_A)
+    {
+        glClearColor(a_R, a_G, a_B, a_A);
+    }
+}
@@ -4,6 +4,8 @@
 #include "d3d12/RenderDevice_D3D12.h"
 #include "d3d12/D3D12Utils.h"
 
+#include <stdexcept>
+
 
 namespace blurp
 {
@@ -36,7 +38,7 @@ namespace blurp
 
         if (window->GetWindowType() != WindowType::WINDOW_WIN32)
         {
-            throw std::exception("SwapChain_GL_Win32 can only be constructed for a Win32 window with OpenGL!");
+            throw std::runtime_error("SwapChain_GL_Win32 can only be constructed for a Win32 window with OpenGL!");
             return false;
         }
 
@@ -2,6 +2,7 @@
 #include <GL/glew.h>
 #include <BlurpEngine.h>
 #include <iostream>
+#include <stdexcept>
 
 
 #include "opengl/RenderTarget_GL.h"
@@ -41,7 +42,7 @@ namespace blurp
 
         if(window->GetWindowType() != WindowType::WINDOW_WIN32)
         {
-            throw std::exception("SwapChain_GL_Win32 can only be constructed for a Win32 window with OpenGL!");
+            throw std::runtime_error("SwapChain_GL_Win32 can only be constructed for a Win32 window with OpenGL!");
             return false;
         }
 
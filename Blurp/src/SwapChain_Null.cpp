@@ -0,0 +1,53 @@
+#include "null/SwapChain_Null.h"
+
+namespace blurp
+{
+    void SwapChain_Null::Resize(const glm::vec2& a_Dimensions, bool a_FullScreen)
+    {
+        m_RenderTarget->SetViewPort({ 0.f, 0.f, a_Dimensions });
+    }
+
+    std::uint16_t SwapChain_Null::GetNumBuffers()
+    {
+        return m_Settings.numBuffers;
+    }
+
+    std::shared_ptr<RenderTarget> SwapChain_Null::GetRenderTarget()
+    {
+        return m_RenderTarget;
+    }
+
+    void SwapChain_Null::Present()
+    {
+        ++m_PresentCount;
+    }
+
+    std::uint64_t SwapChain_Null::GetPresentCount() const
+    {
+        return m_PresentCount;
+    }
+
+    bool SwapChain_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        //Create a render target that does not allow attachments, like the targets of a window.
+        RenderTargetSettings rtSettings;
+        rtSettings.allowAttachments = false;
+        rtSettings.clearColor = m_Settings.renderTargetSettings.clearColor;
+        rtSettings.scissorRect = m_Settings.renderTargetSettings.scissorRect;
+        rtSettings.viewPort = m_Settings.renderTargetSettings.viewPort;
+
+        const bool hasDepth = m_Settings.renderTargetSettings.depthBits != 0;
+        const bool hasStencil = m_Settings.renderTargetSettings.stencilBits != 0;
+        const bool hasColor = m_Settings.renderTargetSettings.colorChannels != 0 && m_Settings.renderTargetSettings.channelBits != 0;
+        m_RenderTarget = std::make_shared<RenderTarget_Null>(rtSettings, hasDepth, hasStencil, hasColor);
+        m_RenderTarget->Load(a_BlurpEngine);
+        return true;
+    }
+
+    bool SwapChain_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        m_RenderTarget->Destroy(a_BlurpEngine);
+        m_RenderTarget = nullptr;
+        return true;
+    }
+}
@@ -1,6 +1,7 @@
 #include "opengl/Texture_GL.h"
 
 #include <algorithm>
+#include <stdexcept>
 
 
 #include "opengl/GLUtils.h"
@@ -165,7 +166,7 @@ namespace blurp
 
         default:
         {
-            throw std::exception("Error: texture type not supported for OpenGL.");
+            throw std::runtime_error("Error: texture type not supported for OpenGL.");
             return false;
         }
             break;
@@ -0,0 +1,176 @@
+#include "null/Texture_Null.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace blurp
+{
+    std::uint64_t Texture_Null::GetTexelCount() const
+    {
+        return static_cast<std::uint64_t>(m_Settings.dimensions.x) * std::max(m_Settings.dimensions.y, 1u) * GetLayerCount();
+    }
+
+    void Texture_Null::Clear(const glm::vec<3, std::uint32_t>& a_Offset, const glm::vec<3, std::uint32_t>& a_Size, const void* a_Value)
+    {
+        if (m_Data.empty())
+        {
+            return;
+        }
+
+        const std::uint64_t width = m_Settings.dimensions.x;
+        const std::uint64_t height = std::max(m_Settings.dimensions.y, 1u);
+        assert(a_Offset.x + a_Size.x <= width && a_Offset.y + a_Size.y <= height && a_Offset.z + a_Size.z <= GetLayerCount() && "Cleared region is outside of the texture!");
+
+        for (std::uint32_t z = a_Offset.z; z < a_Offset.z + a_Size.z; ++z)
+        {
+            for (std::uint32_t y = a_Offset.y; y < a_Offset.y + a_Size.y; ++y)
+            {
+                for (std::uint32_t x = a_Offset.x; x < a_Offset.x + a_Size.x; ++x)
+                {
+                    const std::uint64_t texel = (z * height + y) * width + x;
+                    std::memcpy(&m_Data[texel * m_TexelSize], a_Value, m_TexelSize);
+                }
+            }
+        }
+    }
+
+    std::unique_ptr<std::uint8_t[]> Texture_Null::GetPixels(const glm::vec3& a_Start, const glm::vec3& a_Size, int a_Channels)
+    {
+        assert(a_Channels != 0 && a_Size.x != 0 && a_Size.y != 0 && a_Size.z != 0 && "Pixel size has to be at least 1.");
+        assert(!IsWriteLocked() && "Cannot read pixel data from texture when write locked.");
+
+        //Sized like the OpenGL implementation, which writes texels in the format of the texture.
+        const auto size = static_cast<std::size_t>(a_Size.x) * static_cast<std::size_t>(a_Size.y) * static_cast<std::size_t>(a_Size.z) * a_Channels * SizeOf(m_Settings.dataType);
+        std::unique_ptr<std::uint8_t[]> pixels(new std::uint8_t[size]);
+        std::memset(pixels.get(), 0, size);
+
+        if (m_Data.empty())
+        {
+            return pixels;
+        }
+
+        const std::uint64_t width = m_Settings.dimensions.x;
+        const std::uint64_t height = std::max(m_Settings.dimensions.y, 1u);
+        std::size_t written = 0;
+        for (std::uint32_t z = static_cast<std::uint32_t>(a_Start.z); z < static_cast<std::uint32_t>(a_Start.z + a_Size.z); ++z)
+        {
+            for (std::uint32_t y = static_cast<std::uint32_t>(a_Start.y); y < static_cast<std::uint32_t>(a_Start.y + a_Size.y); ++y)
+            {
+                for (std::uint32_t x = static_cast<std::uint32_t>(a_Start.x); x < static_cast<std::uint32_t>(a_Start.x + a_Size.x); ++x)
+                {
+                    if (written + m_TexelSize > size)
+                    {
+                        return pixels;
+                    }
+
+                    const std::uint64_t texel = (z * height + y) * width + x;
+                    std::memcpy(&pixels[written], &m_Data[texel * m_TexelSize], m_TexelSize);
+                    written += m_TexelSize;
+                }
+            }
+        }
+
+        return pixels;
+    }
+
+    bool Texture_Null::OnLoad(BlurpEngine& a_BlurpEngine)
+    {
+        assert(m_Settings.dimensions.x > 0 && m_Settings.dimensions.y >= 0 && m_Settings.dimensions.z >= 0 && "Texture needs positive dimensions.");
+        assert((m_Settings.textureType != TextureType::TEXTURE_CUBEMAP_ARRAY || m_Settings.dimensions.z % 6 == 0) && "Error: Cubemap array depth has to be a multiple of 6!");
+
+        m_TexelSize = GetChannelCount() * static_cast<std::uint32_t>(SizeOf(m_Settings.dataType));
+        const std::uint64_t layerSize = static_cast<std::uint64_t>(m_Settings.dimensions.x) * std::max(m_Settings.dimensions.y, 1u) * m_TexelSize;
+
+        //Find the data for every layer. Cube maps have a pointer per face, the other types one for all layers.
+        const void* data = nullptr;
+        switch (m_Settings.textureType)
+        {
+        case TextureType::TEXTURE_1D:
+            data = m_Settings.texture1D.data;
+            break;
+        case TextureType::TEXTURE_2D:
+            data = m_Settings.texture2D.data;
+            break;
+        case TextureType::TEXTURE_3D:
+            data = m_Settings.texture3D.data;
+            break;
+        case TextureType::TEXTURE_2D_ARRAY:
+            data = m_Settings.texture2DArray.data;
+            break;
+        case TextureType::TEXTURE_CUBEMAP_ARRAY:
+            data = m_Settings.textureCubeMapArray.data;
+            break;
+        case TextureType::TEXTURE_CUBEMAP:
+        {
+            bool hasData = false;
+            for (auto face : m_Settings.textureCubeMap.data)
+            {
+                hasData = hasData || face != nullptr;
+            }
+
+            if (hasData)
+            {
+                m_Data.resize(static_cast<std::size_t>(layerSize * 6));
+                for (int face = 0; face < 6; ++face)
+                {
+                    if (m_Settings.textureCubeMap.data[face] != nullptr)
+                    {
+                        std::memcpy(&m_Data[static_cast<std::size_t>(layerSize * face)], m_Settings.textureCubeMap.data[face], static_cast<std::size_t>(layerSize));
+                    }
+                }
+            }
+            return true;
+        }
+        default:
+            throw std::runtime_error("Texture type not implemented for the null backend!");
+        }
+
+        if (data != nullptr)
+        {
+            const auto size = static_cast<std::size_t>(layerSize * GetLayerCount());
+            m_Data.resize(size);
+            std::memcpy(&m_Data[0], data, size);
+        }
+
+        return true;
+    }
+
+    bool Texture_Null::OnDestroy(BlurpEngine& a_BlurpEngine)
+    {
+        m_Data.clear();
+        m_Data.shrink_to_fit();
+        return true;
+    }
+
+    std::uint32_t Texture_Null::GetLayerCount() const
+    {
+        switch (m_Settings.textureType)
+        {
+        case TextureType::TEXTURE_3D:
+        case TextureType::TEXTURE_2D_ARRAY:
+        case TextureType::TEXTURE_CUBEMAP_ARRAY:
+            return std::max(m_Settings.dimensions.z, 1u);
+        case TextureType::TEXTURE_CUBEMAP:
+            return 6;
+        default:
+            return 1;
+        }
+    }
+
+    std::uint32_t Texture_Null::GetChannelCount() const
+    {
+        switch (m_Settings.pixelFormat)
+        {
+        case PixelFormat::RG:
+            return 2;
+        case PixelFormat::RGB:
+            return 3;
+        case PixelFormat::RGBA:
+            return 4;
+        default:
+            return 1;
+        }
+    }
+}
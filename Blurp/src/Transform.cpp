@@ -12,6 +12,7 @@ namespace blurp
         , m_Scale(1)
         , m_Transformation(1)
         , m_Flag(false)
+        , m_Changed(true)
     {
 
     }
@@ -33,24 +34,28 @@ namespace blurp
     void Transform::Rotate(const glm::quat& a_Quat)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Rotation = a_Quat * m_Rotation;
     }
 
     void Transform::Translate(const glm::vec3& a_Translation)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Translation += a_Translation;
     }
 
     void Transform::Scale(const glm::vec3& a_Scale)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Scale *= a_Scale;
     }
 
     void Transform::Scale(float a_Scale)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Scale *= a_Scale;
     }
 
@@ -81,6 +86,7 @@ namespace blurp
 
         m_Transformation = matrix;
         m_Flag = false;
+        m_Changed = true;
 
         //Not used
         glm::vec3 skew;
@@ -114,6 +120,7 @@ namespace blurp
 
         //Rotate the entire existing thing around the point.
         m_Transformation = rotate * m_Transformation;
+        m_Changed = true;
 
         //Not used
         glm::vec3 skew;
@@ -126,12 +133,14 @@ namespace blurp
     void Transform::SetScale(const glm::vec3& a_Scale)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Scale = a_Scale;
     }
 
     void Transform::SetScale(float a_Scale)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Scale = glm::vec3(a_Scale);
     }
 
@@ -143,15 +152,27 @@ namespace blurp
     void Transform::SetRotation(const glm::quat& a_Quaternion)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Rotation = a_Quaternion;
     }
 
     void Transform::SetTranslation(const glm::vec3& a_Translation)
     {
         m_Flag = true;
+        m_Changed = true;
         m_Translation = a_Translation;
     }
 
+    bool Transform::HasChanged() const
+    {
+        return m_Changed;
+    }
+
+    void Transform::ClearChanged()
+    {
+        m_Changed = false;
+    }
+
     glm::quat Transform::GetRotation() const
     {
         return m_Rotation;
@@ -0,0 +1,486 @@
+#include "TransformStore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "SimdSupport.h"
+
+//The arrays are always padded to a multiple of this, so that SIMD loads never go out of bounds.
+#define TRANSFORM_STORE_LANES 8
+
+namespace blurp
+{
+#if defined(BLURP_SIMD_SSE)
+    namespace
+    {
+        /*
+         * Transpose the columns of four transforms held in SoA registers and store the ones that are dirty.
+         * a_Columns[j][k] holds component k of column j for four transforms.
+         */
+        void StoreMatrices(__m128 (&a_Columns)[4][4], const std::uint8_t* a_Dirty, glm::mat4* a_Output)
+        {
+            for(int column = 0; column < 4; ++column)
+            {
+                //After the transpose, register k contains this column for transform k.
+                _MM_TRANSPOSE4_PS(a_Columns[column][0], a_Columns[column][1], a_Columns[column][2], a_Columns[column][3]);
+            }
+
+            for(int lane = 0; lane < 4; ++lane)
+            {
+                if(a_Dirty[lane] != 0)
+                {
+                    float* destination = &a_Output[lane][0][0];
+                    _mm_storeu_ps(destination + 0, a_Columns[0][lane]);
+                    _mm_storeu_ps(destination + 4, a_Columns[1][lane]);
+                    _mm_storeu_ps(destination + 8, a_Columns[2][lane]);
+                    _mm_storeu_ps(destination + 12, a_Columns[3][lane]);
+                }
+            }
+        }
+    }
+#endif
+
+    TransformStore::TransformStore() : m_Size(0)
+    {
+
+    }
+
+    std::uint32_t TransformStore::Add(const glm::vec3& a_Translation, const glm::quat& a_Rotation, const glm::vec3& a_Scale)
+    {
+        std::uint32_t index;
+        if(!m_FreeIndices.empty())
+        {
+            index = m_FreeIndices.back();
+            m_FreeIndices.pop_back();
+        }
+        else
+        {
+            index = m_Size;
+            Resize(m_Size + 1);
+        }
+
+        SetTranslation(index, a_Translation);
+        SetRotation(index, a_Rotation);
+        SetScale(index, a_Scale);
+        return index;
+    }
+
+    void TransformStore::Remove(std::uint32_t a_Index)
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        m_Dirty[a_Index] = 0;
+        m_FreeIndices.push_back(a_Index);
+    }
+
+    void TransformStore::Reserve(std::uint32_t a_Capacity)
+    {
+        const std::uint32_t padded = (a_Capacity + TRANSFORM_STORE_LANES - 1) & ~(TRANSFORM_STORE_LANES - 1);
+        for(auto* components : { &m_TranslationX, &m_TranslationY, &m_TranslationZ, &m_RotationX, &m_RotationY, &m_RotationZ, &m_RotationW, &m_ScaleX, &m_ScaleY, &m_ScaleZ })
+        {
+            components->reserve(padded);
+        }
+        m_Dirty.reserve(padded);
+    }
+
+    void TransformStore::Clear()
+    {
+        m_Size = 0;
+        m_FreeIndices.clear();
+        Resize(0);
+    }
+
+    void TransformStore::SetTranslation(std::uint32_t a_Index, const glm::vec3& a_Translation)
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        m_TranslationX[a_Index] = a_Translation.x;
+        m_TranslationY[a_Index] = a_Translation.y;
+        m_TranslationZ[a_Index] = a_Translation.z;
+        m_Dirty[a_Index] = 1;
+    }
+
+    void TransformStore::SetRotation(std::uint32_t a_Index, const glm::quat& a_Rotation)
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        m_RotationX[a_Index] = a_Rotation.x;
+        m_RotationY[a_Index] = a_Rotation.y;
+        m_RotationZ[a_Index] = a_Rotation.z;
+        m_RotationW[a_Index] = a_Rotation.w;
+        m_Dirty[a_Index] = 1;
+    }
+
+    void TransformStore::SetScale(std::uint32_t a_Index, const glm::vec3& a_Scale)
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        m_ScaleX[a_Index] = a_Scale.x;
+        m_ScaleY[a_Index] = a_Scale.y;
+        m_ScaleZ[a_Index] = a_Scale.z;
+        m_Dirty[a_Index] = 1;
+    }
+
+    void TransformStore::Translate(std::uint32_t a_Index, const glm::vec3& a_Translation)
+    {
+        SetTranslation(a_Index, GetTranslation(a_Index) + a_Translation);
+    }
+
+    void TransformStore::Rotate(std::uint32_t a_Index, const glm::quat& a_Rotation)
+    {
+        SetRotation(a_Index, a_Rotation * GetRotation(a_Index));
+    }
+
+    void TransformStore::Scale(std::uint32_t a_Index, const glm::vec3& a_Scale)
+    {
+        SetScale(a_Index, GetScale(a_Index) * a_Scale);
+    }
+
+    glm::vec3 TransformStore::GetTranslation(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        return glm::vec3(m_TranslationX[a_Index], m_TranslationY[a_Index], m_TranslationZ[a_Index]);
+    }
+
+    glm::quat TransformStore::GetRotation(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        return glm::quat(m_RotationW[a_Index], m_RotationX[a_Index], m_RotationY[a_Index], m_RotationZ[a_Index]);
+    }
+
+    glm::vec3 TransformStore::GetScale(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        return glm::vec3(m_ScaleX[a_Index], m_ScaleY[a_Index], m_ScaleZ[a_Index]);
+    }
+
+    bool TransformStore::IsDirty(std::uint32_t a_Index) const
+    {
+        assert(a_Index < m_Size && "Transform index out of bounds!");
+        return m_Dirty[a_Index] != 0;
+    }
+
+    void TransformStore::MarkAllDirty()
+    {
+        std::fill(m_Dirty.begin(), m_Dirty.begin() + m_Size, static_cast<std::uint8_t>(1));
+        for(auto index : m_FreeIndices)
+        {
+            m_Dirty[index] = 0;
+        }
+    }
+
+    std::uint32_t TransformStore::GetSize() const
+    {
+        return m_Size;
+    }
+
+    std::uint32_t TransformStore::GetCount() const
+    {
+        return m_Size - static_cast<std::uint32_t>(m_FreeIndices.size());
+    }
+
+    std::uint32_t TransformStore::Compose(glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices, TransformKernel a_Kernel)
+    {
+        assert(a_Transforms != nullptr && "Output array cannot be nullptr!");
+
+        if(!IsKernelSupported(a_Kernel))
+        {
+            a_Kernel = GetBestKernel();
+        }
+
+        //The SIMD kernels handle whole groups. The transforms after the last full group are done one by one.
+        std::uint32_t composed = 0;
+        std::uint32_t scalarStart = 0;
+
+        if(a_Kernel == TransformKernel::AVX)
+        {
+            scalarStart = m_Size & ~7u;
+            composed += ComposeAVX(scalarStart, a_Transforms, a_NormalMatrices);
+        }
+        else if(a_Kernel == TransformKernel::SSE)
+        {
+            scalarStart = m_Size & ~3u;
+            composed += ComposeSSE(scalarStart, a_Transforms, a_NormalMatrices);
+        }
+
+        composed += ComposeScalar(scalarStart, m_Size, a_Transforms, a_NormalMatrices);
+        return composed;
+    }
+
+    bool TransformStore::IsKernelSupported(TransformKernel a_Kernel)
+    {
+        switch(a_Kernel)
+        {
+        case TransformKernel::SCALAR:
+            return true;
+        case TransformKernel::SSE:
+#if defined(BLURP_SIMD_SSE)
+            return true;
+#else
+            return false;
+#endif
+        case TransformKernel::AVX:
+#if defined(BLURP_SIMD_AVX)
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+        }
+    }
+
+    TransformKernel TransformStore::GetBestKernel()
+    {
+#if defined(BLURP_SIMD_AVX)
+        return TransformKernel::AVX;
+#elif defined(BLURP_SIMD_SSE)
+        return TransformKernel::SSE;
+#else
+        return TransformKernel::SCALAR;
+#endif
+    }
+
+    std::uint32_t TransformStore::ComposeScalar(std::uint32_t a_Start, std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices)
+    {
+        std::uint32_t composed = 0;
+        for(std::uint32_t i = a_Start; i < a_End; ++i)
+        {
+            if(m_Dirty[i] == 0)
+            {
+                continue;
+            }
+
+            const float x = m_RotationX[i], y = m_RotationY[i], z = m_RotationZ[i], w = m_RotationW[i];
+
+            //Rotation matrix from the quaternion, the same as glm::mat3_cast.
+            const glm::vec3 right(1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y));
+            const glm::vec3 up(2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x));
+            const glm::vec3 forward(2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y));
+
+            //Translation * rotation * scale.
+            glm::mat4& transform = a_Transforms[i];
+            transform[0] = glm::vec4(right * m_ScaleX[i], 0.f);
+            transform[1] = glm::vec4(up * m_ScaleY[i], 0.f);
+            transform[2] = glm::vec4(forward * m_ScaleZ[i], 0.f);
+            transform[3] = glm::vec4(m_TranslationX[i], m_TranslationY[i], m_TranslationZ[i], 1.f);
+
+            //The inverse transpose of rotation * scale is rotation * inverse scale.
+            if(a_NormalMatrices != nullptr)
+            {
+                glm::mat4& normal = a_NormalMatrices[i];
+                normal[0] = glm::vec4(right / m_ScaleX[i], 0.f);
+                normal[1] = glm::vec4(up / m_ScaleY[i], 0.f);
+                normal[2] = glm::vec4(forward / m_ScaleZ[i], 0.f);
+                normal[3] = glm::vec4(0.f, 0.f, 0.f, 1.f);
+            }
+
+            m_Dirty[i] = 0;
+            ++composed;
+        }
+        return composed;
+    }
+
+    std::uint32_t TransformStore::ComposeSSE(std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices)
+    {
+#if defined(BLURP_SIMD_SSE)
+        std::uint32_t composed = 0;
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 two = _mm_set1_ps(2.f);
+
+        for(std::uint32_t i = 0; i < a_End; i += 4)
+        {
+            //Skip groups in which nothing changed.
+            std::uint32_t dirtyMask;
+            memcpy(&dirtyMask, &m_Dirty[i], sizeof(dirtyMask));
+            if(dirtyMask == 0)
+            {
+                continue;
+            }
+
+            const __m128 x = _mm_loadu_ps(&m_RotationX[i]);
+            const __m128 y = _mm_loadu_ps(&m_RotationY[i]);
+            const __m128 z = _mm_loadu_ps(&m_RotationZ[i]);
+            const __m128 w = _mm_loadu_ps(&m_RotationW[i]);
+
+            const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+            //Rotation matrix, rotation[column][row].
+            const __m128 rotation[3][3] =
+            {
+                { _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), _mm_mul_ps(two, _mm_add_ps(xy, wz)), _mm_mul_ps(two, _mm_sub_ps(xz, wy)) },
+                { _mm_mul_ps(two, _mm_sub_ps(xy, wz)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), _mm_mul_ps(two, _mm_add_ps(yz, wx)) },
+                { _mm_mul_ps(two, _mm_add_ps(xz, wy)), _mm_mul_ps(two, _mm_sub_ps(yz, wx)), _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))) }
+            };
+
+            const __m128 scale[3] = { _mm_loadu_ps(&m_ScaleX[i]), _mm_loadu_ps(&m_ScaleY[i]), _mm_loadu_ps(&m_ScaleZ[i]) };
+
+            __m128 columns[4][4];
+            for(int column = 0; column < 3; ++column)
+            {
+                columns[column][0] = _mm_mul_ps(rotation[column][0], scale[column]);
+                columns[column][1] = _mm_mul_ps(rotation[column][1], scale[column]);
+                columns[column][2] = _mm_mul_ps(rotation[column][2], scale[column]);
+                columns[column][3] = zero;
+            }
+            columns[3][0] = _mm_loadu_ps(&m_TranslationX[i]);
+            columns[3][1] = _mm_loadu_ps(&m_TranslationY[i]);
+            columns[3][2] = _mm_loadu_ps(&m_TranslationZ[i]);
+            columns[3][3] = one;
+
+            StoreMatrices(columns, &m_Dirty[i], &a_Transforms[i]);
+
+            if(a_NormalMatrices != nullptr)
+            {
+                for(int column = 0; column < 3; ++column)
+                {
+                    const __m128 inverseScale = _mm_div_ps(one, scale[column]);
+                    columns[column][0] = _mm_mul_ps(rotation[column][0], inverseScale);
+                    columns[column][1] = _mm_mul_ps(rotation[column][1], inverseScale);
+                    columns[column][2] = _mm_mul_ps(rotation[column][2], inverseScale);
+                    columns[column][3] = zero;
+                }
+                columns[3][0] = zero;
+                columns[3][1] = zero;
+                columns[3][2] = zero;
+                columns[3][3] = one;
+
+                StoreMatrices(columns, &m_Dirty[i], &a_NormalMatrices[i]);
+            }
+
+            //Clear the dirty flags of the group.
+            for(std::uint32_t lane = 0; lane < 4; ++lane)
+            {
+                composed += m_Dirty[i + lane];
+                m_Dirty[i + lane] = 0;
+            }
+        }
+
+        return composed;
+#else
+        return ComposeScalar(0, a_End, a_Transforms, a_NormalMatrices);
+#endif
+    }
+
+    std::uint32_t TransformStore::ComposeAVX(std::uint32_t a_End, glm::mat4* a_Transforms, glm::mat4* a_NormalMatrices)
+    {
+#if defined(BLURP_SIMD_AVX)
+        std::uint32_t composed = 0;
+
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 two = _mm256_set1_ps(2.f);
+
+        //Split the 8 wide columns into two groups of 4 and store them.
+        const auto store = [](const __m256 (&a_Columns)[4][4], const std::uint8_t* a_Dirty, glm::mat4* a_Output)
+        {
+            __m128 low[4][4];
+            __m128 high[4][4];
+            for(int column = 0; column < 4; ++column)
+            {
+                for(int row = 0; row < 4; ++row)
+                {
+                    low[column][row] = _mm256_castps256_ps128(a_Columns[column][row]);
+                    high[column][row] = _mm256_extractf128_ps(a_Columns[column][row], 1);
+                }
+            }
+            StoreMatrices(low, a_Dirty, a_Output);
+            StoreMatrices(high, a_Dirty + 4, a_Output + 4);
+        };
+
+        for(std::uint32_t i = 0; i < a_End; i += 8)
+        {
+            //Skip groups in which nothing changed.
+            std::uint64_t dirtyMask;
+            memcpy(&dirtyMask, &m_Dirty[i], sizeof(dirtyMask));
+            if(dirtyMask == 0)
+            {
+                continue;
+            }
+
+            const __m256 x = _mm256_loadu_ps(&m_RotationX[i]);
+            const __m256 y = _mm256_loadu_ps(&m_RotationY[i]);
+            const __m256 z = _mm256_loadu_ps(&m_RotationZ[i]);
+            const __m256 w = _mm256_loadu_ps(&m_RotationW[i]);
+
+            const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            const __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            const __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+            //Rotation matrix, rotation[column][row].
+            const __m256 rotation[3][3] =
+            {
+                { _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), _mm256_mul_ps(two, _mm256_add_ps(xy, wz)), _mm256_mul_ps(two, _mm256_sub_ps(xz, wy)) },
+                { _mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), _mm256_mul_ps(two, _mm256_add_ps(yz, wx)) },
+                { _mm256_mul_ps(two, _mm256_add_ps(xz, wy)), _mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))) }
+            };
+
+            const __m256 scale[3] = { _mm256_loadu_ps(&m_ScaleX[i]), _mm256_loadu_ps(&m_ScaleY[i]), _mm256_loadu_ps(&m_ScaleZ[i]) };
+
+            __m256 columns[4][4];
+            for(int column = 0; column < 3; ++column)
+            {
+                columns[column][0] = _mm256_mul_ps(rotation[column][0], scale[column]);
+                columns[column][1] = _mm256_mul_ps(rotation[column][1], scale[column]);
+                columns[column][2] = _mm256_mul_ps(rotation[column][2], scale[column]);
+                columns[column][3] = zero;
+            }
+            columns[3][0] = _mm256_loadu_ps(&m_TranslationX[i]);
+            columns[3][1] = _mm256_loadu_ps(&m_TranslationY[i]);
+            columns[3][2] = _mm256_loadu_ps(&m_TranslationZ[i]);
+            columns[3][3] = one;
+
+            store(columns, &m_Dirty[i], &a_Transforms[i]);
+
+            if(a_NormalMatrices != nullptr)
+            {
+                for(int column = 0; column < 3; ++column)
+                {
+                    const __m256 inverseScale = _mm256_div_ps(one, scale[column]);
+                    columns[column][0] = _mm256_mul_ps(rotation[column][0], inverseScale);
+                    columns[column][1] = _mm256_mul_ps(rotation[column][1], inverseScale);
+                    columns[column][2] = _mm256_mul_ps(rotation[column][2], inverseScale);
+                    columns[column][3] = zero;
+                }
+                columns[3][0] = zero;
+                columns[3][1] = zero;
+                columns[3][2] = zero;
+                columns[3][3] = one;
+
+                store(columns, &m_Dirty[i], &a_NormalMatrices[i]);
+            }
+
+            //Clear the dirty flags of the group.
+            for(std::uint32_t lane = 0; lane < 8; ++lane)
+            {
+                composed += m_Dirty[i + lane];
+                m_Dirty[i + lane] = 0;
+            }
+        }
+
+        return composed;
+#else
+        return ComposeScalar(0, a_End, a_Transforms, a_NormalMatrices);
+#endif
+    }
+
+    void TransformStore::Resize(std::uint32_t a_Size)
+    {
+        m_Size = a_Size;
+
+        //Padding entries are identity transforms that are never dirty, so SIMD kernels can safely read them.
+        const std::uint32_t padded = (a_Size + TRANSFORM_STORE_LANES - 1) & ~(TRANSFORM_STORE_LANES - 1);
+        m_TranslationX.resize(padded, 0.f);
+        m_TranslationY.resize(padded, 0.f);
+        m_TranslationZ.resize(padded, 0.f);
+        m_RotationX.resize(padded, 0.f);
+        m_RotationY.resize(padded, 0.f);
+        m_RotationZ.resize(padded, 0.f);
+        m_RotationW.resize(padded, 1.f);
+        m_ScaleX.resize(padded, 1.f);
+        m_ScaleY.resize(padded, 1.f);
+        m_ScaleZ.resize(padded, 1.f);
+        m_Dirty.resize(padded, 0);
+    }
+}
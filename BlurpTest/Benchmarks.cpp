@@ -0,0 +1,3564 @@
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <BlurpEngine.h>
+#include <Camera.h>
+#include <CascadeScheduler.h>
+#include <CommandRecording.h>
+#include <Culling.h>
+#include <DrawSorter.h>
+#include <GpuBuffer.h>
+#include <GpuBuffer_CPU.h>
+#include <JobSystem.h>
+#include <Light.h>
+#include <LightClusterBuilder.h>
+#include <Material.h>
+#include <PositionalShadowCache.h>
+#include <Profiler.h>
+#include <RenderPass_Clear.h>
+#include <RenderPass_Forward.h>
+#include <RenderPass_ShadowMap.h>
+#include <RenderPipeline_Null.h>
+#include <RenderResourceManager.h>
+#include <RingBufferAllocator.h>
+#include <ShaderBinaryCache.h>
+#include <ShaderCompileQueue.h>
+#include <ShaderManifest.h>
+#include <ShaderMaskTable.h>
+#include <ShaderPreprocessor.h>
+#include <ShaderRegistry.h>
+#include <Shader.h>
+#include <ShadowCasterCuller.h>
+#include <ShadowLightScheduler.h>
+#include <StateTracker.h>
+#include <Transform.h>
+#include <TransformStore.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+    //Time a function and return the average amount of microseconds per call.
+    template<typename T>
+    double Measure(std::uint32_t a_Iterations, T a_Function)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for(std::uint32_t i = 0; i < a_Iterations; ++i)
+        {
+            a_Function(i);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / static_cast<double>(a_Iterations);
+    }
+
+    //Cube with positions and normals, and its indices.
+    const std::float_t cubeData[]
+    {
+        -0.5f, -0.5f, -0.5f,    -0.577f, -0.577f, -0.577f,
+        0.5f, -0.5f, -0.5f,     0.577f, -0.577f, -0.577f,
+        0.5f, 0.5f, -0.5f,      0.577f, 0.577f, -0.577f,
+        -0.5f, 0.5f, -0.5f,     -0.577f, 0.577f, -0.577f,
+        -0.5f, -0.5f, 0.5f,     -0.577f, -0.577f, 0.577f,
+        0.5f, -0.5f, 0.5f,      0.577f, -0.577f, 0.577f,
+        0.5f, 0.5f, 0.5f,       0.577f, 0.577f, 0.577f,
+        -0.5f, 0.5f, 0.5f,      -0.577f, 0.577f, 0.577f,
+    };
+    const std::uint16_t cubeIndices[]
+    {
+        0, 2, 1, 0, 3, 2,
+        4, 5, 6, 4, 6, 7,
+        0, 1, 5, 0, 5, 4,
+        3, 6, 2, 3, 7, 6,
+        0, 4, 7, 0, 7, 3,
+        1, 2, 6, 1, 6, 5,
+    };
+    constexpr std::uint32_t cubeIndexCount = sizeof(cubeIndices) / sizeof(cubeIndices[0]);
+
+    //Settings for the cube above, with or without its normals.
+    blurp::MeshSettings CubeMeshSettings(bool a_Normals)
+    {
+        using namespace blurp;
+        MeshSettings meshSettings;
+        meshSettings.indexData = &cubeIndices;
+        meshSettings.vertexData = &cubeData;
+        meshSettings.indexDataType = DataType::USHORT;
+        meshSettings.usage = MemoryUsage::GPU;
+        meshSettings.access = AccessMode::READ_ONLY;
+        meshSettings.vertexDataSizeBytes = sizeof(cubeData);
+        meshSettings.numIndices = cubeIndexCount;
+        meshSettings.vertexSettings.EnableAttribute(VertexAttribute::POSITION_3D, 0, 24, 0);
+        if(a_Normals)
+        {
+            meshSettings.vertexSettings.EnableAttribute(VertexAttribute::NORMAL, 12, 24, 0);
+        }
+        return meshSettings;
+    }
+
+    //Headless engine that records commands instead of sending them to a GPU, with the resources that the null backend benchmarks share.
+    struct NullScene
+    {
+        blurp::BlurpEngine engine;
+        std::shared_ptr<blurp::RenderTarget> target;
+        std::shared_ptr<blurp::Camera> camera;
+        std::shared_ptr<blurp::Mesh> cube;
+        std::shared_ptr<blurp::Material> material;
+        std::shared_ptr<blurp::GpuBuffer> buffer;
+
+        //One cube per draw, with its transform in the buffer. The cubes are on a grid of 32 wide that goes away from the camera.
+        std::vector<blurp::DrawData> draws;
+
+        //The end of the transforms in the buffer.
+        std::uint32_t bufferEnd = 0;
+    };
+
+    /*
+     * Initialize the engine with the null graphics API and create the shared resources.
+     * The render target has a color and depth attachment of 256 by 256 pixels, and the camera is at the origin.
+     * Draw i places its cube at grid position (i * a_Order) % a_Instances, so an a_Order other than 1 shuffles the draws.
+     */
+    void InitNullScene(NullScene& a_Scene, blurp::BlurpSettings a_Settings, std::uint32_t a_Instances, std::uint32_t a_Order)
+    {
+        using namespace blurp;
+
+        constexpr std::uint32_t targetDimension = 256;
+
+        a_Settings.graphicsAPI = GraphicsAPI::NONE;
+        a_Settings.windowSettings.type = WindowType::NONE;
+        a_Scene.engine.Init(a_Settings);
+        auto& resources = a_Scene.engine.GetResourceManager();
+
+        TextureSettings colorSettings;
+        colorSettings.dimensions = glm::vec3(targetDimension, targetDimension, 1);
+        colorSettings.generateMipMaps = false;
+        colorSettings.dataType = DataType::UBYTE;
+        colorSettings.pixelFormat = PixelFormat::RGBA;
+        colorSettings.memoryAccess = AccessMode::READ_WRITE;
+        colorSettings.memoryUsage = MemoryUsage::GPU;
+        colorSettings.textureType = TextureType::TEXTURE_2D;
+
+        TextureSettings depthSettings = colorSettings;
+        depthSettings.dataType = DataType::FLOAT;
+        depthSettings.pixelFormat = PixelFormat::DEPTH;
+
+        RenderTargetSettings targetSettings;
+        targetSettings.viewPort = { 0, 0, targetDimension, targetDimension };
+        targetSettings.defaultColorAttachment = resources.CreateTexture(colorSettings);
+        targetSettings.defaultDepthStencilAttachment = resources.CreateTexture(depthSettings);
+        a_Scene.target = resources.CreateRenderTarget(targetSettings);
+
+        CameraSettings camSettings;
+        camSettings.width = static_cast<float>(targetDimension);
+        camSettings.height = static_cast<float>(targetDimension);
+        camSettings.nearPlane = 0.1f;
+        camSettings.farPlane = 500.f;
+        a_Scene.camera = resources.CreateCamera(camSettings);
+
+        a_Scene.cube = resources.CreateMesh(CubeMeshSettings(true));
+
+        MaterialSettings materialSettings;
+        materialSettings.EnableAttribute(MaterialAttribute::DIFFUSE_CONSTANT_VALUE);
+        materialSettings.SetDiffuseConstant({ 0.8f, 0.4f, 0.2f });
+        a_Scene.material = resources.CreateMaterial(materialSettings);
+
+        GpuBufferSettings bufferSettings;
+        bufferSettings.size = 1 << 16;
+        bufferSettings.resizeWhenFull = true;
+        bufferSettings.memoryUsage = MemoryUsage::CPU_W;
+        a_Scene.buffer = resources.CreateGpuBuffer(bufferSettings);
+
+        a_Scene.draws.resize(a_Instances);
+        std::uintptr_t offset = 0;
+        for(std::uint32_t i = 0; i < a_Instances; ++i)
+        {
+            const std::uint32_t position = static_cast<std::uint32_t>((static_cast<std::uint64_t>(i) * a_Order) % a_Instances);
+            const glm::mat4 transform = glm::translate(glm::mat4(1.f), glm::vec3(static_cast<float>(position % 32) * 3.f - 48.f, 0.f, -static_cast<float>(position / 32) * 3.f));
+            auto& drawData = a_Scene.draws[i];
+            drawData.mesh = a_Scene.cube;
+            drawData.instanceCount = 1;
+            drawData.attributes.EnableAttribute(DrawAttribute::TRANSFORMATION_MATRIX).EnableAttribute(DrawAttribute::MATERIAL_SINGLE);
+            drawData.materialData.material = a_Scene.material;
+            drawData.transformData.dataBuffer = a_Scene.buffer;
+            drawData.transformData.dataRange = a_Scene.buffer->WriteData<glm::mat4>(offset, 1, 16, &transform);
+            offset = drawData.transformData.dataRange.end;
+        }
+        a_Scene.bufferEnd = static_cast<std::uint32_t>(offset);
+    }
+}
+
+bool BenchmarkDrawSorter(std::uint32_t a_Draws, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 rng(43);
+    bool valid = true;
+
+    //Split a key back into its fields: blended, pipeline, shader, material, mesh and depth.
+    constexpr std::uint32_t stateBits = SORT_KEY_PIPELINE_BITS + SORT_KEY_SHADER_BITS + SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS;
+    constexpr std::uint32_t unusedBits = 64 - (1 + stateBits + SORT_KEY_DEPTH_BITS);
+    constexpr std::uint64_t depthMax = (1ull << SORT_KEY_DEPTH_BITS) - 1;
+    const auto field = [](std::uint64_t a_Value, std::uint32_t a_Shift, std::uint32_t a_Bits)
+    {
+        return static_cast<std::uint32_t>((a_Value >> a_Shift) & ((1ull << a_Bits) - 1));
+    };
+    const auto decode = [&](std::uint64_t a_Key)
+    {
+        const std::uint64_t key = a_Key >> unusedBits;
+        const bool blended = field(key, stateBits + SORT_KEY_DEPTH_BITS, 1) != 0;
+        const std::uint64_t state = blended ? key : (key >> SORT_KEY_DEPTH_BITS);
+        const std::uint32_t depth = blended ? static_cast<std::uint32_t>(depthMax - field(key, stateBits, SORT_KEY_DEPTH_BITS)) : field(key, 0, SORT_KEY_DEPTH_BITS);
+        return std::array<std::uint32_t, 6>
+        {
+            blended ? 1u : 0u,
+            field(state, SORT_KEY_SHADER_BITS + SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS, SORT_KEY_PIPELINE_BITS),
+            field(state, SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS, SORT_KEY_SHADER_BITS),
+            field(state, SORT_KEY_MESH_BITS, SORT_KEY_MATERIAL_BITS),
+            field(state, 0, SORT_KEY_MESH_BITS),
+            depth
+        };
+    };
+
+    //Every field ends up where the layout says, the unused bits stay zero and fields that are too large saturate without touching their neighbours.
+    valid = valid && decode(DrawSorter::MakeKey(false, 5, 9, 300, 77, 1234)) == std::array<std::uint32_t, 6>{ 0, 5, 9, 300, 77, 1234 };
+    valid = valid && decode(DrawSorter::MakeKey(true, 5, 9, 300, 77, 1234)) == std::array<std::uint32_t, 6>{ 1, 5, 9, 300, 77, 1234 };
+    valid = valid && decode(DrawSorter::MakeKey(false, 100000, 0, 100000, 0, 100000)) == std::array<std::uint32_t, 6>{ 0, (1u << SORT_KEY_PIPELINE_BITS) - 1, 0, (1u << SORT_KEY_MATERIAL_BITS) - 1, 0, static_cast<std::uint32_t>(depthMax) };
+    valid = valid && (DrawSorter::MakeKey(true, 100000, 100000, 100000, 100000, 100000) & ((1ull << unusedBits) - 1)) == 0;
+    valid = valid && DrawSorter::MakeKey(false, 0, 0, 0, 0, 0) < DrawSorter::MakeKey(false, 0, 0, 0, 0, 1);
+    valid = valid && DrawSorter::MakeKey(false, 0, 0, 0, 1, 0) > DrawSorter::MakeKey(false, 0, 0, 0, 0, static_cast<std::uint32_t>(depthMax));
+    valid = valid && DrawSorter::MakeKey(true, 0, 0, 0, 0, 0) > DrawSorter::MakeKey(true, 0, 0, 0, 0, 1);
+    valid = valid && DrawSorter::MakeKey(true, 0, 0, 0, 0, static_cast<std::uint32_t>(depthMax)) > DrawSorter::MakeKey(false, 100000, 100000, 100000, 100000, 100000);
+    valid = valid && DrawSorter::QuantizeDepth(0.1f, 0.1f, 100.f) == 0 && DrawSorter::QuantizeDepth(-5.f, 0.1f, 100.f) == 0;
+    valid = valid && DrawSorter::QuantizeDepth(100.f, 0.1f, 100.f) == depthMax && DrawSorter::QuantizeDepth(500.f, 0.1f, 100.f) == depthMax;
+
+    //Headless engine, only used to create meshes and materials.
+    NullScene scene;
+    InitNullScene(scene, BlurpSettings(), 0, 1);
+    auto& resources = scene.engine.GetResourceManager();
+
+    //Two cubes with different vertex attributes, so that they need different shaders.
+    std::vector<std::shared_ptr<Mesh>> meshes{ resources.CreateMesh(CubeMeshSettings(false)), scene.cube };
+
+    //The first two materials have the same attributes, the third needs another shader.
+    MaterialSettings materialSettings;
+    materialSettings.EnableAttribute(MaterialAttribute::DIFFUSE_CONSTANT_VALUE);
+    std::vector<std::shared_ptr<Material>> materials{ scene.material };
+    materialSettings.SetDiffuseConstant({ 0.2f, 0.4f, 0.8f });
+    materials.push_back(resources.CreateMaterial(materialSettings));
+    materialSettings.EnableAttribute(MaterialAttribute::EMISSIVE_CONSTANT_VALUE);
+    materialSettings.SetEmissiveConstant({ 1.f, 1.f, 1.f });
+    materials.push_back(resources.CreateMaterial(materialSettings));
+
+    //Two opaque states and a blended one.
+    BlendData blendData;
+    blendData.blend = true;
+    blendData.srcBlend = BlendType::BLEND_SRC_ALPHA;
+    blendData.dstBlend = BlendType::BLEND_INV_SRC_ALPHA;
+    const std::vector<const PipelineState*> pipelineStates
+    {
+        &PipelineState::GetDefault(),
+        &PipelineState::Intern(BlendData(), TopologyType::TRIANGLES, CullMode::CULL_FRONT, WindingOrder::COUNTER_CLOCKWISE, DepthStencilData()),
+        &PipelineState::Intern(blendData, TopologyType::TRIANGLES, CullMode::CULL_BACK, WindingOrder::COUNTER_CLOCKWISE, DepthStencilData()),
+    };
+
+    DrawSortSettings sortSettings;
+    sortSettings.nearPlane = 0.1f;
+    sortSettings.farPlane = 100.f;
+
+    std::vector<DrawData> draws(a_Draws);
+    for(auto& drawData : draws)
+    {
+        drawData.mesh = meshes[rng() % meshes.size()];
+        drawData.pipelineState = pipelineStates[rng() % pipelineStates.size()];
+        drawData.materialData.material = materials[rng() % materials.size()];
+        drawData.attributes.EnableAttribute(DrawAttribute::TRANSFORMATION_MATRIX).EnableAttribute(DrawAttribute::MATERIAL_SINGLE);
+        drawData.sortDepth = std::uniform_real_distribution<float>(0.f, 110.f)(rng);
+    }
+
+    DrawSorter sorter;
+    sorter.Sort(draws.data(), a_Draws, sortSettings);
+    const auto& keys = sorter.GetKeys();
+    const auto& order = sorter.GetOrder();
+
+    //Pipeline fields follow the order of the pipeline state ids. The other fields have to give the same id to the same value, and different ids to different values.
+    std::vector<int> pipelineIds;
+    for(const auto* pipelineState : pipelineStates)
+    {
+        pipelineIds.push_back(pipelineState->GetId());
+    }
+    std::sort(pipelineIds.begin(), pipelineIds.end());
+
+    std::map<std::uint64_t, std::uint32_t> shaderFields;
+    std::map<const void*, std::uint32_t> materialFields;
+    std::map<const void*, std::uint32_t> meshFields;
+    const auto sameIds = [](auto& a_Fields, const auto& a_Value, std::uint32_t a_Field)
+    {
+        const auto result = a_Fields.emplace(a_Value, a_Field);
+        if(!result.second)
+        {
+            return result.first->second == a_Field;
+        }
+        return std::count_if(a_Fields.begin(), a_Fields.end(), [&](const auto& a_Entry) { return a_Entry.second == a_Field; }) == 1;
+    };
+
+    for(std::uint32_t i = 0; i < a_Draws; ++i)
+    {
+        const auto& drawData = draws[i];
+        const auto fields = decode(keys[i]);
+        const auto pipelineRank = std::find(pipelineIds.begin(), pipelineIds.end(), drawData.pipelineState->GetId()) - pipelineIds.begin();
+        valid = valid && fields[0] == (drawData.pipelineState->GetBlendData().blend ? 1u : 0u);
+        valid = valid && fields[1] == static_cast<std::uint32_t>(pipelineRank);
+        valid = valid && sameIds(shaderFields, DrawSorter::GetShaderMask(drawData, true), fields[2]);
+        valid = valid && sameIds(materialFields, static_cast<const void*>(drawData.materialData.material.get()), fields[3]);
+        valid = valid && sameIds(meshFields, static_cast<const void*>(drawData.mesh.get()), fields[4]);
+        valid = valid && fields[5] == DrawSorter::QuantizeDepth(drawData.sortDepth, sortSettings.nearPlane, sortSettings.farPlane);
+    }
+
+    //The order contains every draw once. Opaque draws come first, front-to-back within the same state. Blended draws are back-to-front.
+    std::vector<std::uint32_t> sortedOrder = order;
+    std::sort(sortedOrder.begin(), sortedOrder.end());
+    for(std::uint32_t i = 0; i < a_Draws; ++i)
+    {
+        valid = valid && sortedOrder[i] == i;
+    }
+    for(std::uint32_t i = 1; i < a_Draws; ++i)
+    {
+        const auto previous = decode(keys[order[i - 1]]);
+        const auto current = decode(keys[order[i]]);
+        valid = valid && keys[order[i - 1]] <= keys[order[i]];
+        valid = valid && previous[0] <= current[0];
+        if(previous[0] == 0 && current[0] == 0 && std::equal(previous.begin(), previous.begin() + 5, current.begin()))
+        {
+            valid = valid && previous[5] <= current[5];
+        }
+        if(previous[0] == 1 && current[0] == 1)
+        {
+            valid = valid && previous[5] >= current[5];
+        }
+    }
+
+    //Sorted opaque draws keep every combination of a state and the states above it in the key together, so every state changes at most once per combination.
+    std::vector<DrawData> opaqueDraws;
+    std::copy_if(draws.begin(), draws.end(), std::back_inserter(opaqueDraws), [](const DrawData& a_DrawData) { return !a_DrawData.pipelineState->GetBlendData().blend; });
+    const auto opaqueCount = static_cast<std::uint32_t>(opaqueDraws.size());
+
+    DrawSorter opaqueSorter;
+    opaqueSorter.Sort(opaqueDraws.data(), opaqueCount, sortSettings);
+
+    using Group = std::tuple<int, std::uint64_t, const void*, const void*>;
+    std::set<int> pipelineGroups;
+    std::set<std::tuple<int, std::uint64_t>> shaderGroups;
+    std::set<std::tuple<int, std::uint64_t, const void*>> materialGroups;
+    std::set<Group> meshGroups;
+    Group previous(-1, 0, nullptr, nullptr);
+    for(const auto index : opaqueSorter.GetOrder())
+    {
+        const auto& drawData = opaqueDraws[index];
+        const Group group(drawData.pipelineState->GetId(), DrawSorter::GetShaderMask(drawData, true), drawData.materialData.material.get(), drawData.mesh.get());
+
+        //A combination that was left before may not come back.
+        const int pipelineId = std::get<0>(group);
+        const std::uint64_t mask = std::get<1>(group);
+        const void* material = std::get<2>(group);
+        const bool samePipeline = pipelineId == std::get<0>(previous);
+        const bool sameShader = samePipeline && mask == std::get<1>(previous);
+        const bool sameMaterial = sameShader && material == std::get<2>(previous);
+        valid = valid && (samePipeline || pipelineGroups.insert(pipelineId).second);
+        valid = valid && (sameShader || shaderGroups.emplace(pipelineId, mask).second);
+        valid = valid && (sameMaterial || materialGroups.emplace(pipelineId, mask, material).second);
+        valid = valid && (group == previous || meshGroups.insert(group).second);
+        previous = group;
+    }
+
+    const auto opaqueSorted = DrawSorter::CountStateChanges(opaqueDraws.data(), opaqueSorter.GetOrder().data(), opaqueCount, true);
+    const auto opaqueSubmitted = DrawSorter::CountStateChanges(opaqueDraws.data(), nullptr, opaqueCount, true);
+    valid = valid && opaqueSorted.pipelineStates == pipelineGroups.size() && opaqueSorted.shaders <= shaderGroups.size();
+    valid = valid && opaqueSorted.materials <= materialGroups.size() && opaqueSorted.meshes <= meshGroups.size();
+    valid = valid && opaqueSorted.pipelineStates <= opaqueSubmitted.pipelineStates && opaqueSorted.shaders <= opaqueSubmitted.shaders;
+    valid = valid && opaqueSorted.materials <= opaqueSubmitted.materials && opaqueSorted.meshes <= opaqueSubmitted.meshes;
+
+    const auto submitted = DrawSorter::CountStateChanges(draws.data(), nullptr, a_Draws, true);
+    const auto sorted = DrawSorter::CountStateChanges(draws.data(), order.data(), a_Draws, true);
+
+    const double sortTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        sorter.Sort(draws.data(), a_Draws, sortSettings);
+    });
+
+    std::cout << "Draw sorter benchmark: " << a_Draws << " draws. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Submission order: " << submitted.pipelineStates << " pipeline states, " << submitted.shaders << " shaders, " << submitted.materials << " materials, " << submitted.meshes << " meshes" << std::endl;
+    std::cout << "    Sorted order: " << sorted.pipelineStates << " pipeline states, " << sorted.shaders << " shaders, " << sorted.materials << " materials, " << sorted.meshes << " meshes" << std::endl;
+    std::cout << "    Sort: " << sortTime << " us" << std::endl;
+
+    return valid;
+}
+
+namespace
+{
+    //Fences that only signal when told to. Waiting on a fence signals it, like the GPU catching up.
+    class FakeRingBufferFence : public blurp::RingBufferFence
+    {
+    public:
+        FakeRingBufferFence() : waits(0) {}
+
+        void Insert(std::uint64_t a_FrameId) override
+        {
+            signalled[a_FrameId] = false;
+        }
+
+        bool IsComplete(std::uint64_t a_FrameId) override
+        {
+            return signalled[a_FrameId];
+        }
+
+        void Wait(std::uint64_t a_FrameId) override
+        {
+            signalled[a_FrameId] = true;
+            ++waits;
+        }
+
+    public:
+        std::map<std::uint64_t, bool> signalled;
+        std::uint32_t waits;
+    };
+}
+
+bool BenchmarkRingBuffer(std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    bool valid = true;
+    std::uint64_t offset = 0;
+
+    //Every allocation starts at its alignment and after the previous one.
+    {
+        FakeRingBufferFence fence;
+        RingBufferAllocator allocator(1024, 3, fence);
+        allocator.BeginFrame();
+        std::uint64_t end = 0;
+        const std::uint64_t sizes[] = { 3, 10, 5, 64, 1, 17 };
+        const std::uint64_t alignments[] = { 1, 16, 256, 4, 8, 32 };
+        for(std::uint32_t i = 0; i < 6; ++i)
+        {
+            valid = valid && allocator.Allocate(sizes[i], alignments[i], offset);
+            valid = valid && offset % alignments[i] == 0 && offset >= end;
+            end = offset + sizes[i];
+        }
+
+        //Too large for the buffer, or for what is left next to the current frame.
+        valid = valid && !allocator.Allocate(2048, 16, offset) && !allocator.Allocate(1024 - 16, 16, offset);
+        valid = valid && allocator.GetStats().allocations == 6 && allocator.GetStats().wraps == 0 && fence.waits == 0;
+    }
+
+    //Fill the buffer over two frames, then wrap around while the first frame is still in use by the GPU.
+    {
+        FakeRingBufferFence fence;
+        RingBufferAllocator allocator(1024, 4, fence);
+        allocator.BeginFrame();
+        const std::uint64_t first = allocator.GetFrameId();
+        valid = valid && allocator.Allocate(400, 16, offset) && offset == 0;
+        allocator.BeginFrame();
+        const std::uint64_t second = allocator.GetFrameId();
+        valid = valid && allocator.Allocate(400, 16, offset) && offset == 400;
+        allocator.BeginFrame();
+        valid = valid && allocator.GetFramesInFlight() == 2 && fence.signalled.count(first) == 1 && fence.signalled.count(second) == 1;
+
+        //The end of the buffer is too small, and the start is only free once the fence of the first frame is passed. The allocator has to wait for it.
+        valid = valid && allocator.Allocate(300, 16, offset) && offset == 0;
+        valid = valid && fence.waits == 1 && fence.signalled[first] && !fence.signalled[second];
+        valid = valid && allocator.GetStats().wraps == 1 && allocator.GetStats().stalls == 1 && allocator.GetFramesInFlight() == 1;
+
+        //The GPU passes the fence of the second frame between two frames.
+        allocator.BeginFrame();
+        fence.signalled[second] = true;
+        allocator.BeginFrame();
+        valid = valid && allocator.GetFramesInFlight() == 1;
+
+        //Once the GPU signalled the second frame, its memory is reused without waiting.
+        valid = valid && allocator.Allocate(400, 16, offset) && offset == 304;
+        valid = valid && fence.waits == 1 && allocator.GetStats().stalls == 1;
+
+        //Nothing else is free while the third frame is in use, and it has not been signalled. The only way to make room is to wait for it.
+        valid = valid && allocator.Allocate(100, 16, offset) && fence.waits == 2 && allocator.GetStats().stalls == 2;
+
+        //A buffer that is too small for the current frame refuses instead of waiting forever.
+        allocator.WaitIdle();
+        valid = valid && allocator.GetFramesInFlight() == 0 && !allocator.Allocate(1000, 16, offset);
+    }
+
+    //No more frames than allowed are in flight. Starting a frame waits for the oldest one.
+    {
+        FakeRingBufferFence fence;
+        RingBufferAllocator allocator(1024, 2, fence);
+        for(std::uint32_t frame = 0; frame < 4; ++frame)
+        {
+            allocator.BeginFrame();
+            valid = valid && allocator.GetFramesInFlight() < 2 && allocator.Allocate(100, 16, offset);
+        }
+        valid = valid && fence.waits == 2 && allocator.GetStats().stalls == 2;
+    }
+
+    //A GPU that finishes every frame two frames later, with random allocation sizes. Allocations of frames that are still in use may never overlap.
+    std::mt19937 rng(47);
+    FakeRingBufferFence fence;
+    RingBufferAllocator allocator(1 << 14, 3, fence);
+    std::deque<std::pair<std::uint64_t, std::vector<std::pair<std::uint64_t, std::uint64_t>>>> frames;
+    const double allocateTime = Measure(a_Frames, [&](std::uint32_t)
+    {
+        allocator.BeginFrame();
+        if(frames.size() >= 2)
+        {
+            fence.signalled[frames.front().first] = true;
+            frames.pop_front();
+        }
+
+        frames.emplace_back(allocator.GetFrameId(), std::vector<std::pair<std::uint64_t, std::uint64_t>>());
+        const std::uint32_t allocations = rng() % 32;
+        for(std::uint32_t i = 0; i < allocations; ++i)
+        {
+            const std::uint64_t size = 1 + rng() % 1024;
+            const std::uint64_t alignment = 1ull << (rng() % 9);
+            if(allocator.Allocate(size, alignment, offset))
+            {
+                valid = valid && offset % alignment == 0 && offset + size <= allocator.GetCapacity();
+                for(const auto& frame : frames)
+                {
+                    //Frames that the allocator waited for have been released.
+                    const auto found = fence.signalled.find(frame.first);
+                    if(found != fence.signalled.end() && found->second)
+                    {
+                        continue;
+                    }
+
+                    for(const auto& range : frame.second)
+                    {
+                        valid = valid && (offset + size <= range.first || offset >= range.second);
+                    }
+                }
+                frames.back().second.emplace_back(offset, offset + size);
+            }
+        }
+    });
+
+    std::cout << "Ring buffer benchmark: " << a_Frames << " frames. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Allocations: " << allocator.GetStats().allocations << ", wraps: " << allocator.GetStats().wraps << ", stalls: " << allocator.GetStats().stalls << std::endl;
+    std::cout << "    Frame: " << allocateTime << " us" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkGpuBufferWriter(std::uint32_t a_Instances, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 rng(53);
+    std::uniform_real_distribution<float> distribution(-100.f, 100.f);
+    bool valid = true;
+
+    std::vector<glm::mat4> transforms(a_Instances);
+    std::vector<glm::mat4> normalMatrices(a_Instances);
+    for(std::uint32_t i = 0; i < a_Instances; ++i)
+    {
+        for(int column = 0; column < 4; ++column)
+        {
+            transforms[i][column] = glm::vec4(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+            normalMatrices[i][column] = glm::vec4(distribution(rng), distribution(rng), distribution(rng), distribution(rng));
+        }
+    }
+
+    //Two buffers that start out too small, so that both grow while being written.
+    GpuBufferSettings bufferSettings;
+    bufferSettings.size = 64;
+    bufferSettings.resizeWhenFull = true;
+    const std::shared_ptr<GpuBuffer> copied = std::make_shared<GpuBuffer_CPU>(bufferSettings);
+    const std::shared_ptr<GpuBuffer> direct = std::make_shared<GpuBuffer_CPU>(bufferSettings);
+    const auto sameBytes = [&]()
+    {
+        return std::static_pointer_cast<GpuBuffer_CPU>(copied)->GetData() == std::static_pointer_cast<GpuBuffer_CPU>(direct)->GetData();
+    };
+
+    const auto sameView = [](const GpuBufferView& a_Left, const GpuBufferView& a_Right)
+    {
+        return a_Left.start == a_Right.start && a_Left.totalSize == a_Right.totalSize && a_Left.elementSize == a_Right.elementSize && a_Left.end == a_Right.end;
+    };
+
+    //Write per instance data with WriteData into one buffer and with a writer into the other. Both buffers have to end up with the same bytes.
+    const auto writePerInstance = [&](std::uintptr_t a_Offset, std::uint32_t a_Count, bool a_Transform, bool a_NormalMatrix)
+    {
+        DrawData copiedData;
+        DrawData directData;
+        for(auto* drawData : { &copiedData, &directData })
+        {
+            drawData->instanceCount = a_Count;
+            if(a_Transform)
+            {
+                drawData->attributes.EnableAttribute(DrawAttribute::TRANSFORMATION_MATRIX);
+            }
+            if(a_NormalMatrix)
+            {
+                drawData->attributes.EnableAttribute(DrawAttribute::NORMAL_MATRIX);
+            }
+        }
+
+        const auto copiedView = copied->WriteData(static_cast<std::uint32_t>(a_Offset), PerInstanceUploadData(&copiedData, transforms.data(), normalMatrices.data()));
+
+        auto writer = direct->BeginWrite(a_Offset, directData);
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            if(a_Transform)
+            {
+                writer.transforms[i] = transforms[i];
+            }
+            if(a_NormalMatrix)
+            {
+                writer.normalMatrices[i] = normalMatrices[i];
+            }
+        }
+        direct->EndWrite();
+
+        bool same = writer.transforms.IsValid() == a_Transform && writer.normalMatrices.IsValid() == a_NormalMatrix;
+        same = same && sameView(copiedView, directData.transformData.dataRange) && sameView(copiedData.transformData.dataRange, directData.transformData.dataRange);
+        same = same && directData.transformData.dataBuffer == direct && sameBytes();
+        return std::make_pair(same, copiedView.end);
+    };
+
+    //Transforms and normal matrices interleaved, at aligned and unaligned offsets. Unaligned offsets are moved up to the next vec4.
+    auto result = writePerInstance(0, a_Instances, true, true);
+    valid = valid && result.first;
+    result = writePerInstance(result.second + 13, 7, true, true);
+    valid = valid && result.first && (result.second % 16) == 0;
+    result = writePerInstance(result.second + 3, 5, false, true);
+    valid = valid && result.first;
+    result = writePerInstance(result.second + 8, 9, true, false);
+    valid = valid && result.first;
+
+    //A writer for transforms only has the same layout as writing the matrices with OnWrite.
+    const std::uintptr_t matrixOffset = result.second + 5;
+    const auto copiedMatrices = copied->WriteData<glm::mat4>(matrixOffset, a_Instances, 16, transforms.data());
+    DrawData transformData;
+    transformData.instanceCount = a_Instances;
+    transformData.attributes.EnableAttribute(DrawAttribute::TRANSFORMATION_MATRIX);
+    auto transformWriter = direct->BeginWrite(matrixOffset, transformData);
+    for(std::uint32_t i = 0; i < a_Instances; ++i)
+    {
+        transformWriter.transforms.Write(i, transforms[i]);
+    }
+    direct->EndWrite();
+    valid = valid && sameView(copiedMatrices, transformData.transformData.dataRange) && sameBytes();
+
+    //Elements smaller than their alignment are padded (std430). The padding is left untouched by both.
+    std::vector<glm::vec3> positions(a_Instances);
+    for(auto& position : positions)
+    {
+        position = glm::vec3(distribution(rng), distribution(rng), distribution(rng));
+    }
+    const std::uintptr_t positionOffset = copiedMatrices.end + 7;
+    const auto copiedPositions = copied->WriteData<glm::vec3>(positionOffset, a_Instances, 16, positions.data());
+    auto positionWriter = direct->BeginWrite<glm::vec3>(positionOffset, a_Instances, 16);
+    for(std::uint32_t i = 0; i < a_Instances; ++i)
+    {
+        positionWriter[i] = positions[i];
+    }
+    direct->EndWrite();
+    valid = valid && positionWriter.GetStride() == 16 && copiedPositions.elementSize == 16 && sameView(copiedPositions, positionWriter.GetView());
+    valid = valid && (copiedPositions.start % 16) == 0 && sameBytes();
+
+    //Time both ways of writing the per instance data of a draw, including building the data that WriteData copies from.
+    DrawData drawData;
+    drawData.instanceCount = a_Instances;
+    drawData.attributes.EnableAttribute(DrawAttribute::TRANSFORMATION_MATRIX).EnableAttribute(DrawAttribute::NORMAL_MATRIX);
+    std::vector<glm::mat4> stagingTransforms(a_Instances);
+    std::vector<glm::mat4> stagingNormals(a_Instances);
+    const double copyTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        for(std::uint32_t i = 0; i < a_Instances; ++i)
+        {
+            stagingTransforms[i] = transforms[i];
+            stagingNormals[i] = normalMatrices[i];
+        }
+        copied->WriteData(0, PerInstanceUploadData(&drawData, stagingTransforms.data(), stagingNormals.data()));
+    });
+    const double writerTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        auto writer = direct->BeginWrite(0, drawData);
+        for(std::uint32_t i = 0; i < a_Instances; ++i)
+        {
+            writer.transforms[i] = transforms[i];
+            writer.normalMatrices[i] = normalMatrices[i];
+        }
+        direct->EndWrite();
+    });
+
+    std::cout << "Gpu buffer writer benchmark: " << a_Instances << " instances. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Staging and WriteData: " << copyTime << " us" << std::endl;
+    std::cout << "    GpuBufferWriter: " << writerTime << " us" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkTransforms(std::uint32_t a_Count, std::uint32_t a_Iterations, std::uint32_t a_DirtyPercentage)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-100.f, 100.f);
+
+    std::vector<Transform> transforms(a_Count);
+    TransformStore store;
+    store.Reserve(a_Count);
+
+    for(std::uint32_t i = 0; i < a_Count; ++i)
+    {
+        const glm::vec3 translation(distribution(random), distribution(random), distribution(random));
+        const glm::quat rotation = glm::angleAxis(distribution(random), glm::normalize(glm::vec3(distribution(random), distribution(random), 1.f)));
+        const glm::vec3 scale(1.f + std::abs(distribution(random)) * 0.01f);
+
+        transforms[i].SetTranslation(translation);
+        transforms[i].SetRotation(rotation);
+        transforms[i].SetScale(scale);
+        store.Add(translation, rotation, scale);
+    }
+
+    //Every iteration rotates a different slice of the transforms.
+    const std::uint32_t dirtyCount = std::max(1u, (a_Count * a_DirtyPercentage) / 100u);
+    const glm::quat spin = glm::angleAxis(0.01f, glm::vec3(0.f, 1.f, 0.f));
+
+    std::vector<glm::mat4> output(a_Count);
+    std::vector<glm::mat4> normalOutput(a_Count);
+
+    //Every kernel has to build the same matrices as Transform, and the inverse transpose of their upper 3x3 as normal matrix.
+    //The amount of transforms is not a multiple of 4 or 8, so that the SIMD kernels also finish with the scalar kernel.
+    //The last index is 1026, which is not a multiple of 5.
+    constexpr std::uint32_t checkCount = 1027;
+    constexpr float epsilon = 0.0001f;
+    const auto closeTo = [epsilon](float a_Value, float a_Expected)
+    {
+        return std::abs(a_Value - a_Expected) <= epsilon * std::max(1.f, std::abs(a_Expected));
+    };
+
+    bool valid = true;
+    const char* kernelNames[] = { "scalar", "SSE", "AVX" };
+    for(const auto kernel : { TransformKernel::SCALAR, TransformKernel::SSE, TransformKernel::AVX })
+    {
+        if(!TransformStore::IsKernelSupported(kernel))
+        {
+            continue;
+        }
+
+        //The same random transforms for every kernel.
+        std::mt19937 checkRandom(7);
+        std::vector<Transform> checkTransforms(checkCount);
+        TransformStore checkStore;
+        for(auto& transform : checkTransforms)
+        {
+            const glm::vec3 translation(distribution(checkRandom), distribution(checkRandom), distribution(checkRandom));
+            const glm::quat rotation = glm::angleAxis(distribution(checkRandom), glm::normalize(glm::vec3(distribution(checkRandom), distribution(checkRandom), 1.f)));
+            const glm::vec3 scale(1.f + std::abs(distribution(checkRandom)) * 0.01f, 1.f, 1.f + std::abs(distribution(checkRandom)) * 0.02f);
+
+            transform.SetTranslation(translation);
+            transform.SetRotation(rotation);
+            transform.SetScale(scale);
+            checkStore.Add(translation, rotation, scale);
+        }
+
+        std::vector<glm::mat4> checkOutput(checkCount);
+        std::vector<glm::mat4> checkNormals(checkCount);
+        const auto matches = [&]()
+        {
+            bool same = true;
+            for(std::uint32_t i = 0; i < checkCount; ++i)
+            {
+                const glm::mat4 expected = checkTransforms[i].GetTransformation();
+                const glm::mat3 expectedNormal = glm::transpose(glm::inverse(glm::mat3(expected)));
+                for(int column = 0; column < 4; ++column)
+                {
+                    for(int row = 0; row < 4; ++row)
+                    {
+                        same = same && closeTo(checkOutput[i][column][row], expected[column][row]);
+                        same = same && (column == 3 || row == 3 || closeTo(checkNormals[i][column][row], expectedNormal[column][row]));
+                    }
+                }
+            }
+            return same;
+        };
+
+        valid = valid && checkStore.Compose(checkOutput.data(), checkNormals.data(), kernel) == checkCount && matches();
+
+        //Only the changed transforms are built again, including the last one which is left for the scalar kernel.
+        std::vector<std::uint32_t> changed;
+        for(std::uint32_t i = 0; i < checkCount; i += 5)
+        {
+            changed.push_back(i);
+        }
+        changed.push_back(checkCount - 1);
+        for(const auto index : changed)
+        {
+            checkTransforms[index].Rotate(spin);
+            checkStore.Rotate(index, spin);
+        }
+        valid = valid && checkStore.Compose(checkOutput.data(), checkNormals.data(), kernel) == changed.size() && matches();
+    }
+
+    std::cout << "Transform benchmark: " << a_Count << " transforms, " << a_DirtyPercentage << "% changed per iteration. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+
+    const double transformTime = Measure(a_Iterations, [&](std::uint32_t a_Iteration)
+    {
+        const std::uint32_t first = (a_Iteration * dirtyCount) % a_Count;
+        for(std::uint32_t i = 0; i < dirtyCount; ++i)
+        {
+            transforms[(first + i) % a_Count].Rotate(spin);
+        }
+
+        //This is how the matrices are gathered for rendering in the demos.
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            output[i] = transforms[i].GetTransformation();
+        }
+    });
+
+    std::cout << "    Transform:              " << transformTime << " us" << std::endl;
+
+    for(const auto kernel : { TransformKernel::SCALAR, TransformKernel::SSE, TransformKernel::AVX })
+    {
+        if(!TransformStore::IsKernelSupported(kernel))
+        {
+            std::cout << "    TransformStore (" << kernelNames[static_cast<int>(kernel)] << "): not compiled in." << std::endl;
+            continue;
+        }
+
+        for(const bool normals : { false, true })
+        {
+            store.MarkAllDirty();
+            store.Compose(output.data(), normals ? normalOutput.data() : nullptr, kernel);
+
+            const double storeTime = Measure(a_Iterations, [&](std::uint32_t a_Iteration)
+            {
+                const std::uint32_t first = (a_Iteration * dirtyCount) % a_Count;
+                for(std::uint32_t i = 0; i < dirtyCount; ++i)
+                {
+                    store.Rotate((first + i) % a_Count, spin);
+                }
+
+                store.Compose(output.data(), normals ? normalOutput.data() : nullptr, kernel);
+            });
+
+            std::cout << "    TransformStore (" << kernelNames[static_cast<int>(kernel)] << (normals ? ", normals" : "") << "): " << storeTime << " us (" << transformTime / storeTime << "x)" << std::endl;
+        }
+    }
+
+    return valid;
+}
+
+bool BenchmarkCulling(std::uint32_t a_Count, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    //Instances are spread around the camera, so that part of them is visible.
+    std::vector<glm::mat4> transforms(a_Count);
+    for(auto& transform : transforms)
+    {
+        const glm::vec3 translation(distribution(random) * 500.f, distribution(random) * 500.f, distribution(random) * 500.f);
+        const glm::quat rotation = glm::normalize(glm::quat(distribution(random), distribution(random), distribution(random), distribution(random)));
+        transform = glm::translate(glm::mat4(1.f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.f), glm::vec3(1.f + distribution(random) * 0.5f));
+    }
+
+    const glm::mat4 projection = glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 400.f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+    const Frustum frustum = ExtractFrustum(projection * view);
+
+    MeshBounds bounds;
+    bounds.center = glm::vec3(0.f, 0.5f, 0.f);
+    bounds.radius = 3.f;
+
+    std::vector<glm::mat4> output(a_Count);
+    std::vector<glm::mat4> referenceOutput(a_Count);
+
+    //Both the compacted and the partitioned output have to be identical.
+    bool valid = true;
+    for(const bool keepCulled : { false, true })
+    {
+        const auto visible = CullInstances(frustum, bounds, transforms.data(), a_Count, output.data(), keepCulled);
+        const auto referenceVisible = CullInstancesReference(frustum, bounds, transforms.data(), a_Count, referenceOutput.data(), keepCulled);
+        const auto compared = keepCulled ? a_Count : visible;
+        valid = valid && visible == referenceVisible && (compared == 0 || memcmp(output.data(), referenceOutput.data(), compared * sizeof(glm::mat4)) == 0);
+    }
+
+    std::uint32_t visible = 0;
+    const double referenceTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        visible = CullInstancesReference(frustum, bounds, transforms.data(), a_Count, output.data());
+    });
+
+    const double kernelTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        visible = CullInstances(frustum, bounds, transforms.data(), a_Count, output.data());
+    });
+
+    std::cout << "Culling benchmark: " << a_Count << " instances, " << visible << " visible. Results " << (valid ? "match" : "DO NOT MATCH") << " the reference." << std::endl;
+    std::cout << "    Reference: " << referenceTime << " us" << std::endl;
+    std::cout << "    Kernel:    " << kernelTime << " us (" << referenceTime / kernelTime << "x)" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkLightClusters(std::uint32_t a_PointCount, std::uint32_t a_SpotCount, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    CameraSettings cameraSettings;
+    cameraSettings.width = 1920;
+    cameraSettings.height = 1080;
+    cameraSettings.fov = 70.f;
+    cameraSettings.nearPlane = 0.1f;
+    cameraSettings.farPlane = 400.f;
+    Camera camera(cameraSettings);
+    camera.GetTransform().Rotate(glm::vec3(0.f, 1.f, 0.f), 0.3f);
+
+    //Lights are spread around the camera, so that part of them is in view and some of them cross the near plane.
+    std::vector<std::shared_ptr<PointLight>> pointLights;
+    std::vector<std::shared_ptr<SpotLight>> spotLights;
+
+    for(std::uint32_t i = 0; i < a_PointCount + a_SpotCount; ++i)
+    {
+        LightSettings settings;
+        settings.color = glm::vec3(distribution(random), distribution(random), distribution(random)) * 0.5f + 0.5f;
+        settings.intensity = 1.f + (distribution(random) + 1.f) * 10.f;
+
+        //Every fourth light casts shadows, so that both halves of the uploaded arrays are used.
+        settings.shadowMapIndex = i % 4 == 0 ? static_cast<std::int32_t>(i / 4) : -1;
+
+        const glm::vec3 position(distribution(random) * 200.f, distribution(random) * 50.f, distribution(random) * 200.f);
+
+        if(i < a_PointCount)
+        {
+            settings.type = LightType::LIGHT_POINT;
+            settings.pointLight.position = position;
+            pointLights.push_back(std::make_shared<PointLight>(settings));
+        }
+        else
+        {
+            settings.type = LightType::LIGHT_SPOT;
+            settings.spotLight.position = position;
+            settings.spotLight.direction = glm::normalize(glm::vec3(distribution(random), distribution(random), distribution(random)) + glm::vec3(0.f, 0.f, 0.01f));
+            settings.spotLight.angle = glm::radians(5.f + (distribution(random) + 1.f) * 50.f);
+            spotLights.push_back(std::make_shared<SpotLight>(settings));
+        }
+    }
+
+    LightData lightData;
+    LightUploadData upload;
+    upload.lightData = &lightData;
+    upload.point.count = static_cast<std::uint32_t>(pointLights.size());
+    upload.point.lights = pointLights.empty() ? nullptr : &pointLights[0];
+    upload.spot.count = static_cast<std::uint32_t>(spotLights.size());
+    upload.spot.lights = spotLights.empty() ? nullptr : &spotLights[0];
+
+    LightClusterBuilder builder;
+    LightClusterBuilder reference;
+
+    builder.Build(camera, upload);
+    reference.BuildReference(camera, upload);
+
+    const auto& cells = builder.GetCells();
+    const auto& referenceCells = reference.GetCells();
+    const auto& indices = builder.GetLightIndices();
+    const auto& referenceIndices = reference.GetLightIndices();
+
+    const bool valid = cells.size() == referenceCells.size() && indices == referenceIndices
+        && (cells.empty() || memcmp(cells.data(), referenceCells.data(), cells.size() * sizeof(LightClusterCell)) == 0);
+
+    const double referenceTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        reference.BuildReference(camera, upload);
+    });
+
+    const double builderTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        builder.Build(camera, upload);
+    });
+
+    const auto& stats = builder.GetStats();
+    std::cout << "Light cluster benchmark: " << a_PointCount << " point lights, " << a_SpotCount << " spot lights, " << cells.size() << " clusters. Results " << (valid ? "match" : "DO NOT MATCH") << " the reference." << std::endl;
+    std::cout << "    Light indices: " << stats.lightIndices << ", most lights in a cluster: " << stats.maxLightsPerCluster << std::endl;
+    std::cout << "    Reference: " << referenceTime << " us (" << reference.GetStats().clusterTests << " tests)" << std::endl;
+    std::cout << "    Builder:   " << builderTime << " us (" << stats.clusterTests << " tests, " << referenceTime / builderTime << "x)" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkShadowScheduler(std::uint32_t a_Count, std::uint32_t a_Slots, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    CameraSettings cameraSettings;
+    cameraSettings.width = 1920;
+    cameraSettings.height = 1080;
+    cameraSettings.fov = 70.f;
+    cameraSettings.nearPlane = 0.1f;
+    cameraSettings.farPlane = 400.f;
+    Camera camera(cameraSettings);
+
+    //Every light starts at a random position and moves a little every frame.
+    std::vector<glm::vec3> startPositions(a_Count);
+    std::vector<glm::vec3> velocities(a_Count);
+    std::vector<std::shared_ptr<PointLight>> lights;
+
+    for(std::uint32_t i = 0; i < a_Count; ++i)
+    {
+        LightSettings settings;
+        settings.type = LightType::LIGHT_POINT;
+        settings.color = glm::vec3(distribution(random), distribution(random), distribution(random)) * 0.5f + 0.5f;
+        settings.intensity = 1.f + (distribution(random) + 1.f) * 20.f;
+        lights.push_back(std::make_shared<PointLight>(settings));
+
+        startPositions[i] = glm::vec3(distribution(random) * 100.f, distribution(random) * 20.f, distribution(random) * 100.f);
+        velocities[i] = glm::vec3(distribution(random), distribution(random), distribution(random)) * 0.2f;
+    }
+
+    LightData lightData;
+    LightUploadData upload;
+    upload.lightData = &lightData;
+    upload.point.count = a_Count;
+    upload.point.lights = lights.empty() ? nullptr : &lights[0];
+
+    const Frustum frustum = camera.GetFrustum();
+    bool valid = true;
+
+    //Run all frames with the given hysteresis. The slots of every frame are stored so that runs can be compared.
+    const auto run = [&](float a_Hysteresis, std::vector<const Light*>& a_History, double& a_Time)
+    {
+        ShadowSchedulerSettings settings;
+        settings.slots = a_Slots;
+        settings.hysteresis = a_Hysteresis;
+
+        ShadowLightScheduler scheduler;
+        scheduler.SetSettings(settings);
+
+        a_History.clear();
+        a_Time = 0.0;
+
+        for(std::uint32_t frame = 0; frame < a_Frames; ++frame)
+        {
+            for(std::uint32_t i = 0; i < a_Count; ++i)
+            {
+                lights[i]->SetPosition(startPositions[i] + velocities[i] * static_cast<float>(frame));
+            }
+
+            //Remember which lights had a slot, so that the hysteresis bonus can be accounted for.
+            std::vector<bool> hadSlot(a_Count);
+            for(std::uint32_t i = 0; i < a_Count; ++i)
+            {
+                hadSlot[i] = std::find(scheduler.GetSlots().begin(), scheduler.GetSlots().end(), lights[i]) != scheduler.GetSlots().end();
+            }
+
+            a_Time += Measure(1, [&](std::uint32_t)
+            {
+                scheduler.Schedule(camera, upload);
+            });
+
+            //No light without a slot may have a higher score than a light with one.
+            float lowestAssigned = std::numeric_limits<float>::max();
+            float highestUnassigned = 0.f;
+            for(std::uint32_t i = 0; i < a_Count; ++i)
+            {
+                const auto data = lights[i]->GetData();
+                float score = ShadowLightScheduler::CalculateScore(camera, frustum, data.positionShadowMapIndex, data.colorIntensity, 1.f, settings);
+                if(hadSlot[i])
+                {
+                    score *= 1.f + a_Hysteresis;
+                }
+
+                if(lights[i]->GetShadowMapIndex() >= 0)
+                {
+                    lowestAssigned = std::min(lowestAssigned, score);
+                }
+                else
+                {
+                    highestUnassigned = std::max(highestUnassigned, score);
+                }
+            }
+            valid = valid && lowestAssigned >= highestUnassigned;
+
+            for(const auto& light : scheduler.GetSlots())
+            {
+                a_History.push_back(light.get());
+            }
+        }
+
+        scheduler.Clear();
+        return scheduler.GetStats().totalSlotChanges;
+    };
+
+    std::vector<const Light*> history;
+    std::vector<const Light*> repeatHistory;
+    std::vector<const Light*> instantHistory;
+    double time = 0.0;
+    double repeatTime = 0.0;
+    double instantTime = 0.0;
+
+    const auto changes = run(ShadowSchedulerSettings().hysteresis, history, time);
+    run(ShadowSchedulerSettings().hysteresis, repeatHistory, repeatTime);
+    const auto instantChanges = run(0.f, instantHistory, instantTime);
+
+    valid = valid && history == repeatHistory;
+
+    std::cout << "Shadow scheduler benchmark: " << a_Count << " lights, " << a_Slots << " slots, " << a_Frames << " frames. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Without hysteresis: " << instantChanges << " slot changes, " << instantTime / a_Frames << " us per frame" << std::endl;
+    std::cout << "    With hysteresis:    " << changes << " slot changes, " << time / a_Frames << " us per frame" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkShadowCache(std::uint32_t a_Lights, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    assert(a_Lights >= 3 && a_Lights <= MAX_SHADOW_LIGHTS && "Shadow cache benchmark needs between 3 and 64 lights.");
+
+    constexpr float nearPlane = 0.1f;
+    constexpr float farPlane = 50.f;
+
+    //The lights are further apart than the far plane, so that they can not see each others surroundings.
+    std::vector<LightShadowData> lights;
+    for(std::uint32_t i = 0; i < a_Lights; ++i)
+    {
+        lights.emplace_back(static_cast<std::int32_t>(i), glm::vec3(static_cast<float>(i) * 200.f, 0.f, 0.f));
+    }
+
+    //One static draw for every light, and one dynamic draw for the first light.
+    std::vector<DrawData> drawData(2);
+    std::vector<LightIndexData> lightIndices(2);
+    drawData[0].instanceCount = 10;
+    drawData[1].instanceCount = 1;
+    lightIndices[0].staticCaster = true;
+    for(std::uint32_t i = 0; i < a_Lights; ++i)
+    {
+        lightIndices[0].posLights.set(i);
+    }
+    lightIndices[1].posLights.set(0);
+
+    bool valid = true;
+    const auto check = [&](const PositionalShadowCache& a_Cache, std::uint32_t a_Cached, std::uint32_t a_Redrawn, std::uint32_t a_StaticRedrawn, std::uint32_t a_Restored)
+    {
+        const auto& stats = a_Cache.GetStats();
+        valid = valid && stats.faces == a_Lights * 6 && stats.cached == a_Cached && stats.redrawn == a_Redrawn && stats.staticRedrawn == a_StaticRedrawn && stats.restored == a_Restored;
+        valid = valid && stats.clearedLayers == a_Redrawn + a_StaticRedrawn;
+    };
+
+    const auto update = [&](PositionalShadowCache& a_Cache, std::uint32_t a_DrawCount)
+    {
+        a_Cache.Update(&lights[0], a_Lights, &drawData[0], &lightIndices[0], a_DrawCount, nearPlane, farPlane);
+    };
+
+    const std::uint32_t allFaces = a_Lights * 6;
+
+    /*
+     * With static layers, dynamic casters only restore the faces of their light.
+     */
+    PositionalShadowCacheSettings settings;
+    settings.slots = a_Lights;
+    settings.staticLayers = true;
+    PositionalShadowCache cache;
+    cache.SetSettings(settings);
+
+    //Nothing was drawn yet. Every layer is cleared in a single region.
+    update(cache, 2);
+    check(cache, 0, 0, allFaces, 0);
+    valid = valid && cache.GetStats().newLights == a_Lights;
+
+    std::vector<ClearData> regions;
+    cache.GetClearRegions(true, ClearData(), regions);
+    valid = valid && regions.size() == 1 && regions[0].offset.z == 0.f && regions[0].size.z == static_cast<float>(allFaces);
+
+    //Nothing changed. Only the light with the dynamic caster does any work, and nothing is cleared.
+    update(cache, 2);
+    check(cache, allFaces - 6, 0, 0, 6);
+    regions.clear();
+    cache.GetClearRegions(true, ClearData(), regions);
+    cache.GetClearRegions(false, ClearData(), regions);
+    valid = valid && regions.empty() && cache.GetFaceMask(0, ShadowFaceUpdate::RESTORE) == 0x3Fu;
+
+    //The second light moves.
+    lights[1].data.y += 1.f;
+    update(cache, 2);
+    check(cache, allFaces - 12, 0, 6, 6);
+    valid = valid && cache.GetStats().movedLights == 1 && cache.GetFaceMask(1, ShadowFaceUpdate::REDRAW_STATIC) == 0x3Fu;
+
+    //A static caster changes next to the third light, in the +X direction.
+    cache.Invalidate(lights[2].data + glm::vec3(10.f, 0.f, 0.f), 1.f);
+    update(cache, 2);
+    check(cache, allFaces - 7, 0, 1, 6);
+    valid = valid && cache.GetStats().staticInvalidated == 1 && cache.GetFaceUpdate(2, 0) == ShadowFaceUpdate::REDRAW_STATIC;
+
+    //A static caster is added, which changes the static casters of every light.
+    drawData[0].instanceCount = 11;
+    update(cache, 2);
+    check(cache, 0, 0, allFaces, 0);
+
+    //The dynamic caster is gone. Its shadow is removed once, after that everything is cached.
+    update(cache, 1);
+    check(cache, allFaces - 6, 0, 0, 6);
+    update(cache, 1);
+    check(cache, allFaces, 0, 0, 0);
+
+    /*
+     * Without static layers, the faces with dynamic casters are cleared and drawn completely.
+     */
+    settings.staticLayers = false;
+    PositionalShadowCache simpleCache;
+    simpleCache.SetSettings(settings);
+
+    update(simpleCache, 2);
+    check(simpleCache, 0, allFaces, 0, 0);
+    update(simpleCache, 2);
+    check(simpleCache, allFaces - 6, 6, 0, 0);
+
+    regions.clear();
+    simpleCache.GetClearRegions(false, ClearData(), regions);
+    valid = valid && regions.size() == 1 && regions[0].offset.z == 0.f && regions[0].size.z == 6.f;
+
+    //Time the update of a scene where only the dynamic caster changes.
+    const double time = Measure(a_Frames, [&](std::uint32_t)
+    {
+        update(cache, 2);
+    });
+
+    std::cout << "Shadow cache benchmark: " << a_Lights << " lights, " << a_Frames << " frames. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    " << cache.GetStats().totalCached << " faces cached, " << cache.GetStats().totalDrawn << " faces drawn, " << time << " us per update" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkCascadeScheduler(std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    constexpr std::uint32_t resolution = 2048;
+    constexpr std::uint32_t numCascades = 6;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    bool valid = true;
+
+    //Snapped matrices put the world origin on a texel corner, and never move by more than half a texel.
+    for(std::uint32_t i = 0; i < 1000; ++i)
+    {
+        glm::mat4 matrix = glm::ortho(-100.f, 100.f, -100.f, 100.f, 0.1f, 1000.f) * glm::lookAt(glm::vec3(0.f), glm::normalize(glm::vec3(distribution(random), -1.f, distribution(random))), glm::vec3(0.f, 1.f, 0.f));
+        matrix[3][0] += distribution(random);
+        matrix[3][1] += distribution(random);
+
+        const glm::mat4 original = matrix;
+        RenderPass_ShadowMap::SnapToTexels(matrix, resolution);
+
+        const glm::vec2 texel = glm::vec2(matrix[3]) * (resolution * 0.5f);
+        valid = valid && glm::all(glm::lessThan(glm::abs(texel - glm::round(texel)), glm::vec2(0.01f)));
+        valid = valid && CascadeScheduler::CalculateTexelShift(original, matrix, resolution) <= 0.5f + 0.01f;
+    }
+
+    CameraSettings cameraSettings;
+    cameraSettings.width = 1920;
+    cameraSettings.height = 1080;
+    cameraSettings.fov = 90.f;
+    cameraSettings.nearPlane = 0.1f;
+    cameraSettings.farPlane = 4000.f;
+    Camera camera(cameraSettings);
+
+    ShadowData shadowData;
+    shadowData.directional.numCascades = numCascades;
+    shadowData.directional.cascadeDistances = { 10.f, 30.f, 90.f, 270.f, 810.f, 2790.f };
+
+    std::vector<LightShadowData> lights;
+    lights.emplace_back(0, glm::normalize(glm::vec3(0.3f, -1.f, 0.2f)));
+    lights.emplace_back(1, glm::normalize(glm::vec3(-0.5f, -0.4f, 1.f)));
+
+    CascadeSchedulerSettings settings;
+    settings.intervals = { 1, 1, 2, 4, 8, 8 };
+    settings.texelThreshold = 1.f;
+    settings.resolution = resolution;
+
+    CascadeScheduler scheduler;
+    scheduler.SetSettings(settings);
+
+    std::vector<glm::mat4> matrices(numCascades);
+    std::vector<glm::vec4> clipDepths(numCascades);
+    std::vector<ClearData> regions;
+    double time = 0.0;
+
+    for(std::uint32_t frame = 0; frame < a_Frames; ++frame)
+    {
+        //Stand still for a while, then fly forward.
+        if(frame >= a_Frames / 2)
+        {
+            camera.GetTransform().Translate(glm::vec3(0.f, 0.f, -0.5f));
+        }
+
+        time += Measure(1, [&](std::uint32_t)
+        {
+            scheduler.Schedule(camera, &lights[0], static_cast<std::uint32_t>(lights.size()), shadowData);
+        });
+
+        const auto& stats = scheduler.GetStats();
+        const std::uint32_t mask = scheduler.GetUpdateMask();
+        valid = valid && stats.updatedMask == mask && (stats.updatedMask | stats.skippedMask) == (1u << numCascades) - 1u && (stats.updatedMask & stats.skippedMask) == 0;
+
+        //The first frame draws everything. While standing still, only the cascades whose interval came around are drawn.
+        if(frame == 0)
+        {
+            valid = valid && mask == (1u << numCascades) - 1u;
+        }
+        else if(frame < a_Frames / 2)
+        {
+            std::uint32_t expected = 0;
+            for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+            {
+                const std::uint32_t interval = settings.intervals[cascade];
+                expected |= frame % interval == cascade % interval ? (1u << cascade) : 0u;
+            }
+            valid = valid && mask == expected && stats.movedCascades == 0;
+        }
+
+        //Drawn cascades use the volume of the current camera. Skipped ones are never further away from it than the threshold.
+        for(std::uint32_t light = 0; light < lights.size(); ++light)
+        {
+            RenderPass_ShadowMap::CalculateCascades(camera, lights[light].data, shadowData, &matrices[0], &clipDepths[0]);
+            for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+            {
+                const auto& scheduled = scheduler.GetMatrices()[light * numCascades + cascade];
+                if((mask & (1u << cascade)) != 0)
+                {
+                    valid = valid && scheduled == matrices[cascade];
+                }
+                else
+                {
+                    valid = valid && CascadeScheduler::CalculateTexelShift(scheduled, matrices[cascade], resolution) <= settings.texelThreshold;
+                }
+                valid = valid && scheduler.GetClipDepths()[light * numCascades + cascade] == clipDepths[cascade];
+            }
+        }
+
+        //Exactly the layers of the drawn cascades are cleared.
+        regions.clear();
+        scheduler.GetClearRegions(ClearData(), regions);
+        float clearedLayers = 0.f;
+        for(auto& region : regions)
+        {
+            clearedLayers += region.size.z;
+        }
+        valid = valid && clearedLayers == static_cast<float>(std::bitset<32>(mask).count() * lights.size());
+    }
+
+    const auto& stats = scheduler.GetStats();
+    std::cout << "Cascade scheduler benchmark: " << lights.size() << " lights, " << numCascades << " cascades, " << a_Frames << " frames. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    " << stats.totalUpdated << " cascades drawn, " << stats.totalSkipped << " cascades skipped, " << time / a_Frames << " us per frame" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkCubeFaceCulling(std::uint32_t a_Count, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+
+    constexpr float nearPlane = 0.1f;
+    constexpr float farPlane = 50.f;
+
+    //Spheres are spread around the light, so that part of them is out of range and part of them crosses the edges between faces.
+    const glm::vec3 lightPosition(3.f, -2.f, 7.f);
+    std::vector<glm::vec4> spheres(a_Count);
+    for(auto& sphere : spheres)
+    {
+        sphere = glm::vec4(lightPosition + glm::vec3(distribution(random), distribution(random), distribution(random)) * 60.f, 2.5f + distribution(random) * 2.f);
+    }
+
+    glm::mat4 faces[6];
+    RenderPass_ShadowMap::CalculateCubeFaces(lightPosition, nearPlane, farPlane, faces);
+    Frustum frustums[6];
+    for(int face = 0; face < 6; ++face)
+    {
+        frustums[face] = ExtractFrustum(faces[face]);
+    }
+
+    const auto reference = [&](const glm::vec4& a_Sphere, float a_Radius)
+    {
+        std::uint32_t mask = 0;
+        for(int face = 0; face < 6; ++face)
+        {
+            bool inside = true;
+            for(const auto& plane : frustums[face].planes)
+            {
+                inside = inside && glm::dot(glm::vec3(plane), glm::vec3(a_Sphere)) + plane.w >= -a_Radius;
+            }
+            mask |= inside ? 1u << face : 0u;
+        }
+        return mask;
+    };
+
+    //Faces may only differ where growing or shrinking the sphere by a tiny amount changes the reference result.
+    bool valid = true;
+    std::uint64_t visibleFaces = 0;
+    for(const auto& sphere : spheres)
+    {
+        const float epsilon = 1e-4f * (1.f + glm::length(glm::vec3(sphere) - lightPosition));
+        const std::uint32_t mask = RenderPass_ShadowMap::CalculateCubeFaceMask(lightPosition, nearPlane, farPlane, glm::vec3(sphere), sphere.w);
+        valid = valid && (mask & ~reference(sphere, sphere.w + epsilon)) == 0 && (reference(sphere, sphere.w - epsilon) & ~mask) == 0;
+        visibleFaces += std::bitset<6>(mask).count();
+    }
+
+    std::uint32_t result = 0;
+    const double referenceTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        for(const auto& sphere : spheres)
+        {
+            result |= reference(sphere, sphere.w);
+        }
+    });
+
+    const double maskTime = Measure(a_Iterations, [&](std::uint32_t)
+    {
+        for(const auto& sphere : spheres)
+        {
+            result |= RenderPass_ShadowMap::CalculateCubeFaceMask(lightPosition, nearPlane, farPlane, glm::vec3(sphere), sphere.w);
+        }
+    });
+
+    /*
+     * Cull the spheres for a directional light and several point lights, and check that every instance ends up in the list for its cascade or face mask.
+     * The point lights have different intensities, so that their range is cut off by the light cutoff or by the camera far plane.
+     */
+    constexpr float lightCutoff = 0.01f;
+    constexpr std::uint32_t numCascades = 3;
+    CameraSettings cameraSettings;
+    cameraSettings.nearPlane = nearPlane;
+    cameraSettings.farPlane = farPlane;
+    auto camera = std::make_shared<Camera>(cameraSettings);
+
+    ShadowData shadowData;
+    shadowData.directional.numCascades = numCascades;
+    shadowData.directional.cascadeDistances = { 5.f, 15.f, 50.f };
+
+    ShadowCasterCuller culler;
+    culler.SetCamera(camera);
+    culler.SetShadowData(shadowData);
+    culler.SetLightCutoff(lightCutoff);
+
+    LightSettings sunSettings;
+    sunSettings.type = LightType::LIGHT_DIRECTIONAL;
+    sunSettings.directionalLight.direction = glm::normalize(glm::vec3(0.3f, -1.f, 0.2f));
+    culler.AddLight(std::make_shared<DirectionalLight>(sunSettings));
+
+    const float intensities[] = { 1.f, 4.f, 16.f, 100.f };
+    std::vector<glm::vec3> lightPositions;
+    std::vector<float> lightRanges;
+    for(const float intensity : intensities)
+    {
+        LightSettings settings;
+        settings.type = LightType::LIGHT_POINT;
+        settings.intensity = intensity;
+        settings.pointLight.position = lightPosition + glm::vec3(distribution(random), distribution(random), distribution(random)) * 20.f;
+        lightPositions.push_back(settings.pointLight.position);
+        lightRanges.push_back(std::min(std::sqrt(intensity / lightCutoff), farPlane));
+        culler.AddLight(std::make_shared<PointLight>(settings));
+    }
+
+    //The instances use the spheres as translation and uniform scale of a unit sphere.
+    MeshBounds bounds;
+    bounds.center = glm::vec3(0.f);
+    bounds.radius = 1.f;
+    std::vector<glm::mat4> transforms(a_Count);
+    for(std::uint32_t i = 0; i < a_Count; ++i)
+    {
+        transforms[i] = glm::translate(glm::mat4(1.f), glm::vec3(spheres[i])) * glm::scale(glm::mat4(1.f), glm::vec3(spheres[i].w));
+    }
+
+    const auto& lists = culler.Cull(bounds, transforms.data(), a_Count);
+
+    //Every cascade has the same casters as camera culling with its volume.
+    std::vector<glm::mat4> cascadeOutput(a_Count);
+    std::uint64_t cascadeCasters = 0;
+    for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+    {
+        const auto expected = CullInstancesReference(culler.GetCascadeVolume(0, cascade), bounds, transforms.data(), a_Count, cascadeOutput.data());
+        valid = valid && culler.GetStats().cascadeCasters[cascade] == expected;
+        cascadeCasters += expected;
+    }
+
+    //Instances that are in several cascades are listed once, in the list for exactly those cascades.
+    const auto cascadeMaskOf = [&](const glm::mat4& a_Transform)
+    {
+        std::uint32_t mask = 0;
+        for(std::uint32_t cascade = 0; cascade < numCascades; ++cascade)
+        {
+            mask |= CullInstancesReference(culler.GetCascadeVolume(0, cascade), bounds, &a_Transform, 1, cascadeOutput.data()) << cascade;
+        }
+        return mask;
+    };
+
+    std::uint32_t cascadeLists = 0;
+    std::uint32_t usedCascadeMasks = 0;
+    std::uint64_t cascadeListed = 0;
+    for(const auto* list : lists)
+    {
+        if(!list->lights.dirLights.test(0))
+        {
+            continue;
+        }
+
+        const std::uint32_t mask = list->lights.cascadeMask;
+        valid = valid && list->lights.dirLights.count() == 1 && list->lights.posLights.none() && mask != 0 && (usedCascadeMasks & (1u << mask)) == 0 && !list->transforms.empty();
+        usedCascadeMasks |= 1u << mask;
+        for(const auto& transform : list->transforms)
+        {
+            valid = valid && cascadeMaskOf(transform) == mask;
+        }
+        cascadeListed += list->transforms.size();
+        ++cascadeLists;
+    }
+
+    std::uint64_t expectedDirectional = 0;
+    for(const auto& transform : transforms)
+    {
+        expectedDirectional += cascadeMaskOf(transform) != 0 ? 1 : 0;
+    }
+    valid = valid && cascadeListed == expectedDirectional && culler.GetStats().directionalCasters[0] == expectedDirectional;
+
+    std::uint64_t expectedCasters = 0;
+    for(std::size_t light = 0; light < lightPositions.size(); ++light)
+    {
+        const float range = lightRanges[light];
+        valid = valid && std::abs(culler.GetLightRange(static_cast<std::uint32_t>(light)) - range) <= 1e-4f * range;
+
+        std::uint32_t listed = 0;
+        std::uint32_t prevMask = 0;
+        for(const auto* list : lists)
+        {
+            if(!list->lights.posLights.test(light))
+            {
+                continue;
+            }
+
+            //Every face mask has a single list, and the lists of a light are in order.
+            valid = valid && list->lights.posLights.count() == 1 && list->lights.faceMask > prevMask && !list->transforms.empty();
+            prevMask = list->lights.faceMask;
+
+            for(const auto& transform : list->transforms)
+            {
+                valid = valid && RenderPass_ShadowMap::CalculateCubeFaceMask(lightPositions[light], nearPlane, range, glm::vec3(transform[3]), glm::length(glm::vec3(transform[0]))) == list->lights.faceMask;
+            }
+            listed += static_cast<std::uint32_t>(list->transforms.size());
+        }
+
+        std::uint32_t expected = 0;
+        for(const auto& sphere : spheres)
+        {
+            const float reach = range + sphere.w;
+            const glm::vec3 offset = glm::vec3(sphere) - lightPositions[light];
+            expected += glm::dot(offset, offset) <= reach * reach && RenderPass_ShadowMap::CalculateCubeFaceMask(lightPositions[light], nearPlane, range, glm::vec3(sphere), sphere.w) != 0 ? 1 : 0;
+        }
+
+        valid = valid && listed == expected && culler.GetStats().positionalCasters[light] == expected;
+        expectedCasters += expected;
+    }
+
+    const auto& stats = culler.GetStats();
+    std::uint64_t faceCasters = 0;
+    for(auto count : stats.faceCasters)
+    {
+        faceCasters += count;
+    }
+    valid = valid && faceCasters == stats.faceInstances && stats.faceInstances + stats.skippedFaceInstances == expectedCasters * 6;
+
+    std::cout << "Cube face culling benchmark: " << a_Count << " spheres, " << visibleFaces << " faces visible. Results " << (valid ? "match" : "DO NOT MATCH") << " the reference." << std::endl;
+    std::cout << "    Reference: " << referenceTime << " us" << std::endl;
+    std::cout << "    Face mask: " << maskTime << " us (" << referenceTime / maskTime << "x)" << std::endl;
+    std::cout << "    Culler: " << stats.faceInstances << " faces drawn, " << stats.skippedFaceInstances << " faces skipped for " << expectedCasters << " casters, " << cascadeCasters << " cascade casters" << std::endl;
+    std::cout << "    Directional casters: " << expectedDirectional << " uploaded in " << cascadeLists << " lists, instead of " << cascadeCasters << " with one list per cascade" << std::endl;
+
+    return valid;
+}
+
+namespace
+{
+    //Creates programs without a GPU. The binary of a program is made from its definitions, so that every variant has its own binary.
+    class FakeShaderBackend : public blurp::ShaderBinaryBackend
+    {
+    public:
+        FakeShaderBackend(const blurp::ShaderSettings& a_Settings, std::uint32_t a_Format) : m_Settings(a_Settings), m_Format(a_Format), compiled(0), loaded(0) {}
+
+        bool LoadBinary(std::uint32_t a_Format, const std::vector<char>& a_Data) override
+        {
+            //Like a driver after an update, binaries in another format are refused.
+            if(a_Format != m_Format || a_Data != MakeBinary())
+            {
+                return false;
+            }
+            ++loaded;
+            return true;
+        }
+
+        bool Compile(std::uint32_t& a_Format, std::vector<char>& a_Data) override
+        {
+            a_Format = m_Format;
+            a_Data = MakeBinary();
+            ++compiled;
+            return true;
+        }
+
+    private:
+        std::vector<char> MakeBinary() const
+        {
+            std::vector<char> data(256, 'B');
+            for(const auto& definition : m_Settings.preprocessorDefinitions)
+            {
+                data.insert(data.end(), definition.begin(), definition.end());
+            }
+            return data;
+        }
+
+    private:
+        blurp::ShaderSettings m_Settings;
+        std::uint32_t m_Format;
+
+    public:
+        std::uint32_t compiled;
+        std::uint32_t loaded;
+    };
+}
+
+bool BenchmarkShaderBinaryCache(std::uint32_t a_Variants)
+{
+    using namespace blurp;
+
+    const std::string vertexSource = "#version 460 core\n//Comment.\nlayout(location = 0) in vec3 aPos;\nvoid main()\n{\n    gl_Position = vec4(aPos, 1.0);\n}\n";
+    const std::string fragmentSource = "#version 460 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+    ShaderSettings baseSettings;
+    baseSettings.vertexShaderSource = vertexSource.c_str();
+    baseSettings.fragmentShaderSource = fragmentSource.c_str();
+
+    //Every variant enables the definitions of the bits in its index, like a ShaderCache mask.
+    std::vector<ShaderSettings> variants(a_Variants, baseSettings);
+    for(std::uint32_t variant = 0; variant < a_Variants; ++variant)
+    {
+        for(std::uint32_t bit = 0; bit < 32; ++bit)
+        {
+            if((variant & (1u << bit)) != 0)
+            {
+                variants[variant].preprocessorDefinitions.push_back("DEFINE_" + std::to_string(bit));
+            }
+        }
+    }
+
+    const auto directory = std::filesystem::temp_directory_path() / "BlurpShaderBinaryCacheTest";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+
+    const auto countFiles = [&](const std::string& a_Extension)
+    {
+        std::uint32_t count = 0;
+        for(const auto& file : std::filesystem::directory_iterator(directory, error))
+        {
+            count += file.path().extension() == a_Extension ? 1 : 0;
+        }
+        return count;
+    };
+
+    //Returns the amount of compiles and loads for every variant.
+    const auto loadAll = [&](ShaderBinaryCache& a_Cache, std::uint32_t a_Format, std::uint32_t& a_Compiled, std::uint32_t& a_Loaded)
+    {
+        a_Compiled = 0;
+        a_Loaded = 0;
+        bool success = true;
+        for(const auto& settings : variants)
+        {
+            FakeShaderBackend backend(settings, a_Format);
+            success = success && a_Cache.LoadOrCompile(settings, backend);
+            a_Compiled += backend.compiled;
+            a_Loaded += backend.loaded;
+        }
+        return success;
+    };
+
+    bool valid = true;
+    std::uint32_t compiled = 0;
+    std::uint32_t loaded = 0;
+
+    //The first run compiles and stores everything.
+    {
+        ShaderBinaryCache cache;
+        valid = valid && cache.Open(directory.string(), "Driver A");
+        valid = valid && loadAll(cache, 1, compiled, loaded) && compiled == a_Variants && loaded == 0;
+        valid = valid && cache.GetStats().misses == a_Variants && cache.GetStats().stored == a_Variants && countFiles(".bin") == a_Variants;
+    }
+
+    //The second run loads everything.
+    double loadTime = 0.0;
+    {
+        ShaderBinaryCache cache;
+        valid = valid && cache.Open(directory.string(), "Driver A") && cache.GetStats().loaded == a_Variants;
+        loadTime = Measure(1, [&](std::uint32_t)
+        {
+            valid = valid && loadAll(cache, 1, compiled, loaded) && compiled == 0 && loaded == a_Variants;
+        });
+        valid = valid && cache.GetStats().hits == a_Variants;
+
+        //Comments and whitespace do not change the key. Code, definitions and the driver do.
+        ShaderSettings settings = baseSettings;
+        const std::string commented = "#version 460 core\n\n/* Block\n comment. */\nlayout(location = 0)   in vec3 aPos; // Position.\nvoid main()\n{\n\tgl_Position = vec4(aPos, 1.0);\n}";
+        const std::string changed = "#version 460 core\nlayout(location = 0) in vec3 aPos;\nvoid main()\n{\n    gl_Position = vec4(aPos, 0.5);\n}\n";
+        const std::uint64_t baseKey = cache.GetKey(baseSettings);
+        settings.vertexShaderSource = commented.c_str();
+        valid = valid && cache.GetKey(settings) == baseKey;
+        settings.vertexShaderSource = changed.c_str();
+        valid = valid && cache.GetKey(settings) != baseKey;
+        settings.vertexShaderSource = baseSettings.vertexShaderSource;
+        settings.preprocessorDefinitions.push_back("OTHER");
+        valid = valid && cache.GetKey(settings) != baseKey;
+        valid = valid && ShaderBinaryCache::CalculateKey(baseSettings, "Driver B") != baseKey;
+
+        //Stages are not interchangeable.
+        settings = baseSettings;
+        settings.fragmentShaderSource = nullptr;
+        settings.geometryShaderSource = baseSettings.fragmentShaderSource;
+        valid = valid && cache.GetKey(settings) != baseKey;
+    }
+
+    //Damage the binary of the first variant, and leave a temporary file behind.
+    {
+        ShaderBinaryCache cache;
+        cache.Open(directory.string(), "Driver A");
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(cache.GetKey(variants[0])));
+        std::fstream file(directory / name, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-1, std::ios::end);
+        file.put('X');
+        file.close();
+        std::ofstream(directory / "0000000000000000.bin.tmp") << "Interrupted";
+    }
+
+    //Damaged binaries are compiled again. Temporary files are removed.
+    {
+        ShaderBinaryCache cache;
+        valid = valid && cache.Open(directory.string(), "Driver A") && countFiles(".tmp") == 0;
+        valid = valid && loadAll(cache, 1, compiled, loaded) && compiled == 1 && loaded == a_Variants - 1 && cache.GetStats().rejected == 1;
+    }
+
+    //Binaries that the driver refuses are compiled again and replaced.
+    {
+        ShaderBinaryCache cache;
+        cache.Open(directory.string(), "Driver A");
+        valid = valid && loadAll(cache, 2, compiled, loaded) && compiled == a_Variants && loaded == 0 && cache.GetStats().rejected == a_Variants && cache.GetStats().stored == a_Variants;
+        valid = valid && loadAll(cache, 2, compiled, loaded) && compiled == 0 && loaded == a_Variants;
+    }
+
+    //Another driver deletes every binary.
+    {
+        ShaderBinaryCache cache;
+        valid = valid && cache.Open(directory.string(), "Driver B") && cache.GetStats().loaded == 0 && countFiles(".bin") == 0;
+    }
+
+    std::filesystem::remove_all(directory, error);
+
+    std::cout << "Shader binary cache benchmark: " << a_Variants << " variants. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Loading every variant from disk: " << loadTime << " us" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkShaderManifest(std::uint32_t a_Variants)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::uint64_t> maskDistribution(0, (1ull << 34) - 1);
+
+    //Every variant gets a random mask and a few attribute location definitions, like the forward pass uses.
+    ShaderManifest manifest;
+    std::vector<std::uint64_t> masks;
+    for(std::uint32_t i = 0; i < a_Variants; ++i)
+    {
+        const std::uint64_t mask = maskDistribution(random);
+        const std::string pass = i % 3 == 0 ? "ShadowMap" : "Forward";
+        std::vector<std::string> definitions;
+        for(std::uint32_t location = 0; location < i % 4; ++location)
+        {
+            definitions.push_back("VA_ATTRIBUTE_" + std::to_string(location) + "_LOCATION_DEF " + std::to_string(location));
+        }
+
+        manifest.Record(pass, mask, definitions, static_cast<float>(i % 50) * 1.5f);
+        masks.push_back(mask);
+
+        if(i % 7 == 0)
+        {
+            manifest.NextFrame();
+        }
+    }
+
+    //Using a variant again does not change when it was first used.
+    bool valid = true;
+    const auto firstForward = manifest.GetEntries("Forward");
+    valid = valid && !firstForward.empty() && !manifest.Record("Forward", firstForward[0].mask, {}, 1000.f);
+    valid = valid && manifest.GetEntries("Forward")[0].frame == firstForward[0].frame && manifest.GetEntries("Forward")[0].compileMilliseconds == firstForward[0].compileMilliseconds;
+    valid = valid && manifest.GetEntries("Unknown").empty();
+
+    //Entries are returned in the order they were first used.
+    for(const auto& pass : { "Forward", "ShadowMap" })
+    {
+        const auto entries = manifest.GetEntries(pass);
+        valid = valid && std::is_sorted(entries.begin(), entries.end(), [](const ShaderManifestEntry& a_Left, const ShaderManifestEntry& a_Right) { return a_Left.frame < a_Right.frame; });
+    }
+
+    const auto directory = std::filesystem::temp_directory_path();
+    const std::string path = (directory / "BlurpShaderManifestTest.txt").string();
+    const std::string copyPath = (directory / "BlurpShaderManifestTestCopy.txt").string();
+
+    const auto readFile = [](const std::string& a_Path)
+    {
+        std::ifstream file(a_Path, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    double saveTime = 0.0;
+    double loadTime = 0.0;
+    ShaderManifest loaded;
+    saveTime = Measure(1, [&](std::uint32_t) { valid = valid && manifest.Save(path); });
+    loadTime = Measure(1, [&](std::uint32_t) { valid = valid && loaded.Load(path); });
+    valid = valid && loaded.GetSkippedLines() == 0 && loaded.GetEntryCount() == manifest.GetEntryCount();
+
+    for(const auto& pass : { "Forward", "ShadowMap" })
+    {
+        const auto original = manifest.GetEntries(pass);
+        const auto copy = loaded.GetEntries(pass);
+        valid = valid && original.size() == copy.size();
+        for(std::size_t i = 0; valid && i < original.size(); ++i)
+        {
+            valid = valid && original[i].mask == copy[i].mask && original[i].frame == copy[i].frame && original[i].definitions == copy[i].definitions
+                && std::abs(original[i].compileMilliseconds - copy[i].compileMilliseconds) < 0.001f;
+        }
+    }
+
+    //Saving what was loaded gives the same file.
+    valid = valid && loaded.Save(copyPath) && readFile(path) == readFile(copyPath);
+
+    //Broken lines are skipped, Windows line endings and comments are fine.
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+        file << "#Comment\r\n";
+        file << "Forward\t0x10\t3\t1.5\tA 0;B 1\r\n";
+        file << "Forward\tnot a mask\t3\t1.5\t\n";
+        file << "Forward\t0x20\t3\n";
+        file << "\t0x30\t3\t1.5\t\n";
+        file << "ShadowMap\t0x40\t7\t0.25\t\n";
+    }
+    ShaderManifest edited;
+    valid = valid && edited.Load(path) && edited.GetSkippedLines() == 3 && edited.GetEntryCount() == 2;
+    valid = valid && edited.Contains("Forward", 0x10) && edited.Contains("ShadowMap", 0x40);
+    valid = valid && edited.GetEntries("Forward")[0].definitions == std::vector<std::string>({ "A 0", "B 1" }) && edited.GetEntries("ShadowMap")[0].definitions.empty();
+    valid = valid && !edited.Load((directory / "BlurpShaderManifestMissing.txt").string());
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::filesystem::remove(copyPath, error);
+
+    std::cout << "Shader manifest benchmark: " << manifest.GetEntryCount() << " variants. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Save: " << saveTime << " us, load: " << loadTime << " us" << std::endl;
+
+    return valid;
+}
+
+namespace
+{
+    //Shader that is never loaded, so that the registry can be tested without a GPU.
+    class FakeShader : public blurp::Shader
+    {
+    public:
+        FakeShader() : Shader(blurp::ShaderSettings()) {}
+
+    protected:
+        bool OnLoad(blurp::BlurpEngine&) override { return true; }
+        bool OnDestroy(blurp::BlurpEngine&) override { return true; }
+    };
+}
+
+bool BenchmarkShaderRegistry(std::uint32_t a_Frames, std::uint32_t a_Budget)
+{
+    using namespace blurp;
+
+    ShaderSettings settings;
+    const char* vertex = "void main()\n{\n    gl_Position = vec4(0.0);\n}\n";
+    settings.vertexShaderSource = vertex;
+    const std::vector<std::string> definitions{ "USE_A", "USE_B", "USE_C" };
+
+    //The same shader gives the same id, and moving a definition into the mask does not.
+    bool valid = true;
+    const std::uint64_t source = ShaderRegistry::CalculateSourceId(settings, definitions);
+    valid = valid && source == ShaderRegistry::CalculateSourceId(settings, definitions);
+    {
+        ShaderSettings moved = settings;
+        moved.preprocessorDefinitions.push_back("USE_A");
+        valid = valid && source != ShaderRegistry::CalculateSourceId(moved, { "USE_B", "USE_C" });
+    }
+
+    //The main view uses a changing set of 32 variants every frame. The minimap uses the first 8 of them.
+    std::mt19937 random(7);
+    std::uniform_int_distribution<std::uint64_t> variantDistribution(0, 47);
+    std::vector<std::vector<std::uint64_t>> frames(a_Frames);
+    for(auto& frame : frames)
+    {
+        for(std::uint32_t i = 0; i < 32; ++i)
+        {
+            frame.push_back(variantDistribution(random));
+        }
+    }
+
+    //Draw every frame with the given registries for the two pipelines. Returns the amount of programs compiled.
+    const auto draw = [&](ShaderRegistry& a_Main, ShaderRegistry& a_Minimap)
+    {
+        std::uint32_t compiled = 0;
+        const auto use = [&](ShaderRegistry& a_Registry, std::uint64_t a_Mask)
+        {
+            if(a_Registry.Find(source, a_Mask) == nullptr)
+            {
+                a_Registry.Insert(source, a_Mask, std::make_shared<FakeShader>());
+                ++compiled;
+            }
+        };
+
+        for(const auto& frame : frames)
+        {
+            a_Main.NextFrame();
+            for(const auto mask : frame)
+            {
+                use(a_Main, mask);
+            }
+
+            a_Minimap.NextFrame();
+            for(std::size_t i = 0; i < 8; ++i)
+            {
+                use(a_Minimap, frame[i]);
+            }
+        }
+        return compiled;
+    };
+
+    ShaderRegistry mainRegistry;
+    ShaderRegistry minimapRegistry;
+    const std::uint32_t separateCompiled = draw(mainRegistry, minimapRegistry);
+    const std::size_t separatePrograms = mainRegistry.GetProgramCount() + minimapRegistry.GetProgramCount();
+
+    ShaderRegistry shared;
+    shared.AddReference(source);
+    shared.AddReference(source);
+    const std::uint32_t sharedCompiled = draw(shared, shared);
+    const std::size_t sharedPrograms = shared.GetProgramCount();
+
+    //Sharing never compiles more, and every variant is compiled only once.
+    valid = valid && sharedCompiled <= separateCompiled && sharedCompiled == sharedPrograms && shared.GetStats().misses == sharedCompiled && shared.GetStats().evictions == 0;
+
+    //With a budget, at most the budget is kept between frames and nothing used in the last frame was removed.
+    ShaderRegistry budgeted(a_Budget);
+    budgeted.AddReference(source);
+    const std::uint32_t budgetedCompiled = draw(budgeted, budgeted);
+    valid = valid && budgeted.GetProgramCount() <= std::max<std::size_t>(a_Budget, 32);
+    valid = valid && budgetedCompiled == budgeted.GetProgramCount() + budgeted.GetStats().evictions;
+    for(const auto mask : frames.back())
+    {
+        valid = valid && budgeted.Contains(source, mask);
+    }
+    if(a_Budget >= 48)
+    {
+        valid = valid && budgeted.GetStats().evictions == 0 && budgeted.GetStats().overBudget == 0;
+    }
+
+    //The least recently used programs go first.
+    {
+        ShaderRegistry order(2);
+        order.AddReference(source);
+        order.Insert(source, 1, std::make_shared<FakeShader>());
+        order.NextFrame();
+        order.Insert(source, 2, std::make_shared<FakeShader>());
+        order.NextFrame();
+        valid = valid && order.Find(source, 1) != nullptr;
+        order.Insert(source, 3, std::make_shared<FakeShader>());
+        valid = valid && order.Contains(source, 1) && !order.Contains(source, 2) && order.Contains(source, 3) && order.GetStats().evictions == 1;
+
+        //Everything was used this frame, so the budget is exceeded until the next one.
+        order.Insert(source, 4, std::make_shared<FakeShader>());
+        valid = valid && order.GetProgramCount() == 3 && order.GetStats().overBudget == 1;
+        order.NextFrame();
+        valid = valid && order.Evict() == 1 && order.GetProgramCount() == 2;
+
+        //Programs are released with the last reference to their source.
+        order.AddReference(source);
+        order.RemoveReference(source);
+        valid = valid && order.GetProgramCount() == 2;
+        order.RemoveReference(source);
+        valid = valid && order.GetProgramCount() == 0 && order.GetStats().released == 2 && order.GetReferences(source) == 0;
+    }
+
+    //Time lookups of variants that are all stored.
+    const double lookupTime = Measure(100000, [&](std::uint32_t a_Index)
+    {
+        valid = valid && shared.Find(source, frames[a_Index % frames.size()][a_Index % 32]) != nullptr;
+    });
+
+    std::cout << "Shader registry benchmark: " << a_Frames << " frames, budget " << a_Budget << ". Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Separate caches: " << separateCompiled << " compiled, " << separatePrograms << " programs" << std::endl;
+    std::cout << "    Shared registry: " << sharedCompiled << " compiled, " << sharedPrograms << " programs" << std::endl;
+    std::cout << "    With budget: " << budgetedCompiled << " compiled, " << budgeted.GetStats().evictions << " evicted, " << budgeted.GetStats().overBudget << " over budget" << std::endl;
+    std::cout << "    Lookup: " << lookupTime << " us" << std::endl;
+
+    return valid;
+}
+
+namespace
+{
+    //Shader that is ready after IsReady was asked a number of times, like a driver that compiles in the background.
+    class FakeAsyncShader : public blurp::Shader
+    {
+    public:
+        FakeAsyncShader(std::uint32_t a_Polls) : Shader(blurp::ShaderSettings()), m_Polls(a_Polls) {}
+
+        bool IsReady() override
+        {
+            if(m_Polls == 0)
+            {
+                return true;
+            }
+            --m_Polls;
+            return false;
+        }
+
+    protected:
+        bool OnLoad(blurp::BlurpEngine&) override { return true; }
+        bool OnDestroy(blurp::BlurpEngine&) override { return true; }
+
+    private:
+        std::uint32_t m_Polls;
+    };
+
+    //Busy wait to act like a compile that takes time on this thread.
+    void Spin(std::uint32_t a_Microseconds)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        while(std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() < a_Microseconds)
+        {
+        }
+    }
+}
+
+bool BenchmarkShaderCompileQueue(std::uint32_t a_Variants, std::uint32_t a_CompileMicroseconds, float a_BudgetMilliseconds)
+{
+    using namespace blurp;
+
+    bool valid = true;
+
+    //Fallback selection.
+    {
+        std::uint64_t fallback = 0;
+        const std::vector<std::uint64_t> available{ 0b0001, 0b0011, 0b0111, 0b1011, 0b11111 };
+        valid = valid && !ShaderCompileQueue::SelectFallback(0b0111, available, 0, ShaderFallbackPolicy::BLOCK, fallback);
+        valid = valid && !ShaderCompileQueue::SelectFallback(0b0111, available, 0, ShaderFallbackPolicy::SKIP, fallback);
+
+        //The subsets with the most features are 0b0111 and 0b1011. Ties go to the lowest mask.
+        valid = valid && ShaderCompileQueue::SelectFallback(0b1111, available, 0, ShaderFallbackPolicy::SUBSET, fallback) && fallback == 0b0111;
+        valid = valid && !ShaderCompileQueue::SelectFallback(0b1110, available, 0, ShaderFallbackPolicy::SUBSET, fallback);
+
+        //Nearest picks the fewest differences, and prefers a missing feature over an extra one.
+        valid = valid && ShaderCompileQueue::SelectFallback(0b1110, available, 0, ShaderFallbackPolicy::NEAREST, fallback) && fallback == 0b0111;
+        valid = valid && ShaderCompileQueue::SelectFallback(0b0110, { 0b0111, 0b0010 }, 0, ShaderFallbackPolicy::NEAREST, fallback) && fallback == 0b0010;
+        valid = valid && ShaderCompileQueue::SelectFallback(0b0110, { 0b0111, 0b1000 }, 0, ShaderFallbackPolicy::NEAREST, fallback) && fallback == 0b0111;
+
+        //Exact bits have to match.
+        valid = valid && ShaderCompileQueue::SelectFallback(0b1111, available, 0b1000, ShaderFallbackPolicy::SUBSET, fallback) && fallback == 0b1011;
+        valid = valid && !ShaderCompileQueue::SelectFallback(0b100000, available, 0b100000, ShaderFallbackPolicy::NEAREST, fallback);
+        valid = valid && !ShaderCompileQueue::SelectFallback(0b0111, {}, 0, ShaderFallbackPolicy::NEAREST, fallback);
+    }
+
+    //Every frame the scene needs 4 more variants, so the first frames need a lot of new ones.
+    const std::uint32_t numFrames = a_Variants / 4 + 64;
+    const auto neededInFrame = [&](std::uint32_t a_Frame)
+    {
+        return std::min<std::uint32_t>(a_Variants, 8 + a_Frame * 4);
+    };
+
+    //Compiling right away: every missing variant is compiled in the frame that needs it.
+    double blockingWorst = 0.0;
+    {
+        std::unordered_set<std::uint64_t> compiled;
+        for(std::uint32_t frame = 0; frame < numFrames; ++frame)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            for(std::uint64_t mask = 0; mask < neededInFrame(frame); ++mask)
+            {
+                if(compiled.insert(mask).second)
+                {
+                    Spin(a_CompileMicroseconds);
+                }
+            }
+            blockingWorst = std::max(blockingWorst, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+    }
+
+    //Draw the same frames with a queue. a_Polls is how many frames a started compile takes to be ready, and a_StartCost how long starting takes.
+    const auto drawQueued = [&](std::uint32_t a_Polls, std::uint32_t a_StartCost, std::uint32_t a_MaxInFlight, double& a_Worst, std::uint32_t& a_Skips, std::uint32_t& a_Frames)
+    {
+        ShaderCompileQueue queue(a_MaxInFlight);
+        std::unordered_map<std::uint64_t, std::uint32_t> finished;
+        std::uint32_t maxInFlight = 0;
+        a_Worst = 0.0;
+        a_Skips = 0;
+        a_Frames = 0;
+
+        for(std::uint32_t frame = 0; frame < numFrames * 4 && (frame < numFrames || queue.GetWaitingCount() + queue.GetInFlightCount() > 0); ++frame)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            queue.Update(a_BudgetMilliseconds,
+                [&](const ShaderCompileJob&) -> std::shared_ptr<Shader>
+                {
+                    Spin(a_StartCost);
+                    return std::make_shared<FakeAsyncShader>(a_Polls);
+                },
+                [](Shader& a_Shader) { return a_Shader.IsReady(); },
+                [&](const ShaderCompileJob& a_Job, float) { ++finished[a_Job.mask]; });
+            const double updateTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            maxInFlight = std::max<std::uint32_t>(maxInFlight, static_cast<std::uint32_t>(queue.GetInFlightCount()));
+
+            for(std::uint64_t mask = 0; mask < neededInFrame(std::min(frame, numFrames - 1)); ++mask)
+            {
+                if(finished.find(mask) == finished.end())
+                {
+                    queue.Request(mask, {});
+                    queue.CountFallback(false);
+                }
+            }
+
+            a_Worst = std::max(a_Worst, updateTime);
+            ++a_Frames;
+        }
+
+        a_Skips = queue.GetStats().skips;
+
+        //Every variant is finished exactly once, requests are not repeated and the limit of compiling variants is kept.
+        bool success = finished.size() == a_Variants && queue.GetStats().requests == a_Variants && queue.GetStats().finished == a_Variants && maxInFlight <= a_MaxInFlight;
+        for(const auto& pair : finished)
+        {
+            success = success && pair.second == 1;
+        }
+        return success;
+    };
+
+    double budgetWorst = 0.0;
+    double parallelWorst = 0.0;
+    std::uint32_t budgetSkips = 0;
+    std::uint32_t parallelSkips = 0;
+    std::uint32_t budgetFrames = 0;
+    std::uint32_t parallelFrames = 0;
+
+    //Without parallel compiles every start is a full compile. A frame starts at most one compile past the budget.
+    valid = valid && drawQueued(0, a_CompileMicroseconds, 1000, budgetWorst, budgetSkips, budgetFrames);
+    valid = valid && budgetWorst <= a_BudgetMilliseconds + 2.0 * a_CompileMicroseconds / 1000.0 + 1.0;
+
+    //With parallel compiles starting is cheap, and variants are ready a few frames later.
+    valid = valid && drawQueued(3, a_CompileMicroseconds / 20, 16, parallelWorst, parallelSkips, parallelFrames);
+
+    std::cout << "Shader compile queue benchmark: " << a_Variants << " variants of " << a_CompileMicroseconds << " us, budget " << a_BudgetMilliseconds << " ms. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Compile right away: slowest frame " << blockingWorst << " ms" << std::endl;
+    std::cout << "    Queue with budget: slowest frame " << budgetWorst << " ms, " << budgetSkips << " skipped draws, done after " << budgetFrames << " frames" << std::endl;
+    std::cout << "    Parallel compiles: slowest frame " << parallelWorst << " ms, " << parallelSkips << " skipped draws, done after " << parallelFrames << " frames" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkShaderPreprocessor(const std::string& a_ShaderDirectory)
+{
+    using namespace blurp;
+
+    ShaderPreprocessor preprocessor;
+    std::string output;
+
+    const auto process = [&](const char* a_Source, const std::vector<std::string>& a_Definitions)
+    {
+        return preprocessor.Process(a_Source, a_Definitions, output) ? output : std::string("FAILED");
+    };
+
+    const auto hasLine = [](const std::string& a_Output, const std::string& a_Line)
+    {
+        return ("\n" + a_Output).find("\n" + a_Line + "\n") != std::string::npos;
+    };
+
+    //Conditionals are resolved, and only definitions that are still used are passed on.
+    const char* source =
+        "#version 460 core\n"
+        "// Comment\n"
+        "#define LIMIT 3\n"
+        "#if defined(A) && !defined B\n"
+        "    first;\n"
+        "#elif COUNT > LIMIT\n"
+        "    second;\n"
+        "#else\n"
+        "    third;\n"
+        "#endif\n"
+        "#ifdef OUTER\n"
+        "    #ifdef A\n"
+        "        nested;\n"
+        "    #else\n"
+        "        #if 1 / 0\n"
+        "        #endif\n"
+        "    #endif\n"
+        "#endif\n"
+        "#if (COUNT + 1) * 2 == 10 || COUNT % 7 == 6\n"
+        "    math;\n"
+        "#endif\n"
+        "void main() { int x = VALUE; }\n";
+
+    bool valid = true;
+    output = process(source, { "A" });
+    valid = valid && output.find("#version 460 core\n") == 0 && hasLine(output, "first;") && !hasLine(output, "second;") && !hasLine(output, "third;");
+    valid = valid && hasLine(output, "#define LIMIT 3") && output.find("Comment") == std::string::npos && output.find("#define A") == std::string::npos;
+    valid = valid && process(source, { "COUNT 4" }).find("second;") != std::string::npos && process(source, { "COUNT 4" }).find("math;") != std::string::npos;
+    valid = valid && process(source, { "A", "B", "COUNT 2" }).find("third;") != std::string::npos;
+    valid = valid && process(source, { "COUNT 13" }).find("math;") != std::string::npos && process(source, { "COUNT 12" }).find("math;") == std::string::npos;
+    valid = valid && hasLine(process(source, { "OUTER", "A" }), "nested;");
+
+    //Definitions that the remaining code does not use do not change the output.
+    valid = valid && process(source, { "A", "UNUSED" }) == process(source, { "A" }) && process(source, { "A", "UNUSED" }) != "FAILED";
+    valid = valid && hasLine(process(source, { "VALUE 5" }), "#define VALUE 5");
+
+    //Broken sources are refused instead of guessed.
+    const std::uint32_t failedBefore = preprocessor.GetStats().failed;
+    valid = valid && process("#version 460 core\n#ifdef A\n", {}) == "FAILED";
+    valid = valid && process("#version 460 core\n#else\n#endif\n", {}) == "FAILED";
+    valid = valid && process("#version 460 core\n#if 1 / 0\n#endif\n", {}) == "FAILED";
+    valid = valid && process("#version 460 core\n#if EMPTY\n#endif\n", { "EMPTY" }) == "FAILED";
+    valid = valid && process("#version 460 core\n#include \"Missing.glsl\"\n", {}) == "FAILED";
+    valid = valid && process("#version 460 core\n#ifdef A\n#else\n#else\n#endif\n", {}) == "FAILED";
+    valid = valid && preprocessor.GetStats().failed == failedBefore + 6;
+
+    //Includes are inserted once, and are processed with the definitions of the source.
+    const auto directory = std::filesystem::temp_directory_path() / "BlurpShaderPreprocessorTest";
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    {
+        std::ofstream file(directory / "Common.glsl", std::ios::out | std::ios::binary | std::ios::trunc);
+        file << "#ifdef A\r\nfloat common;\r\n#endif\r\n";
+    }
+    preprocessor.SetIncludeDirectory(directory.string() + "/");
+    output = process("#version 460 core\n#include \"Common.glsl\"\n#include \"Common.glsl\"\nvoid main() {}\n", { "A" });
+    valid = valid && output.find("float common;") != std::string::npos && output.find("float common;") == output.rfind("float common;");
+    valid = valid && process("#version 460 core\n#include \"Common.glsl\"\n", {}).find("common") == std::string::npos;
+    std::filesystem::remove_all(directory, error);
+
+    //Process random variants of the forward shaders, and count how many of them end up with the same source.
+    std::uint32_t variants = 0;
+    std::set<std::string> unique;
+    double processTime = 0.0;
+    const ShaderPreprocessorStats before = preprocessor.GetStats();
+
+    const auto readFile = [](const std::string& a_Path)
+    {
+        std::ifstream file(a_Path, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    const std::string vertexSource = readFile(a_ShaderDirectory + "Default_Forward.vs");
+    const std::string fragmentSource = readFile(a_ShaderDirectory + "Default_Forward.fs");
+    if(!vertexSource.empty() && !fragmentSource.empty())
+    {
+
+        //Attribute locations are always defined, like Mesh_GL::GetAttribLocations does.
+        std::set<std::string> locations;
+        for(const char* stage : { vertexSource.c_str(), fragmentSource.c_str() })
+        {
+            std::string token;
+            for(const char* c = stage; *c != '\0'; ++c)
+            {
+                if(std::isalnum(static_cast<unsigned char>(*c)) || *c == '_')
+                {
+                    token += *c;
+                    continue;
+                }
+
+                if(token.size() > 13 && token.compare(token.size() - 13, 13, "_LOCATION_DEF") == 0)
+                {
+                    locations.insert(token + " " + std::to_string(locations.size()));
+                }
+                token.clear();
+            }
+        }
+
+        //A static mesh with every combination of a few attributes and material settings.
+        //POSITIONAL belongs to the shadow pass and UNUSED_DEFINE to nothing, so at most a quarter of the variants can differ.
+        const std::vector<std::string> base = { "VA_POS3D_DEF", "VA_NORMAL_DEF", "VA_MATRIX_DEF", "MAT_SINGLE_DEFINE" };
+        const std::vector<std::string> toggles = { "VA_UVCOORD_DEF", "VA_TANGENT_DEF", "VA_BITANGENT_DEF", "MAT_NORMAL_TEXTURE_DEFINE", "MAT_HEIGHT_TEXTURE_DEFINE",
+            "MAT_DIFFUSE_TEXTURE_DEFINE", "MAT_DIFFUSE_CONSTANT_DEFINE", "POSITIONAL", "UNUSED_DEFINE" };
+
+        variants = 1u << toggles.size();
+        std::vector<std::string> enabled;
+        processTime = Measure(variants, [&](std::uint32_t a_Mask)
+        {
+            enabled.assign(locations.begin(), locations.end());
+            enabled.insert(enabled.end(), base.begin(), base.end());
+            for(std::size_t bit = 0; bit < toggles.size(); ++bit)
+            {
+                if(a_Mask & (1u << bit))
+                {
+                    enabled.push_back(toggles[bit]);
+                }
+            }
+
+            std::string combined;
+            valid = valid && preprocessor.Process(vertexSource.c_str(), enabled, output);
+            combined += output;
+            valid = valid && preprocessor.Process(fragmentSource.c_str(), enabled, output);
+            combined += output;
+            unique.insert(combined);
+        });
+        valid = valid && unique.size() <= variants / 4;
+    }
+
+    const ShaderPreprocessorStats& stats = preprocessor.GetStats();
+    const double inputBytes = static_cast<double>(stats.inputBytes - before.inputBytes);
+    const double outputBytes = static_cast<double>(stats.outputBytes - before.outputBytes);
+    valid = valid && outputBytes <= inputBytes;
+
+    std::cout << "Shader preprocessor benchmark: " << variants << " forward variants. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Programs after removing duplicates: " << unique.size() << ", " << processTime << " us per variant" << std::endl;
+    std::cout << "    Source size: " << (inputBytes > 0.0 ? 100.0 * outputBytes / inputBytes : 100.0) << "% of the unprocessed source" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkShaderMaskTable(const std::string& a_ShaderDirectory, std::uint32_t a_Samples)
+{
+    using namespace blurp;
+
+    bool valid = true;
+
+    //The table itself.
+    ShaderMaskTable table;
+    table.Add("A_DEF", true, "A_LOCATION_DEF");
+    table.Add("B_DEF", false, "B_LOCATION_DEF");
+    table.Add("C_DEF", true);
+    table.Add("D_DEF", false);
+    valid = valid && table.GetDefinitions().size() == 4 && table.GetUsedBits() == 0x5 && table.IsUsed(0) && !table.IsUsed(1);
+    valid = valid && table.Canonicalize(0xF) == 0x5 && table.Canonicalize(table.Canonicalize(0xA)) == 0 && table.Canonicalize(0x4) == 0x4;
+
+    std::vector<std::string> filtered;
+    table.FilterDefinitions({ "A_LOCATION_DEF 0", "B_LOCATION_DEF 1", "OTHER 2", "B_LOCATION_DEF_LONGER 3" }, filtered);
+    valid = valid && filtered == std::vector<std::string>({ "A_LOCATION_DEF 0", "OTHER 2", "B_LOCATION_DEF_LONGER 3" });
+
+    //The tables of the passes have a bit for every definition, and the bits they use.
+    const ShaderMaskTable shadowTable = RenderPass_ShadowMap::CreateShaderMaskTable();
+    const ShaderMaskTable forwardTable = RenderPass_Forward::CreateShaderMaskTable();
+    valid = valid && shadowTable.GetDefinitions().size() == NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS + 2;
+    valid = valid && forwardTable.GetDefinitions().size() == NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS + NUM_MATERIAL_ATRRIBS + 3;
+    valid = valid && std::bitset<64>(shadowTable.GetUsedBits()).count() == 6 && std::bitset<64>(forwardTable.GetUsedBits()).count() == forwardTable.GetDefinitions().size() - 2;
+
+    //The attribute locations a mesh with the attributes in a_Mask gets, like Mesh_GL.
+    const auto getLocations = [](std::uint64_t a_Mask, std::vector<std::string>& a_Locations)
+    {
+        a_Locations.clear();
+        std::uint32_t index = 0;
+        for(std::uint32_t i = 0; i < NUM_VERTEX_ATRRIBS; ++i)
+        {
+            if(a_Mask & (1ull << i))
+            {
+                const auto info = VertexSettings::GetVertexAttributeInfo(VERTEX_ATTRIBUTES[i]);
+                a_Locations.push_back(info.locationDefine + " " + std::to_string(index));
+                index += ((info.numElements - 1) / 4) + 1;
+            }
+        }
+    };
+
+    const auto getDefinitions = [](const ShaderMaskTable& a_Table, std::uint64_t a_Mask, const std::vector<std::string>& a_Locations)
+    {
+        std::vector<std::string> definitions = a_Locations;
+        for(std::size_t bit = 0; bit < a_Table.GetDefinitions().size(); ++bit)
+        {
+            if(a_Mask & (1ull << bit))
+            {
+                definitions.push_back(a_Table.GetDefinitions()[bit]);
+            }
+        }
+        return definitions;
+    };
+
+    const auto readFile = [](const std::string& a_Path)
+    {
+        std::ifstream file(a_Path, std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    //Remove vertex inputs that are declared but never read, and then the definitions that are no longer used. Drivers ignore those inputs.
+    const auto removeUnusedInputs = [](const std::string& a_Source)
+    {
+        std::vector<std::string> lines;
+        std::map<std::string, std::uint32_t> uses;
+        std::size_t start = 0;
+        while(start < a_Source.size())
+        {
+            const std::size_t end = a_Source.find('\n', start);
+            lines.push_back(a_Source.substr(start, end - start));
+            start = end == std::string::npos ? a_Source.size() : end + 1;
+
+            std::string token;
+            for(const char c : lines.back() + " ")
+            {
+                if(std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+                {
+                    token += c;
+                }
+                else if(!token.empty())
+                {
+                    ++uses[token];
+                    token.clear();
+                }
+            }
+        }
+
+        //The name after the last space for inputs, and after the define for definitions.
+        const auto declaredName = [](const std::string& a_Line) -> std::string
+        {
+            if(a_Line.compare(0, 16, "layout(location ") == 0 && a_Line.find(") in ") != std::string::npos && a_Line.back() == ';')
+            {
+                return a_Line.substr(a_Line.rfind(' ') + 1, a_Line.size() - a_Line.rfind(' ') - 2);
+            }
+            if(a_Line.compare(0, 8, "#define ") == 0)
+            {
+                return a_Line.substr(8, a_Line.find(' ', 8) - 8);
+            }
+            return std::string();
+        };
+
+        std::string result;
+        for(int pass = 0; pass < 2; ++pass)
+        {
+            for(auto& line : lines)
+            {
+                const std::string name = declaredName(line);
+                if(!name.empty() && uses[name] == 1)
+                {
+                    //Inputs are removed first, which can leave their location definition unused.
+                    if(pass == 0 && line[0] == 'l')
+                    {
+                        const auto location = line.substr(18, line.find(')') - 18);
+                        --uses[location];
+                        line.clear();
+                    }
+                    else if(pass == 1 && line[0] == '#')
+                    {
+                        line.clear();
+                    }
+                }
+            }
+        }
+
+        for(const auto& line : lines)
+        {
+            if(!line.empty())
+            {
+                result += line + "\n";
+            }
+        }
+        return result;
+    };
+
+    struct PassInfo
+    {
+        const char* name;
+        const ShaderMaskTable* table;
+        std::vector<std::string> stages;
+        std::uint64_t randomBits;
+        std::uint64_t fixedBits;
+        std::uint32_t fullVariants;
+        std::uint32_t canonicalVariants;
+        std::uint32_t fullSwitches;
+        std::uint32_t canonicalSwitches;
+        std::uint32_t mismatches;
+    };
+
+    //Every draw has a position. The shadow pass draws one light type at a time, here directional. The forward draws use a single material with a diffuse color.
+    constexpr std::uint64_t attributeBits = (1ull << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS)) - 1;
+    constexpr std::uint64_t directionalBit = 1ull << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS + 1);
+    constexpr std::uint64_t singleMaterialBit = static_cast<std::uint64_t>(DrawAttribute::MATERIAL_SINGLE) << NUM_VERTEX_ATRRIBS;
+    constexpr std::uint64_t batchMaterialBit = static_cast<std::uint64_t>(DrawAttribute::MATERIAL_BATCH) << NUM_VERTEX_ATRRIBS;
+    constexpr std::uint64_t diffuseBit = static_cast<std::uint64_t>(MaterialAttribute::DIFFUSE_CONSTANT_VALUE) << (NUM_VERTEX_ATRRIBS + NUM_DRAW_ATTRIBS);
+    std::vector<PassInfo> passes = {
+        { "ShadowMap", &shadowTable, { "Default_ShadowMap.vs", "Default_ShadowMap.gs", "Default_ShadowMap.fs" }, attributeBits, directionalBit | 1ull, 0, 0, 0, 0, 0 },
+        { "Forward", &forwardTable, { "Default_Forward.vs", "Default_Forward.fs" }, attributeBits & ~singleMaterialBit & ~batchMaterialBit, 1ull | singleMaterialBit | diffuseBit, 0, 0, 0, 0, 0 }
+    };
+
+    ShaderPreprocessor preprocessor;
+    std::mt19937 random(11);
+    std::vector<std::string> locations;
+    std::vector<std::string> canonicalLocations;
+
+    for(auto& pass : passes)
+    {
+        std::vector<std::string> sources;
+        for(const auto& stage : pass.stages)
+        {
+            sources.push_back(readFile(a_ShaderDirectory + stage));
+        }
+        const bool hasSources = std::none_of(sources.begin(), sources.end(), [](const std::string& a_Source) { return a_Source.empty(); });
+
+        //Random draws, sorted by mask like the draw sorter does.
+        std::uniform_int_distribution<std::uint64_t> maskDistribution(0, pass.randomBits);
+        std::vector<std::uint64_t> masks;
+        for(std::uint32_t i = 0; i < a_Samples; ++i)
+        {
+            masks.push_back(maskDistribution(random) | pass.fixedBits);
+        }
+        std::sort(masks.begin(), masks.end());
+
+        //Count the programs and program switches when drawing in mask order, with and without folding.
+        std::set<std::pair<std::uint64_t, std::vector<std::string>>> fullKeys;
+        std::set<std::pair<std::uint64_t, std::vector<std::string>>> canonicalKeys;
+        std::pair<std::uint64_t, std::vector<std::string>> previousFull;
+        std::pair<std::uint64_t, std::vector<std::string>> previousCanonical;
+
+        for(std::size_t i = 0; i < masks.size(); ++i)
+        {
+            const std::uint64_t mask = masks[i];
+            getLocations(mask, locations);
+            pass.table->FilterDefinitions(locations, canonicalLocations);
+
+            auto full = std::make_pair(mask, locations);
+            auto canonical = std::make_pair(pass.table->Canonicalize(mask), canonicalLocations);
+            pass.fullSwitches += i == 0 || full != previousFull;
+            pass.canonicalSwitches += i == 0 || canonical != previousCanonical;
+
+            //Folding is only allowed when the shaders come out the same.
+            if(hasSources && fullKeys.find(full) == fullKeys.end())
+            {
+                const auto fullDefinitions = getDefinitions(*pass.table, full.first, full.second);
+                const auto canonicalDefinitions = getDefinitions(*pass.table, canonical.first, canonical.second);
+                for(const auto& source : sources)
+                {
+                    std::string fullOutput;
+                    std::string canonicalOutput;
+                    const bool processed = preprocessor.Process(source.c_str(), fullDefinitions, fullOutput) && preprocessor.Process(source.c_str(), canonicalDefinitions, canonicalOutput);
+                    pass.mismatches += !processed || removeUnusedInputs(fullOutput) != removeUnusedInputs(canonicalOutput);
+                }
+            }
+
+            fullKeys.insert(full);
+            canonicalKeys.insert(canonical);
+            previousFull = std::move(full);
+            previousCanonical = std::move(canonical);
+        }
+
+        pass.fullVariants = static_cast<std::uint32_t>(fullKeys.size());
+        pass.canonicalVariants = static_cast<std::uint32_t>(canonicalKeys.size());
+        valid = valid && pass.mismatches == 0 && pass.canonicalVariants <= pass.fullVariants && pass.canonicalSwitches <= pass.fullSwitches;
+    }
+
+    std::cout << "Shader mask table benchmark: " << a_Samples << " draws per pass. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    for(const auto& pass : passes)
+    {
+        std::cout << "    " << pass.name << ": " << pass.fullVariants << " -> " << pass.canonicalVariants << " programs, "
+            << pass.fullSwitches << " -> " << pass.canonicalSwitches << " program switches, " << pass.mismatches << " shaders changed by folding" << std::endl;
+    }
+
+    return valid;
+}
+
+namespace
+{
+    //Keeps the state that a graphics API would have after the calls it receives, and counts the calls.
+    class RecordingStateBackend : public blurp::StateTrackerBackend
+    {
+    public:
+        RecordingStateBackend() : calls(0), activeUnit(0) {}
+
+        void UseProgram(std::uint32_t a_Program) override { Record("program", a_Program); }
+        void BindVertexArray(std::uint32_t a_VertexArray) override { Record("vao", a_VertexArray); }
+        void ActiveTexture(std::uint32_t a_Unit) override { ++calls; activeUnit = a_Unit; }
+        void BindTexture(std::uint32_t a_Target, std::uint32_t a_Texture) override { Record("texture " + std::to_string(activeUnit) + " " + std::to_string(a_Target), a_Texture); }
+        void BindSampler(std::uint32_t a_Unit, std::uint32_t a_Sampler) override { Record("sampler " + std::to_string(a_Unit), a_Sampler); }
+        void BindBuffer(std::uint32_t a_Target, std::uint32_t a_Buffer) override { Record("buffer " + std::to_string(a_Target), a_Buffer); }
+
+        void BindBufferBase(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer) override
+        {
+            BindBufferRange(a_Target, a_Index, a_Buffer, 0, -1);
+        }
+
+        void BindBufferRange(std::uint32_t a_Target, std::uint32_t a_Index, std::uint32_t a_Buffer, std::int64_t a_Offset, std::int64_t a_Size) override
+        {
+            //Indexed binds also bind to the generic target.
+            const std::string key = "indexed " + std::to_string(a_Target) + " " + std::to_string(a_Index);
+            state[key] = a_Buffer;
+            state[key + " offset"] = a_Offset;
+            state[key + " size"] = a_Size;
+            state["buffer " + std::to_string(a_Target)] = a_Buffer;
+            ++calls;
+        }
+
+        void BindFramebuffer(std::uint32_t a_Framebuffer) override { Record("framebuffer", a_Framebuffer); }
+        void SetEnabled(std::uint32_t a_Capability, bool a_Enabled) override { Record("enabled " + std::to_string(a_Capability), a_Enabled); }
+        void DepthFunc(std::uint32_t a_Function) override { Record("depthFunc", a_Function); }
+        void DepthMask(bool a_Write) override { Record("depthMask", a_Write); }
+        void CullFace(std::uint32_t a_Face) override { Record("cullFace", a_Face); }
+        void FrontFace(std::uint32_t a_WindingOrder) override { Record("frontFace", a_WindingOrder); }
+
+        void BlendFuncSeparate(std::uint32_t a_SrcRgb, std::uint32_t a_DstRgb, std::uint32_t a_SrcAlpha, std::uint32_t a_DstAlpha) override
+        {
+            Record("blendFunc", (static_cast<std::int64_t>(a_SrcRgb) << 48) | (static_cast<std::int64_t>(a_DstRgb) << 32) | (a_SrcAlpha << 16) | a_DstAlpha);
+        }
+
+        void BlendEquationSeparate(std::uint32_t a_Rgb, std::uint32_t a_Alpha) override { Record("blendEquation", (static_cast<std::int64_t>(a_Rgb) << 32) | a_Alpha); }
+
+        void StencilFuncSeparate(blurp::StateFace a_Face, std::uint32_t a_Function, std::int32_t a_Reference, std::uint32_t a_Mask) override
+        {
+            const std::string face = a_Face == blurp::StateFace::FRONT ? "front" : "back";
+            state["stencilFunc " + face] = a_Function;
+            state["stencilRef " + face] = a_Reference;
+            Record("stencilReadMask " + face, a_Mask);
+        }
+
+        void StencilOpSeparate(blurp::StateFace a_Face, std::uint32_t a_StencilFail, std::uint32_t a_DepthFail, std::uint32_t a_Pass) override
+        {
+            const std::string face = a_Face == blurp::StateFace::FRONT ? "front" : "back";
+            Record("stencilOp " + face, (static_cast<std::int64_t>(a_StencilFail) << 32) | (a_DepthFail << 16) | a_Pass);
+        }
+
+        void StencilMask(std::uint32_t a_Mask) override { Record("stencilMask", a_Mask); }
+        void Viewport(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) override { Record("viewport", Pack(a_X, a_Y, a_Width, a_Height)); }
+        void Scissor(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Width, std::int32_t a_Height) override { Record("scissor", Pack(a_X, a_Y, a_Width, a_Height)); }
+        void ClearColor(float a_R, float a_G, float a_B, float a_A) override { Record("clearColor", Pack(static_cast<std::int32_t>(a_R * 255.f), static_cast<std::int32_t>(a_G * 255.f), static_cast<std::int32_t>(a_B * 255.f), static_cast<std::int32_t>(a_A * 255.f))); }
+
+        std::map<std::string, std::int64_t> state;
+        std::uint32_t calls;
+        std::uint32_t activeUnit;
+
+    private:
+        void Record(const std::string& a_Name, std::int64_t a_Value)
+        {
+            state[a_Name] = a_Value;
+            ++calls;
+        }
+
+        static std::int64_t Pack(std::int32_t a_X, std::int32_t a_Y, std::int32_t a_Z, std::int32_t a_W)
+        {
+            return (static_cast<std::int64_t>(a_X & 0xFFFF) << 48) | (static_cast<std::int64_t>(a_Y & 0xFFFF) << 32) | (static_cast<std::int64_t>(a_Z & 0xFFFF) << 16) | (a_W & 0xFFFF);
+        }
+    };
+}
+
+bool BenchmarkStateTracker(std::uint32_t a_Calls, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    //Values in the format of the API are passed on unchanged, so any number works as long as both sides use the same one.
+    constexpr std::uint32_t DEPTH_TEST = 1;
+    constexpr std::uint32_t CULL = 2;
+    constexpr std::uint32_t BLEND = 3;
+    constexpr std::uint32_t STENCIL_TEST = 4;
+    constexpr std::uint32_t UNIFORM_BUFFER = 10;
+    constexpr std::uint32_t STORAGE_BUFFER = 11;
+    constexpr std::uint32_t TEXTURE_2D = 20;
+    constexpr std::uint32_t TEXTURE_2D_ARRAY = 21;
+
+    bool valid = true;
+
+    //Basic filtering and counting.
+    {
+        RecordingStateBackend backend;
+        StateTracker tracker(backend);
+
+        //Unknown state is always sent, repeated state is not.
+        tracker.UseProgram(0);
+        tracker.UseProgram(0);
+        tracker.UseProgram(3);
+        valid = valid && backend.calls == 2 && tracker.GetStats().issued == 2 && tracker.GetStats().filtered == 1;
+
+        //A texture on a new unit changes the active unit. Binding it again leaves out both calls.
+        tracker.BindTexture(2, TEXTURE_2D, 5);
+        tracker.BindTexture(2, TEXTURE_2D, 5);
+        tracker.BindTexture(2, TEXTURE_2D_ARRAY, 6);
+        valid = valid && backend.calls == 5 && backend.state["texture 2 20"] == 5 && backend.state["texture 2 21"] == 6;
+
+        //Indexed binds also set the generic binding, and a whole buffer is not the same as a range.
+        tracker.BindBufferBase(UNIFORM_BUFFER, 1, 7);
+        tracker.BindBuffer(UNIFORM_BUFFER, 7);
+        tracker.BindBufferRange(UNIFORM_BUFFER, 1, 7, 0, 256);
+        tracker.BindBufferRange(UNIFORM_BUFFER, 1, 7, 0, 256);
+        valid = valid && backend.calls == 7 && backend.state["indexed 10 1 size"] == 256;
+
+        //After invalidating everything is sent again, and after invalidating buffers only buffers are.
+        tracker.Invalidate();
+        tracker.UseProgram(3);
+        tracker.BindTexture(2, TEXTURE_2D, 5);
+        valid = valid && backend.calls == 10;
+        tracker.InvalidateBuffers();
+        tracker.UseProgram(3);
+        tracker.BindBufferRange(UNIFORM_BUFFER, 1, 7, 0, 256);
+        valid = valid && backend.calls == 11;
+
+        //The counters move to the last frame.
+        const StateTrackerStats frame = tracker.GetStats();
+        valid = valid && frame.issued == backend.calls;
+        tracker.NextFrame();
+        valid = valid && tracker.GetLastFrameStats().issued == frame.issued && tracker.GetLastFrameStats().filtered == frame.filtered;
+        valid = valid && tracker.GetStats().issued == 0 && tracker.GetStats().filtered == 0;
+    }
+
+    //Random calls with few different values, so that many are redundant. The tracked state has to match the state when every call is sent.
+    std::uint32_t randomIssued = 0;
+    std::uint32_t randomFiltered = 0;
+    {
+        RecordingStateBackend filtered;
+        RecordingStateBackend direct;
+        StateTracker tracker(filtered);
+
+        std::mt19937 random(19);
+        std::uniform_int_distribution<std::uint32_t> operation(0, 21);
+        std::uniform_int_distribution<std::uint32_t> value(0, 2);
+
+        for(std::uint32_t i = 0; i < a_Calls; ++i)
+        {
+            const std::uint32_t a = value(random);
+            const std::uint32_t b = value(random);
+            const std::uint32_t c = value(random);
+            const std::uint32_t d = value(random);
+            const StateFace face = a == 0 ? StateFace::FRONT : StateFace::BACK;
+
+            switch(operation(random))
+            {
+            case 0: tracker.UseProgram(a); direct.UseProgram(a); break;
+            case 1: tracker.BindVertexArray(a); direct.BindVertexArray(a); break;
+            case 2: tracker.BindFramebuffer(a); direct.BindFramebuffer(a); break;
+            case 3: tracker.BindTexture(a, TEXTURE_2D + b, c); direct.ActiveTexture(a); direct.BindTexture(TEXTURE_2D + b, c); break;
+            case 4: tracker.BindSampler(a, b); direct.BindSampler(a, b); break;
+            case 5: tracker.BindBuffer(UNIFORM_BUFFER + a % 2, b); direct.BindBuffer(UNIFORM_BUFFER + a % 2, b); break;
+            case 6: tracker.BindBufferBase(UNIFORM_BUFFER + a % 2, b, c); direct.BindBufferBase(UNIFORM_BUFFER + a % 2, b, c); break;
+            case 7: tracker.BindBufferRange(STORAGE_BUFFER, a, b, c * 256, 256); direct.BindBufferRange(STORAGE_BUFFER, a, b, c * 256, 256); break;
+            case 8: tracker.SetEnabled(DEPTH_TEST + a, b == 0); direct.SetEnabled(DEPTH_TEST + a, b == 0); break;
+            case 9: tracker.SetDepthFunc(a); direct.DepthFunc(a); break;
+            case 10: tracker.SetDepthMask(a == 0); direct.DepthMask(a == 0); break;
+            case 11: tracker.SetCullFace(a); direct.CullFace(a); break;
+            case 12: tracker.SetFrontFace(a); direct.FrontFace(a); break;
+            case 13: tracker.SetBlendFunc(a, b, c, d); direct.BlendFuncSeparate(a, b, c, d); break;
+            case 14: tracker.SetBlendEquation(a, b); direct.BlendEquationSeparate(a, b); break;
+            case 15: tracker.SetStencilFunc(face, b, c, d); direct.StencilFuncSeparate(face, b, c, d); break;
+            case 16: tracker.SetStencilOp(face, b, c, d); direct.StencilOpSeparate(face, b, c, d); break;
+            case 17: tracker.SetStencilMask(a); direct.StencilMask(a); break;
+            case 18: tracker.SetViewport(0, 0, 256 << a, 256 << b); direct.Viewport(0, 0, 256 << a, 256 << b); break;
+            case 19: tracker.SetScissor(0, 0, 256 << a, 256 << b); direct.Scissor(0, 0, 256 << a, 256 << b); break;
+            case 20: tracker.SetClearColor(a * 0.5f, b * 0.5f, c * 0.5f, 1.f); direct.ClearColor(a * 0.5f, b * 0.5f, c * 0.5f, 1.f); break;
+            default:
+                //Forgetting state is always safe, it only sends more.
+                if(a == 0)
+                {
+                    tracker.Invalidate();
+                }
+                else
+                {
+                    tracker.InvalidateBuffers();
+                }
+                break;
+            }
+
+            //The active unit is only used by texture binds, which set it when they need to.
+            valid = valid && filtered.state == direct.state;
+        }
+
+        randomIssued = tracker.GetStats().issued;
+        randomFiltered = tracker.GetStats().filtered;
+        valid = valid && randomIssued == filtered.calls && randomIssued + randomFiltered == direct.calls;
+    }
+
+    //Frames of a shadow pass and a forward pass that switch between two pipeline states and a few materials, the way the OpenGL passes set their state.
+    RecordingStateBackend backend;
+    StateTracker tracker(backend);
+    std::uint32_t untracked = 0;
+    for(std::uint32_t frame = 0; frame < a_Frames; ++frame)
+    {
+        tracker.NextFrame();
+        tracker.Invalidate();
+        const std::uint32_t before = backend.calls;
+
+        //Shadow pass.
+        tracker.SetEnabled(DEPTH_TEST, true);
+        tracker.SetDepthFunc(1);
+        tracker.SetDepthMask(true);
+        tracker.SetEnabled(CULL, true);
+        tracker.SetCullFace(1);
+        tracker.SetFrontFace(1);
+        tracker.BindFramebuffer(1);
+        tracker.SetViewport(0, 0, 2048, 2048);
+        tracker.SetScissor(0, 0, 2048, 2048);
+        tracker.BindBufferBase(UNIFORM_BUFFER, 1, 1);
+        for(std::uint32_t draw = 0; draw < 64; ++draw)
+        {
+            tracker.UseProgram(1 + draw / 32);
+            tracker.BindBufferRange(STORAGE_BUFFER, 0, 2, draw * 1024, 1024);
+            tracker.BindBufferBase(UNIFORM_BUFFER, 2, 3);
+            tracker.BindVertexArray(1 + draw % 8);
+        }
+
+        //Forward pass. The pipeline state is set again whenever it changes, and textures whenever the material changes.
+        tracker.BindFramebuffer(0);
+        tracker.SetClearColor(0.f, 0.f, 0.f, 1.f);
+        tracker.SetViewport(0, 0, 1920, 1080);
+        tracker.SetScissor(0, 0, 1920, 1080);
+        tracker.BindBufferBase(UNIFORM_BUFFER, 1, 4);
+        tracker.BindTexture(6, TEXTURE_2D_ARRAY, 9);
+        tracker.BindSampler(6, 1);
+        for(std::uint32_t draw = 0; draw < 64; ++draw)
+        {
+            const bool transparent = draw >= 48;
+            if(draw == 0 || draw == 48)
+            {
+                tracker.SetEnabled(DEPTH_TEST, true);
+                tracker.SetDepthFunc(1);
+                tracker.SetDepthMask(!transparent);
+                tracker.SetEnabled(STENCIL_TEST, false);
+                tracker.SetEnabled(CULL, true);
+                tracker.SetCullFace(2);
+                tracker.SetFrontFace(1);
+                tracker.SetEnabled(BLEND, transparent);
+                if(transparent)
+                {
+                    tracker.SetBlendFunc(4, 5, 1, 0);
+                    tracker.SetBlendEquation(0, 0);
+                }
+            }
+
+            tracker.UseProgram(3 + draw / 16);
+            for(std::uint32_t unit = 0; unit < 4; ++unit)
+            {
+                tracker.BindTexture(unit, TEXTURE_2D, 10 + unit + (draw / 4) * 4);
+            }
+            tracker.BindBufferRange(STORAGE_BUFFER, 0, 2, draw * 1024, 1024);
+            tracker.BindVertexArray(1 + draw % 8);
+        }
+
+        untracked = tracker.GetStats().issued + tracker.GetStats().filtered;
+        valid = valid && tracker.GetStats().issued == backend.calls - before;
+    }
+    tracker.NextFrame();
+    const StateTrackerStats frameStats = tracker.GetLastFrameStats();
+
+    //Time sending calls that are all filtered.
+    const double filterTime = Measure(100000, [&](std::uint32_t a_Index)
+    {
+        tracker.BindTexture(a_Index % 4, TEXTURE_2D, 1);
+        tracker.SetEnabled(DEPTH_TEST, true);
+    });
+
+    std::cout << "State tracker benchmark: " << a_Calls << " random calls, " << a_Frames << " frames. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Random calls: " << randomIssued << " sent, " << randomFiltered << " left out" << std::endl;
+    std::cout << "    Frame: " << untracked << " calls without tracking, " << frameStats.issued << " sent, " << frameStats.filtered << " left out" << std::endl;
+    std::cout << "    Filtered calls: " << filterTime << " us per 2 calls" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkPipelineStates(std::uint32_t a_Primitives)
+{
+    using namespace blurp;
+
+    std::mt19937 rng(31);
+    bool valid = true;
+
+    //The default state is always the same object, and default constructed states are copies of it.
+    const PipelineState& defaultState = PipelineState::GetDefault();
+    valid = valid && &PipelineState::Intern(BlendData(), TopologyType::TRIANGLES, CullMode::CULL_BACK, WindingOrder::COUNTER_CLOCKWISE, DepthStencilData()) == &defaultState;
+    valid = valid && PipelineState().GetId() == defaultState.GetId();
+
+    //Every primitive picks its contents out of 48 combinations, like a loaded scene where many primitives use the same material settings.
+    constexpr std::uint32_t combinations = 48;
+    const auto intern = [](std::uint32_t a_Combination) -> const PipelineState&
+    {
+        BlendData blend;
+        DepthStencilData depthStencil;
+        blend.blend = (a_Combination & 1) != 0;
+        if(blend.blend)
+        {
+            blend.srcBlend = BlendType::BLEND_SRC_ALPHA;
+            blend.dstBlend = BlendType::BLEND_INV_SRC_ALPHA;
+        }
+        depthStencil.depthWrite = (a_Combination & 2) != 0;
+        depthStencil.stencilRef = static_cast<int>((a_Combination >> 2) & 1);
+        const auto topology = ((a_Combination >> 3) & 1) != 0 ? TopologyType::LINES : TopologyType::TRIANGLES;
+        const auto cullMode = static_cast<CullMode>((a_Combination >> 4) % 3);
+        return PipelineState::Intern(blend, topology, cullMode, WindingOrder::COUNTER_CLOCKWISE, depthStencil);
+    };
+
+    const std::uint32_t countBefore = PipelineState::GetInternedCount();
+    std::vector<const PipelineState*> states(combinations, nullptr);
+    std::vector<std::uint32_t> firstUse;
+    for(std::uint32_t primitive = 0; primitive < a_Primitives; ++primitive)
+    {
+        const std::uint32_t combination = rng() % combinations;
+        const PipelineState& state = intern(combination);
+        if(states[combination] == nullptr)
+        {
+            states[combination] = &state;
+            firstUse.push_back(combination);
+        }
+        valid = valid && states[combination] == &state;
+    }
+
+    //Only new contents add a state, so interning everything again changes nothing.
+    const std::uint32_t countAfter = PipelineState::GetInternedCount();
+    valid = valid && countAfter - countBefore <= firstUse.size();
+    for(std::uint32_t combination = 0; combination < combinations; ++combination)
+    {
+        intern(combination);
+    }
+    const std::uint32_t countAll = PipelineState::GetInternedCount();
+    for(std::uint32_t combination = 0; combination < combinations; ++combination)
+    {
+        const PipelineState& state = intern(combination);
+        valid = valid && (states[combination] == nullptr || states[combination] == &state);
+        states[combination] = &state;
+
+        //Compile gives a copy with the same id.
+        const PipelineState copy = PipelineState::Compile(state.GetBlendData(), state.GetTopology(), state.GetCullMode(), state.GetFrontWindingOrder(), state.GetDepthStencilData());
+        valid = valid && copy.GetId() == state.GetId();
+    }
+    valid = valid && PipelineState::GetInternedCount() == countAll;
+
+    //Different contents have different ids, and opaque states come before blended states.
+    for(std::uint32_t a = 0; a < combinations; ++a)
+    {
+        for(std::uint32_t b = a + 1; b < combinations; ++b)
+        {
+            valid = valid && states[a]->GetId() != states[b]->GetId();
+            if(states[a]->GetBlendData().blend != states[b]->GetBlendData().blend)
+            {
+                const PipelineState* opaque = states[a]->GetBlendData().blend ? states[b] : states[a];
+                const PipelineState* blended = states[a]->GetBlendData().blend ? states[a] : states[b];
+                valid = valid && opaque->GetId() < blended->GetId();
+            }
+        }
+    }
+
+    //Count the fields that change when drawing the distinct states in order.
+    const auto countFieldChanges = [](const std::vector<const PipelineState*>& a_States)
+    {
+        std::uint32_t changes = 0;
+        for(std::size_t i = 1; i < a_States.size(); ++i)
+        {
+            const PipelineState& previous = *a_States[i - 1];
+            const PipelineState& current = *a_States[i];
+            changes += previous.GetBlendData().blend != current.GetBlendData().blend ? 1 : 0;
+            changes += previous.GetDepthStencilData().depthWrite != current.GetDepthStencilData().depthWrite ? 1 : 0;
+            changes += previous.GetCullMode() != current.GetCullMode() ? 1 : 0;
+            changes += previous.GetTopology() != current.GetTopology() ? 1 : 0;
+            changes += previous.GetDepthStencilData().stencilRef != current.GetDepthStencilData().stencilRef ? 1 : 0;
+        }
+        return changes;
+    };
+
+    std::vector<const PipelineState*> byFirstUse;
+    for(const auto combination : firstUse)
+    {
+        byFirstUse.push_back(states[combination]);
+    }
+    std::vector<const PipelineState*> byId = byFirstUse;
+    std::sort(byId.begin(), byId.end(), [](const PipelineState* a_Left, const PipelineState* a_Right)
+    {
+        return a_Left->GetId() < a_Right->GetId();
+    });
+
+    const double internTime = Measure(100000, [&](std::uint32_t a_Index)
+    {
+        intern(a_Index % combinations);
+    });
+
+    std::cout << "Pipeline state benchmark: " << a_Primitives << " primitives. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Ids: " << a_Primitives << " without interning, " << firstUse.size() << " interned" << std::endl;
+    std::cout << "    Field changes between distinct states: " << countFieldChanges(byFirstUse) << " in order of first use, " << countFieldChanges(byId) << " in order of id" << std::endl;
+    std::cout << "    Intern: " << internTime << " us per call" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkNullBackend(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    constexpr std::uint32_t numLights = 4;
+    constexpr std::uint32_t shadowDimension = 128;
+
+    BlurpSettings settings;
+    settings.shadersPath = a_ShadersPath;
+    NullScene scene;
+    InitNullScene(scene, settings, a_Instances, 1);
+    auto& resources = scene.engine.GetResourceManager();
+    scene.camera->GetTransform().SetTranslation({ 0.f, 20.f, 60.f });
+
+    //Shadowed point lights in a circle above the cubes.
+    TextureSettings shadowSettings;
+    shadowSettings.dimensions = glm::vec3(shadowDimension, shadowDimension, numLights * 6);
+    shadowSettings.generateMipMaps = false;
+    shadowSettings.dataType = DataType::FLOAT;
+    shadowSettings.pixelFormat = PixelFormat::DEPTH;
+    shadowSettings.memoryAccess = AccessMode::READ_WRITE;
+    shadowSettings.memoryUsage = MemoryUsage::GPU;
+    shadowSettings.textureType = TextureType::TEXTURE_CUBEMAP_ARRAY;
+    auto shadowMaps = resources.CreateTexture(shadowSettings);
+
+    std::vector<std::shared_ptr<PointLight>> lights;
+    for(std::uint32_t i = 0; i < numLights; ++i)
+    {
+        const float angle = (6.28f / numLights) * static_cast<float>(i);
+        LightSettings lightSettings;
+        lightSettings.color = glm::vec3(1.f);
+        lightSettings.intensity = 100.f;
+        lightSettings.pointLight.position = glm::vec3(cosf(angle) * 30.f, 15.f, sinf(angle) * 30.f);
+        lightSettings.type = LightType::LIGHT_POINT;
+        lightSettings.shadowMapIndex = i;
+        lights.push_back(std::reinterpret_pointer_cast<PointLight>(resources.CreateLight(lightSettings)));
+    }
+
+    //Pipeline with the same passes as a regular scene.
+    auto pipeline = resources.CreatePipeline(PipelineSettings());
+    auto clearPass = pipeline->AppendRenderPass<RenderPass_Clear>(RenderPassType::RP_CLEAR);
+    auto shadowPass = pipeline->AppendRenderPass<RenderPass_ShadowMap>(RenderPassType::RP_SHADOWMAP);
+    auto forwardPass = pipeline->AppendRenderPass<RenderPass_Forward>(RenderPassType::RP_FORWARD);
+
+    clearPass->AddRenderTarget(scene.target);
+    ClearData shadowClear;
+    shadowClear.size = glm::vec3(shadowDimension, shadowDimension, numLights * 6);
+    shadowClear.clearValue.floats[0] = 1.f;
+    clearPass->AddTexture(shadowMaps, shadowClear);
+
+    ShadowData shadowData;
+    shadowData.positional.shadowMaps = shadowMaps;
+    shadowPass->SetCamera(scene.camera);
+    shadowPass->SetOutput(shadowData);
+    forwardPass->SetCamera(scene.camera);
+    forwardPass->SetTarget(scene.target);
+    forwardPass->SetShadowData(shadowData);
+
+    LightIndexData allLights;
+    for(std::uint32_t i = 0; i < numLights; ++i)
+    {
+        allLights.posLights.set(i);
+    }
+    std::vector<LightIndexData> lightIndices(a_Instances, allLights);
+
+    LightData lightData;
+    LightUploadData lightUpload;
+    lightUpload.point.lights = &lights[0];
+    lightUpload.point.count = numLights;
+    lightUpload.lightData = &lightData;
+    scene.buffer->WriteData(scene.bufferEnd, lightUpload);
+
+    auto& recording = static_cast<RenderPipeline_Null&>(*pipeline).GetRecording();
+    const auto drawFrame = [&]()
+    {
+        forwardPass->Reset();
+        shadowPass->Reset();
+        for(std::uint32_t i = 0; i < numLights; ++i)
+        {
+            shadowPass->AddLight(lights[i], i);
+        }
+        shadowPass->SetGeometry(&scene.draws[0], &lightIndices[0], a_Instances);
+        forwardPass->SetDrawData(DrawDataSet(&scene.draws[0], a_Instances));
+        forwardPass->SetLights(lightData);
+        pipeline->Execute();
+    };
+
+    //Drawing the same frame twice records the same commands.
+    drawFrame();
+    const std::uint64_t firstHash = recording.GetHash();
+    const std::size_t firstCount = recording.GetCommands().size();
+    drawFrame();
+    bool valid = recording.GetHash() == firstHash && recording.GetCommands().size() == firstCount;
+
+    //The forward pass draws after binding its target for the last time, and every instance is drawn once.
+    const std::uint32_t targetId = recording.GetObjectId(scene.target.get());
+    const std::uint32_t meshId = recording.GetObjectId(scene.cube.get());
+    std::size_t forwardStart = 0;
+    for(std::size_t i = 0; i < recording.GetCommands().size(); ++i)
+    {
+        const auto& command = recording.GetCommands()[i];
+        if(command.type == RecordedCommandType::BIND_TARGET && command.object == targetId)
+        {
+            forwardStart = i;
+        }
+    }
+    std::uint32_t forwardDraws = 0;
+    std::uint64_t forwardInstances = 0;
+    for(std::size_t i = forwardStart; i < recording.GetCommands().size(); ++i)
+    {
+        const auto& command = recording.GetCommands()[i];
+        if(command.type == RecordedCommandType::DRAW_INDEXED)
+        {
+            valid = valid && command.object == meshId && command.count == cubeIndexCount;
+            forwardInstances += command.value;
+            ++forwardDraws;
+        }
+    }
+    valid = valid && forwardDraws == a_Instances && forwardInstances == a_Instances;
+
+    //Both clears are recorded once, and the shadow pass draws the cubes for the lights.
+    const std::uint32_t totalDraws = recording.GetCount(RecordedCommandType::DRAW_INDEXED);
+    const std::uint32_t shadowDraws = totalDraws - forwardDraws;
+    const std::size_t commandCount = recording.GetCommands().size();
+    const std::uint32_t shaderBinds = recording.GetCount(RecordedCommandType::BIND_SHADER);
+    const std::uint32_t meshBinds = recording.GetCount(RecordedCommandType::BIND_MESH);
+    const std::uint64_t uploadedBytes = recording.GetUploadedBytes();
+    valid = valid && shadowDraws > 0 && recording.GetCount(RecordedCommandType::CLEAR_TARGET) == 1 && recording.GetCount(RecordedCommandType::CLEAR_TEXTURE) == 1;
+
+    //Moving the camera changes the uploaded camera data, but not which commands are recorded.
+    scene.camera->GetTransform().Translate({ 1.f, 0.f, 0.f });
+    drawFrame();
+    valid = valid && recording.GetHash() != firstHash && recording.GetCommands().size() == firstCount;
+
+    const double frameTime = Measure(a_Frames, [&](std::uint32_t)
+    {
+        drawFrame();
+    });
+
+    std::cout << "Null backend benchmark: " << a_Instances << " instances, " << numLights << " shadowed point lights. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Commands per frame: " << commandCount << ", " << shaderBinds << " shader binds, " << meshBinds << " mesh binds" << std::endl;
+    std::cout << "    Draws per frame: " << shadowDraws << " shadow, " << forwardDraws << " forward" << std::endl;
+    std::cout << "    Uploaded per frame: " << uploadedBytes << " bytes" << std::endl;
+    std::cout << "    Execute: " << frameTime << " us per frame" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkCommandLists(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    constexpr std::uint32_t numMaterials = 16;
+    constexpr std::uint32_t drawsPerList = 128;
+
+    BlurpSettings settings;
+    settings.shadersPath = a_ShadersPath;
+    NullScene scene;
+    InitNullScene(scene, settings, a_Instances, 1);
+    auto& resources = scene.engine.GetResourceManager();
+    const std::uint32_t maxThreads = scene.engine.GetJobSystem().GetThreadCount();
+
+    //Alternating materials, so that every draw binds its material again.
+    std::vector<std::shared_ptr<Material>> materials;
+    for(std::uint32_t i = 0; i < numMaterials; ++i)
+    {
+        MaterialSettings materialSettings;
+        materialSettings.EnableAttribute(MaterialAttribute::DIFFUSE_CONSTANT_VALUE);
+        materialSettings.SetDiffuseConstant({ static_cast<float>(i) / numMaterials, 0.5f, 0.5f });
+        materials.push_back(resources.CreateMaterial(materialSettings));
+    }
+
+    for(std::uint32_t i = 0; i < a_Instances; ++i)
+    {
+        scene.draws[i].materialData.material = materials[i % numMaterials];
+    }
+
+    //Two pipelines with the same draws, of which one records on a single thread and the other on every hardware thread.
+    auto singlePipeline = resources.CreatePipeline(PipelineSettings());
+    auto singlePass = singlePipeline->AppendRenderPass<RenderPass_Forward>(RenderPassType::RP_FORWARD);
+    singlePass->SetCommandRecording(1, drawsPerList);
+
+    auto multiPipeline = resources.CreatePipeline(PipelineSettings());
+    auto multiPass = multiPipeline->AppendRenderPass<RenderPass_Forward>(RenderPassType::RP_FORWARD);
+    multiPass->SetCommandRecording(maxThreads, drawsPerList);
+
+    const auto drawFrame = [&](RenderPipeline& a_Pipeline, RenderPass_Forward& a_Pass)
+    {
+        a_Pass.Reset();
+        a_Pass.SetCamera(scene.camera);
+        a_Pass.SetTarget(scene.target);
+        a_Pass.SetDrawData(DrawDataSet(&scene.draws[0], a_Instances));
+        a_Pass.SetLights(LightData());
+        a_Pipeline.Execute();
+    };
+
+    auto& singleRecording = static_cast<RenderPipeline_Null&>(*singlePipeline).GetRecording();
+    auto& multiRecording = static_cast<RenderPipeline_Null&>(*multiPipeline).GetRecording();
+
+    //The amount of threads does not change the lists, or the commands that they replay.
+    drawFrame(*singlePipeline, *singlePass);
+    drawFrame(*multiPipeline, *multiPass);
+    const auto& lists = singlePass->GetDrawLists();
+    const std::uint64_t listHash = lists.GetHash();
+    const std::uint64_t recordingHash = singleRecording.GetHash();
+    bool valid = listHash == multiPass->GetDrawLists().GetHash() && recordingHash == multiRecording.GetHash();
+    valid = valid && lists.GetListCount() == (a_Instances + drawsPerList - 1) / drawsPerList && singleRecording.GetCount(RecordedCommandType::DRAW_INDEXED) == a_Instances;
+
+    //Drawing the same frame again replays the same lists without recording them.
+    drawFrame(*singlePipeline, *singlePass);
+    valid = valid && lists.GetRecordCount() == 1 && lists.GetHash() == listHash && singleRecording.GetHash() == recordingHash;
+
+    //Changing a material records the lists again.
+    const glm::vec3 diffuse = materials[0]->GetSettings().GetDiffuseValue();
+    materials[0]->GetSettings().SetDiffuseConstant({ 1.f, 0.f, 0.f });
+    drawFrame(*singlePipeline, *singlePass);
+    valid = valid && lists.GetRecordCount() == 2 && lists.GetHash() != listHash && singleRecording.GetHash() != recordingHash;
+
+    //Changing it back gives the first lists.
+    materials[0]->GetSettings().SetDiffuseConstant(diffuse);
+    drawFrame(*singlePipeline, *singlePass);
+    valid = valid && lists.GetRecordCount() == 3 && lists.GetHash() == listHash && singleRecording.GetHash() == recordingHash;
+
+    const std::uint32_t listCount = lists.GetListCount();
+    const std::uint32_t commandCount = lists.GetCommandCount();
+
+    //Every timed frame changes a material, so that the lists are recorded again.
+    const auto changeMaterial = [&](std::uint32_t a_Frame)
+    {
+        materials[a_Frame % numMaterials]->GetSettings().SetDiffuseConstant({ static_cast<float>(a_Frame % 7) / 7.f, 0.5f, 0.5f });
+    };
+    const double singleTime = Measure(a_Frames, [&](std::uint32_t a_Frame)
+    {
+        changeMaterial(a_Frame);
+        drawFrame(*singlePipeline, *singlePass);
+    });
+    const double multiTime = Measure(a_Frames, [&](std::uint32_t a_Frame)
+    {
+        changeMaterial(a_Frame);
+        drawFrame(*multiPipeline, *multiPass);
+    });
+    const double reuseTime = Measure(a_Frames, [&](std::uint32_t)
+    {
+        drawFrame(*multiPipeline, *multiPass);
+    });
+
+    std::cout << "Command list benchmark: " << a_Instances << " draws, " << numMaterials << " materials, " << drawsPerList << " draws per list. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Lists per frame: " << listCount << ", " << commandCount << " commands" << std::endl;
+    std::cout << "    Recorded on 1 thread:   " << singleTime << " us per frame" << std::endl;
+    std::cout << "    Recorded on " << maxThreads << " threads:  " << multiTime << " us per frame" << std::endl;
+    std::cout << "    Reused:                 " << reuseTime << " us per frame" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkParallelPrepare(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    constexpr std::uint32_t numLights = 4;
+    constexpr std::uint32_t shadowDimension = 128;
+
+    //The camera is shared by the shadow and forward passes, which are prepared at the same time.
+    BlurpSettings settings;
+    settings.shadersPath = a_ShadersPath;
+    NullScene scene;
+    InitNullScene(scene, settings, a_Instances, 7919);
+    auto& resources = scene.engine.GetResourceManager();
+    scene.camera->GetTransform().SetTranslation({ 0.f, 20.f, 60.f });
+
+    TextureSettings shadowSettings;
+    shadowSettings.dimensions = glm::vec3(shadowDimension, shadowDimension, numLights * 6);
+    shadowSettings.generateMipMaps = false;
+    shadowSettings.dataType = DataType::FLOAT;
+    shadowSettings.pixelFormat = PixelFormat::DEPTH;
+    shadowSettings.memoryAccess = AccessMode::READ_WRITE;
+    shadowSettings.memoryUsage = MemoryUsage::GPU;
+    shadowSettings.textureType = TextureType::TEXTURE_CUBEMAP_ARRAY;
+    auto shadowMaps = resources.CreateTexture(shadowSettings);
+
+    std::vector<std::shared_ptr<PointLight>> lights;
+    for(std::uint32_t i = 0; i < numLights; ++i)
+    {
+        const float angle = (6.28f / numLights) * static_cast<float>(i);
+        LightSettings lightSettings;
+        lightSettings.color = glm::vec3(1.f);
+        lightSettings.intensity = 100.f;
+        lightSettings.pointLight.position = glm::vec3(cosf(angle) * 30.f, 15.f, sinf(angle) * 30.f);
+        lightSettings.type = LightType::LIGHT_POINT;
+        lightSettings.shadowMapIndex = i;
+        lights.push_back(std::reinterpret_pointer_cast<PointLight>(resources.CreateLight(lightSettings)));
+    }
+
+    LightIndexData allLights;
+    for(std::uint32_t i = 0; i < numLights; ++i)
+    {
+        allLights.posLights.set(i);
+    }
+    std::vector<LightIndexData> lightIndices(a_Instances, allLights);
+
+    LightData lightData;
+    LightUploadData lightUpload;
+    lightUpload.point.lights = &lights[0];
+    lightUpload.point.count = numLights;
+    lightUpload.lightData = &lightData;
+    scene.buffer->WriteData(scene.bufferEnd, lightUpload);
+
+    ShadowData shadowData;
+    shadowData.positional.shadowMaps = shadowMaps;
+
+    //Two pipelines with the same passes, of which one prepares its passes on one thread and the other on multiple threads.
+    struct Scene
+    {
+        std::shared_ptr<RenderPipeline> pipeline;
+        std::shared_ptr<RenderPass_ShadowMap> shadowPass;
+        std::shared_ptr<RenderPass_Forward> forwardPass;
+    };
+
+    const auto createScene = [&](bool a_Parallel)
+    {
+        PipelineSettings pipelineSettings;
+        pipelineSettings.parallelPrepare = a_Parallel;
+
+        Scene result;
+        result.pipeline = resources.CreatePipeline(pipelineSettings);
+        auto clearPass = result.pipeline->AppendRenderPass<RenderPass_Clear>(RenderPassType::RP_CLEAR);
+        result.shadowPass = result.pipeline->AppendRenderPass<RenderPass_ShadowMap>(RenderPassType::RP_SHADOWMAP);
+        result.forwardPass = result.pipeline->AppendRenderPass<RenderPass_Forward>(RenderPassType::RP_FORWARD);
+
+        clearPass->AddRenderTarget(scene.target);
+        ClearData shadowClear;
+        shadowClear.size = glm::vec3(shadowDimension, shadowDimension, numLights * 6);
+        shadowClear.clearValue.floats[0] = 1.f;
+        clearPass->AddTexture(shadowMaps, shadowClear);
+
+        result.shadowPass->SetCamera(scene.camera);
+        result.shadowPass->SetOutput(shadowData);
+        result.shadowPass->SetDrawSorting(true);
+        result.forwardPass->SetCamera(scene.camera);
+        result.forwardPass->SetTarget(scene.target);
+        result.forwardPass->SetShadowData(shadowData);
+        result.forwardPass->SetDrawSorting(true);
+        return result;
+    };
+
+    Scene serial = createScene(false);
+    Scene parallel = createScene(true);
+
+    const auto drawFrame = [&](Scene& a_Scene)
+    {
+        a_Scene.forwardPass->Reset();
+        a_Scene.shadowPass->Reset();
+        for(std::uint32_t i = 0; i < numLights; ++i)
+        {
+            a_Scene.shadowPass->AddLight(lights[i], i);
+        }
+        a_Scene.shadowPass->SetGeometry(&scene.draws[0], &lightIndices[0], a_Instances);
+        a_Scene.forwardPass->SetDrawData(DrawDataSet(&scene.draws[0], a_Instances));
+        a_Scene.forwardPass->SetLights(lightData);
+        a_Scene.pipeline->Execute();
+    };
+
+    auto& serialRecording = static_cast<RenderPipeline_Null&>(*serial.pipeline).GetRecording();
+    auto& parallelRecording = static_cast<RenderPipeline_Null&>(*parallel.pipeline).GetRecording();
+
+    //Preparing on multiple threads records the same commands, also when the camera moves between frames.
+    bool valid = true;
+    for(std::uint32_t frame = 0; frame < 8; ++frame)
+    {
+        scene.camera->GetTransform().Translate({ 1.f, 0.f, -1.f });
+        drawFrame(serial);
+        drawFrame(parallel);
+        valid = valid && serialRecording.GetHash() == parallelRecording.GetHash() && serialRecording.GetCommands().size() == parallelRecording.GetCommands().size();
+    }
+    valid = valid && parallelRecording.GetCount(RecordedCommandType::DRAW_INDEXED) > a_Instances;
+
+    //Measure both, and add up the timings of every frame.
+    const auto measureScene = [&](Scene& a_Scene, PipelineTimings& a_Total)
+    {
+        a_Total = PipelineTimings();
+        a_Total.passes.resize(a_Scene.pipeline->GetTimings().passes.size());
+        return Measure(a_Frames, [&](std::uint32_t)
+        {
+            scene.camera->GetTransform().Translate({ 0.f, 0.f, 0.01f });
+            drawFrame(a_Scene);
+
+            const auto& timings = a_Scene.pipeline->GetTimings();
+            a_Total.prepare += timings.prepare;
+            a_Total.prepareWork += timings.prepareWork;
+            a_Total.criticalPath += timings.criticalPath;
+            a_Total.submit += timings.submit;
+            for(std::size_t i = 0; i < timings.passes.size(); ++i)
+            {
+                a_Total.passes[i].type = timings.passes[i].type;
+                a_Total.passes[i].prepare += timings.passes[i].prepare;
+                a_Total.passes[i].submit += timings.passes[i].submit;
+            }
+        });
+    };
+
+    PipelineTimings serialTotal;
+    PipelineTimings parallelTotal;
+    const double serialTime = measureScene(serial, serialTotal);
+    const double parallelTime = measureScene(parallel, parallelTotal);
+
+    const double frames = static_cast<double>(std::max(a_Frames, 1u));
+    const auto printTimings = [&](const char* a_Name, double a_FrameTime, const PipelineTimings& a_Total)
+    {
+        std::cout << "    " << a_Name << ": " << a_FrameTime << " us per frame" << std::endl;
+        std::cout << "        Prepare: " << a_Total.prepare / frames << " us, work " << a_Total.prepareWork / frames << " us, critical path " << a_Total.criticalPath / frames << " us" << std::endl;
+        std::cout << "        Submit: " << a_Total.submit / frames << " us" << std::endl;
+        for(const auto& pass : a_Total.passes)
+        {
+            std::cout << "        Pass " << static_cast<int>(pass.type) << ": prepare " << pass.prepare / frames << " us, submit " << pass.submit / frames << " us" << std::endl;
+        }
+    };
+
+    std::cout << "Parallel prepare benchmark: " << a_Instances << " sorted instances, " << numLights << " shadowed point lights. Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    printTimings("Prepared on one thread", serialTime, serialTotal);
+    printTimings("Prepared in parallel", parallelTime, parallelTotal);
+
+    return valid;
+}
+
+bool BenchmarkProfiler(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames)
+{
+    using namespace blurp;
+
+    constexpr std::uint32_t numFrames = 4;
+
+    //The ring buffer only keeps the last frames, and the frame that is being recorded is always the last one.
+    Profiler profiler(numFrames);
+    for(std::uint32_t frame = 0; frame < 10; ++frame)
+    {
+        profiler.AddCpuEvent("Frame work", profiler.Now(), 1.0);
+        profiler.NextFrame();
+    }
+    auto frames = profiler.GetFrames();
+    bool valid = frames.size() == numFrames && frames.front().index == 7 && frames.back().index == 10 && profiler.GetFrameIndex() == 10;
+    for(std::size_t i = 0; i + 1 < frames.size(); ++i)
+    {
+        valid = valid && frames[i].events.size() == 1 && frames[i].index + 1 == frames[i + 1].index;
+    }
+    valid = valid && frames.back().events.empty();
+
+    //GPU markers arrive late and are added to their own frame, unless it was already replaced.
+    profiler.AddGpuEvent(8, "Late GPU work", 0.0, 2.0);
+    profiler.AddGpuEvent(3, "Lost GPU work", 0.0, 2.0);
+    profiler.AddGpuEvent(11, "Future GPU work", 0.0, 2.0);
+
+    //Markers are dropped while disabled, and every thread that records markers gets its own index.
+    profiler.SetEnabled(false);
+    profiler.AddCpuEvent("Dropped", profiler.Now(), 1.0);
+    profiler.SetEnabled(true);
+    {
+        ProfileScope scope(profiler, "Quote \" and \\ slash");
+    }
+    std::thread([&profiler]() { ProfileScope scope(profiler, "Other thread"); }).join();
+
+    frames = profiler.GetFrames();
+    std::uint32_t gpuEvents = 0;
+    for(const auto& frame : frames)
+    {
+        for(const auto& event : frame.events)
+        {
+            gpuEvents += event.type == ProfileEventType::GPU ? 1 : 0;
+        }
+    }
+    valid = valid && gpuEvents == 1 && frames[1].events.size() == 2 && frames[1].events[1].type == ProfileEventType::GPU;
+    valid = valid && frames.back().events.size() == 2 && frames.back().events[0].thread == 0 && frames.back().events[1].thread == 1;
+
+    //Every marker and finished frame is a complete event in the trace, and names are escaped.
+    std::ostringstream trace;
+    profiler.WriteChromeTrace(trace);
+    const std::string json = trace.str();
+    std::size_t completeEvents = 0;
+    for(std::size_t found = json.find("\"ph\":\"X\""); found != std::string::npos; found = json.find("\"ph\":\"X\"", found + 1))
+    {
+        ++completeEvents;
+    }
+    valid = valid && json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0) == 0 && json.find("\n]}") != std::string::npos;
+    //The finished frames with one marker each, the late GPU marker and the two markers of the current frame.
+    valid = valid && completeEvents == (numFrames - 1) * 2 + 1 + 2 && json.find("\"Quote \\\" and \\\\ slash\"") != std::string::npos;
+    valid = valid && json.find("Lost GPU work") == std::string::npos && json.find("\"Thread 1\"") != std::string::npos;
+
+    //Headless engine, which records CPU markers only because nothing is sent to a GPU.
+    BlurpSettings settings;
+    settings.shadersPath = a_ShadersPath;
+    settings.profilerFrames = numFrames;
+    NullScene scene;
+    InitNullScene(scene, settings, a_Instances, 1);
+    auto& resources = scene.engine.GetResourceManager();
+
+    auto pipeline = resources.CreatePipeline(PipelineSettings());
+    auto clearPass = pipeline->AppendRenderPass<RenderPass_Clear>(RenderPassType::RP_CLEAR);
+    auto forwardPass = pipeline->AppendRenderPass<RenderPass_Forward>(RenderPassType::RP_FORWARD);
+    clearPass->AddRenderTarget(scene.target);
+
+    auto& engineProfiler = scene.engine.GetProfiler();
+    const auto drawFrame = [&](std::uint32_t)
+    {
+        scene.camera->GetTransform().Translate({ 0.f, 0.f, 0.01f });
+        forwardPass->Reset();
+        forwardPass->SetCamera(scene.camera);
+        forwardPass->SetTarget(scene.target);
+        forwardPass->SetDrawData(DrawDataSet(&scene.draws[0], a_Instances));
+        forwardPass->SetLights(LightData());
+        pipeline->Execute();
+        engineProfiler.NextFrame();
+    };
+
+    for(std::uint32_t frame = 0; frame < numFrames * 2; ++frame)
+    {
+        drawFrame(frame);
+    }
+
+    //Every finished frame has a marker for each phase and pass.
+    frames = engineProfiler.GetFrames();
+    std::uint32_t markers = 0;
+    for(std::size_t i = 0; i + 1 < frames.size(); ++i)
+    {
+        std::set<std::string> names;
+        for(const auto& event : frames[i].events)
+        {
+            names.insert(event.name);
+            valid = valid && event.type == ProfileEventType::CPU && event.duration >= 0.0;
+        }
+        markers += static_cast<std::uint32_t>(frames[i].events.size());
+
+#ifdef BLURP_PROFILING
+        const std::set<std::string> expected = { "RenderPipeline::Execute", "Prepare passes", "Prepare Clear", "Submit Clear", "Prepare Forward", "Submit Forward" };
+        valid = valid && std::includes(names.begin(), names.end(), expected.begin(), expected.end());
+#else
+        valid = valid && names.empty();
+#endif
+    }
+
+    //Measure the cost of recording, which is what profiling adds to every frame when it is compiled in.
+    engineProfiler.SetEnabled(false);
+    const double disabledTime = Measure(a_Frames, drawFrame);
+    engineProfiler.SetEnabled(true);
+    const double enabledTime = Measure(a_Frames, drawFrame);
+
+#ifdef BLURP_PROFILING
+    const char* mode = "compiled in";
+#else
+    const char* mode = "compiled out";
+#endif
+    std::cout << "Profiler benchmark: " << a_Instances << " instances, profiling " << mode << ". Results are " << (valid ? "valid" : "NOT VALID") << "." << std::endl;
+    std::cout << "    Markers per frame: " << markers / (numFrames - 1) << std::endl;
+    std::cout << "    Profiler disabled: " << disabledTime << " us per frame" << std::endl;
+    std::cout << "    Profiler enabled: " << enabledTime << " us per frame" << std::endl;
+
+    return valid;
+}
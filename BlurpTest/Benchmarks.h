@@ -0,0 +1,126 @@
+#pragma once
+#include <cinttypes>
+#include <string>
+
+/*
+ * Benchmarks that check the results of the code they measure against a reference or a known outcome.
+ * Every benchmark prints its results to the console, and returns false if any of its checks fail.
+ */
+
+/*
+ * Sort a_Draws random draws with blurp::DrawSorter, and check the key layout, the fields of every key and the order of opaque and blended draws.
+ * Prints the state changes in submission order and sorted order.
+ */
+bool BenchmarkDrawSorter(std::uint32_t a_Draws, std::uint32_t a_Iterations);
+
+/*
+ * Run a blurp::RingBufferAllocator with fake fences, checking alignment, wrapping, waiting on unsignalled fences and the frames in flight limit.
+ * Then a_Frames frames of random allocations are made while the fences signal two frames late, which must never overlap.
+ */
+bool BenchmarkRingBuffer(std::uint32_t a_Frames);
+
+/*
+ * Check that blurp::GpuBufferWriter writes the same bytes and views as WriteData, at aligned and unaligned offsets, and time a_Instances writes for both.
+ */
+bool BenchmarkGpuBufferWriter(std::uint32_t a_Instances, std::uint32_t a_Iterations);
+
+/*
+ * Check that every available blurp::TransformStore kernel builds the same matrices and normal matrices as blurp::Transform, and compare their speed.
+ * a_Count transforms are created. Each iteration changes a_DirtyPercentage percent of them and then builds the matrices.
+ */
+bool BenchmarkTransforms(std::uint32_t a_Count, std::uint32_t a_Iterations, std::uint32_t a_DirtyPercentage);
+
+/*
+ * Validate blurp::CullInstances against blurp::CullInstancesReference for a_Count random instances, and compare their speed.
+ */
+bool BenchmarkCulling(std::uint32_t a_Count, std::uint32_t a_Iterations);
+
+/*
+ * Validate blurp::LightClusterBuilder::Build against blurp::LightClusterBuilder::BuildReference for random point and spot lights, and compare their speed.
+ */
+bool BenchmarkLightClusters(std::uint32_t a_PointCount, std::uint32_t a_SpotCount, std::uint32_t a_Iterations);
+
+/*
+ * Schedule a_Count moving point lights into a_Slots shadow slots for a_Frames frames with blurp::ShadowLightScheduler, with and without hysteresis.
+ * Checks that no light without a slot outscores one with a slot, and that scheduling is deterministic.
+ */
+bool BenchmarkShadowScheduler(std::uint32_t a_Count, std::uint32_t a_Slots, std::uint32_t a_Frames);
+
+/*
+ * Check the invalidation counters of blurp::PositionalShadowCache over a fixed sequence of frames with a_Lights lights, and time a_Frames updates.
+ */
+bool BenchmarkShadowCache(std::uint32_t a_Lights, std::uint32_t a_Frames);
+
+/*
+ * Run blurp::CascadeScheduler for a_Frames frames with a still and then moving camera, and check which cascades are drawn.
+ * Also checks that blurp::RenderPass_ShadowMap::SnapToTexels puts the world origin on a texel corner.
+ */
+bool BenchmarkCascadeScheduler(std::uint32_t a_Frames);
+
+/*
+ * Validate blurp::RenderPass_ShadowMap::CalculateCubeFaceMask against the frustum planes of every cube face for a_Count random spheres,
+ * and check the lists and caster counts of blurp::ShadowCasterCuller for the same spheres.
+ */
+bool BenchmarkCubeFaceCulling(std::uint32_t a_Count, std::uint32_t a_Iterations);
+
+/*
+ * Store a_Variants shader variants in a blurp::ShaderBinaryCache with a fake backend, and check reloading, keys, and dropping damaged or foreign binaries.
+ */
+bool BenchmarkShaderBinaryCache(std::uint32_t a_Variants);
+
+/*
+ * Save and load a blurp::ShaderManifest with a_Variants variants, and check that it round trips and skips lines that can not be read.
+ */
+bool BenchmarkShaderManifest(std::uint32_t a_Variants);
+
+/*
+ * Count the programs compiled over a_Frames frames of two pipelines with and without a shared blurp::ShaderRegistry,
+ * and check eviction with a budget of a_Budget programs.
+ */
+bool BenchmarkShaderRegistry(std::uint32_t a_Frames, std::uint32_t a_Budget);
+
+/*
+ * Compare the slowest frame when compiling shader variants right away with a blurp::ShaderCompileQueue with a budget of a_BudgetMilliseconds,
+ * and check fallbacks, the budget and that every variant is finished once.
+ */
+bool BenchmarkShaderCompileQueue(std::uint32_t a_Variants, std::uint32_t a_CompileMicroseconds, float a_BudgetMilliseconds);
+
+/*
+ * Check the conditionals, includes and definitions of blurp::ShaderPreprocessor, and print how many forward shader variants in a_ShaderDirectory share a source.
+ */
+bool BenchmarkShaderPreprocessor(const std::string& a_ShaderDirectory);
+
+/*
+ * Check that folding the masks of a_Samples random draws with blurp::ShaderMaskTable gives the same preprocessed source, and print the programs saved.
+ */
+bool BenchmarkShaderMaskTable(const std::string& a_ShaderDirectory, std::uint32_t a_Samples);
+
+/*
+ * Check the state kept by blurp::StateTracker after each of a_Calls random calls, and print the calls left out over a_Frames recorded frames.
+ */
+bool BenchmarkStateTracker(std::uint32_t a_Calls, std::uint32_t a_Frames);
+
+/*
+ * Check that interning the pipeline states of a_Primitives random primitives shares states and ids, and that opaque states get lower ids than blended ones.
+ */
+bool BenchmarkPipelineStates(std::uint32_t a_Primitives);
+
+/*
+ * Record a clear, shadow map and forward pass with a_Instances cubes on GraphicsAPI::NONE, and check that the recording is stable and draws every instance once.
+ */
+bool BenchmarkNullBackend(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames);
+
+/*
+ * Record a_Instances draws into command lists on one thread and on every job system thread, and check that they match and are only recorded again when needed.
+ */
+bool BenchmarkCommandLists(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames);
+
+/*
+ * Check that preparing the passes on multiple threads records the same commands as preparing them one after another, and print the time of every phase.
+ */
+bool BenchmarkParallelPrepare(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames);
+
+/*
+ * Check the frames, GPU markers and Chrome trace of blurp::Profiler, and the markers the passes record with and without BLURP_PROFILING.
+ */
+bool BenchmarkProfiler(const std::string& a_ShadersPath, std::uint32_t a_Instances, std::uint32_t a_Frames);
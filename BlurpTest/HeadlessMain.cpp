@@ -0,0 +1,50 @@
+#include <iostream>
+#include <string>
+
+#include "Benchmarks.h"
+
+/*
+ * Runs every check from Benchmarks.h that works without a window or a GPU, with sizes small enough for a build agent.
+ * Built by the CMake build in the root of the repository. Returns the amount of checks that failed.
+ */
+int main()
+{
+    const std::string shadersPath = BLURP_SHADERS_PATH;
+
+    int failed = 0;
+    const auto check = [&](const char* a_Name, bool a_Valid)
+    {
+        if(!a_Valid)
+        {
+            std::cout << "FAILED: " << a_Name << std::endl;
+            ++failed;
+        }
+    };
+
+    check("DrawSorter", BenchmarkDrawSorter(10000, 10));
+    check("RingBuffer", BenchmarkRingBuffer(10000));
+    check("GpuBufferWriter", BenchmarkGpuBufferWriter(10000, 10));
+    check("Transforms", BenchmarkTransforms(10000, 10, 100));
+    check("Transforms", BenchmarkTransforms(10000, 10, 10));
+    check("Culling", BenchmarkCulling(10000, 10));
+    check("LightClusters", BenchmarkLightClusters(500, 100, 5));
+    check("ShadowScheduler", BenchmarkShadowScheduler(500, 8, 200));
+    check("ShadowCache", BenchmarkShadowCache(64, 200));
+    check("CascadeScheduler", BenchmarkCascadeScheduler(200));
+    check("CubeFaceCulling", BenchmarkCubeFaceCulling(10000, 5));
+    check("ShaderBinaryCache", BenchmarkShaderBinaryCache(64));
+    check("ShaderManifest", BenchmarkShaderManifest(200));
+    check("ShaderRegistry", BenchmarkShaderRegistry(100, 40));
+    check("ShaderCompileQueue", BenchmarkShaderCompileQueue(64, 500, 2.f));
+    check("ShaderPreprocessor", BenchmarkShaderPreprocessor(shadersPath + "opengl/"));
+    check("ShaderMaskTable", BenchmarkShaderMaskTable(shadersPath + "opengl/", 500));
+    check("StateTracker", BenchmarkStateTracker(10000, 10));
+    check("PipelineStates", BenchmarkPipelineStates(10000));
+    check("NullBackend", BenchmarkNullBackend(shadersPath, 200, 5));
+    check("CommandLists", BenchmarkCommandLists(shadersPath, 500, 5));
+    check("ParallelPrepare", BenchmarkParallelPrepare(shadersPath, 500, 5));
+    check("Profiler", BenchmarkProfiler(shadersPath, 500, 5));
+
+    std::cout << (failed == 0 ? "All headless checks passed." : "Some headless checks FAILED.") << std::endl;
+    return failed;
+}
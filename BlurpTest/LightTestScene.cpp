@@ -396,7 +396,12 @@ void LightTestScene::Update()
         m_LightMeshDrawData.transformData.dataRange = m_TransformBuffer->WriteData<glm::mat4>(m_PlaneDrawData.transformData.dataRange.end, lightTransforms.size(), 16, &lightTransforms[0]);
     }
 
-    m_TransformBuffer->WriteData(m_LightMeshDrawData.transformData.dataRange.end, lud);
+    auto lightView = m_TransformBuffer->WriteData(m_LightMeshDrawData.transformData.dataRange.end, lud);
+
+    //Assign the lights to clusters so that every fragment only uses the lights that reach it.
+    m_LightClusters.Build(*m_Camera, lud);
+    m_LightClusters.Upload(m_TransformBuffer, lightView.end, lData);
+    m_ForwardPass->SetLights(lData);
 
     //Update the instance count for the lights.
     m_LightMeshDrawData.instanceCount = lightTransforms.size();
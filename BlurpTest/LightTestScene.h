@@ -6,6 +6,7 @@
 #include <Mesh.h>
 #include <Camera.h>
 #include <Material.h>
+#include <LightClusterBuilder.h>
 
 #include <RenderPass_Skybox.h>
 
@@ -49,6 +50,9 @@ private:
     blurp::Transform m_LightMeshTransform;
     blurp::DrawData m_LightMeshDrawData;
 
+    //Assigns the point and spot lights to clusters.
+    blurp::LightClusterBuilder m_LightClusters;
+
     //Skybox
     std::shared_ptr<blurp::Texture> m_SkyBoxTexture;
 
@@ -10,6 +10,7 @@
 
 
 
+#include "Benchmarks.h"
 #include "LightTestScene.h"
 #include "MaterialTestScene.h"
 #include "Scene.h"
@@ -144,6 +145,38 @@ int main()
     }
 
 
+    //BENCHMARKS
+
+    constexpr bool runBenchmarks = false;
+
+    if(runBenchmarks)
+    {
+        BenchmarkDrawSorter(10000, 100);
+        BenchmarkRingBuffer(10000);
+        BenchmarkGpuBufferWriter(10000, 100);
+        BenchmarkTransforms(100000, 100, 100);
+        BenchmarkTransforms(100000, 100, 10);
+        BenchmarkCulling(100000, 100);
+        BenchmarkLightClusters(2000, 500, 20);
+        BenchmarkShadowScheduler(500, 8, 1000);
+        BenchmarkShadowCache(64, 1000);
+        BenchmarkCascadeScheduler(1000);
+        BenchmarkCubeFaceCulling(100000, 20);
+        BenchmarkShaderBinaryCache(64);
+        BenchmarkShaderManifest(1000);
+        BenchmarkShaderRegistry(500, 40);
+        BenchmarkShaderCompileQueue(256, 500, 2.f);
+        BenchmarkShaderPreprocessor(blurpSettings.shadersPath + "opengl/");
+        BenchmarkShaderMaskTable(blurpSettings.shadersPath + "opengl/", 2000);
+        BenchmarkStateTracker(100000, 100);
+        BenchmarkPipelineStates(10000);
+        BenchmarkNullBackend(blurpSettings.shadersPath, 1000, 100);
+        BenchmarkCommandLists(blurpSettings.shadersPath, 10000, 100);
+        BenchmarkParallelPrepare(blurpSettings.shadersPath, 10000, 100);
+        BenchmarkProfiler(blurpSettings.shadersPath, 10000, 100);
+    }
+
+
     //RENDERING
 
 
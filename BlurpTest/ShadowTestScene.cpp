@@ -616,33 +616,25 @@ void ShadowTestScene::Update()
     //Add the positional light representations to the drawing.
     drawDatas.push_back(m_LightMeshDrawData);
 
-    //Every light affects every geometry, so make a collection of each index.
-    std::vector<int> dirLightShadowIndices;
-    std::vector<int> posLightShadowIndices;
+    //Every light affects every geometry, so set the bit of each light.
+    LightIndexData allLights;
 
     //Setup the shadow mapping for this frame. Exclude the last Drawdata which is the light mesh.
     for(int i = 0; i < NUM_SHADOW_POS_LIGHTS; ++i)
     {
         m_ShadowGenerationPass->AddLight(m_PointLights[i], i);
-        posLightShadowIndices.push_back(i);
+        allLights.posLights.set(i);
     }
 
     for(int i = 0; i < NUM_SHADOW_DIR_LIGHTS; ++i)
     {
        m_ShadowGenerationPass->AddLight(m_DirLights[i], i);
-       dirLightShadowIndices.push_back(i);
+       allLights.dirLights.set(i);
     }
     
 
-    std::vector<LightIndexData> lIndexData;
-    lIndexData.reserve(drawDatas.size() - 1);
-
     //Don't generate shadows for the light spheres (which are at the last index of drawDatas).
-    for(int i = 0; i < static_cast<int>(drawDatas.size() - 1); ++i)
-    {
-        //0 and 0 indicates that each piece of geometry is affected by the dir light at index 0, and the pos light at index 0.
-        lIndexData.emplace_back(LightIndexData{ dirLightShadowIndices, posLightShadowIndices});
-    }
+    std::vector<LightIndexData> lIndexData(drawDatas.size() - 1, allLights);
 
     m_ShadowGenerationPass->SetGeometry(&drawDatas[0], &lIndexData[0], lIndexData.size());
 
@@ -0,0 +1,283 @@
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+#include <BlurpEngine.h>
+#include <Culling.h>
+#include <JobSystem.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Entity.h"
+#include "Game.h"
+#include "SceneBVH.h"
+#include "Timer.h"
+
+bool BenchmarkSceneBVH(std::uint32_t a_Count, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    //Asteroids are placed in a ring around the origin, like in the game.
+    std::vector<Asteroid> asteroids(a_Count, Asteroid(0));
+    std::vector<glm::vec3> velocities(a_Count);
+
+    for(std::uint32_t i = 0; i < a_Count; ++i)
+    {
+        const float angle = 2.f * 3.141592f * unit(random);
+        const float distance = 200.f + unit(random) * 1800.f;
+        auto& transform = asteroids[i].GetTransform();
+        transform.SetTranslation({ std::cos(angle) * distance, (unit(random) - 0.5f) * 200.f, std::sin(angle) * distance });
+        transform.SetScale(0.5f + unit(random) * 2.f);
+
+        velocities[i] = glm::vec3(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f) * 20.f;
+    }
+
+    //Unit cube as the asteroid mesh.
+    MeshBounds meshBounds;
+    meshBounds.min = glm::vec3(-1.f);
+    meshBounds.max = glm::vec3(1.f);
+    meshBounds.radius = std::sqrt(3.f);
+
+    SceneBVH bvh(1.f);
+
+    utilities::Timer timer;
+    for(auto& asteroid : asteroids)
+    {
+        asteroid.SetSceneProxy(bvh.Insert(&asteroid, TransformBounds(meshBounds, asteroid.GetTransform().GetTransformation())));
+    }
+    const float buildTime = timer.measure(utilities::TimeUnit::MILLIS);
+
+    const float deltaTime = 1.f / 60.f;
+    const glm::mat4 projection = glm::perspective(glm::radians(70.f), 16.f / 9.f, 0.1f, 1000.f);
+
+    bool valid = true;
+    double moveTime = 0.0;
+    double refitTime = 0.0;
+    double frustumTime = 0.0;
+    double bruteForceTime = 0.0;
+    double sphereTime = 0.0;
+    double rayTime = 0.0;
+    std::uint64_t frustumResults = 0;
+    std::uint64_t frustumVisited = 0;
+
+    std::vector<Entity*> results;
+    std::vector<RayHit> hits;
+    std::vector<MeshBounds> worldBounds(a_Count);
+
+    bvh.ResetStats();
+
+    for(std::uint32_t iteration = 0; iteration < a_Iterations; ++iteration)
+    {
+        //Move the asteroids. This is the same for both approaches, so it is timed separately.
+        timer.reset();
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            auto& transform = asteroids[i].GetTransform();
+            transform.Translate(velocities[i] * deltaTime);
+            worldBounds[i] = TransformBounds(meshBounds, transform.GetTransformation());
+        }
+        moveTime += timer.measure(utilities::TimeUnit::MICROS);
+
+        timer.reset();
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            bvh.Move(asteroids[i].GetSceneProxy(), worldBounds[i], velocities[i] * deltaTime);
+        }
+        refitTime += timer.measure(utilities::TimeUnit::MICROS);
+
+        //The camera circles through the ring.
+        const float angle = static_cast<float>(iteration) * 0.05f;
+        const glm::vec3 eye(std::cos(angle) * 1000.f, 50.f, std::sin(angle) * 1000.f);
+        const glm::vec3 target(std::cos(angle + 0.3f) * 1000.f, 0.f, std::sin(angle + 0.3f) * 1000.f);
+        const Frustum frustum = ExtractFrustum(projection * glm::lookAt(eye, target, glm::vec3(0.f, 1.f, 0.f)));
+
+        const auto visitedBefore = bvh.GetStats().nodesVisited;
+        results.clear();
+        timer.reset();
+        bvh.QueryFrustum(frustum, results);
+        frustumTime += timer.measure(utilities::TimeUnit::MICROS);
+        frustumVisited += bvh.GetStats().nodesVisited - visitedBefore;
+        frustumResults += results.size();
+
+        //Test every asteroid against the frustum, which is what a query without the BVH costs.
+        timer.reset();
+        std::size_t bruteForceResults = 0;
+        for(std::uint32_t i = 0; i < a_Count; ++i)
+        {
+            const glm::vec3 center = (worldBounds[i].min + worldBounds[i].max) * 0.5f;
+            const glm::vec3 extent = (worldBounds[i].max - worldBounds[i].min) * 0.5f;
+
+            bool inside = true;
+            for(const auto& plane : frustum.planes)
+            {
+                if(glm::dot(glm::vec3(plane), center) + plane.w < -glm::dot(glm::abs(glm::vec3(plane)), extent))
+                {
+                    inside = false;
+                    break;
+                }
+            }
+            bruteForceResults += inside ? 1 : 0;
+        }
+        bruteForceTime += timer.measure(utilities::TimeUnit::MICROS);
+
+        valid = valid && bruteForceResults == results.size();
+
+        //Everything near the camera, and everything in front of it.
+        results.clear();
+        timer.reset();
+        bvh.QuerySphere(eye, 100.f, results);
+        sphereTime += timer.measure(utilities::TimeUnit::MICROS);
+
+        hits.clear();
+        timer.reset();
+        bvh.QueryRay(eye, glm::normalize(target - eye), 1000.f, hits);
+        rayTime += timer.measure(utilities::TimeUnit::MICROS);
+    }
+
+    const double iterations = static_cast<double>(a_Iterations);
+    const auto& stats = bvh.GetStats();
+
+    std::cout << "Scene BVH benchmark: " << a_Count << " moving asteroids, tree height " << bvh.GetHeight() << ". Results " << (valid && bvh.Validate() ? "match" : "DO NOT MATCH") << " brute force." << std::endl;
+    std::cout << "    Build:           " << buildTime << " ms" << std::endl;
+    std::cout << "    Move asteroids:  " << moveTime / iterations << " us" << std::endl;
+    std::cout << "    Refit:           " << refitTime / iterations << " us (" << (100.0 * static_cast<double>(stats.reinserts) / static_cast<double>(stats.moves)) << "% reinserted)" << std::endl;
+    std::cout << "    Frustum query:   " << frustumTime / iterations << " us (" << frustumResults / a_Iterations << " found, " << frustumVisited / a_Iterations << " nodes visited)" << std::endl;
+    std::cout << "    Brute force:     " << bruteForceTime / iterations << " us (" << bruteForceTime / frustumTime << "x)" << std::endl;
+    std::cout << "    Sphere query:    " << sphereTime / iterations << " us" << std::endl;
+    std::cout << "    Ray query:       " << rayTime / iterations << " us" << std::endl;
+
+    return valid;
+}
+
+bool BenchmarkJobScaling(std::uint32_t a_Count, std::uint32_t a_Iterations)
+{
+    using namespace blurp;
+
+    //The same grain as the loops in Game.
+    constexpr std::uint32_t grain = 256;
+    const float deltaTime = 1.f / 60.f;
+    const std::uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    //Entities are updated with a game, which the asteroids do not use. It is never initialized.
+    BlurpEngine engine;
+    Game game(engine);
+
+    MeshBounds meshBounds;
+    meshBounds.min = glm::vec3(-1.f);
+    meshBounds.max = glm::vec3(1.f);
+    meshBounds.radius = std::sqrt(3.f);
+
+    //Every amount of threads starts with the same asteroids, set up like in the game.
+    const auto createAsteroids = [&](std::vector<Asteroid>& a_Asteroids)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        a_Asteroids.assign(a_Count, Asteroid(0));
+        for(auto& asteroid : a_Asteroids)
+        {
+            const float angle = 2.f * 3.141592f * unit(random);
+            const float distance = 200.f + unit(random) * 1800.f;
+            asteroid.GetTransform().SetTranslation({ std::cos(angle) * distance, (unit(random) - 0.5f) * 200.f, std::sin(angle) * distance });
+            asteroid.GetTransform().Scale(unit(random) * 0.03f + 0.002f);
+            asteroid.SetRotation({ 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f }, { unit(random) * 0.1f, unit(random) * 0.1f, unit(random) * 0.1f });
+        }
+    };
+
+    //Powers of two, and every hardware thread.
+    std::vector<std::uint32_t> threadCounts;
+    for(std::uint32_t threads = 1; threads < maxThreads; threads *= 2)
+    {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    bool valid = true;
+    std::vector<glm::mat4> reference;
+    double singleTotal = 0.0;
+
+    std::cout << "Job scaling benchmark: " << a_Count << " asteroids, grain " << grain << "." << std::endl;
+
+    for(const std::uint32_t threads : threadCounts)
+    {
+        JobSystem jobs(threads - 1);
+
+        std::vector<Asteroid> asteroids;
+        createAsteroids(asteroids);
+        std::vector<MeshBounds> worldBounds(a_Count);
+        std::vector<glm::mat4> transforms(a_Count);
+
+        double updateTime = 0.0;
+        double boundsTime = 0.0;
+        double gatherTime = 0.0;
+
+        utilities::Timer timer;
+        for(std::uint32_t iteration = 0; iteration < a_Iterations; ++iteration)
+        {
+            //Game::UpdateGame.
+            timer.reset();
+            jobs.ParallelFor(a_Count, grain, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+            {
+                for(std::uint32_t i = a_Begin; i < a_End; ++i)
+                {
+                    asteroids[i].OnUpdate(deltaTime, game);
+                }
+            });
+            updateTime += timer.measure(utilities::TimeUnit::MICROS);
+
+            //Game::UpdateSceneIndex.
+            timer.reset();
+            jobs.ParallelFor(a_Count, grain, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+            {
+                for(std::uint32_t i = a_Begin; i < a_End; ++i)
+                {
+                    worldBounds[i] = TransformBounds(meshBounds, asteroids[i].GetTransform().GetTransformation());
+                }
+            });
+            boundsTime += timer.measure(utilities::TimeUnit::MICROS);
+
+            //Moving changes the transforms, which are then calculated again when gathered for rendering in Game::Render.
+            timer.reset();
+            jobs.ParallelFor(a_Count, grain, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+            {
+                for(std::uint32_t i = a_Begin; i < a_End; ++i)
+                {
+                    asteroids[i].GetTransform().Translate({ 0.f, deltaTime, 0.f });
+                    transforms[i] = asteroids[i].GetTransform().GetTransformation();
+                }
+            });
+            gatherTime += timer.measure(utilities::TimeUnit::MICROS);
+        }
+
+        //Every asteroid is processed the same way on any thread, so the transforms are exactly the same.
+        if(reference.empty())
+        {
+            reference = transforms;
+        }
+        else
+        {
+            valid = valid && std::memcmp(reference.data(), transforms.data(), sizeof(glm::mat4) * transforms.size()) == 0;
+        }
+
+        const double iterations = static_cast<double>(std::max(a_Iterations, 1u));
+        const double total = (updateTime + boundsTime + gatherTime) / iterations;
+        if(threads == 1)
+        {
+            singleTotal = total;
+        }
+
+        const auto stats = jobs.GetStats();
+        std::cout << "    " << threads << " threads: update " << updateTime / iterations << " us, bounds " << boundsTime / iterations << " us, gather " << gatherTime / iterations
+            << " us, total " << total << " us (" << singleTotal / total << "x, " << stats.stolen << " of " << stats.jobs << " jobs stolen)" << std::endl;
+    }
+
+    std::cout << "    Results " << (valid ? "match" : "DO NOT MATCH") << " for every amount of threads." << std::endl;
+
+    return valid;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cinttypes>
+
+/*
+ * Measure the cost of keeping a SceneBVH up to date with a_Count moving asteroids, and of querying it.
+ * Every iteration moves all asteroids, refits the BVH and runs a frustum, sphere and ray query.
+ * Frustum query results are compared against testing every asteroid, which is also timed.
+ * Returns false if the results differ. Results are printed to the console.
+ */
+bool BenchmarkSceneBVH(std::uint32_t a_Count, std::uint32_t a_Iterations);
+
+/*
+ * Measure how the loops of Game scale with the amount of threads of a blurp::JobSystem, from one thread up to every hardware thread.
+ * Every iteration updates a_Count rotating asteroids, calculates their world bounds for the scene index and gathers their transforms for rendering.
+ * The asteroids end up the same for every amount of threads. Returns false if they do not. Results are printed to the console.
+ */
+bool BenchmarkJobScaling(std::uint32_t a_Count, std::uint32_t a_Iterations);
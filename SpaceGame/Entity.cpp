@@ -1,11 +1,11 @@
 #include "Entity.h"
 
-Entity::Entity(const int a_MeshId) : m_MeshId(a_MeshId), m_Age(0), m_Direction({ 1.f, 0.f, 0.f }), m_Velocity(0.f), m_Acceleration(0.f), m_MarkedForDelete(false)
+Entity::Entity(const int a_MeshId) : m_MeshId(a_MeshId), m_SceneProxy(-1), m_Age(0), m_Direction({ 1.f, 0.f, 0.f }), m_Velocity(0.f), m_Acceleration(0.f), m_MarkedForDelete(false)
 {
 
 }
 
-Entity::Entity() : m_MeshId(-1), m_Age(0), m_Direction({ 1.f, 0.f, 0.f }), m_Velocity(0.f), m_Acceleration(0.f), m_MarkedForDelete(false)
+Entity::Entity() : m_MeshId(-1), m_SceneProxy(-1), m_Age(0), m_Direction({ 1.f, 0.f, 0.f }), m_Velocity(0.f), m_Acceleration(0.f), m_MarkedForDelete(false)
 {
 
 }
@@ -40,6 +40,16 @@ int Entity::GetMeshId() const
 	return m_MeshId;
 }
 
+int Entity::GetSceneProxy() const
+{
+	return m_SceneProxy;
+}
+
+void Entity::SetSceneProxy(int a_Proxy)
+{
+	m_SceneProxy = a_Proxy;
+}
+
 void SpaceShip::Update(float a_DeltaTime, Game& a_Game)
 {
 	//TODO be careful here, Disney owns star wars now so this might get me sued.
@@ -110,12 +120,16 @@ void Light::SetLight(std::shared_ptr<blurp::PointLight>& a_Light)
 	m_Light = a_Light;
 }
 
-std::shared_ptr<blurp::Light> Light::GetLight() const
+std::shared_ptr<blurp::PointLight> Light::GetLight() const
 {
 	return m_Light;
 }
 
 void Light::Update(float a_DeltaTime, Game& a_Game)
 {
-	//TODO lit
+	//The light follows the entity.
+	if(m_Light)
+	{
+		m_Light->SetPosition(m_Transform.GetTranslation());
+	}
 }
@@ -35,8 +35,15 @@ public:
 
 	int GetMeshId() const;
 
+	/*
+	 * The ID of this entity in the scene BVH, or -1 if it is not in the BVH.
+	 */
+	int GetSceneProxy() const;
+	void SetSceneProxy(int a_Proxy);
+
 	/*
 	 * Update this entity and increase age.
+	 * Entities are updated on multiple threads at the same time, so this may only change the entity itself.
 	 */
 	void OnUpdate(float a_DeltaTime, Game& a_Game)
 	{
@@ -66,6 +73,9 @@ protected:
 	//If not used, set to -1.
 	int m_MeshId;
 
+	//ID in the scene BVH. -1 if not registered.
+	int m_SceneProxy;
+
 	//Age of the entity 
 	int m_Age;
 
@@ -153,7 +163,7 @@ public:
 
 	void SetLight(std::shared_ptr<blurp::PointLight>& a_Light);
 
-	std::shared_ptr<blurp::Light> GetLight() const;
+	std::shared_ptr<blurp::PointLight> GetLight() const;
 
 protected:
 	void Update(float a_DeltaTime, Game& a_Game) override final;
@@ -6,9 +6,13 @@
 #include <RenderPipeline.h>
 #include <GpuBuffer.h>
 #include <MeshFile.h>
+#include <Culling.h>
+#include <JobSystem.h>
+#include <Profiler.h>
 
 #include "CubeMapLoader.h"
 #include "MeshLoader.h"
+#include <algorithm>
 #include <iostream>
 
 #define SHADOW_MAP_DIMENSION 2048
@@ -16,6 +20,11 @@
 #define FAR_PLANE 4000.f
 #define NEAR_PLANE 0.1f
 #define NUM_POINT_LIGHT_SHADOWS 2
+#define NUM_POINT_LIGHTS 64
+#define SHADER_MANIFEST_PATH "../Output/shadermanifest.txt"
+#define SHADER_WARM_UP_BUDGET 4.f
+#define ENTITY_JOB_GRAIN 256
+#define PROFILER_TRACE_PATH "../Output/trace.json"
 
 
 #define RAND_FLOAT() (static_cast<float>(rand()) / static_cast<float>(RAND_MAX))
@@ -108,17 +117,7 @@ void Game::Init()
         }
     }
 
-    //Clear the dir shadow buffer.
-    ClearData dirClear;
-    dirClear.size = glm::vec3(SHADOW_MAP_DIMENSION, SHADOW_MAP_DIMENSION, NUM_CASCADES * 1);
-    dirClear.clearValue.floats[0] = 1.f;
-    m_ClearPass->AddTexture(m_DirShadowArray, dirClear);
-
-    //Clear the shadow textures every frame.
-    ClearData posShadowClear;
-    posShadowClear.size = glm::vec3(SHADOW_MAP_DIMENSION, SHADOW_MAP_DIMENSION, NUM_POINT_LIGHT_SHADOWS * 6);
-    posShadowClear.clearValue.floats[0] = 1.f;
-    m_ClearPass->AddTexture(m_PosShadowArray, posShadowClear);
+    //The directional and positional shadow maps are only cleared where the shadow cache redraws them, which is decided every frame.
 
     //Load a skybox;
     m_SkyBoxTexture = LoadCubeMap(m_Engine.GetResourceManager(), CubeMapSettings{
@@ -158,10 +157,13 @@ void Game::Init()
     });
 
     //Create the GPU buffer used to put dynamic data in.
+    //The data is rewritten every frame, so use a persistently mapped ring buffer shared by 3 frames.
     GpuBufferSettings gpuBufferSettings;
-    gpuBufferSettings.size = std::pow(2, 15);
+    gpuBufferSettings.size = std::pow(2, 20);
     gpuBufferSettings.resizeWhenFull = true;
     gpuBufferSettings.memoryUsage = MemoryUsage::CPU_W;
+    gpuBufferSettings.persistentRingBuffer = true;
+    gpuBufferSettings.ringBufferFrames = 3;
     m_GpuBuffer = m_Engine.GetResourceManager().CreateGpuBuffer(gpuBufferSettings);
 
     //Set up shadow map generation for the render passes using the now existing data buffers.
@@ -184,6 +186,43 @@ void Game::Init()
     m_ShadowGenerationPass->SetOutput(shadowData);
     m_ForwardPass->SetShadowData(shadowData);
 
+    //The shadow caster culler needs the same camera and cascades as the shadow pass.
+    m_ShadowCuller.SetCamera(m_Camera);
+    m_ShadowCuller.SetShadowData(shadowData);
+
+    //Only the most important point lights each frame get one of the positional shadow maps.
+    ShadowSchedulerSettings schedulerSettings;
+    schedulerSettings.slots = NUM_POINT_LIGHT_SHADOWS;
+    m_ShadowScheduler.SetSettings(schedulerSettings);
+
+    //Casters outside the range of a light are culled with the same cutoff that the scheduler ranks the lights with.
+    m_ShadowCuller.SetLightCutoff(schedulerSettings.lightCutoff);
+
+    //Keep the shadows of point lights that nothing moved around. Every caster in the game moves, so there are no static layers.
+    PositionalShadowCacheSettings cacheSettings;
+    cacheSettings.slots = NUM_POINT_LIGHT_SHADOWS;
+    m_PosShadowCache = std::make_shared<PositionalShadowCache>();
+    m_PosShadowCache->SetSettings(cacheSettings);
+    m_ShadowGenerationPass->SetShadowCache(m_PosShadowCache);
+
+    //The far cascades of the sun cover a lot of space and barely change, so they are only drawn every few frames or when the camera moved enough.
+    CascadeSchedulerSettings cascadeSettings;
+    cascadeSettings.intervals = { 1, 1, 2, 4, 8, 8 };
+    cascadeSettings.texelThreshold = 1.f;
+    cascadeSettings.resolution = SHADOW_MAP_DIMENSION;
+    m_CascadeScheduler = std::make_shared<CascadeScheduler>();
+    m_CascadeScheduler->SetSettings(cascadeSettings);
+    m_ShadowGenerationPass->SetCascadeScheduler(m_CascadeScheduler);
+
+    //Compile the shaders used in earlier runs a few milliseconds per frame, so that drawing does not have to wait for them.
+    m_ShaderManifest = std::make_shared<ShaderManifest>();
+    if(m_ShaderManifest->Load(SHADER_MANIFEST_PATH))
+    {
+        std::cout << "Loaded " << m_ShaderManifest->GetEntryCount() << " shader variants from the manifest." << std::endl;
+    }
+    m_ForwardPass->SetShaderManifest(m_ShaderManifest, SHADER_WARM_UP_BUDGET);
+    m_ShadowGenerationPass->SetShaderManifest(m_ShaderManifest, SHADER_WARM_UP_BUDGET);
+
 
     /*
      * GAMEPLAY OBJECTS
@@ -271,14 +310,34 @@ void Game::Init()
         asteroid->GetTransform().SetTranslation({ x, y, z });
     }
 
+    //Add point lights scattered through the asteroid belt.
+    LightSettings pointSettings;
+    pointSettings.type = LightType::LIGHT_POINT;
 
+    for (int i = 0; i < NUM_POINT_LIGHTS; ++i)
+    {
+        pointSettings.color = { 1.f, 0.5f + RAND_FLOAT() * 0.5f, RAND_FLOAT() * 0.5f };
+        pointSettings.intensity = 20.f + RAND_FLOAT() * 80.f;
+        auto pointLight = std::reinterpret_pointer_cast<PointLight>(m_Engine.GetResourceManager().CreateLight(pointSettings));
 
+        const float angle = 2.f * 3.141592f * RAND_FLOAT();
+        const float distance = (RAND_FLOAT() * (MAX_ASTEROID_DISTANCE - MIN_ASTEROID_DISTANCE)) + MIN_ASTEROID_DISTANCE;
+        const float y = (RAND_FLOAT() * 2.f * MAX_ASTEROID_HEIGHT_OFFSET) - MAX_ASTEROID_HEIGHT_OFFSET;
 
-    //Generate a vector for each mesh to store transforms in. These are cleared after each draw call but will prevent a lot of memory allocating.
-    for (int i = 0; i < m_Meshes.size(); ++i)
-    {
-        m_Transforms.emplace_back();
+        ::Light* light = static_cast<::Light*>(CreateEntity(EntityType::LIGHT, -1));
+        light->GetTransform().SetTranslation({ cos(angle) * distance, y, sin(angle) * distance });
+        light->SetLight(pointLight);
+        pointLight->SetPosition(light->GetTransform().GetTranslation());
     }
+
+
+
+
+    //One counter per mesh, plus one for the total, used to group the entities found by the scene query per mesh.
+    m_MeshOffsets.resize(m_Meshes.size() + 1);
+
+    //Add all entities to the scene index so that they can be found when rendering.
+    UpdateSceneIndex(0.f);
 }
 
 void Game::UpdateInput(std::shared_ptr<blurp::Window>& a_Window)
@@ -391,6 +450,8 @@ void Game::UpdateInput(std::shared_ptr<blurp::Window>& a_Window)
 
 void Game::UpdateGame(float a_DeltaTime)
 {
+    BLURP_PROFILE_SCOPE(m_Engine.GetProfiler(), "Game::UpdateGame");
+
     /*
      * Remove dead entities. This frees them in their memory pool.
      */
@@ -399,6 +460,10 @@ void Game::UpdateGame(float a_DeltaTime)
     {
         if (itr->first->MarkedForDelete())
         {
+            if(itr->first->GetSceneProxy() != -1)
+            {
+                m_SceneIndex.Remove(itr->first->GetSceneProxy());
+            }
             itr->second->free(itr->first);
             itr = m_Entities.erase(itr);
         }else
@@ -408,19 +473,86 @@ void Game::UpdateGame(float a_DeltaTime)
     }
 
     /*
-     * Update every entity.
+     * Update every entity. Entities only change themselves, so they are updated on multiple threads.
      */
-    for(auto& entity : m_Entities)
+    m_Engine.GetJobSystem().ParallelFor(static_cast<std::uint32_t>(m_Entities.size()), ENTITY_JOB_GRAIN, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+    {
+        for(std::uint32_t i = a_Begin; i < a_End; ++i)
+        {
+            m_Entities[i].first->OnUpdate(a_DeltaTime, *this);
+        }
+    });
+
+    /*
+     * Move the entities in the scene index to their new position.
+     */
+    UpdateSceneIndex(a_DeltaTime);
+}
+
+const SceneBVH& Game::GetSceneIndex() const
+{
+    return m_SceneIndex;
+}
+
+void Game::UpdateSceneIndex(float a_DeltaTime)
+{
+    BLURP_PROFILE_SCOPE(m_Engine.GetProfiler(), "Game::UpdateSceneIndex");
+
+    //Only entities that are new or whose transform changed need new bounds. Static entities keep their place in the index.
+    const auto needsUpdate = [](Entity* a_Entity)
+    {
+        return a_Entity->GetMeshId() != -1 && (a_Entity->GetSceneProxy() == -1 || a_Entity->GetTransform().HasChanged());
+    };
+
+    //The bounds are calculated on multiple threads. Only changing the index itself has to happen on one thread.
+    m_EntityBounds.resize(m_Entities.size());
+    m_Engine.GetJobSystem().ParallelFor(static_cast<std::uint32_t>(m_Entities.size()), ENTITY_JOB_GRAIN, [&](std::uint32_t a_Begin, std::uint32_t a_End)
     {
-        entity.first->OnUpdate(a_DeltaTime, *this);
+        for(std::uint32_t i = a_Begin; i < a_End; ++i)
+        {
+            Entity* ptr = m_Entities[i].first;
+            if(needsUpdate(ptr))
+            {
+                m_EntityBounds[i] = blurp::TransformBounds(m_Meshes[ptr->GetMeshId()].GetBounds(), ptr->GetTransform().GetTransformation());
+            }
+        }
+    });
+
+    for(std::size_t i = 0; i < m_Entities.size(); ++i)
+    {
+        Entity* ptr = m_Entities[i].first;
+        if(!needsUpdate(ptr))
+        {
+            continue;
+        }
+
+        const auto& bounds = m_EntityBounds[i];
+
+        if(ptr->GetSceneProxy() == -1)
+        {
+            ptr->SetSceneProxy(m_SceneIndex.Insert(ptr, bounds));
+        }
+        else
+        {
+            //The velocity predicts where the entity goes next, so that the bounds in the index stay valid for longer.
+            m_SceneIndex.Move(ptr->GetSceneProxy(), bounds, ptr->GetVelocity() * a_DeltaTime);
+        }
+
+        ptr->GetTransform().ClearChanged();
     }
 }
 
 void Game::Render()
 {
+    BLURP_PROFILE_SCOPE(m_Engine.GetProfiler(), "Game::Render");
+
     //Reset the passes.
     m_ForwardPass->Reset();
     m_ShadowGenerationPass->Reset();
+    m_ShadowCuller.Reset();
+
+    //Move the ring buffer on to a region that the GPU is no longer reading from.
+    m_GpuBuffer->BeginFrame();
 
     /*
      * An incrementing value indicating the offset into the GPU Buffer.
@@ -431,114 +563,210 @@ void Game::Render()
      * Allocate memory to store the draw calls, and then iterate over the entities in the scene to find their transforms per mesh.
      */
     std::vector<blurp::DrawData> drawDatasShadow;
+    std::vector<blurp::LightIndexData> lIndexData;
     std::vector<blurp::DrawData> drawDatas;
     std::vector<blurp::DrawData> drawDatasTransparent;
 
-    //Clear previous frames transforms.
-    for(int i = 0; i < m_Meshes.size(); ++i)
+    //Only instances inside the camera frustum are drawn by the forward pass.
+    const auto frustum = m_Camera->GetFrustum();
+
+    //Gather the point lights of all light entities.
+    m_PointLights.clear();
+    for(auto& entity : m_Entities)
     {
-        m_Transforms[i].clear();
+        if(entity.second == &m_Lights)
+        {
+            m_PointLights.push_back(static_cast<Light*>(entity.first)->GetLight());
+        }
     }
 
-    //TODO use a data structure like an octree to reduce this costly loop.
-    for(auto& entity : m_Entities)
+    blurp::LightData lData;
+    lData.ambient = { 0.001f, 0.001f, 0.001f };
+    blurp::LightUploadData lud;
+    lud.lightData = &lData;
+    lud.point.count = static_cast<std::uint32_t>(m_PointLights.size());
+    lud.point.lights = m_PointLights.empty() ? nullptr : &m_PointLights[0];
+    lud.directional.lights = &m_Sun;
+    lud.directional.count = 1;
+
+    //Give the shadow maps to the point lights that matter most this frame. The others are drawn without shadows.
+    m_ShadowScheduler.Schedule(*m_Camera, lud);
+
+    //Setup the shadow mapping for this frame. The lights are added to the culler in the same order, so that the light indices match.
+    for(std::uint32_t slot = 0; slot < m_ShadowScheduler.GetSlots().size(); ++slot)
     {
-        const int id = entity.first->GetMeshId();
-        if(id != -1)
+        const auto& light = m_ShadowScheduler.GetSlots()[slot];
+        if(light != nullptr)
         {
-            m_Transforms[id].emplace_back(entity.first->GetTransform().GetTransformation());
+            m_ShadowGenerationPass->AddLight(light, slot);
+            m_ShadowCuller.AddLight(light);
         }
     }
 
+    m_ShadowGenerationPass->AddLight(m_Sun, 0);
+    m_ShadowCuller.AddLight(m_Sun);
+
+    //Shadow casters outside of the view can still cast into it, so the scene is queried with the view stretched along the sun direction.
+    //Point lights cast shadows in every direction, so everything within the range of a shadowed point light is found as well.
+    //Everything else is skipped without being looked at.
+    m_QueryResults.clear();
+    m_SceneIndex.QueryFrustum(blurp::ExtrudeFrustum(frustum, m_Sun->GetDirection()), m_QueryResults);
+
+    std::uint32_t positionalLight = 0;
+    for(const auto& light : m_ShadowScheduler.GetSlots())
+    {
+        if(light != nullptr)
+        {
+            m_SceneIndex.QuerySphere(std::static_pointer_cast<blurp::PointLight>(light)->GetPosition(), m_ShadowCuller.GetLightRange(positionalLight++), m_QueryResults);
+        }
+    }
+
+    //Entities found by more than one query are only drawn once.
+    if(positionalLight > 0)
+    {
+        std::sort(m_QueryResults.begin(), m_QueryResults.end());
+        m_QueryResults.erase(std::unique(m_QueryResults.begin(), m_QueryResults.end()), m_QueryResults.end());
+    }
+
+    //Group the entities per mesh. Every mesh starts where the previous one ends.
+    //After placing the entities, m_MeshOffsets[i] holds the end of mesh i.
+    std::fill(m_MeshOffsets.begin(), m_MeshOffsets.end(), 0u);
+    for(auto* entity : m_QueryResults)
+    {
+        ++m_MeshOffsets[entity->GetMeshId() + 1];
+    }
+    for(std::size_t i = 1; i < m_MeshOffsets.size(); ++i)
+    {
+        m_MeshOffsets[i] += m_MeshOffsets[i - 1];
+    }
+    m_MeshEntities.resize(m_QueryResults.size());
+    for(auto* entity : m_QueryResults)
+    {
+        m_MeshEntities[m_MeshOffsets[entity->GetMeshId()]++] = entity;
+    }
+
+    //Transforms are calculated on multiple threads, straight into their place behind the other instances of their mesh.
+    m_QueryTransforms.resize(m_MeshEntities.size());
+    m_Engine.GetJobSystem().ParallelFor(static_cast<std::uint32_t>(m_MeshEntities.size()), ENTITY_JOB_GRAIN, [&](std::uint32_t a_Begin, std::uint32_t a_End)
+    {
+        for(std::uint32_t i = a_Begin; i < a_End; ++i)
+        {
+            m_QueryTransforms[i] = m_MeshEntities[i]->GetTransform().GetTransformation();
+        }
+    });
+
+    //Only clear the cascades that are drawn this frame. The others keep their depth.
+    m_ShadowGenerationPass->UpdateCascadeScheduler();
+
+    blurp::ClearData dirClear;
+    dirClear.size = glm::vec3(SHADOW_MAP_DIMENSION, SHADOW_MAP_DIMENSION, 0);
+    dirClear.clearValue.floats[0] = 1.f;
+    m_DirShadowClears.clear();
+    m_CascadeScheduler->GetClearRegions(dirClear, m_DirShadowClears);
+
+    m_ClearPass->RemoveTexture(m_DirShadowArray);
+    for(auto& region : m_DirShadowClears)
+    {
+        m_ClearPass->AddTexture(m_DirShadowArray, region);
+    }
+
     //TODO sort transforms from front to back. How does this work with transparency because it's the other way around. Upload once to GPU then read backwards? Maybe add a setting to the renderer to flip reading direction?
 
-    //Upload transforms to the GPU and link them to the draw call.
+    //Cull the transforms straight into the GPU buffer and link them to the draw call.
+    std::uint32_t meshStart = 0;
     for(int i = 0; i < m_Meshes.size(); ++ i)
     {
-        auto& matvec = m_Transforms[i];
-        if(!matvec.empty())
+        const glm::mat4* transforms = m_QueryTransforms.data() + meshStart;
+        const auto totalCount = m_MeshOffsets[i] - meshStart;
+        meshStart = m_MeshOffsets[i];
+
+        if(totalCount > 0)
         {
-            auto view = m_GpuBuffer->WriteData<glm::mat4>(gpuBufferOffset, matvec.size(), 16, &matvec[0]);
-            gpuBufferOffset = view.end;
+            const bool shadows = m_Meshes[i].GeneratesShadow();
 
-            //Opaque draw calls.
-            for(auto& data : m_Meshes[i].GetDrawDatas())
-            {
-                auto& inserted = drawDatas.emplace_back(data);
-                inserted.instanceCount = matvec.size();
-                inserted.transformData.dataRange = view;
-                inserted.transformData.dataBuffer = m_GpuBuffer;
-            }
+            auto writer = m_GpuBuffer->BeginWrite<glm::mat4>(gpuBufferOffset, totalCount, 16);
+            const auto instanceCount = blurp::CullInstances(frustum, m_Meshes[i].GetBounds(), transforms, totalCount, &writer[0]);
+            m_GpuBuffer->EndWrite();
 
-            //Transparent draw calls (happen last).
-            for (auto& data : m_Meshes[i].GetTransparentDrawDatas())
-            {
-                auto& inserted = drawDatasTransparent.emplace_back(data);
-                inserted.instanceCount = matvec.size();
-                inserted.transformData.dataRange = view;
-                inserted.transformData.dataBuffer = m_GpuBuffer;
-            }
+            const auto allView = writer.GetView();
+            gpuBufferOffset = allView.end;
 
-            if(m_Meshes[i].GeneratesShadow())
+            if(instanceCount > 0)
             {
-                for (auto& data : m_Meshes[i].GetDrawDatas())
+                const auto view = allView.CreateSubView(0, instanceCount - 1);
+
+                //Opaque draw calls.
+                for(auto& data : m_Meshes[i].GetDrawDatas())
+                {
+                    auto& inserted = drawDatas.emplace_back(data);
+                    inserted.instanceCount = instanceCount;
+                    inserted.transformData.dataRange = view;
+                    inserted.transformData.dataBuffer = m_GpuBuffer;
+                }
+
+                //Transparent draw calls (happen last).
+                for (auto& data : m_Meshes[i].GetTransparentDrawDatas())
                 {
-                    auto& inserted = drawDatasShadow.emplace_back(data);
-                    inserted.instanceCount = matvec.size();
+                    auto& inserted = drawDatasTransparent.emplace_back(data);
+                    inserted.instanceCount = instanceCount;
                     inserted.transformData.dataRange = view;
                     inserted.transformData.dataBuffer = m_GpuBuffer;
                 }
             }
+
+            //Every shadow cascade and light only gets the instances inside of its volume.
+            //Instances outside of the view can still cast a shadow into it, so the culling starts again from every instance found by the query.
+            if(shadows)
+            {
+                for(auto* casters : m_ShadowCuller.Cull(m_Meshes[i].GetBounds(), transforms, totalCount))
+                {
+                    const auto casterCount = static_cast<std::uint32_t>(casters->transforms.size());
+                    auto casterWriter = m_GpuBuffer->BeginWrite<glm::mat4>(gpuBufferOffset, casterCount, 16);
+                    for(std::uint32_t caster = 0; caster < casterCount; ++caster)
+                    {
+                        casterWriter[caster] = casters->transforms[caster];
+                    }
+                    m_GpuBuffer->EndWrite();
+
+                    const auto casterView = casterWriter.GetView();
+                    gpuBufferOffset = casterView.end;
+
+                    for (auto& data : m_Meshes[i].GetDrawDatas())
+                    {
+                        auto& inserted = drawDatasShadow.emplace_back(data);
+                        inserted.instanceCount = casterCount;
+                        inserted.transformData.dataRange = casterView;
+                        inserted.transformData.dataBuffer = m_GpuBuffer;
+                        lIndexData.emplace_back(casters->lights);
+                    }
+                }
+            }
         }
     }
 
     //Append transparent draw calls to solid ones.
     drawDatas.insert(drawDatas.end(), drawDatasTransparent.begin(), drawDatasTransparent.end());
 
-    //Tell the shadow pass to use all geometry as shadow casters.
-    //This looks complex, but all it does is specify an array of lights indexes for every DrawData object.
-    //When drawing that geometry, all lights specified will be considered for shadow generation.
-    
-    //Every light affects every geometry, so make a collection of each index.
-    std::vector<int> dirLightShadowIndices;
-    std::vector<int> posLightShadowIndices;
-
-    //Setup the shadow mapping for this frame. Exclude the last Drawdata which is the light mesh.
-    //TODO find the lights to use for shadows! Closest to camera probably.
-    //for (int i = 0; i < m_Lights.size(); ++i)
-    //{
-    //    m_ShadowGenerationPass->AddLight(m_Lights[i], i);
-    //    posLightShadowIndices.push_back(i);
-    //}
+    //Tell the shadow pass which lights and cascades each piece of geometry casts a shadow for.
+    //Only solid geometry casts shadows for now.
+    m_ShadowGenerationPass->SetGeometry(drawDatasShadow.data(), lIndexData.data(), static_cast<std::uint32_t>(drawDatasShadow.size()));
 
-    m_ShadowGenerationPass->AddLight(m_Sun, 0);
-    dirLightShadowIndices.push_back(0);
+    //Find the faces of the positional shadow maps that have to be drawn again, and only clear those.
+    m_ShadowGenerationPass->UpdateShadowCache();
 
-    //TODO set up which objects cast shadows for each shadow casting light.
-    //TODO This means building a new drawable set.
-    //
-    //Only take solid geometry for shadows for now.
-    std::vector<blurp::LightIndexData> lIndexData;
-    lIndexData.reserve(drawDatasShadow.size());
+    blurp::ClearData posShadowClear;
+    posShadowClear.size = glm::vec3(SHADOW_MAP_DIMENSION, SHADOW_MAP_DIMENSION, 0);
+    posShadowClear.clearValue.floats[0] = 1.f;
+    m_PosShadowClears.clear();
+    m_PosShadowCache->GetClearRegions(false, posShadowClear, m_PosShadowClears);
 
-    for (int i = 0; i < static_cast<int>(drawDatasShadow.size()); ++i)
+    m_ClearPass->RemoveTexture(m_PosShadowArray);
+    for(auto& region : m_PosShadowClears)
     {
-        //0 and 0 indicates that each piece of geometry is affected by the dir light at index 0, and the pos light at index 0.
-        lIndexData.emplace_back(blurp::LightIndexData{ dirLightShadowIndices, posLightShadowIndices });
+        m_ClearPass->AddTexture(m_PosShadowArray, region);
     }
 
-    m_ShadowGenerationPass->SetGeometry(&drawDatasShadow[0], &lIndexData[0], drawDatasShadow.size());
-
-    //TODO find lights to use (also non-shadow).
     //Upload light data
-    blurp::LightData lData;
-    lData.ambient = { 0.001f, 0.001f, 0.001f };
-    blurp::LightUploadData lud;
-    lud.lightData = &lData;
-    //lud.point.count = 0;
-    //lud.point.lights = &m_Lights[0];
-    lud.directional.lights = &m_Sun;
-    lud.directional.count = 1;
     auto lightView = m_GpuBuffer->WriteData(gpuBufferOffset, lud);
     gpuBufferOffset = lightView.end;
 
@@ -565,4 +793,22 @@ void Game::Render()
             break;
         }
     }
+
+    m_ShaderManifest->NextFrame();
+}
+
+void Game::Shutdown()
+{
+    if(!m_ShaderManifest->Save(SHADER_MANIFEST_PATH))
+    {
+        std::cout << "Could not save the shader manifest." << std::endl;
+    }
+
+#ifdef BLURP_PROFILING
+    //The last frames can be inspected by loading the trace in chrome://tracing or Perfetto.
+    if(!m_Engine.GetProfiler().ExportChromeTrace(PROFILER_TRACE_PATH))
+    {
+        std::cout << "Could not export the profiler trace." << std::endl;
+    }
+#endif
 }
\ No newline at end of file
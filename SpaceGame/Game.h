@@ -5,10 +5,16 @@
 #include <RenderPass_Forward.h>
 #include <RenderPass_Skybox.h>
 #include <RenderPass_ShadowMap.h>
+#include <PositionalShadowCache.h>
+#include <CascadeScheduler.h>
+#include <ShadowCasterCuller.h>
+#include <ShadowLightScheduler.h>
+#include <ShaderManifest.h>
 #include "MeshLoader.h"
 #include "Mesh.h"
 #include "Entity.h"
 #include "MemoryPool.h"
+#include "SceneBVH.h"
 
 /*
  * This is a game! Games are fun! 
@@ -39,6 +45,11 @@ public:
      */
     void Render();
 
+    /*
+     * Save everything that is kept for the next run.
+     */
+    void Shutdown();
+
     /*
      * Create an entity.
      */
@@ -87,6 +98,18 @@ public:
         return nullptr;
     }
 
+    /*
+     * Get the spatial index containing every entity with a mesh.
+     * Use this to find entities in an area instead of visiting all of them.
+     */
+    const SceneBVH& GetSceneIndex() const;
+
+private:
+    /*
+     * Register new entities with the scene index, and update the bounds of the ones that are already in it.
+     */
+    void UpdateSceneIndex(float a_DeltaTime);
+
 public:
     /*
      * GLOBAL
@@ -102,7 +125,6 @@ private:
      */
      //All meshes used by the game.
     std::vector<Mesh> m_Meshes;
-    std::vector<std::vector<glm::mat4>> m_Transforms;   //Vector used to store selected transforms per draw call.
 
     //Memory pools for each object type.
     utilities::TypelessPool m_SpaceShips;
@@ -115,6 +137,14 @@ private:
     //All entities as pointers and their respective pool.
     std::vector<std::pair<Entity*, utilities::TypelessPool*>> m_Entities;
 
+    //Bounding volume hierarchy over all entities with a mesh.
+    SceneBVH m_SceneIndex;
+    std::vector<Entity*> m_QueryResults;    //Vector used to store the entities found by scene queries.
+    std::vector<Entity*> m_MeshEntities;        //The entities in m_QueryResults grouped per mesh.
+    std::vector<std::uint32_t> m_MeshOffsets;   //The end of every mesh in m_MeshEntities.
+    std::vector<glm::mat4> m_QueryTransforms;   //The transform of every entity in m_MeshEntities, calculated on multiple threads. These are culled straight into the GPU buffer.
+    std::vector<blurp::MeshBounds> m_EntityBounds;  //The world bounds of every entity in m_Entities, calculated on multiple threads.
+
     /*
      * RENDERING RELATED
      */
@@ -123,8 +153,14 @@ private:
     std::shared_ptr<blurp::RenderPass_Clear> m_ClearPass;
     std::shared_ptr<blurp::RenderPass_Skybox> m_SkyboxPass;
     std::shared_ptr<blurp::RenderPass_ShadowMap> m_ShadowGenerationPass;
+    blurp::ShadowCasterCuller m_ShadowCuller;
     std::shared_ptr<blurp::Texture> m_PosShadowArray;
+    std::shared_ptr<blurp::PositionalShadowCache> m_PosShadowCache;    //Decides which faces of the positional shadow maps are drawn and cleared each frame.
+    std::vector<blurp::ClearData> m_PosShadowClears;                    //Regions of the positional shadow maps that are cleared this frame.
     std::shared_ptr<blurp::Texture> m_DirShadowArray;
+    std::shared_ptr<blurp::CascadeScheduler> m_CascadeScheduler;        //Decides which cascades of the sun shadow are drawn and cleared each frame.
+    std::vector<blurp::ClearData> m_DirShadowClears;                    //Regions of the directional shadow maps that are cleared this frame.
+    std::shared_ptr<blurp::ShaderManifest> m_ShaderManifest;            //Shader variants used by the passes. Compiled at startup in the next run.
     std::shared_ptr<blurp::GpuBufferView> m_DirLightMatView;
     std::shared_ptr<blurp::GpuBufferView> m_DirLightDataOffsetView;
     std::shared_ptr<blurp::Texture> m_SkyBoxTexture;
@@ -132,6 +168,8 @@ private:
 
     //Lights
     std::shared_ptr<blurp::DirectionalLight> m_Sun;
+    std::vector<std::shared_ptr<blurp::PointLight>> m_PointLights;     //Point lights of all light entities, gathered every frame.
+    blurp::ShadowLightScheduler m_ShadowScheduler;                      //Picks the point lights that get one of the positional shadow maps.
 
     //Scene data and buffers
     std::shared_ptr<blurp::GpuBuffer> m_GpuBuffer;
@@ -3,8 +3,10 @@
 #include <glm/glm.hpp>
 #include <Window.h>
 #include <RenderResourceManager.h>
+#include <Profiler.h>
 #include "Game.h"
 #include "GameLoop.h"
+#include "Benchmarks.h"
 
 #include <iostream>
 
@@ -16,10 +18,20 @@ int main()
 
     std::cout << "Starting application" << std::endl;
 
+    //Benchmarks do not need a window, so they run before anything is set up.
+    constexpr bool runBenchmarks = false;
+
+    if(runBenchmarks)
+    {
+        BenchmarkSceneBVH(100000, 100);
+        BenchmarkJobScaling(100000, 100);
+    }
+
     BlurpEngine engine;
     BlurpSettings blurpSettings;
     blurpSettings.graphicsAPI = GraphicsAPI::OPENGL;
     blurpSettings.shadersPath = "../Output/shaders/";
+    blurpSettings.shaderBinaryCachePath = "../Output/shadercache/";
 
     WindowSettings windowSettings;
     windowSettings.dimensions = glm::vec2{ 800, 800 };
@@ -69,6 +81,9 @@ int main()
 
             //Finally display on the screen.
             window->Present();
+
+            //Markers recorded from here on belong to the next frame.
+            engine.GetProfiler().NextFrame();
         }
 
          if(data.currentTick % 20 == 0)
@@ -85,5 +100,6 @@ int main()
     }
 
     std::cout << "Closing down." << std::endl;
+    game.Shutdown();
     return 0;
 }
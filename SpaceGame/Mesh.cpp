@@ -1,5 +1,7 @@
 #include "Mesh.h"
 #include "MeshLoader.h"
+#include <Mesh.h>    //The engine mesh, found through the include directories. The game mesh header has the same name.
+#include <Culling.h>
 
 Mesh::Mesh() : m_GenerateShadow(false)
 {
@@ -15,6 +17,19 @@ bool Mesh::Load(const std::string& a_Path, const std::string& a_FileName, blurp:
 	settings.numVertexInstances = 0;
 	m_Scene = LoadMesh(settings, a_ResourceManager, true, false, false);
 	m_GenerateShadow = a_GenerateShadow;
+
+	//Combine the bounds of all primitives so that instances can be culled as a whole.
+	bool first = true;
+	for(auto* drawDatas : { &m_Scene.drawDatas, &m_Scene.transparentDrawDatas })
+	{
+		for(auto& drawData : *drawDatas)
+		{
+			const auto& bounds = drawData.mesh->GetBounds();
+			m_Bounds = first ? bounds : blurp::CombineBounds(m_Bounds, bounds);
+			first = false;
+		}
+	}
+
 	return true;
 }
 
@@ -32,3 +47,8 @@ std::vector<blurp::DrawData>& Mesh::GetTransparentDrawDatas()
 {
 	return m_Scene.transparentDrawDatas;
 }
+
+const blurp::MeshBounds& Mesh::GetBounds() const
+{
+	return m_Bounds;
+}
@@ -19,7 +19,13 @@ public:
     std::vector<blurp::DrawData>& GetDrawDatas();
     std::vector<blurp::DrawData>& GetTransparentDrawDatas();
 
+    /*
+     * Get the bounds enclosing every primitive of this mesh.
+     */
+    const blurp::MeshBounds& GetBounds() const;
+
 private:
     GLTFScene m_Scene;
     bool m_GenerateShadow;
+    blurp::MeshBounds m_Bounds;
 };
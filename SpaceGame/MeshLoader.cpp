@@ -759,20 +759,19 @@ GLTFScene LoadMesh(const MeshLoaderSettings& a_Settings, blurp::RenderResourceMa
                 }
             }
 
-            blurp::PipelineState pState = blurp::PipelineState::Compile(blending, topology, culling, winding, depthData);
+            //Primitives with the same state share one interned pipeline state.
+            drawData.pipelineState = &blurp::PipelineState::Intern(blending, topology, culling, winding, depthData);
 
             //Add data to the right set.
             if(blending.blend)
             {
                 output.transparentDrawDatas.push_back(drawData);
                 transparenDrawableIds.push_back(output.transparentDrawDatas.size() - 1);
-                output.transparentPipelineStates.push_back(pState);
             }
             else
             {
                 output.drawDatas.push_back(drawData);
                 drawableIds.push_back(output.drawDatas.size() - 1);
-                output.pipelineStates.push_back(pState);
             }
 
             std::cout << "Mesh loaded with ID: " << meshId << std::endl;
@@ -799,16 +798,6 @@ GLTFScene LoadMesh(const MeshLoaderSettings& a_Settings, blurp::RenderResourceMa
         }
     }
 
-    //Link the correct pipeline state to each draw data object (because resizing that vector causes the memory addresses to change).
-    for(int i = 0; i < output.drawDatas.size(); ++i)
-    {
-        output.drawDatas[i].pipelineState = &output.pipelineStates[i];
-    }
-    for(int i = 0; i < output.transparentDrawDatas.size(); ++i)
-    {
-        output.transparentDrawDatas[i].pipelineState = &output.transparentPipelineStates[i];
-    }
-
     return output;
 }
 
@@ -27,8 +27,6 @@ struct GLTFScene
 {
     std::vector<blurp::DrawData> drawDatas;
     std::vector<blurp::DrawData> transparentDrawDatas;
-    std::vector<blurp::PipelineState> transparentPipelineStates;
-    std::vector<blurp::PipelineState> pipelineStates;
     std::vector<GLTFMesh> meshes;
 };
 
@@ -0,0 +1,567 @@
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    AABB Combine(const AABB& a_First, const AABB& a_Second)
+    {
+        return AABB{ glm::min(a_First.min, a_Second.min), glm::max(a_First.max, a_Second.max) };
+    }
+
+    bool Contains(const AABB& a_Outer, const AABB& a_Inner)
+    {
+        return glm::all(glm::lessThanEqual(a_Outer.min, a_Inner.min)) && glm::all(glm::greaterThanEqual(a_Outer.max, a_Inner.max));
+    }
+
+    //Half of the surface area, which is enough to compare costs.
+    float SurfaceArea(const AABB& a_Box)
+    {
+        const glm::vec3 size = a_Box.max - a_Box.min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    //Enlarge a box by a margin on every side, and stretch it in the direction of movement.
+    AABB Enlarge(const AABB& a_Box, float a_Margin, const glm::vec3& a_Displacement)
+    {
+        AABB box{ a_Box.min - glm::vec3(a_Margin), a_Box.max + glm::vec3(a_Margin) };
+        box.min += glm::min(a_Displacement, glm::vec3(0.f));
+        box.max += glm::max(a_Displacement, glm::vec3(0.f));
+        return box;
+    }
+
+    bool OverlapsSphere(const AABB& a_Box, const glm::vec3& a_Center, float a_Radius)
+    {
+        const glm::vec3 closest = glm::clamp(a_Center, a_Box.min, a_Box.max);
+        const glm::vec3 offset = closest - a_Center;
+        return glm::dot(offset, offset) <= a_Radius * a_Radius;
+    }
+
+    //Slab test. Returns true if the ray enters the box within a_MaxDistance, and stores where it enters.
+    bool IntersectsRay(const AABB& a_Box, const glm::vec3& a_Origin, const glm::vec3& a_InverseDirection, float a_MaxDistance, float& a_Distance)
+    {
+        const glm::vec3 first = (a_Box.min - a_Origin) * a_InverseDirection;
+        const glm::vec3 second = (a_Box.max - a_Origin) * a_InverseDirection;
+        const glm::vec3 entries = glm::min(first, second);
+        const glm::vec3 exits = glm::max(first, second);
+
+        const float enter = std::max(std::max(std::max(entries.x, entries.y), entries.z), 0.f);
+        const float exit = std::min(std::min(std::min(exits.x, exits.y), exits.z), a_MaxDistance);
+
+        a_Distance = enter;
+        return enter <= exit;
+    }
+
+    //Plane masks are stored in the lower bits of the traversal stack entries, one bit per frustum plane.
+    constexpr int PLANE_BITS = blurp::Frustum::NUM_PLANES;
+    constexpr int ALL_PLANES = (1 << PLANE_BITS) - 1;
+}
+
+SceneBVH::SceneBVH(float a_Margin) : m_Root(NULL_NODE), m_FreeList(NULL_NODE), m_Count(0), m_Margin(a_Margin)
+{
+
+}
+
+int SceneBVH::Insert(Entity* a_Entity, const blurp::MeshBounds& a_Bounds)
+{
+    const int proxy = AllocateNode();
+    m_Leaves[proxy].bounds = AABB{ a_Bounds.min, a_Bounds.max };
+    m_Leaves[proxy].entity = a_Entity;
+    m_Nodes[proxy].fatBounds = Enlarge(m_Leaves[proxy].bounds, m_Margin, glm::vec3(0.f));
+
+    InsertLeaf(proxy);
+    ++m_Count;
+    return proxy;
+}
+
+void SceneBVH::Remove(int a_Proxy)
+{
+    assert(a_Proxy >= 0 && a_Proxy < static_cast<int>(m_Nodes.size()) && m_Nodes[a_Proxy].IsLeaf() && m_Nodes[a_Proxy].height == 0 && "Invalid proxy ID!");
+
+    RemoveLeaf(a_Proxy);
+    FreeNode(a_Proxy);
+    --m_Count;
+}
+
+bool SceneBVH::Move(int a_Proxy, const blurp::MeshBounds& a_Bounds, const glm::vec3& a_Displacement)
+{
+    assert(a_Proxy >= 0 && a_Proxy < static_cast<int>(m_Nodes.size()) && m_Nodes[a_Proxy].IsLeaf() && m_Nodes[a_Proxy].height == 0 && "Invalid proxy ID!");
+
+    ++m_Stats.moves;
+
+    const AABB bounds{ a_Bounds.min, a_Bounds.max };
+    m_Leaves[a_Proxy].bounds = bounds;
+
+    //Nothing changes in the tree as long as the entity stays inside its enlarged bounds.
+    //The enlarged bounds are replaced when they became much larger than needed, for example when an entity stopped moving fast.
+    const AABB& currentFatBounds = m_Nodes[a_Proxy].fatBounds;
+    const AABB fatBounds = Enlarge(bounds, m_Margin, a_Displacement * 2.f);
+    if(Contains(currentFatBounds, bounds))
+    {
+        const AABB largest = Enlarge(fatBounds, m_Margin * 4.f, glm::vec3(0.f));
+        if(Contains(largest, currentFatBounds))
+        {
+            return false;
+        }
+    }
+
+    RemoveLeaf(a_Proxy);
+    m_Nodes[a_Proxy].fatBounds = fatBounds;
+    InsertLeaf(a_Proxy);
+
+    ++m_Stats.reinserts;
+    return true;
+}
+
+void SceneBVH::Clear()
+{
+    m_Nodes.clear();
+    m_Leaves.clear();
+    m_Root = NULL_NODE;
+    m_FreeList = NULL_NODE;
+    m_Count = 0;
+}
+
+void SceneBVH::QueryFrustum(const blurp::Frustum& a_Frustum, std::vector<Entity*>& a_Output) const
+{
+    if(m_Root == NULL_NODE)
+    {
+        return;
+    }
+
+    m_Stack.clear();
+    m_Stack.push_back((m_Root << PLANE_BITS) | ALL_PLANES);
+
+    while(!m_Stack.empty())
+    {
+        const int entry = m_Stack.back();
+        m_Stack.pop_back();
+
+        const int index = entry >> PLANE_BITS;
+        int mask = entry & ALL_PLANES;
+        const Node& node = m_Nodes[index];
+        ++m_Stats.nodesVisited;
+
+        //Leaves are tested against their exact bounds.
+        const AABB& box = node.IsLeaf() ? m_Leaves[index].bounds : node.fatBounds;
+        const glm::vec3 center = (box.min + box.max) * 0.5f;
+        const glm::vec3 extent = (box.max - box.min) * 0.5f;
+
+        //Only planes that the parent was not fully inside of are tested.
+        bool outside = false;
+        for(int plane = 0; plane < PLANE_BITS && !outside; ++plane)
+        {
+            if((mask & (1 << plane)) == 0)
+            {
+                continue;
+            }
+
+            const glm::vec4& p = a_Frustum.planes[plane];
+            const float distance = glm::dot(glm::vec3(p), center) + p.w;
+            const float radius = glm::dot(glm::abs(glm::vec3(p)), extent);
+
+            if(distance < -radius)
+            {
+                outside = true;
+            }
+            else if(distance >= radius)
+            {
+                mask &= ~(1 << plane);
+            }
+        }
+
+        if(outside)
+        {
+            continue;
+        }
+
+        if(node.IsLeaf())
+        {
+            a_Output.push_back(m_Leaves[index].entity);
+        }
+        else
+        {
+            m_Stack.push_back((node.left << PLANE_BITS) | mask);
+            m_Stack.push_back((node.right << PLANE_BITS) | mask);
+        }
+    }
+}
+
+void SceneBVH::QuerySphere(const glm::vec3& a_Center, float a_Radius, std::vector<Entity*>& a_Output) const
+{
+    if(m_Root == NULL_NODE)
+    {
+        return;
+    }
+
+    m_Stack.clear();
+    m_Stack.push_back(m_Root);
+
+    while(!m_Stack.empty())
+    {
+        const int index = m_Stack.back();
+        const Node& node = m_Nodes[index];
+        m_Stack.pop_back();
+        ++m_Stats.nodesVisited;
+
+        if(!OverlapsSphere(node.IsLeaf() ? m_Leaves[index].bounds : node.fatBounds, a_Center, a_Radius))
+        {
+            continue;
+        }
+
+        if(node.IsLeaf())
+        {
+            a_Output.push_back(m_Leaves[index].entity);
+        }
+        else
+        {
+            m_Stack.push_back(node.left);
+            m_Stack.push_back(node.right);
+        }
+    }
+}
+
+void SceneBVH::QueryRay(const glm::vec3& a_Origin, const glm::vec3& a_Direction, float a_MaxDistance, std::vector<RayHit>& a_Output) const
+{
+    if(m_Root == NULL_NODE)
+    {
+        return;
+    }
+
+    //Division by zero gives infinity, which makes the slab test work for axis aligned rays.
+    const glm::vec3 inverseDirection = 1.f / a_Direction;
+    const auto first = a_Output.size();
+
+    m_Stack.clear();
+    m_Stack.push_back(m_Root);
+
+    while(!m_Stack.empty())
+    {
+        const int index = m_Stack.back();
+        const Node& node = m_Nodes[index];
+        m_Stack.pop_back();
+        ++m_Stats.nodesVisited;
+
+        float distance;
+        if(!IntersectsRay(node.IsLeaf() ? m_Leaves[index].bounds : node.fatBounds, a_Origin, inverseDirection, a_MaxDistance, distance))
+        {
+            continue;
+        }
+
+        if(node.IsLeaf())
+        {
+            a_Output.push_back(RayHit{ m_Leaves[index].entity, distance });
+        }
+        else
+        {
+            m_Stack.push_back(node.left);
+            m_Stack.push_back(node.right);
+        }
+    }
+
+    std::sort(a_Output.begin() + first, a_Output.end(), [](const RayHit& a_First, const RayHit& a_Second) { return a_First.distance < a_Second.distance; });
+}
+
+Entity* SceneBVH::GetEntity(int a_Proxy) const
+{
+    assert(a_Proxy >= 0 && a_Proxy < static_cast<int>(m_Nodes.size()) && "Invalid proxy ID!");
+    return m_Leaves[a_Proxy].entity;
+}
+
+const AABB& SceneBVH::GetBounds(int a_Proxy) const
+{
+    assert(a_Proxy >= 0 && a_Proxy < static_cast<int>(m_Nodes.size()) && "Invalid proxy ID!");
+    return m_Leaves[a_Proxy].bounds;
+}
+
+int SceneBVH::GetCount() const
+{
+    return m_Count;
+}
+
+int SceneBVH::GetHeight() const
+{
+    return m_Root == NULL_NODE ? 0 : m_Nodes[m_Root].height;
+}
+
+const SceneBVHStats& SceneBVH::GetStats() const
+{
+    return m_Stats;
+}
+
+void SceneBVH::ResetStats()
+{
+    m_Stats = SceneBVHStats();
+}
+
+bool SceneBVH::Validate() const
+{
+    if(m_Root == NULL_NODE)
+    {
+        return m_Count == 0;
+    }
+    return m_Nodes[m_Root].parent == NULL_NODE && ValidateNode(m_Root);
+}
+
+int SceneBVH::AllocateNode()
+{
+    int index;
+    if(m_FreeList != NULL_NODE)
+    {
+        index = m_FreeList;
+        m_FreeList = m_Nodes[index].parent;
+    }
+    else
+    {
+        index = static_cast<int>(m_Nodes.size());
+        assert(index < (std::numeric_limits<int>::max() >> PLANE_BITS) && "Too many nodes in the scene BVH!");
+        m_Nodes.emplace_back();
+        m_Leaves.emplace_back();
+    }
+
+    Node& node = m_Nodes[index];
+    node.parent = NULL_NODE;
+    node.left = NULL_NODE;
+    node.right = NULL_NODE;
+    node.height = 0;
+    return index;
+}
+
+void SceneBVH::FreeNode(int a_Node)
+{
+    m_Nodes[a_Node].parent = m_FreeList;
+    m_Nodes[a_Node].height = -1;
+    m_FreeList = a_Node;
+}
+
+void SceneBVH::InsertLeaf(int a_Leaf)
+{
+    if(m_Root == NULL_NODE)
+    {
+        m_Root = a_Leaf;
+        m_Nodes[a_Leaf].parent = NULL_NODE;
+        return;
+    }
+
+    //Walk down the tree, following the child whose bounds grow the least.
+    const AABB leafBounds = m_Nodes[a_Leaf].fatBounds;
+    int index = m_Root;
+    while(!m_Nodes[index].IsLeaf())
+    {
+        const Node& node = m_Nodes[index];
+        const float area = SurfaceArea(node.fatBounds);
+        const float combinedArea = SurfaceArea(Combine(node.fatBounds, leafBounds));
+
+        //Cost of making a new parent for this node and the leaf, and the cost that pushing the leaf further down adds to this node.
+        const float cost = 2.f * combinedArea;
+        const float inheritedCost = 2.f * (combinedArea - area);
+
+        const auto childCost = [&](int a_Child)
+        {
+            const Node& child = m_Nodes[a_Child];
+            const float grownArea = SurfaceArea(Combine(child.fatBounds, leafBounds));
+            return (child.IsLeaf() ? grownArea : grownArea - SurfaceArea(child.fatBounds)) + inheritedCost;
+        };
+
+        const float leftCost = childCost(node.left);
+        const float rightCost = childCost(node.right);
+
+        if(cost < leftCost && cost < rightCost)
+        {
+            break;
+        }
+
+        index = leftCost < rightCost ? node.left : node.right;
+    }
+
+    //Replace the sibling by a new parent containing both the sibling and the leaf.
+    const int sibling = index;
+    const int oldParent = m_Nodes[sibling].parent;
+    const int newParent = AllocateNode();
+
+    Node& parent = m_Nodes[newParent];
+    parent.parent = oldParent;
+    parent.fatBounds = Combine(leafBounds, m_Nodes[sibling].fatBounds);
+    parent.height = m_Nodes[sibling].height + 1;
+    parent.left = sibling;
+    parent.right = a_Leaf;
+
+    if(oldParent != NULL_NODE)
+    {
+        if(m_Nodes[oldParent].left == sibling)
+        {
+            m_Nodes[oldParent].left = newParent;
+        }
+        else
+        {
+            m_Nodes[oldParent].right = newParent;
+        }
+    }
+    else
+    {
+        m_Root = newParent;
+    }
+
+    m_Nodes[sibling].parent = newParent;
+    m_Nodes[a_Leaf].parent = newParent;
+
+    Refit(newParent);
+}
+
+void SceneBVH::RemoveLeaf(int a_Leaf)
+{
+    if(a_Leaf == m_Root)
+    {
+        m_Root = NULL_NODE;
+        return;
+    }
+
+    const int parent = m_Nodes[a_Leaf].parent;
+    const int grandParent = m_Nodes[parent].parent;
+    const int sibling = m_Nodes[parent].left == a_Leaf ? m_Nodes[parent].right : m_Nodes[parent].left;
+
+    //The sibling takes the place of the parent.
+    if(grandParent != NULL_NODE)
+    {
+        if(m_Nodes[grandParent].left == parent)
+        {
+            m_Nodes[grandParent].left = sibling;
+        }
+        else
+        {
+            m_Nodes[grandParent].right = sibling;
+        }
+        m_Nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+
+        Refit(grandParent);
+    }
+    else
+    {
+        m_Root = sibling;
+        m_Nodes[sibling].parent = NULL_NODE;
+        FreeNode(parent);
+    }
+}
+
+void SceneBVH::Refit(int a_Node)
+{
+    int index = a_Node;
+    while(index != NULL_NODE)
+    {
+        index = Balance(index);
+
+        Node& node = m_Nodes[index];
+        const Node& left = m_Nodes[node.left];
+        const Node& right = m_Nodes[node.right];
+        node.height = 1 + std::max(left.height, right.height);
+        node.fatBounds = Combine(left.fatBounds, right.fatBounds);
+
+        index = node.parent;
+    }
+}
+
+int SceneBVH::Balance(int a_Node)
+{
+    const int iA = a_Node;
+    Node& a = m_Nodes[iA];
+    if(a.IsLeaf() || a.height < 2)
+    {
+        return iA;
+    }
+
+    const int iB = a.left;
+    const int iC = a.right;
+    Node& b = m_Nodes[iB];
+    Node& c = m_Nodes[iC];
+    const int balance = c.height - b.height;
+
+    //The lower child of the taller child (the grandchild) takes the place of the taller child, and the taller child takes the place of A.
+    const auto rotateUp = [&](int a_Up, Node& a_UpNode, int a_Other, bool a_UpIsRight)
+    {
+        const int iF = a_UpNode.left;
+        const int iG = a_UpNode.right;
+        Node& f = m_Nodes[iF];
+        Node& g = m_Nodes[iG];
+
+        a_UpNode.left = iA;
+        a_UpNode.parent = a.parent;
+        a.parent = a_Up;
+
+        if(a_UpNode.parent != NULL_NODE)
+        {
+            if(m_Nodes[a_UpNode.parent].left == iA)
+            {
+                m_Nodes[a_UpNode.parent].left = a_Up;
+            }
+            else
+            {
+                m_Nodes[a_UpNode.parent].right = a_Up;
+            }
+        }
+        else
+        {
+            m_Root = a_Up;
+        }
+
+        //Keep the taller grandchild next to A's new position, and give the other one to A.
+        const bool keepF = f.height > g.height;
+        const int iKeep = keepF ? iF : iG;
+        const int iMove = keepF ? iG : iF;
+        Node& keep = m_Nodes[iKeep];
+        Node& move = m_Nodes[iMove];
+
+        a_UpNode.right = iKeep;
+        if(a_UpIsRight)
+        {
+            a.right = iMove;
+        }
+        else
+        {
+            a.left = iMove;
+        }
+        move.parent = iA;
+
+        const Node& other = m_Nodes[a_Other];
+        a.fatBounds = Combine(other.fatBounds, move.fatBounds);
+        a.height = 1 + std::max(other.height, move.height);
+        a_UpNode.fatBounds = Combine(a.fatBounds, keep.fatBounds);
+        a_UpNode.height = 1 + std::max(a.height, keep.height);
+
+        ++m_Stats.rotations;
+    };
+
+    if(balance > 1)
+    {
+        rotateUp(iC, c, iB, true);
+        return iC;
+    }
+
+    if(balance < -1)
+    {
+        rotateUp(iB, b, iC, false);
+        return iB;
+    }
+
+    return iA;
+}
+
+bool SceneBVH::ValidateNode(int a_Node) const
+{
+    const Node& node = m_Nodes[a_Node];
+    if(node.IsLeaf())
+    {
+        return node.height == 0 && node.right == NULL_NODE && Contains(node.fatBounds, m_Leaves[a_Node].bounds);
+    }
+
+    const Node& left = m_Nodes[node.left];
+    const Node& right = m_Nodes[node.right];
+
+    return left.parent == a_Node && right.parent == a_Node
+        && node.height == 1 + std::max(left.height, right.height)
+        && Contains(node.fatBounds, left.fatBounds) && Contains(node.fatBounds, right.fatBounds)
+        && ValidateNode(node.left) && ValidateNode(node.right);
+}
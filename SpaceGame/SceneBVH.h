@@ -0,0 +1,203 @@
+#pragma once
+#include <cinttypes>
+#include <vector>
+#include <glm/glm.hpp>
+#include <Data.h>
+
+class Entity;
+
+/*
+ * Axis aligned box stored in the nodes of the scene BVH.
+ */
+struct AABB
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+/*
+ * An entity hit by a ray query, with the distance along the ray where its bounds are entered.
+ */
+struct RayHit
+{
+    Entity* entity;
+    float distance;
+};
+
+/*
+ * Counters kept by the scene BVH. Reset them with SceneBVH::ResetStats().
+ */
+struct SceneBVHStats
+{
+    SceneBVHStats() : moves(0), reinserts(0), rotations(0), nodesVisited(0) {}
+
+    //The amount of calls to Move().
+    std::uint64_t moves;
+
+    //The amount of moves that left the enlarged bounds and had to be reinserted.
+    std::uint64_t reinserts;
+
+    //The amount of tree rotations done to keep the tree balanced.
+    std::uint64_t rotations;
+
+    //The amount of nodes tested by queries.
+    std::uint64_t nodesVisited;
+};
+
+/*
+ * SceneBVH is a dynamic bounding volume hierarchy that entities register with.
+ * It answers which entities are inside a frustum, touch a sphere or are hit by a ray without looking at every entity.
+ *
+ * Every entity is a leaf. Leaves are enlarged by a margin and in the direction of movement, so that small moves do not change the tree.
+ * When an entity leaves its enlarged bounds, it is reinserted and the bounds of its ancestors are refitted.
+ * The tree is kept balanced with rotations, so insert, remove and move take O(log n).
+ *
+ * Queries test the exact bounds of the leaves, so the enlarged bounds do not produce extra results.
+ * Queries are not thread safe because they share a traversal stack.
+ */
+class SceneBVH
+{
+public:
+    /*
+     * Create an empty tree. a_Margin is the distance by which the bounds of every leaf are enlarged.
+     */
+    SceneBVH(float a_Margin = 1.f);
+
+    /*
+     * Add an entity with the given world space bounds.
+     * Returns the proxy ID used to move and remove the entity.
+     */
+    int Insert(Entity* a_Entity, const blurp::MeshBounds& a_Bounds);
+
+    /*
+     * Remove the entity with the given proxy ID. The ID may be reused by a later insert.
+     */
+    void Remove(int a_Proxy);
+
+    /*
+     * Update the world space bounds of an entity.
+     * a_Displacement is the expected movement until the next call, used to enlarge the bounds in that direction.
+     * Returns true if the entity had to be reinserted into the tree.
+     */
+    bool Move(int a_Proxy, const blurp::MeshBounds& a_Bounds, const glm::vec3& a_Displacement);
+
+    /*
+     * Remove all entities.
+     */
+    void Clear();
+
+    /*
+     * Append every entity whose bounds intersect the frustum to a_Output.
+     */
+    void QueryFrustum(const blurp::Frustum& a_Frustum, std::vector<Entity*>& a_Output) const;
+
+    /*
+     * Append every entity whose bounds intersect the sphere to a_Output.
+     */
+    void QuerySphere(const glm::vec3& a_Center, float a_Radius, std::vector<Entity*>& a_Output) const;
+
+    /*
+     * Append every entity whose bounds are hit by the ray within a_MaxDistance to a_Output, sorted from near to far.
+     * a_Direction has to be normalized.
+     */
+    void QueryRay(const glm::vec3& a_Origin, const glm::vec3& a_Direction, float a_MaxDistance, std::vector<RayHit>& a_Output) const;
+
+    /*
+     * Get the entity that belongs to a proxy ID.
+     */
+    Entity* GetEntity(int a_Proxy) const;
+
+    /*
+     * Get the exact bounds of the entity that belongs to a proxy ID.
+     */
+    const AABB& GetBounds(int a_Proxy) const;
+
+    /*
+     * Get the amount of entities in the tree.
+     */
+    int GetCount() const;
+
+    /*
+     * Get the height of the tree. A tree with a single entity has height 0.
+     */
+    int GetHeight() const;
+
+    /*
+     * Get the counters of this tree.
+     */
+    const SceneBVHStats& GetStats() const;
+
+    /*
+     * Set all counters back to 0.
+     */
+    void ResetStats();
+
+    /*
+     * Check that every node encloses its children and that parent links and heights are correct.
+     * Returns false if the tree is broken.
+     */
+    bool Validate() const;
+
+private:
+    static constexpr int NULL_NODE = -1;
+
+    struct Node
+    {
+        //Enlarged bounds for leaves, the union of the children for inner nodes.
+        AABB fatBounds;
+
+        //Parent for nodes in the tree, next free node for nodes in the free list.
+        int parent;
+        int left;
+        int right;
+
+        //Leaves have height 0. Free nodes have height -1.
+        int height;
+
+        bool IsLeaf() const
+        {
+            return left == NULL_NODE;
+        }
+    };
+
+    //Data that only leaves use. Kept apart from the nodes so that traversal touches less memory.
+    struct Leaf
+    {
+        //Exact bounds of the entity.
+        AABB bounds;
+        Entity* entity;
+    };
+
+    //Take a node from the free list, growing the node array when needed.
+    int AllocateNode();
+
+    //Return a node to the free list.
+    void FreeNode(int a_Node);
+
+    //Place a leaf next to the sibling where it increases the total surface area the least.
+    void InsertLeaf(int a_Leaf);
+
+    //Take a leaf out of the tree, replacing its parent by its sibling.
+    void RemoveLeaf(int a_Leaf);
+
+    //Walk up from a node, rotating unbalanced nodes and refitting bounds and heights.
+    void Refit(int a_Node);
+
+    //Rotate the subtree at a_Node if its children differ in height by more than one. Returns the new subtree root.
+    int Balance(int a_Node);
+
+    //Validate the subtree at a_Node.
+    bool ValidateNode(int a_Node) const;
+
+private:
+    std::vector<Node> m_Nodes;
+    std::vector<Leaf> m_Leaves;   //Same size as m_Nodes, indexed by node.
+    int m_Root;
+    int m_FreeList;
+    int m_Count;
+    float m_Margin;
+
+    //Traversal stack shared by the queries.
+    mutable std::vector<int> m_Stack;
+    mutable SceneBVHStats m_Stats;
+};